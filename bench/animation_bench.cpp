@@ -0,0 +1,191 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/animation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// One frame of skeletal animation for 1000 characters on a 24 joint rig, each blending a
+// walk and a run clip of 30 keys per channel. animation.naive searches every key from
+// scratch and builds each joint's matrix by walking up its parents, the way a per object
+// evaluator does. animation.serial runs animation_instance over the same characters and
+// animation.jobs.N spreads them over N threads, 0 is hardware concurrency.
+
+namespace geodesy {
+
+	namespace {
+
+		const std::size_t JointCount = 24;
+		const std::size_t CharacterCount = 1000;
+
+		// Spine of 6 joints with 3 limbs of 6 joints hanging off it.
+		std::shared_ptr<animated_model> make_rig() {
+			auto Rig = std::make_shared<animated_model>();
+			skeleton& S = Rig->Skeleton;
+			for (std::size_t j = 0; j < JointCount; j++) {
+				S.Name.push_back("joint" + std::to_string(j));
+				S.Node.push_back(j);
+				S.Parent.push_back(j == 0 ? -1 : (j % 6 == 0 ? 3 : (int32_t)j - 1));
+				S.Order.push_back((uint32_t)j);
+				S.Translation.insert(S.Translation.end(), { 0.0f, 0.3f, 0.0f });
+				S.Rotation.insert(S.Rotation.end(), { 0.0f, 0.0f, 0.0f, 1.0f });
+				S.Scale.insert(S.Scale.end(), { 1.0f, 1.0f, 1.0f });
+				S.Offset.insert(S.Offset.end(), { 1, 0, 0,  0, 1, 0,  0, 0, 1,  0, 0, 0 });
+				S.InverseBind.insert(S.InverseBind.end(), { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, -0.3f * (float)(j % 6), 0, 1 });
+			}
+			for (float Speed : { 1.0f, 2.5f }) {
+				animation_clip Clip;
+				Clip.Name = Speed < 2.0f ? "walk" : "run";
+				Clip.Duration = 1.0f;
+				for (uint32_t j = 0; j < JointCount; j++) {
+					animation_clip::channel Rotation{ j, animation_clip::ROTATION, animation_clip::LINEAR, {}, {} };
+					for (std::size_t k = 0; k < 30; k++) {
+						float T = (float)k / 29.0f;
+						float Half = 0.25f * Speed * std::sin(6.2831853f * T + (float)j * 0.4f);
+						Rotation.Time.push_back(T);
+						Rotation.Value.insert(Rotation.Value.end(), { std::sin(Half), 0.0f, 0.0f, std::cos(Half) });
+					}
+					Clip.Channel.push_back(Rotation);
+				}
+				animation_clip::channel Root{ 0, animation_clip::TRANSLATION, animation_clip::LINEAR, {}, {} };
+				for (std::size_t k = 0; k < 30; k++) {
+					float T = (float)k / 29.0f;
+					Root.Time.push_back(T);
+					Root.Value.insert(Root.Value.end(), { 0.0f, 1.0f + 0.05f * Speed * std::sin(12.566371f * T), 0.0f });
+				}
+				Clip.Channel.push_back(Root);
+				Rig->Clip.push_back(Clip);
+			}
+			return Rig;
+		}
+
+		// ---------- naive ---------- //
+
+		struct naive_character {
+			float 				Time;
+			float 				Weight[2];
+			std::vector<float> 	Pose; 			// 10 per joint, AoS.
+			std::vector<float> 	Palette;
+		};
+
+		void naive_sample(const animation_clip::channel& aChannel, float aTime, float* aOut) {
+			std::size_t N = aChannel.Path == animation_clip::ROTATION ? 4 : 3;
+			std::size_t K = (std::size_t)(std::upper_bound(aChannel.Time.begin(), aChannel.Time.end(), aTime) - aChannel.Time.begin());
+			if (K == 0) K = 1;
+			if (K >= aChannel.Time.size()) K = aChannel.Time.size() - 1;
+			float U = std::min(1.0f, std::max(0.0f, (aTime - aChannel.Time[K - 1]) / (aChannel.Time[K] - aChannel.Time[K - 1])));
+			const float* V0 = &aChannel.Value[(K - 1) * N];
+			const float* V1 = &aChannel.Value[K * N];
+			if (N == 4) detail::slerp(V0, V1, U, aOut);
+			else for (std::size_t i = 0; i < N; i++) aOut[i] = V0[i] + (V1[i] - V0[i]) * U;
+		}
+
+		void naive_evaluate(const animated_model& aRig, naive_character& aCharacter) {
+			const skeleton& S = aRig.Skeleton;
+			std::vector<float> Sum(10 * JointCount, 0.0f);
+			float WeightSum = 0.0f;
+			for (std::size_t c = 0; c < aRig.Clip.size(); c++) {
+				const animation_clip& Clip = aRig.Clip[c];
+				float T = std::fmod(aCharacter.Time, Clip.Duration);
+				for (std::size_t j = 0; j < JointCount; j++) {
+					float* P = &aCharacter.Pose[10 * j];
+					std::memcpy(P, &S.Translation[3 * j], 3 * sizeof(float));
+					std::memcpy(P + 3, &S.Rotation[4 * j], 4 * sizeof(float));
+					std::memcpy(P + 7, &S.Scale[3 * j], 3 * sizeof(float));
+				}
+				for (const animation_clip::channel& Channel : Clip.Channel) {
+					std::size_t Base = Channel.Path == animation_clip::TRANSLATION ? 0 : (Channel.Path == animation_clip::ROTATION ? 3 : 7);
+					naive_sample(Channel, T, &aCharacter.Pose[10 * Channel.Joint + Base]);
+				}
+				float W = aCharacter.Weight[c];
+				for (std::size_t j = 0; j < JointCount; j++) {
+					float* P = &aCharacter.Pose[10 * j];
+					float* B = &Sum[10 * j];
+					float Dot = B[3] * P[3] + B[4] * P[4] + B[5] * P[5] + B[6] * P[6];
+					float Sign = (WeightSum > 0.0f) && (Dot <= 0.0f) ? -1.0f : 1.0f;
+					for (std::size_t i = 0; i < 10; i++) B[i] += W * ((i >= 3) && (i < 7) ? Sign : 1.0f) * P[i];
+				}
+				WeightSum += W;
+			}
+			std::vector<float> Local(12 * JointCount);
+			for (std::size_t j = 0; j < JointCount; j++) {
+				float* B = &Sum[10 * j];
+				for (std::size_t i = 0; i < 10; i++) B[i] /= WeightSum;
+				detail::normalize_quaternion(B + 3);
+				detail::compose(B, B + 3, B + 7, &Local[12 * j]);
+			}
+			for (std::size_t j = 0; j < JointCount; j++) {
+				float Global[12], Next[12];
+				std::memcpy(Global, &Local[12 * j], sizeof(Global));
+				for (int32_t P = S.Parent[j]; P >= 0; P = S.Parent[P]) {
+					detail::affine_mul(&Local[12 * (std::size_t)P], Global, Next);
+					std::memcpy(Global, Next, sizeof(Global));
+				}
+				const float* IB = &S.InverseBind[16 * j];
+				float* M = &aCharacter.Palette[16 * j];
+				for (int c = 0; c < 4; c++) {
+					for (int r = 0; r < 3; r++) M[4 * c + r] = Global[r] * IB[4 * c] + Global[3 + r] * IB[4 * c + 1] + Global[6 + r] * IB[4 * c + 2] + Global[9 + r] * IB[4 * c + 3];
+					M[4 * c + 3] = IB[4 * c + 3];
+				}
+			}
+		}
+
+		std::shared_ptr<std::vector<animation_instance>> make_instances(const std::shared_ptr<animated_model>& aRig) {
+			auto Instance = std::make_shared<std::vector<animation_instance>>();
+			for (std::size_t i = 0; i < CharacterCount; i++) {
+				animation_instance I(aRig.get());
+				I.Time = 0.001f * (float)i;
+				I.Weight = { 0.7f, 0.3f };
+				Instance->push_back(I);
+			}
+			return Instance;
+		}
+
+		void register_animation(benchmark& aBenchmark) {
+			auto Rig = make_rig();
+
+			auto Naive = std::make_shared<std::vector<naive_character>>(CharacterCount);
+			for (std::size_t i = 0; i < CharacterCount; i++) {
+				(*Naive)[i] = { 0.001f * (float)i, { 0.7f, 0.3f }, std::vector<float>(10 * JointCount), std::vector<float>(16 * JointCount) };
+			}
+			aBenchmark.add("animation.naive", CharacterCount, 1, [=](std::size_t aBatch) {
+				for (std::size_t b = 0; b < aBatch; b++) {
+					for (naive_character& C : *Naive) {
+						C.Time += 1.0f / 60.0f;
+						naive_evaluate(*Rig, C);
+					}
+					benchmark::keep(Naive->back().Palette[12]);
+				}
+			});
+
+			auto Serial = make_instances(Rig);
+			aBenchmark.add("animation.serial", CharacterCount, 1, [=](std::size_t aBatch) {
+				for (std::size_t b = 0; b < aBatch; b++) {
+					for (animation_instance& I : *Serial) {
+						I.Time += 1.0f / 60.0f;
+						I.evaluate();
+					}
+					benchmark::keep(Serial->back().palette()[12]);
+				}
+			});
+
+			for (std::size_t ThreadCount : { 1, 4, 0 }) {
+				auto Instance = make_instances(Rig);
+				auto Jobs = std::make_shared<job_system>(ThreadCount);
+				aBenchmark.add("animation.jobs." + std::to_string(ThreadCount), CharacterCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) {
+						for (animation_instance& I : *Instance) I.Time += 1.0f / 60.0f;
+						evaluate(*Jobs, *Instance, 16);
+						benchmark::keep(Instance->back().palette()[12]);
+					}
+				});
+			}
+		}
+
+		benchmark::suite AnimationSuite("animation", register_animation);
+
+	}
+
+}
@@ -0,0 +1,82 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/asset_cache.h>
+
+#include <cmath>
+
+// Model loading for scenes of repeated props, one load per object against one load per
+// unique model through the cache. The loader stands in for glTF decoding by building a
+// 4096 vertex mesh, so cost and memory are per load as they are in the engine.
+
+namespace geodesy {
+
+	namespace {
+
+		const std::size_t ObjectCountList[] = { 16, 256, 2048 };
+		const std::size_t UniqueModelCount = 16;
+
+		struct mesh {
+			std::vector<float> Vertex;
+		};
+
+		std::shared_ptr<mesh> load_mesh(const std::string& aPath) {
+			// Position, normal and uv per vertex on a 64 x 64 sphere grid.
+			std::shared_ptr<mesh> Mesh = std::make_shared<mesh>();
+			Mesh->Vertex.reserve(64 * 64 * 8);
+			float Seed = (float)aPath.size();
+			for (std::size_t i = 0; i < 64; i++) {
+				for (std::size_t j = 0; j < 64; j++) {
+					float Theta = 3.14159265f * (float)i / 63.0f, Phi = 6.2831853f * (float)j / 63.0f;
+					float X = std::sin(Theta) * std::cos(Phi), Y = std::sin(Theta) * std::sin(Phi), Z = std::cos(Theta);
+					float Vertex[8] = { Seed * X, Seed * Y, Seed * Z, X, Y, Z, (float)j / 63.0f, (float)i / 63.0f };
+					Mesh->Vertex.insert(Mesh->Vertex.end(), Vertex, Vertex + 8);
+				}
+			}
+			return Mesh;
+		}
+
+		io::world_description repeated_world(std::size_t aObjectCount) {
+			io::world_description World;
+			World.Object.resize(aObjectCount);
+			for (std::size_t i = 0; i < aObjectCount; i++) {
+				io::object_description& Object = World.Object[i];
+				Object = io::object_description{};
+				Object.Name 		= "Prop" + std::to_string(i);
+				Object.Type 		= "object";
+				Object.ModelPath 	= "dep/gltf-models/2.0/Prop" + std::to_string(i % UniqueModelCount) + "/glTF/Prop.gltf";
+				Object.Position 	= { (float)i, 0.0f, 0.0f };
+				Object.Scale 		= { 1.0f, 1.0f, 1.0f };
+			}
+			return World;
+		}
+
+		void register_asset(benchmark& aBenchmark) {
+			for (std::size_t ObjectCount : ObjectCountList) {
+				auto World = std::make_shared<io::world_description>(repeated_world(ObjectCount));
+
+				// Every object loads its own model, as object creators do without a cache.
+				aBenchmark.add("world.models.per_object", ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) {
+						std::vector<std::shared_ptr<mesh>> Model;
+						for (const io::object_description& Object : World->Object) Model.push_back(load_mesh(Object.ModelPath));
+						benchmark::keep(Model.back()->Vertex[0]);
+					}
+				});
+
+				// Fresh cache per iteration, so every unique model is still loaded once.
+				aBenchmark.add("world.models.cached", ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) {
+						io::asset_cache<mesh> Cache(load_mesh);
+						std::vector<io::instance_batch<mesh>> Batch = io::build_instance_batches(*World, Cache);
+						benchmark::keep(Batch.back().Model->Vertex[0]);
+					}
+				});
+			}
+		}
+
+		benchmark::suite AssetSuite("asset", register_asset);
+
+	}
+
+}
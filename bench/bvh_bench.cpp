@@ -0,0 +1,93 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/scene_bvh.h>
+#include <geodesy-unit-test/transform_hierarchy.h>
+
+#include <cmath>
+#include <random>
+
+// Frustum culling of 100k instance boxes spread over a 2 x 2 km field, seen by level_01's
+// Camera3D (FOV 70, Near 1, Far 2000) standing in the middle and turning a little every
+// frame. bvh.cull queries a static tree, bvh.brute tests every box on its own, bvh.moving
+// moves a tenth of the boxes before each query so it pays for the refit, bvh.rebuild
+// builds the tree from scratch.
+
+namespace geodesy {
+
+	namespace {
+
+		using mat4 = math::mat<float, 4, 4>;
+
+		const std::size_t InstanceCount = 100000;
+
+		struct scene {
+			scene_bvh 						Tree;
+			std::vector<aabb> 				Box;
+			std::vector<scene_bvh::id> 		Visible;
+			std::mt19937 					Random{ 4 };
+			float 							Yaw = 0.0f;
+
+			aabb random_box() {
+				std::uniform_real_distribution<float> Spread(-1000.0f, 1000.0f), Size(0.5f, 5.0f);
+				float X = Spread(Random), Y = Spread(Random), S = Size(Random);
+				return { { X - S, Y - S, 0.0f }, { X + S, Y + S, 2.0f * S } };
+			}
+
+			frustum next_frustum() {
+				Yaw += 1.0f;
+				mat4 View = math::simd::inverse(object_transform({ 0.0f, 0.0f, 2.0f }, { Yaw, 90.0f }, { 1.0f, 1.0f, 1.0f }));
+				return frustum::from_camera(View, 70.0f, 16.0f / 9.0f, 1.0f, 2000.0f);
+			}
+		};
+
+		std::shared_ptr<scene> make_scene() {
+			auto Scene = std::make_shared<scene>();
+			for (std::size_t i = 0; i < InstanceCount; i++) {
+				Scene->Box.push_back(Scene->random_box());
+				Scene->Tree.add(Scene->Box.back());
+			}
+			Scene->Tree.rebuild();
+			return Scene;
+		}
+
+		void register_bvh(benchmark& aBenchmark) {
+			auto Static = make_scene();
+			aBenchmark.add("bvh.100000.cull", InstanceCount, 1, [=](std::size_t aBatch) {
+				for (std::size_t b = 0; b < aBatch; b++) Static->Tree.cull(Static->next_frustum(), Static->Visible);
+				benchmark::keep(Static->Tree.stats().Visible);
+			});
+			aBenchmark.add("bvh.100000.brute", InstanceCount, 1, [=](std::size_t aBatch) {
+				for (std::size_t b = 0; b < aBatch; b++) {
+					frustum Frustum = Static->next_frustum();
+					Static->Visible.clear();
+					for (scene_bvh::id i = 0; i < Static->Box.size(); i++) if (Frustum.intersects(Static->Box[i])) Static->Visible.push_back(i);
+				}
+				benchmark::keep(Static->Visible.size());
+			});
+			auto Moving = make_scene();
+			aBenchmark.add("bvh.100000.moving.10", InstanceCount, 1, [=](std::size_t aBatch) {
+				std::uniform_real_distribution<float> Step(-0.5f, 0.5f);
+				for (std::size_t b = 0; b < aBatch; b++) {
+					for (std::size_t i = 0; i < InstanceCount; i += 10) {
+						aabb& Box = Moving->Box[i];
+						float DX = Step(Moving->Random), DY = Step(Moving->Random);
+						Box = { { Box.Min[0] + DX, Box.Min[1] + DY, Box.Min[2] }, { Box.Max[0] + DX, Box.Max[1] + DY, Box.Max[2] } };
+						Moving->Tree.set_bounds((scene_bvh::id)i, Box);
+					}
+					Moving->Tree.cull(Moving->next_frustum(), Moving->Visible);
+				}
+				benchmark::keep(Moving->Tree.stats().Visible);
+			});
+			auto Rebuilt = make_scene();
+			aBenchmark.add("bvh.100000.rebuild", InstanceCount, 1, [=](std::size_t aBatch) {
+				for (std::size_t b = 0; b < aBatch; b++) Rebuilt->Tree.rebuild();
+				benchmark::keep(Rebuilt->Tree.node_count());
+			});
+		}
+
+		benchmark::suite BVHSuite("bvh", register_bvh);
+
+	}
+
+}
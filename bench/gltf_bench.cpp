@@ -0,0 +1,68 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/gltf.h>
+
+#include <filesystem>
+
+// glTF import of the bundled models, buffers read into the heap against buffers mapped
+// and viewed in place. The import case converts every primitive to an interleaved
+// position/normal/uv layout with 32 bit indices, the copy the engine needs anyway, so
+// KiB/op shows the heap the buffer read adds on top of it. Run from the repo root.
+
+namespace geodesy {
+
+	namespace {
+
+		const char* ModelList[] = {
+			"assets/models/pirate_map/scene.gltf",
+			"assets/models/bricks2/bricks2.glb",
+		};
+
+		std::size_t import(const std::string& aPath, io::gltf::mode aMode) {
+			static const std::vector<io::vertex_attribute> Layout = {
+				{ "POSITION", 3, { 0.0f } },
+				{ "NORMAL", 3, { 0.0f } },
+				{ "TEXCOORD_0", 2, { 0.0f } },
+			};
+			io::gltf Model = io::gltf::load(aPath, aMode);
+			std::size_t Total = 0;
+			for (const io::gltf::mesh& Mesh : Model.Mesh) {
+				for (const io::gltf::primitive& Primitive : Mesh.Primitive) {
+					std::vector<float> Vertex = io::interleave(Model, Primitive, Layout);
+					std::vector<uint32_t> Index = Primitive.Indices != SIZE_MAX ? Model.read_indices(Primitive.Indices) : std::vector<uint32_t>();
+					Total += Vertex.size() + Index.size();
+				}
+			}
+			return Total;
+		}
+
+		void register_gltf(benchmark& aBenchmark) {
+			for (const char* Path : ModelList) {
+				if (!std::filesystem::exists(Path)) continue;
+				std::string Name = std::filesystem::path(Path).parent_path().filename().string();
+				// Size is the buffer payload, the .glb itself or the .bin files beside a .gltf.
+				std::size_t Size = 0;
+				if (std::filesystem::path(Path).extension() == ".glb") {
+					Size = (std::size_t)std::filesystem::file_size(Path);
+				}
+				else {
+					for (const std::filesystem::directory_entry& Entry : std::filesystem::directory_iterator(std::filesystem::path(Path).parent_path())) {
+						if (Entry.path().extension() == ".bin") Size += (std::size_t)Entry.file_size();
+					}
+				}
+				std::string File = Path;
+				aBenchmark.add("gltf." + Name + ".import.read", Size, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(import(File, io::gltf::READ));
+				});
+				aBenchmark.add("gltf." + Name + ".import.map", Size, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(import(File, io::gltf::MAP));
+				});
+			}
+		}
+
+		benchmark::suite GltfSuite("gltf", register_gltf);
+
+	}
+
+}
@@ -0,0 +1,162 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/job_system.h>
+
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+// One frame of CPU work over level_01.yaml repeated 100 times (1600 objects) as a task
+// graph: object update, then animation, culling and light binning side by side, then a
+// submit count. Serial runs the same work in a plain loop. job.frame.N runs the graph
+// on N threads, 0 is hardware concurrency. The graph scales with cores, on a single core
+// machine the difference to serial is the scheduling overhead.
+
+namespace geodesy {
+
+	namespace {
+
+		struct scene {
+			struct object {
+				float 	Position[3];
+				float 	Velocity[3];
+				float 	Direction[2];
+				float 	Scale;
+				float 	Model[16];
+				float 	Bone[16][4];
+				bool 	Visible;
+			};
+			std::vector<object> 	Object;
+			std::vector<float> 		Light; 				// x, y, z, radius.
+			std::vector<uint32_t> 	LightCount; 		// Lights touching each object.
+			float 					Plane[6][4];
+			float 					Time = 0.0f;
+		};
+
+		std::shared_ptr<scene> make_scene(std::size_t aObjectCount) {
+			auto Scene = std::make_shared<scene>();
+			Scene->Object.resize(aObjectCount);
+			for (std::size_t i = 0; i < aObjectCount; i++) {
+				scene::object& O = Scene->Object[i];
+				O = scene::object{};
+				O.Position[0] = (float)(i % 40) * 2.0f - 40.0f;
+				O.Position[1] = (float)(i / 40) * 2.0f - 40.0f;
+				O.Velocity[0] = 0.01f * (float)(i % 7);
+				O.Direction[0] = (float)i;
+				O.Scale = 1.0f;
+			}
+			for (std::size_t l = 0; l < 64; l++) {
+				float Data[4] = { (float)(l % 8) * 10.0f - 40.0f, (float)(l / 8) * 10.0f - 40.0f, 3.0f, 8.0f };
+				Scene->Light.insert(Scene->Light.end(), Data, Data + 4);
+			}
+			Scene->LightCount.resize(aObjectCount);
+			// A box frustum around the middle of the level.
+			const float Plane[6][4] = { { 1, 0, 0, 30 }, { -1, 0, 0, 30 }, { 0, 1, 0, 30 }, { 0, -1, 0, 30 }, { 0, 0, 1, 10 }, { 0, 0, -1, 10 } };
+			std::memcpy(Scene->Plane, Plane, sizeof(Plane));
+			return Scene;
+		}
+
+		void update(scene& aScene, std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t i = aBegin; i < aEnd; i++) {
+				scene::object& O = aScene.Object[i];
+				for (int k = 0; k < 3; k++) O.Position[k] += O.Velocity[k] * 0.016667f;
+				float CY = std::cos(O.Direction[0]), SY = std::sin(O.Direction[0]), CP = std::cos(O.Direction[1]), SP = std::sin(O.Direction[1]);
+				float M[16] = {
+					CY * O.Scale, -SY * CP * O.Scale, SY * SP * O.Scale, O.Position[0],
+					SY * O.Scale, CY * CP * O.Scale, -CY * SP * O.Scale, O.Position[1],
+					0.0f, SP * O.Scale, CP * O.Scale, O.Position[2],
+					0.0f, 0.0f, 0.0f, 1.0f
+				};
+				std::memcpy(O.Model, M, sizeof(M));
+			}
+		}
+
+		void animate(scene& aScene, std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t i = aBegin; i < aEnd; i++) {
+				scene::object& O = aScene.Object[i];
+				for (int b = 0; b < 16; b++) {
+					float Angle = 0.5f * std::sin(aScene.Time + (float)b * 0.3f + (float)i);
+					float H = 0.5f * Angle;
+					O.Bone[b][0] = std::cos(H);
+					O.Bone[b][1] = std::sin(H);
+					O.Bone[b][2] = 0.0f;
+					O.Bone[b][3] = 0.0f;
+				}
+			}
+		}
+
+		void cull(scene& aScene, std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t i = aBegin; i < aEnd; i++) {
+				scene::object& O = aScene.Object[i];
+				bool Visible = true;
+				for (int p = 0; p < 6; p++) {
+					const float* P = aScene.Plane[p];
+					Visible = Visible && (P[0] * O.Model[3] + P[1] * O.Model[7] + P[2] * O.Model[11] + P[3] >= -O.Scale);
+				}
+				O.Visible = Visible;
+			}
+		}
+
+		void bin_lights(scene& aScene, std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t i = aBegin; i < aEnd; i++) {
+				const scene::object& O = aScene.Object[i];
+				uint32_t Count = 0;
+				for (std::size_t l = 0; l < aScene.Light.size(); l += 4) {
+					float DX = O.Model[3] - aScene.Light[l], DY = O.Model[7] - aScene.Light[l + 1], DZ = O.Model[11] - aScene.Light[l + 2];
+					float R = aScene.Light[l + 3] + O.Scale;
+					Count += (DX * DX + DY * DY + DZ * DZ <= R * R) ? 1 : 0;
+				}
+				aScene.LightCount[i] = Count;
+			}
+		}
+
+		std::size_t submit(const scene& aScene) {
+			std::size_t Count = 0;
+			for (std::size_t i = 0; i < aScene.Object.size(); i++) Count += aScene.Object[i].Visible ? aScene.LightCount[i] + 1 : 0;
+			return Count;
+		}
+
+		void register_job(benchmark& aBenchmark) {
+			const std::size_t ObjectCount = 16 * 100;
+			const std::size_t Grain = 64;
+
+			auto Serial = make_scene(ObjectCount);
+			aBenchmark.add("job.frame.serial", ObjectCount, 1, [=](std::size_t aBatch) {
+				for (std::size_t b = 0; b < aBatch; b++) {
+					Serial->Time += 0.016667f;
+					update(*Serial, 0, ObjectCount);
+					animate(*Serial, 0, ObjectCount);
+					cull(*Serial, 0, ObjectCount);
+					bin_lights(*Serial, 0, ObjectCount);
+					benchmark::keep(submit(*Serial));
+				}
+			});
+
+			for (std::size_t ThreadCount : { 1, 2, 4, 0 }) {
+				auto Scene = make_scene(ObjectCount);
+				auto Jobs = std::make_shared<job_system>(ThreadCount);
+				auto Graph = std::make_shared<task_graph>();
+				auto Submitted = std::make_shared<std::size_t>(0);
+				scene* S = Scene.get();
+				task_graph::id Update = Graph->add_range("update", ObjectCount, Grain, [S](std::size_t aBegin, std::size_t aEnd) { update(*S, aBegin, aEnd); });
+				task_graph::id Animate = Graph->add_range("animate", ObjectCount, Grain, [S](std::size_t aBegin, std::size_t aEnd) { animate(*S, aBegin, aEnd); }, { Update });
+				task_graph::id Cull = Graph->add_range("cull", ObjectCount, Grain, [S](std::size_t aBegin, std::size_t aEnd) { cull(*S, aBegin, aEnd); }, { Update });
+				task_graph::id Light = Graph->add_range("lights", ObjectCount, Grain, [S](std::size_t aBegin, std::size_t aEnd) { bin_lights(*S, aBegin, aEnd); }, { Update });
+				Graph->add("submit", [S, Submitted]() { *Submitted = submit(*S); }, { Animate, Cull, Light });
+
+				aBenchmark.add("job.frame." + std::to_string(ThreadCount), ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) {
+						Scene->Time += 0.016667f;
+						Jobs->run(*Graph);
+						benchmark::keep(*Submitted);
+					}
+				});
+			}
+		}
+
+		benchmark::suite JobSuite("job", register_job);
+
+	}
+
+}
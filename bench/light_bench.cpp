@@ -0,0 +1,111 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/light_clusters.h>
+#include <geodesy-unit-test/transform_hierarchy.h>
+
+#include <cmath>
+#include <random>
+
+// Light assignment for 256 to 16k point and spot lights spread through a 120 x 120 x 24 m
+// hall, seen from a camera standing inside it, into the default 16 x 9 x 24 froxel grid.
+// light.N.serial bins without a job system, light.N.jobs on every core. light.N.brute
+// tests every light against every cluster's bounding box, the cost the binning avoids.
+
+namespace geodesy {
+
+	namespace {
+
+		using mat4 = math::mat<float, 4, 4>;
+
+		std::vector<cluster_light> make_lights(std::size_t aCount) {
+			std::mt19937 Random(3);
+			std::uniform_real_distribution<float> Spread(-60.0f, 60.0f), Height(0.0f, 24.0f), Range(1.0f, 6.0f), Unit(-1.0f, 1.0f), Angle(10.0f, 60.0f), Coin(0.0f, 1.0f);
+			std::vector<cluster_light> Light(aCount);
+			for (cluster_light& L : Light) {
+				L.Position = { Spread(Random), Spread(Random), Height(Random) };
+				L.Range = Range(Random);
+				if (Coin(Random) < 0.25f) {
+					L.Direction = { Unit(Random), Unit(Random), -1.0f };
+					L.Angle = Angle(Random);
+				}
+			}
+			return Light;
+		}
+
+		// View space bounds of every cluster, corners from the tile planes and slice depths.
+		std::vector<float> cluster_bounds(const light_clusters& aClusters) {
+			const cluster_grid& Grid = aClusters.grid();
+			float HalfY = std::tan(Grid.FieldOfView * 3.14159265358979f / 360.0f), HalfX = HalfY * Grid.AspectRatio;
+			std::vector<float> Bounds;
+			for (uint32_t s = 0; s < Grid.Slices; s++) {
+				float Depth[2] = { Grid.Near * std::pow(Grid.Far / Grid.Near, (float)s / Grid.Slices), Grid.Near * std::pow(Grid.Far / Grid.Near, (float)(s + 1) / Grid.Slices) };
+				for (uint32_t y = 0; y < Grid.TilesY; y++) {
+					for (uint32_t x = 0; x < Grid.TilesX; x++) {
+						float TX[2] = { HalfX * (-1.0f + 2.0f * x / Grid.TilesX), HalfX * (-1.0f + 2.0f * (x + 1) / Grid.TilesX) };
+						float TY[2] = { HalfY * (-1.0f + 2.0f * y / Grid.TilesY), HalfY * (-1.0f + 2.0f * (y + 1) / Grid.TilesY) };
+						float Box[6] = { 1e30f, 1e30f, -Depth[1], -1e30f, -1e30f, -Depth[0] };
+						for (float D : Depth) {
+							for (std::size_t k = 0; k < 2; k++) {
+								Box[0] = std::min(Box[0], TX[k] * D);
+								Box[3] = std::max(Box[3], TX[k] * D);
+								Box[1] = std::min(Box[1], TY[k] * D);
+								Box[4] = std::max(Box[4], TY[k] * D);
+							}
+						}
+						Bounds.insert(Bounds.end(), Box, Box + 6);
+					}
+				}
+			}
+			return Bounds;
+		}
+
+		void register_light(benchmark& aBenchmark) {
+			auto Jobs = std::make_shared<job_system>(0);
+			// Standing in the hall looking along +y, view space looks down -z.
+			mat4 View = math::simd::inverse(object_transform({ 0.0f, -50.0f, 2.0f }, { 0.0f, 90.0f }, { 1.0f, 1.0f, 1.0f }));
+			for (std::size_t Count : { 256, 1024, 4096, 16384 }) {
+				auto Light = std::make_shared<std::vector<cluster_light>>(make_lights(Count));
+				auto Serial = std::make_shared<light_clusters>();
+				aBenchmark.add("light." + std::to_string(Count) + ".serial", Count, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) Serial->build(View, *Light);
+					benchmark::keep(Serial->stats().Assigned);
+				});
+				auto Parallel = std::make_shared<light_clusters>();
+				aBenchmark.add("light." + std::to_string(Count) + ".jobs", Count, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) Parallel->build(View, *Light, Jobs.get());
+					benchmark::keep(Parallel->stats().Assigned);
+				});
+				if (Count > 1024) continue;
+				auto Bounds = std::make_shared<std::vector<float>>(cluster_bounds(*Serial));
+				aBenchmark.add("light." + std::to_string(Count) + ".brute", Count, 1, [=](std::size_t aBatch) {
+					std::size_t Assigned = 0;
+					for (std::size_t b = 0; b < aBatch; b++) {
+						// Point light spheres, spots included at full range.
+						std::vector<float> Sphere;
+						for (const cluster_light& L : *Light) {
+							math::vec<float, 4> P = math::simd::mul(View, math::vec<float, 4>(L.Position[0], L.Position[1], L.Position[2], 1.0f));
+							Sphere.insert(Sphere.end(), { P[0], P[1], P[2], L.Range });
+						}
+						for (std::size_t c = 0; c < Bounds->size(); c += 6) {
+							const float* Box = &(*Bounds)[c];
+							for (std::size_t l = 0; l < Sphere.size(); l += 4) {
+								float Distance2 = 0.0f;
+								for (std::size_t k = 0; k < 3; k++) {
+									float Outside = std::max(std::max(Box[k] - Sphere[l + k], Sphere[l + k] - Box[k + 3]), 0.0f);
+									Distance2 += Outside * Outside;
+								}
+								Assigned += Distance2 < Sphere[l + 3] * Sphere[l + 3] ? 1 : 0;
+							}
+						}
+					}
+					benchmark::keep(Assigned);
+				});
+			}
+		}
+
+		benchmark::suite LightSuite("light", register_light);
+
+	}
+
+}
@@ -0,0 +1,82 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/mesh_optimizer.h>
+
+#include <random>
+#include <filesystem>
+
+// Level of detail chains of the bundled models. .lod runs the import pipeline with four
+// levels, to compare with mesh.<model>.optimize, and .simplify halves every primitive
+// once. lod.select picks levels for 10000 instances at random distances, with the level
+// of the previous frame as the hysteresis state. Run from the repo root.
+
+namespace geodesy {
+
+	namespace {
+
+		const char* ModelList[] = {
+			"assets/models/pirate_map/scene.gltf",
+			"assets/models/Pigwithanimation.gltf",
+		};
+
+		void register_lod(benchmark& aBenchmark) {
+			io::mesh_options Options;
+			Options.LodCount = 4;
+			for (const char* Path : ModelList) {
+				if (!std::filesystem::exists(Path)) continue;
+				std::string Name = std::filesystem::path(Path).stem().string();
+				if (Name == "scene") Name = std::filesystem::path(Path).parent_path().filename().string();
+				auto Model = std::make_shared<io::gltf>(io::gltf::load(Path));
+				auto Mesh = std::make_shared<std::vector<io::optimized_mesh>>();
+				std::size_t Triangles = 0;
+				for (std::size_t m = 0; m < Model->Mesh.size(); m++) {
+					for (std::size_t p = 0; p < Model->Mesh[m].Primitive.size(); p++) {
+						Mesh->push_back(io::optimize_mesh(*Model, m, p));
+						Triangles += Mesh->back().Index.size() / 3;
+					}
+				}
+				aBenchmark.add("lod." + Name + ".lod", Triangles, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						std::size_t Levels = 0;
+						for (std::size_t m = 0; m < Model->Mesh.size(); m++) {
+							for (std::size_t p = 0; p < Model->Mesh[m].Primitive.size(); p++) Levels += io::optimize_mesh(*Model, m, p, Options).lod_count();
+						}
+						benchmark::keep(Levels);
+					}
+				});
+				aBenchmark.add("lod." + Name + ".simplify", Triangles, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						for (const io::optimized_mesh& M : *Mesh) {
+							std::vector<uint32_t> Index = io::simplify(M.Position.data(), M.Normal.data(), M.Texcoord.data(), M.VertexCount, M.Index, M.Index.size() / 6);
+							benchmark::keep(Index.size());
+						}
+					}
+				});
+			}
+
+			const std::size_t Count = 10000;
+			auto Distance = std::make_shared<std::vector<float>>(Count);
+			auto Level = std::make_shared<std::vector<std::size_t>>(Count, SIZE_MAX);
+			std::mt19937 Random(5);
+			std::uniform_real_distribution<float> Uniform(1.0f, 500.0f);
+			for (float& D : *Distance) D = Uniform(Random);
+			aBenchmark.add("lod.select", Count, 64, [=](std::size_t aBatch) {
+				lod_selector Selector(70.0f, 1080.0f);
+				const float Error[] = { 0.0f, 0.01f, 0.04f, 0.16f, 0.64f };
+				std::size_t Sum = 0;
+				for (std::size_t i = 0; i < aBatch; i++) {
+					for (std::size_t j = 0; j < Count; j++) {
+						(*Level)[j] = Selector.select(Error, 5, (*Distance)[j], (*Level)[j]);
+						Sum += (*Level)[j];
+					}
+				}
+				benchmark::keep(Sum);
+			});
+		}
+
+		benchmark::suite LodSuite("lod", register_lod);
+
+	}
+
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <fstream>
+
+#include <geodesy-unit-test/benchmark.h>
+
+// Benchmark entry point. Suites register themselves from their own files in bench/.
+//
+//	--filter <substring>		Only run cases whose id contains substring.
+//	--json <path>				Write results as JSON (default: stdout summary only).
+//	--baseline <path>			Compare against a previously saved results file.
+//	--save-baseline <path>		Write results to path for use as a future baseline.
+//	--tolerance <fraction>		Allowed slowdown vs baseline before flagging (default 0.10).
+//	--min-time <seconds>		Minimum measured time per repetition (default 0.05).
+//
+// Exit code is 1 when any case regressed against the baseline, and -1 on a bad argument
+// or a baseline that cannot be read.
+int main(int aCmdArgCount, char* aCmdArgList[]) {
+	geodesy::benchmark::options Options;
+	std::string JsonPath;
+	std::string BaselinePath;
+	std::string SaveBaselinePath;
+
+	// Whole argument as a non-negative number, false otherwise.
+	auto number = [](const std::string& aText, double& aValue) -> bool {
+		try {
+			std::size_t End = 0;
+			double Value = std::stod(aText, &End);
+			if ((End != aText.size()) || !(Value >= 0.0)) return false;
+			aValue = Value;
+			return true;
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+	};
+
+	for (int i = 1; i < aCmdArgCount; i++) {
+		std::string Argument = aCmdArgList[i];
+		bool HasValue = (i + 1 < aCmdArgCount);
+		if ((Argument == "--filter") && HasValue) 				Options.Filter = aCmdArgList[++i];
+		else if ((Argument == "--json") && HasValue) 			JsonPath = aCmdArgList[++i];
+		else if ((Argument == "--baseline") && HasValue) 		BaselinePath = aCmdArgList[++i];
+		else if ((Argument == "--save-baseline") && HasValue) 	SaveBaselinePath = aCmdArgList[++i];
+		else if (((Argument == "--tolerance") || (Argument == "--min-time")) && HasValue) {
+			std::string Value = aCmdArgList[++i];
+			if (!number(Value, Argument == "--tolerance" ? Options.Tolerance : Options.MinimumTime)) {
+				std::cerr << "Invalid value for " << Argument << ": " << Value << std::endl;
+				return -1;
+			}
+		}
+		else {
+			std::cerr << "Unknown argument: " << Argument << std::endl;
+			return -1;
+		}
+	}
+
+	// Read before running anything, so a bad path fails fast instead of after every suite.
+	std::map<std::string, double> Baseline;
+	if (BaselinePath.size() > 0) {
+		try {
+			Baseline = geodesy::benchmark::load_baseline(BaselinePath);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			return -1;
+		}
+	}
+
+	std::vector<geodesy::benchmark::result> ResultList;
+	for (geodesy::benchmark::suite* Suite : geodesy::benchmark::suite_list()) {
+		std::cout << "\n=== Benchmark Suite: " << Suite->Name << " ===\n\n";
+		geodesy::benchmark Benchmark;
+		Benchmark.Options = Options;
+		Suite->Register(Benchmark);
+		std::vector<geodesy::benchmark::result> SuiteResult = Benchmark.run(Suite->Name, &std::cout);
+		ResultList.insert(ResultList.end(), SuiteResult.begin(), SuiteResult.end());
+	}
+
+	std::size_t RegressionCount = 0;
+	if (BaselinePath.size() > 0) {
+		RegressionCount = geodesy::benchmark::compare(ResultList, Baseline, Options.Tolerance);
+		std::cout << "\n=== Baseline Comparison (" << BaselinePath << ") ===\n\n";
+		for (const geodesy::benchmark::result& R : ResultList) {
+			if (!R.Regressed) continue;
+			std::cout << "REGRESSED: " << R.id() << " " << R.BaselineNanosecondsPerOperation
+					  << " -> " << R.NanosecondsPerOperation << " ns/op" << std::endl;
+		}
+		std::cout << "Regressions: " << RegressionCount << std::endl;
+	}
+
+	// A result or baseline that cannot be written fails the run rather than being dropped.
+	auto write_json = [](const std::string& aPath, const std::string& aJson) -> bool {
+		std::ofstream File(aPath, std::ios::binary | std::ios::trunc);
+		File << aJson;
+		File.close();
+		if (!File.fail()) return true;
+		std::cerr << "Error: could not write '" << aPath << "'" << std::endl;
+		return false;
+	};
+	std::string Json = geodesy::benchmark::to_json(ResultList);
+	if ((JsonPath.size() > 0) && !write_json(JsonPath, Json)) return -1;
+	if ((SaveBaselinePath.size() > 0) && !write_json(SaveBaselinePath, Json)) return -1;
+
+	return RegressionCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/math_simd.h>
+#include <geodesy-unit-test/vec_array.h>
+#include <geodesy-unit-test/grid.h>
+#include <geodesy-unit-test/fft.h>
+
+#include <algorithm>
+#include <random>
+
+// Benchmarks the same math library operations that the math suite in math_test.cpp checks
+// for correctness. Batch counts span L1-resident to main-memory-bound working sets.
+
+namespace geodesy {
+
+	namespace {
+
+		const std::size_t BatchList[] = { 64, 4096, 65536 };
+
+		template <typename T, std::size_t N>
+		std::vector<math::vec<T, N>> random_vec(std::size_t aCount, uint32_t aSeed) {
+			std::mt19937 Generator(aSeed);
+			std::uniform_real_distribution<T> Distribution(T(-10), T(10));
+			std::vector<math::vec<T, N>> List(aCount);
+			for (math::vec<T, N>& V : List) {
+				for (std::size_t i = 0; i < N; i++) V[i] = Distribution(Generator);
+			}
+			return List;
+		}
+
+		template <std::size_t N>
+		math::mat<float, N, N> random_mat(std::mt19937& aGenerator) {
+			std::uniform_real_distribution<float> Distribution(-2.0f, 2.0f);
+			math::mat<float, N, N> A;
+			for (std::size_t i = 0; i < N; i++) {
+				for (std::size_t j = 0; j < N; j++) {
+					A(i, j) = Distribution(aGenerator);
+				}
+			}
+			return A;
+		}
+
+		template <std::size_t N>
+		void add_vec_cases(benchmark& aBenchmark) {
+			std::string Prefix = "vec<float," + std::to_string(N) + ">";
+			for (std::size_t Batch : BatchList) {
+				auto A = std::make_shared<std::vector<math::vec<float, N>>>(random_vec<float, N>(Batch, 1));
+				auto B = std::make_shared<std::vector<math::vec<float, N>>>(random_vec<float, N>(Batch, 2));
+				auto C = std::make_shared<std::vector<math::vec<float, N>>>(Batch);
+
+				aBenchmark.add(Prefix + ".add", N, Batch, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) (*C)[i] = (*A)[i] + (*B)[i];
+					benchmark::keep((*C)[aBatch - 1]);
+				});
+
+				aBenchmark.add(Prefix + ".dot", N, Batch, [=](std::size_t aBatch) {
+					float Sum = 0.0f;
+					for (std::size_t i = 0; i < aBatch; i++) Sum += (*A)[i] * (*B)[i];
+					benchmark::keep(Sum);
+				});
+
+				if constexpr (N == 3) {
+					aBenchmark.add(Prefix + ".cross", N, Batch, [=](std::size_t aBatch) {
+						for (std::size_t i = 0; i < aBatch; i++) (*C)[i] = (*A)[i] ^ (*B)[i];
+						benchmark::keep((*C)[aBatch - 1]);
+					});
+				}
+			}
+		}
+
+		template <std::size_t N>
+		void add_mat_cases(benchmark& aBenchmark) {
+			std::string Prefix = "mat<float," + std::to_string(N) + "," + std::to_string(N) + ">";
+			for (std::size_t Batch : BatchList) {
+				std::mt19937 Generator(3);
+				auto A = std::make_shared<std::vector<math::mat<float, N, N>>>(Batch);
+				auto B = std::make_shared<std::vector<math::mat<float, N, N>>>(Batch);
+				auto C = std::make_shared<std::vector<math::mat<float, N, N>>>(Batch);
+				for (std::size_t i = 0; i < Batch; i++) {
+					(*A)[i] = random_mat<N>(Generator);
+					(*B)[i] = random_mat<N>(Generator);
+				}
+
+				aBenchmark.add(Prefix + ".multiply", N * N, Batch, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) (*C)[i] = (*A)[i] * (*B)[i];
+					benchmark::keep((*C)[aBatch - 1]);
+				});
+
+				aBenchmark.add(Prefix + ".determinant", N * N, Batch, [=](std::size_t aBatch) {
+					float Sum = 0.0f;
+					for (std::size_t i = 0; i < aBatch; i++) Sum += determinant((*A)[i]);
+					benchmark::keep(Sum);
+				});
+
+				if constexpr (N == 4) {
+					auto V = std::make_shared<std::vector<math::vec<float, 4>>>(random_vec<float, 4>(Batch, 6));
+					auto R = std::make_shared<std::vector<math::vec<float, 4>>>(Batch);
+
+					aBenchmark.add(Prefix + ".multiply_vec", N * N, Batch, [=](std::size_t aBatch) {
+						for (std::size_t i = 0; i < aBatch; i++) (*R)[i] = (*A)[i] * (*V)[i];
+						benchmark::keep((*R)[aBatch - 1]);
+					});
+
+					std::string Simd = std::string(".simd.") + math::simd::instruction_set();
+
+					aBenchmark.add(Prefix + ".multiply" + Simd, N * N, Batch, [=](std::size_t aBatch) {
+						for (std::size_t i = 0; i < aBatch; i++) (*C)[i] = math::simd::mul((*A)[i], (*B)[i]);
+						benchmark::keep((*C)[aBatch - 1]);
+					});
+
+					aBenchmark.add(Prefix + ".multiply_vec" + Simd, N * N, Batch, [=](std::size_t aBatch) {
+						for (std::size_t i = 0; i < aBatch; i++) (*R)[i] = math::simd::mul((*A)[i], (*V)[i]);
+						benchmark::keep((*R)[aBatch - 1]);
+					});
+
+					aBenchmark.add(Prefix + ".determinant" + Simd, N * N, Batch, [=](std::size_t aBatch) {
+						float Sum = 0.0f;
+						for (std::size_t i = 0; i < aBatch; i++) Sum += math::simd::determinant((*A)[i]);
+						benchmark::keep(Sum);
+					});
+
+					aBenchmark.add(Prefix + ".inverse" + Simd, N * N, Batch, [=](std::size_t aBatch) {
+						for (std::size_t i = 0; i < aBatch; i++) (*C)[i] = math::simd::inverse((*A)[i]);
+						benchmark::keep((*C)[aBatch - 1]);
+					});
+				}
+			}
+		}
+
+		void add_complex_cases(benchmark& aBenchmark) {
+			for (std::size_t Batch : BatchList) {
+				std::mt19937 Generator(4);
+				std::uniform_real_distribution<float> Distribution(-10.0f, 10.0f);
+				auto A = std::make_shared<std::vector<math::complex<float>>>(Batch);
+				auto B = std::make_shared<std::vector<math::complex<float>>>(Batch);
+				auto C = std::make_shared<std::vector<math::complex<float>>>(Batch);
+				for (std::size_t i = 0; i < Batch; i++) {
+					(*A)[i] = math::complex<float>(Distribution(Generator), Distribution(Generator));
+					(*B)[i] = math::complex<float>(Distribution(Generator), Distribution(Generator));
+				}
+
+				aBenchmark.add("complex<float>.multiply", 2, Batch, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) (*C)[i] = (*A)[i] * (*B)[i];
+					benchmark::keep((*C)[aBatch - 1]);
+				});
+
+				aBenchmark.add("complex<float>.abs", 2, Batch, [=](std::size_t aBatch) {
+					float Sum = 0.0f;
+					for (std::size_t i = 0; i < aBatch; i++) Sum += abs((*A)[i]);
+					benchmark::keep(Sum);
+				});
+
+				aBenchmark.add("complex<float>.phase", 2, Batch, [=](std::size_t aBatch) {
+					float Sum = 0.0f;
+					for (std::size_t i = 0; i < aBatch; i++) Sum += phase((*A)[i]);
+					benchmark::keep(Sum);
+				});
+			}
+		}
+
+		void add_field_cases(benchmark& aBenchmark) {
+			// Field addition, one operation is one full-grid sum.
+			for (std::size_t Resolution : { 16, 50, 128 }) {
+				auto X = std::make_shared<math::field<float, 2, float>>(math::vec<float, 2>{ -5.0f, -5.0f }, math::vec<float, 2>{ 2.0f, 2.0f }, math::vec<std::size_t, 2>{ Resolution, Resolution }, 1.0f);
+				auto Y = std::make_shared<math::field<float, 2, float>>(math::vec<float, 2>{ -2.0f, -3.0f }, math::vec<float, 2>{ 4.0f, 5.0f }, math::vec<std::size_t, 2>{ Resolution, Resolution }, 2.0f);
+				aBenchmark.add("field<float,2,float>.add", Resolution * Resolution, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						math::field<float, 2, float> Sum = *X + *Y;
+						benchmark::keep(Sum);
+					}
+				});
+			}
+
+			// Fused X + Y * 2 on math::grid, against the same expression evaluated one
+			// operator at a time. The fused form allocates only its result.
+			for (std::size_t Resolution : { 16, 50, 128 }) {
+				auto X = std::make_shared<math::grid<float, 2, float>>(math::vec<float, 2>{ -5.0f, -5.0f }, math::vec<float, 2>{ 2.0f, 2.0f }, math::vec<std::size_t, 2>{ Resolution, Resolution }, 1.0f);
+				auto Y = std::make_shared<math::grid<float, 2, float>>(math::vec<float, 2>{ -5.0f, -5.0f }, math::vec<float, 2>{ 2.0f, 2.0f }, math::vec<std::size_t, 2>{ Resolution, Resolution }, 2.0f);
+				aBenchmark.add("grid<float,2,float>.add_scaled.fused", Resolution * Resolution, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						math::grid<float, 2, float> Sum = *X + *Y * 2.0f;
+						benchmark::keep(Sum);
+					}
+				});
+				aBenchmark.add("grid<float,2,float>.add_scaled.unfused", Resolution * Resolution, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						math::grid<float, 2, float> Scaled = *Y * 2.0f;
+						math::grid<float, 2, float> Sum = *X + Scaled;
+						benchmark::keep(Sum);
+					}
+				});
+			}
+
+			// Point sampling, one operation is one sample.
+			auto Field = std::make_shared<math::field<float, 2, float>>(math::vec<float, 2>{ -5.0f, -5.0f }, math::vec<float, 2>{ 2.0f, 2.0f }, math::vec<std::size_t, 2>{ 50, 50 }, 1.0f);
+			for (std::size_t Batch : BatchList) {
+				std::mt19937 Generator(5);
+				std::uniform_real_distribution<float> Distribution(-5.0f, 2.0f);
+				auto Point = std::make_shared<std::vector<math::vec<float, 2>>>(Batch);
+				for (math::vec<float, 2>& P : *Point) P = { Distribution(Generator), Distribution(Generator) };
+
+				aBenchmark.add("field<float,2,float>.sample", 50 * 50, Batch, [=](std::size_t aBatch) {
+					float Sum = 0.0f;
+					for (std::size_t i = 0; i < aBatch; i++) Sum += (*Field)((*Point)[i]);
+					benchmark::keep(Sum);
+				});
+			}
+		}
+
+		void add_vec_array_cases(benchmark& aBenchmark) {
+			math::mat<float, 4, 4> Transform = math::mat<float, 4, 4>(
+				0.0f, -2.0f, 0.0f, 1.0f,
+				2.0f, 0.0f, 0.0f, -3.0f,
+				0.0f, 0.0f, 2.0f, 0.5f,
+				0.0f, 0.0f, 0.0f, 1.0f
+			);
+			for (std::size_t Batch : BatchList) {
+				auto AoS = std::make_shared<std::vector<math::vec<float, 3>>>(random_vec<float, 3>(Batch, 7));
+				auto AoSOut = std::make_shared<std::vector<math::vec<float, 3>>>(Batch);
+				auto SoA = std::make_shared<math::vec_array<float, 3>>(*AoS);
+				auto SoAOut = std::make_shared<math::vec_array<float, 3>>(Batch);
+
+				// Per-element reference, as CPU mesh processing is written today.
+				aBenchmark.add("vec<float,3>.transform_points", 3, Batch, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						const math::vec<float, 3>& P = (*AoS)[i];
+						math::vec<float, 4> R = Transform * math::vec<float, 4>{ P[0], P[1], P[2], 1.0f };
+						(*AoSOut)[i] = { R[0], R[1], R[2] };
+					}
+					benchmark::keep((*AoSOut)[aBatch - 1]);
+				});
+
+				aBenchmark.add("vec_array<float,3>.transform_points", 3, Batch, [=](std::size_t aBatch) {
+					math::batch::transform_points(Transform, *SoA, *SoAOut);
+					benchmark::keep(SoAOut->component(0)[aBatch - 1]);
+				});
+
+				aBenchmark.add("vec_array<float,3>.normalize", 3, Batch, [=](std::size_t aBatch) {
+					math::batch::normalize(*SoAOut);
+					benchmark::keep(SoAOut->component(0)[aBatch - 1]);
+				});
+
+				aBenchmark.add("vec_array<float,3>.cross", 3, Batch, [=](std::size_t aBatch) {
+					math::batch::cross(*SoA, *SoA, *SoAOut);
+					benchmark::keep(SoAOut->component(0)[aBatch - 1]);
+				});
+
+				aBenchmark.add("vec_array<float,3>.bounds", 3, Batch, [=](std::size_t) {
+					math::vec<float, 3> Min, Max;
+					math::batch::bounds(*SoA, Min, Max);
+					benchmark::keep(Max);
+				});
+			}
+		}
+
+		void add_grid_sample_cases(benchmark& aBenchmark) {
+			auto Jobs = std::make_shared<job_system>(0);
+			for (std::size_t Batch : { (std::size_t)4096, (std::size_t)65536, (std::size_t)1 << 20 }) {
+				std::mt19937 Generator(8);
+				std::uniform_real_distribution<float> Distribution(-1.0f, 1.0f);
+				auto Volume = std::make_shared<math::grid<float, 3, float>>(math::vec<float, 3>{ -1.0f, -1.0f, -1.0f }, math::vec<float, 3>{ 1.0f, 1.0f, 1.0f }, math::vec<std::size_t, 3>{ 64, 64, 64 }, 0.0f);
+				for (std::size_t i = 0; i < Volume->size(); i++) (*Volume)[i] = Distribution(Generator);
+				auto Point = std::make_shared<math::vec_array<float, 3>>(Batch);
+				for (std::size_t i = 0; i < Batch; i++) Point->set(i, { Distribution(Generator), Distribution(Generator), Distribution(Generator) });
+				auto Out = std::make_shared<std::vector<float>>(Point->stride());
+
+				aBenchmark.add("grid<float,3,float>.sample.point", 64 * 64 * 64, Batch, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) (*Out)[i] = (*Volume)(Point->get(i));
+					benchmark::keep((*Out)[aBatch - 1]);
+				});
+
+				aBenchmark.add("grid<float,3,float>.sample.batch", 64 * 64 * 64, Batch, [=](std::size_t aBatch) {
+					Volume->sample(*Point, Out->data());
+					benchmark::keep((*Out)[aBatch - 1]);
+				});
+
+				aBenchmark.add("grid<float,3,float>.sample.parallel", 64 * 64 * 64, Batch, [=](std::size_t aBatch) {
+					Volume->sample_parallel(*Point, Out->data(), Jobs.get());
+					benchmark::keep((*Out)[aBatch - 1]);
+				});
+			}
+		}
+
+		// Sparse volume, a thin shell through a 128^3 box touches a few percent of the
+		// 8^3 bricks. Dense and bricked sums of the same data, one operation is one node.
+		void add_grid_bricked_cases(benchmark& aBenchmark) {
+			using dense = math::grid<float, 3, float>;
+			using sparse = math::grid<float, 3, float, math::bricked<8>>;
+			const std::size_t Resolution = 128;
+			math::vec<float, 3> Lower = { -1.0f, -1.0f, -1.0f }, Upper = { 1.0f, 1.0f, 1.0f };
+			math::vec<std::size_t, 3> Count = { Resolution, Resolution, Resolution };
+			auto DenseX = std::make_shared<dense>(Lower, Upper, Count, 0.0f), DenseY = std::make_shared<dense>(Lower, Upper, Count, 0.0f);
+			auto SparseX = std::make_shared<sparse>(Lower, Upper, Count, 0.0f), SparseY = std::make_shared<sparse>(Lower, Upper, Count, 0.0f);
+			for (std::size_t i = 0; i < DenseX->size(); i++) {
+				math::vec<float, 3> Position = DenseX->Layout.position(i);
+				float Radius = std::sqrt(Position * Position);
+				if (std::abs(Radius - 0.6f) > 0.02f) continue;
+				(*DenseX)[i] = (*SparseX)[i] = Radius;
+				(*DenseY)[i] = (*SparseY)[i] = 1.0f - Radius;
+			}
+
+			aBenchmark.add("grid<float,3,float>.add_scaled.dense", DenseX->size(), 1, [=](std::size_t aBatch) {
+				for (std::size_t i = 0; i < aBatch; i++) {
+					dense Sum = *DenseX + *DenseY * 2.0f;
+					benchmark::keep(Sum);
+				}
+			});
+			aBenchmark.add("grid<float,3,float>.add_scaled.bricked", SparseX->size(), 1, [=](std::size_t aBatch) {
+				for (std::size_t i = 0; i < aBatch; i++) {
+					sparse Sum = *SparseX + *SparseY * 2.0f;
+					benchmark::keep(Sum);
+				}
+			});
+		}
+
+		void add_fft_cases(benchmark& aBenchmark) {
+			// One operation is one forward transform, sizes cover radix 4, mixed radix and Bluestein.
+			for (std::size_t Size : { (std::size_t)1024, (std::size_t)1000, (std::size_t)1031, (std::size_t)65536 }) {
+				std::mt19937 Generator(9);
+				std::uniform_real_distribution<float> Distribution(-1.0f, 1.0f);
+				auto Plan = std::make_shared<math::fft<float>>(Size);
+				auto Input = std::make_shared<std::vector<math::complex<float>>>(Size);
+				auto Data = std::make_shared<std::vector<math::complex<float>>>(Size);
+				auto Scratch = std::make_shared<std::vector<math::complex<float>>>(Plan->scratch_size());
+				for (math::complex<float>& Value : *Input) Value = math::complex<float>(Distribution(Generator), Distribution(Generator));
+				// The unnormalized transform grows the energy N fold per pass, so every pass starts
+				// from the pristine input instead of running in place until it overflows to inf.
+				// The copy is O(N) against the transform's O(N log N).
+				aBenchmark.add("fft<float>.forward", Size, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						std::copy(Input->begin(), Input->end(), Data->begin());
+						Plan->forward(Data->data(), Scratch->data());
+					}
+					benchmark::keep((*Data)[0]);
+				});
+			}
+
+			// 2D blur of a 256^2 field, FFT against direct convolution. One operation is one blur.
+			for (float Sigma : { 0.01f, 0.03f }) {
+				auto Field = std::make_shared<math::grid<float, 2, float>>(math::vec<float, 2>{ 0.0f, 0.0f }, math::vec<float, 2>{ 1.0f, 1.0f }, math::vec<std::size_t, 2>{ 256, 256 }, 0.0f);
+				std::mt19937 Generator(10);
+				std::uniform_real_distribution<float> Distribution(0.0f, 1.0f);
+				for (std::size_t i = 0; i < Field->size(); i++) (*Field)[i] = Distribution(Generator);
+				auto Kernel = std::make_shared<math::grid<float, 2, float>>(math::gaussian_kernel(*Field, Sigma));
+				aBenchmark.add("grid<float,2,float>.blur.fft", Kernel->size(), 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(math::convolve(*Field, *Kernel));
+				});
+				aBenchmark.add("grid<float,2,float>.blur.direct", Kernel->size(), 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(math::convolve_direct(*Field, *Kernel));
+				});
+			}
+		}
+
+		void register_math(benchmark& aBenchmark) {
+			add_vec_cases<2>(aBenchmark);
+			add_vec_cases<3>(aBenchmark);
+			add_vec_cases<4>(aBenchmark);
+			add_mat_cases<3>(aBenchmark);
+			add_mat_cases<4>(aBenchmark);
+			add_vec_array_cases(aBenchmark);
+			add_complex_cases(aBenchmark);
+			add_field_cases(aBenchmark);
+			add_grid_sample_cases(aBenchmark);
+			add_grid_bricked_cases(aBenchmark);
+			add_fft_cases(aBenchmark);
+		}
+
+		benchmark::suite MathSuite("math", register_math);
+
+	}
+
+}
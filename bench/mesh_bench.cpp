@@ -0,0 +1,92 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/mesh_optimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <random>
+
+// Import time mesh optimization of the bundled models. .optimize runs the pipeline on
+// every primitive with float and with quantized vertices, .cold does the same through an
+// emptied mesh cache and stores the result, .warm reads it back. mesh.grid.vertex_cache
+// reorders a 256 x 256 grid whose triangles were shuffled. Run from the repo root.
+
+namespace geodesy {
+
+	namespace {
+
+		const char* ModelList[] = {
+			"assets/models/pirate_map/scene.gltf",
+			"assets/models/Pigwithanimation.gltf",
+		};
+
+		std::size_t optimize_all(const io::gltf& aModel, const io::mesh_options& aOptions) {
+			std::size_t Bytes = 0;
+			for (std::size_t m = 0; m < aModel.Mesh.size(); m++) {
+				for (std::size_t p = 0; p < aModel.Mesh[m].Primitive.size(); p++) Bytes += (std::size_t)io::optimize_mesh(aModel, m, p, aOptions).After.VertexBytes;
+			}
+			return Bytes;
+		}
+
+		void register_mesh(benchmark& aBenchmark) {
+			for (const char* Path : ModelList) {
+				if (!std::filesystem::exists(Path)) continue;
+				std::string File = Path;
+				std::string Name = std::filesystem::path(Path).stem().string();
+				if (Name == "scene") Name = std::filesystem::path(Path).parent_path().filename().string();
+				auto Model = std::make_shared<io::gltf>(io::gltf::load(File));
+				std::size_t Triangles = 0;
+				for (const io::gltf::mesh& Mesh : Model->Mesh) {
+					for (const io::gltf::primitive& Primitive : Mesh.Primitive) Triangles += Primitive.Indices != SIZE_MAX ? Model->Accessor[Primitive.Indices].Count / 3 : 0;
+				}
+				io::mesh_options Quantized;
+				Quantized.Quantize = true;
+				aBenchmark.add("mesh." + Name + ".optimize", Triangles, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(optimize_all(*Model, io::mesh_options()));
+				});
+				aBenchmark.add("mesh." + Name + ".optimize.quantize", Triangles, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(optimize_all(*Model, Quantized));
+				});
+
+				std::filesystem::path Directory = std::filesystem::temp_directory_path() / ("geodesy-mesh-bench-" + Name);
+				auto Cache = std::make_shared<io::mesh_cache>(Directory.string());
+				aBenchmark.add("mesh." + Name + ".cold", Triangles, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						std::filesystem::remove_all(Directory);
+						benchmark::keep(Cache->load(File).size());
+					}
+				});
+				aBenchmark.add("mesh." + Name + ".warm", Triangles, 1, [=](std::size_t aBatch) {
+					Cache->load(File);
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(Cache->load(File).size());
+				});
+			}
+
+			const uint32_t Size = 256;
+			auto Grid = std::make_shared<std::vector<uint32_t>>();
+			for (uint32_t y = 0; y < Size; y++) {
+				for (uint32_t x = 0; x < Size; x++) {
+					uint32_t A = y * (Size + 1) + x;
+					Grid->insert(Grid->end(), { A, A + 1, A + Size + 2, A, A + Size + 2, A + Size + 1 });
+				}
+			}
+			std::vector<std::array<uint32_t, 3>> Triangle;
+			for (std::size_t i = 0; i < Grid->size(); i += 3) Triangle.push_back({ (*Grid)[i], (*Grid)[i + 1], (*Grid)[i + 2] });
+			std::shuffle(Triangle.begin(), Triangle.end(), std::mt19937(7));
+			for (std::size_t t = 0; t < Triangle.size(); t++) std::copy_n(Triangle[t].begin(), 3, Grid->begin() + 3 * t);
+			aBenchmark.add("mesh.grid.vertex_cache", Grid->size() / 3, 1, [=](std::size_t aBatch) {
+				for (std::size_t i = 0; i < aBatch; i++) {
+					std::vector<uint32_t> Index = *Grid;
+					io::optimize_vertex_cache(Index, (Size + 1) * (Size + 1));
+					benchmark::keep(Index[0]);
+				}
+			});
+		}
+
+		benchmark::suite MeshSuite("mesh", register_mesh);
+
+	}
+
+}
@@ -0,0 +1,56 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/physics.h>
+
+#include <cmath>
+#include <random>
+
+// One fixed step of level_01.yaml's physics settings for 100 to 100k spheres raining onto
+// a floor, spread so the number of bodies per square metre stays the same at every size.
+// The world is stepped for a second before timing so the floor is covered with resting
+// contacts. physics.N.serial steps without a job system, physics.N.jobs on every core.
+
+namespace geodesy {
+
+	namespace {
+
+		std::shared_ptr<physics_world> make_world(std::size_t aCount) {
+			physics_settings Settings;
+			Settings.Gravity = { 0.0f, 0.0f, -9.81f };
+			Settings.TimeStep = 0.016667f;
+			Settings.VelocityIterations = 8;
+			Settings.PositionIterations = 3;
+			auto World = std::make_shared<physics_world>(Settings);
+			World->add_plane({ 0.0f, 0.0f, 1.0f }, 0.0f);
+			float Half = 0.5f * std::sqrt((float)aCount);
+			std::mt19937 Random(1);
+			std::uniform_real_distribution<float> Spread(-Half, Half), Height(0.5f, 3.0f), Size(0.2f, 0.35f);
+			for (std::size_t i = 0; i < aCount; i++) {
+				World->add_sphere({ Spread(Random), Spread(Random), Height(Random) }, Size(Random), 1.0f);
+			}
+			for (int Step = 0; Step < 60; Step++) World->substep();
+			return World;
+		}
+
+		void register_physics(benchmark& aBenchmark) {
+			auto Jobs = std::make_shared<job_system>(0);
+			for (std::size_t Count : { 100, 1000, 10000, 100000 }) {
+				auto Serial = make_world(Count);
+				aBenchmark.add("physics." + std::to_string(Count) + ".serial", Count, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) Serial->substep();
+					benchmark::keep(Serial->stats().Contacts);
+				});
+				auto Parallel = make_world(Count);
+				aBenchmark.add("physics." + std::to_string(Count) + ".jobs", Count, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) Parallel->substep(Jobs.get());
+					benchmark::keep(Parallel->stats().Contacts);
+				});
+			}
+		}
+
+		benchmark::suite PhysicsSuite("physics", register_physics);
+
+	}
+
+}
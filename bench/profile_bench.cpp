@@ -0,0 +1,52 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/profiler.h>
+
+// Cost of one profiler scope around a trivial body, recording and with the profiler
+// switched off at run time, against the bare body. ns/op is per scope, an enabled scope
+// costs two steady_clock reads plus a ring store.
+
+namespace geodesy {
+
+	namespace {
+
+		void register_profile(benchmark& aBenchmark) {
+			aBenchmark.add("scope.none", 1, 1024, [](std::size_t aBatch) {
+				uint64_t Sum = 0;
+				for (std::size_t b = 0; b < aBatch; b++) {
+					Sum += b;
+					benchmark::keep(&Sum);
+				}
+			});
+
+			aBenchmark.add("scope.enabled", 1, 1024, [](std::size_t aBatch) {
+				uint64_t Sum = 0;
+				for (std::size_t b = 0; b < aBatch; b++) {
+					GEODESY_PROFILE_SCOPE("bench", "scope");
+					Sum += b;
+					benchmark::keep(&Sum);
+				}
+			});
+
+			aBenchmark.add("scope.disabled", 1, 1024, [](std::size_t aBatch) {
+				profiler::instance().Enabled = false;
+				uint64_t Sum = 0;
+				for (std::size_t b = 0; b < aBatch; b++) {
+					GEODESY_PROFILE_SCOPE("bench", "scope");
+					Sum += b;
+					benchmark::keep(&Sum);
+				}
+				profiler::instance().Enabled = true;
+			});
+
+			aBenchmark.add("frame_mark", 1, 1024, [](std::size_t aBatch) {
+				for (std::size_t b = 0; b < aBatch; b++) profiler::instance().frame_mark();
+			});
+		}
+
+		benchmark::suite ProfileSuite("profile", register_profile);
+
+	}
+
+}
@@ -0,0 +1,65 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/stage_loader.h>
+
+#include <cmath>
+#include <cstring>
+
+// Stage construction with serial and parallel loading. The world mirrors level_01.yaml,
+// one large scene model and many small props, with loads that build vertex data in
+// proportion to the model and a finalize that copies it to a staging buffer.
+
+namespace geodesy {
+
+	namespace {
+
+		std::vector<io::object_description> level_objects(std::size_t aCount) {
+			std::vector<io::object_description> List(aCount);
+			for (std::size_t i = 0; i < aCount; i++) {
+				List[i] = io::object_description{};
+				List[i].Name = "Object" + std::to_string(i);
+				// Vertex count, the first object is the large scene model.
+				List[i].FrameCount = (i == 0) ? (1u << 18) : (1u << 14) * (uint32_t)(1 + i % 4);
+			}
+			return List;
+		}
+
+		std::vector<float> load_vertices(const io::object_description& aObject) {
+			std::vector<float> Vertex(aObject.FrameCount * 8);
+			for (std::size_t v = 0; v < aObject.FrameCount; v++) {
+				float T = (float)v * 0.001f;
+				float* Out = &Vertex[v * 8];
+				Out[0] = std::sin(T); Out[1] = std::cos(T); Out[2] = T;
+				Out[3] = std::cos(T); Out[4] = -std::sin(T); Out[5] = 0.0f;
+				Out[6] = std::fmod(T, 1.0f); Out[7] = std::fmod(T * 0.5f, 1.0f);
+			}
+			return Vertex;
+		}
+
+		void register_stage(benchmark& aBenchmark) {
+			auto Pool = std::make_shared<job_system>(0);
+			for (std::size_t ObjectCount : { 16, 64 }) {
+				auto List = std::make_shared<std::vector<io::object_description>>(level_objects(ObjectCount));
+				auto Staging = std::make_shared<std::vector<float>>((1u << 18) * 8);
+				std::function<std::vector<float>(const io::object_description&)> Load = load_vertices;
+				std::function<void(std::size_t, std::vector<float>&)> Finalize = [=](std::size_t, std::vector<float>& aVertex) {
+					std::memcpy(Staging->data(), aVertex.data(), aVertex.size() * sizeof(float));
+				};
+				for (std::shared_ptr<job_system> Jobs : { std::shared_ptr<job_system>(), Pool }) {
+					std::string Name = Jobs == nullptr ? "stage.build.serial" : "stage.build.parallel";
+					aBenchmark.add(Name, ObjectCount, 1, [=](std::size_t aBatch) {
+						for (std::size_t b = 0; b < aBatch; b++) {
+							std::vector<std::vector<float>> Result = io::build_objects(*List, Load, Finalize, nullptr, Jobs.get());
+							benchmark::keep(Result.back().back());
+						}
+					});
+				}
+			}
+		}
+
+		benchmark::suite StageSuite("stage", register_stage);
+
+	}
+
+}
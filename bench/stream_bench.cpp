@@ -0,0 +1,85 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/world_streamer.h>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+// World switches of growing size, loaded and integrated in one blocking call against a
+// background prefetch integrated at the default 60 Hz budget (4.2 ms per frame). The load
+// builds a 4096 vertex mesh, integration copies it into a staging buffer as an upload
+// would. ns/op is the whole switch. The streamed case spreads it over frames that each
+// stay within the budget, its total includes frames spent waiting on the loader.
+
+namespace geodesy {
+
+	namespace {
+
+		const std::size_t ObjectCountList[] = { 16, 128 };
+
+		std::vector<float> load_mesh(const io::object_description& aObject) {
+			std::vector<float> Vertex;
+			Vertex.reserve(64 * 64 * 8);
+			for (std::size_t i = 0; i < 64; i++) {
+				for (std::size_t j = 0; j < 64; j++) {
+					float Theta = 3.14159265f * (float)i / 63.0f, Phi = 6.2831853f * (float)j / 63.0f;
+					float X = std::sin(Theta) * std::cos(Phi), Y = std::sin(Theta) * std::sin(Phi), Z = std::cos(Theta);
+					float Data[8] = { aObject.Position[0] + X, Y, Z, X, Y, Z, (float)j / 63.0f, (float)i / 63.0f };
+					Vertex.insert(Vertex.end(), Data, Data + 8);
+				}
+			}
+			return Vertex;
+		}
+
+		std::string write_world(std::size_t aObjectCount) {
+			std::filesystem::path Path = std::filesystem::temp_directory_path() / ("geodesy-stream-bench-" + std::to_string(aObjectCount) + ".yaml");
+			std::ofstream Stream(Path, std::ios::binary | std::ios::trunc);
+			Stream << "World:\n  Name: \"Bench\"\n  Objects:\n";
+			for (std::size_t i = 0; i < aObjectCount; i++) {
+				Stream << "    - Name: \"Prop" << i << "\"\n      Type: \"object\"\n      Position: [" << i << ", 0, 0]\n";
+			}
+			return Path.string();
+		}
+
+		void register_stream(benchmark& aBenchmark) {
+			double Budget = io::streaming_config().budget();
+			for (std::size_t ObjectCount : ObjectCountList) {
+				std::string Path = write_world(ObjectCount);
+				auto Staging = std::make_shared<std::vector<float>>(64 * 64 * 8);
+				auto integrate = [=](const std::string&, const io::object_description&, std::vector<float>& aMesh) {
+					std::copy(aMesh.begin(), aMesh.end(), Staging->begin());
+				};
+
+				// The whole world in one call, the frame it happens in stalls for all of it.
+				aBenchmark.add("world.switch.blocking", ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) {
+						io::world_description World = io::world_description::from_yaml(io::yaml::load(Path));
+						for (const io::object_description& Object : World.Object) {
+							std::vector<float> Mesh = load_mesh(Object);
+							integrate(World.Name, Object, Mesh);
+						}
+						benchmark::keep(Staging->data());
+					}
+				});
+
+				aBenchmark.add("world.switch.streamed", ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t b = 0; b < aBatch; b++) {
+						io::world_streamer<std::vector<float>> Streamer(load_mesh, integrate);
+						Streamer.prefetch("Bench", Path);
+						Streamer.request("Bench");
+						while (Streamer.status("Bench") == io::world_streamer<std::vector<float>>::INTEGRATING) {
+							if (Streamer.update(Budget).Integrated == 0) std::this_thread::yield();
+						}
+						benchmark::keep(Staging->data());
+					}
+				});
+			}
+		}
+
+		benchmark::suite StreamSuite("stream", register_stream);
+
+	}
+
+}
@@ -0,0 +1,75 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/texture_cache.h>
+
+#include <filesystem>
+
+// Texture loading of the bundled models. Cold loads decode, build the mip chain and store
+// it in an emptied cache, serially and on the worker pool. Warm loads are served from the
+// cache and read one byte per page of every level, so the mapped pixels are actually
+// faulted in as an upload would. Run from the repo root.
+
+namespace geodesy {
+
+	namespace {
+
+		struct texture_set {
+			const char* 	Name;
+			const char* 	Directory;
+		};
+
+		const texture_set SetList[] = {
+			{ "pirate_map", "assets/models/pirate_map/textures" },
+			{ "bricks2", "assets/models/bricks2" },
+		};
+
+		std::size_t touch(const std::vector<io::texture>& aTexture) {
+			std::size_t Sum = 0;
+			for (const io::texture& Texture : aTexture) {
+				const uint8_t* Data = Texture.data();
+				for (std::size_t i = 0; i < Texture.byte_size(); i += 4096) Sum += Data[i];
+			}
+			return Sum;
+		}
+
+		void register_texture(benchmark& aBenchmark) {
+			auto Pool = std::make_shared<job_system>(0);
+			for (const texture_set& Set : SetList) {
+				if (!std::filesystem::exists(Set.Directory)) continue;
+				// Base color maps are sRGB, normal and displacement maps are data.
+				auto Source = std::make_shared<std::vector<io::texture_cache::source>>();
+				std::size_t Size = 0;
+				for (const std::filesystem::directory_entry& Entry : std::filesystem::directory_iterator(Set.Directory)) {
+					std::string Extension = Entry.path().extension().string();
+					if ((Extension != ".png") && (Extension != ".jpg")) continue;
+					std::string Stem = Entry.path().stem().string();
+					bool Data = (Stem.find("normal") != std::string::npos) || (Stem.find("disp") != std::string::npos);
+					Source->push_back({ Entry.path().string(), { true, !Data } });
+					Size += (std::size_t)Entry.file_size();
+				}
+				if (Source->empty()) continue;
+
+				std::string Name = Set.Name;
+				std::filesystem::path Directory = std::filesystem::temp_directory_path() / ("geodesy-texture-bench-" + Name);
+				auto Cache = std::make_shared<io::texture_cache>(Directory.string());
+				for (std::shared_ptr<job_system> Jobs : { std::shared_ptr<job_system>(), Pool }) {
+					aBenchmark.add("texture." + Name + ".cold" + (Jobs == nullptr ? ".serial" : ".parallel"), Size, 1, [=](std::size_t aBatch) {
+						for (std::size_t i = 0; i < aBatch; i++) {
+							std::filesystem::remove_all(Directory);
+							benchmark::keep(Cache->load_all(*Source, nullptr, Jobs.get()).size());
+						}
+					});
+				}
+				aBenchmark.add("texture." + Name + ".warm", Size, 1, [=](std::size_t aBatch) {
+					Cache->load_all(*Source, nullptr, Pool.get());
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(touch(Cache->load_all(*Source, nullptr, Pool.get())));
+				});
+			}
+		}
+
+		benchmark::suite TextureSuite("texture", register_texture);
+
+	}
+
+}
@@ -0,0 +1,60 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/transform_hierarchy.h>
+
+// World transforms of 400 objects, each with a 15 node model tree (6000 nodes). all moves
+// every object every frame, the cost of recomputing every world matrix. moving.N moves N
+// percent of the objects, static moves none, the steady state of scenery like Sponza.
+
+namespace geodesy {
+
+	namespace {
+
+		const std::size_t ObjectCount = 400;
+		const std::size_t NodePerObject = 15;
+
+		struct scene {
+			transform_hierarchy 					Hierarchy;
+			std::vector<transform_hierarchy::id> 	Object;
+			float 									Time = 0.0f;
+		};
+
+		std::shared_ptr<scene> make_scene() {
+			auto Scene = std::make_shared<scene>();
+			for (std::size_t o = 0; o < ObjectCount; o++) {
+				transform_hierarchy::id Root = Scene->Hierarchy.add(object_transform({ (float)(o % 20) * 3.0f, (float)(o / 20) * 3.0f, 0.0f }, { (float)o, 0.0f }, { 1.0f, 1.0f, 1.0f }));
+				Scene->Object.push_back(Root);
+				// Binary tree below the object root.
+				std::vector<transform_hierarchy::id> Node = { Root };
+				for (std::size_t n = 1; n < NodePerObject; n++) {
+					Node.push_back(Scene->Hierarchy.add(object_transform({ 0.0f, 0.0f, 0.5f }, { 10.0f * (float)n, 5.0f }, { 0.9f, 0.9f, 0.9f }), Node[(n - 1) / 2]));
+				}
+			}
+			Scene->Hierarchy.update();
+			return Scene;
+		}
+
+		void register_transform(benchmark& aBenchmark) {
+			const std::size_t NodeCount = ObjectCount * NodePerObject;
+			for (std::size_t Percent : { 100, 10, 1, 0 }) {
+				auto Scene = make_scene();
+				std::string Name = Percent == 100 ? "transform.all" : (Percent == 0 ? "transform.static" : "transform.moving." + std::to_string(Percent));
+				aBenchmark.add(Name, NodeCount, 1, [=](std::size_t aBatch) {
+					std::size_t Moving = ObjectCount * Percent / 100;
+					for (std::size_t b = 0; b < aBatch; b++) {
+						Scene->Time += 0.016667f;
+						for (std::size_t o = 0; o < Moving; o++) {
+							Scene->Hierarchy.set_local(Scene->Object[o], object_transform({ (float)o, Scene->Time, 0.0f }, { Scene->Time * 10.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }));
+						}
+						benchmark::keep(Scene->Hierarchy.update());
+					}
+				});
+			}
+		}
+
+		benchmark::suite TransformSuite("transform", register_transform);
+
+	}
+
+}
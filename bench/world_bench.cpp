@@ -0,0 +1,72 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/benchmark.h>
+#include <geodesy-unit-test/yaml.h>
+#include <geodesy-unit-test/world_snapshot.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <random>
+
+// World loading from text YAML against the compiled binary snapshot of the same file.
+// Object counts span the shipped level (16 objects) to large streamed worlds.
+
+namespace geodesy {
+
+	namespace {
+
+		const std::size_t ObjectCountList[] = { 16, 1000, 10000 };
+
+		std::string synthetic_world(std::size_t aObjectCount, uint32_t aSeed) {
+			std::mt19937 Generator(aSeed);
+			std::uniform_real_distribution<float> Distribution(-100.0f, 100.0f);
+			std::stringstream Stream;
+			Stream << "World:\n  Name: \"Synthetic\"\n  Physics:\n    Gravity: [0.0, 0.0, -9.81]\n"
+				   << "    TimeStep: 0.016667\n    VelocityIterations: 8\n    PositionIterations: 3\n  Objects:\n";
+			for (std::size_t i = 0; i < aObjectCount; i++) {
+				Stream << "    - Name: \"Object" << i << "\"\n"
+					   << "      Type: \"object\"\n"
+					   << "      ModelPath: \"dep/gltf-models/2.0/Model" << (i % 32) << "/glTF/Model" << (i % 32) << ".gltf\"\n"
+					   << "      Position: [" << Distribution(Generator) << ", " << Distribution(Generator) << ", " << Distribution(Generator) << "]\n"
+					   << "      Direction: [" << Distribution(Generator) << ", 0.0]\n"
+					   << "      Scale: [1.0, 1.0, 1.0]\n";
+				if (i % 8 == 0) Stream << "      AnimationWeights: [0.0, 1.0]\n";
+			}
+			return Stream.str();
+		}
+
+		void register_world(benchmark& aBenchmark) {
+			std::filesystem::path Directory = std::filesystem::temp_directory_path() / "geodesy-world-bench";
+			std::filesystem::create_directories(Directory);
+			for (std::size_t ObjectCount : ObjectCountList) {
+				std::string Source = (Directory / ("world_" + std::to_string(ObjectCount) + ".yaml")).string();
+				std::string Snapshot = io::world_snapshot::path_for(Source);
+				std::ofstream(Source, std::ios::binary | std::ios::trunc) << synthetic_world(ObjectCount, (uint32_t)ObjectCount);
+				io::world_snapshot::compile(Source, Snapshot);
+
+				// Full text path, read and parse the file and build the description.
+				aBenchmark.add("world.load.yaml", ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(io::world_description::from_yaml(io::yaml::load(Source)).Object.size());
+				});
+
+				// Snapshot path as the loader takes it, currency check and copy into a description.
+				aBenchmark.add("world.load.snapshot", ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) benchmark::keep(io::load_world(Source, Snapshot).Object.size());
+				});
+
+				// Mapping alone, for consumers that read records in place.
+				aBenchmark.add("world.map.snapshot", ObjectCount, 1, [=](std::size_t aBatch) {
+					for (std::size_t i = 0; i < aBatch; i++) {
+						io::world_snapshot View(Snapshot);
+						benchmark::keep(View.object(View.object_count() - 1).Position[0]);
+					}
+				});
+			}
+		}
+
+		benchmark::suite WorldSuite("world", register_world);
+
+	}
+
+}
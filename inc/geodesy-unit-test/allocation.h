@@ -0,0 +1,23 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_ALLOCATION_H
+#define GEODESY_UNIT_TEST_ALLOCATION_H
+
+#include <cstdint>
+#include <atomic>
+
+namespace geodesy {
+
+	// Heap allocation counters, bumped by the global operator new replacement in
+	// src/allocation_hook.cpp which is linked into the app and the benchmark.
+	struct allocation {
+		// Every allocation on every thread.
+		inline static std::atomic<uint64_t> Total{ 0 };
+		// Bytes requested by every allocation on every thread.
+		inline static std::atomic<uint64_t> Bytes{ 0 };
+		// Allocations made by the calling thread.
+		inline static thread_local uint64_t Thread = 0;
+	};
+
+}
+
+#endif // GEODESY_UNIT_TEST_ALLOCATION_H
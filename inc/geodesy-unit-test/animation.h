@@ -0,0 +1,561 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_ANIMATION_H
+#define GEODESY_UNIT_TEST_ANIMATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <geodesy-unit-test/gltf.h>
+#include <geodesy-unit-test/vec_array.h>
+#include <geodesy-unit-test/job_system.h>
+
+namespace geodesy {
+
+	// Joint hierarchy and rest pose of a glTF skin. Joints keep the skin's order, the order
+	// JOINTS_0 indexes the palette by, and Order lists them parents first. Affine matrices
+	// here are 3x4 column-major, A(r,c) == Data[3*c + r].
+	struct skeleton {
+		std::vector<std::string> 	Name;
+		std::vector<std::size_t> 	Node; 				// glTF node of each joint.
+		std::vector<int32_t> 		Parent; 			// Nearest joint ancestor, -1 for roots.
+		std::vector<uint32_t> 		Order; 				// Parents before children.
+		std::vector<float> 			Translation; 		// Rest pose, 3 per joint.
+		std::vector<float> 			Rotation; 			// 4 per joint, x y z w.
+		std::vector<float> 			Scale; 				// 3 per joint.
+		// 12 per joint, the static transform of non-joint nodes between a joint and its
+		// Parent (or the scene root), identity when there are none. Animation of those
+		// nodes is not applied.
+		std::vector<float> 			Offset;
+		std::vector<float> 			InverseBind; 		// 16 per joint, column-major.
+
+		std::size_t size() const;
+		static skeleton from_gltf(const io::gltf& aModel, std::size_t aSkin);
+	};
+
+	// Keyframed joint tracks of one glTF animation.
+	struct animation_clip {
+		enum path : uint8_t { TRANSLATION, ROTATION, SCALE };
+		enum interpolation : uint8_t { STEP, LINEAR, CUBICSPLINE };
+
+		struct channel {
+			uint32_t 			Joint;
+			path 				Path;
+			interpolation 		Interpolation;
+			std::vector<float> 	Time; 				// [s] Ascending.
+			std::vector<float> 	Value; 				// 3 or 4 per key, CUBICSPLINE keys hold in tangent, value and out tangent.
+		};
+
+		std::string 			Name;
+		float 					Duration = 0.0f; 	// [s]
+		std::vector<channel> 	Channel;
+
+		// Channels that target nodes outside aSkeleton, and morph weights, are dropped.
+		static animation_clip from_gltf(const io::gltf& aModel, std::size_t aAnimation, const skeleton& aSkeleton);
+		// Value of channel aChannel at aTime, clamped to its first and last key. aKey is the
+		// key found by the previous call and is updated, playback moving forward finds its
+		// key in one or two compares instead of a search.
+		void sample(std::size_t aChannel, float aTime, uint32_t& aKey, float* aOut) const;
+	};
+
+	// Skeleton and clips shared by every character using a model.
+	struct animated_model {
+		skeleton 						Skeleton;
+		std::vector<animation_clip> 	Clip;
+
+		// Skin aSkin and every animation of the file.
+		static animated_model from_gltf(const io::gltf& aModel, std::size_t aSkin = 0);
+	};
+
+	// One animated character. Weight holds one blend weight per clip of the model, as in
+	// an object's AnimationWeights, and every clip loops over its own duration. evaluate()
+	// samples the weighted clips, blends them and builds the skinning palette. The pose is
+	// kept as structure of arrays over joints so blending and matrix building run a SIMD
+	// lane per joint, and all scratch lives in the instance so evaluation does not allocate
+	// and instances can be evaluated concurrently.
+	class animation_instance {
+	public:
+
+		std::vector<float> 	Weight;
+		float 				Time; 				// [s]
+
+		animation_instance(const animated_model* aModel);
+
+		void evaluate();
+		// Skinning matrices, 16 floats per joint, column-major, global joint transform times
+		// inverse bind matrix.
+		const float* palette() const;
+		std::size_t joint_count() const;
+
+	private:
+
+		// Pose arrays: translation xyz, rotation xyzw, scale xyz.
+		static constexpr std::size_t PoseComponents = 10;
+
+		const animated_model* 		Model;
+		std::size_t 				Stride; 		// Joints rounded up to the vec_array padding.
+		std::vector<std::size_t> 	KeyOffset; 		// First entry of each clip in Key.
+		std::vector<uint32_t> 		Key; 			// Last keyframe of every channel.
+		std::vector<float> 			Rest;
+		std::vector<float> 			Pose;
+		std::vector<float> 			Blend;
+		std::vector<float> 			Local; 			// 12 arrays, affine local transforms.
+		std::vector<float> 			Global; 		// 12 per joint.
+		std::vector<float> 			Palette;
+
+		void accumulate(float aWeight, bool aFirst);
+		void build_matrices(float aWeightSum);
+
+	};
+
+	// Evaluates every instance, aGrain instances per job.
+	void evaluate(job_system& aJobs, std::vector<animation_instance>& aInstance, std::size_t aGrain = 8);
+
+	// ---------- Implementation ---------- //
+
+	namespace detail {
+
+		// Affine from translation, unit quaternion and scale.
+		inline void compose(const float* aT, const float* aR, const float* aS, float* aOut) {
+			float X = aR[0], Y = aR[1], Z = aR[2], W = aR[3];
+			float Rotation[9] = {
+				1.0f - 2.0f * (Y * Y + Z * Z), 2.0f * (X * Y + Z * W), 2.0f * (X * Z - Y * W),
+				2.0f * (X * Y - Z * W), 1.0f - 2.0f * (X * X + Z * Z), 2.0f * (Y * Z + X * W),
+				2.0f * (X * Z + Y * W), 2.0f * (Y * Z - X * W), 1.0f - 2.0f * (X * X + Y * Y)
+			};
+			for (int c = 0; c < 3; c++) {
+				for (int r = 0; r < 3; r++) aOut[3 * c + r] = Rotation[3 * c + r] * aS[c];
+			}
+			for (int r = 0; r < 3; r++) aOut[9 + r] = aT[r];
+		}
+
+		// Out = A * B, affine. Out may not alias A or B.
+		inline void affine_mul(const float* aA, const float* aB, float* aOut) {
+			for (int c = 0; c < 4; c++) {
+				for (int r = 0; r < 3; r++) {
+					float Sum = aA[r] * aB[3 * c] + aA[3 + r] * aB[3 * c + 1] + aA[6 + r] * aB[3 * c + 2];
+					aOut[3 * c + r] = (c == 3) ? Sum + aA[9 + r] : Sum;
+				}
+			}
+		}
+
+		inline void identity_affine(float* aOut) {
+			const float Identity[12] = { 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0 };
+			std::memcpy(aOut, Identity, sizeof(Identity));
+		}
+
+		// Local TRS of a glTF node, a matrix is decomposed assuming it has no shear.
+		inline void node_trs(const io::json& aNode, float* aT, float* aR, float* aS) {
+			if (aNode.has("matrix")) {
+				float M[16];
+				for (std::size_t i = 0; i < 16; i++) M[i] = (float)aNode["matrix"][i].as_double(i % 5 == 0 ? 1.0 : 0.0);
+				float Basis[9];
+				for (int c = 0; c < 3; c++) {
+					aT[c] = M[12 + c];
+					aS[c] = std::sqrt(M[4 * c] * M[4 * c] + M[4 * c + 1] * M[4 * c + 1] + M[4 * c + 2] * M[4 * c + 2]);
+					for (int r = 0; r < 3; r++) Basis[3 * c + r] = aS[c] > 0.0f ? M[4 * c + r] / aS[c] : 0.0f;
+				}
+				// Quaternion from the rotation basis, largest diagonal term first for stability.
+				auto b = [&](int r, int c) { return Basis[3 * c + r]; };
+				float Trace = b(0, 0) + b(1, 1) + b(2, 2);
+				if (Trace > 0.0f) {
+					float S = 2.0f * std::sqrt(Trace + 1.0f);
+					aR[3] = 0.25f * S; aR[0] = (b(2, 1) - b(1, 2)) / S; aR[1] = (b(0, 2) - b(2, 0)) / S; aR[2] = (b(1, 0) - b(0, 1)) / S;
+				}
+				else if ((b(0, 0) > b(1, 1)) && (b(0, 0) > b(2, 2))) {
+					float S = 2.0f * std::sqrt(1.0f + b(0, 0) - b(1, 1) - b(2, 2));
+					aR[3] = (b(2, 1) - b(1, 2)) / S; aR[0] = 0.25f * S; aR[1] = (b(0, 1) + b(1, 0)) / S; aR[2] = (b(0, 2) + b(2, 0)) / S;
+				}
+				else if (b(1, 1) > b(2, 2)) {
+					float S = 2.0f * std::sqrt(1.0f + b(1, 1) - b(0, 0) - b(2, 2));
+					aR[3] = (b(0, 2) - b(2, 0)) / S; aR[0] = (b(0, 1) + b(1, 0)) / S; aR[1] = 0.25f * S; aR[2] = (b(1, 2) + b(2, 1)) / S;
+				}
+				else {
+					float S = 2.0f * std::sqrt(1.0f + b(2, 2) - b(0, 0) - b(1, 1));
+					aR[3] = (b(1, 0) - b(0, 1)) / S; aR[0] = (b(0, 2) + b(2, 0)) / S; aR[1] = (b(1, 2) + b(2, 1)) / S; aR[2] = 0.25f * S;
+				}
+				return;
+			}
+			for (std::size_t i = 0; i < 3; i++) aT[i] = (float)aNode["translation"][i].as_double(0.0);
+			for (std::size_t i = 0; i < 4; i++) aR[i] = (float)aNode["rotation"][i].as_double(i == 3 ? 1.0 : 0.0);
+			for (std::size_t i = 0; i < 3; i++) aS[i] = (float)aNode["scale"][i].as_double(1.0);
+		}
+
+		// Key k with aTime[k] <= aValue < aTime[k + 1], for aTime[0] < aValue < aTime.back().
+		inline uint32_t find_key(const std::vector<float>& aTime, float aValue, uint32_t aHint) {
+			std::size_t Last = aTime.size() - 2;
+			std::size_t K = std::min<std::size_t>(aHint, Last);
+			if (aTime[K] <= aValue) {
+				if (aValue < aTime[K + 1]) return (uint32_t)K;
+				// Frame steps are usually shorter than the key spacing.
+				if ((K < Last) && (aValue < aTime[K + 2])) return (uint32_t)(K + 1);
+				return (uint32_t)(std::upper_bound(aTime.begin() + K + 1, aTime.end(), aValue) - aTime.begin() - 1);
+			}
+			// Looped or scrubbed backwards.
+			return (uint32_t)(std::upper_bound(aTime.begin(), aTime.begin() + K, aValue) - aTime.begin() - 1);
+		}
+
+		inline void normalize_quaternion(float* aQ) {
+			float Length = std::sqrt(aQ[0] * aQ[0] + aQ[1] * aQ[1] + aQ[2] * aQ[2] + aQ[3] * aQ[3]);
+			if (Length > 0.0f) for (int i = 0; i < 4; i++) aQ[i] /= Length;
+		}
+
+		inline void slerp(const float* aA, const float* aB, float aT, float* aOut) {
+			float Dot = aA[0] * aB[0] + aA[1] * aB[1] + aA[2] * aB[2] + aA[3] * aB[3];
+			float Sign = Dot < 0.0f ? -1.0f : 1.0f;
+			Dot *= Sign;
+			float WA = 1.0f - aT, WB = aT * Sign;
+			// Nearly parallel keys fall back to normalized lerp, sin(Angle) is too small to divide by.
+			if (Dot < 0.9995f) {
+				float Angle = std::acos(Dot);
+				float InverseSin = 1.0f / std::sin(Angle);
+				WA = std::sin((1.0f - aT) * Angle) * InverseSin;
+				WB = std::sin(aT * Angle) * InverseSin * Sign;
+			}
+			for (int i = 0; i < 4; i++) aOut[i] = WA * aA[i] + WB * aB[i];
+			normalize_quaternion(aOut);
+		}
+
+	}
+
+	// ---------- skeleton ---------- //
+
+	inline std::size_t skeleton::size() const {
+		return Node.size();
+	}
+
+	inline skeleton skeleton::from_gltf(const io::gltf& aModel, std::size_t aSkin) {
+		const io::json& SkinList = aModel.Document["skins"];
+		if (aSkin >= SkinList.size()) throw std::runtime_error("skeleton: skin " + std::to_string(aSkin) + " not found");
+		const io::json& Skin = SkinList[aSkin];
+		const io::json& NodeList = aModel.Document["nodes"];
+		std::size_t NodeCount = NodeList.size();
+
+		std::vector<int64_t> NodeParent(NodeCount, -1);
+		for (std::size_t n = 0; n < NodeCount; n++) {
+			const io::json& Children = NodeList[n]["children"];
+			for (std::size_t c = 0; c < Children.size(); c++) {
+				std::size_t Child = Children[c].as_index();
+				if (Child >= NodeCount) throw std::runtime_error("skeleton: node " + std::to_string(n) + " has a missing child");
+				NodeParent[Child] = (int64_t)n;
+			}
+		}
+
+		skeleton Skeleton;
+		const io::json& JointList = Skin["joints"];
+		std::size_t JointCount = JointList.size();
+		std::vector<int32_t> JointOf(NodeCount, -1);
+		for (std::size_t j = 0; j < JointCount; j++) {
+			std::size_t N = JointList[j].as_index();
+			if (N >= NodeCount) throw std::runtime_error("skeleton: joint " + std::to_string(j) + " references a missing node");
+			JointOf[N] = (int32_t)j;
+			Skeleton.Node.push_back(N);
+			Skeleton.Name.push_back(NodeList[N]["name"].as_string());
+		}
+
+		Skeleton.Translation.resize(3 * JointCount);
+		Skeleton.Rotation.resize(4 * JointCount);
+		Skeleton.Scale.resize(3 * JointCount);
+		Skeleton.Offset.resize(12 * JointCount);
+		Skeleton.Parent.resize(JointCount);
+		std::vector<std::size_t> Depth(JointCount, 0);
+		for (std::size_t j = 0; j < JointCount; j++) {
+			detail::node_trs(NodeList[Skeleton.Node[j]], &Skeleton.Translation[3 * j], &Skeleton.Rotation[4 * j], &Skeleton.Scale[3 * j]);
+			detail::normalize_quaternion(&Skeleton.Rotation[4 * j]);
+			// Fold static non-joint ancestors into the offset, up to the next joint.
+			float* Offset = &Skeleton.Offset[12 * j];
+			detail::identity_affine(Offset);
+			int64_t P = NodeParent[Skeleton.Node[j]];
+			std::size_t Steps = 0;
+			while ((P >= 0) && (JointOf[P] < 0)) {
+				float T[3], R[4], S[3], Node[12], Product[12];
+				detail::node_trs(NodeList[(std::size_t)P], T, R, S);
+				detail::normalize_quaternion(R);
+				detail::compose(T, R, S, Node);
+				detail::affine_mul(Node, Offset, Product);
+				std::memcpy(Offset, Product, sizeof(Product));
+				P = NodeParent[(std::size_t)P];
+				if (++Steps > NodeCount) throw std::runtime_error("skeleton: node hierarchy has a cycle");
+			}
+			Skeleton.Parent[j] = P >= 0 ? JointOf[P] : -1;
+		}
+		for (std::size_t j = 0; j < JointCount; j++) {
+			for (int32_t P = Skeleton.Parent[j]; P >= 0; P = Skeleton.Parent[P]) {
+				if (++Depth[j] > JointCount) throw std::runtime_error("skeleton: joint hierarchy has a cycle");
+			}
+		}
+		for (std::size_t j = 0; j < JointCount; j++) Skeleton.Order.push_back((uint32_t)j);
+		std::stable_sort(Skeleton.Order.begin(), Skeleton.Order.end(), [&](uint32_t aA, uint32_t aB) { return Depth[aA] < Depth[aB]; });
+
+		Skeleton.InverseBind.assign(16 * JointCount, 0.0f);
+		for (std::size_t j = 0; j < JointCount; j++) {
+			for (int i = 0; i < 4; i++) Skeleton.InverseBind[16 * j + 5 * i] = 1.0f;
+		}
+		if (Skin.has("inverseBindMatrices")) {
+			std::size_t Accessor = Skin["inverseBindMatrices"].as_index();
+			if ((Accessor >= aModel.Accessor.size()) || (aModel.Accessor[Accessor].Count < JointCount)) throw std::runtime_error("skeleton: inverse bind matrices do not cover every joint");
+			std::vector<float> Matrix(16 * aModel.Accessor[Accessor].Count);
+			aModel.read_float(Accessor, Matrix.data(), 16, 16);
+			std::copy(Matrix.begin(), Matrix.begin() + 16 * JointCount, Skeleton.InverseBind.begin());
+		}
+		return Skeleton;
+	}
+
+	// ---------- animation_clip ---------- //
+
+	inline animation_clip animation_clip::from_gltf(const io::gltf& aModel, std::size_t aAnimation, const skeleton& aSkeleton) {
+		const io::json& AnimationList = aModel.Document["animations"];
+		if (aAnimation >= AnimationList.size()) throw std::runtime_error("animation_clip: animation " + std::to_string(aAnimation) + " not found");
+		const io::json& Animation = AnimationList[aAnimation];
+		animation_clip Clip;
+		Clip.Name = Animation["name"].as_string();
+		const io::json& ChannelList = Animation["channels"];
+		const io::json& SamplerList = Animation["samplers"];
+		for (std::size_t c = 0; c < ChannelList.size(); c++) {
+			const io::json& C = ChannelList[c];
+			std::size_t Node = C["target"]["node"].as_index();
+			std::string Path = C["target"]["path"].as_string();
+			auto Joint = std::find(aSkeleton.Node.begin(), aSkeleton.Node.end(), Node);
+			if ((Joint == aSkeleton.Node.end()) || (Path == "weights")) continue;
+
+			channel Channel;
+			Channel.Joint = (uint32_t)(Joint - aSkeleton.Node.begin());
+			if (Path == "translation") Channel.Path = TRANSLATION;
+			else if (Path == "rotation") Channel.Path = ROTATION;
+			else if (Path == "scale") Channel.Path = SCALE;
+			else throw std::runtime_error("animation_clip: channel " + std::to_string(c) + " has unknown path " + Path);
+
+			std::size_t SamplerIndex = C["sampler"].as_index();
+			if (SamplerIndex >= SamplerList.size()) throw std::runtime_error("animation_clip: channel " + std::to_string(c) + " references a missing sampler");
+			const io::json& Sampler = SamplerList[SamplerIndex];
+			std::string Interpolation = Sampler["interpolation"].as_string("LINEAR");
+			if (Interpolation == "STEP") Channel.Interpolation = STEP;
+			else if (Interpolation == "CUBICSPLINE") Channel.Interpolation = CUBICSPLINE;
+			else Channel.Interpolation = LINEAR;
+
+			std::size_t Input = Sampler["input"].as_index(), Output = Sampler["output"].as_index();
+			if ((Input >= aModel.Accessor.size()) || (Output >= aModel.Accessor.size())) throw std::runtime_error("animation_clip: sampler " + std::to_string(SamplerIndex) + " references a missing accessor");
+			std::size_t KeyCount = aModel.Accessor[Input].Count;
+			std::size_t Components = Channel.Path == ROTATION ? 4 : 3;
+			std::size_t PerKey = Channel.Interpolation == CUBICSPLINE ? 3 : 1;
+			if ((KeyCount == 0) || (aModel.Accessor[Output].Count != KeyCount * PerKey)) throw std::runtime_error("animation_clip: sampler " + std::to_string(SamplerIndex) + " output does not match its input");
+			Channel.Time.resize(KeyCount);
+			aModel.read_float(Input, Channel.Time.data(), 1, 1);
+			Channel.Value.resize(KeyCount * PerKey * Components);
+			aModel.read_float(Output, Channel.Value.data(), Components, Components);
+			if (!std::is_sorted(Channel.Time.begin(), Channel.Time.end())) throw std::runtime_error("animation_clip: sampler " + std::to_string(SamplerIndex) + " times are not ascending");
+			Clip.Duration = std::max(Clip.Duration, Channel.Time.back());
+			Clip.Channel.push_back(std::move(Channel));
+		}
+		return Clip;
+	}
+
+	inline void animation_clip::sample(std::size_t aChannel, float aTime, uint32_t& aKey, float* aOut) const {
+		const channel& C = Channel[aChannel];
+		std::size_t N = C.Path == ROTATION ? 4 : 3;
+		bool Cubic = C.Interpolation == CUBICSPLINE;
+		std::size_t Width = Cubic ? 3 * N : N;
+		const float* First = &C.Value[Cubic ? N : 0];
+		std::size_t Count = C.Time.size();
+		if ((Count == 1) || (aTime <= C.Time[0])) {
+			std::memcpy(aOut, First, N * sizeof(float));
+			return;
+		}
+		if (aTime >= C.Time[Count - 1]) {
+			std::memcpy(aOut, First + (Count - 1) * Width, N * sizeof(float));
+			return;
+		}
+		uint32_t K = detail::find_key(C.Time, aTime, aKey);
+		aKey = K;
+		const float* V0 = First + K * Width;
+		const float* V1 = V0 + Width;
+		float Span = C.Time[K + 1] - C.Time[K];
+		float U = (aTime - C.Time[K]) / Span;
+		switch (C.Interpolation) {
+		case STEP:
+			std::memcpy(aOut, V0, N * sizeof(float));
+			break;
+		case LINEAR:
+			if (C.Path == ROTATION) detail::slerp(V0, V1, U, aOut);
+			else for (std::size_t i = 0; i < N; i++) aOut[i] = V0[i] + (V1[i] - V0[i]) * U;
+			break;
+		case CUBICSPLINE: {
+			// Hermite spline, the out tangent follows the value and the in tangent precedes it.
+			const float* Out0 = V0 + N;
+			const float* In1 = V1 - N;
+			float U2 = U * U, U3 = U2 * U;
+			float H00 = 2.0f * U3 - 3.0f * U2 + 1.0f, H10 = (U3 - 2.0f * U2 + U) * Span;
+			float H01 = -2.0f * U3 + 3.0f * U2, H11 = (U3 - U2) * Span;
+			for (std::size_t i = 0; i < N; i++) aOut[i] = H00 * V0[i] + H10 * Out0[i] + H01 * V1[i] + H11 * In1[i];
+			if (C.Path == ROTATION) detail::normalize_quaternion(aOut);
+			break;
+		}
+		}
+	}
+
+	// ---------- animated_model ---------- //
+
+	inline animated_model animated_model::from_gltf(const io::gltf& aModel, std::size_t aSkin) {
+		animated_model Model;
+		Model.Skeleton = skeleton::from_gltf(aModel, aSkin);
+		for (std::size_t a = 0; a < aModel.Document["animations"].size(); a++) Model.Clip.push_back(animation_clip::from_gltf(aModel, a, Model.Skeleton));
+		return Model;
+	}
+
+	// ---------- animation_instance ---------- //
+
+	inline animation_instance::animation_instance(const animated_model* aModel) {
+		Model = aModel;
+		Time = 0.0f;
+		std::size_t JointCount = Model->Skeleton.size();
+		const std::size_t Padding = math::vec_array<float, 3>::Padding;
+		Stride = std::max<std::size_t>(Padding, (JointCount + Padding - 1) / Padding * Padding);
+		Weight.assign(Model->Clip.size(), 0.0f);
+		if (!Weight.empty()) Weight[0] = 1.0f;
+		std::size_t KeyCount = 0;
+		for (const animation_clip& Clip : Model->Clip) {
+			KeyOffset.push_back(KeyCount);
+			KeyCount += Clip.Channel.size();
+		}
+		Key.assign(KeyCount, 0);
+
+		// Padding joints rest at identity so the quaternion normalization never divides by zero.
+		Rest.assign(PoseComponents * Stride, 0.0f);
+		for (std::size_t j = 0; j < Stride; j++) {
+			Rest[6 * Stride + j] = 1.0f;
+			for (int c = 7; c < 10; c++) Rest[c * Stride + j] = 1.0f;
+		}
+		const skeleton& S = Model->Skeleton;
+		for (std::size_t j = 0; j < JointCount; j++) {
+			for (int c = 0; c < 3; c++) Rest[c * Stride + j] = S.Translation[3 * j + c];
+			for (int c = 0; c < 4; c++) Rest[(3 + c) * Stride + j] = S.Rotation[4 * j + c];
+			for (int c = 0; c < 3; c++) Rest[(7 + c) * Stride + j] = S.Scale[3 * j + c];
+		}
+		Pose = Rest;
+		Blend = Rest;
+		Local.assign(12 * Stride, 0.0f);
+		Global.assign(12 * JointCount, 0.0f);
+		Palette.assign(16 * JointCount, 0.0f);
+	}
+
+	inline void animation_instance::evaluate() {
+		float WeightSum = 0.0f;
+		for (std::size_t c = 0; c < Model->Clip.size(); c++) {
+			const animation_clip& Clip = Model->Clip[c];
+			float W = c < Weight.size() ? Weight[c] : 0.0f;
+			if (W <= 0.0f) continue;
+			float T = 0.0f;
+			if (Clip.Duration > 0.0f) {
+				T = std::fmod(Time, Clip.Duration);
+				if (T < 0.0f) T += Clip.Duration;
+			}
+			std::memcpy(Pose.data(), Rest.data(), Rest.size() * sizeof(float));
+			uint32_t* ClipKey = &Key[KeyOffset[c]];
+			for (std::size_t i = 0; i < Clip.Channel.size(); i++) {
+				const animation_clip::channel& Channel = Clip.Channel[i];
+				float Value[4];
+				Clip.sample(i, T, ClipKey[i], Value);
+				std::size_t Base = Channel.Path == animation_clip::TRANSLATION ? 0 : (Channel.Path == animation_clip::ROTATION ? 3 : 7);
+				std::size_t Components = Channel.Path == animation_clip::ROTATION ? 4 : 3;
+				for (std::size_t k = 0; k < Components; k++) Pose[(Base + k) * Stride + Channel.Joint] = Value[k];
+			}
+			this->accumulate(W, WeightSum == 0.0f);
+			WeightSum += W;
+		}
+		if (WeightSum == 0.0f) std::memcpy(Blend.data(), Rest.data(), Rest.size() * sizeof(float));
+		this->build_matrices(WeightSum);
+	}
+
+	inline const float* animation_instance::palette() const {
+		return Palette.data();
+	}
+
+	inline std::size_t animation_instance::joint_count() const {
+		return Model->Skeleton.size();
+	}
+
+	inline void animation_instance::accumulate(float aWeight, bool aFirst) {
+		using math::detail::lane;
+		lane W = lane::set(aWeight);
+		lane NegativeW = lane::set(-aWeight);
+		const float* P = Pose.data();
+		float* B = Blend.data();
+		for (std::size_t j = 0; j < Stride; j += lane::Width) {
+			if (aFirst) {
+				for (std::size_t c = 0; c < PoseComponents; c++) (W * lane::load(P + c * Stride + j)).store(B + c * Stride + j);
+				continue;
+			}
+			for (std::size_t c : { 0, 1, 2, 7, 8, 9 }) (lane::load(B + c * Stride + j) + W * lane::load(P + c * Stride + j)).store(B + c * Stride + j);
+			// q and -q are the same rotation, add each sample on the side of the running sum.
+			lane Q[4], Dot = lane::set(0.0f);
+			for (std::size_t c = 0; c < 4; c++) {
+				Q[c] = lane::load(P + (3 + c) * Stride + j);
+				Dot = Dot + Q[c] * lane::load(B + (3 + c) * Stride + j);
+			}
+			lane Signed = select_positive(Dot, NegativeW, W);
+			for (std::size_t c = 0; c < 4; c++) (lane::load(B + (3 + c) * Stride + j) + Signed * Q[c]).store(B + (3 + c) * Stride + j);
+		}
+	}
+
+	inline void animation_instance::build_matrices(float aWeightSum) {
+		using math::detail::lane;
+		lane InverseSum = lane::set(aWeightSum > 0.0f ? 1.0f / aWeightSum : 1.0f);
+		lane One = lane::set(1.0f), Two = lane::set(2.0f);
+		const float* B = Blend.data();
+		float* L = Local.data();
+		// Local affine per joint lane: normalized blend of T, R, S composed into columns.
+		for (std::size_t j = 0; j < Stride; j += lane::Width) {
+			lane T[3], R[4], S[3];
+			for (std::size_t c = 0; c < 3; c++) T[c] = lane::load(B + c * Stride + j) * InverseSum;
+			for (std::size_t c = 0; c < 4; c++) R[c] = lane::load(B + (3 + c) * Stride + j);
+			for (std::size_t c = 0; c < 3; c++) S[c] = lane::load(B + (7 + c) * Stride + j) * InverseSum;
+			lane Length = sqrt(R[0] * R[0] + R[1] * R[1] + R[2] * R[2] + R[3] * R[3]);
+			for (std::size_t c = 0; c < 4; c++) R[c] = R[c] / Length;
+			lane X = R[0], Y = R[1], Z = R[2], W = R[3];
+			lane Column[12] = {
+				(One - Two * (Y * Y + Z * Z)) * S[0], Two * (X * Y + Z * W) * S[0], Two * (X * Z - Y * W) * S[0],
+				Two * (X * Y - Z * W) * S[1], (One - Two * (X * X + Z * Z)) * S[1], Two * (Y * Z + X * W) * S[1],
+				Two * (X * Z + Y * W) * S[2], Two * (Y * Z - X * W) * S[2], (One - Two * (X * X + Y * Y)) * S[2],
+				T[0], T[1], T[2]
+			};
+			for (std::size_t e = 0; e < 12; e++) Column[e].store(L + e * Stride + j);
+		}
+
+		// Hierarchy, parents first, then the palette.
+		const skeleton& Skeleton = Model->Skeleton;
+		for (uint32_t J : Skeleton.Order) {
+			float Joint[12], Offsetted[12];
+			for (std::size_t e = 0; e < 12; e++) Joint[e] = L[e * Stride + J];
+			detail::affine_mul(&Skeleton.Offset[12 * J], Joint, Offsetted);
+			float* G = &Global[12 * J];
+			if (Skeleton.Parent[J] >= 0) detail::affine_mul(&Global[12 * (std::size_t)Skeleton.Parent[J]], Offsetted, G);
+			else std::memcpy(G, Offsetted, sizeof(Offsetted));
+
+			const float* IB = &Skeleton.InverseBind[16 * J];
+			float* P = &Palette[16 * J];
+			for (int c = 0; c < 4; c++) {
+				for (int r = 0; r < 3; r++) P[4 * c + r] = G[r] * IB[4 * c] + G[3 + r] * IB[4 * c + 1] + G[6 + r] * IB[4 * c + 2] + G[9 + r] * IB[4 * c + 3];
+				P[4 * c + 3] = IB[4 * c + 3];
+			}
+		}
+	}
+
+	// ---------- evaluate ---------- //
+
+	inline void evaluate(job_system& aJobs, std::vector<animation_instance>& aInstance, std::size_t aGrain) {
+		task_graph Graph;
+		Graph.add_range("animation", aInstance.size(), aGrain, [&](std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t i = aBegin; i < aEnd; i++) aInstance[i].evaluate();
+		});
+		aJobs.run(Graph);
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_ANIMATION_H
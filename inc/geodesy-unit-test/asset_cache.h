@@ -0,0 +1,219 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_ASSET_CACHE_H
+#define GEODESY_UNIT_TEST_ASSET_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <filesystem>
+
+#include <geodesy-unit-test/world_snapshot.h>
+
+namespace geodesy::io {
+
+	// Path keyed cache of loaded assets. The cache holds weak references, an asset lives
+	// as long as some object holds the returned shared_ptr and is loaded again on the next
+	// acquire after the last holder releases it. Concurrent acquires of the same path wait
+	// on the one load in flight instead of loading twice.
+	template <typename T>
+	class asset_cache {
+	public:
+
+		using loader = std::function<std::shared_ptr<T>(const std::string&)>;
+
+		asset_cache(loader aLoader);
+
+		// Returns the cached asset for aPath, loading it on a miss. Loader exceptions are
+		// rethrown to every waiting caller and the path is retried on the next acquire.
+		std::shared_ptr<T> acquire(const std::string& aPath);
+		// Returns the cached asset without loading, null when absent or released.
+		std::shared_ptr<T> find(const std::string& aPath) const;
+
+		// Assets currently alive in the cache.
+		std::size_t size() const;
+		std::size_t load_count() const;
+		std::size_t hit_count() const;
+		// Drops entries whose asset has been released.
+		void purge();
+
+		// Cache key for a path, lexically normalized so "a/./b.gltf" and "a/b.gltf" share.
+		static std::string key(const std::string& aPath);
+
+	private:
+
+		struct entry {
+			std::weak_ptr<T> 							Asset;
+			std::shared_future<std::shared_ptr<T>> 		Pending;
+		};
+
+		loader 										Loader;
+		mutable std::mutex 							Mutex;
+		std::unordered_map<std::string, entry> 		Entry;
+		std::size_t 								LoadCount;
+		std::size_t 								HitCount;
+
+	};
+
+	// Per instance transform as given by the world file, tightly packed for an instance buffer.
+	struct instance {
+		float Position[3];
+		float Direction[2];
+		float Scale[3];
+	};
+
+	// Objects of a world that share one model and can be drawn with one instanced call.
+	template <typename T>
+	struct instance_batch {
+		std::string 				ModelPath;
+		std::vector<float> 			AnimationWeights;
+		std::shared_ptr<T> 			Model;
+		std::vector<instance> 		Instance;
+		std::vector<std::size_t> 	Object; 			// Index into world_description::Object per instance.
+	};
+
+	// Groups the plain objects of aWorld by model, acquiring each unique model once from
+	// aCache. Objects only share a batch when their animation weights are equal, since
+	// animated instances are posed per batch. Subjects (cameras) and objects without a
+	// model are not batched. Batches are in order of first appearance.
+	template <typename T>
+	std::vector<instance_batch<T>> build_instance_batches(const world_description& aWorld, asset_cache<T>& aCache);
+
+	// ---------- asset_cache ---------- //
+
+	template <typename T>
+	inline asset_cache<T>::asset_cache(loader aLoader) {
+		Loader = std::move(aLoader);
+		LoadCount = 0;
+		HitCount = 0;
+	}
+
+	template <typename T>
+	inline std::shared_ptr<T> asset_cache<T>::acquire(const std::string& aPath) {
+		std::string Key = key(aPath);
+		std::promise<std::shared_ptr<T>> Promise;
+		std::shared_future<std::shared_ptr<T>> Pending;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			entry& E = Entry[Key];
+			if (std::shared_ptr<T> Asset = E.Asset.lock()) {
+				HitCount++;
+				return Asset;
+			}
+			if (E.Pending.valid()) {
+				HitCount++;
+				Pending = E.Pending;
+			}
+			else {
+				E.Pending = Promise.get_future().share();
+				LoadCount++;
+			}
+		}
+		// Another thread is loading this path, wait for it outside the lock.
+		if (Pending.valid()) return Pending.get();
+
+		std::shared_ptr<T> Asset;
+		try {
+			Asset = Loader(Key);
+		}
+		catch (...) {
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Entry.erase(Key);
+			}
+			Promise.set_exception(std::current_exception());
+			throw;
+		}
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			entry& E = Entry[Key];
+			E.Asset = Asset;
+			E.Pending = std::shared_future<std::shared_ptr<T>>();
+		}
+		Promise.set_value(Asset);
+		return Asset;
+	}
+
+	template <typename T>
+	inline std::shared_ptr<T> asset_cache<T>::find(const std::string& aPath) const {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		auto Iterator = Entry.find(key(aPath));
+		return Iterator != Entry.end() ? Iterator->second.Asset.lock() : nullptr;
+	}
+
+	template <typename T>
+	inline std::size_t asset_cache<T>::size() const {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		std::size_t Count = 0;
+		for (const auto& E : Entry) Count += E.second.Asset.expired() ? 0 : 1;
+		return Count;
+	}
+
+	template <typename T>
+	inline std::size_t asset_cache<T>::load_count() const {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return LoadCount;
+	}
+
+	template <typename T>
+	inline std::size_t asset_cache<T>::hit_count() const {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return HitCount;
+	}
+
+	template <typename T>
+	inline void asset_cache<T>::purge() {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (auto Iterator = Entry.begin(); Iterator != Entry.end();) {
+			if (Iterator->second.Asset.expired() && !Iterator->second.Pending.valid()) Iterator = Entry.erase(Iterator);
+			else ++Iterator;
+		}
+	}
+
+	template <typename T>
+	inline std::string asset_cache<T>::key(const std::string& aPath) {
+		return std::filesystem::path(aPath).lexically_normal().generic_string();
+	}
+
+	// ---------- instancing ---------- //
+
+	template <typename T>
+	inline std::vector<instance_batch<T>> build_instance_batches(const world_description& aWorld, asset_cache<T>& aCache) {
+		std::vector<instance_batch<T>> Batch;
+		std::unordered_map<std::string, std::vector<std::size_t>> BatchOfModel;
+		for (std::size_t i = 0; i < aWorld.Object.size(); i++) {
+			const object_description& Object = aWorld.Object[i];
+			if (Object.IsSubject || Object.ModelPath.empty()) continue;
+			std::string Key = asset_cache<T>::key(Object.ModelPath);
+			std::vector<std::size_t>& Candidate = BatchOfModel[Key];
+			std::size_t Index = Batch.size();
+			for (std::size_t b : Candidate) {
+				if (Batch[b].AnimationWeights == Object.AnimationWeights) { Index = b; break; }
+			}
+			if (Index == Batch.size()) {
+				instance_batch<T> New;
+				New.ModelPath 			= Key;
+				New.AnimationWeights 	= Object.AnimationWeights;
+				New.Model 				= aCache.acquire(Key);
+				Batch.push_back(std::move(New));
+				Candidate.push_back(Index);
+			}
+			instance Instance;
+			for (std::size_t d = 0; d < 3; d++) Instance.Position[d] = Object.Position[d];
+			for (std::size_t d = 0; d < 2; d++) Instance.Direction[d] = Object.Direction[d];
+			for (std::size_t d = 0; d < 3; d++) Instance.Scale[d] = Object.Scale[d];
+			Batch[Index].Instance.push_back(Instance);
+			Batch[Index].Object.push_back(i);
+		}
+		return Batch;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_ASSET_CACHE_H
@@ -0,0 +1,259 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_BENCHMARK_H
+#define GEODESY_UNIT_TEST_BENCHMARK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <geodesy-unit-test/allocation.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace geodesy {
+
+	// Micro-benchmark harness used by the geodesy-unit-test-bench target. Each case
+	// runs a batch of operations per call, is repeated until a minimum wall time is
+	// reached, and is reported as ns/op, throughput and heap allocations and bytes per op.
+	class benchmark {
+	public:
+
+		struct result {
+			std::string 	Suite;
+			std::string 	Name;
+			std::size_t 	Size;
+			std::size_t 	Batch;
+			uint64_t 		Iterations;
+			double 			NanosecondsPerOperation;
+			double 			OperationsPerSecond;
+			double 			AllocationsPerOperation;
+			double 			BytesPerOperation; 		// Heap bytes allocated per op.
+			// Filled in when a baseline is available.
+			double 			BaselineNanosecondsPerOperation;
+			bool 			Regressed;
+			// Unique key used to match results against a baseline.
+			std::string id() const;
+		};
+
+		struct options {
+			double 			MinimumTime 	= 0.05; 	// [s] Minimum measured time per repetition.
+			uint32_t 		Repetitions 	= 5; 		// Median of this many repetitions is reported.
+			double 			Tolerance 		= 0.10; 	// Fractional slowdown vs baseline flagged as regression.
+			std::string 	Filter;						// Substring filter on result id, empty runs all.
+		};
+
+		// A suite registers its cases with a benchmark instance on construction of a
+		// static suite object, so new benchmark files only need to be added to bench/.
+		struct suite {
+			std::string Name;
+			std::function<void(benchmark&)> Register;
+			suite(std::string aName, std::function<void(benchmark&)> aRegister);
+		};
+
+		static std::vector<suite*>& suite_list();
+
+		// Keeps a value alive so the optimizer cannot discard the computation producing it.
+		template <typename T> static void keep(const T& aValue);
+
+		options Options;
+
+		// Adds a case. aFunction performs exactly aBatch operations per call.
+		void add(std::string aName, std::size_t aSize, std::size_t aBatch, std::function<void(std::size_t)> aFunction);
+
+		// Runs all registered cases matching Options.Filter.
+		std::vector<result> run(const std::string& aSuite, std::ostream* aLog = nullptr);
+
+		// Loads id -> ns/op pairs from a file previously written by to_json(). Throws
+		// std::runtime_error when the file cannot be opened or a value is not a number.
+		static std::map<std::string, double> load_baseline(const std::string& aPath);
+		// Marks each result regressed when it is slower than its baseline by more than aTolerance.
+		static std::size_t compare(std::vector<result>& aResults, const std::map<std::string, double>& aBaseline, double aTolerance);
+		static std::string to_json(const std::vector<result>& aResults);
+
+	private:
+
+		struct entry {
+			std::string Name;
+			std::size_t Size;
+			std::size_t Batch;
+			std::function<void(std::size_t)> Function;
+		};
+
+		std::vector<entry> Entry;
+
+	};
+
+	inline std::string benchmark::result::id() const {
+		return Suite + "/" + Name + "/" + std::to_string(Size) + "/" + std::to_string(Batch);
+	}
+
+	inline benchmark::suite::suite(std::string aName, std::function<void(benchmark&)> aRegister) {
+		this->Name = aName;
+		this->Register = aRegister;
+		suite_list().push_back(this);
+	}
+
+	inline std::vector<benchmark::suite*>& benchmark::suite_list() {
+		static std::vector<suite*> SuiteList;
+		return SuiteList;
+	}
+
+	template <typename T>
+	inline void benchmark::keep(const T& aValue) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(aValue) : "memory");
+#else
+		const volatile char* Pointer = reinterpret_cast<const volatile char*>(&aValue);
+		(void)*Pointer;
+		_ReadWriteBarrier();
+#endif
+	}
+
+	inline void benchmark::add(std::string aName, std::size_t aSize, std::size_t aBatch, std::function<void(std::size_t)> aFunction) {
+		Entry.push_back({ aName, aSize, aBatch, aFunction });
+	}
+
+	inline std::vector<benchmark::result> benchmark::run(const std::string& aSuite, std::ostream* aLog) {
+		using clock = std::chrono::steady_clock;
+		std::vector<result> ResultList;
+		for (entry& E : Entry) {
+			result R{};
+			R.Suite 	= aSuite;
+			R.Name 		= E.Name;
+			R.Size 		= E.Size;
+			R.Batch 	= E.Batch;
+			if ((Options.Filter.size() > 0) && (R.id().find(Options.Filter) == std::string::npos)) continue;
+
+			// Warm up caches and find how many calls fill the minimum time.
+			E.Function(E.Batch);
+			uint64_t Calls = 1;
+			while (true) {
+				clock::time_point Start = clock::now();
+				for (uint64_t i = 0; i < Calls; i++) E.Function(E.Batch);
+				double Elapsed = std::chrono::duration<double>(clock::now() - Start).count();
+				if ((Elapsed >= Options.MinimumTime) || (Calls >= (1ull << 40))) break;
+				Calls *= 2;
+			}
+
+			// Measured repetitions, median is reported.
+			std::vector<double> Sample;
+			uint64_t Allocations = 0;
+			uint64_t Bytes = 0;
+			for (uint32_t r = 0; r < std::max(Options.Repetitions, 1u); r++) {
+				uint64_t AllocationStart = allocation::Total.load(std::memory_order_relaxed);
+				uint64_t BytesStart = allocation::Bytes.load(std::memory_order_relaxed);
+				clock::time_point Start = clock::now();
+				for (uint64_t i = 0; i < Calls; i++) E.Function(E.Batch);
+				double Elapsed = std::chrono::duration<double>(clock::now() - Start).count();
+				Allocations += allocation::Total.load(std::memory_order_relaxed) - AllocationStart;
+				Bytes += allocation::Bytes.load(std::memory_order_relaxed) - BytesStart;
+				Sample.push_back(Elapsed * 1e9 / (double)(Calls * E.Batch));
+			}
+			std::sort(Sample.begin(), Sample.end());
+
+			R.Iterations 				= Calls * E.Batch * Sample.size();
+			R.NanosecondsPerOperation 	= Sample[Sample.size() / 2];
+			R.OperationsPerSecond 		= R.NanosecondsPerOperation > 0.0 ? 1e9 / R.NanosecondsPerOperation : 0.0;
+			R.AllocationsPerOperation 	= (double)Allocations / (double)R.Iterations;
+			R.BytesPerOperation 		= (double)Bytes / (double)R.Iterations;
+			ResultList.push_back(R);
+
+			if (aLog != nullptr) {
+				*aLog << std::setw(56) << std::left << R.id()
+					  << std::setw(14) << std::right << std::fixed << std::setprecision(3) << R.NanosecondsPerOperation << " ns/op"
+					  << std::setw(12) << std::setprecision(3) << R.AllocationsPerOperation << " allocs/op"
+					  << std::setw(12) << std::setprecision(1) << R.BytesPerOperation / 1024.0 << " KiB/op" << std::endl;
+			}
+		}
+		return ResultList;
+	}
+
+	inline std::map<std::string, double> benchmark::load_baseline(const std::string& aPath) {
+		// Results are written one object per line by to_json(), so a line scan is enough.
+		std::map<std::string, double> Baseline;
+		std::ifstream File(aPath);
+		if (!File) throw std::runtime_error("cannot open baseline " + aPath);
+		std::string Line;
+		auto field = [](const std::string& aLine, const std::string& aKey) -> std::string {
+			std::string Key = "\"" + aKey + "\": ";
+			std::size_t Start = aLine.find(Key);
+			if (Start == std::string::npos) return "";
+			Start += Key.size();
+			if (aLine[Start] == '"') {
+				std::size_t End = aLine.find('"', Start + 1);
+				return aLine.substr(Start + 1, End - Start - 1);
+			}
+			std::size_t End = aLine.find_first_of(",}", Start);
+			return aLine.substr(Start, End - Start);
+		};
+		while (std::getline(File, Line)) {
+			std::string Id = field(Line, "id");
+			std::string Value = field(Line, "ns_per_op");
+			if ((Id.size() == 0) || (Value.size() == 0)) continue;
+			try {
+				Baseline[Id] = std::stod(Value);
+			}
+			catch (const std::exception&) {
+				throw std::runtime_error("bad ns_per_op for " + Id + " in baseline " + aPath);
+			}
+		}
+		return Baseline;
+	}
+
+	inline std::size_t benchmark::compare(std::vector<result>& aResults, const std::map<std::string, double>& aBaseline, double aTolerance) {
+		std::size_t RegressionCount = 0;
+		for (result& R : aResults) {
+			auto It = aBaseline.find(R.id());
+			if (It == aBaseline.end()) continue;
+			R.BaselineNanosecondsPerOperation = It->second;
+			R.Regressed = R.NanosecondsPerOperation > It->second * (1.0 + aTolerance);
+			if (R.Regressed) RegressionCount++;
+		}
+		return RegressionCount;
+	}
+
+	inline std::string benchmark::to_json(const std::vector<result>& aResults) {
+		std::stringstream Stream;
+		Stream << std::setprecision(6);
+		Stream << "{\n  \"results\": [\n";
+		for (std::size_t i = 0; i < aResults.size(); i++) {
+			const result& R = aResults[i];
+			Stream << "    { "
+				   << "\"id\": \"" << R.id() << "\", "
+				   << "\"suite\": \"" << R.Suite << "\", "
+				   << "\"name\": \"" << R.Name << "\", "
+				   << "\"size\": " << R.Size << ", "
+				   << "\"batch\": " << R.Batch << ", "
+				   << "\"iterations\": " << R.Iterations << ", "
+				   << "\"ns_per_op\": " << R.NanosecondsPerOperation << ", "
+				   << "\"ops_per_sec\": " << R.OperationsPerSecond << ", "
+				   << "\"allocs_per_op\": " << R.AllocationsPerOperation << ", "
+				   << "\"bytes_per_op\": " << R.BytesPerOperation;
+			if (R.BaselineNanosecondsPerOperation > 0.0) {
+				Stream << ", \"baseline_ns_per_op\": " << R.BaselineNanosecondsPerOperation
+					   << ", \"regressed\": " << (R.Regressed ? "true" : "false");
+			}
+			Stream << " }" << (i + 1 < aResults.size() ? "," : "") << "\n";
+		}
+		Stream << "  ]\n}\n";
+		return Stream.str();
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_BENCHMARK_H
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_CACHE_FILE_H
+#define GEODESY_UNIT_TEST_CACHE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include <geodesy-unit-test/mapped_file.h>
+
+namespace geodesy::io {
+
+	// Shared by the binary caches (world_snapshot, texture_cache, mesh_cache). Their headers
+	// are trivially copyable structs that start with
+	//
+	//	char Magic[8] | uint32_t Version | uint32_t ByteOrder
+	//
+	// Files are native endian, ByteOrder holds CacheByteOrder as the writing host stored it
+	// so a file from a host of the other byte order is rejected.
+	constexpr uint32_t CacheByteOrder = 0x01020304u;
+
+	// Zeroed header with its magic, version and byte order set.
+	template <typename H>
+	H make_cache_header(const char (&aMagic)[8], uint32_t aVersion);
+	// Copies the header at the start of aFile into aHeader. False when the file is shorter
+	// than a header or its magic, version or byte order differ.
+	template <typename H>
+	bool read_cache_header(const mapped_file& aFile, const char (&aMagic)[8], uint32_t aVersion, H& aHeader);
+	// Runs aWrite on a per process and thread temporary next to aPath and renames it over aPath, so
+	// concurrent writers of the same file and readers never see a half written one. False,
+	// with the temporary removed, when any step fails.
+	bool write_cache_file(const std::string& aPath, const std::function<void(std::ostream&)>& aWrite);
+
+	template <typename H>
+	inline H make_cache_header(const char (&aMagic)[8], uint32_t aVersion) {
+		H Header{};
+		std::memcpy(Header.Magic, aMagic, sizeof(aMagic));
+		Header.Version 		= aVersion;
+		Header.ByteOrder 	= CacheByteOrder;
+		return Header;
+	}
+
+	template <typename H>
+	inline bool read_cache_header(const mapped_file& aFile, const char (&aMagic)[8], uint32_t aVersion, H& aHeader) {
+		if (!aFile.is_open() || (aFile.size() < sizeof(H))) return false;
+		std::memcpy(&aHeader, aFile.data(), sizeof(H));
+		return (std::memcmp(aHeader.Magic, aMagic, sizeof(aMagic)) == 0) && (aHeader.Version == aVersion) && (aHeader.ByteOrder == CacheByteOrder);
+	}
+
+	inline bool write_cache_file(const std::string& aPath, const std::function<void(std::ostream&)>& aWrite) {
+		// Process and thread id keep writers in other processes off the same temporary.
+#if defined(_WIN32)
+		unsigned long Process = GetCurrentProcessId();
+#else
+		unsigned long Process = (unsigned long)getpid();
+#endif
+		std::stringstream Name;
+		Name << aPath << ".tmp" << std::hex << Process << "-" << std::hash<std::thread::id>()(std::this_thread::get_id());
+		std::string Temporary = Name.str();
+		std::error_code Error;
+		{
+			std::ofstream Stream(Temporary, std::ios::binary | std::ios::trunc);
+			if (!Stream) return false;
+			aWrite(Stream);
+			// Buffered data only reaches the file on flush and close, a full disk fails there.
+			Stream.flush();
+			Stream.close();
+			if (Stream.fail()) {
+				std::filesystem::remove(Temporary, Error);
+				return false;
+			}
+		}
+		std::filesystem::rename(Temporary, aPath, Error);
+		if (!Error) return true;
+		std::filesystem::remove(Temporary, Error);
+		return false;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_CACHE_FILE_H
@@ -0,0 +1,556 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_FFT_H
+#define GEODESY_UNIT_TEST_FFT_H
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/grid.h>
+#include <geodesy-unit-test/job_system.h>
+
+namespace geodesy::math {
+
+	// Discrete Fourier transform plan over math::complex<T> for one length, built once
+	// and reused. Forward is unnormalized, X[k] = sum_j x[j] e^(-2 pi i j k / n), inverse
+	// is scaled by 1/n so inverse(forward(x)) == x. Transforms run in place.
+	//
+	// Lengths whose prime factors are at most 13 use a mixed-radix Stockham transform
+	// (radix 2, 3, 4 and 5 butterflies, a generic butterfly for 7 to 13). Other lengths use
+	// Bluestein's algorithm over a power of two plan, so every length is O(n log n).
+	template <typename T>
+	class fft {
+	public:
+
+		fft();
+		fft(std::size_t aSize);
+
+		std::size_t size() const;
+		// Elements of scratch space a transform needs.
+		std::size_t scratch_size() const;
+
+		void forward(complex<T>* aData) const;
+		void inverse(complex<T>* aData) const;
+		// As above with caller owned scratch of scratch_size() elements, so a buffer can
+		// be reused across many lines.
+		void forward(complex<T>* aData, complex<T>* aScratch) const;
+		void inverse(complex<T>* aData, complex<T>* aScratch) const;
+
+		// Smallest length >= aMinimum with only factors 2, 3 and 5.
+		static std::size_t fast_size(std::size_t aMinimum);
+
+	private:
+
+		struct stage {
+			std::size_t Radix;
+			std::size_t Span; 			// Product of the radices of earlier stages.
+			std::size_t Twiddle; 		// Offset of this stage's twiddles in Twiddle.
+			std::size_t Root; 			// Offset of the radix roots in Root, generic butterflies only.
+		};
+
+		std::size_t 						Size;
+		std::vector<stage> 					Stage;
+		std::vector<complex<T>> 			Twiddle;
+		std::vector<complex<T>> 			Root;
+		// Bluestein, chirp w[k] = e^(-pi i k^2 / n) and the pre-scaled spectrum of conj(w).
+		std::shared_ptr<const fft<T>> 		Inner;
+		std::vector<complex<T>> 			Chirp;
+		std::vector<complex<T>> 			ChirpSpectrum;
+
+		void stockham(complex<T>* aData, complex<T>* aScratch) const;
+		void bluestein(complex<T>* aData, complex<T>* aScratch) const;
+
+	};
+
+	// Separable N dimensional transform over a dense array with Count[d] elements on axis
+	// d, axis 0 varying fastest (the math::grid node order). Lines along strided axes are
+	// gathered a block at a time so each cache line read is used by every line in the block.
+	// Given a job_system the lines of each axis run as its tasks.
+	template <typename T, std::size_t N>
+	class fft_nd {
+	public:
+
+		fft_nd();
+		fft_nd(const vec<std::size_t, N>& aCount);
+
+		std::size_t size() const;
+		void forward(complex<T>* aData, job_system* aJobs = nullptr) const;
+		void inverse(complex<T>* aData, job_system* aJobs = nullptr) const;
+
+	private:
+
+		vec<std::size_t, N> 	Count;
+		std::vector<fft<T>> 	Axis;
+
+		void transform(complex<T>* aData, bool aInverse, job_system* aJobs) const;
+
+	};
+
+	// Linear convolution of a field with a kernel of taps at the field's node spacing,
+	// centered on kernel node Count / 2 on each axis. Nodes outside the field are zero.
+	// convolve() runs in O(n log n) through fft_nd, convolve_direct() is the O(n k)
+	// reference and is faster only for very small kernels.
+	template <typename X, std::size_t N, typename Y>
+	grid<X, N, Y> convolve(const grid<X, N, Y>& aField, const grid<X, N, Y>& aKernel, job_system* aJobs = nullptr);
+	template <typename X, std::size_t N, typename Y>
+	grid<X, N, Y> convolve_direct(const grid<X, N, Y>& aField, const grid<X, N, Y>& aKernel);
+
+	// Normalized Gaussian kernel for aField's node spacing, aSigma in field units,
+	// truncated at three standard deviations. Convolving with it is one step of
+	// diffusion with aSigma = sqrt(2 * D * t).
+	template <typename X, std::size_t N, typename Y>
+	grid<X, N, Y> gaussian_kernel(const grid<X, N, Y>& aField, X aSigma);
+
+	namespace detail {
+
+		// e^(-2 pi i aNumerator / aDenominator), evaluated in double.
+		template <typename T>
+		inline complex<T> unit_root(std::size_t aNumerator, std::size_t aDenominator) {
+			const double Pi = 3.14159265358979323846;
+			double Angle = -2.0 * Pi * double(aNumerator % aDenominator) / double(aDenominator);
+			return complex<T>(T(std::cos(Angle)), T(std::sin(Angle)));
+		}
+
+		// -i * aValue.
+		template <typename T>
+		inline complex<T> rotate(const complex<T>& aValue) {
+			return complex<T>(aValue[1], -aValue[0]);
+		}
+
+		template <typename T>
+		inline complex<T> scale(const complex<T>& aValue, T aScale) {
+			return complex<T>(aValue[0] * aScale, aValue[1] * aScale);
+		}
+
+		// Runs aFunction(aBegin, aEnd) over [0, aCount), as aJobs tasks when given one. Each
+		// chunk allocates its own scratch, so there are about four per thread to balance load.
+		inline void parallel_range(std::size_t aCount, job_system* aJobs, const task_graph::range_function& aFunction) {
+			if ((aJobs == nullptr) || (aJobs->thread_count() <= 1) || (aCount <= 1)) {
+				if (aCount > 0) aFunction(0, aCount);
+				return;
+			}
+			aJobs->parallel_for(aCount, std::max<std::size_t>(1, aCount / (4 * aJobs->thread_count())), aFunction);
+		}
+
+	}
+
+	// ---------- fft ---------- //
+
+	template <typename T>
+	inline fft<T>::fft() {
+		Size = 0;
+	}
+
+	template <typename T>
+	inline fft<T>::fft(std::size_t aSize) {
+		Size = aSize;
+		if (Size <= 1) return;
+
+		// Factor, radix 4 first while an even count of twos remains.
+		std::vector<std::size_t> Radix;
+		std::size_t Remaining = Size;
+		while (Remaining % 4 == 0) { Radix.push_back(4); Remaining /= 4; }
+		while (Remaining % 2 == 0) { Radix.push_back(2); Remaining /= 2; }
+		for (std::size_t p = 3; p <= 13; p += 2) {
+			while (Remaining % p == 0) { Radix.push_back(p); Remaining /= p; }
+		}
+
+		if (Remaining == 1) {
+			std::size_t Span = 1;
+			for (std::size_t R : Radix) {
+				stage Current = { R, Span, Twiddle.size(), Root.size() };
+				for (std::size_t t = 0; t < Span; t++) {
+					for (std::size_t r = 1; r < R; r++) Twiddle.push_back(detail::unit_root<T>(r * t, Span * R));
+				}
+				if (R > 5) {
+					for (std::size_t r = 0; r < R; r++) Root.push_back(detail::unit_root<T>(r, R));
+				}
+				Stage.push_back(Current);
+				Span *= R;
+			}
+			return;
+		}
+
+		// Bluestein, a length n transform as a circular convolution of length M >= 2n - 1.
+		std::size_t M = 1;
+		while (M < 2 * Size - 1) M *= 2;
+		Inner = std::make_shared<const fft<T>>(M);
+		Chirp.resize(Size);
+		for (std::size_t k = 0; k < Size; k++) {
+			// k^2 mod 2n keeps the angle small for large k.
+			std::size_t Square = (std::size_t)(((unsigned long long)k * k) % (2ull * Size));
+			const double Pi = 3.14159265358979323846;
+			double Angle = -Pi * double(Square) / double(Size);
+			Chirp[k] = complex<T>(T(std::cos(Angle)), T(std::sin(Angle)));
+		}
+		ChirpSpectrum = std::vector<complex<T>>(M, complex<T>(T(0), T(0)));
+		ChirpSpectrum[0] = ~Chirp[0];
+		for (std::size_t k = 1; k < Size; k++) {
+			ChirpSpectrum[k] = ~Chirp[k];
+			ChirpSpectrum[M - k] = ~Chirp[k];
+		}
+		std::vector<complex<T>> Scratch(Inner->scratch_size());
+		Inner->forward(ChirpSpectrum.data(), Scratch.data());
+		// Fold the inner inverse's 1/M into the spectrum.
+		for (complex<T>& Value : ChirpSpectrum) Value = detail::scale(Value, T(1) / T(M));
+	}
+
+	template <typename T>
+	inline std::size_t fft<T>::size() const {
+		return Size;
+	}
+
+	template <typename T>
+	inline std::size_t fft<T>::scratch_size() const {
+		return Inner ? Inner->size() + Inner->scratch_size() : Size;
+	}
+
+	template <typename T>
+	inline void fft<T>::forward(complex<T>* aData) const {
+		std::vector<complex<T>> Scratch(this->scratch_size());
+		this->forward(aData, Scratch.data());
+	}
+
+	template <typename T>
+	inline void fft<T>::inverse(complex<T>* aData) const {
+		std::vector<complex<T>> Scratch(this->scratch_size());
+		this->inverse(aData, Scratch.data());
+	}
+
+	template <typename T>
+	inline void fft<T>::forward(complex<T>* aData, complex<T>* aScratch) const {
+		if (Size <= 1) return;
+		if (Inner) this->bluestein(aData, aScratch);
+		else this->stockham(aData, aScratch);
+	}
+
+	template <typename T>
+	inline void fft<T>::inverse(complex<T>* aData, complex<T>* aScratch) const {
+		if (Size <= 1) return;
+		// inverse(x) = conj(forward(conj(x))) / n
+		for (std::size_t i = 0; i < Size; i++) aData[i] = ~aData[i];
+		this->forward(aData, aScratch);
+		T Scale = T(1) / T(Size);
+		for (std::size_t i = 0; i < Size; i++) aData[i] = detail::scale(~aData[i], Scale);
+	}
+
+	template <typename T>
+	inline std::size_t fft<T>::fast_size(std::size_t aMinimum) {
+		std::size_t Best = 1;
+		while (Best < aMinimum) Best *= 2;
+		for (std::size_t P5 = 1; P5 < Best; P5 *= 5) {
+			for (std::size_t P35 = P5; P35 < Best; P35 *= 3) {
+				std::size_t Candidate = P35;
+				while (Candidate < aMinimum) Candidate *= 2;
+				Best = std::min(Best, Candidate);
+			}
+		}
+		return Best;
+	}
+
+	template <typename T>
+	inline void fft<T>::stockham(complex<T>* aData, complex<T>* aScratch) const {
+		// Self-sorting decimation in time, each stage reads Source and writes Destination
+		// so no bit reversal pass is needed.
+		complex<T>* Source = aData;
+		complex<T>* Destination = aScratch;
+		complex<T> Value[13];
+		for (const stage& Current : Stage) {
+			const std::size_t R = Current.Radix;
+			const std::size_t Span = Current.Span;
+			const std::size_t Stride = Size / R;
+			for (std::size_t j = 0; j < Stride; j++) {
+				std::size_t t = j % Span;
+				const complex<T>* W = &Twiddle[Current.Twiddle + t * (R - 1)];
+				Value[0] = Source[j];
+				for (std::size_t r = 1; r < R; r++) Value[r] = Source[j + r * Stride] * W[r - 1];
+				complex<T>* Out = Destination + (j - t) * R + t;
+				switch (R) {
+				case 2:
+					Out[0] 			= Value[0] + Value[1];
+					Out[Span] 		= Value[0] - Value[1];
+					break;
+				case 3: {
+					const T Half = T(0.5);
+					const T Sine = T(0.86602540378443864676);
+					complex<T> Sum 		= Value[1] + Value[2];
+					complex<T> Mid 		= Value[0] - detail::scale(Sum, Half);
+					complex<T> Turn 	= detail::scale(detail::rotate(Value[1] - Value[2]), Sine);
+					Out[0] 				= Value[0] + Sum;
+					Out[Span] 			= Mid + Turn;
+					Out[2 * Span] 		= Mid - Turn;
+					break;
+				}
+				case 4: {
+					complex<T> A0 	= Value[0] + Value[2];
+					complex<T> A1 	= Value[0] - Value[2];
+					complex<T> A2 	= Value[1] + Value[3];
+					complex<T> A3 	= detail::rotate(Value[1] - Value[3]);
+					Out[0] 			= A0 + A2;
+					Out[Span] 		= A1 + A3;
+					Out[2 * Span] 	= A0 - A2;
+					Out[3 * Span] 	= A1 - A3;
+					break;
+				}
+				case 5: {
+					const T C1 = T(0.30901699437494742410), C2 = T(-0.80901699437494742410);
+					const T S1 = T(0.95105651629515357212), S2 = T(0.58778525229247312917);
+					complex<T> T1 	= Value[1] + Value[4];
+					complex<T> T2 	= Value[2] + Value[3];
+					complex<T> T3 	= detail::rotate(Value[1] - Value[4]);
+					complex<T> T4 	= detail::rotate(Value[2] - Value[3]);
+					complex<T> A1 	= Value[0] + detail::scale(T1, C1) + detail::scale(T2, C2);
+					complex<T> A2 	= Value[0] + detail::scale(T1, C2) + detail::scale(T2, C1);
+					complex<T> B1 	= detail::scale(T3, S1) + detail::scale(T4, S2);
+					complex<T> B2 	= detail::scale(T3, S2) - detail::scale(T4, S1);
+					Out[0] 			= Value[0] + T1 + T2;
+					Out[Span] 		= A1 + B1;
+					Out[2 * Span] 	= A2 + B2;
+					Out[3 * Span] 	= A2 - B2;
+					Out[4 * Span] 	= A1 - B1;
+					break;
+				}
+				default: {
+					const complex<T>* Omega = &Root[Current.Root];
+					for (std::size_t k = 0; k < R; k++) {
+						complex<T> Sum = Value[0];
+						for (std::size_t r = 1; r < R; r++) Sum = Sum + Value[r] * Omega[(r * k) % R];
+						Out[k * Span] = Sum;
+					}
+					break;
+				}
+				}
+			}
+			std::swap(Source, Destination);
+		}
+		if (Source != aData) std::copy(Source, Source + Size, aData);
+	}
+
+	template <typename T>
+	inline void fft<T>::bluestein(complex<T>* aData, complex<T>* aScratch) const {
+		const std::size_t M = Inner->size();
+		complex<T>* Work = aScratch;
+		complex<T>* InnerScratch = aScratch + M;
+		for (std::size_t k = 0; k < Size; k++) Work[k] = aData[k] * Chirp[k];
+		std::fill(Work + Size, Work + M, complex<T>(T(0), T(0)));
+		Inner->forward(Work, InnerScratch);
+		// Pointwise product, then the inverse through conjugation, 1/M is in the spectrum.
+		for (std::size_t k = 0; k < M; k++) Work[k] = ~(Work[k] * ChirpSpectrum[k]);
+		Inner->forward(Work, InnerScratch);
+		for (std::size_t k = 0; k < Size; k++) aData[k] = ~Work[k] * Chirp[k];
+	}
+
+	// ---------- fft_nd ---------- //
+
+	template <typename T, std::size_t N>
+	inline fft_nd<T, N>::fft_nd() {}
+
+	template <typename T, std::size_t N>
+	inline fft_nd<T, N>::fft_nd(const vec<std::size_t, N>& aCount) {
+		Count = aCount;
+		for (std::size_t d = 0; d < N; d++) Axis.emplace_back(aCount[d]);
+	}
+
+	template <typename T, std::size_t N>
+	inline std::size_t fft_nd<T, N>::size() const {
+		std::size_t Size = 1;
+		for (std::size_t d = 0; d < N; d++) Size *= Count[d];
+		return Size;
+	}
+
+	template <typename T, std::size_t N>
+	inline void fft_nd<T, N>::forward(complex<T>* aData, job_system* aJobs) const {
+		this->transform(aData, false, aJobs);
+	}
+
+	template <typename T, std::size_t N>
+	inline void fft_nd<T, N>::inverse(complex<T>* aData, job_system* aJobs) const {
+		this->transform(aData, true, aJobs);
+	}
+
+	template <typename T, std::size_t N>
+	inline void fft_nd<T, N>::transform(complex<T>* aData, bool aInverse, job_system* aJobs) const {
+		// Lines gathered together along strided axes, 16 complex<float> fill two cache lines.
+		const std::size_t Block = 16;
+		std::size_t Inner = 1;
+		for (std::size_t d = 0; d < N; d++) {
+			const fft<T>& Plan = Axis[d];
+			const std::size_t Length = Count[d];
+			const std::size_t Outer = this->size() / (Inner * Length);
+			if (Length > 1) {
+				if (Inner == 1) {
+					// Contiguous lines are transformed where they lie.
+					detail::parallel_range(Outer, aJobs, [&](std::size_t aBegin, std::size_t aEnd) {
+						std::vector<complex<T>> Scratch(Plan.scratch_size());
+						for (std::size_t o = aBegin; o < aEnd; o++) {
+							if (aInverse) Plan.inverse(aData + o * Length, Scratch.data());
+							else Plan.forward(aData + o * Length, Scratch.data());
+						}
+					});
+				}
+				else {
+					const std::size_t BlockCount = (Inner + Block - 1) / Block;
+					detail::parallel_range(Outer * BlockCount, aJobs, [&](std::size_t aBegin, std::size_t aEnd) {
+						std::vector<complex<T>> Scratch(Plan.scratch_size());
+						std::vector<complex<T>> Line(Block * Length);
+						for (std::size_t Task = aBegin; Task < aEnd; Task++) {
+							std::size_t o = Task / BlockCount;
+							std::size_t First = (Task % BlockCount) * Block;
+							std::size_t Width = std::min(Block, Inner - First);
+							complex<T>* Base = aData + o * Inner * Length + First;
+							for (std::size_t k = 0; k < Length; k++) {
+								for (std::size_t b = 0; b < Width; b++) Line[b * Length + k] = Base[k * Inner + b];
+							}
+							for (std::size_t b = 0; b < Width; b++) {
+								if (aInverse) Plan.inverse(&Line[b * Length], Scratch.data());
+								else Plan.forward(&Line[b * Length], Scratch.data());
+							}
+							for (std::size_t k = 0; k < Length; k++) {
+								for (std::size_t b = 0; b < Width; b++) Base[k * Inner + b] = Line[b * Length + k];
+							}
+						}
+					});
+				}
+			}
+			Inner *= Length;
+		}
+	}
+
+	// ---------- Convolution ---------- //
+
+	template <typename X, std::size_t N, typename Y>
+	inline grid<X, N, Y> convolve(const grid<X, N, Y>& aField, const grid<X, N, Y>& aKernel, job_system* aJobs) {
+		static_assert(std::is_floating_point_v<Y>, "convolve() needs a real valued field.");
+		vec<std::size_t, N> Padded, Center;
+		std::size_t Size = 1;
+		for (std::size_t d = 0; d < N; d++) {
+			// Zero padding to at least field + kernel - 1 keeps the circular result linear.
+			Padded[d] = fft<Y>::fast_size(aField.Layout.Count[d] + aKernel.Layout.Count[d] - 1);
+			Center[d] = aKernel.Layout.Count[d] / 2;
+			Size *= Padded[d];
+		}
+
+		// Both real inputs share one complex transform, field in the real part and the
+		// kernel (wrapped so its center sits at the origin) in the imaginary part. Separating
+		// the spectra subtracts one from the other, so the kernel is brought to the field's
+		// magnitude first to keep its rounding error relative to its own size.
+		Y FieldMaximum = Y(0), KernelMaximum = Y(0);
+		for (std::size_t i = 0; i < aField.size(); i++) FieldMaximum = std::max(FieldMaximum, std::abs(aField[i]));
+		for (std::size_t i = 0; i < aKernel.size(); i++) KernelMaximum = std::max(KernelMaximum, std::abs(aKernel[i]));
+		Y Balance = (FieldMaximum > Y(0)) && (KernelMaximum > Y(0)) ? FieldMaximum / KernelMaximum : Y(1);
+		std::vector<complex<Y>> Data(Size, complex<Y>(Y(0), Y(0)));
+		std::size_t Coordinate[N];
+		for (std::size_t i = 0; i < aField.size(); i++) {
+			std::size_t Index = i, Offset = 0;
+			for (std::size_t d = 0, Stride = 1; d < N; d++) {
+				Offset += (Index % aField.Layout.Count[d]) * Stride;
+				Index /= aField.Layout.Count[d];
+				Stride *= Padded[d];
+			}
+			Data[Offset][0] = aField[i];
+		}
+		for (std::size_t i = 0; i < aKernel.size(); i++) {
+			std::size_t Index = i, Offset = 0;
+			for (std::size_t d = 0, Stride = 1; d < N; d++) {
+				std::size_t Tap = Index % aKernel.Layout.Count[d];
+				Offset += ((Tap + Padded[d] - Center[d]) % Padded[d]) * Stride;
+				Index /= aKernel.Layout.Count[d];
+				Stride *= Padded[d];
+			}
+			Data[Offset][1] = aKernel[i] * Balance;
+		}
+
+		fft_nd<Y, N> Transform(Padded);
+		Transform.forward(Data.data(), aJobs);
+
+		// With Z = F + iK for real F and K, F^[k] = (Z[k] + ~Z[-k]) / 2 and
+		// K^[k] = -i (Z[k] - ~Z[-k]) / 2. The product at -k is the conjugate of the
+		// product at k, so each pair is visited once.
+		for (std::size_t i = 0; i < Size; i++) {
+			std::size_t Index = i, Mirror = 0;
+			for (std::size_t d = 0, Stride = 1; d < N; d++) {
+				Coordinate[d] = Index % Padded[d];
+				Index /= Padded[d];
+				Mirror += ((Padded[d] - Coordinate[d]) % Padded[d]) * Stride;
+				Stride *= Padded[d];
+			}
+			if (Mirror < i) continue;
+			complex<Y> Z = Data[i];
+			complex<Y> ZMirror = ~Data[Mirror];
+			complex<Y> F = detail::scale(Z + ZMirror, Y(0.5));
+			complex<Y> K = detail::scale(detail::rotate(Z - ZMirror), Y(0.5) / Balance);
+			complex<Y> Product = F * K;
+			Data[Mirror] = ~Product;
+			Data[i] = Product;
+		}
+
+		Transform.inverse(Data.data(), aJobs);
+
+		grid<X, N, Y> Result(aField.Layout.Lower, aField.Layout.Upper, aField.Layout.Count, Y(0));
+		for (std::size_t i = 0; i < Result.size(); i++) {
+			std::size_t Index = i, Offset = 0;
+			for (std::size_t d = 0, Stride = 1; d < N; d++) {
+				Offset += (Index % aField.Layout.Count[d]) * Stride;
+				Index /= aField.Layout.Count[d];
+				Stride *= Padded[d];
+			}
+			Result[i] = Data[Offset][0];
+		}
+		return Result;
+	}
+
+	template <typename X, std::size_t N, typename Y>
+	inline grid<X, N, Y> convolve_direct(const grid<X, N, Y>& aField, const grid<X, N, Y>& aKernel) {
+		grid<X, N, Y> Result(aField.Layout.Lower, aField.Layout.Upper, aField.Layout.Count, Y(0));
+		std::size_t Node[N], Tap[N], Source[N];
+		for (std::size_t i = 0; i < Result.size(); i++) {
+			std::size_t Index = i;
+			for (std::size_t d = 0; d < N; d++) { Node[d] = Index % aField.Layout.Count[d]; Index /= aField.Layout.Count[d]; }
+			Y Sum = Y(0);
+			for (std::size_t k = 0; k < aKernel.size(); k++) {
+				std::size_t KernelIndex = k;
+				bool Inside = true;
+				for (std::size_t d = 0; d < N; d++) {
+					Tap[d] = KernelIndex % aKernel.Layout.Count[d];
+					KernelIndex /= aKernel.Layout.Count[d];
+					// Source = Node - (Tap - Center), unsigned wrap lands out of range.
+					Source[d] = Node[d] + aKernel.Layout.Count[d] / 2 - Tap[d];
+					Inside &= (Source[d] < aField.Layout.Count[d]);
+				}
+				if (Inside) Sum += aField.Storage.get((const std::size_t*)Source) * aKernel[k];
+			}
+			Result[i] = Sum;
+		}
+		return Result;
+	}
+
+	template <typename X, std::size_t N, typename Y>
+	inline grid<X, N, Y> gaussian_kernel(const grid<X, N, Y>& aField, X aSigma) {
+		vec<X, N> Spacing, Lower, Upper;
+		vec<std::size_t, N> Count;
+		for (std::size_t d = 0; d < N; d++) {
+			Spacing[d] = aField.Layout.Count[d] > 1 ? (aField.Layout.Upper[d] - aField.Layout.Lower[d]) / X(aField.Layout.Count[d] - 1) : X(0);
+			std::size_t Radius = Spacing[d] > X(0) ? (std::size_t)std::ceil(X(3) * aSigma / Spacing[d]) : 0;
+			Count[d] = 2 * Radius + 1;
+			Lower[d] = -X(Radius) * Spacing[d];
+			Upper[d] = X(Radius) * Spacing[d];
+		}
+		grid<X, N, Y> Kernel(Lower, Upper, Count, Y(0));
+		Y Sum = Y(0);
+		for (std::size_t i = 0; i < Kernel.size(); i++) {
+			vec<X, N> Position = Kernel.Layout.position(i);
+			Kernel[i] = Y(std::exp(-(Position * Position) / (X(2) * aSigma * aSigma)));
+			Sum += Kernel[i];
+		}
+		for (std::size_t i = 0; i < Kernel.size(); i++) Kernel[i] /= Sum;
+		return Kernel;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_FFT_H
@@ -0,0 +1,464 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_GLTF_H
+#define GEODESY_UNIT_TEST_GLTF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <filesystem>
+#include <fstream>
+
+#include <geodesy-unit-test/json.h>
+#include <geodesy-unit-test/mapped_file.h>
+
+namespace geodesy::io {
+
+	// glTF 2.0 importer for .gltf (JSON plus external .bin or data: URI buffers) and .glb.
+	// In MAP mode buffer payloads are memory mapped and accessors are strided views over the
+	// mapping, so vertex and index data is copied once, when it is converted to the engine's
+	// layout, and pages that are never read are never loaded. READ mode reads buffers into
+	// the heap first and exists as the baseline for comparison. Sparse accessors and
+	// extensions that replace buffer data (Draco, meshopt) are not supported.
+	class gltf {
+	public:
+
+		enum mode { MAP, READ };
+
+		enum component : uint32_t {
+			BYTE 			= 5120,
+			UNSIGNED_BYTE 	= 5121,
+			SHORT 			= 5122,
+			UNSIGNED_SHORT 	= 5123,
+			UNSIGNED_INT 	= 5125,
+			FLOAT 			= 5126,
+		};
+
+		struct buffer_view {
+			std::size_t 	Buffer;
+			std::size_t 	Offset;
+			std::size_t 	Length;
+			std::size_t 	Stride; 			// 0 when tightly packed.
+		};
+
+		struct accessor {
+			std::size_t 	View; 				// SIZE_MAX when the accessor has no buffer view (all zero).
+			std::size_t 	Offset;
+			uint32_t 		ComponentType;
+			std::size_t 	ComponentCount;
+			std::size_t 	Count;
+			bool 			Normalized;
+			bool 			Sparse;
+			std::size_t element_size() const;
+		};
+
+		struct primitive {
+			std::vector<std::pair<std::string, std::size_t>> 	Attribute;
+			std::size_t 										Indices; 	// SIZE_MAX when not indexed.
+			std::size_t 										Material; 	// SIZE_MAX when unset.
+			uint32_t 											Mode;
+			// Accessor of a named attribute, SIZE_MAX when absent.
+			std::size_t attribute(const std::string& aName) const;
+		};
+
+		struct mesh {
+			std::string 			Name;
+			std::vector<primitive> 	Primitive;
+		};
+
+		// Strided, typed window over buffer memory. Elements may be unaligned.
+		struct view {
+			const uint8_t* 	Data;
+			std::size_t 	Count;
+			std::size_t 	Stride;
+			uint32_t 		ComponentType;
+			std::size_t 	ComponentCount;
+			bool 			Normalized;
+			// Element i, component c, converted to float (normalized integers to [0,1] or [-1,1]).
+			float component(std::size_t aIndex, std::size_t aComponent) const;
+			// Element i of a scalar integer accessor.
+			uint32_t index(std::size_t aIndex) const;
+			// Direct pointer when the data already is a packed, aligned T array, else null.
+			template <typename T> const T* as(uint32_t aComponentType) const;
+		};
+
+		json 						Document;
+		std::vector<buffer_view> 	BufferView;
+		std::vector<accessor> 		Accessor;
+		std::vector<mesh> 			Mesh;
+
+		gltf();
+
+		// Loads a .gltf or .glb, the container is detected from the file's magic.
+		static gltf load(const std::string& aPath, mode aMode = MAP);
+
+		std::size_t buffer_count() const;
+		const uint8_t* buffer_data(std::size_t aBuffer) const;
+		std::size_t buffer_size(std::size_t aBuffer) const;
+
+		// View over an accessor's data, bounds checked against its buffer.
+		view accessor_view(std::size_t aAccessor) const;
+		// Converting copy of an accessor into aOut, aOutStride floats apart, aComponents per element.
+		void read_float(std::size_t aAccessor, float* aOut, std::size_t aOutStride, std::size_t aComponents) const;
+		std::vector<uint32_t> read_indices(std::size_t aAccessor) const;
+
+		// Bytes of buffer data held in the heap rather than mapped.
+		std::size_t heap_bytes() const;
+
+	private:
+
+		struct buffer {
+			const uint8_t* 	Data;
+			std::size_t 	Size;
+		};
+
+		std::vector<mapped_file> 			File;
+		std::vector<std::vector<uint8_t>> 	Owned;
+		std::vector<buffer> 				Buffer;
+
+		void parse_document(const std::filesystem::path& aDirectory, const uint8_t* aBinary, std::size_t aBinarySize, mode aMode);
+		static std::vector<uint8_t> decode_base64(std::string_view aText);
+		static std::string decode_uri(const std::string& aURI);
+
+	};
+
+	// Interleaves the named attributes of a primitive into one float vertex array, the copy
+	// that converts glTF data to an engine vertex layout. Attributes missing from the
+	// primitive are filled with their default component values.
+	struct vertex_attribute {
+		std::string 		Name;
+		std::size_t 		ComponentCount;
+		float 				Default[4];
+	};
+	std::vector<float> interleave(const gltf& aModel, const gltf::primitive& aPrimitive, const std::vector<vertex_attribute>& aLayout);
+
+	// ---------- gltf ---------- //
+
+	inline std::size_t gltf::accessor::element_size() const {
+		std::size_t ComponentSize = 4;
+		switch (ComponentType) {
+		case BYTE: case UNSIGNED_BYTE: ComponentSize = 1; break;
+		case SHORT: case UNSIGNED_SHORT: ComponentSize = 2; break;
+		default: ComponentSize = 4; break;
+		}
+		return ComponentSize * ComponentCount;
+	}
+
+	inline std::size_t gltf::primitive::attribute(const std::string& aName) const {
+		for (const std::pair<std::string, std::size_t>& A : Attribute) if (A.first == aName) return A.second;
+		return SIZE_MAX;
+	}
+
+	inline float gltf::view::component(std::size_t aIndex, std::size_t aComponent) const {
+		if (Data == nullptr) return 0.0f;
+		const uint8_t* Pointer = Data + aIndex * Stride;
+		switch (ComponentType) {
+		case FLOAT: 			{ float V; std::memcpy(&V, Pointer + 4 * aComponent, 4); return V; }
+		case UNSIGNED_BYTE: 	{ uint8_t V = Pointer[aComponent]; return Normalized ? (float)V / 255.0f : (float)V; }
+		case BYTE: 				{ int8_t V; std::memcpy(&V, Pointer + aComponent, 1); return Normalized ? std::max((float)V / 127.0f, -1.0f) : (float)V; }
+		case UNSIGNED_SHORT: 	{ uint16_t V; std::memcpy(&V, Pointer + 2 * aComponent, 2); return Normalized ? (float)V / 65535.0f : (float)V; }
+		case SHORT: 			{ int16_t V; std::memcpy(&V, Pointer + 2 * aComponent, 2); return Normalized ? std::max((float)V / 32767.0f, -1.0f) : (float)V; }
+		case UNSIGNED_INT: 		{ uint32_t V; std::memcpy(&V, Pointer + 4 * aComponent, 4); return (float)V; }
+		default: 				return 0.0f;
+		}
+	}
+
+	inline uint32_t gltf::view::index(std::size_t aIndex) const {
+		if (Data == nullptr) return 0;
+		const uint8_t* Pointer = Data + aIndex * Stride;
+		switch (ComponentType) {
+		case UNSIGNED_BYTE: 	return Pointer[0];
+		case UNSIGNED_SHORT: 	{ uint16_t V; std::memcpy(&V, Pointer, 2); return V; }
+		case UNSIGNED_INT: 		{ uint32_t V; std::memcpy(&V, Pointer, 4); return V; }
+		default: 				return 0;
+		}
+	}
+
+	template <typename T>
+	inline const T* gltf::view::as(uint32_t aComponentType) const {
+		if ((Data == nullptr) || (ComponentType != aComponentType) || Normalized) return nullptr;
+		if ((Stride != sizeof(T)) || (((uintptr_t)Data % alignof(T)) != 0)) return nullptr;
+		return reinterpret_cast<const T*>(Data);
+	}
+
+	inline gltf::gltf() {}
+
+	inline gltf gltf::load(const std::string& aPath, mode aMode) {
+		gltf Model;
+		std::filesystem::path Directory = std::filesystem::path(aPath).parent_path();
+		mapped_file Source;
+		std::vector<uint8_t> Whole;
+		const uint8_t* Data = nullptr;
+		std::size_t Size = 0;
+		if (aMode == READ) {
+			std::ifstream Stream(aPath, std::ios::binary);
+			if (!Stream) throw std::runtime_error("gltf: cannot open " + aPath);
+			Whole.resize((std::size_t)std::filesystem::file_size(aPath));
+			if (!Stream.read((char*)Whole.data(), Whole.size())) throw std::runtime_error("gltf: cannot read " + aPath);
+			Data = Whole.data();
+			Size = Whole.size();
+		}
+		else {
+			Source = mapped_file(aPath);
+			if (!Source.is_open()) throw std::runtime_error("gltf: cannot open " + aPath);
+			Data = Source.data();
+			Size = Source.size();
+		}
+
+		uint32_t Magic = 0;
+		if (Size >= 4) std::memcpy(&Magic, Data, 4);
+		if (Magic == 0x46546C67u) {
+			// GLB: 12 byte header, then a JSON chunk and an optional BIN chunk.
+			uint32_t Header[3];
+			if (Size < 20) throw std::runtime_error("gltf: truncated GLB header in " + aPath);
+			std::memcpy(Header, Data, 12);
+			if (Header[1] != 2) throw std::runtime_error("gltf: unsupported GLB version in " + aPath);
+			std::size_t Offset = 12;
+			std::string_view Text;
+			const uint8_t* Binary = nullptr;
+			std::size_t BinarySize = 0;
+			std::size_t End = std::min<std::size_t>(Header[2], Size);
+			while (Offset + 8 <= End) {
+				uint32_t Chunk[2];
+				std::memcpy(Chunk, Data + Offset, 8);
+				Offset += 8;
+				if (Offset + Chunk[0] > End) throw std::runtime_error("gltf: truncated GLB chunk in " + aPath);
+				if ((Chunk[1] == 0x4E4F534Au) && Text.empty()) Text = std::string_view((const char*)Data + Offset, Chunk[0]);
+				else if ((Chunk[1] == 0x004E4942u) && (Binary == nullptr)) { Binary = Data + Offset; BinarySize = Chunk[0]; }
+				Offset += (Chunk[0] + 3) & ~std::size_t(3);
+			}
+			if (Text.empty()) throw std::runtime_error("gltf: GLB without JSON chunk in " + aPath);
+			Model.Document = json::parse(Text);
+			// The BIN chunk is used in place, the file contents must outlive the model.
+			if (aMode == READ) Model.Owned.push_back(std::move(Whole));
+			else Model.File.push_back(std::move(Source));
+			Model.parse_document(Directory, Binary, BinarySize, aMode);
+		}
+		else {
+			Model.Document = json::parse(std::string_view((const char*)Data, Size));
+			Model.parse_document(Directory, nullptr, 0, aMode);
+		}
+		return Model;
+	}
+
+	inline std::size_t gltf::buffer_count() const {
+		return Buffer.size();
+	}
+
+	inline const uint8_t* gltf::buffer_data(std::size_t aBuffer) const {
+		return Buffer[aBuffer].Data;
+	}
+
+	inline std::size_t gltf::buffer_size(std::size_t aBuffer) const {
+		return Buffer[aBuffer].Size;
+	}
+
+	inline gltf::view gltf::accessor_view(std::size_t aAccessor) const {
+		if (aAccessor >= Accessor.size()) throw std::runtime_error("gltf: accessor index out of range");
+		const accessor& A = Accessor[aAccessor];
+		if (A.Sparse) throw std::runtime_error("gltf: sparse accessors are not supported");
+		view View{ nullptr, A.Count, A.element_size(), A.ComponentType, A.ComponentCount, A.Normalized };
+		if (A.View == SIZE_MAX) return View;
+		const buffer_view& B = BufferView[A.View];
+		View.Stride = B.Stride > 0 ? B.Stride : A.element_size();
+		// Last element must end inside both the buffer view and the buffer.
+		bool Inside = (B.Offset <= Buffer[B.Buffer].Size) && (B.Length <= Buffer[B.Buffer].Size - B.Offset);
+		if (Inside && (A.Count > 0)) {
+			Inside = (A.Offset <= B.Length) && (A.element_size() <= B.Length - A.Offset) && ((A.Count - 1) <= (B.Length - A.Offset - A.element_size()) / View.Stride);
+		}
+		if (!Inside) throw std::runtime_error("gltf: accessor " + std::to_string(aAccessor) + " exceeds its buffer");
+		View.Data = Buffer[B.Buffer].Data + B.Offset + A.Offset;
+		return View;
+	}
+
+	inline void gltf::read_float(std::size_t aAccessor, float* aOut, std::size_t aOutStride, std::size_t aComponents) const {
+		view View = this->accessor_view(aAccessor);
+		std::size_t Components = std::min(aComponents, View.ComponentCount);
+		if ((View.ComponentType == FLOAT) && (View.Data != nullptr)) {
+			// Common case, no conversion, copy the components straight from the mapping.
+			for (std::size_t i = 0; i < View.Count; i++) std::memcpy(aOut + i * aOutStride, View.Data + i * View.Stride, Components * sizeof(float));
+			return;
+		}
+		for (std::size_t i = 0; i < View.Count; i++) {
+			for (std::size_t c = 0; c < Components; c++) aOut[i * aOutStride + c] = View.component(i, c);
+		}
+	}
+
+	inline std::vector<uint32_t> gltf::read_indices(std::size_t aAccessor) const {
+		view View = this->accessor_view(aAccessor);
+		std::vector<uint32_t> Index(View.Count);
+		if (const uint32_t* Direct = View.as<uint32_t>(UNSIGNED_INT)) {
+			std::memcpy(Index.data(), Direct, View.Count * sizeof(uint32_t));
+			return Index;
+		}
+		for (std::size_t i = 0; i < View.Count; i++) Index[i] = View.index(i);
+		return Index;
+	}
+
+	inline std::size_t gltf::heap_bytes() const {
+		std::size_t Bytes = 0;
+		for (const std::vector<uint8_t>& O : Owned) Bytes += O.size();
+		return Bytes;
+	}
+
+	inline void gltf::parse_document(const std::filesystem::path& aDirectory, const uint8_t* aBinary, std::size_t aBinarySize, mode aMode) {
+		const json& BufferList = Document["buffers"];
+		for (std::size_t i = 0; i < BufferList.size(); i++) {
+			const json& B = BufferList[i];
+			std::size_t Length = B["byteLength"].as_index(0);
+			buffer Entry{ nullptr, 0 };
+			if (!B.has("uri")) {
+				if ((i != 0) || (aBinary == nullptr)) throw std::runtime_error("gltf: buffer " + std::to_string(i) + " has no data");
+				Entry = { aBinary, aBinarySize };
+			}
+			else {
+				std::string URI = B["uri"].as_string();
+				if (URI.compare(0, 5, "data:") == 0) {
+					std::size_t Comma = URI.find(',');
+					if ((Comma == std::string::npos) || (URI.rfind(";base64", Comma) == std::string::npos)) throw std::runtime_error("gltf: unsupported data URI in buffer " + std::to_string(i));
+					Owned.push_back(decode_base64(std::string_view(URI).substr(Comma + 1)));
+					Entry = { Owned.back().data(), Owned.back().size() };
+				}
+				else {
+					std::string Path = (aDirectory / decode_uri(URI)).string();
+					if (aMode == READ) {
+						std::ifstream Stream(Path, std::ios::binary);
+						if (!Stream) throw std::runtime_error("gltf: cannot open buffer " + Path);
+						Owned.emplace_back((std::size_t)std::filesystem::file_size(Path));
+						if (!Stream.read((char*)Owned.back().data(), Owned.back().size())) throw std::runtime_error("gltf: cannot read buffer " + Path);
+						Entry = { Owned.back().data(), Owned.back().size() };
+					}
+					else {
+						File.emplace_back(Path);
+						if (!File.back().is_open()) throw std::runtime_error("gltf: cannot open buffer " + Path);
+						Entry = { File.back().data(), File.back().size() };
+					}
+				}
+			}
+			if (Entry.Size < Length) throw std::runtime_error("gltf: buffer " + std::to_string(i) + " is shorter than its byteLength");
+			Buffer.push_back(Entry);
+		}
+
+		const json& ViewList = Document["bufferViews"];
+		for (std::size_t i = 0; i < ViewList.size(); i++) {
+			const json& V = ViewList[i];
+			buffer_view View{ V["buffer"].as_index(), V["byteOffset"].as_index(0), V["byteLength"].as_index(0), V["byteStride"].as_index(0) };
+			if (View.Buffer >= Buffer.size()) throw std::runtime_error("gltf: buffer view " + std::to_string(i) + " references a missing buffer");
+			BufferView.push_back(View);
+		}
+
+		const json& AccessorList = Document["accessors"];
+		for (std::size_t i = 0; i < AccessorList.size(); i++) {
+			const json& A = AccessorList[i];
+			std::string Type = A["type"].as_string();
+			std::size_t ComponentCount = 0;
+			if (Type == "SCALAR") ComponentCount = 1;
+			else if (Type == "VEC2") ComponentCount = 2;
+			else if (Type == "VEC3") ComponentCount = 3;
+			else if (Type == "VEC4") ComponentCount = 4;
+			else if (Type == "MAT2") ComponentCount = 4;
+			else if (Type == "MAT3") ComponentCount = 9;
+			else if (Type == "MAT4") ComponentCount = 16;
+			else throw std::runtime_error("gltf: accessor " + std::to_string(i) + " has unknown type " + Type);
+			accessor Entry{ A["bufferView"].as_index(), A["byteOffset"].as_index(0), (uint32_t)A["componentType"].as_int(0), ComponentCount, A["count"].as_index(0), A["normalized"].as_bool(false), A.has("sparse") };
+			if ((Entry.View != SIZE_MAX) && (Entry.View >= BufferView.size())) throw std::runtime_error("gltf: accessor " + std::to_string(i) + " references a missing buffer view");
+			Accessor.push_back(Entry);
+		}
+
+		// Primitive indices are checked here so consumers can index Accessor directly.
+		const json& MeshList = Document["meshes"];
+		std::size_t MaterialCount = Document["materials"].size();
+		for (std::size_t i = 0; i < MeshList.size(); i++) {
+			mesh Entry;
+			Entry.Name = MeshList[i]["name"].as_string();
+			const json& PrimitiveList = MeshList[i]["primitives"];
+			for (std::size_t p = 0; p < PrimitiveList.size(); p++) {
+				const json& P = PrimitiveList[p];
+				std::string Where = "gltf: mesh " + std::to_string(i) + " primitive " + std::to_string(p);
+				primitive Primitive;
+				for (const std::pair<std::string, json>& A : P["attributes"].Member) {
+					std::size_t Index = A.second.as_index();
+					if (Index >= Accessor.size()) throw std::runtime_error(Where + " attribute " + A.first + " references a missing accessor");
+					Primitive.Attribute.emplace_back(A.first, Index);
+				}
+				Primitive.Indices 	= P["indices"].as_index();
+				Primitive.Material 	= P["material"].as_index();
+				Primitive.Mode 		= (uint32_t)P["mode"].as_int(4);
+				if (P.has("indices") && (Primitive.Indices >= Accessor.size())) throw std::runtime_error(Where + " references a missing index accessor");
+				if (P.has("material") && (Primitive.Material >= MaterialCount)) throw std::runtime_error(Where + " references a missing material");
+				Entry.Primitive.push_back(std::move(Primitive));
+			}
+			Mesh.push_back(std::move(Entry));
+		}
+	}
+
+	inline std::vector<uint8_t> gltf::decode_base64(std::string_view aText) {
+		auto value = [](char aC) -> int {
+			if ((aC >= 'A') && (aC <= 'Z')) return aC - 'A';
+			if ((aC >= 'a') && (aC <= 'z')) return aC - 'a' + 26;
+			if ((aC >= '0') && (aC <= '9')) return aC - '0' + 52;
+			if ((aC == '+') || (aC == '-')) return 62;
+			if ((aC == '/') || (aC == '_')) return 63;
+			return -1;
+		};
+		std::vector<uint8_t> Data;
+		Data.reserve(aText.size() * 3 / 4);
+		uint32_t Accumulator = 0;
+		int Bits = 0;
+		for (char C : aText) {
+			int V = value(C);
+			if (V < 0) continue;
+			Accumulator = (Accumulator << 6) | (uint32_t)V;
+			Bits += 6;
+			if (Bits >= 8) {
+				Bits -= 8;
+				Data.push_back((uint8_t)((Accumulator >> Bits) & 0xFF));
+			}
+		}
+		return Data;
+	}
+
+	inline std::string gltf::decode_uri(const std::string& aURI) {
+		std::string Path;
+		for (std::size_t i = 0; i < aURI.size(); i++) {
+			if ((aURI[i] == '%') && (i + 2 < aURI.size())) {
+				Path += (char)std::stoi(aURI.substr(i + 1, 2), nullptr, 16);
+				i += 2;
+			}
+			else {
+				Path += aURI[i];
+			}
+		}
+		return Path;
+	}
+
+	inline std::vector<float> interleave(const gltf& aModel, const gltf::primitive& aPrimitive, const std::vector<vertex_attribute>& aLayout) {
+		std::size_t Stride = 0;
+		for (const vertex_attribute& A : aLayout) Stride += A.ComponentCount;
+		std::size_t Position = aPrimitive.attribute("POSITION");
+		std::size_t Count = Position != SIZE_MAX ? aModel.Accessor[Position].Count : 0;
+		std::vector<float> Vertex(Count * Stride);
+		std::size_t Offset = 0;
+		for (const vertex_attribute& A : aLayout) {
+			std::size_t Source = aPrimitive.attribute(A.Name);
+			std::size_t Filled = 0;
+			if ((Source != SIZE_MAX) && (aModel.Accessor[Source].Count == Count)) {
+				aModel.read_float(Source, Vertex.data() + Offset, Stride, A.ComponentCount);
+				Filled = std::min(A.ComponentCount, aModel.Accessor[Source].ComponentCount);
+			}
+			for (std::size_t c = Filled; c < A.ComponentCount; c++) {
+				for (std::size_t i = 0; i < Count; i++) Vertex[i * Stride + Offset + c] = A.Default[c];
+			}
+			Offset += A.ComponentCount;
+		}
+		return Vertex;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_GLTF_H
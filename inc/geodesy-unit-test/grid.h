@@ -0,0 +1,600 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_GRID_H
+#define GEODESY_UNIT_TEST_GRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/math_expr.h>
+#include <geodesy-unit-test/vec_array.h>
+#include <geodesy-unit-test/job_system.h>
+
+namespace geodesy::math {
+
+	// Storage policies for math::grid.
+	//	dense			One contiguous array over the whole box.
+	//	bricked<B>		B^N node bricks, allocated only where a node was written or an
+	//					expression produced non-background values. Unallocated bricks read
+	//					as the background value the grid was created with.
+	struct dense {};
+	template <std::size_t B = 8> struct bricked { static constexpr std::size_t Size = B; };
+
+	template <typename Y, std::size_t N, typename P> class grid_storage;
+
+	template <typename Y, std::size_t N>
+	class grid_storage<Y, N, dense> {
+	public:
+
+		static constexpr bool Bricked = false;
+		static constexpr std::size_t BrickSize = 0;
+
+		vec<std::size_t, N> 	Count;
+		std::vector<Y> 			Data;
+
+		void create(const vec<std::size_t, N>& aCount, Y aBackground);
+		std::size_t index(const std::size_t* aCoordinate) const;
+		Y get(std::size_t aIndex) const { return Data[aIndex]; }
+		Y& ref(std::size_t aIndex) { return Data[aIndex]; }
+		Y get(const std::size_t* aCoordinate) const { return Data[this->index(aCoordinate)]; }
+		// Bytes of node storage.
+		std::size_t memory() const { return Data.size() * sizeof(Y); }
+
+	};
+
+	template <typename Y, std::size_t N, std::size_t B>
+	class grid_storage<Y, N, bricked<B>> {
+	public:
+
+		static constexpr bool Bricked = true;
+		static constexpr std::size_t BrickSize = B;
+		static constexpr std::size_t BrickVolume = []() { std::size_t V = 1; for (std::size_t d = 0; d < N; d++) V *= B; return V; }();
+
+		vec<std::size_t, N> 				Count;
+		vec<std::size_t, N> 				BrickCount;
+		Y 									Background;
+		// One slot per brick in the bounding box, null where the brick is background.
+		std::vector<std::unique_ptr<Y[]>> 	Brick;
+		std::size_t 						Occupied;
+
+		grid_storage();
+		grid_storage(const grid_storage& aStorage);
+		grid_storage& operator=(const grid_storage& aStorage);
+		grid_storage(grid_storage&&) = default;
+		grid_storage& operator=(grid_storage&&) = default;
+
+		void create(const vec<std::size_t, N>& aCount, Y aBackground);
+		// Brick and element within the brick holding node aCoordinate.
+		void locate(const std::size_t* aCoordinate, std::size_t& aBrick, std::size_t& aLocal) const;
+		// Node coordinate of element aLocal of brick aBrick, may lie past Count on edge bricks.
+		void coordinate(std::size_t aBrick, std::size_t aLocal, std::size_t* aCoordinate) const;
+		// Node coordinate of flat node index aIndex (axis 0 fastest, as in dense storage).
+		void coordinate(std::size_t aIndex, std::size_t* aCoordinate) const;
+		std::size_t index(const std::size_t* aCoordinate) const;
+
+		Y get(const std::size_t* aCoordinate) const;
+		Y& ref(const std::size_t* aCoordinate);
+		Y get(std::size_t aIndex) const;
+		Y& ref(std::size_t aIndex);
+		Y get(std::size_t aBrick, std::size_t aLocal) const { return Brick[aBrick] ? Brick[aBrick][aLocal] : Background; }
+
+		bool allocated(std::size_t aBrick) const { return (bool)Brick[aBrick]; }
+		// Allocates brick aBrick filled with the background value if it is not present.
+		Y* allocate(std::size_t aBrick);
+		// Releases bricks whose every node equals the background value.
+		void compact();
+		// Bytes of node storage, allocated bricks plus the brick table.
+		std::size_t memory() const { return Occupied * BrickVolume * sizeof(Y) + Brick.size() * sizeof(Brick[0]); }
+
+	};
+
+	// Dense or sparse regular grid over the box [Lower, Upper] with Count nodes per
+	// axis, the tree-side counterpart of math::field<X,N,Y> with the same constructor
+	// shape. Node j on axis d sits at Lower[d] + j * (Upper[d] - Lower[d]) / (Count[d] - 1),
+	// flat node indices vary fastest along axis 0. Sampling is multilinear and clamps
+	// to the box.
+	//
+	// Arithmetic between grids is lazy (see math_expr.h): X + Y * 2 is evaluated in one
+	// pass when assigned to a grid, or point-wise when sampled. Operands on a different
+	// layout than the result are resampled at the result's nodes. A bricked result only
+	// visits bricks that are allocated in at least one same-layout bricked operand.
+	template <typename X, std::size_t N, typename Y, typename P = dense>
+	class grid {
+	public:
+
+		using value_type = Y;
+		using storage = grid_storage<Y, N, P>;
+
+		struct layout {
+			vec<X, N> 				Lower;
+			vec<X, N> 				Upper;
+			vec<std::size_t, N> 	Count;
+
+			std::size_t size() const;
+			// Position of flat node index aIndex.
+			vec<X, N> position(std::size_t aIndex) const;
+			// Position of node aCoordinate.
+			vec<X, N> position(const std::size_t* aCoordinate) const;
+			bool operator==(const layout& aRHS) const;
+		};
+
+		layout 		Layout;
+		storage 	Storage;
+
+		grid();
+		// aValue is every node's initial value, and the background of bricked storage.
+		grid(const vec<X, N>& aLower, const vec<X, N>& aUpper, const vec<std::size_t, N>& aCount, Y aValue);
+		template <typename E> grid(const expression<E>& aExpression);
+		template <typename E> grid& operator=(const expression<E>& aExpression);
+
+		std::size_t size() const;
+		std::size_t memory() const;
+		// Flat node access. The non-const operator allocates the node's brick of a bricked
+		// grid, even when only read, get() reads any grid without allocating.
+		Y& operator[](std::size_t aIndex);
+		Y operator[](std::size_t aIndex) const;
+		Y get(std::size_t aIndex) const;
+
+		// Multilinear interpolation at aPoint.
+		Y operator()(const vec<X, N>& aPoint) const;
+
+		// Samples every point of aPoints into aOut, which must hold aPoints.stride() values.
+		// Dense grid<float,N,float> uses SIMD lanes, bounds and index math are done per lane.
+		void sample(const vec_array<X, N>& aPoints, Y* aOut) const;
+		// As sample(), split into contiguous chunks that run as aJobs tasks. Without a
+		// job_system, or for small batches, it runs on the calling thread.
+		void sample_parallel(const vec_array<X, N>& aPoints, Y* aOut, job_system* aJobs = nullptr) const;
+
+	private:
+
+		void sample_range(const vec_array<X, N>& aPoints, Y* aOut, std::size_t aBegin, std::size_t aEnd) const;
+
+	};
+
+	namespace expr {
+
+		// Position of one element while evaluating into a bricked grid.
+		struct brick_cursor {
+			std::size_t Index;
+			std::size_t Brick;
+			std::size_t Local;
+			std::size_t BrickSize;
+			operator std::size_t() const { return Index; }
+		};
+
+		template <typename X, std::size_t N, typename Y, typename P>
+		struct grid_leaf : expression<grid_leaf<X, N, Y, P>> {
+			using value_type = Y;
+			using storage = typename grid<X, N, Y, P>::storage;
+			using layout_type = typename grid<X, N, Y, P>::layout;
+			const grid<X, N, Y, P>& Value;
+			// Set by prepare() so the layout comparison happens once per evaluation
+			// instead of per element. Direct is set for dense grids on the result layout.
+			mutable bool SameLayout;
+			mutable const Y* Direct;
+			grid_leaf(const grid<X, N, Y, P>& aValue) : Value(aValue), SameLayout(false), Direct(nullptr) {}
+			void prepare(const layout_type& aLayout) const {
+				SameLayout = (aLayout == Value.Layout);
+				if constexpr (!storage::Bricked) Direct = SameLayout ? Value.Storage.Data.data() : nullptr;
+			}
+			Y at(const layout_type& aLayout, std::size_t aIndex) const {
+				if constexpr (!storage::Bricked) { if (Direct != nullptr) return Direct[aIndex]; }
+				else { if (SameLayout) return Value.Storage.get(aIndex); }
+				return Value(aLayout.position(aIndex));
+			}
+			Y at(const layout_type& aLayout, const brick_cursor& aCursor) const {
+				if constexpr (storage::Bricked) {
+					if (SameLayout && (aCursor.BrickSize == storage::BrickSize)) return Value.Storage.get(aCursor.Brick, aCursor.Local);
+				}
+				return this->at(aLayout, aCursor.Index);
+			}
+			bool occupied(std::size_t aBrickSize, std::size_t aBrick) const {
+				if constexpr (storage::Bricked) {
+					if (SameLayout && (aBrickSize == storage::BrickSize)) return Value.Storage.allocated(aBrick);
+				}
+				return true;
+			}
+			Y background() const {
+				if constexpr (storage::Bricked) return Value.Storage.Background;
+				else return Y();
+			}
+			Y sample(const vec<X, N>& aPoint) const { return Value(aPoint); }
+			const layout_type& layout() const { return Value.Layout; }
+		};
+
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	struct operand_traits<grid<X, N, Y, P>> {
+		static constexpr bool Value = true;
+		static expr::grid_leaf<X, N, Y, P> node(const grid<X, N, Y, P>& aGrid) { return expr::grid_leaf<X, N, Y, P>(aGrid); }
+	};
+
+	// ---------- Dense Storage ---------- //
+
+	template <typename Y, std::size_t N>
+	inline void grid_storage<Y, N, dense>::create(const vec<std::size_t, N>& aCount, Y aBackground) {
+		std::size_t Size = 1;
+		for (std::size_t d = 0; d < N; d++) Size *= aCount[d];
+		Count 	= aCount;
+		Data 	= std::vector<Y>(Size, aBackground);
+	}
+
+	template <typename Y, std::size_t N>
+	inline std::size_t grid_storage<Y, N, dense>::index(const std::size_t* aCoordinate) const {
+		std::size_t Index = 0;
+		for (std::size_t d = N; d-- > 0;) Index = Index * Count[d] + aCoordinate[d];
+		return Index;
+	}
+
+	// ---------- Bricked Storage ---------- //
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline grid_storage<Y, N, bricked<B>>::grid_storage() {
+		Background = Y();
+		Occupied = 0;
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline grid_storage<Y, N, bricked<B>>::grid_storage(const grid_storage& aStorage) {
+		*this = aStorage;
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline grid_storage<Y, N, bricked<B>>& grid_storage<Y, N, bricked<B>>::operator=(const grid_storage& aStorage) {
+		if (this == &aStorage) return *this;
+		Count 		= aStorage.Count;
+		BrickCount 	= aStorage.BrickCount;
+		Background 	= aStorage.Background;
+		Occupied 	= aStorage.Occupied;
+		Brick 		= std::vector<std::unique_ptr<Y[]>>(aStorage.Brick.size());
+		for (std::size_t b = 0; b < Brick.size(); b++) {
+			if (!aStorage.Brick[b]) continue;
+			Brick[b] = std::unique_ptr<Y[]>(new Y[BrickVolume]);
+			std::copy(aStorage.Brick[b].get(), aStorage.Brick[b].get() + BrickVolume, Brick[b].get());
+		}
+		return *this;
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline void grid_storage<Y, N, bricked<B>>::create(const vec<std::size_t, N>& aCount, Y aBackground) {
+		std::size_t Total = 1;
+		for (std::size_t d = 0; d < N; d++) {
+			BrickCount[d] = (aCount[d] + B - 1) / B;
+			Total *= BrickCount[d];
+		}
+		Count 		= aCount;
+		Background 	= aBackground;
+		Occupied 	= 0;
+		Brick 		= std::vector<std::unique_ptr<Y[]>>(Total);
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline void grid_storage<Y, N, bricked<B>>::locate(const std::size_t* aCoordinate, std::size_t& aBrick, std::size_t& aLocal) const {
+		aBrick = 0;
+		aLocal = 0;
+		for (std::size_t d = N; d-- > 0;) {
+			aBrick = aBrick * BrickCount[d] + aCoordinate[d] / B;
+			aLocal = aLocal * B + aCoordinate[d] % B;
+		}
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline void grid_storage<Y, N, bricked<B>>::coordinate(std::size_t aBrick, std::size_t aLocal, std::size_t* aCoordinate) const {
+		for (std::size_t d = 0; d < N; d++) {
+			aCoordinate[d] = (aBrick % BrickCount[d]) * B + aLocal % B;
+			aBrick /= BrickCount[d];
+			aLocal /= B;
+		}
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline void grid_storage<Y, N, bricked<B>>::coordinate(std::size_t aIndex, std::size_t* aCoordinate) const {
+		for (std::size_t d = 0; d < N; d++) {
+			aCoordinate[d] = aIndex % Count[d];
+			aIndex /= Count[d];
+		}
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline std::size_t grid_storage<Y, N, bricked<B>>::index(const std::size_t* aCoordinate) const {
+		std::size_t Index = 0;
+		for (std::size_t d = N; d-- > 0;) Index = Index * Count[d] + aCoordinate[d];
+		return Index;
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline Y grid_storage<Y, N, bricked<B>>::get(const std::size_t* aCoordinate) const {
+		std::size_t BrickIndex, Local;
+		this->locate(aCoordinate, BrickIndex, Local);
+		return this->get(BrickIndex, Local);
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline Y& grid_storage<Y, N, bricked<B>>::ref(const std::size_t* aCoordinate) {
+		std::size_t BrickIndex, Local;
+		this->locate(aCoordinate, BrickIndex, Local);
+		return this->allocate(BrickIndex)[Local];
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline Y grid_storage<Y, N, bricked<B>>::get(std::size_t aIndex) const {
+		std::size_t Coordinate[N];
+		this->coordinate(aIndex, Coordinate);
+		return this->get((const std::size_t*)Coordinate);
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline Y& grid_storage<Y, N, bricked<B>>::ref(std::size_t aIndex) {
+		std::size_t Coordinate[N];
+		this->coordinate(aIndex, Coordinate);
+		return this->ref((const std::size_t*)Coordinate);
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline Y* grid_storage<Y, N, bricked<B>>::allocate(std::size_t aBrick) {
+		if (!Brick[aBrick]) {
+			Brick[aBrick] = std::unique_ptr<Y[]>(new Y[BrickVolume]);
+			std::fill(Brick[aBrick].get(), Brick[aBrick].get() + BrickVolume, Background);
+			Occupied++;
+		}
+		return Brick[aBrick].get();
+	}
+
+	template <typename Y, std::size_t N, std::size_t B>
+	inline void grid_storage<Y, N, bricked<B>>::compact() {
+		for (std::unique_ptr<Y[]>& Slot : Brick) {
+			if (!Slot) continue;
+			if (std::all_of(Slot.get(), Slot.get() + BrickVolume, [&](const Y& aValue) { return aValue == Background; })) {
+				Slot.reset();
+				Occupied--;
+			}
+		}
+	}
+
+	// ---------- Grid ---------- //
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline std::size_t grid<X, N, Y, P>::layout::size() const {
+		std::size_t Size = 1;
+		for (std::size_t d = 0; d < N; d++) Size *= Count[d];
+		return Size;
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline vec<X, N> grid<X, N, Y, P>::layout::position(std::size_t aIndex) const {
+		std::size_t Coordinate[N];
+		for (std::size_t d = 0; d < N; d++) {
+			Coordinate[d] = aIndex % Count[d];
+			aIndex /= Count[d];
+		}
+		return this->position((const std::size_t*)Coordinate);
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline vec<X, N> grid<X, N, Y, P>::layout::position(const std::size_t* aCoordinate) const {
+		vec<X, N> Position;
+		for (std::size_t d = 0; d < N; d++) {
+			Position[d] = Count[d] > 1 ? Lower[d] + (Upper[d] - Lower[d]) * X(aCoordinate[d]) / X(Count[d] - 1) : Lower[d];
+		}
+		return Position;
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline bool grid<X, N, Y, P>::layout::operator==(const layout& aRHS) const {
+		for (std::size_t d = 0; d < N; d++) {
+			if ((Lower[d] != aRHS.Lower[d]) || (Upper[d] != aRHS.Upper[d]) || (Count[d] != aRHS.Count[d])) return false;
+		}
+		return true;
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline grid<X, N, Y, P>::grid() {}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline grid<X, N, Y, P>::grid(const vec<X, N>& aLower, const vec<X, N>& aUpper, const vec<std::size_t, N>& aCount, Y aValue) {
+		Layout.Lower 	= aLower;
+		Layout.Upper 	= aUpper;
+		Layout.Count 	= aCount;
+		Storage.create(aCount, aValue);
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	template <typename E>
+	inline grid<X, N, Y, P>::grid(const expression<E>& aExpression) {
+		*this = aExpression;
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	template <typename E>
+	inline grid<X, N, Y, P>& grid<X, N, Y, P>::operator=(const expression<E>& aExpression) {
+		const E& Expression = aExpression.self();
+		// Evaluate into fresh storage, the expression may reference this grid.
+		layout ResultLayout = Expression.layout();
+		Expression.prepare(ResultLayout);
+		storage Result;
+		if constexpr (storage::Bricked) {
+			Result.create(ResultLayout.Count, Expression.background());
+			std::size_t Origin[N], Local[N], Coordinate[N];
+			for (std::size_t b = 0; b < Result.Brick.size(); b++) {
+				// Bricks that are background in every operand stay unallocated.
+				if (!Expression.occupied(storage::BrickSize, b)) continue;
+				Y* Destination = Result.allocate(b);
+				Result.coordinate(b, 0, Origin);
+				// Walk the brick one axis 0 row at a time, clipped to the grid on edge bricks.
+				std::size_t Row = std::min(storage::BrickSize, ResultLayout.Count[0] - Origin[0]);
+				for (std::size_t d = 0; d < N; d++) Local[d] = 0;
+				for (std::size_t l = 0; l < storage::BrickVolume; l += storage::BrickSize) {
+					bool Inside = true;
+					for (std::size_t d = 0; d < N; d++) {
+						Coordinate[d] = Origin[d] + Local[d];
+						Inside &= (Coordinate[d] < ResultLayout.Count[d]);
+					}
+					if (Inside) {
+						std::size_t Index = Result.index(Coordinate);
+						for (std::size_t x = 0; x < Row; x++) {
+							Destination[l + x] = Expression.at(ResultLayout, expr::brick_cursor{ Index + x, b, l + x, storage::BrickSize });
+						}
+					}
+					for (std::size_t d = 1; (d < N) && (++Local[d] == storage::BrickSize); d++) Local[d] = 0;
+				}
+			}
+		}
+		else {
+			Result.create(ResultLayout.Count, Y());
+			for (std::size_t i = 0; i < Result.Data.size(); i++) {
+				Result.Data[i] = Expression.at(ResultLayout, i);
+			}
+		}
+		Layout = ResultLayout;
+		Storage = std::move(Result);
+		return *this;
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline std::size_t grid<X, N, Y, P>::size() const {
+		return Layout.size();
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline std::size_t grid<X, N, Y, P>::memory() const {
+		return Storage.memory();
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline Y& grid<X, N, Y, P>::operator[](std::size_t aIndex) {
+		return Storage.ref(aIndex);
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline Y grid<X, N, Y, P>::operator[](std::size_t aIndex) const {
+		return Storage.get(aIndex);
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline Y grid<X, N, Y, P>::get(std::size_t aIndex) const {
+		return Storage.get(aIndex);
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline Y grid<X, N, Y, P>::operator()(const vec<X, N>& aPoint) const {
+		// An empty grid has no nodes to blend, it reads as its background.
+		if (this->size() == 0) {
+			if constexpr (storage::Bricked) return Storage.Background;
+			else return Y();
+		}
+		std::size_t Base[N];
+		X Fraction[N];
+		for (std::size_t d = 0; d < N; d++) {
+			if (Layout.Count[d] < 2) {
+				Base[d] = 0;
+				Fraction[d] = X(0);
+				continue;
+			}
+			// Clamped in floating point before the cast, NaN goes to the lower edge.
+			X Cell = (aPoint[d] - Layout.Lower[d]) / (Layout.Upper[d] - Layout.Lower[d]) * X(Layout.Count[d] - 1);
+			if (!(Cell > X(0))) Cell = X(0);
+			if (!(Cell < X(Layout.Count[d] - 1))) Cell = X(Layout.Count[d] - 1);
+			Base[d] = std::min((std::size_t)Cell, Layout.Count[d] - 2);
+			Fraction[d] = Cell - X(Base[d]);
+		}
+		// Weighted sum over the 2^N corners of the containing cell.
+		Y Sum = Y();
+		std::size_t Coordinate[N];
+		for (std::size_t Corner = 0; Corner < ((std::size_t)1 << N); Corner++) {
+			X Weight = X(1);
+			for (std::size_t d = 0; d < N; d++) {
+				bool Upper = (Corner >> d) & 1;
+				if (Upper && (Layout.Count[d] < 2)) { Weight = X(0); break; }
+				Weight *= Upper ? Fraction[d] : X(1) - Fraction[d];
+				Coordinate[d] = Base[d] + (Upper ? 1 : 0);
+			}
+			if (Weight != X(0)) Sum = Sum + Storage.get((const std::size_t*)Coordinate) * Weight;
+		}
+		return Sum;
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline void grid<X, N, Y, P>::sample(const vec_array<X, N>& aPoints, Y* aOut) const {
+		this->sample_range(aPoints, aOut, 0, aPoints.stride());
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline void grid<X, N, Y, P>::sample_parallel(const vec_array<X, N>& aPoints, Y* aOut, job_system* aJobs) const {
+		// Below this many points per chunk, scheduling costs more than it saves. Chunk
+		// boundaries stay on the vec_array padding so every chunk is whole lanes.
+		const std::size_t Grain = 4096;
+		static_assert(Grain % vec_array<X, N>::Padding == 0, "sample_parallel() chunks must be whole lanes.");
+		if ((aJobs == nullptr) || (aPoints.stride() <= Grain)) {
+			this->sample_range(aPoints, aOut, 0, aPoints.stride());
+			return;
+		}
+		aJobs->parallel_for(aPoints.stride(), Grain, [&](std::size_t aBegin, std::size_t aEnd) {
+			this->sample_range(aPoints, aOut, aBegin, aEnd);
+		});
+	}
+
+	template <typename X, std::size_t N, typename Y, typename P>
+	inline void grid<X, N, Y, P>::sample_range(const vec_array<X, N>& aPoints, Y* aOut, std::size_t aBegin, std::size_t aEnd) const {
+		if constexpr (std::is_same_v<X, float> && std::is_same_v<Y, float> && !storage::Bricked) {
+			// Empty grids take the scalar path, which returns the background. max() before
+			// min() sends NaN lanes to 0, see lane.
+			if ((Storage.Data.size() > 0) && (Storage.Data.size() <= (std::size_t)std::numeric_limits<int32_t>::max())) {
+				using detail::lane;
+				constexpr std::size_t W = lane::Width;
+				// Per axis constants, axes with a single node collapse to index 0.
+				lane Lower[N], Scale[N], Last[N], MaxBase[N];
+				int32_t Stride[N], UpperStride[N];
+				for (std::size_t d = 0, S = 1; d < N; d++) {
+					bool Flat = (Layout.Count[d] < 2);
+					Lower[d] 		= lane::set(Layout.Lower[d]);
+					Scale[d] 		= lane::set(Flat ? 0.0f : float(Layout.Count[d] - 1) / (Layout.Upper[d] - Layout.Lower[d]));
+					Last[d] 		= lane::set(Flat ? 0.0f : float(Layout.Count[d] - 1));
+					MaxBase[d] 		= lane::set(Flat ? 0.0f : float(Layout.Count[d] - 2));
+					Stride[d] 		= (int32_t)S;
+					UpperStride[d] 	= Flat ? 0 : (int32_t)S;
+					S *= Layout.Count[d];
+				}
+				const float* Value = Storage.Data.data();
+				for (std::size_t i = aBegin; i < aEnd; i += W) {
+					lane Fraction[N];
+					int32_t Offset[W] = {};
+					for (std::size_t d = 0; d < N; d++) {
+						lane Cell = min(max((lane::load(aPoints.component(d) + i) - Lower[d]) * Scale[d], lane::set(0.0f)), Last[d]);
+						lane Base = min(Cell.truncated(), MaxBase[d]);
+						Fraction[d] = Cell - Base;
+						int32_t BaseIndex[W];
+						Base.truncate(BaseIndex);
+						for (std::size_t l = 0; l < W; l++) Offset[l] += BaseIndex[l] * Stride[d];
+					}
+					lane Sum = lane::set(0.0f);
+					for (std::size_t Corner = 0; Corner < ((std::size_t)1 << N); Corner++) {
+						lane Weight = lane::set(1.0f);
+						int32_t CornerOffset = 0;
+						for (std::size_t d = 0; d < N; d++) {
+							bool Upper = (Corner >> d) & 1;
+							Weight = Weight * (Upper ? Fraction[d] : lane::set(1.0f) - Fraction[d]);
+							CornerOffset += Upper ? UpperStride[d] : 0;
+						}
+						int32_t Index[W];
+						for (std::size_t l = 0; l < W; l++) Index[l] = Offset[l] + CornerOffset;
+						Sum = Sum + lane::gather(Value, Index) * Weight;
+					}
+					Sum.store(aOut + i);
+				}
+				return;
+			}
+		}
+		for (std::size_t i = aBegin; i < aEnd; i++) {
+			aOut[i] = (*this)(aPoints.get(i));
+		}
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_GRID_H
@@ -0,0 +1,301 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_JOB_SYSTEM_H
+#define GEODESY_UNIT_TEST_JOB_SYSTEM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy {
+
+	// Dependency graph of frame work, built once and run every frame by a job_system. A
+	// task runs after all of its dependencies finished. A range task splits [0, Count) into
+	// chunks of Grain items that run in parallel, its successors start once every chunk
+	// is done.
+	class task_graph {
+	public:
+
+		using id = std::size_t;
+		using function = std::function<void()>;
+		using range_function = std::function<void(std::size_t, std::size_t)>;
+
+		// Name must be a string literal or profiler::intern result, it labels the trace.
+		id add(const char* aName, function aFunction, const std::vector<id>& aDependency = {});
+		// Calls aFunction(Begin, End) for consecutive chunks covering [0, aCount).
+		id add_range(const char* aName, std::size_t aCount, std::size_t aGrain, range_function aFunction, const std::vector<id>& aDependency = {});
+		std::size_t size() const;
+
+	private:
+
+		friend class job_system;
+
+		struct node {
+			const char* 			Name;
+			range_function 			Function;
+			std::size_t 			Count;
+			std::size_t 			Grain;
+			std::size_t 			ChunkCount;
+			std::vector<node*> 		Successor;
+			std::size_t 			DependencyCount;
+			// Reset at the start of every run.
+			std::atomic<std::size_t> 	Waiting{ 0 }; 		// Unfinished dependencies.
+			std::atomic<std::size_t> 	Pending{ 0 }; 		// Unfinished chunks.
+		};
+
+		std::vector<std::unique_ptr<node>> 	Node;
+
+	};
+
+	// Work stealing scheduler. Each worker owns a deque of ready chunks, it pushes and pops
+	// at the back (newest first, warm caches) and idle workers steal from the front of the
+	// others (oldest first, usually the biggest remaining work). The thread calling run()
+	// works as one of the workers, so a frame's graph uses every core and the frame thread
+	// only waits at the end of the run, which is the frame's barrier. Workers sleep while
+	// no graph is running.
+	//
+	// One graph runs at a time, tasks must not call run() themselves. The first exception
+	// a task throws is rethrown from run() once the graph drained, tasks that did not start
+	// yet are skipped.
+	class job_system {
+	public:
+
+		// aThreadCount counts the calling thread, 0 uses hardware concurrency.
+		job_system(std::size_t aThreadCount = 0);
+		job_system(const job_system&) = delete;
+		job_system& operator=(const job_system&) = delete;
+		~job_system();
+
+		std::size_t thread_count() const;
+		// Runs every task of aGraph and returns when all are done.
+		void run(task_graph& aGraph);
+		// Runs aFunction over [0, aCount) in chunks of aGrain and returns when all are done.
+		void parallel_for(std::size_t aCount, std::size_t aGrain, const task_graph::range_function& aFunction);
+
+	private:
+
+		struct work {
+			task_graph::node* 	Node;
+			std::size_t 		Chunk;
+		};
+
+		// Guarded by a lock per worker, contention only happens on steals.
+		struct queue {
+			std::mutex 			Mutex;
+			std::vector<work> 	Item; 		// Ring buffer, doubled when full.
+			std::size_t 		Front 	= 0;
+			std::size_t 		Count 	= 0;
+
+			void push_back(work aWork);
+			bool pop_back(work& aWork);
+			bool pop_front(work& aWork);
+		};
+
+		std::vector<std::unique_ptr<queue>> 	Queue; 		// Index 0 belongs to the thread in run().
+		std::vector<std::thread> 				Worker;
+		std::mutex 								SleepMutex;
+		std::condition_variable 				Wake;
+		std::atomic<std::size_t> 				Queued; 		// Chunks in all queues.
+		std::atomic<std::size_t> 				Remaining; 		// Unfinished tasks of the running graph.
+		std::atomic<bool> 						Cancel;
+		std::mutex 								ErrorMutex;
+		std::exception_ptr 						Error;
+		std::mutex 								RunMutex;
+		bool 									Stop;
+
+		void worker(std::size_t aIndex);
+		bool execute_one(std::size_t aIndex);
+		void schedule(std::size_t aIndex, task_graph::node* aNode);
+		void finish(std::size_t aIndex, task_graph::node* aNode);
+		void notify(bool aAll);
+
+	};
+
+	// ---------- task_graph ---------- //
+
+	inline task_graph::id task_graph::add(const char* aName, function aFunction, const std::vector<id>& aDependency) {
+		return this->add_range(aName, 1, 1, [F = std::move(aFunction)](std::size_t, std::size_t) { F(); }, aDependency);
+	}
+
+	inline task_graph::id task_graph::add_range(const char* aName, std::size_t aCount, std::size_t aGrain, range_function aFunction, const std::vector<id>& aDependency) {
+		id Id = Node.size();
+		for (id Dependency : aDependency) {
+			if (Dependency >= Id) throw std::invalid_argument("task_graph: dependency on a task not added yet");
+		}
+		std::unique_ptr<node> N = std::make_unique<node>();
+		N->Name 			= aName;
+		N->Function 		= std::move(aFunction);
+		N->Count 			= aCount;
+		N->Grain 			= std::max<std::size_t>(1, aGrain);
+		// An empty range still runs as one chunk so its successors are released in order.
+		N->ChunkCount 		= std::max<std::size_t>(1, (aCount + N->Grain - 1) / N->Grain);
+		N->DependencyCount 	= aDependency.size();
+		for (id Dependency : aDependency) Node[Dependency]->Successor.push_back(N.get());
+		Node.push_back(std::move(N));
+		return Id;
+	}
+
+	inline std::size_t task_graph::size() const {
+		return Node.size();
+	}
+
+	// ---------- job_system::queue ---------- //
+
+	inline void job_system::queue::push_back(work aWork) {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (Count == Item.size()) {
+			// Unroll the ring into a buffer twice the size.
+			std::vector<work> Grown(std::max<std::size_t>(64, Item.size() * 2));
+			for (std::size_t i = 0; i < Count; i++) Grown[i] = Item[(Front + i) % Item.size()];
+			Item.swap(Grown);
+			Front = 0;
+		}
+		Item[(Front + Count) % Item.size()] = aWork;
+		Count++;
+	}
+
+	inline bool job_system::queue::pop_back(work& aWork) {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (Count == 0) return false;
+		Count--;
+		aWork = Item[(Front + Count) % Item.size()];
+		return true;
+	}
+
+	inline bool job_system::queue::pop_front(work& aWork) {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (Count == 0) return false;
+		aWork = Item[Front];
+		Front = (Front + 1) % Item.size();
+		Count--;
+		return true;
+	}
+
+	// ---------- job_system ---------- //
+
+	inline job_system::job_system(std::size_t aThreadCount) {
+		std::size_t ThreadCount = aThreadCount > 0 ? aThreadCount : std::max(1u, std::thread::hardware_concurrency());
+		Queued = 0;
+		Remaining = 0;
+		Cancel = false;
+		Stop = false;
+		for (std::size_t i = 0; i < ThreadCount; i++) Queue.push_back(std::make_unique<queue>());
+		for (std::size_t i = 1; i < ThreadCount; i++) Worker.emplace_back(&job_system::worker, this, i);
+	}
+
+	inline job_system::~job_system() {
+		{
+			std::lock_guard<std::mutex> Lock(SleepMutex);
+			Stop = true;
+		}
+		Wake.notify_all();
+		for (std::thread& Thread : Worker) Thread.join();
+	}
+
+	inline std::size_t job_system::thread_count() const {
+		return Queue.size();
+	}
+
+	inline void job_system::run(task_graph& aGraph) {
+		std::lock_guard<std::mutex> RunLock(RunMutex);
+		if (aGraph.Node.empty()) return;
+		Cancel = false;
+		Error = nullptr;
+		for (const std::unique_ptr<task_graph::node>& N : aGraph.Node) N->Waiting.store(N->DependencyCount, std::memory_order_relaxed);
+		Remaining.store(aGraph.Node.size(), std::memory_order_release);
+		for (const std::unique_ptr<task_graph::node>& N : aGraph.Node) {
+			if (N->DependencyCount == 0) this->schedule(0, N.get());
+		}
+		while (Remaining.load(std::memory_order_acquire) > 0) {
+			if (this->execute_one(0)) continue;
+			std::unique_lock<std::mutex> Lock(SleepMutex);
+			Wake.wait(Lock, [&]() { return (Queued.load() > 0) || (Remaining.load() == 0); });
+		}
+		if (Error) std::rethrow_exception(Error);
+	}
+
+	inline void job_system::parallel_for(std::size_t aCount, std::size_t aGrain, const task_graph::range_function& aFunction) {
+		task_graph Graph;
+		Graph.add_range("parallel_for", aCount, aGrain, aFunction);
+		this->run(Graph);
+	}
+
+	inline void job_system::worker(std::size_t aIndex) {
+		profiler::instance().set_thread_name("job worker " + std::to_string(aIndex));
+		while (true) {
+			if (this->execute_one(aIndex)) continue;
+			std::unique_lock<std::mutex> Lock(SleepMutex);
+			Wake.wait(Lock, [&]() { return Stop || (Queued.load() > 0); });
+			if (Stop) return;
+		}
+	}
+
+	inline bool job_system::execute_one(std::size_t aIndex) {
+		work Work{};
+		bool Found = Queue[aIndex]->pop_back(Work);
+		for (std::size_t i = 1; !Found && (i < Queue.size()); i++) {
+			Found = Queue[(aIndex + i) % Queue.size()]->pop_front(Work);
+		}
+		if (!Found) return false;
+		Queued.fetch_sub(1, std::memory_order_relaxed);
+
+		task_graph::node* N = Work.Node;
+		if (!Cancel.load(std::memory_order_relaxed)) {
+			std::size_t Begin = Work.Chunk * N->Grain;
+			std::size_t End = std::min(N->Count, Begin + N->Grain);
+			try {
+				GEODESY_PROFILE_SCOPE("job", N->Name);
+				N->Function(Begin, End);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> Lock(ErrorMutex);
+				if (!Error) Error = std::current_exception();
+				Cancel = true;
+			}
+		}
+		// The last chunk to finish completes the task.
+		if (N->Pending.fetch_sub(1, std::memory_order_acq_rel) == 1) this->finish(aIndex, N);
+		return true;
+	}
+
+	inline void job_system::schedule(std::size_t aIndex, task_graph::node* aNode) {
+		aNode->Pending.store(aNode->ChunkCount, std::memory_order_relaxed);
+		// Counted before the chunks are published, so a worker that pops one never takes
+		// Queued below the number of chunks actually queued.
+		Queued.fetch_add(aNode->ChunkCount, std::memory_order_release);
+		// Pushed last chunk first so the owner pops them in order, thieves take the tail end.
+		for (std::size_t c = aNode->ChunkCount; c > 0; c--) Queue[aIndex]->push_back({ aNode, c - 1 });
+		this->notify(aNode->ChunkCount > 1);
+	}
+
+	inline void job_system::finish(std::size_t aIndex, task_graph::node* aNode) {
+		// Successors are queued before the count drops, so run() cannot return early.
+		for (task_graph::node* Successor : aNode->Successor) {
+			if (Successor->Waiting.fetch_sub(1, std::memory_order_acq_rel) == 1) this->schedule(aIndex, Successor);
+		}
+		if (Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) this->notify(true);
+	}
+
+	inline void job_system::notify(bool aAll) {
+		// Taking the lock orders this wake after a sleeper's predicate check.
+		{ std::lock_guard<std::mutex> Lock(SleepMutex); }
+		if (aAll) Wake.notify_all();
+		else Wake.notify_one();
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_JOB_SYSTEM_H
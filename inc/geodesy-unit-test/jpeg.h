@@ -0,0 +1,479 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_JPEG_H
+#define GEODESY_UNIT_TEST_JPEG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <geodesy-unit-test/png.h>
+
+namespace geodesy::io {
+
+	namespace detail {
+
+		// Baseline (sequential Huffman, 8 bit) JPEG decoder with any chroma subsampling,
+		// restart intervals and multi-scan files. Progressive, arithmetic coded, lossless
+		// and 12 bit files are rejected.
+		class jpeg_decoder {
+		public:
+
+			jpeg_decoder(const uint8_t* aData, std::size_t aSize);
+			image decode();
+
+		private:
+
+			struct huffman {
+				uint16_t 	Fast[1 << 9]; 			// (Index + 1) into Symbol, 0 when the code is longer.
+				uint8_t 	Symbol[256];
+				uint8_t 	Size[256];
+				int32_t 	MaxCode[18]; 			// Largest code of each length, left aligned to 16 bits.
+				int32_t 	Delta[17]; 				// Symbol index minus code for each length.
+				bool 		Valid = false;
+				void build(const uint8_t* aCount, const uint8_t* aSymbol);
+			};
+
+			struct component {
+				uint8_t 				Id;
+				uint32_t 				H, V;
+				uint32_t 				Quantization;
+				uint32_t 				DCTable, ACTable;
+				int32_t 				Predictor;
+				uint32_t 				BlocksPerLine, BlocksPerColumn;
+				std::vector<uint8_t> 	Plane;
+			};
+
+			const uint8_t* 				Data;
+			std::size_t 				Size;
+			std::size_t 				Position;
+			uint32_t 					Buffer;
+			int32_t 					BitCount;
+			int32_t 					Marker; 		// Marker met inside entropy coded data, -1 when none.
+			uint16_t 					Quantization[4][64];
+			huffman 					DC[4], AC[4];
+			std::vector<component> 		Component;
+			uint32_t 					Width, Height;
+			uint32_t 					HMax, VMax, MCUCountX, MCUCountY;
+			uint32_t 					RestartInterval;
+			int32_t 					AdobeTransform;
+			float 						Basis[8][8];
+
+			uint8_t byte();
+			uint32_t word();
+			uint32_t next_marker();
+			void refill();
+			int32_t decode(const huffman& aCode);
+			int32_t receive(uint32_t aCount);
+			void read_quantization(std::size_t aEnd);
+			void read_huffman(std::size_t aEnd);
+			void read_frame(std::size_t aEnd);
+			void read_scan(std::size_t aEnd);
+			void decode_block(component& aComponent, uint32_t aBlockX, uint32_t aBlockY);
+			void reset();
+			image convert();
+
+		};
+
+		inline void jpeg_decoder::huffman::build(const uint8_t* aCount, const uint8_t* aSymbol) {
+			uint16_t Code[256];
+			uint32_t Index = 0, Next = 0;
+			for (uint32_t l = 1; l <= 16; l++) {
+				Delta[l] = (int32_t)Index - (int32_t)Next;
+				for (uint32_t k = 0; k < aCount[l - 1]; k++) {
+					if (Index >= 256) throw std::runtime_error("jpeg: too many Huffman symbols");
+					Symbol[Index] = aSymbol[Index];
+					Size[Index] = (uint8_t)l;
+					Code[Index++] = (uint16_t)Next++;
+				}
+				if (Next > (1u << l)) throw std::runtime_error("jpeg: invalid Huffman table");
+				MaxCode[l] = (int32_t)(Next << (16 - l));
+				Next <<= 1;
+			}
+			MaxCode[17] = 0x7FFFFFFF;
+			std::memset(Fast, 0, sizeof(Fast));
+			for (uint32_t i = 0; i < Index; i++) {
+				if (Size[i] > 9) continue;
+				uint32_t Shift = 9 - Size[i];
+				for (uint32_t Fill = 0; Fill < (1u << Shift); Fill++) Fast[(Code[i] << Shift) | Fill] = (uint16_t)(i + 1);
+			}
+			Valid = true;
+		}
+
+		inline jpeg_decoder::jpeg_decoder(const uint8_t* aData, std::size_t aSize) {
+			Data = aData;
+			Size = aSize;
+			Position = 0;
+			Buffer = 0;
+			BitCount = 0;
+			Marker = -1;
+			Width = Height = 0;
+			HMax = VMax = MCUCountX = MCUCountY = 0;
+			RestartInterval = 0;
+			AdobeTransform = -1;
+			std::memset(Quantization, 0, sizeof(Quantization));
+			// Basis[x][u] = C(u) / 2 * cos((2x + 1) u pi / 16), the separable IDCT kernel.
+			for (std::size_t x = 0; x < 8; x++) {
+				for (std::size_t u = 0; u < 8; u++) {
+					double C = u == 0 ? std::sqrt(0.5) : 1.0;
+					Basis[x][u] = (float)(0.5 * C * std::cos((2.0 * x + 1.0) * u * 3.14159265358979323846 / 16.0));
+				}
+			}
+		}
+
+		inline uint8_t jpeg_decoder::byte() {
+			if (Position >= Size) throw std::runtime_error("jpeg: unexpected end of data");
+			return Data[Position++];
+		}
+
+		inline uint32_t jpeg_decoder::word() {
+			uint32_t High = this->byte();
+			return (High << 8) | this->byte();
+		}
+
+		inline uint32_t jpeg_decoder::next_marker() {
+			if (Marker >= 0) {
+				uint32_t Pending = (uint32_t)Marker;
+				Marker = -1;
+				return Pending;
+			}
+			// Skips any garbage and fill bytes before the marker.
+			while (this->byte() != 0xFF) {}
+			uint8_t Code = this->byte();
+			while (Code == 0xFF) Code = this->byte();
+			return Code;
+		}
+
+		inline image jpeg_decoder::decode() {
+			if ((Size < 2) || (Data[0] != 0xFF) || (Data[1] != 0xD8)) throw std::runtime_error("jpeg: missing SOI marker");
+			Position = 2;
+			bool Frame = false;
+			while (true) {
+				uint32_t Code = this->next_marker();
+				if (Code == 0xD9) break;
+				if ((Code == 0x01) || ((Code >= 0xD0) && (Code <= 0xD7))) continue;
+				std::size_t Length = this->word();
+				if ((Length < 2) || (Position + Length - 2 > Size)) throw std::runtime_error("jpeg: truncated segment");
+				std::size_t End = Position + Length - 2;
+				switch (Code) {
+				case 0xDB: this->read_quantization(End); break;
+				case 0xC4: this->read_huffman(End); break;
+				case 0xC0: case 0xC1: this->read_frame(End); Frame = true; break;
+				case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7: case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+					throw std::runtime_error("jpeg: only baseline and extended sequential Huffman JPEG is supported");
+				case 0xDD: RestartInterval = this->word(); break;
+				case 0xEE:
+					// Adobe APP14, the transform flag tells RGB from YCbCr for 3 component files.
+					if ((Length >= 14) && (std::memcmp(Data + Position, "Adobe", 5) == 0)) AdobeTransform = Data[Position + 11];
+					break;
+				case 0xDA:
+					if (!Frame) throw std::runtime_error("jpeg: scan before frame header");
+					this->read_scan(End);
+					continue;
+				default: break;
+				}
+				Position = End;
+			}
+			if (!Frame) throw std::runtime_error("jpeg: missing frame header");
+			return this->convert();
+		}
+
+		inline void jpeg_decoder::read_quantization(std::size_t aEnd) {
+			while (Position < aEnd) {
+				uint8_t Info = this->byte();
+				uint32_t Precision = Info >> 4, Table = Info & 15;
+				if (Table > 3) throw std::runtime_error("jpeg: invalid quantization table");
+				for (std::size_t k = 0; k < 64; k++) Quantization[Table][k] = (uint16_t)(Precision ? this->word() : this->byte());
+			}
+		}
+
+		inline void jpeg_decoder::read_huffman(std::size_t aEnd) {
+			while (Position < aEnd) {
+				uint8_t Info = this->byte();
+				uint32_t Class = Info >> 4, Table = Info & 15;
+				if ((Class > 1) || (Table > 3)) throw std::runtime_error("jpeg: invalid Huffman table");
+				uint8_t Count[16];
+				uint32_t Total = 0;
+				for (std::size_t l = 0; l < 16; l++) Total += Count[l] = this->byte();
+				if ((Total > 256) || (Position + Total > aEnd)) throw std::runtime_error("jpeg: invalid Huffman table");
+				(Class == 0 ? DC[Table] : AC[Table]).build(Count, Data + Position);
+				Position += Total;
+			}
+		}
+
+		inline void jpeg_decoder::read_frame(std::size_t aEnd) {
+			if (!Component.empty()) throw std::runtime_error("jpeg: multiple frame headers");
+			if (this->byte() != 8) throw std::runtime_error("jpeg: only 8 bit precision is supported");
+			Height = this->word();
+			Width = this->word();
+			uint32_t Count = this->byte();
+			if ((Width == 0) || (Height == 0)) throw std::runtime_error("jpeg: invalid dimensions");
+			if ((Count != 1) && (Count != 3)) throw std::runtime_error("jpeg: only 1 and 3 component images are supported");
+			if (Position + Count * 3 > aEnd) throw std::runtime_error("jpeg: truncated frame header");
+			Component.resize(Count);
+			HMax = VMax = 1;
+			for (component& C : Component) {
+				C.Id = this->byte();
+				uint8_t Sampling = this->byte();
+				C.H = Sampling >> 4;
+				C.V = Sampling & 15;
+				C.Quantization = this->byte();
+				if ((C.H < 1) || (C.H > 4) || (C.V < 1) || (C.V > 4) || (C.Quantization > 3)) throw std::runtime_error("jpeg: invalid component");
+				C.Predictor = 0;
+				HMax = std::max(HMax, C.H);
+				VMax = std::max(VMax, C.V);
+			}
+			MCUCountX = (Width + 8 * HMax - 1) / (8 * HMax);
+			MCUCountY = (Height + 8 * VMax - 1) / (8 * VMax);
+			for (component& C : Component) {
+				// Planes cover whole MCUs, the padding is cropped at conversion.
+				C.BlocksPerLine = MCUCountX * C.H;
+				C.BlocksPerColumn = MCUCountY * C.V;
+				C.Plane.assign((std::size_t)C.BlocksPerLine * C.BlocksPerColumn * 64, 0);
+			}
+		}
+
+		inline void jpeg_decoder::refill() {
+			while (BitCount <= 24) {
+				uint32_t Byte = 0;
+				if ((Marker < 0) && (Position < Size)) {
+					Byte = Data[Position++];
+					if (Byte == 0xFF) {
+						uint8_t Next = Position < Size ? Data[Position] : 0xD9;
+						while ((Next == 0xFF) && (Position + 1 < Size)) Next = Data[++Position];
+						Position++;
+						if (Next != 0) {
+							// A marker ends the entropy coded segment, feed zeros from here.
+							Marker = Next;
+							Byte = 0;
+						}
+					}
+				}
+				Buffer |= Byte << (24 - BitCount);
+				BitCount += 8;
+			}
+		}
+
+		inline int32_t jpeg_decoder::decode(const huffman& aCode) {
+			if (!aCode.Valid) throw std::runtime_error("jpeg: scan uses an undefined Huffman table");
+			if (BitCount < 16) this->refill();
+			uint32_t Fast = aCode.Fast[Buffer >> 23];
+			if (Fast != 0) {
+				uint32_t Length = aCode.Size[Fast - 1];
+				Buffer <<= Length;
+				BitCount -= (int32_t)Length;
+				return aCode.Symbol[Fast - 1];
+			}
+			int32_t Top = (int32_t)(Buffer >> 16);
+			uint32_t Length = 10;
+			while (Top >= aCode.MaxCode[Length]) Length++;
+			if (Length > 16) throw std::runtime_error("jpeg: invalid Huffman code");
+			int32_t Index = (int32_t)(Buffer >> (32 - Length)) + aCode.Delta[Length];
+			if ((Index < 0) || (Index >= 256)) throw std::runtime_error("jpeg: invalid Huffman code");
+			Buffer <<= Length;
+			BitCount -= (int32_t)Length;
+			return aCode.Symbol[Index];
+		}
+
+		inline int32_t jpeg_decoder::receive(uint32_t aCount) {
+			if (aCount == 0) return 0;
+			if (aCount > 16) throw std::runtime_error("jpeg: invalid coefficient size");
+			if (BitCount < (int32_t)aCount) this->refill();
+			int32_t Value = (int32_t)(Buffer >> (32 - aCount));
+			Buffer <<= aCount;
+			BitCount -= (int32_t)aCount;
+			// Values with a leading zero bit are negative.
+			if (Value < (1 << (aCount - 1))) Value += (int32_t)(~0u << aCount) + 1;
+			return Value;
+		}
+
+		inline void jpeg_decoder::reset() {
+			Buffer = 0;
+			BitCount = 0;
+			Marker = -1;
+			for (component& C : Component) C.Predictor = 0;
+		}
+
+		inline void jpeg_decoder::decode_block(component& aComponent, uint32_t aBlockX, uint32_t aBlockY) {
+			static const uint8_t ZigZag[64] = {
+				 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+				12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+				35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+				58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+			};
+			const uint16_t* Q = Quantization[aComponent.Quantization];
+			float Coefficient[64] = {};
+			int32_t Category = this->decode(DC[aComponent.DCTable]);
+			aComponent.Predictor += this->receive((uint32_t)Category);
+			Coefficient[0] = (float)(aComponent.Predictor * Q[0]);
+			for (uint32_t k = 1; k < 64;) {
+				int32_t RunSize = this->decode(AC[aComponent.ACTable]);
+				uint32_t Run = (uint32_t)RunSize >> 4, Bits = (uint32_t)RunSize & 15;
+				if (Bits == 0) {
+					if (Run != 15) break;
+					k += 16;
+					continue;
+				}
+				k += Run;
+				if (k > 63) throw std::runtime_error("jpeg: coefficient index out of range");
+				Coefficient[ZigZag[k]] = (float)(this->receive(Bits) * Q[k]);
+				k++;
+			}
+
+			// Separable inverse DCT, rows then columns.
+			float Row[64];
+			for (std::size_t v = 0; v < 8; v++) {
+				const float* F = Coefficient + v * 8;
+				for (std::size_t x = 0; x < 8; x++) {
+					float Sum = 0.0f;
+					for (std::size_t u = 0; u < 8; u++) Sum += Basis[x][u] * F[u];
+					Row[v * 8 + x] = Sum;
+				}
+			}
+			uint8_t* Out = aComponent.Plane.data() + ((std::size_t)aBlockY * 8 * aComponent.BlocksPerLine + aBlockX) * 8;
+			std::size_t Stride = (std::size_t)aComponent.BlocksPerLine * 8;
+			for (std::size_t y = 0; y < 8; y++) {
+				for (std::size_t x = 0; x < 8; x++) {
+					float Sum = 128.0f;
+					for (std::size_t v = 0; v < 8; v++) Sum += Basis[y][v] * Row[v * 8 + x];
+					Out[y * Stride + x] = (uint8_t)std::clamp((int32_t)std::lround(Sum), 0, 255);
+				}
+			}
+		}
+
+		inline void jpeg_decoder::read_scan(std::size_t aEnd) {
+			uint32_t Count = this->byte();
+			if ((Count < 1) || (Count > Component.size())) throw std::runtime_error("jpeg: invalid scan");
+			std::vector<component*> Scan;
+			for (uint32_t i = 0; i < Count; i++) {
+				uint8_t Id = this->byte(), Tables = this->byte();
+				component* Match = nullptr;
+				for (component& C : Component) if (C.Id == Id) Match = &C;
+				if (Match == nullptr) throw std::runtime_error("jpeg: scan references an unknown component");
+				Match->DCTable = Tables >> 4;
+				Match->ACTable = Tables & 15;
+				if ((Match->DCTable > 3) || (Match->ACTable > 3)) throw std::runtime_error("jpeg: invalid scan tables");
+				Scan.push_back(Match);
+			}
+			Position = aEnd;
+			this->reset();
+
+			// A single component scan is not interleaved, it covers only that component's
+			// own blocks rather than whole MCUs.
+			uint32_t UnitsX = MCUCountX, UnitsY = MCUCountY;
+			if (Count == 1) {
+				UnitsX = (uint32_t)((((uint64_t)Width * Scan[0]->H + HMax - 1) / HMax + 7) / 8);
+				UnitsY = (uint32_t)((((uint64_t)Height * Scan[0]->V + VMax - 1) / VMax + 7) / 8);
+			}
+			uint32_t Remaining = RestartInterval;
+			for (uint32_t my = 0; my < UnitsY; my++) {
+				for (uint32_t mx = 0; mx < UnitsX; mx++) {
+					if (Count == 1) {
+						this->decode_block(*Scan[0], mx, my);
+					}
+					else {
+						for (component* C : Scan) {
+							for (uint32_t v = 0; v < C->V; v++) {
+								for (uint32_t h = 0; h < C->H; h++) this->decode_block(*C, mx * C->H + h, my * C->V + v);
+							}
+						}
+					}
+					if ((RestartInterval > 0) && (--Remaining == 0) && !((my + 1 == UnitsY) && (mx + 1 == UnitsX))) {
+						// Expect RSTn, then start the next interval from a clean state.
+						if (Marker < 0) {
+							while ((Position + 1 < Size) && !((Data[Position] == 0xFF) && (Data[Position + 1] >= 0xD0) && (Data[Position + 1] <= 0xD7))) Position++;
+							Position += 2;
+						}
+						else if ((Marker < 0xD0) || (Marker > 0xD7)) {
+							throw std::runtime_error("jpeg: missing restart marker");
+						}
+						this->reset();
+						Remaining = RestartInterval;
+					}
+				}
+			}
+			// Leaves Position at the next marker, or Marker holding it when already read.
+			if (Marker < 0) {
+				while ((Position + 1 < Size) && !((Data[Position] == 0xFF) && (Data[Position + 1] != 0) && !((Data[Position + 1] >= 0xD0) && (Data[Position + 1] <= 0xD7)))) Position++;
+			}
+		}
+
+		inline image jpeg_decoder::convert() {
+			image Image;
+			Image.Width = Width;
+			Image.Height = Height;
+			Image.Pixel.resize((std::size_t)Width * Height * 4);
+
+			// Samples each component at full resolution, with linear interpolation between
+			// sample centres for subsampled components (libjpeg's "fancy" upsampling).
+			std::vector<std::vector<uint8_t>> Full(Component.size());
+			for (std::size_t c = 0; c < Component.size(); c++) {
+				const component& C = Component[c];
+				std::size_t Stride = (std::size_t)C.BlocksPerLine * 8;
+				if ((C.H == HMax) && (C.V == VMax)) continue;
+				Full[c].resize((std::size_t)Width * Height);
+				uint32_t PlaneWidth = (uint32_t)(((uint64_t)Width * C.H + HMax - 1) / HMax);
+				uint32_t PlaneHeight = (uint32_t)(((uint64_t)Height * C.V + VMax - 1) / VMax);
+				float SX = (float)C.H / (float)HMax, SY = (float)C.V / (float)VMax;
+				for (uint32_t y = 0; y < Height; y++) {
+					float FY = std::clamp(((float)y + 0.5f) * SY - 0.5f, 0.0f, (float)(PlaneHeight - 1));
+					uint32_t Y0 = (uint32_t)FY, Y1 = std::min(Y0 + 1, PlaneHeight - 1);
+					float WY = FY - (float)Y0;
+					const uint8_t* Row0 = C.Plane.data() + Y0 * Stride;
+					const uint8_t* Row1 = C.Plane.data() + Y1 * Stride;
+					for (uint32_t x = 0; x < Width; x++) {
+						float FX = std::clamp(((float)x + 0.5f) * SX - 0.5f, 0.0f, (float)(PlaneWidth - 1));
+						uint32_t X0 = (uint32_t)FX, X1 = std::min(X0 + 1, PlaneWidth - 1);
+						float WX = FX - (float)X0;
+						float Top = Row0[X0] + (Row0[X1] - Row0[X0]) * WX;
+						float Bottom = Row1[X0] + (Row1[X1] - Row1[X0]) * WX;
+						Full[c][(std::size_t)y * Width + x] = (uint8_t)std::lround(Top + (Bottom - Top) * WY);
+					}
+				}
+			}
+			auto sample = [&](std::size_t aComponent, uint32_t aX, uint32_t aY) -> float {
+				if (!Full[aComponent].empty()) return Full[aComponent][(std::size_t)aY * Width + aX];
+				return Component[aComponent].Plane[(std::size_t)aY * Component[aComponent].BlocksPerLine * 8 + aX];
+			};
+
+			bool YCbCr = (Component.size() == 3) && (AdobeTransform != 0);
+			for (uint32_t y = 0; y < Height; y++) {
+				uint8_t* Out = Image.Pixel.data() + (std::size_t)y * Width * 4;
+				for (uint32_t x = 0; x < Width; x++, Out += 4) {
+					if (Component.size() == 1) {
+						Out[0] = Out[1] = Out[2] = (uint8_t)sample(0, x, y);
+					}
+					else if (YCbCr) {
+						float L = sample(0, x, y), Cb = sample(1, x, y) - 128.0f, Cr = sample(2, x, y) - 128.0f;
+						Out[0] = (uint8_t)std::clamp((int32_t)std::lround(L + 1.402f * Cr), 0, 255);
+						Out[1] = (uint8_t)std::clamp((int32_t)std::lround(L - 0.344136f * Cb - 0.714136f * Cr), 0, 255);
+						Out[2] = (uint8_t)std::clamp((int32_t)std::lround(L + 1.772f * Cb), 0, 255);
+					}
+					else {
+						Out[0] = (uint8_t)sample(0, x, y); Out[1] = (uint8_t)sample(1, x, y); Out[2] = (uint8_t)sample(2, x, y);
+					}
+					Out[3] = 255;
+				}
+			}
+			return Image;
+		}
+
+	}
+
+	// True when aData starts with a JPEG SOI marker.
+	inline bool is_jpeg(const uint8_t* aData, std::size_t aSize) {
+		return (aSize >= 3) && (aData[0] == 0xFF) && (aData[1] == 0xD8) && (aData[2] == 0xFF);
+	}
+
+	// Decodes a baseline JPEG to RGBA8 (alpha 255).
+	inline image decode_jpeg(const uint8_t* aData, std::size_t aSize) {
+		return detail::jpeg_decoder(aData, aSize).decode();
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_JPEG_H
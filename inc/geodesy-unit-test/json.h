@@ -0,0 +1,285 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_JSON_H
+#define GEODESY_UNIT_TEST_JSON_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+namespace geodesy::io {
+
+	// JSON document tree (RFC 8259) with the same lookup interface as yaml, used for glTF.
+	// Errors throw std::runtime_error with the byte offset of the problem.
+	class json {
+	public:
+
+		enum kind { NONE, NULL_VALUE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+		kind 										Kind;
+		bool 										Boolean;
+		double 										Number;
+		std::string 								String;
+		std::vector<json> 							Item;
+		std::vector<std::pair<std::string, json>> 	Member;
+
+		json();
+
+		static json parse(std::string_view aText);
+
+		// Member lookup, a missing key yields a NONE node so lookups can be chained.
+		const json& operator[](const std::string& aKey) const;
+		const json& operator[](std::size_t aIndex) const;
+		bool has(const std::string& aKey) const;
+		// Items of an array or members of an object.
+		std::size_t size() const;
+
+		bool is_none() const { return Kind == NONE; }
+		std::string as_string(const std::string& aDefault = "") const;
+		double as_double(double aDefault = 0.0) const;
+		int64_t as_int(int64_t aDefault = 0) const;
+		// A negative, fractional or out of range number yields SIZE_MAX, never the default.
+		std::size_t as_index(std::size_t aDefault = SIZE_MAX) const;
+		bool as_bool(bool aDefault = false) const;
+
+	private:
+
+		struct parser {
+			std::string_view 	Text;
+			std::size_t 		Offset;
+			[[noreturn]] void fail(const std::string& aMessage) const;
+			void skip();
+			char peek();
+			void expect(char aCharacter);
+			json value(int aDepth);
+			std::string string();
+			void append_utf8(std::string& aOut, uint32_t aCode);
+			uint32_t hex4();
+		};
+
+		static const json& none();
+
+	};
+
+	inline json::json() {
+		Kind = NONE;
+		Boolean = false;
+		Number = 0.0;
+	}
+
+	inline json json::parse(std::string_view aText) {
+		parser Parser{ aText, 0 };
+		// Byte order mark.
+		if (aText.substr(0, 3) == "\xEF\xBB\xBF") Parser.Offset = 3;
+		json Root = Parser.value(0);
+		Parser.skip();
+		if (Parser.Offset != aText.size()) Parser.fail("trailing characters");
+		return Root;
+	}
+
+	inline const json& json::operator[](const std::string& aKey) const {
+		for (const std::pair<std::string, json>& M : Member) if (M.first == aKey) return M.second;
+		return none();
+	}
+
+	inline const json& json::operator[](std::size_t aIndex) const {
+		return aIndex < Item.size() ? Item[aIndex] : none();
+	}
+
+	inline bool json::has(const std::string& aKey) const {
+		for (const std::pair<std::string, json>& M : Member) if (M.first == aKey) return true;
+		return false;
+	}
+
+	inline std::size_t json::size() const {
+		return Kind == OBJECT ? Member.size() : Item.size();
+	}
+
+	inline std::string json::as_string(const std::string& aDefault) const {
+		return Kind == STRING ? String : aDefault;
+	}
+
+	inline double json::as_double(double aDefault) const {
+		return Kind == NUMBER ? Number : aDefault;
+	}
+
+	inline int64_t json::as_int(int64_t aDefault) const {
+		return Kind == NUMBER ? (int64_t)Number : aDefault;
+	}
+
+	inline std::size_t json::as_index(std::size_t aDefault) const {
+		if (Kind != NUMBER) return aDefault;
+		// 2^64 (or 2^32) is exact as a double, so anything below it converts without overflow.
+		const double Limit = (double)(SIZE_MAX / 2 + 1) * 2.0;
+		if (!(Number >= 0.0) || !(Number < Limit) || (std::floor(Number) != Number)) return SIZE_MAX;
+		return (std::size_t)Number;
+	}
+
+	inline bool json::as_bool(bool aDefault) const {
+		return Kind == BOOLEAN ? Boolean : aDefault;
+	}
+
+	inline const json& json::none() {
+		static const json None;
+		return None;
+	}
+
+	// ---------- parser ---------- //
+
+	inline void json::parser::fail(const std::string& aMessage) const {
+		throw std::runtime_error("json: offset " + std::to_string(Offset) + ": " + aMessage);
+	}
+
+	inline void json::parser::skip() {
+		while ((Offset < Text.size()) && ((Text[Offset] == ' ') || (Text[Offset] == '\t') || (Text[Offset] == '\n') || (Text[Offset] == '\r'))) Offset++;
+	}
+
+	inline char json::parser::peek() {
+		this->skip();
+		if (Offset >= Text.size()) this->fail("unexpected end of input");
+		return Text[Offset];
+	}
+
+	inline void json::parser::expect(char aCharacter) {
+		if (this->peek() != aCharacter) this->fail(std::string("expected '") + aCharacter + "'");
+		Offset++;
+	}
+
+	inline json json::parser::value(int aDepth) {
+		// Guards the recursion against hostile nesting.
+		if (aDepth > 256) this->fail("nesting too deep");
+		json Node;
+		char C = this->peek();
+		if (C == '{') {
+			Offset++;
+			Node.Kind = OBJECT;
+			if (this->peek() == '}') { Offset++; return Node; }
+			while (true) {
+				if (this->peek() != '"') this->fail("expected member name");
+				std::string Key = this->string();
+				this->expect(':');
+				Node.Member.emplace_back(std::move(Key), this->value(aDepth + 1));
+				char Next = this->peek();
+				Offset++;
+				if (Next == '}') break;
+				if (Next != ',') { Offset--; this->fail("expected ',' or '}'"); }
+			}
+		}
+		else if (C == '[') {
+			Offset++;
+			Node.Kind = ARRAY;
+			if (this->peek() == ']') { Offset++; return Node; }
+			while (true) {
+				Node.Item.push_back(this->value(aDepth + 1));
+				char Next = this->peek();
+				Offset++;
+				if (Next == ']') break;
+				if (Next != ',') { Offset--; this->fail("expected ',' or ']'"); }
+			}
+		}
+		else if (C == '"') {
+			Node.Kind = STRING;
+			Node.String = this->string();
+		}
+		else if (Text.compare(Offset, 4, "true") == 0) { Offset += 4; Node.Kind = BOOLEAN; Node.Boolean = true; }
+		else if (Text.compare(Offset, 5, "false") == 0) { Offset += 5; Node.Kind = BOOLEAN; Node.Boolean = false; }
+		else if (Text.compare(Offset, 4, "null") == 0) { Offset += 4; Node.Kind = NULL_VALUE; }
+		else if ((C == '-') || ((C >= '0') && (C <= '9'))) {
+			std::size_t Start = Offset;
+			if (Text[Offset] == '-') Offset++;
+			while ((Offset < Text.size()) && (((Text[Offset] >= '0') && (Text[Offset] <= '9')) || (Text[Offset] == '.') || (Text[Offset] == 'e') || (Text[Offset] == 'E') || (Text[Offset] == '+') || (Text[Offset] == '-'))) Offset++;
+			std::string Number(Text.substr(Start, Offset - Start));
+			char* End = nullptr;
+			Node.Kind = NUMBER;
+			Node.Number = std::strtod(Number.c_str(), &End);
+			if ((End == nullptr) || (*End != '\0')) { Offset = Start; this->fail("malformed number"); }
+		}
+		else {
+			this->fail("unexpected character");
+		}
+		return Node;
+	}
+
+	inline std::string json::parser::string() {
+		Offset++;
+		std::string Result;
+		while (true) {
+			if (Offset >= Text.size()) this->fail("unterminated string");
+			char C = Text[Offset++];
+			if (C == '"') break;
+			if ((unsigned char)C < 0x20) { Offset--; this->fail("control character in string"); }
+			if (C != '\\') { Result += C; continue; }
+			if (Offset >= Text.size()) this->fail("unterminated escape");
+			char Escape = Text[Offset++];
+			switch (Escape) {
+			case '"': Result += '"'; break;
+			case '\\': Result += '\\'; break;
+			case '/': Result += '/'; break;
+			case 'b': Result += '\b'; break;
+			case 'f': Result += '\f'; break;
+			case 'n': Result += '\n'; break;
+			case 'r': Result += '\r'; break;
+			case 't': Result += '\t'; break;
+			case 'u': {
+				uint32_t Code = this->hex4();
+				// Surrogate pair.
+				if ((Code >= 0xD800) && (Code < 0xDC00) && (Text.compare(Offset, 2, "\\u") == 0)) {
+					Offset += 2;
+					uint32_t Low = this->hex4();
+					if ((Low < 0xDC00) || (Low >= 0xE000)) this->fail("invalid surrogate pair");
+					Code = 0x10000 + ((Code - 0xD800) << 10) + (Low - 0xDC00);
+				}
+				this->append_utf8(Result, Code);
+				break;
+			}
+			default:
+				Offset--;
+				this->fail("invalid escape");
+			}
+		}
+		return Result;
+	}
+
+	inline void json::parser::append_utf8(std::string& aOut, uint32_t aCode) {
+		if (aCode < 0x80) {
+			aOut += (char)aCode;
+		}
+		else if (aCode < 0x800) {
+			aOut += (char)(0xC0 | (aCode >> 6));
+			aOut += (char)(0x80 | (aCode & 0x3F));
+		}
+		else if (aCode < 0x10000) {
+			aOut += (char)(0xE0 | (aCode >> 12));
+			aOut += (char)(0x80 | ((aCode >> 6) & 0x3F));
+			aOut += (char)(0x80 | (aCode & 0x3F));
+		}
+		else {
+			aOut += (char)(0xF0 | (aCode >> 18));
+			aOut += (char)(0x80 | ((aCode >> 12) & 0x3F));
+			aOut += (char)(0x80 | ((aCode >> 6) & 0x3F));
+			aOut += (char)(0x80 | (aCode & 0x3F));
+		}
+	}
+
+	inline uint32_t json::parser::hex4() {
+		if (Offset + 4 > Text.size()) this->fail("truncated \\u escape");
+		uint32_t Code = 0;
+		for (std::size_t i = 0; i < 4; i++) {
+			char C = Text[Offset++];
+			Code <<= 4;
+			if ((C >= '0') && (C <= '9')) Code |= (uint32_t)(C - '0');
+			else if ((C >= 'a') && (C <= 'f')) Code |= (uint32_t)(C - 'a' + 10);
+			else if ((C >= 'A') && (C <= 'F')) Code |= (uint32_t)(C - 'A' + 10);
+			else { Offset--; this->fail("invalid hex digit"); }
+		}
+		return Code;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_JSON_H
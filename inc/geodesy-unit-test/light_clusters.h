@@ -0,0 +1,389 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_LIGHT_CLUSTERS_H
+#define GEODESY_UNIT_TEST_LIGHT_CLUSTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/math_simd.h>
+#include <geodesy-unit-test/vec_array.h>
+#include <geodesy-unit-test/job_system.h>
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy {
+
+	// A point or spot light as seen by the culling pass, shading data stays with the caller
+	// and is found through the light's index in the list given to light_clusters::build().
+	struct cluster_light {
+		math::vec<float, 3> 	Position;
+		float 					Range 		= 1.0f; 		// [m] Distance at which the light no longer contributes.
+		math::vec<float, 3> 	Direction 	= { 0.0f, 0.0f, -1.0f };
+		float 					Angle 		= 0.0f; 		// [deg] Spot cone half angle, 0 for a point light.
+	};
+
+	// Froxel grid over a symmetric perspective view frustum. Tiles split the screen evenly,
+	// slices split depth exponentially so clusters stay roughly cube shaped.
+	struct cluster_grid {
+		uint32_t 	TilesX 		= 16;
+		uint32_t 	TilesY 		= 9;
+		uint32_t 	Slices 		= 24;
+		float 		FieldOfView = 70.0f; 			// [deg] Vertical.
+		float 		AspectRatio = 16.0f / 9.0f; 	// Width over height.
+		float 		Near 		= 0.1f; 			// [m]
+		float 		Far 		= 500.0f; 			// [m]
+	};
+
+	// CPU light assignment for clustered shading. build() bins a frame's lights into the
+	// froxel grid of a camera and produces compact per cluster index lists, offsets() and
+	// indices(), ready to upload in place of a fixed size light array. A fragment then
+	// only evaluates the lights of its own cluster.
+	//
+	// Lights are bounded by spheres. Their view space centres are transformed in one batch
+	// and tested against every tile plane a SIMD register of lights at a time, which culls
+	// lights outside the frustum and gives each remaining light its range of tiles. Each
+	// depth slice then narrows the range to the part of the sphere inside the slice. View
+	// space is right handed looking down -z, tile rows run along +y.
+	//
+	// Given a job_system the light tests run in chunks of lights and the binning in chunks
+	// of slices. Every cluster lists its lights in ascending order whatever the thread count.
+	class light_clusters {
+	public:
+
+		static constexpr uint32_t None = UINT32_MAX;
+
+		struct statistics {
+			std::size_t 	Visible 	= 0; 		// Lights in at least one cluster.
+			std::size_t 	Assigned 	= 0; 		// Entries of indices().
+			std::size_t 	Largest 	= 0; 		// Lights in the fullest cluster.
+		};
+
+		light_clusters(const cluster_grid& aGrid = cluster_grid());
+
+		const cluster_grid& grid() const;
+		std::size_t cluster_count() const;
+		uint32_t cluster(uint32_t aX, uint32_t aY, uint32_t aSlice) const;
+		// Cluster holding a view space position, None outside the grid.
+		uint32_t cluster(const math::vec<float, 3>& aViewPosition) const;
+
+		// Assigns aLights to clusters for a camera with view matrix aView.
+		void build(const math::mat<float, 4, 4>& aView, const std::vector<cluster_light>& aLights, job_system* aJobs = nullptr);
+
+		// Lights of cluster c are indices()[offsets()[c]] to indices()[offsets()[c + 1] - 1].
+		const std::vector<uint32_t>& offsets() const;
+		const std::vector<uint32_t>& indices() const;
+		const statistics& stats() const;
+
+	private:
+
+		static constexpr std::size_t LightGrain = 256; 		// Lights per culling job, a multiple of every SIMD width.
+
+		// Tiles and slices a light's sphere touches, X0 > X1 when it is culled.
+		struct extent {
+			int32_t 	X0, X1;
+			int32_t 	Y0, Y1;
+			int32_t 	Z0, Z1;
+		};
+
+		// A light's tile range within one slice.
+		struct span {
+			uint32_t 	Light;
+			int32_t 	X0, X1;
+			int32_t 	Y0, Y1;
+		};
+
+		cluster_grid 					Grid;
+		std::vector<float> 				TangentX; 		// Tile planes x = t * depth, TilesX + 1.
+		std::vector<float> 				TangentY;
+		std::vector<float> 				ScaleX; 		// 1 / sqrt(1 + t^2), plane normal length.
+		std::vector<float> 				ScaleY;
+		std::vector<float> 				SliceDepth; 	// Slices + 1 boundaries from Near to Far.
+
+		std::vector<uint32_t> 			Offset;
+		std::vector<uint32_t> 			Index;
+		statistics 						Stats;
+		// Scratch kept between frames.
+		math::vec_array<float, 3> 		Center;
+		math::vec_array<float, 3> 		ViewCenter;
+		std::vector<float> 				Radius;
+		std::vector<extent> 			Extent;
+		std::vector<uint32_t> 			Visible;
+		std::vector<std::vector<span>> 	SliceSpan;
+		std::vector<int32_t> 			SliceEdge; 		// Per slice and tile row, span starts minus span ends.
+		std::vector<uint32_t> 			Fill;
+
+		void run(job_system* aJobs, std::size_t aCount, std::size_t aGrain, const task_graph::range_function& aFunction);
+		void cull(std::size_t aBegin, std::size_t aEnd);
+		void bin(uint32_t aSlice);
+		// First and last tile of a sphere along one screen axis, by plane counting.
+		static void tile_range(float aCoordinate, float aDepth, float aRadius, const std::vector<float>& aTangent, const std::vector<float>& aScale, int32_t& aFirst, int32_t& aLast);
+		uint32_t slice_of(float aDepth) const;
+
+	};
+
+	// ---------- light_clusters ---------- //
+
+	inline light_clusters::light_clusters(const cluster_grid& aGrid) {
+		if ((aGrid.TilesX == 0) || (aGrid.TilesY == 0) || (aGrid.Slices == 0)) throw std::invalid_argument("light_clusters: empty grid");
+		if (!(aGrid.Near > 0.0f) || !(aGrid.Far > aGrid.Near) || !(aGrid.FieldOfView > 0.0f) || !(aGrid.FieldOfView < 180.0f) || !(aGrid.AspectRatio > 0.0f)) throw std::invalid_argument("light_clusters: invalid frustum");
+		Grid = aGrid;
+		float HalfY = std::tan(Grid.FieldOfView * 3.14159265358979f / 360.0f);
+		float HalfX = HalfY * Grid.AspectRatio;
+		for (uint32_t i = 0; i <= Grid.TilesX; i++) {
+			TangentX.push_back(HalfX * (-1.0f + 2.0f * (float)i / (float)Grid.TilesX));
+			ScaleX.push_back(1.0f / std::sqrt(1.0f + TangentX.back() * TangentX.back()));
+		}
+		for (uint32_t i = 0; i <= Grid.TilesY; i++) {
+			TangentY.push_back(HalfY * (-1.0f + 2.0f * (float)i / (float)Grid.TilesY));
+			ScaleY.push_back(1.0f / std::sqrt(1.0f + TangentY.back() * TangentY.back()));
+		}
+		for (uint32_t i = 0; i <= Grid.Slices; i++) {
+			SliceDepth.push_back(Grid.Near * std::pow(Grid.Far / Grid.Near, (float)i / (float)Grid.Slices));
+		}
+		SliceDepth.back() = Grid.Far;
+		Offset.assign(this->cluster_count() + 1, 0);
+		SliceEdge.assign((std::size_t)Grid.Slices * Grid.TilesY * (Grid.TilesX + 1), 0);
+	}
+
+	inline const cluster_grid& light_clusters::grid() const {
+		return Grid;
+	}
+
+	inline std::size_t light_clusters::cluster_count() const {
+		return (std::size_t)Grid.TilesX * Grid.TilesY * Grid.Slices;
+	}
+
+	inline uint32_t light_clusters::cluster(uint32_t aX, uint32_t aY, uint32_t aSlice) const {
+		return (aSlice * Grid.TilesY + aY) * Grid.TilesX + aX;
+	}
+
+	inline uint32_t light_clusters::cluster(const math::vec<float, 3>& aViewPosition) const {
+		float Depth = -aViewPosition[2];
+		if ((Depth < Grid.Near) || (Depth >= Grid.Far)) return None;
+		// Tile i holds t[i] <= x / depth < t[i + 1], as the plane tests in cull() see it.
+		auto tile = [&](float aCoordinate, const std::vector<float>& aTangent) -> uint32_t {
+			float T = aCoordinate / Depth;
+			if ((T < aTangent.front()) || (T >= aTangent.back())) return None;
+			return (uint32_t)(std::upper_bound(aTangent.begin(), aTangent.end(), T) - aTangent.begin()) - 1;
+		};
+		uint32_t X = tile(aViewPosition[0], TangentX);
+		uint32_t Y = tile(aViewPosition[1], TangentY);
+		if ((X == None) || (Y == None)) return None;
+		return this->cluster(X, Y, this->slice_of(Depth));
+	}
+
+	inline void light_clusters::build(const math::mat<float, 4, 4>& aView, const std::vector<cluster_light>& aLights, job_system* aJobs) {
+		GEODESY_PROFILE_SCOPE("light", "build");
+		std::size_t LightCount = aLights.size();
+		// Bounding spheres in world space, a spot cone is bounded by the smallest sphere
+		// through its apex and rim, or by its base disc's sphere for wide cones.
+		Center.resize(LightCount);
+		Radius.assign(Center.stride(), 0.0f);
+		for (std::size_t i = 0; i < LightCount; i++) {
+			const cluster_light& L = aLights[i];
+			math::vec<float, 3> C = L.Position;
+			float R = std::max(L.Range, 0.0f);
+			if ((L.Angle > 0.0f) && (L.Angle < 90.0f)) {
+				math::vec<float, 3> D = L.Direction;
+				float Length = std::sqrt(D[0] * D[0] + D[1] * D[1] + D[2] * D[2]);
+				if (Length > 0.0f) {
+					float A = L.Angle * 3.14159265358979f / 180.0f;
+					float Along = A > 0.785398163f ? std::cos(A) * R : 0.5f * R / std::cos(A);
+					R = A > 0.785398163f ? std::sin(A) * R : Along;
+					for (std::size_t k = 0; k < 3; k++) C[k] += D[k] / Length * Along;
+				}
+			}
+			Center.set(i, C);
+			Radius[i] = R;
+		}
+		math::batch::transform_points(aView, Center, ViewCenter);
+
+		Extent.resize(LightCount);
+		{
+			GEODESY_PROFILE_SCOPE("light", "cull");
+			this->run(aJobs, LightCount, LightGrain, [&](std::size_t aBegin, std::size_t aEnd) {
+				this->cull(aBegin, aEnd);
+			});
+		}
+		Visible.clear();
+		for (std::size_t i = 0; i < LightCount; i++) {
+			if (Extent[i].X0 <= Extent[i].X1) Visible.push_back((uint32_t)i);
+		}
+
+		// Count per cluster while collecting each slice's spans, then lay the lists out
+		// back to back and fill them from the same spans.
+		GEODESY_PROFILE_SCOPE("light", "bin");
+		SliceSpan.resize(Grid.Slices);
+		this->run(aJobs, Grid.Slices, 1, [&](std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t s = aBegin; s < aEnd; s++) this->bin((uint32_t)s);
+		});
+		uint32_t Total = 0;
+		Stats.Largest = 0;
+		for (std::size_t c = 0; c < this->cluster_count(); c++) {
+			uint32_t Count = Offset[c];
+			Offset[c] = Total;
+			Total += Count;
+			Stats.Largest = std::max(Stats.Largest, (std::size_t)Count);
+		}
+		Offset.back() = Total;
+		Index.resize(Total);
+		Fill.assign(Offset.begin(), Offset.end() - 1);
+		this->run(aJobs, Grid.Slices, 1, [&](std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t s = aBegin; s < aEnd; s++) {
+				uint32_t* Out = Index.data();
+				for (const span& Span : SliceSpan[s]) {
+					for (int32_t y = Span.Y0; y <= Span.Y1; y++) {
+						uint32_t* Cursor = &Fill[this->cluster(0, (uint32_t)y, (uint32_t)s)];
+						for (int32_t x = Span.X0; x <= Span.X1; x++) Out[Cursor[x]++] = Span.Light;
+					}
+				}
+			}
+		});
+		Stats.Visible = Visible.size();
+		Stats.Assigned = Total;
+	}
+
+	inline const std::vector<uint32_t>& light_clusters::offsets() const {
+		return Offset;
+	}
+
+	inline const std::vector<uint32_t>& light_clusters::indices() const {
+		return Index;
+	}
+
+	inline const light_clusters::statistics& light_clusters::stats() const {
+		return Stats;
+	}
+
+	inline void light_clusters::run(job_system* aJobs, std::size_t aCount, std::size_t aGrain, const task_graph::range_function& aFunction) {
+		if ((aJobs == nullptr) || (aCount <= aGrain)) {
+			if (aCount > 0) aFunction(0, aCount);
+			return;
+		}
+		aJobs->parallel_for(aCount, aGrain, aFunction);
+	}
+
+	inline void light_clusters::cull(std::size_t aBegin, std::size_t aEnd) {
+		using lane = math::detail::lane;
+		const float* X = ViewCenter.component(0);
+		const float* Y = ViewCenter.component(1);
+		const float* Z = ViewCenter.component(2);
+		// A sphere with its centre in front of the camera is entirely right of the first
+		// planes and entirely left of the last ones. Counting the planes it is not left of
+		// (Inside) and the planes it is right of (Right) gives its first and last tile.
+		auto count = [&](lane aCoordinate, lane aDepth, lane aRadius, const std::vector<float>& aTangent, const std::vector<float>& aScale, float* aInside, float* aRight) {
+			lane Zero = lane::set(0.0f), One = lane::set(1.0f);
+			lane Inside = Zero, Right = Zero;
+			for (std::size_t p = 0; p < aTangent.size(); p++) {
+				lane Distance = (aCoordinate - lane::set(aTangent[p]) * aDepth) * lane::set(aScale[p]);
+				Inside = Inside + select_positive(Distance + aRadius, Zero, One);
+				Right = Right + select_positive(Distance - aRadius, Zero, One);
+			}
+			Inside.lanes(aInside);
+			Right.lanes(aRight);
+		};
+		float InsideX[lane::Width], RightX[lane::Width], InsideY[lane::Width], RightY[lane::Width];
+		// aBegin is a multiple of LightGrain, so whole lanes stay inside the padded arrays.
+		for (std::size_t i = aBegin; i < aEnd; i += lane::Width) {
+			lane Depth = lane::set(0.0f) - lane::load(Z + i);
+			lane R = lane::load(Radius.data() + i);
+			count(lane::load(X + i), Depth, R, TangentX, ScaleX, InsideX, RightX);
+			count(lane::load(Y + i), Depth, R, TangentY, ScaleY, InsideY, RightY);
+			for (std::size_t l = 0; (l < lane::Width) && (i + l < aEnd); l++) {
+				extent& E = Extent[i + l];
+				float D = -Z[i + l], Rl = Radius[i + l];
+				E = { 0, -1, 0, -1, 0, -1 };
+				if ((Rl <= 0.0f) || (D + Rl <= Grid.Near) || (D - Rl >= Grid.Far)) continue;
+				if (D > Rl) {
+					E.X0 = std::max((int32_t)RightX[l] - 1, 0);
+					E.X1 = std::min((int32_t)InsideX[l] - 1, (int32_t)Grid.TilesX - 1);
+					E.Y0 = std::max((int32_t)RightY[l] - 1, 0);
+					E.Y1 = std::min((int32_t)InsideY[l] - 1, (int32_t)Grid.TilesY - 1);
+				}
+				else {
+					// Reaching the eye plane, every tile may see it.
+					E.X1 = (int32_t)Grid.TilesX - 1;
+					E.Y1 = (int32_t)Grid.TilesY - 1;
+				}
+				if ((E.X0 > E.X1) || (E.Y0 > E.Y1)) {
+					E = { 0, -1, 0, -1, 0, -1 };
+					continue;
+				}
+				E.Z0 = (int32_t)this->slice_of(std::max(D - Rl, Grid.Near));
+				E.Z1 = (int32_t)this->slice_of(std::min(D + Rl, Grid.Far));
+			}
+		}
+	}
+
+	inline void light_clusters::bin(uint32_t aSlice) {
+		std::vector<span>& Spans = SliceSpan[aSlice];
+		Spans.clear();
+		const float* X = ViewCenter.component(0);
+		const float* Y = ViewCenter.component(1);
+		const float* Z = ViewCenter.component(2);
+		float Front = SliceDepth[aSlice], Back = SliceDepth[aSlice + 1];
+		int32_t Width = (int32_t)Grid.TilesX + 1;
+		int32_t* Edge = &SliceEdge[(std::size_t)aSlice * Grid.TilesY * Width];
+		std::fill(Edge, Edge + Grid.TilesY * Width, 0);
+		for (uint32_t Light : Visible) {
+			const extent& E = Extent[Light];
+			if (((int32_t)aSlice < E.Z0) || ((int32_t)aSlice > E.Z1)) continue;
+			span Span{ Light, E.X0, E.X1, E.Y0, E.Y1 };
+			// The part of the sphere inside the slice lies in the smaller sphere around its
+			// cross section on the nearest slice face.
+			float D = -Z[Light], R = Radius[Light];
+			float Face = std::min(std::max(D, Front), Back);
+			if ((Face != D) && (Face > 0.0f)) {
+				float Cut = std::sqrt(std::max(R * R - (Face - D) * (Face - D), 0.0f));
+				if (Face > Cut) {
+					int32_t X0, X1, Y0, Y1;
+					tile_range(X[Light], Face, Cut, TangentX, ScaleX, X0, X1);
+					tile_range(Y[Light], Face, Cut, TangentY, ScaleY, Y0, Y1);
+					Span.X0 = std::max(Span.X0, X0);
+					Span.X1 = std::min(Span.X1, X1);
+					Span.Y0 = std::max(Span.Y0, Y0);
+					Span.Y1 = std::min(Span.Y1, Y1);
+					if ((Span.X0 > Span.X1) || (Span.Y0 > Span.Y1)) continue;
+				}
+			}
+			Spans.push_back(Span);
+			for (int32_t y = Span.Y0; y <= Span.Y1; y++) {
+				Edge[y * Width + Span.X0]++;
+				Edge[y * Width + Span.X1 + 1]--;
+			}
+		}
+		// Lights per cluster are the running sum of span starts and ends along each row.
+		for (uint32_t y = 0; y < Grid.TilesY; y++) {
+			int32_t Count = 0;
+			for (uint32_t x = 0; x < Grid.TilesX; x++) {
+				Count += Edge[y * Width + x];
+				Offset[this->cluster(x, y, aSlice)] = (uint32_t)Count;
+			}
+		}
+	}
+
+	inline void light_clusters::tile_range(float aCoordinate, float aDepth, float aRadius, const std::vector<float>& aTangent, const std::vector<float>& aScale, int32_t& aFirst, int32_t& aLast) {
+		int32_t Inside = 0, Right = 0;
+		for (std::size_t p = 0; p < aTangent.size(); p++) {
+			float Distance = (aCoordinate - aTangent[p] * aDepth) * aScale[p];
+			Inside += Distance + aRadius > 0.0f ? 1 : 0;
+			Right += Distance - aRadius > 0.0f ? 1 : 0;
+		}
+		aFirst = std::max(Right - 1, 0);
+		aLast = std::min(Inside - 1, (int32_t)aTangent.size() - 2);
+	}
+
+	inline uint32_t light_clusters::slice_of(float aDepth) const {
+		auto Above = std::upper_bound(SliceDepth.begin(), SliceDepth.end(), aDepth);
+		return (uint32_t)std::min<std::ptrdiff_t>(std::max<std::ptrdiff_t>(Above - SliceDepth.begin() - 1, 0), (std::ptrdiff_t)Grid.Slices - 1);
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_LIGHT_CLUSTERS_H
@@ -0,0 +1,150 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_MAPPED_FILE_H
+#define GEODESY_UNIT_TEST_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace geodesy::io {
+
+	// Read-only memory mapping of a whole file. Pages are faulted in by the OS on first
+	// touch, so opening is O(1) in the file size and unused parts are never read.
+	class mapped_file {
+	public:
+
+		mapped_file();
+		mapped_file(const std::string& aPath);
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+		mapped_file(mapped_file&& aFile) noexcept;
+		mapped_file& operator=(mapped_file&& aFile) noexcept;
+		~mapped_file();
+
+		// False when the file could not be opened or mapped. Empty files map as valid with size 0.
+		bool is_open() const;
+		const uint8_t* data() const;
+		std::size_t size() const;
+		void close();
+
+	private:
+
+		const uint8_t* 	Data;
+		std::size_t 	Size;
+		bool 			Open;
+#if defined(_WIN32)
+		HANDLE 			File;
+		HANDLE 			Mapping;
+#endif
+
+	};
+
+	inline mapped_file::mapped_file() {
+		Data = nullptr;
+		Size = 0;
+		Open = false;
+#if defined(_WIN32)
+		File = INVALID_HANDLE_VALUE;
+		Mapping = NULL;
+#endif
+	}
+
+	inline mapped_file::mapped_file(const std::string& aPath) : mapped_file() {
+#if defined(_WIN32)
+		File = CreateFileA(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (File == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER FileSize;
+		if (!GetFileSizeEx(File, &FileSize)) { this->close(); return; }
+		Size = (std::size_t)FileSize.QuadPart;
+		Open = true;
+		if (Size == 0) return;
+		Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (Mapping == NULL) { this->close(); return; }
+		Data = (const uint8_t*)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (Data == nullptr) this->close();
+#else
+		int Descriptor = ::open(aPath.c_str(), O_RDONLY);
+		if (Descriptor < 0) return;
+		struct stat Status;
+		if (fstat(Descriptor, &Status) != 0) { ::close(Descriptor); return; }
+		Size = (std::size_t)Status.st_size;
+		Open = true;
+		if (Size > 0) {
+			void* Pointer = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, Descriptor, 0);
+			if (Pointer == MAP_FAILED) {
+				Open = false;
+				Size = 0;
+			}
+			else {
+				Data = (const uint8_t*)Pointer;
+			}
+		}
+		// The mapping keeps its own reference to the file.
+		::close(Descriptor);
+#endif
+	}
+
+	inline mapped_file::mapped_file(mapped_file&& aFile) noexcept : mapped_file() {
+		*this = std::move(aFile);
+	}
+
+	inline mapped_file& mapped_file::operator=(mapped_file&& aFile) noexcept {
+		if (this == &aFile) return *this;
+		this->close();
+		std::swap(Data, aFile.Data);
+		std::swap(Size, aFile.Size);
+		std::swap(Open, aFile.Open);
+#if defined(_WIN32)
+		std::swap(File, aFile.File);
+		std::swap(Mapping, aFile.Mapping);
+#endif
+		return *this;
+	}
+
+	inline mapped_file::~mapped_file() {
+		this->close();
+	}
+
+	inline bool mapped_file::is_open() const {
+		return Open;
+	}
+
+	inline const uint8_t* mapped_file::data() const {
+		return Data;
+	}
+
+	inline std::size_t mapped_file::size() const {
+		return Size;
+	}
+
+	inline void mapped_file::close() {
+#if defined(_WIN32)
+		if (Data != nullptr) UnmapViewOfFile(Data);
+		if (Mapping != NULL) CloseHandle(Mapping);
+		if (File != INVALID_HANDLE_VALUE) CloseHandle(File);
+		Mapping = NULL;
+		File = INVALID_HANDLE_VALUE;
+#else
+		if (Data != nullptr) munmap((void*)Data, Size);
+#endif
+		Data = nullptr;
+		Size = 0;
+		Open = false;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_MAPPED_FILE_H
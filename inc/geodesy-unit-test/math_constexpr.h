@@ -0,0 +1,358 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_MATH_CONSTEXPR_H
+#define GEODESY_UNIT_TEST_MATH_CONSTEXPR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include <geodesy/engine.h>
+
+// Compile-time stand-ins for the engine's math::vec, math::mat and math::complex, which
+// live in geodesy-engine and are not constexpr. They exist only to fold constants: each
+// has the engine type's layout and operator semantics (vec * vec is the dot product, ^
+// the cross product, mat is constructed from row-major scalars and stored column-major)
+// for the few operations a constant transform needs, and converts implicitly to the
+// engine type, which runtime code should use for everything else:
+//
+//	constexpr auto ZUp = math::constant::rotation<float>({ 1.0f, 0.0f, 0.0f }, math::constant::Pi<float> / 2.0f);
+//	math::mat<float, 4, 4> Basis = ZUp;
+//
+// math_test checks every operator and helper with a static_assert at compile time, and
+// compares dot, cross, the matrix product, the determinant, the complex product and
+// sin and cos against the engine and the runtime library.
+
+namespace geodesy::math::constant {
+
+	template <typename T> constexpr T Pi = T(3.14159265358979323846264338327950288L);
+
+	// ---------- Scalar ---------- //
+
+	template <typename T>
+	constexpr T abs(T aValue) { return aValue < T(0) ? -aValue : aValue; }
+
+	// Newton iteration, exact to the last bit or two for float and double.
+	template <typename T>
+	constexpr T sqrt(T aValue) {
+		if (!(aValue > T(0))) return T(0);
+		T Estimate = aValue > T(1) ? aValue : T(1);
+		for (int i = 0; i < 128; i++) {
+			T Next = T(0.5) * (Estimate + aValue / Estimate);
+			if (!(Next < Estimate)) break;
+			Estimate = Next;
+		}
+		return Estimate;
+	}
+
+	namespace detail {
+
+		// Bits of 1 / (2 pi) after the binary point, most significant first. 1280 bits
+		// cover every finite double with the 192 bit window reduce() takes.
+		constexpr uint32_t InverseTwoPi[40] = {
+			0x28BE60DBu, 0x9391054Au, 0x7F09D5F4u, 0x7D4D3770u, 0x36D8A566u, 0x4F10E410u, 0x7F9458EAu, 0xF7AEF158u,
+			0x6DC91B8Eu, 0x909374B8u, 0x01924BBAu, 0x82746487u, 0x3F877AC7u, 0x2C4A69CFu, 0xBA208D7Du, 0x4BAED121u,
+			0x3A671C09u, 0xAD17DF90u, 0x4E64758Eu, 0x60D4CE7Du, 0x272117E2u, 0xEF7E4A0Eu, 0xC7FE25FFu, 0xF7816603u,
+			0xFBCBC462u, 0xD6829B47u, 0xDB4D9FB3u, 0xC9F2C26Du, 0xD3D18FD9u, 0xA797FA8Bu, 0x5D49EEB1u, 0xFAF97C5Eu,
+			0xCF41CE7Du, 0xE294A4BAu, 0x9AFED7ECu, 0x47E35742u, 0x1580CC11u, 0xBF1EDAEAu, 0xFC33EF08u, 0x26BD0D87u,
+		};
+
+		// Bit k of 1 / (2 pi), k = 1 is the first bit after the binary point.
+		constexpr uint32_t inverse_two_pi_bit(long long aBit) {
+			if (aBit < 1) return 0;
+			return (InverseTwoPi[(aBit - 1) / 32] >> (31 - (aBit - 1) % 32)) & 1u;
+		}
+
+		// Angle in long double, reduced to [-pi, pi] exactly (Payne and Hanek): with
+		// |aAngle| = m 2^e, m a 64 bit integer, the bits of 1 / (2 pi) above 2^-e only add
+		// whole turns, so the phase is m times the next 192 bits, modulo one turn. NaN and
+		// infinities give NaN, as std::sin does, and so do long double angles past the range
+		// of double, which the table does not cover.
+		constexpr long double reduce(long double aAngle) {
+			if (!(aAngle - aAngle == 0.0L)) return aAngle - aAngle;
+			if (abs(aAngle) <= Pi<long double>) return aAngle;
+
+			// Exact scaling by powers of two to m in [2^63, 2^64).
+			long double Magnitude = abs(aAngle);
+			long long Exponent = 0;
+			while (Magnitude >= 18446744073709551616.0L) { Magnitude /= 4294967296.0L; Exponent += 32; }
+			while (Magnitude < 9223372036854775808.0L) { Magnitude *= 2.0L; Exponent -= 1; }
+			unsigned long long Mantissa = (unsigned long long)Magnitude;
+			if (Exponent + 192 > 32 * 40) return std::numeric_limits<long double>::quiet_NaN();
+
+			// Window = bits Exponent + 1 ... Exponent + 192 as six 32 bit limbs, least
+			// significant first, then the low 192 bits of Mantissa * Window.
+			uint32_t Window[6] = {};
+			for (long long j = 0; j < 192; j++) {
+				if (inverse_two_pi_bit(Exponent + 1 + j)) Window[(191 - j) / 32] |= 1u << ((191 - j) % 32);
+			}
+			uint32_t Phase[6] = {};
+			const uint32_t Factor[2] = { (uint32_t)Mantissa, (uint32_t)(Mantissa >> 32) };
+			for (int a = 0; a < 2; a++) {
+				unsigned long long Carry = 0;
+				for (int b = 0; a + b < 6; b++) {
+					unsigned long long Term = (unsigned long long)Factor[a] * Window[b] + Phase[a + b] + Carry;
+					Phase[a + b] = (uint32_t)Term;
+					Carry = Term >> 32;
+				}
+			}
+
+			// Phase / 2^192 is the fraction of a turn, taken in [-1/2, 1/2).
+			bool Negative = (Phase[5] >> 31) != 0;
+			if (Negative) {
+				unsigned long long Carry = 1;
+				for (int i = 0; i < 6; i++) {
+					unsigned long long Term = (unsigned long long)(uint32_t)~Phase[i] + Carry;
+					Phase[i] = (uint32_t)Term;
+					Carry = Term >> 32;
+				}
+			}
+			long double Turn = 0.0L;
+			for (int i = 5; i >= 0; i--) Turn = Turn * 4294967296.0L + (long double)Phase[i];
+			for (int i = 0; i < 6; i++) Turn /= 4294967296.0L;
+			if (Negative) Turn = -Turn;
+			if (aAngle < 0.0L) Turn = -Turn;
+			return Turn * (2.0L * Pi<long double>);
+		}
+
+	}
+
+	// Taylor series after reduction to [-pi, pi].
+	template <typename T>
+	constexpr T sin(T aAngle) {
+		long double x = detail::reduce(aAngle);
+		long double Term = x, Sum = x;
+		for (int n = 1; n < 20; n++) {
+			Term *= -x * x / ((2.0L * n) * (2.0L * n + 1.0L));
+			Sum += Term;
+		}
+		return T(Sum);
+	}
+
+	// Its own series rather than a shifted sin, so the zeros keep full precision.
+	template <typename T>
+	constexpr T cos(T aAngle) {
+		long double x = detail::reduce(aAngle);
+		long double Term = 1.0L, Sum = 1.0L;
+		for (int n = 1; n < 20; n++) {
+			Term *= -x * x / ((2.0L * n - 1.0L) * (2.0L * n));
+			Sum += Term;
+		}
+		return T(Sum);
+	}
+
+	template <typename T>
+	constexpr T tan(T aAngle) { return sin(aAngle) / cos(aAngle); }
+
+	// ---------- vec ---------- //
+
+	template <typename T, std::size_t N>
+	struct vec {
+		T Data[N] = {};
+
+		constexpr vec() {}
+		template <typename... A, typename = std::enable_if_t<(sizeof...(A) == N) && (N > 1)>>
+		constexpr vec(A... aValue) : Data{ T(aValue)... } {}
+
+		constexpr T& operator[](std::size_t aIndex) { return Data[aIndex]; }
+		constexpr const T& operator[](std::size_t aIndex) const { return Data[aIndex]; }
+
+		constexpr vec operator-() const { vec R; for (std::size_t i = 0; i < N; i++) R[i] = -Data[i]; return R; }
+		constexpr vec operator+(const vec& aRHS) const { vec R; for (std::size_t i = 0; i < N; i++) R[i] = Data[i] + aRHS[i]; return R; }
+		constexpr vec operator-(const vec& aRHS) const { vec R; for (std::size_t i = 0; i < N; i++) R[i] = Data[i] - aRHS[i]; return R; }
+		// Dot product.
+		constexpr T operator*(const vec& aRHS) const { T R = T(0); for (std::size_t i = 0; i < N; i++) R += Data[i] * aRHS[i]; return R; }
+		constexpr vec operator*(T aScalar) const { vec R; for (std::size_t i = 0; i < N; i++) R[i] = Data[i] * aScalar; return R; }
+		constexpr vec operator/(T aScalar) const { vec R; for (std::size_t i = 0; i < N; i++) R[i] = Data[i] / aScalar; return R; }
+		// Cross product.
+		constexpr vec operator^(const vec& aRHS) const {
+			static_assert(N == 3, "Cross product is only defined for vec<T,3>.");
+			return vec(Data[1] * aRHS[2] - Data[2] * aRHS[1], Data[2] * aRHS[0] - Data[0] * aRHS[2], Data[0] * aRHS[1] - Data[1] * aRHS[0]);
+		}
+		constexpr bool operator==(const vec& aRHS) const { for (std::size_t i = 0; i < N; i++) if (Data[i] != aRHS[i]) return false; return true; }
+		constexpr bool operator!=(const vec& aRHS) const { return !(*this == aRHS); }
+
+		operator math::vec<T, N>() const { math::vec<T, N> R; for (std::size_t i = 0; i < N; i++) R[i] = Data[i]; return R; }
+	};
+
+	template <typename T, std::size_t N>
+	constexpr T length(const vec<T, N>& aVector) { return sqrt(aVector * aVector); }
+
+	template <typename T, std::size_t N>
+	constexpr vec<T, N> normalize(const vec<T, N>& aVector) { T Length = length(aVector); return Length > T(0) ? aVector / Length : aVector; }
+
+	// ---------- mat ---------- //
+
+	// Column-major storage, element (r, c) at Data[c * M + r].
+	template <typename T, std::size_t M, std::size_t N>
+	struct mat {
+		T Data[M * N] = {};
+
+		constexpr mat() {}
+		// Row-major argument order, as the engine's mat constructor.
+		template <typename... A, typename = std::enable_if_t<sizeof...(A) == M * N>>
+		constexpr mat(A... aValue) {
+			T Value[M * N] = { T(aValue)... };
+			for (std::size_t r = 0; r < M; r++) for (std::size_t c = 0; c < N; c++) (*this)(r, c) = Value[r * N + c];
+		}
+
+		constexpr T& operator()(std::size_t aRow, std::size_t aColumn) { return Data[aColumn * M + aRow]; }
+		constexpr const T& operator()(std::size_t aRow, std::size_t aColumn) const { return Data[aColumn * M + aRow]; }
+
+		constexpr mat operator-() const { mat R; for (std::size_t i = 0; i < M * N; i++) R.Data[i] = -Data[i]; return R; }
+		constexpr mat operator+(const mat& aRHS) const { mat R; for (std::size_t i = 0; i < M * N; i++) R.Data[i] = Data[i] + aRHS.Data[i]; return R; }
+		constexpr mat operator-(const mat& aRHS) const { mat R; for (std::size_t i = 0; i < M * N; i++) R.Data[i] = Data[i] - aRHS.Data[i]; return R; }
+		constexpr mat operator*(T aScalar) const { mat R; for (std::size_t i = 0; i < M * N; i++) R.Data[i] = Data[i] * aScalar; return R; }
+		constexpr mat operator/(T aScalar) const { mat R; for (std::size_t i = 0; i < M * N; i++) R.Data[i] = Data[i] / aScalar; return R; }
+		template <std::size_t P>
+		constexpr mat<T, M, P> operator*(const mat<T, N, P>& aRHS) const {
+			mat<T, M, P> R;
+			for (std::size_t r = 0; r < M; r++) for (std::size_t c = 0; c < P; c++) {
+				T Sum = T(0);
+				for (std::size_t k = 0; k < N; k++) Sum += (*this)(r, k) * aRHS(k, c);
+				R(r, c) = Sum;
+			}
+			return R;
+		}
+		constexpr vec<T, M> operator*(const vec<T, N>& aRHS) const {
+			vec<T, M> R;
+			for (std::size_t r = 0; r < M; r++) {
+				T Sum = T(0);
+				for (std::size_t k = 0; k < N; k++) Sum += (*this)(r, k) * aRHS[k];
+				R[r] = Sum;
+			}
+			return R;
+		}
+		constexpr bool operator==(const mat& aRHS) const { for (std::size_t i = 0; i < M * N; i++) if (Data[i] != aRHS.Data[i]) return false; return true; }
+		constexpr bool operator!=(const mat& aRHS) const { return !(*this == aRHS); }
+
+		operator math::mat<T, M, N>() const {
+			math::mat<T, M, N> R;
+			for (std::size_t r = 0; r < M; r++) for (std::size_t c = 0; c < N; c++) R(r, c) = (*this)(r, c);
+			return R;
+		}
+	};
+
+	template <typename T, std::size_t M, std::size_t N>
+	constexpr mat<T, N, M> transpose(const mat<T, M, N>& aMatrix) {
+		mat<T, N, M> R;
+		for (std::size_t r = 0; r < M; r++) for (std::size_t c = 0; c < N; c++) R(c, r) = aMatrix(r, c);
+		return R;
+	}
+
+	template <typename T, std::size_t N>
+	constexpr mat<T, N, N> identity() {
+		mat<T, N, N> R;
+		for (std::size_t i = 0; i < N; i++) R(i, i) = T(1);
+		return R;
+	}
+
+	// Cofactor expansion along the first row, exact for integer valued entries.
+	template <typename T, std::size_t N>
+	constexpr T determinant(const mat<T, N, N>& aMatrix) {
+		if constexpr (N == 1) {
+			return aMatrix(0, 0);
+		}
+		else if constexpr (N == 2) {
+			return aMatrix(0, 0) * aMatrix(1, 1) - aMatrix(0, 1) * aMatrix(1, 0);
+		}
+		else {
+			T Sum = T(0);
+			for (std::size_t c = 0; c < N; c++) {
+				mat<T, N - 1, N - 1> Minor;
+				for (std::size_t r = 1; r < N; r++) for (std::size_t k = 0, m = 0; k < N; k++) {
+					if (k == c) continue;
+					Minor(r - 1, m++) = aMatrix(r, k);
+				}
+				T Term = aMatrix(0, c) * determinant(Minor);
+				Sum += (c % 2 == 0) ? Term : -Term;
+			}
+			return Sum;
+		}
+	}
+
+	// ---------- complex ---------- //
+
+	template <typename T>
+	struct complex {
+		T Data[2] = {};
+
+		constexpr complex() {}
+		constexpr complex(T aReal, T aImaginary) : Data{ aReal, aImaginary } {}
+
+		constexpr T& operator[](std::size_t aIndex) { return Data[aIndex]; }
+		constexpr const T& operator[](std::size_t aIndex) const { return Data[aIndex]; }
+
+		constexpr complex operator-() const { return complex(-Data[0], -Data[1]); }
+		constexpr complex operator+(const complex& aRHS) const { return complex(Data[0] + aRHS[0], Data[1] + aRHS[1]); }
+		constexpr complex operator-(const complex& aRHS) const { return complex(Data[0] - aRHS[0], Data[1] - aRHS[1]); }
+		constexpr complex operator*(T aScalar) const { return complex(Data[0] * aScalar, Data[1] * aScalar); }
+		constexpr complex operator/(T aScalar) const { return complex(Data[0] / aScalar, Data[1] / aScalar); }
+		constexpr complex operator*(const complex& aRHS) const { return complex(Data[0] * aRHS[0] - Data[1] * aRHS[1], Data[0] * aRHS[1] + Data[1] * aRHS[0]); }
+		// Conjugate.
+		constexpr complex operator~() const { return complex(Data[0], -Data[1]); }
+		constexpr bool operator==(const complex& aRHS) const { return (Data[0] == aRHS[0]) && (Data[1] == aRHS[1]); }
+		constexpr bool operator!=(const complex& aRHS) const { return !(*this == aRHS); }
+
+		operator math::complex<T>() const { return math::complex<T>(Data[0], Data[1]); }
+	};
+
+	template <typename T>
+	constexpr T abs(const complex<T>& aValue) { return sqrt(aValue[0] * aValue[0] + aValue[1] * aValue[1]); }
+
+	// ---------- Transforms ---------- //
+
+	template <typename T>
+	constexpr mat<T, 4, 4> translation(const vec<T, 3>& aOffset) {
+		mat<T, 4, 4> R = identity<T, 4>();
+		for (std::size_t i = 0; i < 3; i++) R(i, 3) = aOffset[i];
+		return R;
+	}
+
+	template <typename T>
+	constexpr mat<T, 4, 4> scale(const vec<T, 3>& aScale) {
+		mat<T, 4, 4> R = identity<T, 4>();
+		for (std::size_t i = 0; i < 3; i++) R(i, i) = aScale[i];
+		return R;
+	}
+
+	// Right-handed rotation of aAngle radians about aAxis, which need not be unit length.
+	template <typename T>
+	constexpr mat<T, 4, 4> rotation(const vec<T, 3>& aAxis, T aAngle) {
+		vec<T, 3> u = normalize(aAxis);
+		T c = cos(aAngle), s = sin(aAngle), t = T(1) - c;
+		return mat<T, 4, 4>(
+			t * u[0] * u[0] + c, 		t * u[0] * u[1] - s * u[2], 	t * u[0] * u[2] + s * u[1], 	T(0),
+			t * u[0] * u[1] + s * u[2], t * u[1] * u[1] + c, 			t * u[1] * u[2] - s * u[0], 	T(0),
+			t * u[0] * u[2] - s * u[1], t * u[1] * u[2] + s * u[0], 	t * u[2] * u[2] + c, 			T(0),
+			T(0), 						T(0), 							T(0), 							T(1)
+		);
+	}
+
+	// Right-handed perspective projection to Vulkan clip space (depth in [0, 1]),
+	// aFieldOfView is the vertical angle in radians.
+	template <typename T>
+	constexpr mat<T, 4, 4> perspective(T aFieldOfView, T aAspectRatio, T aNear, T aFar) {
+		T f = T(1) / tan(aFieldOfView / T(2));
+		return mat<T, 4, 4>(
+			f / aAspectRatio, 	T(0), 	T(0), 						T(0),
+			T(0), 				f, 		T(0), 						T(0),
+			T(0), 				T(0), 	aFar / (aNear - aFar), 		aNear * aFar / (aNear - aFar),
+			T(0), 				T(0), 	T(-1), 						T(0)
+		);
+	}
+
+	// Change of basis taking Y-up coordinates (glTF) to the Z-up world frame.
+	template <typename T>
+	constexpr mat<T, 4, 4> y_up_to_z_up() {
+		return mat<T, 4, 4>(
+			T(1), T(0), T(0), 	T(0),
+			T(0), T(0), T(-1), 	T(0),
+			T(0), T(1), T(0), 	T(0),
+			T(0), T(0), T(0), 	T(1)
+		);
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_MATH_CONSTEXPR_H
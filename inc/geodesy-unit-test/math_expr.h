@@ -0,0 +1,242 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_MATH_EXPR_H
+#define GEODESY_UNIT_TEST_MATH_EXPR_H
+
+#include <cstddef>
+#include <type_traits>
+
+#include <geodesy/engine.h>
+
+// Lazy element-wise arithmetic. Operators on expressions build a tree of nodes
+// and nothing is computed until the tree is converted to a concrete type, where
+// every element is produced in a single fused pass with no temporaries.
+//
+//	math::vec<float, 3> R = math::lazy(A) * s + math::lazy(B) - math::lazy(C);
+//	math::grid<float, 2, float> S = X + Y * 2.0f;
+//
+// Engine vec and mat keep their eager operators, math::lazy() opts in. Grids
+// (grid.h) are lazy operands by default. Expressions hold references to their
+// leaf operands, so they must not outlive them.
+
+namespace geodesy::math {
+
+	template <typename E>
+	struct expression {
+		const E& self() const { return static_cast<const E&>(*this); }
+		// Point-wise evaluation of a grid expression, no grid is materialized.
+		template <typename P> auto operator()(const P& aPoint) const { return self().sample(aPoint); }
+		// Assigning a fixed-size expression to a vec or mat evaluates it.
+		template <typename T, std::size_t N> operator vec<T, N>() const;
+		template <typename T, std::size_t M, std::size_t N> operator mat<T, M, N>() const;
+	};
+
+	// Operand traits. A type is an operand when it is an expression or when it
+	// specializes operand_traits with a node() that wraps it in a leaf expression.
+	template <typename T, typename = void>
+	struct operand_traits {
+		static constexpr bool Value = false;
+	};
+
+	template <typename E>
+	struct operand_traits<E, std::enable_if_t<std::is_base_of_v<expression<E>, E>>> {
+		static constexpr bool Value = true;
+		static const E& node(const E& aExpression) { return aExpression; }
+	};
+
+	template <typename T>
+	constexpr bool is_operand_v = operand_traits<std::decay_t<T>>::Value;
+
+	template <typename T>
+	using node_t = std::decay_t<decltype(operand_traits<std::decay_t<T>>::node(std::declval<const std::decay_t<T>&>()))>;
+
+	namespace expr {
+
+		// Every node provides:
+		//	value_type
+		//	prepare(aLayout)		called once on the whole tree before evaluation.
+		//	at(aLayout, aIndex)		element aIndex of the result laid out as aLayout.
+		//	sample(aPoint)			value at a continuous point (grid expressions only).
+		//	layout()				layout of the result, taken from the leftmost leaf that has one.
+		// Grid expressions additionally provide, for sparse (bricked) results:
+		//	occupied(aSize, aBrick)	false when brick aBrick of edge aSize is background everywhere.
+		//	background()			value of the expression where every grid operand is background.
+
+		struct no_layout {};
+
+		template <typename T, std::size_t N>
+		struct vec_leaf : expression<vec_leaf<T, N>> {
+			using value_type = T;
+			static constexpr std::size_t Size = N;
+			const vec<T, N>& Value;
+			vec_leaf(const vec<T, N>& aValue) : Value(aValue) {}
+			template <typename L> void prepare(const L&) const {}
+			template <typename L> T at(const L&, std::size_t aIndex) const { return Value[aIndex]; }
+			no_layout layout() const { return {}; }
+		};
+
+		// Column-major flat index, element i is (i % M, i / M).
+		template <typename T, std::size_t M, std::size_t N>
+		struct mat_leaf : expression<mat_leaf<T, M, N>> {
+			using value_type = T;
+			static constexpr std::size_t Size = M * N;
+			const mat<T, M, N>& Value;
+			mat_leaf(const mat<T, M, N>& aValue) : Value(aValue) {}
+			template <typename L> void prepare(const L&) const {}
+			template <typename L> T at(const L&, std::size_t aIndex) const { return Value(aIndex % M, aIndex / M); }
+			no_layout layout() const { return {}; }
+		};
+
+		template <typename T>
+		struct scalar : expression<scalar<T>> {
+			using value_type = T;
+			T Value;
+			scalar(T aValue) : Value(aValue) {}
+			template <typename L> void prepare(const L&) const {}
+			template <typename L> T at(const L&, std::size_t) const { return Value; }
+			template <typename P> T sample(const P&) const { return Value; }
+			bool occupied(std::size_t, std::size_t) const { return false; }
+			T background() const { return Value; }
+			no_layout layout() const { return {}; }
+		};
+
+		struct add { template <typename A, typename B> static auto apply(const A& aA, const B& aB) { return aA + aB; } };
+		struct sub { template <typename A, typename B> static auto apply(const A& aA, const B& aB) { return aA - aB; } };
+		struct mul { template <typename A, typename B> static auto apply(const A& aA, const B& aB) { return aA * aB; } };
+		struct div { template <typename A, typename B> static auto apply(const A& aA, const B& aB) { return aA / aB; } };
+
+		template <typename Op, typename A, typename B> struct binary;
+		template <typename A> struct negate;
+
+		// Size of a fixed-size (vec/mat) expression, 0 for scalars and grids. binary checks
+		// that its sized operands agree, so the leftmost sized leaf gives the size.
+		template <typename E, typename = void>
+		struct fixed_size { static constexpr std::size_t Value = 0; };
+		template <typename E>
+		struct fixed_size<E, std::void_t<decltype(E::Size)>> { static constexpr std::size_t Value = E::Size; };
+		template <typename Op, typename A, typename B>
+		struct fixed_size<binary<Op, A, B>> { static constexpr std::size_t Value = fixed_size<A>::Value > 0 ? fixed_size<A>::Value : fixed_size<B>::Value; };
+		template <typename A>
+		struct fixed_size<negate<A>> { static constexpr std::size_t Value = fixed_size<A>::Value; };
+
+		template <typename Op, typename A, typename B>
+		struct binary : expression<binary<Op, A, B>> {
+			static_assert((fixed_size<A>::Value == 0) || (fixed_size<B>::Value == 0) || (fixed_size<A>::Value == fixed_size<B>::Value), "Operands of an element-wise expression differ in size.");
+			using value_type = typename A::value_type;
+			A Left;
+			B Right;
+			binary(const A& aLeft, const B& aRight) : Left(aLeft), Right(aRight) {}
+			template <typename L> void prepare(const L& aLayout) const { Left.prepare(aLayout); Right.prepare(aLayout); }
+			template <typename L, typename I> value_type at(const L& aLayout, const I& aIndex) const { return Op::apply(Left.at(aLayout, aIndex), Right.at(aLayout, aIndex)); }
+			template <typename P> value_type sample(const P& aPoint) const { return Op::apply(Left.sample(aPoint), Right.sample(aPoint)); }
+			bool occupied(std::size_t aSize, std::size_t aBrick) const { return Left.occupied(aSize, aBrick) || Right.occupied(aSize, aBrick); }
+			value_type background() const { return Op::apply(Left.background(), Right.background()); }
+			auto layout() const {
+				if constexpr (std::is_same_v<decltype(Left.layout()), no_layout>) return Right.layout();
+				else return Left.layout();
+			}
+		};
+
+		template <typename A>
+		struct negate : expression<negate<A>> {
+			using value_type = typename A::value_type;
+			A Operand;
+			negate(const A& aOperand) : Operand(aOperand) {}
+			template <typename L> void prepare(const L& aLayout) const { Operand.prepare(aLayout); }
+			template <typename L, typename I> value_type at(const L& aLayout, const I& aIndex) const { return -Operand.at(aLayout, aIndex); }
+			template <typename P> value_type sample(const P& aPoint) const { return -Operand.sample(aPoint); }
+			bool occupied(std::size_t aSize, std::size_t aBrick) const { return Operand.occupied(aSize, aBrick); }
+			value_type background() const { return -Operand.background(); }
+			auto layout() const { return Operand.layout(); }
+		};
+
+	}
+
+	// Opt-in lazy views of engine vec and mat.
+	template <typename T, std::size_t N>
+	inline expr::vec_leaf<T, N> lazy(const vec<T, N>& aValue) { return expr::vec_leaf<T, N>(aValue); }
+
+	template <typename T, std::size_t M, std::size_t N>
+	inline expr::mat_leaf<T, M, N> lazy(const mat<T, M, N>& aValue) { return expr::mat_leaf<T, M, N>(aValue); }
+
+	// Evaluates a fixed-size expression into a vec or mat in one pass.
+	template <typename T, std::size_t N, typename E>
+	inline void assign(vec<T, N>& aResult, const expression<E>& aExpression) {
+		static_assert(expr::fixed_size<E>::Value == N, "Expression size does not match vec<T,N>.");
+		for (std::size_t i = 0; i < N; i++) aResult[i] = aExpression.self().at(expr::no_layout{}, i);
+	}
+
+	template <typename T, std::size_t M, std::size_t N, typename E>
+	inline void assign(mat<T, M, N>& aResult, const expression<E>& aExpression) {
+		static_assert(expr::fixed_size<E>::Value == M * N, "Expression size does not match mat<T,M,N>.");
+		for (std::size_t i = 0; i < M * N; i++) aResult(i % M, i / M) = aExpression.self().at(expr::no_layout{}, i);
+	}
+
+	template <typename R, typename E>
+	inline R eval(const expression<E>& aExpression) {
+		R Result;
+		assign(Result, aExpression);
+		return Result;
+	}
+
+	template <typename E>
+	template <typename T, std::size_t N>
+	inline expression<E>::operator vec<T, N>() const {
+		return eval<vec<T, N>>(*this);
+	}
+
+	template <typename E>
+	template <typename T, std::size_t M, std::size_t N>
+	inline expression<E>::operator mat<T, M, N>() const {
+		return eval<mat<T, M, N>>(*this);
+	}
+
+	// ---------- Operators ---------- //
+
+	template <typename A, typename B, std::enable_if_t<is_operand_v<A> && is_operand_v<B>, int> = 0>
+	inline auto operator+(const A& aA, const B& aB) {
+		return expr::binary<expr::add, node_t<A>, node_t<B>>(operand_traits<A>::node(aA), operand_traits<B>::node(aB));
+	}
+
+	template <typename A, typename B, std::enable_if_t<is_operand_v<A> && is_operand_v<B>, int> = 0>
+	inline auto operator-(const A& aA, const B& aB) {
+		return expr::binary<expr::sub, node_t<A>, node_t<B>>(operand_traits<A>::node(aA), operand_traits<B>::node(aB));
+	}
+
+	template <typename A, typename S, std::enable_if_t<is_operand_v<A> && std::is_arithmetic_v<S>, int> = 0>
+	inline auto operator+(const A& aA, S aScalar) {
+		using T = typename node_t<A>::value_type;
+		return expr::binary<expr::add, node_t<A>, expr::scalar<T>>(operand_traits<A>::node(aA), expr::scalar<T>(T(aScalar)));
+	}
+
+	template <typename A, typename S, std::enable_if_t<is_operand_v<A> && std::is_arithmetic_v<S>, int> = 0>
+	inline auto operator-(const A& aA, S aScalar) {
+		using T = typename node_t<A>::value_type;
+		return expr::binary<expr::sub, node_t<A>, expr::scalar<T>>(operand_traits<A>::node(aA), expr::scalar<T>(T(aScalar)));
+	}
+
+	template <typename A, std::enable_if_t<is_operand_v<A>, int> = 0>
+	inline auto operator-(const A& aA) {
+		return expr::negate<node_t<A>>(operand_traits<A>::node(aA));
+	}
+
+	template <typename A, typename S, std::enable_if_t<is_operand_v<A> && std::is_arithmetic_v<S>, int> = 0>
+	inline auto operator*(const A& aA, S aScalar) {
+		using T = typename node_t<A>::value_type;
+		return expr::binary<expr::mul, node_t<A>, expr::scalar<T>>(operand_traits<A>::node(aA), expr::scalar<T>(T(aScalar)));
+	}
+
+	template <typename A, typename S, std::enable_if_t<is_operand_v<A> && std::is_arithmetic_v<S>, int> = 0>
+	inline auto operator*(S aScalar, const A& aA) {
+		using T = typename node_t<A>::value_type;
+		return expr::binary<expr::mul, expr::scalar<T>, node_t<A>>(expr::scalar<T>(T(aScalar)), operand_traits<A>::node(aA));
+	}
+
+	template <typename A, typename S, std::enable_if_t<is_operand_v<A> && std::is_arithmetic_v<S>, int> = 0>
+	inline auto operator/(const A& aA, S aScalar) {
+		using T = typename node_t<A>::value_type;
+		return expr::binary<expr::div, node_t<A>, expr::scalar<T>>(operand_traits<A>::node(aA), expr::scalar<T>(T(aScalar)));
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_MATH_EXPR_H
@@ -0,0 +1,225 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_MATH_SIMD_H
+#define GEODESY_UNIT_TEST_MATH_SIMD_H
+
+#include <geodesy/engine.h>
+
+// Instruction set selection happens at build time. GEODESY_MATH_SIMD_SCALAR forces
+// the portable path, otherwise the widest set enabled by the compiler flags is used
+// (see GEODESY_UNIT_TEST_SIMD in CMakeLists.txt).
+#if !defined(GEODESY_MATH_SIMD_SCALAR)
+	#if defined(__AVX2__)
+		#define GEODESY_MATH_SIMD_AVX2
+		#define GEODESY_MATH_SIMD_SSE
+	#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+		#define GEODESY_MATH_SIMD_SSE
+	#endif
+#endif
+
+#if defined(GEODESY_MATH_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(GEODESY_MATH_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace geodesy::math::simd {
+
+	// The kernels below read math::mat<float,4,4> as 16 contiguous floats in
+	// column-major order, A(r,c) == Data[4*c + r], and math::vec<float,4> as 4 floats.
+	static_assert(sizeof(mat<float, 4, 4>) == 16 * sizeof(float), "math::simd expects mat<float,4,4> to be 16 packed floats.");
+	static_assert(sizeof(vec<float, 4>) == 4 * sizeof(float), "math::simd expects vec<float,4> to be 4 packed floats.");
+
+	// Name of the instruction set the kernels were compiled for.
+	constexpr const char* instruction_set() {
+#if defined(GEODESY_MATH_SIMD_AVX2)
+		return "AVX2";
+#elif defined(GEODESY_MATH_SIMD_SSE)
+		return "SSE2";
+#else
+		return "Scalar";
+#endif
+	}
+
+	// C = A * B. Accumulates over k in ascending order without FMA, matching the
+	// generic mat<T,M,N> product bit for bit.
+	mat<float, 4, 4> mul(const mat<float, 4, 4>& aLHS, const mat<float, 4, 4>& aRHS);
+	// R = A * V.
+	vec<float, 4> mul(const mat<float, 4, 4>& aLHS, const vec<float, 4>& aRHS);
+	// Determinant by 2x2 sub-determinant (Laplace) expansion.
+	float determinant(const mat<float, 4, 4>& aMatrix);
+	// Inverse as adjugate / determinant. A singular input yields non-finite entries.
+	mat<float, 4, 4> inverse(const mat<float, 4, 4>& aMatrix);
+
+	// ---------- Implementation ---------- //
+
+	namespace detail {
+
+		inline const float* data(const mat<float, 4, 4>& aMatrix) { return &aMatrix(0, 0); }
+		inline float* data(mat<float, 4, 4>& aMatrix) { return &aMatrix(0, 0); }
+		inline const float* data(const vec<float, 4>& aVector) { return &aVector[0]; }
+		inline float* data(vec<float, 4>& aVector) { return &aVector[0]; }
+
+#if defined(GEODESY_MATH_SIMD_SSE)
+
+		#define GEODESY_MATH_SIMD_SHUFFLE(V, A, B, C, D) _mm_shuffle_ps(V, V, _MM_SHUFFLE(D, C, B, A))
+
+		// Unscaled adjugate of a column-major matrix, returned as columns, and the determinant.
+		// With rows r0..r3 and pair permutations Pa = [2,2,1,1], Pb = [3,3,3,2], Pc = [1,0,0,0],
+		// the 2x2 minors of (r0,r1) and (r2,r3) give each adjugate column in three products.
+		inline __m128 adjugate(const float* aData, __m128 (&aColumn)[4]) {
+			__m128 R0 = _mm_loadu_ps(aData + 0);
+			__m128 R1 = _mm_loadu_ps(aData + 4);
+			__m128 R2 = _mm_loadu_ps(aData + 8);
+			__m128 R3 = _mm_loadu_ps(aData + 12);
+			_MM_TRANSPOSE4_PS(R0, R1, R2, R3);
+
+			__m128 R0a = GEODESY_MATH_SIMD_SHUFFLE(R0, 2, 2, 1, 1), R0b = GEODESY_MATH_SIMD_SHUFFLE(R0, 3, 3, 3, 2), R0c = GEODESY_MATH_SIMD_SHUFFLE(R0, 1, 0, 0, 0);
+			__m128 R1a = GEODESY_MATH_SIMD_SHUFFLE(R1, 2, 2, 1, 1), R1b = GEODESY_MATH_SIMD_SHUFFLE(R1, 3, 3, 3, 2), R1c = GEODESY_MATH_SIMD_SHUFFLE(R1, 1, 0, 0, 0);
+			__m128 R2a = GEODESY_MATH_SIMD_SHUFFLE(R2, 2, 2, 1, 1), R2b = GEODESY_MATH_SIMD_SHUFFLE(R2, 3, 3, 3, 2), R2c = GEODESY_MATH_SIMD_SHUFFLE(R2, 1, 0, 0, 0);
+			__m128 R3a = GEODESY_MATH_SIMD_SHUFFLE(R3, 2, 2, 1, 1), R3b = GEODESY_MATH_SIMD_SHUFFLE(R3, 3, 3, 3, 2), R3c = GEODESY_MATH_SIMD_SHUFFLE(R3, 1, 0, 0, 0);
+
+			// S1 = [s5,s5,s4,s3], S2 = [s4,s2,s2,s1], S3 = [s3,s1,s0,s0] and likewise C1..C3.
+			__m128 S1 = _mm_sub_ps(_mm_mul_ps(R0a, R1b), _mm_mul_ps(R1a, R0b));
+			__m128 S2 = _mm_sub_ps(_mm_mul_ps(R0c, R1b), _mm_mul_ps(R1c, R0b));
+			__m128 S3 = _mm_sub_ps(_mm_mul_ps(R0c, R1a), _mm_mul_ps(R1c, R0a));
+			__m128 C1 = _mm_sub_ps(_mm_mul_ps(R2a, R3b), _mm_mul_ps(R3a, R2b));
+			__m128 C2 = _mm_sub_ps(_mm_mul_ps(R2c, R3b), _mm_mul_ps(R3c, R2b));
+			__m128 C3 = _mm_sub_ps(_mm_mul_ps(R2c, R3a), _mm_mul_ps(R3c, R2a));
+
+			const __m128 EvenSign = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+			const __m128 OddSign = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+			aColumn[0] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(R1c, C1), _mm_mul_ps(R1a, C2)), _mm_mul_ps(R1b, C3)), EvenSign);
+			aColumn[1] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(R0c, C1), _mm_mul_ps(R0a, C2)), _mm_mul_ps(R0b, C3)), OddSign);
+			aColumn[2] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(R3c, S1), _mm_mul_ps(R3a, S2)), _mm_mul_ps(R3b, S3)), EvenSign);
+			aColumn[3] = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(R2c, S1), _mm_mul_ps(R2a, S2)), _mm_mul_ps(R2b, S3)), OddSign);
+
+			// det = r0 . adj[:,0], broadcast to all lanes.
+			__m128 Product = _mm_mul_ps(R0, aColumn[0]);
+			__m128 Sum = _mm_add_ps(Product, GEODESY_MATH_SIMD_SHUFFLE(Product, 1, 0, 3, 2));
+			return _mm_add_ps(Sum, GEODESY_MATH_SIMD_SHUFFLE(Sum, 2, 3, 0, 1));
+		}
+
+		#undef GEODESY_MATH_SIMD_SHUFFLE
+
+#else
+
+		// Scalar fallback, same minor expansion as the SSE path. aAdjugate is column-major.
+		inline float adjugate(const float* aData, float (&aAdjugate)[16]) {
+			auto a = [aData](int r, int c) -> float { return aData[4 * c + r]; };
+			float s0 = a(0,0)*a(1,1) - a(1,0)*a(0,1), s1 = a(0,0)*a(1,2) - a(1,0)*a(0,2), s2 = a(0,0)*a(1,3) - a(1,0)*a(0,3);
+			float s3 = a(0,1)*a(1,2) - a(1,1)*a(0,2), s4 = a(0,1)*a(1,3) - a(1,1)*a(0,3), s5 = a(0,2)*a(1,3) - a(1,2)*a(0,3);
+			float c0 = a(2,0)*a(3,1) - a(3,0)*a(2,1), c1 = a(2,0)*a(3,2) - a(3,0)*a(2,2), c2 = a(2,0)*a(3,3) - a(3,0)*a(2,3);
+			float c3 = a(2,1)*a(3,2) - a(3,1)*a(2,2), c4 = a(2,1)*a(3,3) - a(3,1)*a(2,3), c5 = a(2,2)*a(3,3) - a(3,2)*a(2,3);
+			float Adj[4][4] = {
+				{  a(1,1)*c5 - a(1,2)*c4 + a(1,3)*c3, -a(0,1)*c5 + a(0,2)*c4 - a(0,3)*c3,  a(3,1)*s5 - a(3,2)*s4 + a(3,3)*s3, -a(2,1)*s5 + a(2,2)*s4 - a(2,3)*s3 },
+				{ -a(1,0)*c5 + a(1,2)*c2 - a(1,3)*c1,  a(0,0)*c5 - a(0,2)*c2 + a(0,3)*c1, -a(3,0)*s5 + a(3,2)*s2 - a(3,3)*s1,  a(2,0)*s5 - a(2,2)*s2 + a(2,3)*s1 },
+				{  a(1,0)*c4 - a(1,1)*c2 + a(1,3)*c0, -a(0,0)*c4 + a(0,1)*c2 - a(0,3)*c0,  a(3,0)*s4 - a(3,1)*s2 + a(3,3)*s0, -a(2,0)*s4 + a(2,1)*s2 - a(2,3)*s0 },
+				{ -a(1,0)*c3 + a(1,1)*c1 - a(1,2)*c0,  a(0,0)*c3 - a(0,1)*c1 + a(0,2)*c0, -a(3,0)*s3 + a(3,1)*s1 - a(3,2)*s0,  a(2,0)*s3 - a(2,1)*s1 + a(2,2)*s0 }
+			};
+			for (int r = 0; r < 4; r++) {
+				for (int c = 0; c < 4; c++) {
+					aAdjugate[4 * c + r] = Adj[r][c];
+				}
+			}
+			return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+		}
+
+#endif
+
+	}
+
+	inline mat<float, 4, 4> mul(const mat<float, 4, 4>& aLHS, const mat<float, 4, 4>& aRHS) {
+		mat<float, 4, 4> Result;
+		const float* A = detail::data(aLHS);
+		const float* B = detail::data(aRHS);
+		float* C = detail::data(Result);
+#if defined(GEODESY_MATH_SIMD_AVX2)
+		// Two result columns per iteration, each lane half holds one column.
+		__m256 A0 = _mm256_broadcast_ps((const __m128*)(A + 0));
+		__m256 A1 = _mm256_broadcast_ps((const __m128*)(A + 4));
+		__m256 A2 = _mm256_broadcast_ps((const __m128*)(A + 8));
+		__m256 A3 = _mm256_broadcast_ps((const __m128*)(A + 12));
+		for (int j = 0; j < 4; j += 2) {
+			const float* Bj = B + 4 * j;
+			__m256 Sum = _mm256_mul_ps(A0, _mm256_setr_ps(Bj[0], Bj[0], Bj[0], Bj[0], Bj[4], Bj[4], Bj[4], Bj[4]));
+			Sum = _mm256_add_ps(Sum, _mm256_mul_ps(A1, _mm256_setr_ps(Bj[1], Bj[1], Bj[1], Bj[1], Bj[5], Bj[5], Bj[5], Bj[5])));
+			Sum = _mm256_add_ps(Sum, _mm256_mul_ps(A2, _mm256_setr_ps(Bj[2], Bj[2], Bj[2], Bj[2], Bj[6], Bj[6], Bj[6], Bj[6])));
+			Sum = _mm256_add_ps(Sum, _mm256_mul_ps(A3, _mm256_setr_ps(Bj[3], Bj[3], Bj[3], Bj[3], Bj[7], Bj[7], Bj[7], Bj[7])));
+			_mm256_storeu_ps(C + 4 * j, Sum);
+		}
+#elif defined(GEODESY_MATH_SIMD_SSE)
+		__m128 A0 = _mm_loadu_ps(A + 0);
+		__m128 A1 = _mm_loadu_ps(A + 4);
+		__m128 A2 = _mm_loadu_ps(A + 8);
+		__m128 A3 = _mm_loadu_ps(A + 12);
+		for (int j = 0; j < 4; j++) {
+			const float* Bj = B + 4 * j;
+			__m128 Sum = _mm_mul_ps(A0, _mm_set1_ps(Bj[0]));
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(A1, _mm_set1_ps(Bj[1])));
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(A2, _mm_set1_ps(Bj[2])));
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(A3, _mm_set1_ps(Bj[3])));
+			_mm_storeu_ps(C + 4 * j, Sum);
+		}
+#else
+		for (int j = 0; j < 4; j++) {
+			for (int i = 0; i < 4; i++) {
+				float Sum = A[i] * B[4 * j];
+				for (int k = 1; k < 4; k++) Sum += A[4 * k + i] * B[4 * j + k];
+				C[4 * j + i] = Sum;
+			}
+		}
+#endif
+		return Result;
+	}
+
+	inline vec<float, 4> mul(const mat<float, 4, 4>& aLHS, const vec<float, 4>& aRHS) {
+		vec<float, 4> Result;
+		const float* A = detail::data(aLHS);
+		const float* V = detail::data(aRHS);
+		float* R = detail::data(Result);
+#if defined(GEODESY_MATH_SIMD_SSE)
+		__m128 Sum = _mm_mul_ps(_mm_loadu_ps(A + 0), _mm_set1_ps(V[0]));
+		Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_loadu_ps(A + 4), _mm_set1_ps(V[1])));
+		Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_loadu_ps(A + 8), _mm_set1_ps(V[2])));
+		Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_loadu_ps(A + 12), _mm_set1_ps(V[3])));
+		_mm_storeu_ps(R, Sum);
+#else
+		for (int i = 0; i < 4; i++) {
+			float Sum = A[i] * V[0];
+			for (int k = 1; k < 4; k++) Sum += A[4 * k + i] * V[k];
+			R[i] = Sum;
+		}
+#endif
+		return Result;
+	}
+
+	inline float determinant(const mat<float, 4, 4>& aMatrix) {
+#if defined(GEODESY_MATH_SIMD_SSE)
+		__m128 Column[4];
+		return _mm_cvtss_f32(detail::adjugate(detail::data(aMatrix), Column));
+#else
+		float Adjugate[16];
+		return detail::adjugate(detail::data(aMatrix), Adjugate);
+#endif
+	}
+
+	inline mat<float, 4, 4> inverse(const mat<float, 4, 4>& aMatrix) {
+		mat<float, 4, 4> Result;
+		float* R = detail::data(Result);
+#if defined(GEODESY_MATH_SIMD_SSE)
+		__m128 Column[4];
+		__m128 InverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), detail::adjugate(detail::data(aMatrix), Column));
+		for (int j = 0; j < 4; j++) {
+			_mm_storeu_ps(R + 4 * j, _mm_mul_ps(Column[j], InverseDeterminant));
+		}
+#else
+		float Adjugate[16];
+		float InverseDeterminant = 1.0f / detail::adjugate(detail::data(aMatrix), Adjugate);
+		for (int i = 0; i < 16; i++) R[i] = Adjugate[i] * InverseDeterminant;
+#endif
+		return Result;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_MATH_SIMD_H
@@ -0,0 +1,386 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_MESH_LOD_H
+#define GEODESY_UNIT_TEST_MESH_LOD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <array>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+#include <stdexcept>
+
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy {
+
+	namespace io {
+
+		struct simplify_options {
+			float 	MaxError 		= FLT_MAX; 		// Largest error estimate allowed per collapse, object space units.
+			float 	NormalWeight 	= 0.5f; 		// Attribute cost per unit of normal change, relative to the mesh extent.
+			float 	TexcoordWeight 	= 1.0f; 		// Same per unit of texture coordinate change.
+			float 	BorderWeight 	= 10.0f; 		// Weight of the planes that hold open borders in place.
+		};
+
+		// Simplifies a triangle list towards aTargetTriangles by half edge collapses ordered
+		// by quadric error (Garland and Heckbert), so the result indexes a subset of the
+		// original vertices and coarser levels can share one vertex buffer. Vertices at the
+		// same position are welded for the error, attribute seams only collapse along the
+		// seam and open borders only along the border, and collapses that would flip a
+		// triangle are rejected. Normal and texcoord changes add to the cost so flat shaded
+		// edges and UV charts keep their shape. aNormal and aTexcoord may be null.
+		//
+		// aError receives the largest error estimate of any collapse performed, the square
+		// root of its quadric error (the area weighted mean squared distance of the kept
+		// vertex to the planes merged into it). Being a mean over planes it estimates the
+		// deviation of the level from the original surface rather than bounding it, a point
+		// of the level may lie further away. optimize_mesh sums it over levels into
+		// lod_level::Error.
+		std::vector<uint32_t> simplify(const float* aPosition, const float* aNormal, const float* aTexcoord, std::size_t aVertexCount, const std::vector<uint32_t>& aIndex, std::size_t aTargetTriangles, const simplify_options& aOptions = simplify_options(), float* aError = nullptr);
+
+		namespace detail {
+
+			// Symmetric 4x4 matrix of summed squared plane distances, with the area it came from.
+			struct quadric {
+				double 		A[10];
+				double 		Weight;
+
+				void add_plane(const double aPlane[4], double aWeight) {
+					const double* P = aPlane;
+					A[0] += aWeight * P[0] * P[0]; A[1] += aWeight * P[0] * P[1]; A[2] += aWeight * P[0] * P[2]; A[3] += aWeight * P[0] * P[3];
+					A[4] += aWeight * P[1] * P[1]; A[5] += aWeight * P[1] * P[2]; A[6] += aWeight * P[1] * P[3];
+					A[7] += aWeight * P[2] * P[2]; A[8] += aWeight * P[2] * P[3];
+					A[9] += aWeight * P[3] * P[3];
+					Weight += aWeight;
+				}
+
+				void add(const quadric& aOther) {
+					for (std::size_t i = 0; i < 10; i++) A[i] += aOther.A[i];
+					Weight += aOther.Weight;
+				}
+
+				// Mean squared distance of aPoint to the planes.
+				double error(const float aPoint[3]) const {
+					double X = aPoint[0], Y = aPoint[1], Z = aPoint[2];
+					double Sum = A[0] * X * X + A[4] * Y * Y + A[7] * Z * Z + 2.0 * (A[1] * X * Y + A[2] * X * Z + A[5] * Y * Z) + 2.0 * (A[3] * X + A[6] * Y + A[8] * Z) + A[9];
+					return Weight > 0.0 ? std::max(Sum, 0.0) / Weight : 0.0;
+				}
+			};
+
+			inline void cross(const float aA[3], const float aB[3], const float aC[3], double aOut[3]) {
+				double E[3] = { (double)aB[0] - aA[0], (double)aB[1] - aA[1], (double)aB[2] - aA[2] };
+				double F[3] = { (double)aC[0] - aA[0], (double)aC[1] - aA[1], (double)aC[2] - aA[2] };
+				aOut[0] = E[1] * F[2] - E[2] * F[1];
+				aOut[1] = E[2] * F[0] - E[0] * F[2];
+				aOut[2] = E[0] * F[1] - E[1] * F[0];
+			}
+
+		}
+
+		// ---------- simplify ---------- //
+
+		inline std::vector<uint32_t> simplify(const float* aPosition, const float* aNormal, const float* aTexcoord, std::size_t aVertexCount, const std::vector<uint32_t>& aIndex, std::size_t aTargetTriangles, const simplify_options& aOptions, float* aError) {
+			GEODESY_PROFILE_SCOPE("asset", "mesh.simplify");
+			if (aIndex.size() % 3 != 0) throw std::invalid_argument("simplify: index count is not a multiple of 3");
+			for (uint32_t V : aIndex) if (V >= aVertexCount) throw std::out_of_range("simplify: index " + std::to_string(V) + " out of range");
+			std::vector<uint32_t> Index = aIndex;
+			if (aError != nullptr) *aError = 0.0f;
+			if (Index.size() / 3 <= aTargetTriangles) return Index;
+
+			// Weld vertices by exact position, Weld[v] is the first vertex at v's position and
+			// the quadric, kind and locks of a position live at that vertex.
+			std::vector<uint32_t> Weld(aVertexCount), WedgeNext(aVertexCount);
+			{
+				struct key_hash {
+					std::size_t operator()(const std::array<uint32_t, 3>& aKey) const {
+						return (std::size_t)(((uint64_t)aKey[0] * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)aKey[1] * 0xC2B2AE3D27D4EB4Full) ^ ((uint64_t)aKey[2] * 0x165667B19E3779F9ull));
+					}
+				};
+				std::unordered_map<std::array<uint32_t, 3>, uint32_t, key_hash> First;
+				First.reserve(aVertexCount);
+				for (uint32_t v = 0; v < aVertexCount; v++) {
+					std::array<uint32_t, 3> Key;
+					std::memcpy(Key.data(), aPosition + 3 * (std::size_t)v, 12);
+					for (uint32_t& K : Key) K = K == 0x80000000u ? 0 : K; 		// -0 welds with 0.
+					auto Found = First.emplace(Key, v);
+					Weld[v] = Found.first->second;
+				}
+				// Wedges of a position in a cycle.
+				std::vector<uint32_t> Last(aVertexCount, UINT32_MAX);
+				for (uint32_t v = 0; v < aVertexCount; v++) {
+					uint32_t W = Weld[v];
+					WedgeNext[v] = W;
+					if (Last[W] != UINT32_MAX) WedgeNext[Last[W]] = v;
+					Last[W] = v;
+				}
+			}
+			auto position = [&](uint32_t aVertex) { return aPosition + 3 * (std::size_t)aVertex; };
+			auto edge_key = [&](uint32_t aA, uint32_t aB) { return aA < aB ? ((uint64_t)aA << 32) | aB : ((uint64_t)aB << 32) | aA; };
+
+			float Extent = 0.0f;
+			{
+				float Low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, High[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				for (uint32_t V : Index) {
+					for (std::size_t k = 0; k < 3; k++) {
+						Low[k] = std::min(Low[k], position(V)[k]);
+						High[k] = std::max(High[k], position(V)[k]);
+					}
+				}
+				for (std::size_t k = 0; k < 3; k++) Extent = std::max(Extent, High[k] - Low[k]);
+				if (Extent <= 0.0f) Extent = 1.0f;
+			}
+
+			// Triangles per welded edge: one is an open border, more than two is non-manifold.
+			std::unordered_map<uint64_t, uint32_t> EdgeCount;
+			EdgeCount.reserve(Index.size());
+			for (std::size_t i = 0; i < Index.size(); i += 3) {
+				for (std::size_t k = 0; k < 3; k++) {
+					uint32_t A = Weld[Index[i + k]], B = Weld[Index[i + (k + 1) % 3]];
+					if (A != B) EdgeCount[edge_key(A, B)]++;
+				}
+			}
+			enum kind : uint8_t { MANIFOLD, BORDER, SEAM, LOCKED };
+			std::vector<uint8_t> Kind(aVertexCount, MANIFOLD);
+			for (uint32_t v = 0; v < aVertexCount; v++) if ((Weld[v] == v) && (WedgeNext[v] != v)) Kind[v] = SEAM;
+			for (const std::pair<const uint64_t, uint32_t>& E : EdgeCount) {
+				uint32_t A = (uint32_t)(E.first >> 32), B = (uint32_t)E.first;
+				for (uint32_t P : { A, B }) {
+					if (E.second > 2) Kind[P] = LOCKED;
+					else if ((E.second == 1) && (Kind[P] != LOCKED)) Kind[P] = Kind[P] == SEAM ? LOCKED : BORDER;
+				}
+			}
+
+			// Face planes weighted by area, and planes through border edges perpendicular to
+			// their face that keep the outline from sliding.
+			std::vector<detail::quadric> Quadric(aVertexCount, detail::quadric{});
+			for (std::size_t i = 0; i < Index.size(); i += 3) {
+				const float* P[3] = { position(Index[i]), position(Index[i + 1]), position(Index[i + 2]) };
+				double N[3];
+				detail::cross(P[0], P[1], P[2], N);
+				double Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+				if (Length == 0.0) continue;
+				double Plane[4] = { N[0] / Length, N[1] / Length, N[2] / Length, 0.0 };
+				Plane[3] = -(Plane[0] * P[0][0] + Plane[1] * P[0][1] + Plane[2] * P[0][2]);
+				for (std::size_t k = 0; k < 3; k++) Quadric[Weld[Index[i + k]]].add_plane(Plane, 0.5 * Length);
+				for (std::size_t k = 0; k < 3; k++) {
+					uint32_t A = Weld[Index[i + k]], B = Weld[Index[i + (k + 1) % 3]];
+					if ((A == B) || (EdgeCount[edge_key(A, B)] != 1)) continue;
+					const float* PA = P[k];
+					const float* PB = P[(k + 1) % 3];
+					double E[3] = { (double)PB[0] - PA[0], (double)PB[1] - PA[1], (double)PB[2] - PA[2] };
+					double M[3] = { E[1] * Plane[2] - E[2] * Plane[1], E[2] * Plane[0] - E[0] * Plane[2], E[0] * Plane[1] - E[1] * Plane[0] };
+					double ML = std::sqrt(M[0] * M[0] + M[1] * M[1] + M[2] * M[2]);
+					if (ML == 0.0) continue;
+					double Border[4] = { M[0] / ML, M[1] / ML, M[2] / ML, 0.0 };
+					Border[3] = -(Border[0] * PA[0] + Border[1] * PA[1] + Border[2] * PA[2]);
+					double Weight = aOptions.BorderWeight * (E[0] * E[0] + E[1] * E[1] + E[2] * E[2]);
+					Quadric[A].add_plane(Border, Weight);
+					Quadric[B].add_plane(Border, Weight);
+				}
+			}
+
+			auto attribute_cost = [&](uint32_t aA, uint32_t aB) {
+				double Cost = 0.0;
+				if (aNormal != nullptr) {
+					double D = 0.0;
+					for (std::size_t k = 0; k < 3; k++) D += (double)(aNormal[3 * (std::size_t)aA + k] - aNormal[3 * (std::size_t)aB + k]) * (aNormal[3 * (std::size_t)aA + k] - aNormal[3 * (std::size_t)aB + k]);
+					Cost += (double)aOptions.NormalWeight * aOptions.NormalWeight * D;
+				}
+				if (aTexcoord != nullptr) {
+					double D = 0.0;
+					for (std::size_t k = 0; k < 2; k++) D += (double)(aTexcoord[2 * (std::size_t)aA + k] - aTexcoord[2 * (std::size_t)aB + k]) * (aTexcoord[2 * (std::size_t)aA + k] - aTexcoord[2 * (std::size_t)aB + k]);
+					Cost += (double)aOptions.TexcoordWeight * aOptions.TexcoordWeight * D;
+				}
+				return Cost;
+			};
+
+			struct candidate {
+				double 		Cost;
+				double 		Error; 			// Squared geometric error.
+				uint32_t 	From; 			// Vertex of the edge on the collapsing position.
+				uint32_t 	To;
+			};
+			double MaxError2 = (double)aOptions.MaxError * aOptions.MaxError;
+			double Extent2 = (double)Extent * Extent;
+			double Error2 = 0.0;
+			std::size_t TriangleCount = Index.size() / 3;
+			std::vector<uint32_t> First(aVertexCount + 1), Adjacent, Remap(aVertexCount);
+			std::vector<uint8_t> Locked(aVertexCount);
+			std::vector<candidate> Candidate;
+			std::vector<double> Best(aVertexCount);
+			std::vector<candidate> BestOf(aVertexCount);
+			std::vector<std::pair<uint32_t, uint32_t>> Pair;
+
+			// Each pass collapses the cheapest edges whose ends no other collapse of the pass
+			// touched, then rebuilds adjacency, until the target or the error limit is reached.
+			while (TriangleCount > aTargetTriangles) {
+				std::fill(First.begin(), First.end(), 0);
+				for (uint32_t V : Index) First[Weld[V] + 1]++;
+				for (std::size_t v = 0; v < aVertexCount; v++) First[v + 1] += First[v];
+				Adjacent.resize(Index.size());
+				{
+					std::vector<uint32_t> Fill(First.begin(), First.end() - 1);
+					for (std::size_t i = 0; i < Index.size(); i++) Adjacent[Fill[Weld[Index[i]]]++] = (uint32_t)(i / 3);
+				}
+
+				std::fill(Best.begin(), Best.end(), DBL_MAX);
+				for (std::size_t i = 0; i < Index.size(); i += 3) {
+					for (std::size_t k = 0; k < 3; k++) {
+						for (std::size_t d = 1; d < 3; d++) {
+							uint32_t U = Index[i + k], V = Index[i + (k + d) % 3];
+							uint32_t A = Weld[U], B = Weld[V];
+							if ((A == B) || (Kind[A] == LOCKED)) continue;
+							if ((Kind[A] == BORDER) && (EdgeCount[edge_key(A, B)] != 1)) continue;
+							if ((Kind[A] == SEAM) && (Kind[B] != SEAM) && (Kind[B] != LOCKED)) continue;
+							double Error = Quadric[A].error(position(V));
+							double Cost = Error / Extent2 + attribute_cost(U, V);
+							if (Cost < Best[A]) {
+								Best[A] = Cost;
+								BestOf[A] = { Cost, Error, U, V };
+							}
+						}
+					}
+				}
+				Candidate.clear();
+				for (uint32_t v = 0; v < aVertexCount; v++) if ((Best[v] < DBL_MAX) && (BestOf[v].Error <= MaxError2)) Candidate.push_back(BestOf[v]);
+				std::sort(Candidate.begin(), Candidate.end(), [](const candidate& aA, const candidate& aB) { return (aA.Cost < aB.Cost) || ((aA.Cost == aB.Cost) && (aA.From < aB.From)); });
+
+				std::iota(Remap.begin(), Remap.end(), 0u);
+				std::fill(Locked.begin(), Locked.end(), 0);
+				std::size_t Removed = 0, Collapsed = 0;
+				for (const candidate& C : Candidate) {
+					if (Removed >= TriangleCount - aTargetTriangles) break;
+					uint32_t A = Weld[C.From], B = Weld[C.To];
+					if (Locked[A] || Locked[B]) continue;
+
+					// Every wedge of A goes to the wedge of B it shares an edge with, a seam
+					// whose sides do not line up with B's wedges stays.
+					Pair.clear();
+					bool Mapped = true;
+					uint32_t W = C.From;
+					do {
+						uint32_t Partner = W == C.From ? C.To : UINT32_MAX;
+						for (uint32_t a = First[A]; (a < First[A + 1]) && (Partner == UINT32_MAX); a++) {
+							const uint32_t* T = &Index[3 * (std::size_t)Adjacent[a]];
+							for (std::size_t k = 0; k < 3; k++) {
+								if (T[k] != W) continue;
+								for (std::size_t d = 1; d < 3; d++) if (Weld[T[(k + d) % 3]] == B) Partner = T[(k + d) % 3];
+							}
+						}
+						if (Partner == UINT32_MAX) Mapped = false;
+						Pair.emplace_back(W, Partner);
+						W = WedgeNext[W];
+					} while (Mapped && (W != C.From));
+					if (!Mapped) continue;
+
+					// Triangles around A that stay must keep facing the same way.
+					bool Flipped = false;
+					std::size_t Degenerate = 0;
+					for (uint32_t a = First[A]; (a < First[A + 1]) && !Flipped; a++) {
+						const uint32_t* T = &Index[3 * (std::size_t)Adjacent[a]];
+						uint32_t P[3] = { Weld[Remap[T[0]]], Weld[Remap[T[1]]], Weld[Remap[T[2]]] };
+						if ((P[0] == P[1]) || (P[1] == P[2]) || (P[0] == P[2])) continue;
+						if ((P[0] == B) || (P[1] == B) || (P[2] == B)) {
+							Degenerate++;
+							continue;
+						}
+						const float* Old[3] = { position(P[0]), position(P[1]), position(P[2]) };
+						const float* New[3] = { Old[0], Old[1], Old[2] };
+						for (std::size_t k = 0; k < 3; k++) if (P[k] == A) New[k] = position(B);
+						double NO[3], NN[3];
+						detail::cross(Old[0], Old[1], Old[2], NO);
+						detail::cross(New[0], New[1], New[2], NN);
+						double Dot = NO[0] * NN[0] + NO[1] * NN[1] + NO[2] * NN[2];
+						double Scale = std::sqrt((NO[0] * NO[0] + NO[1] * NO[1] + NO[2] * NO[2]) * (NN[0] * NN[0] + NN[1] * NN[1] + NN[2] * NN[2]));
+						Flipped = Dot < 0.25 * Scale;
+					}
+					if (Flipped) continue;
+
+					for (const std::pair<uint32_t, uint32_t>& P : Pair) Remap[P.first] = P.second;
+					Quadric[B].add(Quadric[A]);
+					Locked[A] = 1;
+					Locked[B] = 1;
+					Removed += Degenerate;
+					Collapsed++;
+					Error2 = std::max(Error2, C.Error);
+				}
+				if (Collapsed == 0) break;
+
+				std::size_t Write = 0;
+				for (std::size_t i = 0; i < Index.size(); i += 3) {
+					uint32_t T[3] = { Remap[Index[i]], Remap[Index[i + 1]], Remap[Index[i + 2]] };
+					if ((Weld[T[0]] == Weld[T[1]]) || (Weld[T[1]] == Weld[T[2]]) || (Weld[T[0]] == Weld[T[2]])) continue;
+					std::copy_n(T, 3, Index.begin() + Write);
+					Write += 3;
+				}
+				Index.resize(Write);
+				TriangleCount = Index.size() / 3;
+			}
+			if (aError != nullptr) *aError = (float)std::sqrt(Error2);
+			return Index;
+		}
+
+	}
+
+	// Picks a level of detail per object from the projected size of each level's error
+	// estimate. An error e at distance d covers e * H / (2 d tan(fov / 2)) pixels of an
+	// H pixel high viewport. The coarsest level under Threshold pixels is used, but a
+	// switch to a coarser level waits until it is under Threshold * (1 - Hysteresis), so
+	// an object hovering at a boundary does not flip between levels every frame. The
+	// estimate is not a bound, so neither is its projection, a lower Threshold buys
+	// margin where popping matters.
+	class lod_selector {
+	public:
+
+		// aFieldOfView is vertical in degrees, as in a world file's Camera3D.
+		lod_selector(float aFieldOfView, float aViewportHeight, float aThreshold = 1.0f, float aHysteresis = 0.25f);
+
+		// Pixels covered by aError at aDistance, both in the same units.
+		float projected_error(float aError, float aDistance) const;
+		// Level to draw given the error of every level, finest first, and the level drawn
+		// last frame, SIZE_MAX when there was none.
+		std::size_t select(const float* aError, std::size_t aLevelCount, float aDistance, std::size_t aCurrent = SIZE_MAX) const;
+
+	private:
+
+		float 	PixelsPerUnit; 			// At unit distance.
+		float 	Threshold;
+		float 	Hysteresis;
+
+	};
+
+	// ---------- lod_selector ---------- //
+
+	inline lod_selector::lod_selector(float aFieldOfView, float aViewportHeight, float aThreshold, float aHysteresis) {
+		PixelsPerUnit = aViewportHeight / (2.0f * std::tan(aFieldOfView * 3.14159265358979f / 360.0f));
+		Threshold = aThreshold;
+		Hysteresis = aHysteresis;
+	}
+
+	inline float lod_selector::projected_error(float aError, float aDistance) const {
+		return aError * PixelsPerUnit / std::max(aDistance, FLT_MIN);
+	}
+
+	inline std::size_t lod_selector::select(const float* aError, std::size_t aLevelCount, float aDistance, std::size_t aCurrent) const {
+		if (aLevelCount == 0) return 0;
+		std::size_t Fine = 0, Coarse = 0;
+		for (std::size_t l = 1; l < aLevelCount; l++) {
+			float Pixels = this->projected_error(aError[l], aDistance);
+			if (Pixels <= Threshold) Fine = l;
+			if (Pixels <= Threshold * (1.0f - Hysteresis)) Coarse = l;
+		}
+		// Finer levels are taken at once, coarser ones only past the band.
+		if ((aCurrent == SIZE_MAX) || (aCurrent >= aLevelCount)) return Coarse;
+		if (Fine < aCurrent) return Fine;
+		return std::max(aCurrent, Coarse);
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_MESH_LOD_H
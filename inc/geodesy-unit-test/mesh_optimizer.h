@@ -0,0 +1,954 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_MESH_OPTIMIZER_H
+#define GEODESY_UNIT_TEST_MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <type_traits>
+
+#include <geodesy-unit-test/gltf.h>
+#include <geodesy-unit-test/mapped_file.h>
+#include <geodesy-unit-test/cache_file.h>
+#include <geodesy-unit-test/mesh_lod.h>
+#include <geodesy-unit-test/profiler.h>
+#include <geodesy-unit-test/texture_cache.h>
+
+namespace geodesy::io {
+
+	// Post-transform vertex cache behaviour of an index buffer. ACMR is vertex shader
+	// invocations per triangle (0.5 is the ideal for a regular grid, 3 the worst), ATVR
+	// invocations per referenced vertex (1 is the ideal).
+	struct vertex_cache_statistics {
+		double 			ACMR;
+		double 			ATVR;
+		std::size_t 	Misses;
+	};
+
+	// Simulates a FIFO cache of aCacheSize entries, as fixed function hardware has.
+	vertex_cache_statistics analyze_vertex_cache(const std::vector<uint32_t>& aIndex, std::size_t aVertexCount, std::size_t aCacheSize = 16);
+	// Reorders the triangles of a list so vertices are reused while they are still in the
+	// cache, with Forsyth's linear speed scoring. Triangles keep their winding.
+	void optimize_vertex_cache(std::vector<uint32_t>& aIndex, std::size_t aVertexCount);
+	// Renumbers vertices in order of first use so vertex fetch walks memory forwards.
+	// aRemap receives the new index of every old vertex, UINT32_MAX for vertices no
+	// triangle uses, which are dropped. Returns the new vertex count.
+	std::size_t optimize_vertex_fetch(std::vector<uint32_t>& aIndex, std::size_t aVertexCount, std::vector<uint32_t>& aRemap);
+
+	// Up to 256 vertices and a run of triangles indexing them with 8 bit local indices,
+	// the unit a mesh shader or a cluster culling pass works on.
+	struct meshlet {
+		uint32_t 	VertexOffset; 			// Into optimized_mesh::MeshletVertex.
+		uint32_t 	TriangleOffset; 		// Into optimized_mesh::MeshletTriangle, three bytes per triangle.
+		uint32_t 	VertexCount;
+		uint32_t 	TriangleCount;
+		float 		Center[3];
+		float 		Radius;
+		float 		ConeAxis[3]; 			// Average triangle normal.
+		float 		ConeCutoff; 			// Sine of the normals' spread around the axis, 1 when they span a half space.
+
+		// True when every triangle faces away from a camera at aCamera (object space).
+		bool backfacing(const float aCamera[3]) const;
+	};
+
+	// A coarser index list over the vertices of the full mesh, and the estimate of the
+	// geometric error it shows against it in object space units (see simplify), what
+	// lod_selector projects to the screen.
+	struct lod_level {
+		uint32_t 	IndexOffset; 			// Into optimized_mesh::LodIndex.
+		uint32_t 	IndexCount;
+		float 		Error;
+		uint32_t 	Reserved;
+	};
+
+	// Import pipeline settings. Everything that changes the output is part of the cache key.
+	struct mesh_options {
+		bool 		Reorder 			= true; 		// Vertex cache then vertex fetch order.
+		bool 		Quantize 			= false; 		// 16 byte vertices instead of 32.
+		uint32_t 	MeshletVertices 	= 64;
+		uint32_t 	MeshletTriangles 	= 124; 			// 0 builds no meshlets.
+		uint32_t 	CacheSize 			= 16; 			// FIFO size the statistics are measured with.
+		uint32_t 	LodCount 			= 0; 			// Levels simplified below the full mesh.
+		float 		LodRatio 			= 0.5f; 		// Triangles of a level relative to the one above.
+		float 		LodMaxError 		= 0.05f; 		// Error estimate limit of the coarsest level, relative to the primitive's extent.
+	};
+
+	// Vertex and index data of a primitive as the engine would upload it.
+	struct mesh_statistics {
+		uint64_t 	VertexCount;
+		uint64_t 	TriangleCount;
+		uint64_t 	VertexBytes;
+		uint64_t 	IndexBytes;
+		double 		ACMR;
+		double 		ATVR;
+	};
+
+	// One triangle list primitive of a glTF model after the import pipeline. Vertices are
+	// either float streams (Position, Normal, Texcoord) or, quantized, position as unorm16
+	// over the primitive's bounds (x, y, z, pad), normal as octahedral snorm16 pairs and
+	// texcoord as half float pairs. position(), normal() and texcoord() decode either form.
+	// Level 0 of detail is Index, coarser levels index the same vertices from LodIndex.
+	// Skinned primitives carry JOINTS_0 and WEIGHTS_0 unquantized, other attributes are
+	// not imported.
+	struct optimized_mesh {
+		uint32_t 				Mesh;
+		uint32_t 				Primitive;
+		uint32_t 				VertexCount;
+		bool 					Quantized;
+		std::vector<float> 		Position; 			// 3 per vertex.
+		std::vector<float> 		Normal; 			// 3 per vertex.
+		std::vector<float> 		Texcoord; 			// 2 per vertex.
+		std::vector<uint16_t> 	PackedPosition; 	// 4 per vertex.
+		std::vector<uint32_t> 	PackedNormal;
+		std::vector<uint32_t> 	PackedTexcoord;
+		float 					PositionOffset[3]; 	// Position = Offset + Scale * PackedPosition.
+		float 					PositionScale[3];
+		std::vector<uint16_t> 	Joint; 				// 4 per vertex, empty unless skinned.
+		std::vector<float> 		Weight; 			// 4 per vertex, empty unless skinned.
+		std::vector<uint32_t> 	Index;
+		std::vector<meshlet> 	Meshlet;
+		std::vector<uint32_t> 	MeshletVertex;
+		std::vector<uint8_t> 	MeshletTriangle;
+		std::vector<lod_level> 	Lod; 				// Levels 1 and up, finest first.
+		std::vector<uint32_t> 	LodIndex;
+		mesh_statistics 		Before; 			// As authored, converted to float vertices.
+		mesh_statistics 		After;
+
+		optimized_mesh();
+
+		void position(std::size_t aVertex, float aOut[3]) const;
+		void normal(std::size_t aVertex, float aOut[3]) const;
+		void texcoord(std::size_t aVertex, float aOut[2]) const;
+		// Bytes of one vertex across all streams.
+		std::size_t vertex_stride() const;
+		std::size_t meshlet_bytes() const;
+		// Levels including the full mesh, and their errors for lod_selector::select().
+		std::size_t lod_count() const;
+		std::vector<float> lod_error() const;
+		// Triangles and first index of level aLevel.
+		std::size_t lod_triangles(std::size_t aLevel) const;
+		const uint32_t* lod_index(std::size_t aLevel) const;
+	};
+
+	// Runs the import pipeline on one primitive. Throws std::runtime_error for primitives
+	// that are not triangle lists or have no positions, std::invalid_argument for meshlet
+	// limits outside [3, 256] vertices or a LodRatio outside (0, 1).
+	optimized_mesh optimize_mesh(const gltf& aModel, std::size_t aMesh, std::size_t aPrimitive, const mesh_options& aOptions = mesh_options());
+
+	// Timings of a mesh_cache load in milliseconds and the statistics of every primitive.
+	struct mesh_report {
+		struct entry {
+			uint32_t 			Mesh;
+			uint32_t 			Primitive;
+			std::size_t 		MeshletCount;
+			mesh_statistics 	Before;
+			mesh_statistics 	After;
+			std::vector<lod_level> 	Lod;
+		};
+
+		std::string 			Path;
+		bool 					Hit;
+		bool 					Stored;
+		double 					Read; 				// Loading and hashing the model.
+		double 					Optimize;
+		double 					Cache; 				// Reading a hit, or writing a miss.
+		double 					Total;
+		std::vector<entry> 		Entry;
+
+		// Vertex and index bytes of every primitive, as authored and as optimized.
+		uint64_t bytes_before() const;
+		uint64_t bytes_after() const;
+		std::string to_string() const;
+	};
+
+	// Content addressed on-disk cache of optimized models, next to texture_cache. The key
+	// hashes the glTF document and every buffer it uses with the options and cache
+	// version. An entry holds every triangle list primitive of the model:
+	//
+	//	header | record[RecordCount] | streams of each primitive (from a 16 byte aligned
+	//	DataOffset, each stream padded to a multiple of 4 bytes)
+	//
+	// Entries that fail validation are ignored and rewritten, the cache never makes a load
+	// fail. Primitives that are not triangle lists are skipped.
+	class mesh_cache {
+	public:
+
+		static constexpr uint32_t Version = 2;
+		static constexpr char Magic[8] = { 'G', 'E', 'O', 'M', 'E', 'S', 'H', '\0' };
+		static constexpr std::size_t StreamCount = 14;
+
+		struct header {
+			char 		Magic[8];
+			uint32_t 	Version;
+			uint32_t 	ByteOrder; 				// 0x01020304 as written by the storing host.
+			uint64_t 	Key;
+			uint32_t 	RecordCount;
+			uint32_t 	Reserved;
+			uint64_t 	DataOffset;
+			uint64_t 	DataSize;
+		};
+
+		struct record {
+			uint32_t 			Mesh;
+			uint32_t 			Primitive;
+			uint32_t 			VertexCount;
+			uint32_t 			Quantized;
+			float 				PositionOffset[3];
+			float 				PositionScale[3];
+			mesh_statistics 	Before;
+			mesh_statistics 	After;
+			uint64_t 			Count[StreamCount]; 	// Elements of each stream, in stream order.
+			uint64_t 			Offset; 				// From DataOffset.
+		};
+
+		// Entries are kept in aDirectory, created on first store.
+		mesh_cache(const std::string& aDirectory);
+
+		// Loads a .gltf or .glb and returns its optimized primitives in mesh, primitive order.
+		std::vector<optimized_mesh> load(const std::string& aPath, const mesh_options& aOptions = mesh_options(), mesh_report* aReport = nullptr) const;
+
+		static uint64_t key(const uint8_t* aDocument, std::size_t aSize, const gltf& aModel, const mesh_options& aOptions);
+		std::string path_for(uint64_t aKey) const;
+
+	private:
+
+		std::filesystem::path 	Directory;
+
+		bool read(const std::string& aPath, uint64_t aKey, std::vector<optimized_mesh>& aMesh) const;
+		bool store(const std::string& aPath, uint64_t aKey, const std::vector<optimized_mesh>& aMesh) const;
+
+	};
+
+	static_assert(std::is_trivially_copyable_v<meshlet> && (sizeof(meshlet) % 4 == 0), "Meshlet must be a packed POD.");
+	static_assert(std::is_trivially_copyable_v<lod_level> && (sizeof(lod_level) % 4 == 0), "LOD level must be a packed POD.");
+	static_assert(std::is_trivially_copyable_v<mesh_cache::header> && (sizeof(mesh_cache::header) % 8 == 0), "Mesh cache header must be a packed POD.");
+	static_assert(std::is_trivially_copyable_v<mesh_cache::record> && (sizeof(mesh_cache::record) % 8 == 0), "Mesh cache record must be a packed POD.");
+
+	namespace detail {
+
+		// IEEE half from float, round to nearest even, overflow to infinity.
+		inline uint16_t to_half(float aValue) {
+			uint32_t F;
+			std::memcpy(&F, &aValue, 4);
+			uint16_t Sign = (uint16_t)((F >> 16) & 0x8000u);
+			uint32_t Abs = F & 0x7FFFFFFFu;
+			if (Abs > 0x7F800000u) return Sign | 0x7E00u;
+			if (Abs >= 0x477FF000u) return Sign | 0x7C00u;
+			if (Abs < 0x38800000u) {
+				// Below the smallest normal half, in units of 2^-24.
+				float Magnitude;
+				std::memcpy(&Magnitude, &Abs, 4);
+				return Sign | (uint16_t)std::lrint(Magnitude * 16777216.0f);
+			}
+			uint32_t Half = (Abs - 0x38000000u) >> 13;
+			uint32_t Rest = Abs & 0x1FFFu;
+			if ((Rest > 0x1000u) || ((Rest == 0x1000u) && (Half & 1u))) Half++;
+			return Sign | (uint16_t)Half;
+		}
+
+		inline float from_half(uint16_t aValue) {
+			uint32_t Sign = (uint32_t)(aValue & 0x8000u) << 16;
+			uint32_t Exponent = (aValue >> 10) & 0x1Fu;
+			uint32_t Mantissa = aValue & 0x3FFu;
+			if (Exponent == 0) {
+				float Magnitude = (float)Mantissa / 16777216.0f;
+				return Sign ? -Magnitude : Magnitude;
+			}
+			uint32_t F = Exponent == 31 ? Sign | 0x7F800000u | (Mantissa << 13) : Sign | ((Exponent + 112) << 23) | (Mantissa << 13);
+			float Value;
+			std::memcpy(&Value, &F, 4);
+			return Value;
+		}
+
+		// Unit vector on the octahedron folded into [-1, 1]^2, as two snorm16 in one word.
+		inline uint32_t encode_octahedral(const float aNormal[3]) {
+			float L1 = std::abs(aNormal[0]) + std::abs(aNormal[1]) + std::abs(aNormal[2]);
+			float X = L1 > 0.0f ? aNormal[0] / L1 : 0.0f, Y = L1 > 0.0f ? aNormal[1] / L1 : 0.0f;
+			if (aNormal[2] < 0.0f) {
+				float FX = (1.0f - std::abs(Y)) * (X >= 0.0f ? 1.0f : -1.0f);
+				float FY = (1.0f - std::abs(X)) * (Y >= 0.0f ? 1.0f : -1.0f);
+				X = FX;
+				Y = FY;
+			}
+			int16_t QX = (int16_t)std::lround(std::clamp(X, -1.0f, 1.0f) * 32767.0f);
+			int16_t QY = (int16_t)std::lround(std::clamp(Y, -1.0f, 1.0f) * 32767.0f);
+			return (uint32_t)(uint16_t)QX | ((uint32_t)(uint16_t)QY << 16);
+		}
+
+		inline void decode_octahedral(uint32_t aPacked, float aOut[3]) {
+			float X = std::max((float)(int16_t)(aPacked & 0xFFFFu) / 32767.0f, -1.0f);
+			float Y = std::max((float)(int16_t)(aPacked >> 16) / 32767.0f, -1.0f);
+			float Z = 1.0f - std::abs(X) - std::abs(Y);
+			float T = std::max(-Z, 0.0f);
+			X += X >= 0.0f ? -T : T;
+			Y += Y >= 0.0f ? -T : T;
+			float Length = std::sqrt(X * X + Y * Y + Z * Z);
+			aOut[0] = X / Length;
+			aOut[1] = Y / Length;
+			aOut[2] = Z / Length;
+		}
+
+		// Moves the vertices of a stream with aComponents values per vertex to their new index.
+		template <typename T>
+		inline void remap_stream(std::vector<T>& aStream, std::size_t aComponents, const std::vector<uint32_t>& aRemap, std::size_t aVertexCount) {
+			if (aStream.empty()) return;
+			std::vector<T> Moved(aVertexCount * aComponents);
+			for (std::size_t v = 0; v < aRemap.size(); v++) {
+				if (aRemap[v] == UINT32_MAX) continue;
+				std::copy_n(aStream.begin() + v * aComponents, aComponents, Moved.begin() + (std::size_t)aRemap[v] * aComponents);
+			}
+			aStream = std::move(Moved);
+		}
+
+		// Stream sizes agree with the vertex count and every index stays in range.
+		inline bool consistent(const optimized_mesh& aMesh) {
+			std::size_t V = aMesh.VertexCount;
+			bool Sized = aMesh.Quantized ?
+				(aMesh.PackedPosition.size() == 4 * V) && (aMesh.PackedNormal.size() == V) && (aMesh.PackedTexcoord.size() == V) && aMesh.Position.empty() && aMesh.Normal.empty() && aMesh.Texcoord.empty() :
+				(aMesh.Position.size() == 3 * V) && (aMesh.Normal.size() == 3 * V) && (aMesh.Texcoord.size() == 2 * V) && aMesh.PackedPosition.empty() && aMesh.PackedNormal.empty() && aMesh.PackedTexcoord.empty();
+			Sized = Sized && (aMesh.Joint.size() == aMesh.Weight.size()) && (aMesh.Joint.empty() || (aMesh.Joint.size() == 4 * V)) && (aMesh.Index.size() % 3 == 0);
+			if (!Sized) return false;
+			for (uint32_t I : aMesh.Index) if (I >= V) return false;
+			for (uint32_t I : aMesh.MeshletVertex) if (I >= V) return false;
+			for (const meshlet& M : aMesh.Meshlet) {
+				if ((M.VertexOffset > aMesh.MeshletVertex.size()) || (M.VertexCount > aMesh.MeshletVertex.size() - M.VertexOffset)) return false;
+				if ((M.TriangleOffset > aMesh.MeshletTriangle.size()) || (3 * (std::size_t)M.TriangleCount > aMesh.MeshletTriangle.size() - M.TriangleOffset)) return false;
+				for (std::size_t t = 0; t < 3 * (std::size_t)M.TriangleCount; t++) if (aMesh.MeshletTriangle[M.TriangleOffset + t] >= M.VertexCount) return false;
+			}
+			for (uint32_t I : aMesh.LodIndex) if (I >= V) return false;
+			for (const lod_level& L : aMesh.Lod) {
+				if ((L.IndexOffset > aMesh.LodIndex.size()) || (L.IndexCount > aMesh.LodIndex.size() - L.IndexOffset) || (L.IndexCount % 3 != 0)) return false;
+			}
+			return true;
+		}
+
+		// Calls aFunction on every stream of a mesh in file order.
+		template <typename M, typename F>
+		inline void each_stream(M& aMesh, F&& aFunction) {
+			aFunction(aMesh.Position);
+			aFunction(aMesh.Normal);
+			aFunction(aMesh.Texcoord);
+			aFunction(aMesh.PackedPosition);
+			aFunction(aMesh.PackedNormal);
+			aFunction(aMesh.PackedTexcoord);
+			aFunction(aMesh.Joint);
+			aFunction(aMesh.Weight);
+			aFunction(aMesh.Index);
+			aFunction(aMesh.Meshlet);
+			aFunction(aMesh.MeshletVertex);
+			aFunction(aMesh.MeshletTriangle);
+			aFunction(aMesh.Lod);
+			aFunction(aMesh.LodIndex);
+		}
+
+		inline void build_meshlets(optimized_mesh& aMesh, std::size_t aMaxVertices, std::size_t aMaxTriangles) {
+			// Triangles are taken in index order, which after vertex cache ordering already
+			// keeps neighbours together, and a meshlet is closed when the next triangle
+			// would exceed either limit.
+			std::vector<uint32_t> Slot(aMesh.VertexCount, UINT32_MAX);
+			meshlet Current{};
+			auto finish = [&]() {
+				if (Current.TriangleCount == 0) return;
+				float Low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, High[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				for (uint32_t i = 0; i < Current.VertexCount; i++) {
+					const float* P = &aMesh.Position[3 * (std::size_t)aMesh.MeshletVertex[Current.VertexOffset + i]];
+					for (std::size_t k = 0; k < 3; k++) {
+						Low[k] = std::min(Low[k], P[k]);
+						High[k] = std::max(High[k], P[k]);
+					}
+				}
+				float Radius2 = 0.0f;
+				for (std::size_t k = 0; k < 3; k++) Current.Center[k] = 0.5f * (Low[k] + High[k]);
+				for (uint32_t i = 0; i < Current.VertexCount; i++) {
+					const float* P = &aMesh.Position[3 * (std::size_t)aMesh.MeshletVertex[Current.VertexOffset + i]];
+					float D2 = 0.0f;
+					for (std::size_t k = 0; k < 3; k++) D2 += (P[k] - Current.Center[k]) * (P[k] - Current.Center[k]);
+					Radius2 = std::max(Radius2, D2);
+				}
+				Current.Radius = std::sqrt(Radius2);
+
+				// Normal cone of the triangles, degenerate ones left out.
+				std::vector<float> Normal;
+				float Axis[3] = { 0.0f, 0.0f, 0.0f };
+				for (uint32_t t = 0; t < Current.TriangleCount; t++) {
+					const uint8_t* Local = &aMesh.MeshletTriangle[Current.TriangleOffset + 3 * (std::size_t)t];
+					const float* A = &aMesh.Position[3 * (std::size_t)aMesh.MeshletVertex[Current.VertexOffset + Local[0]]];
+					const float* B = &aMesh.Position[3 * (std::size_t)aMesh.MeshletVertex[Current.VertexOffset + Local[1]]];
+					const float* C = &aMesh.Position[3 * (std::size_t)aMesh.MeshletVertex[Current.VertexOffset + Local[2]]];
+					float E[3] = { B[0] - A[0], B[1] - A[1], B[2] - A[2] }, F[3] = { C[0] - A[0], C[1] - A[1], C[2] - A[2] };
+					float N[3] = { E[1] * F[2] - E[2] * F[1], E[2] * F[0] - E[0] * F[2], E[0] * F[1] - E[1] * F[0] };
+					float Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+					if (Length == 0.0f) continue;
+					for (std::size_t k = 0; k < 3; k++) {
+						Normal.push_back(N[k] / Length);
+						Axis[k] += N[k] / Length;
+					}
+				}
+				float Length = std::sqrt(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+				float MinDot = 1.0f;
+				for (std::size_t k = 0; k < 3; k++) Current.ConeAxis[k] = Length > 0.0f ? Axis[k] / Length : 0.0f;
+				for (std::size_t n = 0; n < Normal.size(); n += 3) {
+					MinDot = std::min(MinDot, Normal[n] * Current.ConeAxis[0] + Normal[n + 1] * Current.ConeAxis[1] + Normal[n + 2] * Current.ConeAxis[2]);
+				}
+				Current.ConeCutoff = (Length > 0.0f) && (MinDot > 0.0f) ? std::sqrt(1.0f - MinDot * MinDot) : 1.0f;
+
+				for (uint32_t i = 0; i < Current.VertexCount; i++) Slot[aMesh.MeshletVertex[Current.VertexOffset + i]] = UINT32_MAX;
+				aMesh.Meshlet.push_back(Current);
+				Current = meshlet{};
+				Current.VertexOffset = (uint32_t)aMesh.MeshletVertex.size();
+				Current.TriangleOffset = (uint32_t)aMesh.MeshletTriangle.size();
+			};
+			for (std::size_t i = 0; i + 2 < aMesh.Index.size(); i += 3) {
+				const uint32_t* T = &aMesh.Index[i];
+				uint32_t New = (Slot[T[0]] == UINT32_MAX ? 1 : 0) + ((Slot[T[1]] == UINT32_MAX) && (T[1] != T[0]) ? 1 : 0) + ((Slot[T[2]] == UINT32_MAX) && (T[2] != T[0]) && (T[2] != T[1]) ? 1 : 0);
+				if ((Current.VertexCount + New > aMaxVertices) || (Current.TriangleCount + 1 > aMaxTriangles)) finish();
+				for (std::size_t k = 0; k < 3; k++) {
+					if (Slot[T[k]] == UINT32_MAX) {
+						Slot[T[k]] = Current.VertexCount++;
+						aMesh.MeshletVertex.push_back(T[k]);
+					}
+					aMesh.MeshletTriangle.push_back((uint8_t)Slot[T[k]]);
+				}
+				Current.TriangleCount++;
+			}
+			finish();
+		}
+
+	}
+
+	// ---------- vertex cache ---------- //
+
+	inline vertex_cache_statistics analyze_vertex_cache(const std::vector<uint32_t>& aIndex, std::size_t aVertexCount, std::size_t aCacheSize) {
+		// A vertex is still cached while fewer than aCacheSize misses happened since its own.
+		std::vector<std::size_t> Stamp(aVertexCount, 0);
+		std::size_t Time = aCacheSize + 1, Misses = 0, Unique = 0;
+		for (uint32_t V : aIndex) {
+			if (V >= aVertexCount) throw std::out_of_range("analyze_vertex_cache: index " + std::to_string(V) + " out of range");
+			if (Time - Stamp[V] <= aCacheSize) continue;
+			Unique += Stamp[V] == 0 ? 1 : 0;
+			Stamp[V] = Time++;
+			Misses++;
+		}
+		vertex_cache_statistics Statistics{ 0.0, 0.0, Misses };
+		if (aIndex.size() >= 3) Statistics.ACMR = (double)Misses / (double)(aIndex.size() / 3);
+		if (Unique > 0) Statistics.ATVR = (double)Misses / (double)Unique;
+		return Statistics;
+	}
+
+	inline void optimize_vertex_cache(std::vector<uint32_t>& aIndex, std::size_t aVertexCount) {
+		GEODESY_PROFILE_SCOPE("asset", "mesh.vertex_cache");
+		const std::size_t TriangleCount = aIndex.size() / 3;
+		if (TriangleCount == 0) return;
+		for (uint32_t V : aIndex) if (V >= aVertexCount) throw std::out_of_range("optimize_vertex_cache: index " + std::to_string(V) + " out of range");
+
+		// Scores of a vertex by its position in a 32 entry LRU cache and by how many of its
+		// triangles are left, so lone vertices get finished off.
+		constexpr std::size_t CacheSize = 32;
+		constexpr std::size_t ValenceSize = 32;
+		float CacheScore[CacheSize], ValenceScore[ValenceSize];
+		for (std::size_t i = 0; i < CacheSize; i++) CacheScore[i] = i < 3 ? 0.75f : std::pow(1.0f - (float)(i - 3) / (float)(CacheSize - 3), 1.5f);
+		for (std::size_t i = 0; i < ValenceSize; i++) ValenceScore[i] = i == 0 ? 0.0f : 2.0f / std::sqrt((float)i);
+		auto score = [&](int32_t aPosition, uint32_t aRemaining) {
+			if (aRemaining == 0) return -1.0f;
+			float Score = aPosition >= 0 ? CacheScore[aPosition] : 0.0f;
+			return Score + (aRemaining < ValenceSize ? ValenceScore[aRemaining] : 2.0f / std::sqrt((float)aRemaining));
+		};
+
+		// Triangles of every vertex, the live ones first in each range.
+		std::vector<uint32_t> First(aVertexCount + 1, 0), Remaining(aVertexCount, 0), Adjacent(aIndex.size());
+		for (uint32_t V : aIndex) Remaining[V]++;
+		for (std::size_t v = 0; v < aVertexCount; v++) First[v + 1] = First[v] + Remaining[v];
+		{
+			std::vector<uint32_t> Fill(First.begin(), First.end() - 1);
+			for (std::size_t i = 0; i < aIndex.size(); i++) Adjacent[Fill[aIndex[i]]++] = (uint32_t)(i / 3);
+		}
+		std::vector<int32_t> Position(aVertexCount, -1);
+		std::vector<float> VertexScore(aVertexCount), TriangleScore(TriangleCount, 0.0f);
+		std::vector<uint8_t> Emitted(TriangleCount, 0);
+		for (std::size_t v = 0; v < aVertexCount; v++) VertexScore[v] = score(-1, Remaining[v]);
+		for (std::size_t i = 0; i < aIndex.size(); i++) TriangleScore[i / 3] += VertexScore[aIndex[i]];
+
+		std::vector<uint32_t> Output;
+		Output.reserve(aIndex.size());
+		uint32_t Cache[CacheSize + 3], Next[CacheSize + 3];
+		std::size_t CacheCount = 0, Cursor = 0;
+		std::size_t Best = SIZE_MAX;
+		for (std::size_t Done = 0; Done < TriangleCount; Done++) {
+			// Dead end, nothing in the cache has triangles left: resume in input order.
+			if (Best == SIZE_MAX) {
+				while (Emitted[Cursor]) Cursor++;
+				Best = Cursor;
+			}
+			const uint32_t* T = &aIndex[3 * Best];
+			Output.insert(Output.end(), T, T + 3);
+			Emitted[Best] = 1;
+			for (std::size_t k = 0; k < 3; k++) {
+				uint32_t V = T[k];
+				uint32_t* Begin = &Adjacent[First[V]];
+				uint32_t* Last = Begin + Remaining[V] - 1;
+				uint32_t* Found = std::find(Begin, Last, (uint32_t)Best);
+				std::swap(*Found, *Last);
+				Remaining[V]--;
+			}
+
+			// The triangle's vertices move to the front, the rest of the cache follows them.
+			std::size_t NextCount = 0;
+			for (std::size_t k = 0; k < 3; k++) {
+				if (std::find(Next, Next + NextCount, T[k]) == Next + NextCount) Next[NextCount++] = T[k];
+			}
+			for (std::size_t c = 0; c < CacheCount; c++) {
+				if ((Cache[c] != T[0]) && (Cache[c] != T[1]) && (Cache[c] != T[2])) Next[NextCount++] = Cache[c];
+			}
+			for (std::size_t c = 0; c < NextCount; c++) Position[Next[c]] = c < CacheSize ? (int32_t)c : -1;
+			std::copy(Next, Next + NextCount, Cache);
+
+			// Rescore what moved, the best live triangle of a cached vertex goes next.
+			Best = SIZE_MAX;
+			float BestScore = -FLT_MAX;
+			for (std::size_t c = 0; c < NextCount; c++) {
+				uint32_t V = Cache[c];
+				float Score = score(Position[V], Remaining[V]);
+				float Delta = Score - VertexScore[V];
+				VertexScore[V] = Score;
+				for (uint32_t a = First[V]; a < First[V] + Remaining[V]; a++) {
+					uint32_t Triangle = Adjacent[a];
+					TriangleScore[Triangle] += Delta;
+					if ((c < CacheSize) && (TriangleScore[Triangle] > BestScore)) {
+						BestScore = TriangleScore[Triangle];
+						Best = Triangle;
+					}
+				}
+			}
+			CacheCount = std::min(NextCount, CacheSize);
+		}
+		aIndex = std::move(Output);
+	}
+
+	inline std::size_t optimize_vertex_fetch(std::vector<uint32_t>& aIndex, std::size_t aVertexCount, std::vector<uint32_t>& aRemap) {
+		aRemap.assign(aVertexCount, UINT32_MAX);
+		uint32_t Count = 0;
+		for (uint32_t& V : aIndex) {
+			if (V >= aVertexCount) throw std::out_of_range("optimize_vertex_fetch: index " + std::to_string(V) + " out of range");
+			if (aRemap[V] == UINT32_MAX) aRemap[V] = Count++;
+			V = aRemap[V];
+		}
+		return Count;
+	}
+
+	// ---------- meshlet ---------- //
+
+	inline bool meshlet::backfacing(const float aCamera[3]) const {
+		float D[3] = { Center[0] - aCamera[0], Center[1] - aCamera[1], Center[2] - aCamera[2] };
+		float Distance = std::sqrt(D[0] * D[0] + D[1] * D[1] + D[2] * D[2]);
+		return D[0] * ConeAxis[0] + D[1] * ConeAxis[1] + D[2] * ConeAxis[2] >= ConeCutoff * Distance + Radius;
+	}
+
+	// ---------- optimized_mesh ---------- //
+
+	inline optimized_mesh::optimized_mesh() {
+		Mesh = 0;
+		Primitive = 0;
+		VertexCount = 0;
+		Quantized = false;
+		for (std::size_t k = 0; k < 3; k++) {
+			PositionOffset[k] = 0.0f;
+			PositionScale[k] = 0.0f;
+		}
+		Before = mesh_statistics{};
+		After = mesh_statistics{};
+	}
+
+	inline void optimized_mesh::position(std::size_t aVertex, float aOut[3]) const {
+		for (std::size_t k = 0; k < 3; k++) aOut[k] = Quantized ? PositionOffset[k] + PositionScale[k] * (float)PackedPosition[4 * aVertex + k] : Position[3 * aVertex + k];
+	}
+
+	inline void optimized_mesh::normal(std::size_t aVertex, float aOut[3]) const {
+		if (Quantized) detail::decode_octahedral(PackedNormal[aVertex], aOut);
+		else for (std::size_t k = 0; k < 3; k++) aOut[k] = Normal[3 * aVertex + k];
+	}
+
+	inline void optimized_mesh::texcoord(std::size_t aVertex, float aOut[2]) const {
+		for (std::size_t k = 0; k < 2; k++) aOut[k] = Quantized ? detail::from_half((uint16_t)(PackedTexcoord[aVertex] >> (16 * k))) : Texcoord[2 * aVertex + k];
+	}
+
+	inline std::size_t optimized_mesh::vertex_stride() const {
+		std::size_t Stride = Quantized ? 8 + 4 + 4 : 12 + 12 + 8;
+		if (!Joint.empty()) Stride += 4 * sizeof(uint16_t) + 4 * sizeof(float);
+		return Stride;
+	}
+
+	inline std::size_t optimized_mesh::meshlet_bytes() const {
+		return Meshlet.size() * sizeof(meshlet) + MeshletVertex.size() * sizeof(uint32_t) + MeshletTriangle.size();
+	}
+
+	inline std::size_t optimized_mesh::lod_count() const {
+		return 1 + Lod.size();
+	}
+
+	inline std::vector<float> optimized_mesh::lod_error() const {
+		std::vector<float> Error(1, 0.0f);
+		for (const lod_level& L : Lod) Error.push_back(L.Error);
+		return Error;
+	}
+
+	inline std::size_t optimized_mesh::lod_triangles(std::size_t aLevel) const {
+		return aLevel == 0 ? Index.size() / 3 : Lod[aLevel - 1].IndexCount / 3;
+	}
+
+	inline const uint32_t* optimized_mesh::lod_index(std::size_t aLevel) const {
+		return aLevel == 0 ? Index.data() : LodIndex.data() + Lod[aLevel - 1].IndexOffset;
+	}
+
+	// ---------- optimize_mesh ---------- //
+
+	inline optimized_mesh optimize_mesh(const gltf& aModel, std::size_t aMesh, std::size_t aPrimitive, const mesh_options& aOptions) {
+		GEODESY_PROFILE_SCOPE("asset", "mesh.optimize");
+		if ((aMesh >= aModel.Mesh.size()) || (aPrimitive >= aModel.Mesh[aMesh].Primitive.size())) throw std::out_of_range("optimize_mesh: primitive " + std::to_string(aMesh) + "." + std::to_string(aPrimitive) + " not found");
+		if ((aOptions.MeshletTriangles > 0) && ((aOptions.MeshletVertices < 3) || (aOptions.MeshletVertices > 256))) throw std::invalid_argument("optimize_mesh: meshlets need 3 to 256 vertices");
+		if ((aOptions.LodCount > 0) && !((aOptions.LodRatio > 0.0f) && (aOptions.LodRatio < 1.0f))) throw std::invalid_argument("optimize_mesh: LOD ratio must be in (0, 1)");
+		const gltf::primitive& Primitive = aModel.Mesh[aMesh].Primitive[aPrimitive];
+		std::size_t Source = Primitive.attribute("POSITION");
+		if (Primitive.Mode != 4) throw std::runtime_error("optimize_mesh: primitive mode " + std::to_string(Primitive.Mode) + " is not a triangle list");
+		if (Source == SIZE_MAX) throw std::runtime_error("optimize_mesh: primitive without positions");
+		// gltf::load checks these, a hand-built model may not.
+		for (const std::pair<std::string, std::size_t>& A : Primitive.Attribute) if (A.second >= aModel.Accessor.size()) throw std::out_of_range("optimize_mesh: attribute " + A.first + " references a missing accessor");
+		if ((Primitive.Indices != SIZE_MAX) && (Primitive.Indices >= aModel.Accessor.size())) throw std::out_of_range("optimize_mesh: index accessor not found");
+
+		optimized_mesh Mesh;
+		Mesh.Mesh = (uint32_t)aMesh;
+		Mesh.Primitive = (uint32_t)aPrimitive;
+		std::size_t VertexCount = aModel.Accessor[Source].Count;
+		Mesh.VertexCount = (uint32_t)VertexCount;
+		// Missing attributes get the defaults the engine would fill in.
+		auto read = [&](const char* aName, std::vector<float>& aOut, std::size_t aComponents, float aDefault) {
+			std::size_t Accessor = Primitive.attribute(aName);
+			aOut.assign(VertexCount * aComponents, aDefault);
+			if ((Accessor != SIZE_MAX) && (aModel.Accessor[Accessor].Count == VertexCount)) aModel.read_float(Accessor, aOut.data(), aComponents, aComponents);
+		};
+		read("POSITION", Mesh.Position, 3, 0.0f);
+		read("NORMAL", Mesh.Normal, 3, 0.0f);
+		read("TEXCOORD_0", Mesh.Texcoord, 2, 0.0f);
+		if (Primitive.attribute("NORMAL") == SIZE_MAX) for (std::size_t v = 0; v < VertexCount; v++) Mesh.Normal[3 * v + 2] = 1.0f;
+		if ((Primitive.attribute("JOINTS_0") != SIZE_MAX) && (Primitive.attribute("WEIGHTS_0") != SIZE_MAX)) {
+			std::vector<float> Joint;
+			read("JOINTS_0", Joint, 4, 0.0f);
+			read("WEIGHTS_0", Mesh.Weight, 4, 0.0f);
+			Mesh.Joint.resize(Joint.size());
+			for (std::size_t i = 0; i < Joint.size(); i++) Mesh.Joint[i] = (uint16_t)Joint[i];
+		}
+		if (Primitive.Indices != SIZE_MAX) {
+			Mesh.Index = aModel.read_indices(Primitive.Indices);
+		}
+		else {
+			Mesh.Index.resize(VertexCount);
+			for (std::size_t i = 0; i < VertexCount; i++) Mesh.Index[i] = (uint32_t)i;
+		}
+		if (Mesh.Index.size() % 3 != 0) throw std::runtime_error("optimize_mesh: index count " + std::to_string(Mesh.Index.size()) + " is not a multiple of 3");
+
+		auto measure = [&]() {
+			vertex_cache_statistics Cache = analyze_vertex_cache(Mesh.Index, Mesh.VertexCount, aOptions.CacheSize);
+			return mesh_statistics{ Mesh.VertexCount, Mesh.Index.size() / 3, (uint64_t)Mesh.VertexCount * Mesh.vertex_stride(), Mesh.Index.size() * sizeof(uint32_t), Cache.ACMR, Cache.ATVR };
+		};
+		Mesh.Before = measure();
+
+		if (aOptions.Reorder) {
+			optimize_vertex_cache(Mesh.Index, VertexCount);
+			std::vector<uint32_t> Remap;
+			Mesh.VertexCount = (uint32_t)optimize_vertex_fetch(Mesh.Index, VertexCount, Remap);
+			detail::remap_stream(Mesh.Position, 3, Remap, Mesh.VertexCount);
+			detail::remap_stream(Mesh.Normal, 3, Remap, Mesh.VertexCount);
+			detail::remap_stream(Mesh.Texcoord, 2, Remap, Mesh.VertexCount);
+			detail::remap_stream(Mesh.Joint, 4, Remap, Mesh.VertexCount);
+			detail::remap_stream(Mesh.Weight, 4, Remap, Mesh.VertexCount);
+		}
+
+		if (aOptions.MeshletTriangles > 0) {
+			GEODESY_PROFILE_SCOPE("asset", "mesh.meshlets");
+			detail::build_meshlets(Mesh, aOptions.MeshletVertices, aOptions.MeshletTriangles);
+		}
+
+		if (aOptions.LodCount > 0) {
+			GEODESY_PROFILE_SCOPE("asset", "mesh.lod");
+			// Each level is simplified from the one above, so its error estimate is the sum
+			// of the steps' estimates. The chain ends early once a step removes under a tenth
+			// of the triangles, at the error limit or on a mesh with nothing left to collapse.
+			float Low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, High[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (std::size_t v = 0; v < Mesh.VertexCount; v++) {
+				for (std::size_t k = 0; k < 3; k++) {
+					Low[k] = std::min(Low[k], Mesh.Position[3 * v + k]);
+					High[k] = std::max(High[k], Mesh.Position[3 * v + k]);
+				}
+			}
+			float Extent = 0.0f;
+			for (std::size_t k = 0; (k < 3) && (Mesh.VertexCount > 0); k++) Extent = std::max(Extent, High[k] - Low[k]);
+			std::vector<uint32_t> Level = Mesh.Index;
+			float Error = 0.0f;
+			for (uint32_t l = 0; (l < aOptions.LodCount) && (Level.size() >= 3); l++) {
+				simplify_options Options;
+				Options.MaxError = aOptions.LodMaxError * Extent - Error;
+				if (Options.MaxError <= 0.0f) break;
+				float Step = 0.0f;
+				std::size_t Target = (std::size_t)((float)(Level.size() / 3) * aOptions.LodRatio);
+				std::vector<uint32_t> Next = simplify(Mesh.Position.data(), Mesh.Normal.data(), Mesh.Texcoord.data(), Mesh.VertexCount, Level, Target, Options, &Step);
+				if (Next.size() * 10 > Level.size() * 9) break;
+				Error += Step;
+				if (aOptions.Reorder) optimize_vertex_cache(Next, Mesh.VertexCount);
+				Mesh.Lod.push_back({ (uint32_t)Mesh.LodIndex.size(), (uint32_t)Next.size(), Error, 0 });
+				Mesh.LodIndex.insert(Mesh.LodIndex.end(), Next.begin(), Next.end());
+				Level = std::move(Next);
+			}
+		}
+
+		if (aOptions.Quantize) {
+			GEODESY_PROFILE_SCOPE("asset", "mesh.quantize");
+			float Low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, High[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (std::size_t v = 0; v < Mesh.VertexCount; v++) {
+				for (std::size_t k = 0; k < 3; k++) {
+					Low[k] = std::min(Low[k], Mesh.Position[3 * v + k]);
+					High[k] = std::max(High[k], Mesh.Position[3 * v + k]);
+				}
+			}
+			for (std::size_t k = 0; k < 3; k++) {
+				Mesh.PositionOffset[k] = Mesh.VertexCount > 0 ? Low[k] : 0.0f;
+				Mesh.PositionScale[k] = Mesh.VertexCount > 0 ? (High[k] - Low[k]) / 65535.0f : 0.0f;
+			}
+			Mesh.PackedPosition.resize(4 * (std::size_t)Mesh.VertexCount, 0);
+			Mesh.PackedNormal.resize(Mesh.VertexCount);
+			Mesh.PackedTexcoord.resize(Mesh.VertexCount);
+			for (std::size_t v = 0; v < Mesh.VertexCount; v++) {
+				for (std::size_t k = 0; k < 3; k++) {
+					float Range = High[k] - Low[k];
+					float Unit = Range > 0.0f ? (Mesh.Position[3 * v + k] - Low[k]) / Range : 0.0f;
+					Mesh.PackedPosition[4 * v + k] = (uint16_t)std::lround(std::clamp(Unit, 0.0f, 1.0f) * 65535.0f);
+				}
+				Mesh.PackedNormal[v] = detail::encode_octahedral(&Mesh.Normal[3 * v]);
+				Mesh.PackedTexcoord[v] = (uint32_t)detail::to_half(Mesh.Texcoord[2 * v]) | ((uint32_t)detail::to_half(Mesh.Texcoord[2 * v + 1]) << 16);
+			}
+			Mesh.Position = std::vector<float>();
+			Mesh.Normal = std::vector<float>();
+			Mesh.Texcoord = std::vector<float>();
+			Mesh.Quantized = true;
+		}
+		Mesh.After = measure();
+		return Mesh;
+	}
+
+	// ---------- mesh_report ---------- //
+
+	inline uint64_t mesh_report::bytes_before() const {
+		uint64_t Bytes = 0;
+		for (const entry& E : Entry) Bytes += E.Before.VertexBytes + E.Before.IndexBytes;
+		return Bytes;
+	}
+
+	inline uint64_t mesh_report::bytes_after() const {
+		uint64_t Bytes = 0;
+		for (const entry& E : Entry) Bytes += E.After.VertexBytes + E.After.IndexBytes;
+		return Bytes;
+	}
+
+	inline std::string mesh_report::to_string() const {
+		std::stringstream Stream;
+		Stream << std::fixed << std::setprecision(3);
+		for (const entry& E : Entry) {
+			Stream << "[mesh] " << std::setw(3) << E.Mesh << ":" << std::left << std::setw(3) << E.Primitive << std::right
+				   << "  tris " << std::setw(7) << E.After.TriangleCount
+				   << "  ACMR " << E.Before.ACMR << " -> " << E.After.ACMR
+				   << "  ATVR " << E.Before.ATVR << " -> " << E.After.ATVR
+				   << "  bytes " << std::setw(9) << (E.Before.VertexBytes + E.Before.IndexBytes) << " -> " << std::setw(9) << (E.After.VertexBytes + E.After.IndexBytes)
+				   << "  meshlets " << E.MeshletCount << "\n";
+			for (std::size_t l = 0; l < E.Lod.size(); l++) {
+				Stream << "[mesh]        lod " << (l + 1)
+					   << "  tris " << std::setw(7) << E.Lod[l].IndexCount / 3
+					   << "  (" << std::setprecision(1) << std::setw(5) << (E.After.TriangleCount > 0 ? 100.0 * (double)(E.Lod[l].IndexCount / 3) / (double)E.After.TriangleCount : 0.0) << "%)"
+					   << "  error " << std::setprecision(6) << E.Lod[l].Error << std::setprecision(3) << "\n";
+			}
+		}
+		uint64_t Before = this->bytes_before(), After = this->bytes_after();
+		Stream << "[mesh] " << Path << (Hit ? " warm" : " cold")
+			   << "  read " << Read << "  optimize " << Optimize << "  cache " << Cache << "  total " << Total << " ms, "
+			   << Before << " -> " << After << " bytes (" << std::setprecision(1) << (Before > 0 ? 100.0 * (double)(Before - std::min(Before, After)) / (double)Before : 0.0) << "% saved)\n";
+		return Stream.str();
+	}
+
+	// ---------- mesh_cache ---------- //
+
+	inline mesh_cache::mesh_cache(const std::string& aDirectory) {
+		Directory = aDirectory;
+	}
+
+	inline uint64_t mesh_cache::key(const uint8_t* aDocument, std::size_t aSize, const gltf& aModel, const mesh_options& aOptions) {
+		uint64_t Seed = ((uint64_t)Version << 32) | (aOptions.Reorder ? 1u : 0u) | (aOptions.Quantize ? 2u : 0u);
+		Seed = detail::hash64((const uint8_t*)&aOptions.MeshletVertices, sizeof(uint32_t), Seed);
+		Seed = detail::hash64((const uint8_t*)&aOptions.MeshletTriangles, sizeof(uint32_t), Seed);
+		Seed = detail::hash64((const uint8_t*)&aOptions.CacheSize, sizeof(uint32_t), Seed);
+		Seed = detail::hash64((const uint8_t*)&aOptions.LodCount, sizeof(uint32_t), Seed);
+		Seed = detail::hash64((const uint8_t*)&aOptions.LodRatio, sizeof(float), Seed);
+		Seed = detail::hash64((const uint8_t*)&aOptions.LodMaxError, sizeof(float), Seed);
+		uint64_t Key = detail::hash64(aDocument, aSize, Seed);
+		for (std::size_t b = 0; b < aModel.buffer_count(); b++) Key = detail::hash64(aModel.buffer_data(b), aModel.buffer_size(b), Key);
+		return Key;
+	}
+
+	inline std::string mesh_cache::path_for(uint64_t aKey) const {
+		std::stringstream Name;
+		Name << std::hex << std::setw(16) << std::setfill('0') << aKey << ".mesh";
+		return (Directory / Name.str()).string();
+	}
+
+	inline std::vector<optimized_mesh> mesh_cache::load(const std::string& aPath, const mesh_options& aOptions, mesh_report* aReport) const {
+		using clock = std::chrono::steady_clock;
+		clock::time_point Start = clock::now();
+		clock::time_point Mark = Start;
+		auto lap = [&]() {
+			clock::time_point Now = clock::now();
+			double Elapsed = std::chrono::duration<double, std::milli>(Now - Mark).count();
+			Mark = Now;
+			return Elapsed;
+		};
+		mesh_report Report{};
+		Report.Path = aPath;
+		[[maybe_unused]] const char* Detail = profiler::instance().intern(aPath);
+		GEODESY_PROFILE_SCOPE("asset", "mesh", Detail);
+
+		// The model is mapped, so hashing touches every buffer page once and a hit reads nothing else.
+		gltf Model = gltf::load(aPath);
+		uint64_t Key;
+		{
+			mapped_file Source(aPath);
+			if (!Source.is_open()) throw std::runtime_error("mesh_cache: cannot open " + aPath);
+			Key = key(Source.data(), Source.size(), Model, aOptions);
+		}
+		std::string CachePath = this->path_for(Key);
+		Report.Read = lap();
+
+		std::vector<optimized_mesh> Mesh;
+		Report.Hit = this->read(CachePath, Key, Mesh);
+		if (Report.Hit) {
+			Report.Cache = lap();
+		}
+		else {
+			for (std::size_t m = 0; m < Model.Mesh.size(); m++) {
+				for (std::size_t p = 0; p < Model.Mesh[m].Primitive.size(); p++) {
+					const gltf::primitive& Primitive = Model.Mesh[m].Primitive[p];
+					if ((Primitive.Mode != 4) || (Primitive.attribute("POSITION") == SIZE_MAX)) continue;
+					Mesh.push_back(optimize_mesh(Model, m, p, aOptions));
+				}
+			}
+			Report.Optimize = lap();
+			Report.Stored = this->store(CachePath, Key, Mesh);
+			Report.Cache = lap();
+		}
+		for (const optimized_mesh& M : Mesh) Report.Entry.push_back({ M.Mesh, M.Primitive, M.Meshlet.size(), M.Before, M.After, M.Lod });
+		Report.Total = std::chrono::duration<double, std::milli>(clock::now() - Start).count();
+		if (aReport != nullptr) *aReport = std::move(Report);
+		return Mesh;
+	}
+
+	inline bool mesh_cache::read(const std::string& aPath, uint64_t aKey, std::vector<optimized_mesh>& aMesh) const {
+		mapped_file File(aPath);
+		header Header;
+		if (!read_cache_header(File, Magic, Version, Header) || (Header.Key != aKey)) return false;
+		if ((uint64_t)sizeof(header) + (uint64_t)Header.RecordCount * sizeof(record) > Header.DataOffset) return false;
+		if ((Header.DataOffset > File.size()) || (Header.DataSize > File.size() - Header.DataOffset)) return false;
+
+		std::vector<optimized_mesh> Result(Header.RecordCount);
+		for (std::size_t r = 0; r < Result.size(); r++) {
+			record Record;
+			std::memcpy(&Record, File.data() + sizeof(header) + r * sizeof(record), sizeof(record));
+			optimized_mesh& M = Result[r];
+			M.Mesh = Record.Mesh;
+			M.Primitive = Record.Primitive;
+			M.VertexCount = Record.VertexCount;
+			M.Quantized = Record.Quantized != 0;
+			std::copy_n(Record.PositionOffset, 3, M.PositionOffset);
+			std::copy_n(Record.PositionScale, 3, M.PositionScale);
+			M.Before = Record.Before;
+			M.After = Record.After;
+			// Streams follow each other 4 byte aligned, every one must end inside the data.
+			uint64_t Offset = Record.Offset;
+			std::size_t Stream = 0;
+			bool Valid = true;
+			detail::each_stream(M, [&](auto& aStream) {
+				using element = typename std::decay_t<decltype(aStream)>::value_type;
+				uint64_t Count = Record.Count[Stream++];
+				if (!Valid || (Count > Header.DataSize / sizeof(element)) || (Offset > Header.DataSize - Count * sizeof(element))) {
+					Valid = false;
+					return;
+				}
+				aStream.resize((std::size_t)Count);
+				if (Count > 0) std::memcpy((void*)aStream.data(), File.data() + Header.DataOffset + Offset, (std::size_t)Count * sizeof(element));
+				Offset += (Count * sizeof(element) + 3) & ~(uint64_t)3;
+			});
+			if (!Valid || !detail::consistent(M)) return false;
+		}
+		aMesh = std::move(Result);
+		return true;
+	}
+
+	inline bool mesh_cache::store(const std::string& aPath, uint64_t aKey, const std::vector<optimized_mesh>& aMesh) const {
+		std::error_code Error;
+		std::filesystem::create_directories(Directory, Error);
+		if (Error) return false;
+
+		header Header = make_cache_header<header>(Magic, Version);
+		Header.Key 			= aKey;
+		Header.RecordCount 	= (uint32_t)aMesh.size();
+		Header.DataOffset 	= (sizeof(header) + aMesh.size() * sizeof(record) + 15) & ~(uint64_t)15;
+		std::vector<record> Record(aMesh.size());
+		uint64_t Offset = 0;
+		for (std::size_t r = 0; r < aMesh.size(); r++) {
+			const optimized_mesh& M = aMesh[r];
+			record& R = Record[r];
+			R = record{};
+			R.Mesh = M.Mesh;
+			R.Primitive = M.Primitive;
+			R.VertexCount = M.VertexCount;
+			R.Quantized = M.Quantized ? 1 : 0;
+			std::copy_n(M.PositionOffset, 3, R.PositionOffset);
+			std::copy_n(M.PositionScale, 3, R.PositionScale);
+			R.Before = M.Before;
+			R.After = M.After;
+			R.Offset = Offset;
+			std::size_t Stream = 0;
+			detail::each_stream(M, [&](const auto& aStream) {
+				using element = typename std::decay_t<decltype(aStream)>::value_type;
+				R.Count[Stream++] = aStream.size();
+				Offset += (aStream.size() * sizeof(element) + 3) & ~(uint64_t)3;
+			});
+		}
+		Header.DataSize = Offset;
+		static const char Padding[16] = {};
+		std::size_t PaddingSize = (std::size_t)Header.DataOffset - sizeof(header) - Record.size() * sizeof(record);
+
+		return write_cache_file(aPath, [&](std::ostream& aFile) {
+			aFile.write((const char*)&Header, sizeof(Header));
+			aFile.write((const char*)Record.data(), Record.size() * sizeof(record));
+			aFile.write(Padding, PaddingSize);
+			for (const optimized_mesh& M : aMesh) {
+				detail::each_stream(M, [&](const auto& aStream) {
+					using element = typename std::decay_t<decltype(aStream)>::value_type;
+					std::size_t Bytes = aStream.size() * sizeof(element);
+					aFile.write((const char*)aStream.data(), Bytes);
+					aFile.write(Padding, ((Bytes + 3) & ~(std::size_t)3) - Bytes);
+				});
+			}
+		});
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_MESH_OPTIMIZER_H
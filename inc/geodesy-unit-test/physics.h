@@ -0,0 +1,495 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_PHYSICS_H
+#define GEODESY_UNIT_TEST_PHYSICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <stdexcept>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/world_snapshot.h>
+#include <geodesy-unit-test/job_system.h>
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy {
+
+	// Solver parameters, the first four come from a world file's Physics block.
+	struct physics_settings {
+		math::vec<float, 3> 	Gravity 			= { 0.0f, 0.0f, -9.81f };
+		float 					TimeStep 			= 0.016667f; 		// [s]
+		uint32_t 				VelocityIterations 	= 8;
+		uint32_t 				PositionIterations 	= 3;
+		uint32_t 				MaxSubSteps 		= 4; 				// Per step() call, the rest of a long frame is dropped.
+		float 					Restitution 		= 0.2f;
+		float 					Slop 				= 0.005f; 			// [m] Penetration left alone by position correction.
+		float 					Correction 			= 0.8f; 			// Fraction of the penetration removed per position iteration.
+
+		// Settings of aWorld, zero iteration counts and time steps keep the defaults.
+		static physics_settings from_world(const io::world_description& aWorld);
+	};
+
+	// Fixed step rigid body simulation of spheres against each other and static planes.
+	// Bodies are stored as structure of arrays. Each step integrates gravity, finds pairs
+	// by sweep and prune (in bands, see sweep()), groups bodies joined by contacts into
+	// islands and solves each island independently with sequential impulses
+	// (VelocityIterations) and position projection (PositionIterations). Contacts have no
+	// friction.
+	//
+	// Given a job_system the integration, pair search and island solves run in parallel.
+	// Work is split in fixed size chunks and every island is solved by one thread in a fixed
+	// contact order, so results are bit for bit identical for any thread count, and without
+	// a job system.
+	class physics_world {
+	public:
+
+		using id = uint32_t;
+
+		struct statistics {
+			std::size_t 	Contacts 		= 0;
+			std::size_t 	Islands 		= 0;
+			std::size_t 	LargestIsland 	= 0; 		// Bodies.
+		};
+
+		physics_settings 	Settings;
+
+		physics_world(const physics_settings& aSettings = physics_settings());
+
+		// aMass 0 makes a static body.
+		id add_sphere(const math::vec<float, 3>& aPosition, float aRadius, float aMass, const math::vec<float, 3>& aVelocity = math::vec<float, 3>());
+		// Static half space n . x >= aOffset, aNormal is normalized.
+		void add_plane(const math::vec<float, 3>& aNormal, float aOffset);
+		std::size_t size() const;
+		math::vec<float, 3> position(id aBody) const;
+		math::vec<float, 3> velocity(id aBody) const;
+		// Ignored for static bodies.
+		void set_velocity(id aBody, const math::vec<float, 3>& aVelocity);
+
+		// Advances by aFrameTime in steps of Settings.TimeStep and returns the number of
+		// steps taken. Time short of a full step carries over to the next call.
+		std::size_t step(float aFrameTime, job_system* aJobs = nullptr);
+		// One fixed step.
+		void substep(job_system* aJobs = nullptr);
+		const statistics& stats() const;
+
+	private:
+
+		static constexpr id None = UINT32_MAX;
+		static constexpr std::size_t ChunkSize = 512; 		// Bodies per integration and pair search job.
+		static constexpr std::size_t IslandGrain = 32; 		// Islands per solver job.
+
+		struct contact {
+			id 		A;
+			id 		B; 					// None for a plane contact.
+			id 		Plane;
+			float 	Normal[3]; 			// From A to B, or the plane normal pointing at A.
+			float 	Mass; 				// Effective mass along the normal.
+			float 	TargetSpeed; 		// Separation speed from restitution.
+			float 	Impulse;
+		};
+
+		// Bounds of a body on the sweep axis, copied out in sweep order.
+		struct sweep_entry {
+			int64_t 	Band;
+			float 		Lower;
+			float 		Upper;
+			float 		Center[3];
+			float 		Radius;
+			float 		InverseMass;
+			id 			Body;
+		};
+
+		// Bodies.
+		std::vector<float> 		Position[3];
+		std::vector<float> 		Velocity[3];
+		std::vector<float> 		Radius;
+		std::vector<float> 		InverseMass;
+		// Planes.
+		std::vector<float> 		Plane; 				// nx, ny, nz, offset.
+
+		float 					Accumulator;
+		statistics 				Stats;
+		// Scratch kept between steps.
+		float 								MaxRadius;
+		std::size_t 						Axis;
+		std::size_t 						BandAxis;
+		std::vector<sweep_entry> 			Entry; 			// By band, then lower bound on the sweep axis.
+		std::vector<std::size_t> 			RunBegin; 		// Sorted positions where a band starts.
+		std::vector<uint32_t> 				RunOf;
+		std::vector<std::vector<contact>> 	ChunkContact;
+		std::vector<contact> 				Contact;
+		std::vector<id> 					Root;
+		std::vector<id> 					IslandOf;
+		std::vector<std::size_t> 			IslandStart; 	// Offsets into IslandContact.
+		std::vector<std::size_t> 			IslandContact;
+		std::vector<std::size_t> 			IslandBodies;
+		std::vector<id> 					ContactIsland;
+		std::vector<std::size_t> 			Fill;
+
+		void run(job_system* aJobs, std::size_t aCount, std::size_t aGrain, const std::function<void(std::size_t, std::size_t)>& aFunction);
+		void sweep(job_system* aJobs);
+		void build_islands();
+		void solve_velocity(std::size_t aIsland);
+		void solve_position(std::size_t aIsland);
+		id find(id aBody);
+
+	};
+
+	// ---------- physics_settings ---------- //
+
+	inline physics_settings physics_settings::from_world(const io::world_description& aWorld) {
+		physics_settings Settings;
+		Settings.Gravity = aWorld.Gravity;
+		if (aWorld.TimeStep > 0.0f) Settings.TimeStep = aWorld.TimeStep;
+		if (aWorld.VelocityIterations > 0) Settings.VelocityIterations = aWorld.VelocityIterations;
+		if (aWorld.PositionIterations > 0) Settings.PositionIterations = aWorld.PositionIterations;
+		return Settings;
+	}
+
+	// ---------- physics_world ---------- //
+
+	inline physics_world::physics_world(const physics_settings& aSettings) {
+		Settings = aSettings;
+		Accumulator = 0.0f;
+		MaxRadius = 0.0f;
+		Axis = 0;
+		BandAxis = 1;
+	}
+
+	inline physics_world::id physics_world::add_sphere(const math::vec<float, 3>& aPosition, float aRadius, float aMass, const math::vec<float, 3>& aVelocity) {
+		if (!(aRadius > 0.0f) || (aMass < 0.0f)) throw std::invalid_argument("physics_world: sphere needs a positive radius and a non-negative mass");
+		id Body = (id)Radius.size();
+		for (std::size_t k = 0; k < 3; k++) {
+			Position[k].push_back(aPosition[k]);
+			Velocity[k].push_back(aMass > 0.0f ? aVelocity[k] : 0.0f);
+		}
+		Radius.push_back(aRadius);
+		MaxRadius = std::max(MaxRadius, aRadius);
+		InverseMass.push_back(aMass > 0.0f ? 1.0f / aMass : 0.0f);
+		Entry.push_back(sweep_entry{ 0, 0.0f, 0.0f, { 0.0f, 0.0f, 0.0f }, Radius.back(), InverseMass.back(), Body });
+		return Body;
+	}
+
+	inline void physics_world::add_plane(const math::vec<float, 3>& aNormal, float aOffset) {
+		float Length = std::sqrt(aNormal[0] * aNormal[0] + aNormal[1] * aNormal[1] + aNormal[2] * aNormal[2]);
+		if (!(Length > 0.0f)) throw std::invalid_argument("physics_world: plane normal is zero");
+		for (std::size_t k = 0; k < 3; k++) Plane.push_back(aNormal[k] / Length);
+		Plane.push_back(aOffset);
+	}
+
+	inline std::size_t physics_world::size() const {
+		return Radius.size();
+	}
+
+	inline math::vec<float, 3> physics_world::position(id aBody) const {
+		return { Position[0][aBody], Position[1][aBody], Position[2][aBody] };
+	}
+
+	inline math::vec<float, 3> physics_world::velocity(id aBody) const {
+		return { Velocity[0][aBody], Velocity[1][aBody], Velocity[2][aBody] };
+	}
+
+	inline void physics_world::set_velocity(id aBody, const math::vec<float, 3>& aVelocity) {
+		if (InverseMass[aBody] == 0.0f) return;
+		for (std::size_t k = 0; k < 3; k++) Velocity[k][aBody] = aVelocity[k];
+	}
+
+	inline std::size_t physics_world::step(float aFrameTime, job_system* aJobs) {
+		Accumulator += aFrameTime;
+		std::size_t Steps = 0;
+		while ((Accumulator >= Settings.TimeStep) && (Steps < Settings.MaxSubSteps)) {
+			this->substep(aJobs);
+			Accumulator -= Settings.TimeStep;
+			Steps++;
+		}
+		// Falling behind drops time rather than spiralling into ever longer frames.
+		if (Steps == Settings.MaxSubSteps) Accumulator = std::min(Accumulator, Settings.TimeStep);
+		return Steps;
+	}
+
+	inline void physics_world::substep(job_system* aJobs) {
+		GEODESY_PROFILE_SCOPE("physics", "step");
+		const float DT = Settings.TimeStep;
+		std::size_t BodyCount = Radius.size();
+		{
+			GEODESY_PROFILE_SCOPE("physics", "integrate velocity");
+			float G[3] = { Settings.Gravity[0] * DT, Settings.Gravity[1] * DT, Settings.Gravity[2] * DT };
+			this->run(aJobs, BodyCount, 4 * ChunkSize, [&](std::size_t aBegin, std::size_t aEnd) {
+				for (std::size_t k = 0; k < 3; k++) {
+					float* V = Velocity[k].data();
+					const float* W = InverseMass.data();
+					for (std::size_t i = aBegin; i < aEnd; i++) V[i] += W[i] > 0.0f ? G[k] : 0.0f;
+				}
+			});
+		}
+		this->sweep(aJobs);
+		this->build_islands();
+		{
+			GEODESY_PROFILE_SCOPE("physics", "solve velocity");
+			this->run(aJobs, Stats.Islands, IslandGrain, [&](std::size_t aBegin, std::size_t aEnd) {
+				for (std::size_t i = aBegin; i < aEnd; i++) this->solve_velocity(i);
+			});
+		}
+		{
+			GEODESY_PROFILE_SCOPE("physics", "integrate position");
+			this->run(aJobs, BodyCount, 4 * ChunkSize, [&](std::size_t aBegin, std::size_t aEnd) {
+				for (std::size_t k = 0; k < 3; k++) {
+					float* P = Position[k].data();
+					const float* V = Velocity[k].data();
+					for (std::size_t i = aBegin; i < aEnd; i++) P[i] += V[i] * DT;
+				}
+			});
+		}
+		{
+			GEODESY_PROFILE_SCOPE("physics", "solve position");
+			this->run(aJobs, Stats.Islands, IslandGrain, [&](std::size_t aBegin, std::size_t aEnd) {
+				for (std::size_t i = aBegin; i < aEnd; i++) this->solve_position(i);
+			});
+		}
+	}
+
+	inline const physics_world::statistics& physics_world::stats() const {
+		return Stats;
+	}
+
+	inline void physics_world::run(job_system* aJobs, std::size_t aCount, std::size_t aGrain, const std::function<void(std::size_t, std::size_t)>& aFunction) {
+		if ((aJobs == nullptr) || (aCount <= aGrain)) {
+			if (aCount > 0) aFunction(0, aCount);
+			return;
+		}
+		aJobs->parallel_for(aCount, aGrain, aFunction);
+	}
+
+	inline void physics_world::sweep(job_system* aJobs) {
+		GEODESY_PROFILE_SCOPE("physics", "broadphase");
+		std::size_t BodyCount = Radius.size();
+		Contact.clear();
+		Stats.Contacts = 0;
+		if (BodyCount == 0) return;
+		// Sweep along the axis of largest spread, in bands across the second largest. Bands
+		// are one largest diameter wide, so a body only touches bodies of its own band and
+		// the two next to it, and a sweep over a wide floor does not scan a whole strip.
+		double Spread[3];
+		for (std::size_t k = 0; k < 3; k++) {
+			double Mean = 0.0, Square = 0.0;
+			for (std::size_t i = 0; i < BodyCount; i++) {
+				Mean += Position[k][i];
+				Square += (double)Position[k][i] * Position[k][i];
+			}
+			Spread[k] = Square - Mean * Mean / (double)BodyCount;
+		}
+		std::size_t NewAxis = 0;
+		for (std::size_t k = 1; k < 3; k++) if (Spread[k] > Spread[NewAxis]) NewAxis = k;
+		std::size_t NewBandAxis = NewAxis == 0 ? 1 : 0;
+		for (std::size_t k = 0; k < 3; k++) if ((k != NewAxis) && (Spread[k] > Spread[NewBandAxis])) NewBandAxis = k;
+		float Width = 2.0f * MaxRadius;
+		// Entries stay in last step's order, so refreshing them is the only pass over the
+		// bodies in id order and sorting and sweeping read memory in sequence.
+		for (sweep_entry& E : Entry) {
+			for (std::size_t k = 0; k < 3; k++) E.Center[k] = Position[k][E.Body];
+			E.Lower = E.Center[NewAxis] - E.Radius;
+			E.Upper = E.Center[NewAxis] + E.Radius;
+			E.Band = (int64_t)std::floor(E.Center[NewBandAxis] / Width);
+		}
+		auto before = [](const sweep_entry& aA, const sweep_entry& aB) {
+			if (aA.Band != aB.Band) return aA.Band < aB.Band;
+			if (aA.Lower != aB.Lower) return aA.Lower < aB.Lower;
+			return aA.Body < aB.Body;
+		};
+		if ((NewAxis != Axis) || (NewBandAxis != BandAxis)) {
+			std::sort(Entry.begin(), Entry.end(), before);
+			Axis = NewAxis;
+			BandAxis = NewBandAxis;
+		}
+		else {
+			// Bodies move little per step, insertion sort on last step's order is near linear.
+			for (std::size_t i = 1; i < BodyCount; i++) {
+				if (!before(Entry[i], Entry[i - 1])) continue;
+				sweep_entry Moved = Entry[i];
+				std::size_t j = i;
+				while ((j > 0) && before(Moved, Entry[j - 1])) {
+					Entry[j] = Entry[j - 1];
+					j--;
+				}
+				Entry[j] = Moved;
+			}
+		}
+		// Runs of equal band in the sorted order.
+		RunBegin.clear();
+		RunOf.resize(BodyCount);
+		for (std::size_t i = 0; i < BodyCount; i++) {
+			if ((i == 0) || (Entry[i].Band != Entry[i - 1].Band)) RunBegin.push_back(i);
+			RunOf[i] = (uint32_t)(RunBegin.size() - 1);
+		}
+		RunBegin.push_back(BodyCount);
+
+		// Pairs overlapping on the sweep axis within a band and with the next band, then the
+		// exact sphere and plane tests, per chunk of the sorted order. Chunks are joined in
+		// order so the contact list does not depend on which thread found what.
+		std::size_t ChunkCount = (BodyCount + ChunkSize - 1) / ChunkSize;
+		ChunkContact.resize(ChunkCount);
+		float Restitution = Settings.Restitution;
+		float Threshold = 2.0f * std::sqrt(Settings.Gravity * Settings.Gravity) * Settings.TimeStep;
+		this->run(aJobs, ChunkCount, 1, [&](std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t c = aBegin; c < aEnd; c++) {
+				std::vector<contact>& Found = ChunkContact[c];
+				Found.clear();
+				std::size_t End = std::min(BodyCount, (c + 1) * ChunkSize);
+				for (std::size_t i = c * ChunkSize; i < End; i++) {
+					const sweep_entry& A = Entry[i];
+					float WA = A.InverseMass;
+					auto test = [&](const sweep_entry& aB) {
+						float WB = aB.InverseMass;
+						if ((WA == 0.0f) && (WB == 0.0f)) return;
+						float D[3] = { aB.Center[0] - A.Center[0], aB.Center[1] - A.Center[1], aB.Center[2] - A.Center[2] };
+						float Distance2 = D[0] * D[0] + D[1] * D[1] + D[2] * D[2];
+						float Reach = A.Radius + aB.Radius;
+						if (Distance2 >= Reach * Reach) return;
+						contact C{ A.Body, aB.Body, None, { 0.0f, 0.0f, 1.0f }, 1.0f / (WA + WB), 0.0f, 0.0f };
+						float Distance = std::sqrt(Distance2);
+						if (Distance > 0.0f) for (std::size_t k = 0; k < 3; k++) C.Normal[k] = D[k] / Distance;
+						float Approach = 0.0f;
+						for (std::size_t k = 0; k < 3; k++) Approach += (Velocity[k][aB.Body] - Velocity[k][A.Body]) * C.Normal[k];
+						// Resting contacts approach at about gravity times the step, they do not bounce.
+						C.TargetSpeed = Approach < -Threshold ? -Restitution * Approach : 0.0f;
+						Found.push_back(C);
+					};
+					std::size_t Run = RunOf[i];
+					for (std::size_t j = i + 1; (j < RunBegin[Run + 1]) && (Entry[j].Lower <= A.Upper); j++) test(Entry[j]);
+					if ((Run + 2 < RunBegin.size()) && (Entry[RunBegin[Run + 1]].Band == A.Band + 1)) {
+						// Bodies of the next band reaching back to A start at most one width before it.
+						auto First = std::lower_bound(Entry.begin() + RunBegin[Run + 1], Entry.begin() + RunBegin[Run + 2], A.Lower - Width, [](const sweep_entry& aB, float aValue) { return aB.Lower < aValue; });
+						for (auto j = First; (j != Entry.begin() + RunBegin[Run + 2]) && (j->Lower <= A.Upper); ++j) test(*j);
+					}
+					if (WA == 0.0f) continue;
+					for (std::size_t p = 0; p < Plane.size(); p += 4) {
+						const float* N = &Plane[p];
+						float Height = N[0] * A.Center[0] + N[1] * A.Center[1] + N[2] * A.Center[2] - N[3];
+						if (Height >= A.Radius) continue;
+						contact C{ A.Body, None, (id)(p / 4), { N[0], N[1], N[2] }, 1.0f / WA, 0.0f, 0.0f };
+						float Approach = N[0] * Velocity[0][A.Body] + N[1] * Velocity[1][A.Body] + N[2] * Velocity[2][A.Body];
+						C.TargetSpeed = Approach < -Threshold ? -Restitution * Approach : 0.0f;
+						Found.push_back(C);
+					}
+				}
+			}
+		});
+		for (const std::vector<contact>& Found : ChunkContact) Contact.insert(Contact.end(), Found.begin(), Found.end());
+		Stats.Contacts = Contact.size();
+	}
+
+	inline physics_world::id physics_world::find(id aBody) {
+		while (Root[aBody] != aBody) {
+			Root[aBody] = Root[Root[aBody]];
+			aBody = Root[aBody];
+		}
+		return aBody;
+	}
+
+	inline void physics_world::build_islands() {
+		GEODESY_PROFILE_SCOPE("physics", "islands");
+		std::size_t BodyCount = Radius.size();
+		// Union of dynamic bodies in contact, static bodies and planes do not join islands.
+		Root.resize(BodyCount);
+		for (std::size_t i = 0; i < BodyCount; i++) Root[i] = (id)i;
+		for (const contact& C : Contact) {
+			if ((C.B == None) || (InverseMass[C.A] == 0.0f) || (InverseMass[C.B] == 0.0f)) continue;
+			id A = this->find(C.A), B = this->find(C.B);
+			if (A != B) Root[std::max(A, B)] = std::min(A, B);
+		}
+		// Islands numbered by first contact, contacts bucketed in contact order.
+		IslandOf.assign(BodyCount, None);
+		std::vector<std::size_t>& Count = IslandBodies;
+		Count.clear();
+		ContactIsland.resize(Contact.size());
+		for (std::size_t c = 0; c < Contact.size(); c++) {
+			id Body = InverseMass[Contact[c].A] > 0.0f ? Contact[c].A : Contact[c].B;
+			id R = this->find(Body);
+			if (IslandOf[R] == None) {
+				IslandOf[R] = (id)Count.size();
+				Count.push_back(0);
+			}
+			ContactIsland[c] = IslandOf[R];
+			Count[IslandOf[R]]++;
+		}
+		std::size_t IslandCount = Count.size();
+		IslandStart.assign(IslandCount + 1, 0);
+		for (std::size_t i = 0; i < IslandCount; i++) IslandStart[i + 1] = IslandStart[i] + Count[i];
+		IslandContact.resize(Contact.size());
+		Fill.assign(IslandStart.begin(), IslandStart.end() - 1);
+		for (std::size_t c = 0; c < Contact.size(); c++) IslandContact[Fill[ContactIsland[c]]++] = c;
+
+		// Body counts for the statistics.
+		std::fill(Count.begin(), Count.end(), 0);
+		for (std::size_t i = 0; i < BodyCount; i++) {
+			if (InverseMass[i] == 0.0f) continue;
+			id R = this->find((id)i);
+			if (IslandOf[R] != None) Count[IslandOf[R]]++;
+		}
+		Stats.Islands = IslandCount;
+		Stats.LargestIsland = IslandCount > 0 ? *std::max_element(Count.begin(), Count.end()) : 0;
+	}
+
+	inline void physics_world::solve_velocity(std::size_t aIsland) {
+		float* V[3] = { Velocity[0].data(), Velocity[1].data(), Velocity[2].data() };
+		for (uint32_t Iteration = 0; Iteration < Settings.VelocityIterations; Iteration++) {
+			for (std::size_t k = IslandStart[aIsland]; k < IslandStart[aIsland + 1]; k++) {
+				contact& C = Contact[IslandContact[k]];
+				const float* N = C.Normal;
+				float WA = InverseMass[C.A], WB = C.B == None ? 0.0f : InverseMass[C.B];
+				float Speed = 0.0f;
+				for (std::size_t d = 0; d < 3; d++) Speed += ((C.B == None ? 0.0f : V[d][C.B]) - V[d][C.A]) * N[d];
+				if (C.B == None) Speed = -Speed; 		// The plane normal points at A.
+				// Accumulated impulses only ever push apart.
+				float Delta = (C.TargetSpeed - Speed) * C.Mass;
+				float Total = std::max(0.0f, C.Impulse + Delta);
+				Delta = Total - C.Impulse;
+				C.Impulse = Total;
+				if (C.B == None) {
+					for (std::size_t d = 0; d < 3; d++) V[d][C.A] += Delta * WA * N[d];
+				}
+				else {
+					// Static bodies are shared between islands and never written.
+					if (WA > 0.0f) for (std::size_t d = 0; d < 3; d++) V[d][C.A] -= Delta * WA * N[d];
+					if (WB > 0.0f) for (std::size_t d = 0; d < 3; d++) V[d][C.B] += Delta * WB * N[d];
+				}
+			}
+		}
+	}
+
+	inline void physics_world::solve_position(std::size_t aIsland) {
+		float* P[3] = { Position[0].data(), Position[1].data(), Position[2].data() };
+		for (uint32_t Iteration = 0; Iteration < Settings.PositionIterations; Iteration++) {
+			for (std::size_t k = IslandStart[aIsland]; k < IslandStart[aIsland + 1]; k++) {
+				const contact& C = Contact[IslandContact[k]];
+				float WA = InverseMass[C.A];
+				if (C.B == None) {
+					const float* N = &Plane[4 * C.Plane];
+					float Depth = Radius[C.A] - (N[0] * P[0][C.A] + N[1] * P[1][C.A] + N[2] * P[2][C.A] - N[3]);
+					if (Depth <= Settings.Slop) continue;
+					float Push = Settings.Correction * (Depth - Settings.Slop);
+					for (std::size_t d = 0; d < 3; d++) P[d][C.A] += Push * N[d];
+					continue;
+				}
+				float WB = InverseMass[C.B];
+				float D[3] = { P[0][C.B] - P[0][C.A], P[1][C.B] - P[1][C.A], P[2][C.B] - P[2][C.A] };
+				float Distance = std::sqrt(D[0] * D[0] + D[1] * D[1] + D[2] * D[2]);
+				float Depth = Radius[C.A] + Radius[C.B] - Distance;
+				if (Depth <= Settings.Slop) continue;
+				float N[3] = { C.Normal[0], C.Normal[1], C.Normal[2] };
+				if (Distance > 0.0f) for (std::size_t d = 0; d < 3; d++) N[d] = D[d] / Distance;
+				float Push = Settings.Correction * (Depth - Settings.Slop) * C.Mass;
+				if (WA > 0.0f) for (std::size_t d = 0; d < 3; d++) P[d][C.A] -= Push * WA * N[d];
+				if (WB > 0.0f) for (std::size_t d = 0; d < 3; d++) P[d][C.B] += Push * WB * N[d];
+			}
+		}
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_PHYSICS_H
@@ -0,0 +1,420 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_PNG_H
+#define GEODESY_UNIT_TEST_PNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace geodesy::io {
+
+	// Decoded 8 bit RGBA image, rows top to bottom.
+	struct image {
+		uint32_t 				Width 	= 0;
+		uint32_t 				Height 	= 0;
+		std::vector<uint8_t> 	Pixel;
+	};
+
+	namespace detail {
+
+		// DEFLATE (RFC 1951) decoder into a growing byte vector.
+		class inflater {
+		public:
+
+			inflater(const uint8_t* aData, std::size_t aSize);
+			// Decodes every block, appending to aOut.
+			void run(std::vector<uint8_t>& aOut);
+
+		private:
+
+			// Canonical Huffman code with a 10 bit lookup table, longer codes fall back to
+			// walking the code lengths one bit at a time.
+			struct huffman {
+				static constexpr uint32_t FastBits = 10;
+				uint16_t Fast[1 << FastBits]; 		// (Symbol << 4) | Length, 0 when the code is longer.
+				uint16_t Count[16];
+				uint16_t Symbol[320];
+				void build(const uint8_t* aLength, std::size_t aCount);
+			};
+
+			const uint8_t* 	Data;
+			std::size_t 	Size;
+			std::size_t 	Position;
+			uint64_t 		Bits;
+			uint32_t 		BitCount;
+
+			void refill();
+			uint32_t bits(uint32_t aCount);
+			uint32_t decode(const huffman& aCode);
+			void stored(std::vector<uint8_t>& aOut);
+			void compressed(std::vector<uint8_t>& aOut, const huffman& aLength, const huffman& aDistance);
+			void dynamic(huffman& aLength, huffman& aDistance);
+
+		};
+
+		inline inflater::inflater(const uint8_t* aData, std::size_t aSize) {
+			Data = aData;
+			Size = aSize;
+			Position = 0;
+			Bits = 0;
+			BitCount = 0;
+		}
+
+		inline void inflater::huffman::build(const uint8_t* aLength, std::size_t aCount) {
+			std::memset(Fast, 0, sizeof(Fast));
+			std::memset(Count, 0, sizeof(Count));
+			for (std::size_t i = 0; i < aCount; i++) Count[aLength[i]]++;
+			Count[0] = 0;
+			uint16_t Offset[16];
+			Offset[1] = 0;
+			for (std::size_t l = 1; l < 15; l++) Offset[l + 1] = Offset[l] + Count[l];
+			for (std::size_t i = 0; i < aCount; i++) if (aLength[i] != 0) Symbol[Offset[aLength[i]]++] = (uint16_t)i;
+			// Codes are assigned in canonical order and stored bit reversed, as they are read.
+			uint32_t Code = 0, Index = 0;
+			for (uint32_t l = 1; l < 16; l++) {
+				for (uint32_t k = 0; k < Count[l]; k++, Code++, Index++) {
+					if (l > FastBits) continue;
+					uint32_t Reversed = 0;
+					for (uint32_t b = 0; b < l; b++) Reversed |= ((Code >> b) & 1u) << (l - 1 - b);
+					for (uint32_t Fill = Reversed; Fill < (1u << FastBits); Fill += (1u << l)) Fast[Fill] = (uint16_t)((Symbol[Index] << 4) | l);
+				}
+				Code <<= 1;
+			}
+		}
+
+		inline void inflater::refill() {
+			// Past the end reads zeros so the lookahead may run over, a stream still
+			// reading once all lookahead is spent is truncated.
+			if (Position > Size + 16) throw std::runtime_error("inflate: unexpected end of data");
+			while (BitCount <= 56) {
+				uint64_t Byte = Position < Size ? Data[Position] : 0;
+				Position++;
+				Bits |= Byte << BitCount;
+				BitCount += 8;
+			}
+		}
+
+		inline uint32_t inflater::bits(uint32_t aCount) {
+			if (BitCount < aCount) this->refill();
+			uint32_t Value = (uint32_t)(Bits & ((1ull << aCount) - 1));
+			Bits >>= aCount;
+			BitCount -= aCount;
+			return Value;
+		}
+
+		inline uint32_t inflater::decode(const huffman& aCode) {
+			if (BitCount < 16) this->refill();
+			uint16_t Entry = aCode.Fast[Bits & ((1u << huffman::FastBits) - 1)];
+			if (Entry != 0) {
+				uint32_t Length = Entry & 15u;
+				Bits >>= Length;
+				BitCount -= Length;
+				return Entry >> 4;
+			}
+			int32_t Code = 0, First = 0, Index = 0;
+			for (uint32_t l = 1; l < 16; l++) {
+				Code |= (int32_t)(Bits & 1u);
+				Bits >>= 1;
+				BitCount--;
+				int32_t Count = aCode.Count[l];
+				if (Code - First < Count) return aCode.Symbol[Index + (Code - First)];
+				Index += Count;
+				First = (First + Count) << 1;
+				Code <<= 1;
+			}
+			throw std::runtime_error("inflate: invalid Huffman code");
+		}
+
+		inline void inflater::run(std::vector<uint8_t>& aOut) {
+			static huffman FixedLength, FixedDistance;
+			static bool FixedReady = [&]() {
+				uint8_t Length[288];
+				for (std::size_t i = 0; i < 144; i++) Length[i] = 8;
+				for (std::size_t i = 144; i < 256; i++) Length[i] = 9;
+				for (std::size_t i = 256; i < 280; i++) Length[i] = 7;
+				for (std::size_t i = 280; i < 288; i++) Length[i] = 8;
+				FixedLength.build(Length, 288);
+				for (std::size_t i = 0; i < 30; i++) Length[i] = 5;
+				FixedDistance.build(Length, 30);
+				return true;
+			}();
+			(void)FixedReady;
+
+			huffman Length, Distance;
+			bool Last = false;
+			while (!Last) {
+				Last = this->bits(1) != 0;
+				uint32_t Type = this->bits(2);
+				if (Type == 0) this->stored(aOut);
+				else if (Type == 1) this->compressed(aOut, FixedLength, FixedDistance);
+				else if (Type == 2) { this->dynamic(Length, Distance); this->compressed(aOut, Length, Distance); }
+				else throw std::runtime_error("inflate: invalid block type");
+			}
+		}
+
+		inline void inflater::stored(std::vector<uint8_t>& aOut) {
+			// Drop to the byte boundary, then return whole unread bytes to the stream.
+			Bits >>= BitCount % 8;
+			BitCount -= BitCount % 8;
+			Position -= BitCount / 8;
+			Bits = 0;
+			BitCount = 0;
+			if (Position + 4 > Size) throw std::runtime_error("inflate: truncated stored block");
+			uint32_t Length = Data[Position] | (Data[Position + 1] << 8);
+			uint32_t Complement = Data[Position + 2] | (Data[Position + 3] << 8);
+			Position += 4;
+			if ((Length ^ 0xFFFFu) != Complement) throw std::runtime_error("inflate: stored block length mismatch");
+			if (Position + Length > Size) throw std::runtime_error("inflate: truncated stored block");
+			aOut.insert(aOut.end(), Data + Position, Data + Position + Length);
+			Position += Length;
+		}
+
+		inline void inflater::compressed(std::vector<uint8_t>& aOut, const huffman& aLength, const huffman& aDistance) {
+			static const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static const uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			static const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			static const uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+			while (true) {
+				uint32_t Symbol = this->decode(aLength);
+				if (Symbol < 256) {
+					aOut.push_back((uint8_t)Symbol);
+					continue;
+				}
+				if (Symbol == 256) break;
+				Symbol -= 257;
+				if (Symbol >= 29) throw std::runtime_error("inflate: invalid length symbol");
+				uint32_t Length = LengthBase[Symbol] + this->bits(LengthExtra[Symbol]);
+				uint32_t DistanceSymbol = this->decode(aDistance);
+				if (DistanceSymbol >= 30) throw std::runtime_error("inflate: invalid distance symbol");
+				std::size_t Distance = DistanceBase[DistanceSymbol] + this->bits(DistanceExtra[DistanceSymbol]);
+				if (Distance > aOut.size()) throw std::runtime_error("inflate: distance before start of output");
+				std::size_t From = aOut.size() - Distance;
+				std::size_t To = aOut.size();
+				aOut.resize(To + Length);
+				uint8_t* Out = aOut.data();
+				// Byte by byte, source and destination overlap when Distance < Length.
+				for (uint32_t i = 0; i < Length; i++) Out[To + i] = Out[From + i];
+			}
+		}
+
+		inline void inflater::dynamic(huffman& aLength, huffman& aDistance) {
+			static const uint8_t Order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+			uint32_t LengthCount = this->bits(5) + 257;
+			uint32_t DistanceCount = this->bits(5) + 1;
+			uint32_t CodeCount = this->bits(4) + 4;
+			if ((LengthCount > 286) || (DistanceCount > 30)) throw std::runtime_error("inflate: too many codes");
+			uint8_t CodeLength[19] = {};
+			for (uint32_t i = 0; i < CodeCount; i++) CodeLength[Order[i]] = (uint8_t)this->bits(3);
+			huffman Code;
+			Code.build(CodeLength, 19);
+			uint8_t Length[286 + 30] = {};
+			uint32_t Index = 0;
+			while (Index < LengthCount + DistanceCount) {
+				uint32_t Symbol = this->decode(Code);
+				uint32_t Repeat = 0;
+				uint8_t Value = 0;
+				if (Symbol < 16) { Length[Index++] = (uint8_t)Symbol; continue; }
+				if (Symbol == 16) {
+					if (Index == 0) throw std::runtime_error("inflate: repeat with no previous length");
+					Value = Length[Index - 1];
+					Repeat = 3 + this->bits(2);
+				}
+				else if (Symbol == 17) Repeat = 3 + this->bits(3);
+				else Repeat = 11 + this->bits(7);
+				if (Index + Repeat > LengthCount + DistanceCount) throw std::runtime_error("inflate: code lengths overflow");
+				while (Repeat-- > 0) Length[Index++] = Value;
+			}
+			if (Length[256] == 0) throw std::runtime_error("inflate: missing end of block code");
+			aLength.build(Length, LengthCount);
+			aDistance.build(Length + LengthCount, DistanceCount);
+		}
+
+		inline uint32_t read_be32(const uint8_t* aData) {
+			return ((uint32_t)aData[0] << 24) | ((uint32_t)aData[1] << 16) | ((uint32_t)aData[2] << 8) | (uint32_t)aData[3];
+		}
+
+		inline uint8_t paeth(uint8_t aA, uint8_t aB, uint8_t aC) {
+			int P = (int)aA + (int)aB - (int)aC;
+			int PA = std::abs(P - (int)aA), PB = std::abs(P - (int)aB), PC = std::abs(P - (int)aC);
+			if ((PA <= PB) && (PA <= PC)) return aA;
+			return PB <= PC ? aB : aC;
+		}
+
+	}
+
+	// True when aData starts with the PNG signature.
+	inline bool is_png(const uint8_t* aData, std::size_t aSize) {
+		static const uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		return (aSize >= 8) && (std::memcmp(aData, Signature, 8) == 0);
+	}
+
+	// Decodes a PNG to RGBA8. All color types, bit depths and Adam7 interlacing are
+	// supported, 16 bit channels keep their high byte. Chunk CRCs are not verified.
+	inline image decode_png(const uint8_t* aData, std::size_t aSize) {
+		if (!is_png(aData, aSize)) throw std::runtime_error("png: missing signature");
+		uint32_t Width = 0, Height = 0;
+		uint8_t Depth = 0, ColorType = 0, Interlace = 0;
+		std::vector<uint8_t> Palette, Transparency, Compressed;
+		std::size_t Offset = 8;
+		bool End = false;
+		while (!End) {
+			if (Offset + 12 > aSize) throw std::runtime_error("png: truncated chunk");
+			uint32_t Length = detail::read_be32(aData + Offset);
+			const uint8_t* Type = aData + Offset + 4;
+			const uint8_t* Body = aData + Offset + 8;
+			if (Length > aSize - Offset - 12) throw std::runtime_error("png: truncated chunk");
+			if (std::memcmp(Type, "IHDR", 4) == 0) {
+				if (Length < 13) throw std::runtime_error("png: short IHDR");
+				Width 		= detail::read_be32(Body);
+				Height 		= detail::read_be32(Body + 4);
+				Depth 		= Body[8];
+				ColorType 	= Body[9];
+				Interlace 	= Body[12];
+			}
+			else if (std::memcmp(Type, "PLTE", 4) == 0) Palette.assign(Body, Body + Length);
+			else if (std::memcmp(Type, "tRNS", 4) == 0) Transparency.assign(Body, Body + Length);
+			else if (std::memcmp(Type, "IDAT", 4) == 0) Compressed.insert(Compressed.end(), Body, Body + Length);
+			else if (std::memcmp(Type, "IEND", 4) == 0) End = true;
+			Offset += 12 + Length;
+		}
+
+		std::size_t Channels = 0;
+		switch (ColorType) {
+		case 0: Channels = 1; break;
+		case 2: Channels = 3; break;
+		case 3: Channels = 1; break;
+		case 4: Channels = 2; break;
+		case 6: Channels = 4; break;
+		default: throw std::runtime_error("png: invalid color type");
+		}
+		bool ValidDepth = (Depth == 8) || (Depth == 16) || (((ColorType == 0) || (ColorType == 3)) && ((Depth == 1) || (Depth == 2) || (Depth == 4)));
+		if (!ValidDepth || (ColorType == 3 && Depth == 16)) throw std::runtime_error("png: invalid bit depth");
+		if ((Width == 0) || (Height == 0) || (Width > (1u << 24)) || (Height > (1u << 24))) throw std::runtime_error("png: invalid dimensions");
+		if ((ColorType == 3) && Palette.empty()) throw std::runtime_error("png: missing palette");
+		if (Compressed.size() < 2) throw std::runtime_error("png: missing image data");
+		if (((Compressed[0] & 0x0F) != 8) || ((Compressed[1] & 0x20) != 0) || ((((uint32_t)Compressed[0] << 8) | Compressed[1]) % 31 != 0)) throw std::runtime_error("png: invalid zlib header");
+
+		// Pass geometry, a single pass unless Adam7 interlaced.
+		struct pass { uint32_t X, Y, DX, DY; };
+		static const pass Adam7[7] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+		static const pass Single[1] = { { 0, 0, 1, 1 } };
+		const pass* PassList = Interlace ? Adam7 : Single;
+		std::size_t PassCount = Interlace ? 7 : 1;
+		std::size_t BitsPerPixel = Channels * Depth;
+		std::size_t Stride = (BitsPerPixel + 7) / 8;
+
+		std::size_t Expected = 0;
+		for (std::size_t p = 0; p < PassCount; p++) {
+			std::size_t PassWidth = (Width + PassList[p].DX - 1 - PassList[p].X) / PassList[p].DX;
+			std::size_t PassHeight = (Height + PassList[p].DY - 1 - PassList[p].Y) / PassList[p].DY;
+			if ((PassWidth > 0) && (PassHeight > 0)) Expected += PassHeight * (1 + (PassWidth * BitsPerPixel + 7) / 8);
+		}
+		// Expected comes from the untrusted header, so the reservation is capped by what the
+		// compressed data plausibly inflates to and the vector grows past it if needed.
+		std::vector<uint8_t> Raw;
+		Raw.reserve(std::min(Expected, Compressed.size() * 8));
+		detail::inflater(Compressed.data() + 2, Compressed.size() - 2).run(Raw);
+		if (Raw.size() < Expected) throw std::runtime_error("png: image data too short");
+
+		image Image;
+		Image.Width = Width;
+		Image.Height = Height;
+		Image.Pixel.resize((std::size_t)Width * Height * 4);
+		uint8_t* Raw8 = Raw.data();
+		std::size_t RawOffset = 0;
+		for (std::size_t p = 0; p < PassCount; p++) {
+			const pass& P = PassList[p];
+			std::size_t PassWidth = (Width + P.DX - 1 - P.X) / P.DX;
+			std::size_t PassHeight = (Height + P.DY - 1 - P.Y) / P.DY;
+			if ((PassWidth == 0) || (PassHeight == 0)) continue;
+			std::size_t RowBytes = (PassWidth * BitsPerPixel + 7) / 8;
+			uint8_t* Previous = nullptr;
+			for (std::size_t y = 0; y < PassHeight; y++) {
+				uint8_t Filter = Raw8[RawOffset];
+				uint8_t* Row = Raw8 + RawOffset + 1;
+				RawOffset += 1 + RowBytes;
+				// Undo the row filter in place.
+				for (std::size_t i = 0; i < RowBytes; i++) {
+					uint8_t A = i >= Stride ? Row[i - Stride] : 0;
+					uint8_t B = Previous != nullptr ? Previous[i] : 0;
+					uint8_t C = (Previous != nullptr) && (i >= Stride) ? Previous[i - Stride] : 0;
+					switch (Filter) {
+					case 0: break;
+					case 1: Row[i] += A; break;
+					case 2: Row[i] += B; break;
+					case 3: Row[i] += (uint8_t)(((uint32_t)A + B) / 2); break;
+					case 4: Row[i] += detail::paeth(A, B, C); break;
+					default: throw std::runtime_error("png: invalid filter type");
+					}
+				}
+				Previous = Row;
+
+				// Expand to RGBA8.
+				uint8_t* Out = Image.Pixel.data() + ((P.Y + y * P.DY) * (std::size_t)Width) * 4;
+				if ((Depth == 8) && (P.DX == 1) && (((ColorType == 2) && Transparency.empty()) || (ColorType == 6))) {
+					// Common case for color textures.
+					if (ColorType == 6) {
+						std::memcpy(Out, Row, PassWidth * 4);
+						continue;
+					}
+					for (std::size_t x = 0; x < PassWidth; x++) {
+						Out[x * 4] = Row[x * 3]; Out[x * 4 + 1] = Row[x * 3 + 1]; Out[x * 4 + 2] = Row[x * 3 + 2]; Out[x * 4 + 3] = 255;
+					}
+					continue;
+				}
+				for (std::size_t x = 0; x < PassWidth; x++) {
+					uint8_t* Pixel = Out + (P.X + x * P.DX) * 4;
+					uint16_t Sample[4] = { 0, 0, 0, 0 };
+					if (Depth < 8) {
+						std::size_t Bit = x * Depth;
+						Sample[0] = (uint16_t)((Row[Bit / 8] >> (8 - Depth - Bit % 8)) & ((1u << Depth) - 1));
+					}
+					else {
+						for (std::size_t c = 0; c < Channels; c++) {
+							Sample[c] = Depth == 16 ? (uint16_t)((Row[(x * Channels + c) * 2] << 8) | Row[(x * Channels + c) * 2 + 1]) : Row[x * Channels + c];
+						}
+					}
+					auto scale = [&](uint16_t aValue) -> uint8_t {
+						if (Depth == 16) return (uint8_t)(aValue >> 8);
+						if (Depth == 8) return (uint8_t)aValue;
+						return (uint8_t)(aValue * 255u / ((1u << Depth) - 1));
+					};
+					switch (ColorType) {
+					case 0:
+						Pixel[0] = Pixel[1] = Pixel[2] = scale(Sample[0]);
+						Pixel[3] = ((Transparency.size() >= 2) && (Sample[0] == ((Transparency[0] << 8) | Transparency[1]))) ? 0 : 255;
+						break;
+					case 2:
+						Pixel[0] = scale(Sample[0]); Pixel[1] = scale(Sample[1]); Pixel[2] = scale(Sample[2]);
+						Pixel[3] = ((Transparency.size() >= 6)
+							&& (Sample[0] == ((Transparency[0] << 8) | Transparency[1]))
+							&& (Sample[1] == ((Transparency[2] << 8) | Transparency[3]))
+							&& (Sample[2] == ((Transparency[4] << 8) | Transparency[5]))) ? 0 : 255;
+						break;
+					case 3:
+						if ((std::size_t)Sample[0] * 3 + 2 >= Palette.size()) throw std::runtime_error("png: palette index out of range");
+						Pixel[0] = Palette[Sample[0] * 3]; Pixel[1] = Palette[Sample[0] * 3 + 1]; Pixel[2] = Palette[Sample[0] * 3 + 2];
+						Pixel[3] = Sample[0] < Transparency.size() ? Transparency[Sample[0]] : 255;
+						break;
+					case 4:
+						Pixel[0] = Pixel[1] = Pixel[2] = scale(Sample[0]);
+						Pixel[3] = scale(Sample[1]);
+						break;
+					case 6:
+						Pixel[0] = scale(Sample[0]); Pixel[1] = scale(Sample[1]); Pixel[2] = scale(Sample[2]); Pixel[3] = scale(Sample[3]);
+						break;
+					}
+				}
+			}
+		}
+		return Image;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_PNG_H
@@ -0,0 +1,409 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_PROFILER_H
+#define GEODESY_UNIT_TEST_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+// Scoped timing of a block into the process wide profiler. Category and name must be
+// string literals (or profiler::intern results), the detail is optional. Defining
+// GEODESY_PROFILE_DISABLED compiles every scope out.
+#if !defined(GEODESY_PROFILE_DISABLED)
+#define GEODESY_PROFILE_CONCAT_(A, B) A##B
+#define GEODESY_PROFILE_CONCAT(A, B) GEODESY_PROFILE_CONCAT_(A, B)
+#define GEODESY_PROFILE_SCOPE(...) ::geodesy::profiler::scope GEODESY_PROFILE_CONCAT(ProfileScope, __LINE__)(__VA_ARGS__)
+#else
+#define GEODESY_PROFILE_SCOPE(...) ((void)0)
+#endif
+
+namespace geodesy {
+
+	// Low overhead frame and phase profiler. Each thread writes completed scopes into its
+	// own fixed size ring, so recording takes two clock reads and no lock or allocation,
+	// and a full ring overwrites its oldest events. Every slot is a seqlock: readers copy
+	// the rings while writers keep going and keep a slot only if its sequence number was
+	// the same, and even, before and after the copy. Frame times go
+	// to a separate rolling window for percentile stats. Rings are exported as Chrome
+	// trace JSON, which chrome://tracing and ui.perfetto.dev open directly.
+	//
+	// instance() is the process wide profiler that GEODESY_PROFILE_SCOPE records into.
+	// Other instances, such as a test's own, keep their events and frames apart from it.
+	// They give each thread that records into them a ring for their whole lifetime.
+	class profiler {
+	public:
+
+		struct event {
+			const char* 	Category;
+			const char* 	Name;
+			const char* 	Detail; 			// nullptr or an interned string.
+			uint64_t 		Start; 				// [ns] since the profiler was created.
+			uint64_t 		Duration; 			// [ns]
+			uint32_t 		Thread;
+		};
+
+		// Over the last FrameCapacity frames, in milliseconds.
+		struct frame_stats {
+			std::size_t 	Count;
+			double 			Mean;
+			double 			P50;
+			double 			P90;
+			double 			P99;
+			double 			Max;
+		};
+
+		static constexpr std::size_t ThreadCapacity 	= 1 << 13; 		// Events kept per thread.
+		static constexpr std::size_t FrameCapacity 		= 1024;
+
+		class scope {
+		public:
+			scope(const char* aCategory, const char* aName, const char* aDetail = nullptr);
+			scope(profiler& aProfiler, const char* aCategory, const char* aName, const char* aDetail = nullptr);
+			scope(const scope&) = delete;
+			scope& operator=(const scope&) = delete;
+			~scope();
+		private:
+			profiler* 		Owner;
+			const char* 	Category;
+			const char* 	Name;
+			const char* 	Detail;
+			uint64_t 		Start;
+		};
+
+		// Recording is on by default, cheap enough to leave on in release builds.
+		std::atomic<bool> Enabled;
+
+		profiler();
+		profiler(const profiler&) = delete;
+		profiler& operator=(const profiler&) = delete;
+
+		static profiler& instance();
+		// [ns] since the profiler was created.
+		uint64_t now() const;
+
+		void record(const char* aCategory, const char* aName, const char* aDetail, uint64_t aStart, uint64_t aEnd);
+		// Call once per frame from the frame thread. Records the time since the previous
+		// call as a frame, both as a trace event and in the rolling window.
+		void frame_mark();
+		void record_frame(uint64_t aDuration);
+		frame_stats frame_statistics() const;
+
+		// Returns a pointer that stays valid for the life of the process, for names built
+		// at run time such as object or file names.
+		const char* intern(const std::string& aText);
+		void set_thread_name(const std::string& aName);
+
+		// Every event still held, ordered by start time.
+		std::vector<event> events() const;
+		std::string to_chrome_trace() const;
+		bool write_chrome_trace(const std::string& aPath) const;
+		// Drops recorded events and frames.
+		void clear();
+
+	private:
+
+		// One ring entry. Sequence is odd while event i is written into it and 2 * (i + 1)
+		// once it is complete, the payload is atomic so a copy racing a write is not UB.
+		struct slot {
+			std::atomic<uint64_t> 		Sequence{ 0 };
+			std::atomic<const char*> 	Category{ nullptr };
+			std::atomic<const char*> 	Name{ nullptr };
+			std::atomic<const char*> 	Detail{ nullptr };
+			std::atomic<uint64_t> 		Start{ 0 };
+			std::atomic<uint64_t> 		Duration{ 0 };
+		};
+
+		struct thread_buffer {
+			std::atomic<uint64_t> 	Head{ 0 };
+			std::atomic<uint64_t> 	Floor{ 0 }; 		// Events below this were cleared.
+			uint32_t 				Id;
+			std::string 			Name;
+			bool 					InUse;
+			slot 					Slot[ThreadCapacity];
+		};
+
+		std::chrono::steady_clock::time_point 			Epoch;
+		uint64_t 										Generation; 	// Unique per instance, keys the per thread ring cache.
+		mutable std::mutex 								Mutex;
+		std::vector<std::unique_ptr<thread_buffer>> 	Buffer;
+		std::vector<std::pair<std::thread::id, thread_buffer*>> 	Assigned; 		// Ring of each thread, except in instance().
+		std::unordered_set<std::string> 				Interned;
+		std::atomic<uint64_t> 							LastFrame;
+		std::atomic<uint64_t> 							FrameCount;
+		std::atomic<uint64_t> 							FrameFloor;
+		std::atomic<uint64_t> 							FrameTime[FrameCapacity];
+
+		thread_buffer* local();
+		thread_buffer* acquire();
+		void release(thread_buffer* aBuffer);
+		static std::string escape(const char* aText);
+
+	};
+
+	// ---------- profiler::scope ---------- //
+
+	inline profiler::scope::scope(const char* aCategory, const char* aName, const char* aDetail) : scope(profiler::instance(), aCategory, aName, aDetail) {}
+
+	inline profiler::scope::scope(profiler& aProfiler, const char* aCategory, const char* aName, const char* aDetail) {
+		Owner = &aProfiler;
+		Category = aCategory;
+		Name = aName;
+		Detail = aDetail;
+		Start = Owner->Enabled.load(std::memory_order_relaxed) ? Owner->now() : UINT64_MAX;
+	}
+
+	inline profiler::scope::~scope() {
+		if (Start == UINT64_MAX) return;
+		Owner->record(Category, Name, Detail, Start, Owner->now());
+	}
+
+	// ---------- profiler ---------- //
+
+	inline profiler::profiler() {
+		static std::atomic<uint64_t> NextGeneration{ 1 };
+		Epoch = std::chrono::steady_clock::now();
+		Generation = NextGeneration.fetch_add(1, std::memory_order_relaxed);
+		Enabled = true;
+		LastFrame = 0;
+		FrameCount = 0;
+		FrameFloor = 0;
+		for (std::atomic<uint64_t>& Time : FrameTime) Time = 0;
+	}
+
+	inline profiler& profiler::instance() {
+		static profiler Instance;
+		return Instance;
+	}
+
+	inline uint64_t profiler::now() const {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count();
+	}
+
+	inline void profiler::record(const char* aCategory, const char* aName, const char* aDetail, uint64_t aStart, uint64_t aEnd) {
+		thread_buffer* Local = this->local();
+		// Single writer per ring. The odd sequence is ordered before the payload by the
+		// fence, the even one publishes it, as in a seqlock.
+		uint64_t Head = Local->Head.load(std::memory_order_relaxed);
+		slot& Slot = Local->Slot[Head & (ThreadCapacity - 1)];
+		Slot.Sequence.store(2 * Head + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Slot.Category.store(aCategory, std::memory_order_relaxed);
+		Slot.Name.store(aName, std::memory_order_relaxed);
+		Slot.Detail.store(aDetail, std::memory_order_relaxed);
+		Slot.Start.store(aStart, std::memory_order_relaxed);
+		Slot.Duration.store(aEnd - aStart, std::memory_order_relaxed);
+		Slot.Sequence.store(2 * Head + 2, std::memory_order_release);
+		Local->Head.store(Head + 1, std::memory_order_release);
+	}
+
+	inline void profiler::frame_mark() {
+		uint64_t Now = this->now();
+		uint64_t Last = LastFrame.exchange(Now, std::memory_order_relaxed);
+		if (Last == 0) return;
+		if (Enabled.load(std::memory_order_relaxed)) this->record("frame", "frame", nullptr, Last, Now);
+		this->record_frame(Now - Last);
+	}
+
+	inline void profiler::record_frame(uint64_t aDuration) {
+		uint64_t Index = FrameCount.load(std::memory_order_relaxed);
+		FrameTime[Index % FrameCapacity].store(aDuration, std::memory_order_relaxed);
+		FrameCount.store(Index + 1, std::memory_order_release);
+	}
+
+	inline profiler::frame_stats profiler::frame_statistics() const {
+		uint64_t Count = FrameCount.load(std::memory_order_acquire);
+		uint64_t First = std::max(FrameFloor.load(std::memory_order_relaxed), Count > FrameCapacity ? Count - FrameCapacity : 0);
+		std::vector<double> Time;
+		for (uint64_t i = First; i < Count; i++) Time.push_back((double)FrameTime[i % FrameCapacity].load(std::memory_order_relaxed) * 1e-6);
+		frame_stats Stats{};
+		Stats.Count = Time.size();
+		if (Time.empty()) return Stats;
+		std::sort(Time.begin(), Time.end());
+		// Nearest rank percentiles.
+		auto percentile = [&](double aP) { return Time[(std::size_t)std::max(1.0, std::ceil(aP * (double)Time.size())) - 1]; };
+		double Sum = 0.0;
+		for (double T : Time) Sum += T;
+		Stats.Mean = Sum / (double)Time.size();
+		Stats.P50 = percentile(0.50);
+		Stats.P90 = percentile(0.90);
+		Stats.P99 = percentile(0.99);
+		Stats.Max = Time.back();
+		return Stats;
+	}
+
+	inline const char* profiler::intern(const std::string& aText) {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return Interned.insert(aText).first->c_str();
+	}
+
+	inline void profiler::set_thread_name(const std::string& aName) {
+		thread_buffer* Local = this->local();
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Local->Name = aName;
+	}
+
+	inline std::vector<profiler::event> profiler::events() const {
+		std::vector<event> List;
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (const std::unique_ptr<thread_buffer>& B : Buffer) {
+			uint64_t Head = B->Head.load(std::memory_order_acquire);
+			uint64_t First = std::max(B->Floor.load(std::memory_order_relaxed), Head > ThreadCapacity ? Head - ThreadCapacity : 0);
+			for (uint64_t i = First; i < Head; i++) {
+				// Event i is intact only if its slot held the complete event i before and
+				// after the copy, a slot being rewritten or already lapped is dropped.
+				const slot& Slot = B->Slot[i & (ThreadCapacity - 1)];
+				uint64_t Sequence = Slot.Sequence.load(std::memory_order_acquire);
+				if (Sequence != 2 * i + 2) continue;
+				event Event;
+				Event.Category 	= Slot.Category.load(std::memory_order_relaxed);
+				Event.Name 		= Slot.Name.load(std::memory_order_relaxed);
+				Event.Detail 	= Slot.Detail.load(std::memory_order_relaxed);
+				Event.Start 	= Slot.Start.load(std::memory_order_relaxed);
+				Event.Duration 	= Slot.Duration.load(std::memory_order_relaxed);
+				Event.Thread 	= B->Id;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (Slot.Sequence.load(std::memory_order_relaxed) != Sequence) continue;
+				List.push_back(Event);
+			}
+		}
+		std::sort(List.begin(), List.end(), [](const event& aA, const event& aB) { return aA.Start < aB.Start; });
+		return List;
+	}
+
+	inline std::string profiler::to_chrome_trace() const {
+		std::vector<event> List = this->events();
+		std::stringstream Stream;
+		Stream << std::fixed << std::setprecision(3);
+		Stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool First = true;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			for (const std::unique_ptr<thread_buffer>& B : Buffer) {
+				Stream << (First ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << B->Id
+					   << ",\"args\":{\"name\":\"" << escape(B->Name.c_str()) << "\"}}";
+				First = false;
+			}
+		}
+		for (const event& E : List) {
+			Stream << (First ? "" : ",\n") << "{\"name\":\"" << escape(E.Name) << "\",\"cat\":\"" << escape(E.Category)
+				   << "\",\"ph\":\"X\",\"ts\":" << (double)E.Start * 1e-3 << ",\"dur\":" << (double)E.Duration * 1e-3
+				   << ",\"pid\":1,\"tid\":" << E.Thread;
+			if (E.Detail != nullptr) Stream << ",\"args\":{\"detail\":\"" << escape(E.Detail) << "\"}";
+			Stream << "}";
+			First = false;
+		}
+		Stream << "\n]}\n";
+		return Stream.str();
+	}
+
+	inline bool profiler::write_chrome_trace(const std::string& aPath) const {
+		std::ofstream Stream(aPath, std::ios::binary | std::ios::trunc);
+		Stream << this->to_chrome_trace();
+		return (bool)Stream;
+	}
+
+	inline void profiler::clear() {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (const std::unique_ptr<thread_buffer>& B : Buffer) B->Floor.store(B->Head.load(std::memory_order_acquire), std::memory_order_relaxed);
+		FrameFloor.store(FrameCount.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+
+	inline profiler::thread_buffer* profiler::local() {
+		if (this == &profiler::instance()) {
+			// Hands the ring back when the thread exits, the next new thread reuses it. Its
+			// events stay readable until overwritten.
+			struct holder {
+				thread_buffer* Buffer = nullptr;
+				~holder() { if (Buffer != nullptr) profiler::instance().release(Buffer); }
+			};
+			thread_local holder Holder;
+			if (Holder.Buffer == nullptr) Holder.Buffer = this->acquire();
+			return Holder.Buffer;
+		}
+		// Any other instance may die before the threads that recorded into it, so nothing
+		// is handed back at thread exit. The last instance used is cached by generation, a
+		// new instance at a freed address misses.
+		struct cache {
+			uint64_t 		Generation 	= 0;
+			thread_buffer* 	Buffer 		= nullptr;
+		};
+		thread_local cache Cache;
+		if (Cache.Generation == Generation) return Cache.Buffer;
+		thread_buffer* Local = nullptr;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			for (const std::pair<std::thread::id, thread_buffer*>& O : Assigned) {
+				if (O.first == std::this_thread::get_id()) Local = O.second;
+			}
+		}
+		if (Local == nullptr) {
+			Local = this->acquire();
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Assigned.emplace_back(std::this_thread::get_id(), Local);
+		}
+		Cache = { Generation, Local };
+		return Local;
+	}
+
+	inline profiler::thread_buffer* profiler::acquire() {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (const std::unique_ptr<thread_buffer>& B : Buffer) {
+			if (!B->InUse) {
+				B->InUse = true;
+				B->Name = "thread " + std::to_string(B->Id);
+				return B.get();
+			}
+		}
+		Buffer.push_back(std::make_unique<thread_buffer>());
+		thread_buffer* B = Buffer.back().get();
+		B->Id = (uint32_t)Buffer.size();
+		B->Name = "thread " + std::to_string(B->Id);
+		B->InUse = true;
+		return B;
+	}
+
+	inline void profiler::release(thread_buffer* aBuffer) {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		aBuffer->InUse = false;
+	}
+
+	inline std::string profiler::escape(const char* aText) {
+		std::string Text;
+		for (const char* C = aText; *C != '\0'; C++) {
+			switch (*C) {
+			case '"': Text += "\\\""; break;
+			case '\\': Text += "\\\\"; break;
+			case '\n': Text += "\\n"; break;
+			case '\t': Text += "\\t"; break;
+			default:
+				if ((unsigned char)*C < 0x20) {
+					char Code[8];
+					std::snprintf(Code, sizeof(Code), "\\u%04x", (unsigned)(unsigned char)*C);
+					Text += Code;
+				}
+				else {
+					Text += *C;
+				}
+			}
+		}
+		return Text;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_PROFILER_H
@@ -0,0 +1,484 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_SCENE_BVH_H
+#define GEODESY_UNIT_TEST_SCENE_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/math_simd.h>
+#include <geodesy-unit-test/math_constexpr.h>
+#include <geodesy-unit-test/vec_array.h>
+#include <geodesy-unit-test/gltf.h>
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy {
+
+	struct aabb {
+		math::vec<float, 3> 	Min;
+		math::vec<float, 3> 	Max;
+
+		// Bounds of the box after an affine transform.
+		aabb transformed(const math::mat<float, 4, 4>& aTransform) const;
+	};
+
+	// Six planes a x + b y + c z + d >= 0 bounding what a camera sees.
+	struct frustum {
+		float 	Plane[6][4]; 		// Left, right, bottom, top, near, far. Unit normals.
+
+		// Planes of a view projection matrix mapping to Vulkan clip space (depth in [0, 1]).
+		static frustum from_matrix(const math::mat<float, 4, 4>& aViewProjection);
+		// A camera looking down -z of its view space, aFieldOfView vertical in degrees as in
+		// a world file's FOV.
+		static frustum from_camera(const math::mat<float, 4, 4>& aView, float aFieldOfView, float aAspectRatio, float aNear, float aFar);
+		// Conservative box test, true unless the box lies outside one of the planes.
+		bool intersects(const aabb& aBox) const;
+	};
+
+	// Object space bounds of a glTF mesh, from the min and max of its POSITION accessors,
+	// or from the vertex data when a file leaves them out.
+	aabb mesh_bounds(const io::gltf& aModel, std::size_t aMesh);
+
+	// Bounding volume hierarchy over the world space boxes of a stage's objects and meshes,
+	// queried with the camera's frustum before draw submission. Nodes have eight children
+	// stored as structure of arrays, so one query tests all children of a node at once,
+	// eight boxes per AVX2 instruction or four per SSE instruction. A node entirely inside
+	// the frustum emits its whole subtree without further tests, the items of every node
+	// are a contiguous run of one array.
+	//
+	// add() and remove() mark the tree for a rebuild on the next query. set_bounds() refits
+	// the boxes on the item's path to the root instead, which keeps the tree valid but lets
+	// it loosen as objects travel. Call rebuild() when that shows in the culling statistics.
+	class scene_bvh {
+	public:
+
+		using id = uint32_t;
+
+		static constexpr id None = UINT32_MAX;
+		static constexpr std::size_t Width = 8; 		// Children per node.
+
+		struct statistics {
+			std::size_t 	Visible 	= 0;
+			std::size_t 	Culled 		= 0;
+			std::size_t 	NodeTests 	= 0; 		// Nodes whose children were tested against the planes.
+		};
+
+		scene_bvh();
+
+		id add(const aabb& aBounds);
+		void remove(id aItem);
+		// Moves an item, its ancestors' boxes are refit on the next query.
+		void set_bounds(id aItem, const aabb& aBounds);
+		const aabb& bounds(id aItem) const;
+		// Items added and not removed.
+		std::size_t size() const;
+		std::size_t node_count() const;
+
+		// Rebuilds the tree from the current bounds.
+		void rebuild();
+		// Writes the ids of items intersecting aFrustum to aVisible, replacing its contents.
+		void cull(const frustum& aFrustum, std::vector<id>& aVisible);
+		// Of the last cull().
+		const statistics& stats() const;
+
+	private:
+
+		static constexpr uint32_t ItemBit = 0x80000000u; 		// Child is an item, not a node.
+
+		struct node {
+			float 		Min[3][Width];
+			float 		Max[3][Width];
+			uint32_t 	Child[Width]; 		// Node index, item | ItemBit or None.
+			uint32_t 	Parent;
+			uint32_t 	First; 				// Subtree items are Order[First, First + Count).
+			uint32_t 	Count;
+			uint32_t 	Dirty;
+		};
+
+		std::vector<aabb> 		Bounds;
+		std::vector<uint8_t> 	Alive;
+		std::vector<id> 		Free;
+		std::size_t 			Live;
+		std::vector<node> 		Node;
+		std::vector<id> 		Order;
+		std::vector<uint32_t> 	ItemNode; 		// Node holding the item, None before a build.
+		std::vector<uint32_t> 	ItemSlot;
+		std::vector<uint32_t> 	Moved; 			// Nodes whose children's boxes changed.
+		bool 					Stale;
+		statistics 				Stats;
+		std::vector<uint32_t> 	Stack;
+
+		// Box centre and item, partitioned in place while building.
+		struct build_entry {
+			float 	Center[3];
+			id 		Item;
+		};
+
+		uint32_t build(uint32_t aParent, uint32_t aFirst, uint32_t aCount, std::vector<build_entry>& aEntry);
+		void refit();
+		void set_child(node& aNode, std::size_t aSlot, const aabb& aBox);
+		aabb node_bounds(uint32_t aNode) const;
+
+	};
+
+	// ---------- aabb ---------- //
+
+	inline aabb aabb::transformed(const math::mat<float, 4, 4>& aTransform) const {
+		// Each output axis adds the smaller and larger product of every input axis (Arvo).
+		aabb Box;
+		for (std::size_t r = 0; r < 3; r++) {
+			Box.Min[r] = Box.Max[r] = aTransform(r, 3);
+			for (std::size_t c = 0; c < 3; c++) {
+				float A = aTransform(r, c) * Min[c], B = aTransform(r, c) * Max[c];
+				Box.Min[r] += std::min(A, B);
+				Box.Max[r] += std::max(A, B);
+			}
+		}
+		return Box;
+	}
+
+	// ---------- frustum ---------- //
+
+	inline frustum frustum::from_matrix(const math::mat<float, 4, 4>& aViewProjection) {
+		const math::mat<float, 4, 4>& M = aViewProjection;
+		// Clip space -w <= x, y <= w and 0 <= z <= w as combinations of the matrix rows.
+		static const int Row[6] = { 0, 0, 1, 1, 2, 2 };
+		static const float Sign[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+		frustum Frustum;
+		for (std::size_t p = 0; p < 6; p++) {
+			float W = p == 4 ? 0.0f : 1.0f;
+			for (std::size_t c = 0; c < 4; c++) Frustum.Plane[p][c] = W * M(3, c) + Sign[p] * M(Row[p], c);
+			float* P = Frustum.Plane[p];
+			float Length = std::sqrt(P[0] * P[0] + P[1] * P[1] + P[2] * P[2]);
+			if (Length > 0.0f) for (std::size_t c = 0; c < 4; c++) P[c] /= Length;
+		}
+		return Frustum;
+	}
+
+	inline frustum frustum::from_camera(const math::mat<float, 4, 4>& aView, float aFieldOfView, float aAspectRatio, float aNear, float aFar) {
+		math::mat<float, 4, 4> Projection = math::constant::perspective(aFieldOfView * math::constant::Pi<float> / 180.0f, aAspectRatio, aNear, aFar);
+		return from_matrix(math::simd::mul(Projection, aView));
+	}
+
+	inline bool frustum::intersects(const aabb& aBox) const {
+		for (std::size_t p = 0; p < 6; p++) {
+			const float* P = Plane[p];
+			// The box corner furthest along the normal.
+			float Distance = P[3];
+			for (std::size_t k = 0; k < 3; k++) Distance += P[k] * (P[k] > 0.0f ? aBox.Max[k] : aBox.Min[k]);
+			if (Distance < 0.0f) return false;
+		}
+		return true;
+	}
+
+	// ---------- mesh_bounds ---------- //
+
+	inline aabb mesh_bounds(const io::gltf& aModel, std::size_t aMesh) {
+		if (aMesh >= aModel.Mesh.size()) throw std::out_of_range("mesh_bounds: mesh " + std::to_string(aMesh) + " not found");
+		aabb Box{ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+		for (const io::gltf::primitive& Primitive : aModel.Mesh[aMesh].Primitive) {
+			std::size_t Accessor = Primitive.attribute("POSITION");
+			if (Accessor == SIZE_MAX) continue;
+			const io::json& Min = aModel.Document["accessors"][Accessor]["min"];
+			const io::json& Max = aModel.Document["accessors"][Accessor]["max"];
+			if ((Min.size() == 3) && (Max.size() == 3)) {
+				for (std::size_t k = 0; k < 3; k++) {
+					Box.Min[k] = std::min(Box.Min[k], (float)Min[k].as_double());
+					Box.Max[k] = std::max(Box.Max[k], (float)Max[k].as_double());
+				}
+				continue;
+			}
+			io::gltf::view View = aModel.accessor_view(Accessor);
+			for (std::size_t i = 0; i < View.Count; i++) {
+				for (std::size_t k = 0; k < 3; k++) {
+					float V = View.component(i, k);
+					Box.Min[k] = std::min(Box.Min[k], V);
+					Box.Max[k] = std::max(Box.Max[k], V);
+				}
+			}
+		}
+		if (Box.Min[0] > Box.Max[0]) return aabb{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+		return Box;
+	}
+
+	// ---------- scene_bvh ---------- //
+
+	inline scene_bvh::scene_bvh() {
+		Live = 0;
+		Stale = false;
+	}
+
+	inline scene_bvh::id scene_bvh::add(const aabb& aBounds) {
+		id Item;
+		if (!Free.empty()) {
+			Item = Free.back();
+			Free.pop_back();
+			Bounds[Item] = aBounds;
+			Alive[Item] = 1;
+		}
+		else {
+			Item = (id)Bounds.size();
+			if (Item >= ItemBit) throw std::length_error("scene_bvh: too many items");
+			Bounds.push_back(aBounds);
+			Alive.push_back(1);
+			ItemNode.push_back(None);
+			ItemSlot.push_back(0);
+		}
+		Live++;
+		Stale = true;
+		return Item;
+	}
+
+	inline void scene_bvh::remove(id aItem) {
+		if ((aItem >= Bounds.size()) || !Alive[aItem]) throw std::invalid_argument("scene_bvh: item " + std::to_string(aItem) + " does not exist");
+		Alive[aItem] = 0;
+		Free.push_back(aItem);
+		Live--;
+		Stale = true;
+	}
+
+	inline void scene_bvh::set_bounds(id aItem, const aabb& aBounds) {
+		if ((aItem >= Bounds.size()) || !Alive[aItem]) throw std::invalid_argument("scene_bvh: item " + std::to_string(aItem) + " does not exist");
+		Bounds[aItem] = aBounds;
+		if (Stale || (ItemNode[aItem] == None)) return;
+		node& N = Node[ItemNode[aItem]];
+		this->set_child(N, ItemSlot[aItem], aBounds);
+		if (!N.Dirty) {
+			N.Dirty = 1;
+			Moved.push_back(ItemNode[aItem]);
+		}
+	}
+
+	inline const aabb& scene_bvh::bounds(id aItem) const {
+		return Bounds[aItem];
+	}
+
+	inline std::size_t scene_bvh::size() const {
+		return Live;
+	}
+
+	inline std::size_t scene_bvh::node_count() const {
+		return Node.size();
+	}
+
+	inline void scene_bvh::rebuild() {
+		GEODESY_PROFILE_SCOPE("bvh", "rebuild");
+		Node.clear();
+		Order.clear();
+		Moved.clear();
+		std::fill(ItemNode.begin(), ItemNode.end(), None);
+		// Centres are split on, copied next to their ids so partitioning reads memory in order.
+		std::vector<build_entry> Entry;
+		Entry.reserve(Live);
+		for (id i = 0; i < Bounds.size(); i++) {
+			if (!Alive[i]) continue;
+			const aabb& B = Bounds[i];
+			Entry.push_back({ { 0.5f * (B.Min[0] + B.Max[0]), 0.5f * (B.Min[1] + B.Max[1]), 0.5f * (B.Min[2] + B.Max[2]) }, i });
+		}
+		Node.reserve(2 * Entry.size() / (Width - 1) + 1);
+		this->build(None, 0, (uint32_t)Entry.size(), Entry);
+		for (const build_entry& E : Entry) Order.push_back(E.Item);
+		Stale = false;
+	}
+
+	inline void scene_bvh::cull(const frustum& aFrustum, std::vector<id>& aVisible) {
+		GEODESY_PROFILE_SCOPE("bvh", "cull");
+		if (Stale) this->rebuild();
+		else this->refit();
+		aVisible.clear();
+		Stats = statistics();
+		Stats.Culled = Live;
+		if (Live == 0) return;
+
+		using lane = math::detail::lane;
+		static_assert(Width % lane::Width == 0, "scene_bvh node width must be a multiple of the SIMD width.");
+		// Per plane, which of Min and Max gives the corner furthest along (Outer) and
+		// against (Inner) the normal.
+		lane Normal[6][3], Offset[6];
+		bool Positive[6][3];
+		for (std::size_t p = 0; p < 6; p++) {
+			for (std::size_t k = 0; k < 3; k++) {
+				Normal[p][k] = lane::set(aFrustum.Plane[p][k]);
+				Positive[p][k] = aFrustum.Plane[p][k] > 0.0f;
+			}
+			Offset[p] = lane::set(aFrustum.Plane[p][3]);
+		}
+		float Outer[Width], Inner[Width];
+		Stack.clear();
+		Stack.push_back(0);
+		while (!Stack.empty()) {
+			const node& N = Node[Stack.back()];
+			Stack.pop_back();
+			Stats.NodeTests++;
+			for (std::size_t l = 0; l < Width; l += lane::Width) {
+				lane Near = lane::set(FLT_MAX), Far = lane::set(FLT_MAX);
+				for (std::size_t p = 0; p < 6; p++) {
+					lane Out = Offset[p], In = Offset[p];
+					for (std::size_t k = 0; k < 3; k++) {
+						lane Low = lane::load(&N.Min[k][l]), High = lane::load(&N.Max[k][l]);
+						Out = Out + Normal[p][k] * (Positive[p][k] ? High : Low);
+						In = In + Normal[p][k] * (Positive[p][k] ? Low : High);
+					}
+					Near = min(Near, Out);
+					Far = min(Far, In);
+				}
+				Near.lanes(Outer + l);
+				Far.lanes(Inner + l);
+			}
+			for (std::size_t c = 0; c < Width; c++) {
+				uint32_t Child = N.Child[c];
+				// Outside one plane, or the slot is empty.
+				if ((Child == None) || (Outer[c] < 0.0f)) continue;
+				if (Child & ItemBit) {
+					aVisible.push_back(Child & ~ItemBit);
+				}
+				else if (Inner[c] >= 0.0f) {
+					const node& Inside = Node[Child];
+					aVisible.insert(aVisible.end(), Order.begin() + Inside.First, Order.begin() + Inside.First + Inside.Count);
+				}
+				else {
+					Stack.push_back(Child);
+				}
+			}
+		}
+		Stats.Visible = aVisible.size();
+		Stats.Culled = Live - aVisible.size();
+	}
+
+	inline const scene_bvh::statistics& scene_bvh::stats() const {
+		return Stats;
+	}
+
+	inline uint32_t scene_bvh::build(uint32_t aParent, uint32_t aFirst, uint32_t aCount, std::vector<build_entry>& aEntry) {
+		uint32_t Index = (uint32_t)Node.size();
+		Node.emplace_back();
+		{
+			node& N = Node.back();
+			N.Parent = aParent;
+			N.First = aFirst;
+			N.Count = aCount;
+			N.Dirty = 0;
+			for (std::size_t c = 0; c < Width; c++) {
+				N.Child[c] = None;
+				for (std::size_t k = 0; k < 3; k++) {
+					N.Min[k][c] = FLT_MAX;
+					N.Max[k][c] = -FLT_MAX;
+				}
+			}
+		}
+		// A node of up to Width items holds them directly. Larger ones are split in up to
+		// Width groups by halving the largest group at the median centre of its widest
+		// axis, until every group fits in one node.
+		struct group { uint32_t First, Count; };
+		group Group[Width];
+		std::size_t GroupCount = 0;
+		if (aCount <= Width) for (uint32_t i = 0; i < aCount; i++) Group[GroupCount++] = { aFirst + i, 1 };
+		else Group[GroupCount++] = { aFirst, aCount };
+		while ((aCount > Width) && (GroupCount < Width)) {
+			std::size_t Largest = 0;
+			for (std::size_t g = 1; g < GroupCount; g++) if (Group[g].Count > Group[Largest].Count) Largest = g;
+			group G = Group[Largest];
+			if (G.Count <= Width) break;
+			float Low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, High[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (uint32_t i = G.First; i < G.First + G.Count; i++) {
+				for (std::size_t k = 0; k < 3; k++) {
+					float V = aEntry[i].Center[k];
+					Low[k] = std::min(Low[k], V);
+					High[k] = std::max(High[k], V);
+				}
+			}
+			std::size_t Axis = 0;
+			for (std::size_t k = 1; k < 3; k++) if (High[k] - Low[k] > High[Axis] - Low[Axis]) Axis = k;
+			uint32_t Half = G.Count / 2;
+			std::nth_element(aEntry.begin() + G.First, aEntry.begin() + G.First + Half, aEntry.begin() + G.First + G.Count, [&](const build_entry& aA, const build_entry& aB) {
+				return (aA.Center[Axis] < aB.Center[Axis]) || ((aA.Center[Axis] == aB.Center[Axis]) && (aA.Item < aB.Item));
+			});
+			std::copy_backward(Group + Largest + 1, Group + GroupCount, Group + GroupCount + 1);
+			Group[Largest] = { G.First, Half };
+			Group[Largest + 1] = { G.First + Half, G.Count - Half };
+			GroupCount++;
+		}
+		for (std::size_t c = 0; c < GroupCount; c++) {
+			if (Group[c].Count == 0) continue;
+			if (Group[c].Count == 1) {
+				id Item = aEntry[Group[c].First].Item;
+				Node[Index].Child[c] = Item | ItemBit;
+				ItemNode[Item] = Index;
+				ItemSlot[Item] = (uint32_t)c;
+				this->set_child(Node[Index], c, Bounds[Item]);
+			}
+			else {
+				// Node may grow, the child is linked once it is built.
+				uint32_t Child = this->build(Index, Group[c].First, Group[c].Count, aEntry);
+				Node[Index].Child[c] = Child;
+				this->set_child(Node[Index], c, this->node_bounds(Child));
+			}
+		}
+		return Index;
+	}
+
+	inline void scene_bvh::refit() {
+		if (Moved.empty()) return;
+		GEODESY_PROFILE_SCOPE("bvh", "refit");
+		// Children come after their parents, so taking the highest node first refits every
+		// node after all of its children. Many moved nodes are cheaper to find by walking
+		// every node backwards than through a heap.
+		auto refit_node = [&](uint32_t aIndex) -> uint32_t {
+			Node[aIndex].Dirty = 0;
+			uint32_t Parent = Node[aIndex].Parent;
+			if (Parent == None) return None;
+			node& P = Node[Parent];
+			std::size_t Slot = 0;
+			while (P.Child[Slot] != aIndex) Slot++;
+			this->set_child(P, Slot, this->node_bounds(aIndex));
+			if (P.Dirty) return None;
+			P.Dirty = 1;
+			return Parent;
+		};
+		if (Moved.size() * 16 > Node.size()) {
+			for (uint32_t i = (uint32_t)Node.size(); i-- > 0;) if (Node[i].Dirty) refit_node(i);
+			Moved.clear();
+			return;
+		}
+		std::make_heap(Moved.begin(), Moved.end());
+		while (!Moved.empty()) {
+			std::pop_heap(Moved.begin(), Moved.end());
+			uint32_t Index = Moved.back();
+			Moved.pop_back();
+			uint32_t Parent = refit_node(Index);
+			if (Parent == None) continue;
+			Moved.push_back(Parent);
+			std::push_heap(Moved.begin(), Moved.end());
+		}
+	}
+
+	inline void scene_bvh::set_child(node& aNode, std::size_t aSlot, const aabb& aBox) {
+		for (std::size_t k = 0; k < 3; k++) {
+			aNode.Min[k][aSlot] = aBox.Min[k];
+			aNode.Max[k][aSlot] = aBox.Max[k];
+		}
+	}
+
+	inline aabb scene_bvh::node_bounds(uint32_t aNode) const {
+		const node& N = Node[aNode];
+		aabb Box{ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+		for (std::size_t c = 0; c < Width; c++) {
+			if (N.Child[c] == None) continue;
+			for (std::size_t k = 0; k < 3; k++) {
+				Box.Min[k] = std::min(Box.Min[k], N.Min[k][c]);
+				Box.Max[k] = std::max(Box.Max[k], N.Max[k][c]);
+			}
+		}
+		return Box;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_SCENE_BVH_H
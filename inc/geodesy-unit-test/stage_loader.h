@@ -0,0 +1,188 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_STAGE_LOADER_H
+#define GEODESY_UNIT_TEST_STAGE_LOADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+#include <geodesy-unit-test/world_snapshot.h>
+#include <geodesy-unit-test/job_system.h>
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy::io {
+
+	// Timings of one stage build, all in milliseconds from the start of the build.
+	struct load_report {
+		struct entry {
+			std::string 	Name;
+			std::size_t 	Thread; 			// Thread that ran the load, 0 is the calling thread.
+			double 			LoadStart;
+			double 			LoadEnd;
+			double 			FinalizeStart;
+			double 			FinalizeEnd;
+		};
+
+		std::vector<entry> 	Entry;
+		double 				Total;
+
+		// Sum of load times, what a serial build would spend loading.
+		double load_sum() const;
+		double slowest_load() const;
+		std::string to_string() const;
+	};
+
+	// Builds the objects of a stage in two phases. aLoad does the CPU side work (file I/O,
+	// glTF parsing, image decoding), aFinalize does the GPU handoff and always runs on the
+	// calling thread, in list order. Without a job_system both run serially. Given one, each
+	// load is a task and the calling thread, which works as one of the job workers, finalizes
+	// every object whose load is done between its own loads, so uploads overlap with loads
+	// still in flight. aLoad must then be safe to call concurrently. The first exception
+	// from either phase is rethrown once all loads stopped.
+	template <typename T>
+	std::vector<T> build_objects(
+		const std::vector<object_description>& aObject,
+		const std::function<T(const object_description&)>& aLoad,
+		const std::function<void(std::size_t, T&)>& aFinalize,
+		load_report* aReport = nullptr,
+		job_system* aJobs = nullptr
+	);
+
+	// ---------- load_report ---------- //
+
+	inline double load_report::load_sum() const {
+		double Sum = 0.0;
+		for (const entry& E : Entry) Sum += E.LoadEnd - E.LoadStart;
+		return Sum;
+	}
+
+	inline double load_report::slowest_load() const {
+		double Slowest = 0.0;
+		for (const entry& E : Entry) Slowest = std::max(Slowest, E.LoadEnd - E.LoadStart);
+		return Slowest;
+	}
+
+	inline std::string load_report::to_string() const {
+		std::stringstream Stream;
+		Stream << std::fixed << std::setprecision(3);
+		for (const entry& E : Entry) {
+			Stream << "[load] " << std::setw(28) << std::left << E.Name << std::right
+				   << " thread " << std::setw(2) << E.Thread
+				   << "  load " << std::setw(10) << E.LoadEnd - E.LoadStart << " ms"
+				   << "  finalize " << std::setw(10) << E.FinalizeEnd - E.FinalizeStart << " ms\n";
+		}
+		Stream << "[load] total " << Total << " ms, slowest " << this->slowest_load() << " ms, serial sum " << this->load_sum() << " ms\n";
+		return Stream.str();
+	}
+
+	// ---------- build_objects ---------- //
+
+	template <typename T>
+	inline std::vector<T> build_objects(
+		const std::vector<object_description>& aObject,
+		const std::function<T(const object_description&)>& aLoad,
+		const std::function<void(std::size_t, T&)>& aFinalize,
+		load_report* aReport,
+		job_system* aJobs
+	) {
+		using clock = std::chrono::steady_clock;
+		clock::time_point Start = clock::now();
+		auto now = [&]() { return std::chrono::duration<double, std::milli>(clock::now() - Start).count(); };
+
+		std::size_t Count = aObject.size();
+		std::vector<T> Result(Count);
+		std::vector<load_report::entry> Entry(Count);
+		std::vector<uint8_t> Ready(Count, 0);
+		std::thread::id Caller = std::this_thread::get_id();
+		std::vector<std::thread::id> Thread{ Caller };
+		std::mutex Mutex;
+		std::exception_ptr Error;
+		std::atomic<bool> Cancel{ false };
+
+		auto load = [&](std::size_t i) {
+			{
+				// Threads are numbered in the order they first load something.
+				std::lock_guard<std::mutex> Lock(Mutex);
+				std::size_t t = std::find(Thread.begin(), Thread.end(), std::this_thread::get_id()) - Thread.begin();
+				if (t == Thread.size()) Thread.push_back(std::this_thread::get_id());
+				Entry[i].Thread = t;
+			}
+			Entry[i].Name = aObject[i].Name;
+			Entry[i].LoadStart = now();
+			if (!Cancel) {
+				try {
+					GEODESY_PROFILE_SCOPE("asset", "load", profiler::instance().intern(aObject[i].Name));
+					Result[i] = aLoad(aObject[i]);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> Lock(Mutex);
+					if (!Error) Error = std::current_exception();
+					Cancel = true;
+				}
+			}
+			Entry[i].LoadEnd = now();
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Ready[i] = 1;
+		};
+
+		// Finalizes in list order up to the first object still loading, stage object order
+		// is significant. Only the calling thread runs this.
+		std::size_t Finalized = 0;
+		auto finalize_ready = [&]() {
+			for (; (Finalized < Count) && !Cancel; Finalized++) {
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					if (Ready[Finalized] == 0) return;
+				}
+				std::size_t i = Finalized;
+				Entry[i].FinalizeStart = now();
+				try {
+					GEODESY_PROFILE_SCOPE("asset", "finalize", profiler::instance().intern(aObject[i].Name));
+					aFinalize(i, Result[i]);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> Lock(Mutex);
+					if (!Error) Error = std::current_exception();
+					Cancel = true;
+				}
+				Entry[i].FinalizeEnd = now();
+			}
+		};
+
+		if (aJobs == nullptr) {
+			for (std::size_t i = 0; i < Count; i++) {
+				load(i);
+				finalize_ready();
+			}
+		}
+		else {
+			// One object per chunk, workers take the next unstarted object so the largest
+			// assets do not hold up a fixed share.
+			aJobs->parallel_for(Count, 1, [&](std::size_t aBegin, std::size_t aEnd) {
+				for (std::size_t i = aBegin; i < aEnd; i++) load(i);
+				if (std::this_thread::get_id() == Caller) finalize_ready();
+			});
+			finalize_ready();
+		}
+
+		if (aReport != nullptr) {
+			aReport->Entry = Entry;
+			aReport->Total = now();
+		}
+		if (Error) std::rethrow_exception(Error);
+		return Result;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_STAGE_LOADER_H
@@ -0,0 +1,325 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_TEST_H
+#define GEODESY_UNIT_TEST_TEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+#include <geodesy-unit-test/allocation.h>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace geodesy {
+
+	// Test registry and runner. Suites register their cases on construction of a static
+	// suite object, the same way benchmark suites do, so a new test file only needs to
+	// be added to src/. Cases run in parallel on a pool of worker threads and report
+	// wall time and the heap allocations made on the case's own thread (see
+	// result::Allocations).
+	class test {
+	public:
+
+		// Passed to every case, records named checks.
+		class context {
+		public:
+			uint32_t 					CheckCount = 0;
+			std::vector<std::string> 	Failure;
+			// Records one check, a failed check fails the case but the case keeps running.
+			void check(const std::string& aName, bool aResult);
+		};
+
+		struct result {
+			std::string 				Suite;
+			std::string 				Name;
+			bool 						Passed;
+			uint32_t 					CheckCount;
+			// Names of failed checks, or the message of an exception that escaped the case.
+			std::vector<std::string> 	Failure;
+			double 						Milliseconds;
+			// Heap allocations made on the thread that ran the case. Cases run side by side,
+			// so the global count cannot be split between them, and allocations made for the
+			// case on other threads, such as job_system workers running its tasks, are not
+			// counted. Treat it as a lower bound for cases that fan out.
+			uint64_t 					Allocations;
+			std::string id() const;
+		};
+
+		struct options {
+			std::string 	Filter; 			// Substring filter on case id, empty runs all.
+			std::size_t 	ThreadCount = 0; 	// Worker threads, 0 uses hardware concurrency.
+		};
+
+		// Empty temporary directory for one case, named after aName and the process id so
+		// neither concurrent cases nor concurrent test binaries share files. It is removed
+		// with its contents when the object goes out of scope, also when the case throws.
+		class scratch {
+		public:
+			explicit scratch(const std::string& aName);
+			~scratch();
+			scratch(const scratch&) = delete;
+			scratch& operator=(const scratch&) = delete;
+			const std::filesystem::path& path() const { return Path; }
+		private:
+			std::filesystem::path Path;
+		};
+
+		struct suite {
+			std::string Name;
+			std::function<void(test&)> Register;
+			suite(std::string aName, std::function<void(test&)> aRegister);
+		};
+
+		static std::vector<suite*>& suite_list();
+
+		options Options;
+
+		// Registers the cases of every suite in suite_list().
+		void register_all();
+		// Adds a case to the suite currently being registered.
+		void add(std::string aName, std::function<void(context&)> aFunction);
+
+		// Runs all cases matching Options.Filter. Results and log lines are in registration order.
+		std::vector<result> run(std::ostream* aLog = nullptr);
+
+		static std::string to_json(const std::vector<result>& aResults);
+		static std::string to_junit(const std::vector<result>& aResults);
+
+	private:
+
+		struct entry {
+			std::string Suite;
+			std::string Name;
+			std::function<void(context&)> Function;
+		};
+
+		std::string 		CurrentSuite;
+		std::vector<entry> 	Entry;
+
+		static std::string escape(const std::string& aText, bool aXML);
+
+	};
+
+	inline void test::context::check(const std::string& aName, bool aResult) {
+		CheckCount++;
+		if (!aResult) Failure.push_back(aName);
+	}
+
+	inline std::string test::result::id() const {
+		return Suite + "/" + Name;
+	}
+
+	inline test::scratch::scratch(const std::string& aName) {
+#if defined(_WIN32)
+		long Process = (long)_getpid();
+#else
+		long Process = (long)getpid();
+#endif
+		Path = std::filesystem::temp_directory_path() / ("geodesy-" + aName + "-" + std::to_string(Process));
+		std::error_code Error;
+		std::filesystem::remove_all(Path, Error);
+		std::filesystem::create_directories(Path);
+	}
+
+	inline test::scratch::~scratch() {
+		std::error_code Error;
+		std::filesystem::remove_all(Path, Error);
+	}
+
+	inline test::suite::suite(std::string aName, std::function<void(test&)> aRegister) {
+		this->Name = aName;
+		this->Register = aRegister;
+		suite_list().push_back(this);
+	}
+
+	inline std::vector<test::suite*>& test::suite_list() {
+		static std::vector<suite*> SuiteList;
+		return SuiteList;
+	}
+
+	inline void test::register_all() {
+		for (suite* Suite : suite_list()) {
+			CurrentSuite = Suite->Name;
+			Suite->Register(*this);
+		}
+		CurrentSuite.clear();
+	}
+
+	inline void test::add(std::string aName, std::function<void(context&)> aFunction) {
+		Entry.push_back({ CurrentSuite, aName, aFunction });
+	}
+
+	inline std::vector<test::result> test::run(std::ostream* aLog) {
+		using clock = std::chrono::steady_clock;
+		std::vector<const entry*> Selected;
+		for (const entry& E : Entry) {
+			if ((Options.Filter.size() > 0) && ((E.Suite + "/" + E.Name).find(Options.Filter) == std::string::npos)) continue;
+			Selected.push_back(&E);
+		}
+
+		// Workers take the next unstarted case, so long cases do not hold up a fixed share.
+		std::vector<result> ResultList(Selected.size());
+		std::atomic<std::size_t> Next{ 0 };
+		auto worker = [&]() {
+			for (std::size_t i = Next.fetch_add(1); i < Selected.size(); i = Next.fetch_add(1)) {
+				const entry& E = *Selected[i];
+				result& R = ResultList[i];
+				context Context;
+				uint64_t AllocationStart = allocation::Thread;
+				clock::time_point Start = clock::now();
+				try {
+					E.Function(Context);
+				}
+				catch (const std::exception& aException) {
+					Context.Failure.push_back(std::string("exception: ") + aException.what());
+				}
+				catch (...) {
+					Context.Failure.push_back("exception: unknown");
+				}
+				R.Milliseconds 	= std::chrono::duration<double, std::milli>(clock::now() - Start).count();
+				R.Allocations 	= allocation::Thread - AllocationStart;
+				R.Suite 		= E.Suite;
+				R.Name 			= E.Name;
+				R.CheckCount 	= Context.CheckCount;
+				R.Failure 		= Context.Failure;
+				R.Passed 		= Context.Failure.empty();
+			}
+		};
+		std::size_t ThreadCount = Options.ThreadCount > 0 ? Options.ThreadCount : std::max(1u, std::thread::hardware_concurrency());
+		ThreadCount = std::min(ThreadCount, std::max<std::size_t>(1, Selected.size()));
+		std::vector<std::thread> Worker;
+		for (std::size_t t = 1; t < ThreadCount; t++) Worker.emplace_back(worker);
+		worker();
+		for (std::thread& Thread : Worker) Thread.join();
+
+		if (aLog != nullptr) {
+			for (const result& R : ResultList) {
+				*aLog << std::setw(40) << std::left << R.id() << (R.Passed ? "PASSED" : "FAILED")
+					  << std::setw(6) << std::right << R.CheckCount << " checks"
+					  << std::setw(12) << std::fixed << std::setprecision(3) << R.Milliseconds << " ms"
+					  << std::setw(10) << R.Allocations << " allocs" << std::endl;
+				for (const std::string& Failure : R.Failure) *aLog << "    FAILED: " << Failure << std::endl;
+			}
+		}
+		return ResultList;
+	}
+
+	inline std::string test::escape(const std::string& aText, bool aXML) {
+		// Failure and exception messages may span lines, control characters are written as
+		// character references (XML) or escapes (JSON). XML 1.0 cannot hold the other
+		// control characters at all, they become '?'.
+		std::string Escaped;
+		for (char Character : aText) {
+			if (aXML) {
+				switch (Character) {
+				case '&': Escaped += "&amp;"; break;
+				case '<': Escaped += "&lt;"; break;
+				case '>': Escaped += "&gt;"; break;
+				case '"': Escaped += "&quot;"; break;
+				case '\n': Escaped += "&#10;"; break;
+				case '\r': Escaped += "&#13;"; break;
+				case '\t': Escaped += "&#9;"; break;
+				default: Escaped += (unsigned char)Character < 0x20 ? '?' : Character; break;
+				}
+			}
+			else {
+				switch (Character) {
+				case '"': Escaped += "\\\""; break;
+				case '\\': Escaped += "\\\\"; break;
+				case '\n': Escaped += "\\n"; break;
+				case '\r': Escaped += "\\r"; break;
+				case '\t': Escaped += "\\t"; break;
+				default:
+					if ((unsigned char)Character < 0x20) {
+						char Code[8];
+						std::snprintf(Code, sizeof(Code), "\\u%04x", (unsigned)(unsigned char)Character);
+						Escaped += Code;
+					}
+					else {
+						Escaped += Character;
+					}
+				}
+			}
+		}
+		return Escaped;
+	}
+
+	inline std::string test::to_json(const std::vector<result>& aResults) {
+		std::stringstream Stream;
+		Stream << std::setprecision(6);
+		Stream << "{\n  \"results\": [\n";
+		for (std::size_t i = 0; i < aResults.size(); i++) {
+			const result& R = aResults[i];
+			Stream << "    { "
+				   << "\"id\": \"" << escape(R.id(), false) << "\", "
+				   << "\"suite\": \"" << escape(R.Suite, false) << "\", "
+				   << "\"name\": \"" << escape(R.Name, false) << "\", "
+				   << "\"passed\": " << (R.Passed ? "true" : "false") << ", "
+				   << "\"checks\": " << R.CheckCount << ", "
+				   << "\"ms\": " << R.Milliseconds << ", "
+				   << "\"allocations\": " << R.Allocations << ", "
+				   << "\"failures\": [";
+			for (std::size_t f = 0; f < R.Failure.size(); f++) Stream << (f > 0 ? ", " : "") << "\"" << escape(R.Failure[f], false) << "\"";
+			Stream << "] }" << (i + 1 < aResults.size() ? "," : "") << "\n";
+		}
+		Stream << "  ]\n}\n";
+		return Stream.str();
+	}
+
+	inline std::string test::to_junit(const std::vector<result>& aResults) {
+		// One <testsuite> per suite, in order of first appearance.
+		std::vector<std::string> SuiteName;
+		for (const result& R : aResults) {
+			if (std::find(SuiteName.begin(), SuiteName.end(), R.Suite) == SuiteName.end()) SuiteName.push_back(R.Suite);
+		}
+		std::stringstream Stream;
+		Stream << std::fixed << std::setprecision(6);
+		Stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n";
+		for (const std::string& Name : SuiteName) {
+			std::size_t Count = 0, FailureCount = 0;
+			double Seconds = 0.0;
+			for (const result& R : aResults) {
+				if (R.Suite != Name) continue;
+				Count++;
+				FailureCount += R.Passed ? 0 : 1;
+				Seconds += R.Milliseconds / 1000.0;
+			}
+			Stream << "  <testsuite name=\"" << escape(Name, true) << "\" tests=\"" << Count << "\" failures=\"" << FailureCount << "\" time=\"" << Seconds << "\">\n";
+			for (const result& R : aResults) {
+				if (R.Suite != Name) continue;
+				Stream << "    <testcase classname=\"" << escape(R.Suite, true) << "\" name=\"" << escape(R.Name, true) << "\" time=\"" << R.Milliseconds / 1000.0 << "\"";
+				if (R.Passed) {
+					Stream << "/>\n";
+					continue;
+				}
+				Stream << ">\n";
+				for (const std::string& Failure : R.Failure) Stream << "      <failure message=\"" << escape(Failure, true) << "\"/>\n";
+				Stream << "    </testcase>\n";
+			}
+			Stream << "  </testsuite>\n";
+		}
+		Stream << "</testsuites>\n";
+		return Stream.str();
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_TEST_H
@@ -0,0 +1,480 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_TEXTURE_CACHE_H
+#define GEODESY_UNIT_TEST_TEXTURE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <functional>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <type_traits>
+
+#include <geodesy-unit-test/mapped_file.h>
+#include <geodesy-unit-test/cache_file.h>
+#include <geodesy-unit-test/job_system.h>
+#include <geodesy-unit-test/profiler.h>
+#include <geodesy-unit-test/png.h>
+#include <geodesy-unit-test/jpeg.h>
+
+namespace geodesy::io {
+
+	// Decodes a PNG or JPEG by signature.
+	inline image decode_image(const uint8_t* aData, std::size_t aSize) {
+		if (is_png(aData, aSize)) return decode_png(aData, aSize);
+		if (is_jpeg(aData, aSize)) return decode_jpeg(aData, aSize);
+		throw std::runtime_error("image: unrecognised format");
+	}
+
+	// RGBA8 texture with its mip chain, level 0 first, levels tightly packed. Pixels live
+	// either in the texture's own storage (freshly decoded) or in a read-only mapping of
+	// the cache file they were loaded from.
+	class texture {
+	public:
+
+		struct level {
+			uint32_t 	Width;
+			uint32_t 	Height;
+			uint64_t 	Offset; 			// From the start of level 0, in bytes.
+		};
+
+		uint32_t 				Width;
+		uint32_t 				Height;
+		bool 					Srgb;
+		std::vector<level> 		Level;
+
+		texture();
+
+		// Takes the pixels of aImage as level 0 and, with aMipmaps, box filters the rest of
+		// the chain down to 1x1. sRGB textures are filtered in linear space.
+		static texture from_image(image&& aImage, bool aMipmaps, bool aSrgb);
+
+		const uint8_t* data(std::size_t aLevel = 0) const;
+		// Bytes of the whole chain.
+		std::size_t byte_size() const;
+		bool is_mapped() const;
+
+	private:
+
+		friend class texture_cache;
+
+		std::vector<uint8_t> 	Storage;
+		mapped_file 			File;
+		std::size_t 			FileOffset;
+
+	};
+
+	// Per texture timings of a texture_cache load, in milliseconds. Hit marks a warm load
+	// served from the cache, a cold load decodes, builds mips and stores the result.
+	struct texture_report {
+		struct entry {
+			std::string 	Path;
+			bool 			Hit;
+			bool 			Stored; 			// Cold load whose result was written to the cache.
+			double 			Read; 				// Mapping and hashing the source.
+			double 			Decode;
+			double 			Mipmap;
+			double 			Cache; 				// Mapping a hit, or writing a miss.
+			double 			Total;
+		};
+
+		std::vector<entry> 	Entry;
+		double 				Total;
+
+		std::size_t hit_count() const;
+		std::string to_string() const;
+	};
+
+	struct texture_options {
+		bool 	Mipmaps 	= true;
+		bool 	Srgb 		= true; 			// Color data, false for normal, height and data maps.
+	};
+
+	// Content addressed on-disk cache of decoded textures. The key hashes the source file's
+	// bytes with the decode options and cache version, so an edited, renamed or copied
+	// source resolves correctly without timestamps. Entries are raw RGBA8 mip chains:
+	//
+	//	header | level_record[LevelCount] | pixels of every level (from a 16 byte aligned DataOffset)
+	//
+	// A warm load maps the entry and skips decoding and mip generation. Entries that fail
+	// validation are ignored and rewritten, the cache never makes a load fail.
+	class texture_cache {
+	public:
+
+		static constexpr uint32_t Version = 1;
+		static constexpr char Magic[8] = { 'G', 'E', 'O', 'T', 'E', 'X', '\0', '\0' };
+
+		struct source {
+			std::string 	Path;
+			texture_options Options;
+		};
+
+		struct header {
+			char 		Magic[8];
+			uint32_t 	Version;
+			uint32_t 	ByteOrder; 				// 0x01020304 as written by the storing host.
+			uint64_t 	Key;
+			uint32_t 	Width;
+			uint32_t 	Height;
+			uint32_t 	LevelCount;
+			uint32_t 	Srgb;
+			uint64_t 	DataOffset;
+			uint64_t 	DataSize;
+		};
+
+		struct level_record {
+			uint32_t 	Width;
+			uint32_t 	Height;
+			uint64_t 	Offset;
+		};
+
+		// Entries are kept in aDirectory, created on first store.
+		texture_cache(const std::string& aDirectory);
+
+		// Loads one texture, from the cache when an entry for its content exists.
+		texture load(const std::string& aPath, const texture_options& aOptions = texture_options(), texture_report::entry* aEntry = nullptr) const;
+		// Loads every source, results in list order. Given a job_system each texture is a
+		// task, otherwise they load serially. The first error is rethrown once all loads
+		// stopped.
+		std::vector<texture> load_all(const std::vector<source>& aSource, texture_report* aReport = nullptr, job_system* aJobs = nullptr) const;
+
+		static uint64_t key(const uint8_t* aData, std::size_t aSize, const texture_options& aOptions);
+		std::string path_for(uint64_t aKey) const;
+
+	private:
+
+		std::filesystem::path 	Directory;
+
+		bool read(const std::string& aPath, uint64_t aKey, texture& aTexture) const;
+		bool store(const std::string& aPath, uint64_t aKey, const texture& aTexture) const;
+
+	};
+
+	static_assert(std::is_trivially_copyable_v<texture_cache::header> && (sizeof(texture_cache::header) % 8 == 0), "Texture cache header must be a packed POD.");
+	static_assert(std::is_trivially_copyable_v<texture_cache::level_record> && (sizeof(texture_cache::level_record) % 8 == 0), "Texture cache level record must be a packed POD.");
+
+	namespace detail {
+
+		// XXH64, fast enough to hash every source on every load.
+		inline uint64_t hash64(const uint8_t* aData, std::size_t aSize, uint64_t aSeed) {
+			constexpr uint64_t P1 = 0x9E3779B185EBCA87ull, P2 = 0xC2B2AE3D27D4EB4Full, P3 = 0x165667B19E3779F9ull, P4 = 0x85EBCA77C2B2AE63ull, P5 = 0x27D4EB2F165667C5ull;
+			auto rotl = [](uint64_t aX, int aR) { return (aX << aR) | (aX >> (64 - aR)); };
+			auto read64 = [](const uint8_t* aP) { uint64_t V; std::memcpy(&V, aP, 8); return V; };
+			auto read32 = [](const uint8_t* aP) { uint32_t V; std::memcpy(&V, aP, 4); return (uint64_t)V; };
+			auto mix = [&](uint64_t aAcc, uint64_t aInput) { return rotl(aAcc + aInput * P2, 31) * P1; };
+			auto merge = [&](uint64_t aAcc, uint64_t aValue) { return (aAcc ^ mix(0, aValue)) * P1 + P4; };
+
+			const uint8_t* P = aData;
+			const uint8_t* End = aData + aSize;
+			uint64_t H;
+			if (aSize >= 32) {
+				uint64_t V1 = aSeed + P1 + P2, V2 = aSeed + P2, V3 = aSeed, V4 = aSeed - P1;
+				for (; P + 32 <= End; P += 32) {
+					V1 = mix(V1, read64(P));
+					V2 = mix(V2, read64(P + 8));
+					V3 = mix(V3, read64(P + 16));
+					V4 = mix(V4, read64(P + 24));
+				}
+				H = rotl(V1, 1) + rotl(V2, 7) + rotl(V3, 12) + rotl(V4, 18);
+				H = merge(H, V1); H = merge(H, V2); H = merge(H, V3); H = merge(H, V4);
+			}
+			else {
+				H = aSeed + P5;
+			}
+			H += (uint64_t)aSize;
+			for (; P + 8 <= End; P += 8) H = rotl(H ^ mix(0, read64(P)), 27) * P1 + P4;
+			if (P + 4 <= End) { H = rotl(H ^ (read32(P) * P1), 23) * P2 + P3; P += 4; }
+			for (; P < End; P++) H = rotl(H ^ (*P * P5), 11) * P1;
+			H ^= H >> 33; H *= P2;
+			H ^= H >> 29; H *= P3;
+			H ^= H >> 32;
+			return H;
+		}
+
+		// sRGB <-> linear lookups for mip filtering, 8 bit in and 12 bit linear back out.
+		struct srgb_table {
+			float 		ToLinear[256];
+			uint8_t 	FromLinear[4096];
+			srgb_table() {
+				for (std::size_t i = 0; i < 256; i++) {
+					double C = i / 255.0;
+					ToLinear[i] = (float)(C <= 0.04045 ? C / 12.92 : std::pow((C + 0.055) / 1.055, 2.4));
+				}
+				for (std::size_t i = 0; i < 4096; i++) {
+					double L = i / 4095.0;
+					double C = L <= 0.0031308 ? L * 12.92 : 1.055 * std::pow(L, 1.0 / 2.4) - 0.055;
+					FromLinear[i] = (uint8_t)std::lround(std::clamp(C, 0.0, 1.0) * 255.0);
+				}
+			}
+		};
+
+		inline const srgb_table& srgb() {
+			static const srgb_table Table;
+			return Table;
+		}
+
+		// Halves aSource with a 2x2 box, odd edges reuse the last row or column.
+		inline void downsample(const uint8_t* aSource, uint32_t aWidth, uint32_t aHeight, uint8_t* aTarget, uint32_t aTargetWidth, uint32_t aTargetHeight, bool aSrgb) {
+			const srgb_table& Table = srgb();
+			for (uint32_t y = 0; y < aTargetHeight; y++) {
+				const uint8_t* Row0 = aSource + (std::size_t)std::min(2 * y, aHeight - 1) * aWidth * 4;
+				const uint8_t* Row1 = aSource + (std::size_t)std::min(2 * y + 1, aHeight - 1) * aWidth * 4;
+				uint8_t* Out = aTarget + (std::size_t)y * aTargetWidth * 4;
+				for (uint32_t x = 0; x < aTargetWidth; x++, Out += 4) {
+					std::size_t X0 = (std::size_t)std::min(2 * x, aWidth - 1) * 4;
+					std::size_t X1 = (std::size_t)std::min(2 * x + 1, aWidth - 1) * 4;
+					if (aSrgb) {
+						for (std::size_t c = 0; c < 3; c++) {
+							float L = Table.ToLinear[Row0[X0 + c]] + Table.ToLinear[Row0[X1 + c]] + Table.ToLinear[Row1[X0 + c]] + Table.ToLinear[Row1[X1 + c]];
+							Out[c] = Table.FromLinear[(std::size_t)(L * (4095.0f / 4.0f) + 0.5f)];
+						}
+					}
+					else {
+						for (std::size_t c = 0; c < 3; c++) Out[c] = (uint8_t)((Row0[X0 + c] + Row0[X1 + c] + Row1[X0 + c] + Row1[X1 + c] + 2) >> 2);
+					}
+					Out[3] = (uint8_t)((Row0[X0 + 3] + Row0[X1 + 3] + Row1[X0 + 3] + Row1[X1 + 3] + 2) >> 2);
+				}
+			}
+		}
+
+	}
+
+	// ---------- texture ---------- //
+
+	inline texture::texture() {
+		Width = 0;
+		Height = 0;
+		Srgb = false;
+		FileOffset = 0;
+	}
+
+	inline texture texture::from_image(image&& aImage, bool aMipmaps, bool aSrgb) {
+		texture Texture;
+		Texture.Width = aImage.Width;
+		Texture.Height = aImage.Height;
+		Texture.Srgb = aSrgb;
+		uint64_t Offset = 0;
+		for (uint32_t W = aImage.Width, H = aImage.Height; ; W = std::max(1u, W / 2), H = std::max(1u, H / 2)) {
+			Texture.Level.push_back({ W, H, Offset });
+			Offset += (uint64_t)W * H * 4;
+			if (!aMipmaps || ((W == 1) && (H == 1))) break;
+		}
+		Texture.Storage = std::move(aImage.Pixel);
+		Texture.Storage.resize((std::size_t)Offset);
+		for (std::size_t i = 1; i < Texture.Level.size(); i++) {
+			const level& Source = Texture.Level[i - 1];
+			const level& Target = Texture.Level[i];
+			detail::downsample(Texture.Storage.data() + Source.Offset, Source.Width, Source.Height, Texture.Storage.data() + Target.Offset, Target.Width, Target.Height, aSrgb);
+		}
+		return Texture;
+	}
+
+	inline const uint8_t* texture::data(std::size_t aLevel) const {
+		const uint8_t* Base = Storage.empty() ? File.data() + FileOffset : Storage.data();
+		return Base + Level[aLevel].Offset;
+	}
+
+	inline std::size_t texture::byte_size() const {
+		if (Level.empty()) return 0;
+		const level& Last = Level.back();
+		return (std::size_t)(Last.Offset + (uint64_t)Last.Width * Last.Height * 4);
+	}
+
+	inline bool texture::is_mapped() const {
+		return Storage.empty() && File.is_open();
+	}
+
+	// ---------- texture_report ---------- //
+
+	inline std::size_t texture_report::hit_count() const {
+		std::size_t Count = 0;
+		for (const entry& E : Entry) Count += E.Hit ? 1 : 0;
+		return Count;
+	}
+
+	inline std::string texture_report::to_string() const {
+		std::stringstream Stream;
+		Stream << std::fixed << std::setprecision(3);
+		for (const entry& E : Entry) {
+			Stream << "[texture] " << std::setw(44) << std::left << E.Path << std::right
+				   << (E.Hit ? " warm" : " cold")
+				   << "  read " << std::setw(8) << E.Read
+				   << "  decode " << std::setw(8) << E.Decode
+				   << "  mip " << std::setw(8) << E.Mipmap
+				   << "  cache " << std::setw(8) << E.Cache
+				   << "  total " << std::setw(8) << E.Total << " ms\n";
+		}
+		Stream << "[texture] total " << Total << " ms, " << this->hit_count() << "/" << Entry.size() << " from cache\n";
+		return Stream.str();
+	}
+
+	// ---------- texture_cache ---------- //
+
+	inline texture_cache::texture_cache(const std::string& aDirectory) {
+		Directory = aDirectory;
+	}
+
+	inline uint64_t texture_cache::key(const uint8_t* aData, std::size_t aSize, const texture_options& aOptions) {
+		uint64_t Seed = ((uint64_t)Version << 32) | (aOptions.Mipmaps ? 1u : 0u) | (aOptions.Srgb ? 2u : 0u);
+		return detail::hash64(aData, aSize, Seed);
+	}
+
+	inline std::string texture_cache::path_for(uint64_t aKey) const {
+		std::stringstream Name;
+		Name << std::hex << std::setw(16) << std::setfill('0') << aKey << ".tex";
+		return (Directory / Name.str()).string();
+	}
+
+	inline texture texture_cache::load(const std::string& aPath, const texture_options& aOptions, texture_report::entry* aEntry) const {
+		using clock = std::chrono::steady_clock;
+		clock::time_point Start = clock::now();
+		clock::time_point Mark = Start;
+		auto lap = [&]() {
+			clock::time_point Now = clock::now();
+			double Elapsed = std::chrono::duration<double, std::milli>(Now - Mark).count();
+			Mark = Now;
+			return Elapsed;
+		};
+		texture_report::entry Entry{};
+		Entry.Path = aPath;
+		[[maybe_unused]] const char* Detail = profiler::instance().intern(aPath);
+		GEODESY_PROFILE_SCOPE("asset", "texture", Detail);
+
+		mapped_file Source(aPath);
+		if (!Source.is_open()) throw std::runtime_error("texture_cache: cannot open " + aPath);
+		uint64_t Key = key(Source.data(), Source.size(), aOptions);
+		std::string CachePath = this->path_for(Key);
+		Entry.Read = lap();
+
+		texture Texture;
+		Entry.Hit = this->read(CachePath, Key, Texture);
+		if (Entry.Hit) {
+			Entry.Cache = lap();
+		}
+		else {
+			image Image;
+			{
+				GEODESY_PROFILE_SCOPE("asset", "texture.decode", Detail);
+				Image = decode_image(Source.data(), Source.size());
+			}
+			Source.close();
+			Entry.Decode = lap();
+			{
+				GEODESY_PROFILE_SCOPE("asset", "texture.mipmap", Detail);
+				Texture = texture::from_image(std::move(Image), aOptions.Mipmaps, aOptions.Srgb);
+			}
+			Entry.Mipmap = lap();
+			Entry.Stored = this->store(CachePath, Key, Texture);
+			Entry.Cache = lap();
+		}
+		Entry.Total = std::chrono::duration<double, std::milli>(clock::now() - Start).count();
+		if (aEntry != nullptr) *aEntry = std::move(Entry);
+		return Texture;
+	}
+
+	inline std::vector<texture> texture_cache::load_all(const std::vector<source>& aSource, texture_report* aReport, job_system* aJobs) const {
+		using clock = std::chrono::steady_clock;
+		clock::time_point Start = clock::now();
+
+		std::size_t Count = aSource.size();
+		std::vector<texture> Result(Count);
+		std::vector<texture_report::entry> Entry(Count);
+		std::mutex Mutex;
+		std::exception_ptr Error;
+		std::atomic<bool> Cancel{ false };
+
+		auto load_range = [&](std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t i = aBegin; (i < aEnd) && !Cancel; i++) {
+				try {
+					Result[i] = this->load(aSource[i].Path, aSource[i].Options, &Entry[i]);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> Lock(Mutex);
+					if (!Error) Error = std::current_exception();
+					Cancel = true;
+				}
+			}
+		};
+
+		// One texture per chunk, workers take the next unstarted one so a large image does
+		// not hold up a fixed share.
+		if ((aJobs == nullptr) || (Count <= 1)) load_range(0, Count);
+		else aJobs->parallel_for(Count, 1, load_range);
+
+		if (aReport != nullptr) {
+			aReport->Entry = std::move(Entry);
+			aReport->Total = std::chrono::duration<double, std::milli>(clock::now() - Start).count();
+		}
+		if (Error) std::rethrow_exception(Error);
+		return Result;
+	}
+
+	inline bool texture_cache::read(const std::string& aPath, uint64_t aKey, texture& aTexture) const {
+		mapped_file File(aPath);
+		header Header;
+		if (!read_cache_header(File, Magic, Version, Header) || (Header.Key != aKey)) return false;
+		if ((Header.LevelCount == 0) || (Header.LevelCount > 32)) return false;
+		if ((uint64_t)sizeof(header) + (uint64_t)Header.LevelCount * sizeof(level_record) > Header.DataOffset) return false;
+		if ((Header.DataOffset > File.size()) || (Header.DataSize > File.size() - Header.DataOffset)) return false;
+
+		texture Texture;
+		Texture.Width = Header.Width;
+		Texture.Height = Header.Height;
+		Texture.Srgb = Header.Srgb != 0;
+		Texture.Level.resize(Header.LevelCount);
+		for (std::size_t i = 0; i < Texture.Level.size(); i++) {
+			level_record Record;
+			std::memcpy(&Record, File.data() + sizeof(header) + i * sizeof(level_record), sizeof(level_record));
+			uint64_t Bytes = (uint64_t)Record.Width * Record.Height * 4;
+			if ((Record.Offset > Header.DataSize) || (Bytes > Header.DataSize - Record.Offset)) return false;
+			Texture.Level[i] = { Record.Width, Record.Height, Record.Offset };
+		}
+		if ((Texture.Level[0].Width != Header.Width) || (Texture.Level[0].Height != Header.Height)) return false;
+		Texture.FileOffset = (std::size_t)Header.DataOffset;
+		Texture.File = std::move(File);
+		aTexture = std::move(Texture);
+		return true;
+	}
+
+	inline bool texture_cache::store(const std::string& aPath, uint64_t aKey, const texture& aTexture) const {
+		std::error_code Error;
+		std::filesystem::create_directories(Directory, Error);
+		if (Error) return false;
+
+		header Header = make_cache_header<header>(Magic, Version);
+		Header.Key 			= aKey;
+		Header.Width 		= aTexture.Width;
+		Header.Height 		= aTexture.Height;
+		Header.LevelCount 	= (uint32_t)aTexture.Level.size();
+		Header.Srgb 		= aTexture.Srgb ? 1 : 0;
+		Header.DataOffset 	= (sizeof(header) + aTexture.Level.size() * sizeof(level_record) + 15) & ~(uint64_t)15;
+		Header.DataSize 	= aTexture.byte_size();
+		std::vector<level_record> Record;
+		for (const texture::level& Level : aTexture.Level) Record.push_back({ Level.Width, Level.Height, Level.Offset });
+		static const char Padding[16] = {};
+		std::size_t PaddingSize = (std::size_t)Header.DataOffset - sizeof(header) - Record.size() * sizeof(level_record);
+
+		return write_cache_file(aPath, [&](std::ostream& aStream) {
+			aStream.write((const char*)&Header, sizeof(Header));
+			aStream.write((const char*)Record.data(), Record.size() * sizeof(level_record));
+			aStream.write(Padding, PaddingSize);
+			aStream.write((const char*)aTexture.data(), aTexture.byte_size());
+		});
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_TEXTURE_CACHE_H
@@ -0,0 +1,264 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_TRANSFORM_HIERARCHY_H
+#define GEODESY_UNIT_TEST_TRANSFORM_HIERARCHY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/gltf.h>
+#include <geodesy-unit-test/math_simd.h>
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy {
+
+	// World transforms of objects and their glTF node trees, kept as flat arrays sorted by
+	// depth so every parent precedes its children. Changing a local transform marks the
+	// node dirty and update() recomputes only dirty nodes and their descendants, walking
+	// the arrays once from the first dirty node. A frame where nothing moved costs nothing.
+	//
+	// Node ids are stable, the storage order is not: adding a node shallower than the
+	// deepest one defers a re-sort to the next update().
+	class transform_hierarchy {
+	public:
+
+		using id = uint32_t;
+		static constexpr id None = UINT32_MAX;
+
+		// aParent must be None or a node added before.
+		id add(const math::mat<float, 4, 4>& aLocal, id aParent = None);
+		void set_local(id aNode, const math::mat<float, 4, 4>& aLocal);
+		const math::mat<float, 4, 4>& local(id aNode) const;
+		// World transform as of the last update().
+		const math::mat<float, 4, 4>& world(id aNode) const;
+		id parent(id aNode) const;
+		std::size_t size() const;
+
+		// Recomputes dirty subtrees and returns the number of nodes updated.
+		std::size_t update();
+		// Nodes recomputed by the last update().
+		std::size_t updated_count() const;
+		void clear();
+
+	private:
+
+		// Indexed by storage slot.
+		std::vector<math::mat<float, 4, 4>> 	Local;
+		std::vector<math::mat<float, 4, 4>> 	World;
+		std::vector<uint32_t> 					Parent; 		// Slot of the parent, None for roots.
+		std::vector<uint32_t> 					Depth;
+		std::vector<uint8_t> 					Dirty;
+		std::vector<uint32_t> 					Stamp; 			// Update that last recomputed the slot.
+		std::vector<id> 						Id;
+		// Indexed by id.
+		std::vector<uint32_t> 					Slot;
+
+		std::size_t 	FirstDirty 		= 0;
+		bool 			Sorted 			= true;
+		uint32_t 		Frame 			= 0;
+		std::size_t 	UpdatedCount 	= 0;
+
+		void sort();
+
+	};
+
+	// Local transform of a world object: translation, yaw of Direction[0] degrees about z,
+	// pitch of Direction[1] degrees about x, then scale.
+	math::mat<float, 4, 4> object_transform(const math::vec<float, 3>& aPosition, const math::vec<float, 2>& aDirection, const math::vec<float, 3>& aScale);
+
+	// Adds the node trees of scene aScene (the default scene when none is given) below
+	// aParent. Returns the id of every glTF node, None for nodes outside the scene.
+	std::vector<transform_hierarchy::id> add_gltf_nodes(transform_hierarchy& aHierarchy, const io::gltf& aModel, transform_hierarchy::id aParent = transform_hierarchy::None, std::size_t aScene = SIZE_MAX);
+
+	// ---------- transform_hierarchy ---------- //
+
+	inline transform_hierarchy::id transform_hierarchy::add(const math::mat<float, 4, 4>& aLocal, id aParent) {
+		if ((aParent != None) && (aParent >= Slot.size())) throw std::invalid_argument("transform_hierarchy: parent " + std::to_string(aParent) + " does not exist");
+		id Node = (id)Slot.size();
+		uint32_t ParentSlot = aParent == None ? None : Slot[aParent];
+		uint32_t NodeDepth = aParent == None ? 0 : Depth[ParentSlot] + 1;
+		if (!Depth.empty() && (NodeDepth < Depth.back())) Sorted = false;
+		FirstDirty = std::min(FirstDirty, Local.size());
+		Slot.push_back((uint32_t)Local.size());
+		Local.push_back(aLocal);
+		World.push_back(aLocal);
+		Parent.push_back(ParentSlot);
+		Depth.push_back(NodeDepth);
+		Dirty.push_back(1);
+		Stamp.push_back(0);
+		Id.push_back(Node);
+		return Node;
+	}
+
+	inline void transform_hierarchy::set_local(id aNode, const math::mat<float, 4, 4>& aLocal) {
+		uint32_t S = Slot[aNode];
+		Local[S] = aLocal;
+		Dirty[S] = 1;
+		FirstDirty = std::min<std::size_t>(FirstDirty, S);
+	}
+
+	inline const math::mat<float, 4, 4>& transform_hierarchy::local(id aNode) const {
+		return Local[Slot[aNode]];
+	}
+
+	inline const math::mat<float, 4, 4>& transform_hierarchy::world(id aNode) const {
+		return World[Slot[aNode]];
+	}
+
+	inline transform_hierarchy::id transform_hierarchy::parent(id aNode) const {
+		uint32_t P = Parent[Slot[aNode]];
+		return P == None ? None : Id[P];
+	}
+
+	inline std::size_t transform_hierarchy::size() const {
+		return Slot.size();
+	}
+
+	inline std::size_t transform_hierarchy::update() {
+		GEODESY_PROFILE_SCOPE("transform", "update");
+		if (!Sorted) this->sort();
+		UpdatedCount = 0;
+		std::size_t Count = Local.size();
+		if (FirstDirty >= Count) return 0;
+		// A node is recomputed when it is dirty or its parent was recomputed in this pass.
+		if (++Frame == 0) {
+			std::fill(Stamp.begin(), Stamp.end(), 0);
+			Frame = 1;
+		}
+		for (std::size_t i = FirstDirty; i < Count; i++) {
+			uint32_t P = Parent[i];
+			if (P == None) {
+				if (!Dirty[i]) continue;
+				World[i] = Local[i];
+			}
+			else {
+				if (!Dirty[i] && (Stamp[P] != Frame)) continue;
+				World[i] = math::simd::mul(World[P], Local[i]);
+			}
+			Dirty[i] = 0;
+			Stamp[i] = Frame;
+			UpdatedCount++;
+		}
+		FirstDirty = Count;
+		return UpdatedCount;
+	}
+
+	inline std::size_t transform_hierarchy::updated_count() const {
+		return UpdatedCount;
+	}
+
+	inline void transform_hierarchy::clear() {
+		*this = transform_hierarchy();
+	}
+
+	inline void transform_hierarchy::sort() {
+		std::size_t Count = Local.size();
+		std::vector<uint32_t> Order(Count);
+		std::iota(Order.begin(), Order.end(), 0u);
+		std::stable_sort(Order.begin(), Order.end(), [&](uint32_t aA, uint32_t aB) { return Depth[aA] < Depth[aB]; });
+		std::vector<uint32_t> NewSlot(Count);
+		for (std::size_t i = 0; i < Count; i++) NewSlot[Order[i]] = (uint32_t)i;
+
+		auto permute = [&](auto& aArray) {
+			std::remove_reference_t<decltype(aArray)> Permuted(Count);
+			for (std::size_t i = 0; i < Count; i++) Permuted[i] = aArray[Order[i]];
+			aArray.swap(Permuted);
+		};
+		permute(Local);
+		permute(World);
+		permute(Parent);
+		permute(Depth);
+		permute(Dirty);
+		permute(Stamp);
+		permute(Id);
+		for (uint32_t& P : Parent) if (P != None) P = NewSlot[P];
+		for (std::size_t i = 0; i < Count; i++) Slot[Id[i]] = (uint32_t)i;
+		FirstDirty = (std::size_t)(std::find(Dirty.begin(), Dirty.end(), 1) - Dirty.begin());
+		Sorted = true;
+	}
+
+	// ---------- object_transform ---------- //
+
+	inline math::mat<float, 4, 4> object_transform(const math::vec<float, 3>& aPosition, const math::vec<float, 2>& aDirection, const math::vec<float, 3>& aScale) {
+		const float Radian = 3.14159265358979323846f / 180.0f;
+		float CY = std::cos(aDirection[0] * Radian), SY = std::sin(aDirection[0] * Radian);
+		float CP = std::cos(aDirection[1] * Radian), SP = std::sin(aDirection[1] * Radian);
+		return math::mat<float, 4, 4>(
+			CY * aScale[0], 	-SY * CP * aScale[1], 	SY * SP * aScale[2], 	aPosition[0],
+			SY * aScale[0], 	CY * CP * aScale[1], 	-CY * SP * aScale[2], 	aPosition[1],
+			0.0f, 				SP * aScale[1], 		CP * aScale[2], 		aPosition[2],
+			0.0f, 				0.0f, 					0.0f, 					1.0f
+		);
+	}
+
+	// ---------- add_gltf_nodes ---------- //
+
+	inline std::vector<transform_hierarchy::id> add_gltf_nodes(transform_hierarchy& aHierarchy, const io::gltf& aModel, transform_hierarchy::id aParent, std::size_t aScene) {
+		const io::json& NodeList = aModel.Document["nodes"];
+		std::size_t NodeCount = NodeList.size();
+		std::vector<transform_hierarchy::id> NodeId(NodeCount, transform_hierarchy::None);
+
+		// Roots of the scene, or every parentless node when the file has no scenes.
+		std::vector<std::size_t> Root;
+		const io::json& SceneList = aModel.Document["scenes"];
+		if (SceneList.size() > 0) {
+			std::size_t Scene = aScene != SIZE_MAX ? aScene : (std::size_t)aModel.Document["scene"].as_double(0.0);
+			if (Scene >= SceneList.size()) throw std::runtime_error("transform_hierarchy: scene " + std::to_string(Scene) + " not found");
+			for (std::size_t r = 0; r < SceneList[Scene]["nodes"].size(); r++) Root.push_back(SceneList[Scene]["nodes"][r].as_index());
+		}
+		else {
+			std::vector<uint8_t> IsChild(NodeCount, 0);
+			for (std::size_t n = 0; n < NodeCount; n++) {
+				for (std::size_t c = 0; c < NodeList[n]["children"].size(); c++) {
+					std::size_t Child = NodeList[n]["children"][c].as_index();
+					if (Child < NodeCount) IsChild[Child] = 1;
+				}
+			}
+			for (std::size_t n = 0; n < NodeCount; n++) if (!IsChild[n]) Root.push_back(n);
+		}
+
+		// Depth first, parents are added before their children.
+		std::vector<std::pair<std::size_t, transform_hierarchy::id>> Stack;
+		for (std::size_t r = Root.size(); r > 0; r--) Stack.push_back({ Root[r - 1], aParent });
+		while (!Stack.empty()) {
+			auto [Node, Parent] = Stack.back();
+			Stack.pop_back();
+			if (Node >= NodeCount) throw std::runtime_error("transform_hierarchy: missing node " + std::to_string(Node));
+			if (NodeId[Node] != transform_hierarchy::None) throw std::runtime_error("transform_hierarchy: node " + std::to_string(Node) + " is reached twice");
+			const io::json& N = NodeList[Node];
+			math::mat<float, 4, 4> Local;
+			if (N.has("matrix")) {
+				for (std::size_t i = 0; i < 16; i++) Local(i % 4, i / 4) = (float)N["matrix"][i].as_double(i % 5 == 0 ? 1.0 : 0.0);
+			}
+			else {
+				float T[3], R[4], S[3];
+				for (std::size_t i = 0; i < 3; i++) T[i] = (float)N["translation"][i].as_double(0.0);
+				for (std::size_t i = 0; i < 4; i++) R[i] = (float)N["rotation"][i].as_double(i == 3 ? 1.0 : 0.0);
+				for (std::size_t i = 0; i < 3; i++) S[i] = (float)N["scale"][i].as_double(1.0);
+				float X = R[0], Y = R[1], Z = R[2], W = R[3];
+				Local = math::mat<float, 4, 4>(
+					(1 - 2 * (Y * Y + Z * Z)) * S[0], 	2 * (X * Y - Z * W) * S[1], 		2 * (X * Z + Y * W) * S[2], 		T[0],
+					2 * (X * Y + Z * W) * S[0], 		(1 - 2 * (X * X + Z * Z)) * S[1], 	2 * (Y * Z - X * W) * S[2], 		T[1],
+					2 * (X * Z - Y * W) * S[0], 		2 * (Y * Z + X * W) * S[1], 		(1 - 2 * (X * X + Y * Y)) * S[2], 	T[2],
+					0.0f, 								0.0f, 								0.0f, 								1.0f
+				);
+			}
+			NodeId[Node] = aHierarchy.add(Local, Parent);
+			const io::json& Children = N["children"];
+			for (std::size_t c = Children.size(); c > 0; c--) Stack.push_back({ Children[c - 1].as_index(), NodeId[Node] });
+		}
+		return NodeId;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_TRANSFORM_HIERARCHY_H
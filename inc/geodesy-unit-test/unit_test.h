@@ -20,7 +20,11 @@ namespace geodesy {
 		unit_test(engine* aEngine);
 		~unit_test();
 
-		void math_test();
+		// Runs the registered CPU test suites (see test.h), needs no engine or device
+		// context. Reads --filter=, --threads=, --json= and --junit= from the command
+		// line. Returns true when every test passed, false after printing usage when an
+		// option's value is malformed.
+		static bool run_tests(const std::set<std::string>& aCommandLineArguments);
 		void create_worlds();
 
 	};
@@ -0,0 +1,327 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_VEC_ARRAY_H
+#define GEODESY_UNIT_TEST_VEC_ARRAY_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/math_simd.h>
+
+namespace geodesy::math {
+
+	// Structure-of-arrays container for N component vectors. Each component is stored
+	// in its own contiguous run of stride() elements, padded to a multiple of the widest
+	// SIMD lane count so batch kernels never need a scalar tail.
+	template <typename T, std::size_t N>
+	class vec_array {
+	public:
+
+		static constexpr std::size_t Padding = 8;
+
+		vec_array();
+		vec_array(std::size_t aCount);
+		vec_array(const std::vector<vec<T, N>>& aList);
+
+		std::size_t size() const;
+		std::size_t stride() const;
+		void resize(std::size_t aCount);
+
+		// Pointer to the first element of component aComponent.
+		T* component(std::size_t aComponent);
+		const T* component(std::size_t aComponent) const;
+
+		vec<T, N> get(std::size_t aIndex) const;
+		void set(std::size_t aIndex, const vec<T, N>& aValue);
+
+		std::vector<vec<T, N>> to_vector() const;
+
+	private:
+
+		std::size_t Count;
+		std::size_t Stride;
+		std::vector<T> Data;
+
+	};
+
+	// Batch kernels over vec_array<float,3>. Output arrays are resized to match the input.
+	namespace batch {
+
+		// Out = Transform * (In, 1), affine transform of positions.
+		void transform_points(const mat<float, 4, 4>& aTransform, const vec_array<float, 3>& aIn, vec_array<float, 3>& aOut);
+		// Out = Transform * (In, 0), for directions. For normals pass the inverse transpose.
+		void transform_vectors(const mat<float, 4, 4>& aTransform, const vec_array<float, 3>& aIn, vec_array<float, 3>& aOut);
+		// Scales every vector to unit length in place. Zero vectors are left at zero.
+		void normalize(vec_array<float, 3>& aVectors);
+		// aOut[i] = A[i] . B[i], aOut must hold at least A.stride() floats. dot() and cross()
+		// throw std::invalid_argument when A and B differ in size.
+		void dot(const vec_array<float, 3>& aA, const vec_array<float, 3>& aB, float* aOut);
+		// Out[i] = A[i] x B[i].
+		void cross(const vec_array<float, 3>& aA, const vec_array<float, 3>& aB, vec_array<float, 3>& aOut);
+		// Component-wise minimum and maximum over all vectors, e.g. for bounding box updates.
+		void bounds(const vec_array<float, 3>& aPoints, vec<float, 3>& aMin, vec<float, 3>& aMax);
+
+	}
+
+	// ---------- Implementation ---------- //
+
+	template <typename T, std::size_t N>
+	inline vec_array<T, N>::vec_array() {
+		this->Count = 0;
+		this->Stride = 0;
+	}
+
+	template <typename T, std::size_t N>
+	inline vec_array<T, N>::vec_array(std::size_t aCount) : vec_array() {
+		this->resize(aCount);
+	}
+
+	template <typename T, std::size_t N>
+	inline vec_array<T, N>::vec_array(const std::vector<vec<T, N>>& aList) : vec_array(aList.size()) {
+		for (std::size_t i = 0; i < aList.size(); i++) {
+			this->set(i, aList[i]);
+		}
+	}
+
+	template <typename T, std::size_t N>
+	inline std::size_t vec_array<T, N>::size() const {
+		return Count;
+	}
+
+	template <typename T, std::size_t N>
+	inline std::size_t vec_array<T, N>::stride() const {
+		return Stride;
+	}
+
+	template <typename T, std::size_t N>
+	inline void vec_array<T, N>::resize(std::size_t aCount) {
+		std::size_t NewStride = ((aCount + Padding - 1) / Padding) * Padding;
+		if (NewStride != Stride) {
+			std::vector<T> NewData(NewStride * N, T(0));
+			for (std::size_t c = 0; c < N; c++) {
+				std::copy(Data.begin() + c * Stride, Data.begin() + c * Stride + std::min(Count, aCount), NewData.begin() + c * NewStride);
+			}
+			Data.swap(NewData);
+			Stride = NewStride;
+		}
+		else {
+			// Keep padding zeroed when shrinking inside the same stride.
+			for (std::size_t c = 0; c < N; c++) {
+				std::fill(Data.begin() + c * Stride + std::min(Count, aCount), Data.begin() + (c + 1) * Stride, T(0));
+			}
+		}
+		Count = aCount;
+	}
+
+	template <typename T, std::size_t N>
+	inline T* vec_array<T, N>::component(std::size_t aComponent) {
+		return Data.data() + aComponent * Stride;
+	}
+
+	template <typename T, std::size_t N>
+	inline const T* vec_array<T, N>::component(std::size_t aComponent) const {
+		return Data.data() + aComponent * Stride;
+	}
+
+	template <typename T, std::size_t N>
+	inline vec<T, N> vec_array<T, N>::get(std::size_t aIndex) const {
+		vec<T, N> Value;
+		for (std::size_t c = 0; c < N; c++) Value[c] = Data[c * Stride + aIndex];
+		return Value;
+	}
+
+	template <typename T, std::size_t N>
+	inline void vec_array<T, N>::set(std::size_t aIndex, const vec<T, N>& aValue) {
+		for (std::size_t c = 0; c < N; c++) Data[c * Stride + aIndex] = aValue[c];
+	}
+
+	template <typename T, std::size_t N>
+	inline std::vector<vec<T, N>> vec_array<T, N>::to_vector() const {
+		std::vector<vec<T, N>> List(Count);
+		for (std::size_t i = 0; i < Count; i++) List[i] = this->get(i);
+		return List;
+	}
+
+	namespace detail {
+
+		// Thin wrapper over the widest float register enabled by math_simd.h so each
+		// batch kernel is written once for AVX2, SSE2 and scalar builds.
+		struct lane {
+#if defined(GEODESY_MATH_SIMD_AVX2)
+			static constexpr std::size_t Width = 8;
+			__m256 V;
+			static lane load(const float* aPointer) { return { _mm256_loadu_ps(aPointer) }; }
+			static lane set(float aValue) { return { _mm256_set1_ps(aValue) }; }
+			void store(float* aPointer) const { _mm256_storeu_ps(aPointer, V); }
+			friend lane operator+(lane aA, lane aB) { return { _mm256_add_ps(aA.V, aB.V) }; }
+			friend lane operator-(lane aA, lane aB) { return { _mm256_sub_ps(aA.V, aB.V) }; }
+			friend lane operator*(lane aA, lane aB) { return { _mm256_mul_ps(aA.V, aB.V) }; }
+			friend lane operator/(lane aA, lane aB) { return { _mm256_div_ps(aA.V, aB.V) }; }
+			friend lane sqrt(lane aA) { return { _mm256_sqrt_ps(aA.V) }; }
+			friend lane min(lane aA, lane aB) { return { _mm256_min_ps(aA.V, aB.V) }; }
+			friend lane max(lane aA, lane aB) { return { _mm256_max_ps(aA.V, aB.V) }; }
+			// Selects aB where aMask > 0, else aA.
+			friend lane select_positive(lane aMask, lane aA, lane aB) { return { _mm256_blendv_ps(aA.V, aB.V, _mm256_cmp_ps(aMask.V, _mm256_setzero_ps(), _CMP_GT_OQ)) }; }
+			void lanes(float* aOut) const { _mm256_storeu_ps(aOut, V); }
+			// Rounds toward zero, as float lanes and as integer lanes.
+			lane truncated() const { return { _mm256_cvtepi32_ps(_mm256_cvttps_epi32(V)) }; }
+			void truncate(int32_t* aOut) const { _mm256_storeu_si256((__m256i*)aOut, _mm256_cvttps_epi32(V)); }
+			static lane gather(const float* aBase, const int32_t* aIndex) { return { _mm256_i32gather_ps(aBase, _mm256_loadu_si256((const __m256i*)aIndex), 4) }; }
+#elif defined(GEODESY_MATH_SIMD_SSE)
+			static constexpr std::size_t Width = 4;
+			__m128 V;
+			static lane load(const float* aPointer) { return { _mm_loadu_ps(aPointer) }; }
+			static lane set(float aValue) { return { _mm_set1_ps(aValue) }; }
+			void store(float* aPointer) const { _mm_storeu_ps(aPointer, V); }
+			friend lane operator+(lane aA, lane aB) { return { _mm_add_ps(aA.V, aB.V) }; }
+			friend lane operator-(lane aA, lane aB) { return { _mm_sub_ps(aA.V, aB.V) }; }
+			friend lane operator*(lane aA, lane aB) { return { _mm_mul_ps(aA.V, aB.V) }; }
+			friend lane operator/(lane aA, lane aB) { return { _mm_div_ps(aA.V, aB.V) }; }
+			friend lane sqrt(lane aA) { return { _mm_sqrt_ps(aA.V) }; }
+			friend lane min(lane aA, lane aB) { return { _mm_min_ps(aA.V, aB.V) }; }
+			friend lane max(lane aA, lane aB) { return { _mm_max_ps(aA.V, aB.V) }; }
+			friend lane select_positive(lane aMask, lane aA, lane aB) {
+				__m128 Mask = _mm_cmpgt_ps(aMask.V, _mm_setzero_ps());
+				return { _mm_or_ps(_mm_and_ps(Mask, aB.V), _mm_andnot_ps(Mask, aA.V)) };
+			}
+			void lanes(float* aOut) const { _mm_storeu_ps(aOut, V); }
+			lane truncated() const { return { _mm_cvtepi32_ps(_mm_cvttps_epi32(V)) }; }
+			void truncate(int32_t* aOut) const { _mm_storeu_si128((__m128i*)aOut, _mm_cvttps_epi32(V)); }
+			static lane gather(const float* aBase, const int32_t* aIndex) { return { _mm_setr_ps(aBase[aIndex[0]], aBase[aIndex[1]], aBase[aIndex[2]], aBase[aIndex[3]]) }; }
+#else
+			static constexpr std::size_t Width = 1;
+			float V;
+			static lane load(const float* aPointer) { return { *aPointer }; }
+			static lane set(float aValue) { return { aValue }; }
+			void store(float* aPointer) const { *aPointer = V; }
+			friend lane operator+(lane aA, lane aB) { return { aA.V + aB.V }; }
+			friend lane operator-(lane aA, lane aB) { return { aA.V - aB.V }; }
+			friend lane operator*(lane aA, lane aB) { return { aA.V * aB.V }; }
+			friend lane operator/(lane aA, lane aB) { return { aA.V / aB.V }; }
+			friend lane sqrt(lane aA) { return { std::sqrt(aA.V) }; }
+			// Return aB when either is NaN, as minps and maxps do.
+			friend lane min(lane aA, lane aB) { return { aA.V < aB.V ? aA.V : aB.V }; }
+			friend lane max(lane aA, lane aB) { return { aA.V > aB.V ? aA.V : aB.V }; }
+			friend lane select_positive(lane aMask, lane aA, lane aB) { return { aMask.V > 0.0f ? aB.V : aA.V }; }
+			void lanes(float* aOut) const { *aOut = V; }
+			lane truncated() const { return { (float)(int32_t)V }; }
+			void truncate(int32_t* aOut) const { *aOut = (int32_t)V; }
+			static lane gather(const float* aBase, const int32_t* aIndex) { return { aBase[*aIndex] }; }
+#endif
+		};
+
+		static_assert(vec_array<float, 3>::Padding % lane::Width == 0, "vec_array padding must be a multiple of the SIMD width.");
+
+		inline void transform(const mat<float, 4, 4>& aTransform, float aW, const vec_array<float, 3>& aIn, vec_array<float, 3>& aOut) {
+			if (aOut.size() != aIn.size()) aOut.resize(aIn.size());
+			lane M[3][4];
+			for (int r = 0; r < 3; r++) {
+				for (int c = 0; c < 4; c++) {
+					M[r][c] = lane::set(aTransform(r, c));
+				}
+			}
+			lane W = lane::set(aW);
+			const float* X = aIn.component(0);
+			const float* Y = aIn.component(1);
+			const float* Z = aIn.component(2);
+			float* OX = aOut.component(0);
+			float* OY = aOut.component(1);
+			float* OZ = aOut.component(2);
+			for (std::size_t i = 0; i < aIn.stride(); i += lane::Width) {
+				lane x = lane::load(X + i), y = lane::load(Y + i), z = lane::load(Z + i);
+				(M[0][0] * x + M[0][1] * y + M[0][2] * z + M[0][3] * W).store(OX + i);
+				(M[1][0] * x + M[1][1] * y + M[1][2] * z + M[1][3] * W).store(OY + i);
+				(M[2][0] * x + M[2][1] * y + M[2][2] * z + M[2][3] * W).store(OZ + i);
+			}
+		}
+
+	}
+
+	namespace batch {
+
+		inline void transform_points(const mat<float, 4, 4>& aTransform, const vec_array<float, 3>& aIn, vec_array<float, 3>& aOut) {
+			detail::transform(aTransform, 1.0f, aIn, aOut);
+		}
+
+		inline void transform_vectors(const mat<float, 4, 4>& aTransform, const vec_array<float, 3>& aIn, vec_array<float, 3>& aOut) {
+			detail::transform(aTransform, 0.0f, aIn, aOut);
+		}
+
+		inline void normalize(vec_array<float, 3>& aVectors) {
+			using detail::lane;
+			float* X = aVectors.component(0);
+			float* Y = aVectors.component(1);
+			float* Z = aVectors.component(2);
+			for (std::size_t i = 0; i < aVectors.stride(); i += lane::Width) {
+				lane x = lane::load(X + i), y = lane::load(Y + i), z = lane::load(Z + i);
+				lane LengthSquared = x * x + y * y + z * z;
+				// Padding and zero vectors divide by one instead of zero.
+				lane Length = select_positive(LengthSquared, lane::set(1.0f), sqrt(LengthSquared));
+				(x / Length).store(X + i);
+				(y / Length).store(Y + i);
+				(z / Length).store(Z + i);
+			}
+		}
+
+		inline void dot(const vec_array<float, 3>& aA, const vec_array<float, 3>& aB, float* aOut) {
+			using detail::lane;
+			if (aB.size() != aA.size()) throw std::invalid_argument("batch::dot: operands differ in size");
+			for (std::size_t i = 0; i < aA.stride(); i += lane::Width) {
+				lane Sum = lane::load(aA.component(0) + i) * lane::load(aB.component(0) + i);
+				Sum = Sum + lane::load(aA.component(1) + i) * lane::load(aB.component(1) + i);
+				Sum = Sum + lane::load(aA.component(2) + i) * lane::load(aB.component(2) + i);
+				Sum.store(aOut + i);
+			}
+		}
+
+		inline void cross(const vec_array<float, 3>& aA, const vec_array<float, 3>& aB, vec_array<float, 3>& aOut) {
+			using detail::lane;
+			if (aB.size() != aA.size()) throw std::invalid_argument("batch::cross: operands differ in size");
+			if (aOut.size() != aA.size()) aOut.resize(aA.size());
+			for (std::size_t i = 0; i < aA.stride(); i += lane::Width) {
+				lane ax = lane::load(aA.component(0) + i), ay = lane::load(aA.component(1) + i), az = lane::load(aA.component(2) + i);
+				lane bx = lane::load(aB.component(0) + i), by = lane::load(aB.component(1) + i), bz = lane::load(aB.component(2) + i);
+				(ay * bz - az * by).store(aOut.component(0) + i);
+				(az * bx - ax * bz).store(aOut.component(1) + i);
+				(ax * by - ay * bx).store(aOut.component(2) + i);
+			}
+		}
+
+		inline void bounds(const vec_array<float, 3>& aPoints, vec<float, 3>& aMin, vec<float, 3>& aMax) {
+			using detail::lane;
+			for (std::size_t c = 0; c < 3; c++) {
+				const float* P = aPoints.component(c);
+				lane Min = lane::set(std::numeric_limits<float>::max());
+				lane Max = lane::set(-std::numeric_limits<float>::max());
+				// Whole lanes only cover real elements, the remainder is folded in scalar
+				// so the zeroed padding cannot leak into the bounds.
+				std::size_t Whole = (aPoints.size() / lane::Width) * lane::Width;
+				for (std::size_t i = 0; i < Whole; i += lane::Width) {
+					lane Value = lane::load(P + i);
+					Min = min(Min, Value);
+					Max = max(Max, Value);
+				}
+				float MinLane[lane::Width], MaxLane[lane::Width];
+				Min.lanes(MinLane);
+				Max.lanes(MaxLane);
+				float MinValue = *std::min_element(MinLane, MinLane + lane::Width);
+				float MaxValue = *std::max_element(MaxLane, MaxLane + lane::Width);
+				for (std::size_t i = Whole; i < aPoints.size(); i++) {
+					MinValue = std::min(MinValue, P[i]);
+					MaxValue = std::max(MaxValue, P[i]);
+				}
+				aMin[c] = MinValue;
+				aMax[c] = MaxValue;
+			}
+		}
+
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_VEC_ARRAY_H
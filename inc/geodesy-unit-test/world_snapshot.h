@@ -0,0 +1,408 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_WORLD_SNAPSHOT_H
+#define GEODESY_UNIT_TEST_WORLD_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/yaml.h>
+#include <geodesy-unit-test/mapped_file.h>
+#include <geodesy-unit-test/cache_file.h>
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy::io {
+
+	// Contents of a world file (assets/worlds/*.yaml) as the loader consumes it.
+	struct object_description {
+		std::string 				Name;
+		std::string 				Type;
+		std::string 				ModelPath;
+		math::vec<float, 3> 		Position;
+		math::vec<float, 2> 		Direction;
+		math::vec<float, 3> 		Scale;
+		std::vector<float> 			AnimationWeights;
+		// Subject and camera settings, only meaningful when IsSubject is set.
+		bool 						IsSubject;
+		math::vec<uint32_t, 2> 		Resolution;
+		float 						FrameRate;
+		uint32_t 					FrameCount;
+		float 						FieldOfView;
+		float 						Near;
+		float 						Far;
+		// Resolved asset metadata, zero when the model was not found at compile time.
+		uint64_t 					ModelSize;
+		int64_t 					ModelTime;
+	};
+
+	struct world_description {
+		std::string 						Name;
+		math::vec<float, 3> 				Gravity;
+		float 								TimeStep;
+		uint32_t 							VelocityIterations;
+		uint32_t 							PositionIterations;
+		std::vector<object_description> 	Object;
+
+		// Reads the World block of a parsed world file.
+		static world_description from_yaml(const yaml& aRoot);
+	};
+
+	// Versioned binary image of a world_description, read in place from a memory mapping.
+	// All records are fixed size and 4 byte aligned, strings live in one table and are
+	// referenced by offset and length, so opening a snapshot does no parsing or allocation.
+	//
+	//	header | object_record[ObjectCount] | float[FloatCount] | char[StringSize]
+	//
+	// A snapshot records the size and write time of the YAML it was compiled from and is
+	// only used while the YAML is unchanged. Files are native (little) endian, a snapshot
+	// from a host of the other byte order is rejected by the ByteOrder check.
+	class world_snapshot {
+	public:
+
+		static constexpr uint32_t Version = 1;
+		static constexpr char Magic[8] = { 'G', 'E', 'O', 'W', 'O', 'R', 'L', 'D' };
+
+		struct string_ref {
+			uint32_t Offset;
+			uint32_t Length;
+		};
+
+		struct header {
+			char 		Magic[8];
+			uint32_t 	Version;
+			uint32_t 	ByteOrder; 				// 0x01020304 as written by the compiling host.
+			uint64_t 	SourceSize;
+			int64_t 	SourceTime;
+			uint32_t 	ObjectCount;
+			uint32_t 	FloatCount;
+			uint32_t 	StringSize;
+			uint32_t 	Flags;
+			string_ref 	Name;
+			float 		Gravity[3];
+			float 		TimeStep;
+			uint32_t 	VelocityIterations;
+			uint32_t 	PositionIterations;
+		};
+
+		struct object_record {
+			string_ref 	Name;
+			string_ref 	Type;
+			string_ref 	ModelPath;
+			float 		Position[3];
+			float 		Direction[2];
+			float 		Scale[3];
+			uint32_t 	WeightOffset; 			// Into the float pool.
+			uint32_t 	WeightCount;
+			uint32_t 	IsSubject;
+			uint32_t 	Resolution[2];
+			float 		FrameRate;
+			uint32_t 	FrameCount;
+			float 		FieldOfView;
+			float 		Near;
+			float 		Far;
+			uint32_t 	Padding;
+			uint64_t 	ModelSize;
+			int64_t 	ModelTime;
+		};
+
+		enum flag : uint32_t {
+			ASSETS_RESOLVED = 1u << 0,
+		};
+
+		world_snapshot();
+		// Maps aPath and validates its header and the ranges of every record, check
+		// is_valid() afterwards.
+		world_snapshot(const std::string& aPath);
+
+		bool is_valid() const;
+		// True when the snapshot was compiled from aSourcePath as it is on disk now. With
+		// ASSETS_RESOLVED, every model resolved against aAssetRoot must also be unchanged.
+		bool is_current(const std::string& aSourcePath, const std::string& aAssetRoot = ".") const;
+
+		const header& info() const;
+		std::size_t object_count() const;
+		const object_record& object(std::size_t aIndex) const;
+		std::string_view string(const string_ref& aReference) const;
+		const float* weights(const object_record& aObject) const;
+
+		// Copies the mapped records into an owning description.
+		world_description to_description() const;
+
+		// Default snapshot location for a world file, the YAML path with a .world extension.
+		static std::string path_for(const std::string& aSourcePath);
+		// Parses aSourcePath and writes its snapshot to aSnapshotPath. With aResolveAssets,
+		// each ModelPath is resolved against aAssetRoot and its size and write time stored.
+		static void compile(const std::string& aSourcePath, const std::string& aSnapshotPath, bool aResolveAssets = false, const std::string& aAssetRoot = ".");
+
+	private:
+
+		mapped_file 			File;
+		const header* 			Header;
+		const object_record* 	Object;
+		const float* 			Float;
+		const char* 			String;
+
+		static int64_t write_time(const std::filesystem::path& aPath);
+
+	};
+
+	static_assert(std::is_trivially_copyable_v<world_snapshot::header> && (sizeof(world_snapshot::header) % 8 == 0), "Snapshot header must be a packed POD.");
+	static_assert(std::is_trivially_copyable_v<world_snapshot::object_record> && (sizeof(world_snapshot::object_record) % 8 == 0), "Snapshot object record must be a packed POD.");
+
+	// Loads a world, from its snapshot when one exists and is current, else from YAML.
+	// aUsedSnapshot, when given, reports which path was taken. aAssetRoot is the one the
+	// snapshot was compiled with.
+	world_description load_world(const std::string& aSourcePath, const std::string& aSnapshotPath, bool* aUsedSnapshot = nullptr, const std::string& aAssetRoot = ".");
+
+	// ---------- world_description ---------- //
+
+	inline world_description world_description::from_yaml(const yaml& aRoot) {
+		auto read = [](const yaml& aNode, float* aOut, std::size_t aCount, float aDefault) {
+			for (std::size_t i = 0; i < aCount; i++) aOut[i] = aNode[i].as_float(aDefault);
+		};
+		const yaml& World = aRoot["World"];
+		world_description Description;
+		Description.Name 				= World["Name"].as_string();
+		const yaml& Physics 			= World["Physics"];
+		read(Physics["Gravity"], &Description.Gravity[0], 3, 0.0f);
+		Description.TimeStep 			= Physics["TimeStep"].as_float(0.0f);
+		Description.VelocityIterations 	= (uint32_t)Physics["VelocityIterations"].as_int(0);
+		Description.PositionIterations 	= (uint32_t)Physics["PositionIterations"].as_int(0);
+		const yaml& ObjectList = World["Objects"];
+		Description.Object.resize(ObjectList.size());
+		for (std::size_t i = 0; i < ObjectList.size(); i++) {
+			const yaml& Node = ObjectList[i];
+			object_description& Object = Description.Object[i];
+			Object.Name 			= Node["Name"].as_string();
+			Object.Type 			= Node["Type"].as_string();
+			Object.ModelPath 		= Node["ModelPath"].as_string();
+			read(Node["Position"], &Object.Position[0], 3, 0.0f);
+			read(Node["Direction"], &Object.Direction[0], 2, 0.0f);
+			read(Node["Scale"], &Object.Scale[0], 3, 1.0f);
+			for (std::size_t w = 0; w < Node["AnimationWeights"].size(); w++) Object.AnimationWeights.push_back(Node["AnimationWeights"][w].as_float());
+			Object.IsSubject 		= Node.has("Resolution") || Node.has("FOV");
+			Object.Resolution[0] 	= (uint32_t)Node["Resolution"][0].as_int(0);
+			Object.Resolution[1] 	= (uint32_t)Node["Resolution"][1].as_int(0);
+			Object.FrameRate 		= Node["FrameRate"].as_float(0.0f);
+			Object.FrameCount 		= (uint32_t)Node["FrameCount"].as_int(0);
+			Object.FieldOfView 		= Node["FOV"].as_float(0.0f);
+			Object.Near 			= Node["Near"].as_float(0.0f);
+			Object.Far 				= Node["Far"].as_float(0.0f);
+			Object.ModelSize 		= 0;
+			Object.ModelTime 		= 0;
+		}
+		return Description;
+	}
+
+	// ---------- world_snapshot ---------- //
+
+	inline world_snapshot::world_snapshot() {
+		Header = nullptr;
+		Object = nullptr;
+		Float = nullptr;
+		String = nullptr;
+	}
+
+	inline world_snapshot::world_snapshot(const std::string& aPath) : world_snapshot() {
+		File = mapped_file(aPath);
+		header Check;
+		if (!read_cache_header(File, Magic, Version, Check)) return;
+		const header* Candidate = (const header*)File.data();
+		// Bounds of every section must lie inside the file.
+		uint64_t Expected = sizeof(header) + (uint64_t)Candidate->ObjectCount * sizeof(object_record) + (uint64_t)Candidate->FloatCount * sizeof(float) + Candidate->StringSize;
+		if (Expected != File.size()) return;
+		// So must every string and weight range a record points at, the accessors index
+		// the mapping without further checks.
+		const object_record* Records = (const object_record*)(File.data() + sizeof(header));
+		auto inside = [&](const string_ref& aReference) { return (uint64_t)aReference.Offset + aReference.Length <= Candidate->StringSize; };
+		if (!inside(Candidate->Name)) return;
+		for (std::size_t i = 0; i < Candidate->ObjectCount; i++) {
+			const object_record& Record = Records[i];
+			if (!inside(Record.Name) || !inside(Record.Type) || !inside(Record.ModelPath)) return;
+			if ((uint64_t)Record.WeightOffset + Record.WeightCount > Candidate->FloatCount) return;
+		}
+		Header 	= Candidate;
+		Object 	= Records;
+		Float 	= (const float*)(Object + Header->ObjectCount);
+		String 	= (const char*)(Float + Header->FloatCount);
+	}
+
+	inline bool world_snapshot::is_valid() const {
+		return Header != nullptr;
+	}
+
+	inline bool world_snapshot::is_current(const std::string& aSourcePath, const std::string& aAssetRoot) const {
+		if (!this->is_valid()) return false;
+		std::error_code Error;
+		uint64_t Size = std::filesystem::file_size(aSourcePath, Error);
+		if (Error) return false;
+		if ((Size != Header->SourceSize) || (write_time(aSourcePath) != Header->SourceTime)) return false;
+		if ((Header->Flags & ASSETS_RESOLVED) == 0) return true;
+		for (uint32_t i = 0; i < Header->ObjectCount; i++) {
+			const object_record& Record = Object[i];
+			if (Record.ModelPath.Length == 0) continue;
+			// A model missing at compile time was stored as zero, and must still be missing.
+			std::filesystem::path Model = std::filesystem::path(aAssetRoot) / this->string(Record.ModelPath);
+			uint64_t ModelSize = std::filesystem::file_size(Model, Error);
+			if (Error) ModelSize = 0;
+			if ((ModelSize != Record.ModelSize) || (write_time(Model) != Record.ModelTime)) return false;
+		}
+		return true;
+	}
+
+	inline const world_snapshot::header& world_snapshot::info() const {
+		return *Header;
+	}
+
+	inline std::size_t world_snapshot::object_count() const {
+		return Header != nullptr ? Header->ObjectCount : 0;
+	}
+
+	inline const world_snapshot::object_record& world_snapshot::object(std::size_t aIndex) const {
+		return Object[aIndex];
+	}
+
+	inline std::string_view world_snapshot::string(const string_ref& aReference) const {
+		if ((uint64_t)aReference.Offset + aReference.Length > Header->StringSize) return std::string_view();
+		return std::string_view(String + aReference.Offset, aReference.Length);
+	}
+
+	inline const float* world_snapshot::weights(const object_record& aObject) const {
+		return Float + aObject.WeightOffset;
+	}
+
+	inline world_description world_snapshot::to_description() const {
+		world_description Description;
+		if (!this->is_valid()) return Description;
+		Description.Name 				= std::string(this->string(Header->Name));
+		Description.Gravity 			= { Header->Gravity[0], Header->Gravity[1], Header->Gravity[2] };
+		Description.TimeStep 			= Header->TimeStep;
+		Description.VelocityIterations 	= Header->VelocityIterations;
+		Description.PositionIterations 	= Header->PositionIterations;
+		Description.Object.resize(Header->ObjectCount);
+		for (std::size_t i = 0; i < Header->ObjectCount; i++) {
+			const object_record& Record = Object[i];
+			object_description& Target = Description.Object[i];
+			Target.Name 			= std::string(this->string(Record.Name));
+			Target.Type 			= std::string(this->string(Record.Type));
+			Target.ModelPath 		= std::string(this->string(Record.ModelPath));
+			Target.Position 		= { Record.Position[0], Record.Position[1], Record.Position[2] };
+			Target.Direction 		= { Record.Direction[0], Record.Direction[1] };
+			Target.Scale 			= { Record.Scale[0], Record.Scale[1], Record.Scale[2] };
+			const float* Weight 	= this->weights(Record);
+			Target.AnimationWeights.assign(Weight, Weight + Record.WeightCount);
+			Target.IsSubject 		= Record.IsSubject != 0;
+			Target.Resolution 		= { Record.Resolution[0], Record.Resolution[1] };
+			Target.FrameRate 		= Record.FrameRate;
+			Target.FrameCount 		= Record.FrameCount;
+			Target.FieldOfView 		= Record.FieldOfView;
+			Target.Near 			= Record.Near;
+			Target.Far 				= Record.Far;
+			Target.ModelSize 		= Record.ModelSize;
+			Target.ModelTime 		= Record.ModelTime;
+		}
+		return Description;
+	}
+
+	inline std::string world_snapshot::path_for(const std::string& aSourcePath) {
+		return std::filesystem::path(aSourcePath).replace_extension(".world").string();
+	}
+
+	inline void world_snapshot::compile(const std::string& aSourcePath, const std::string& aSnapshotPath, bool aResolveAssets, const std::string& aAssetRoot) {
+		// Stat the source before reading it, so an edit made during compilation leaves
+		// the snapshot stale rather than silently current.
+		std::error_code Error;
+		uint64_t SourceSize = std::filesystem::file_size(aSourcePath, Error);
+		if (Error) throw std::runtime_error("world_snapshot: cannot stat " + aSourcePath);
+		int64_t SourceTime = write_time(aSourcePath);
+		world_description Description = world_description::from_yaml(yaml::load(aSourcePath));
+
+		std::string StringTable;
+		auto intern = [&](const std::string& aText) -> string_ref {
+			string_ref Reference = { (uint32_t)StringTable.size(), (uint32_t)aText.size() };
+			StringTable += aText;
+			return Reference;
+		};
+		std::vector<float> FloatPool;
+
+		header Header = make_cache_header<header>(Magic, Version);
+		Header.SourceSize 			= SourceSize;
+		Header.SourceTime 			= SourceTime;
+		Header.ObjectCount 			= (uint32_t)Description.Object.size();
+		Header.Flags 				= aResolveAssets ? (uint32_t)ASSETS_RESOLVED : 0u;
+		Header.Name 				= intern(Description.Name);
+		for (std::size_t i = 0; i < 3; i++) Header.Gravity[i] = Description.Gravity[i];
+		Header.TimeStep 			= Description.TimeStep;
+		Header.VelocityIterations 	= Description.VelocityIterations;
+		Header.PositionIterations 	= Description.PositionIterations;
+
+		std::vector<object_record> Record(Description.Object.size());
+		for (std::size_t i = 0; i < Record.size(); i++) {
+			const object_description& Source = Description.Object[i];
+			object_record& Target = Record[i];
+			Target = object_record{};
+			Target.Name 			= intern(Source.Name);
+			Target.Type 			= intern(Source.Type);
+			Target.ModelPath 		= intern(Source.ModelPath);
+			for (std::size_t d = 0; d < 3; d++) Target.Position[d] = Source.Position[d];
+			for (std::size_t d = 0; d < 2; d++) Target.Direction[d] = Source.Direction[d];
+			for (std::size_t d = 0; d < 3; d++) Target.Scale[d] = Source.Scale[d];
+			Target.WeightOffset 	= (uint32_t)FloatPool.size();
+			Target.WeightCount 		= (uint32_t)Source.AnimationWeights.size();
+			FloatPool.insert(FloatPool.end(), Source.AnimationWeights.begin(), Source.AnimationWeights.end());
+			Target.IsSubject 		= Source.IsSubject ? 1 : 0;
+			Target.Resolution[0] 	= Source.Resolution[0];
+			Target.Resolution[1] 	= Source.Resolution[1];
+			Target.FrameRate 		= Source.FrameRate;
+			Target.FrameCount 		= Source.FrameCount;
+			Target.FieldOfView 		= Source.FieldOfView;
+			Target.Near 			= Source.Near;
+			Target.Far 				= Source.Far;
+			if (aResolveAssets && (Source.ModelPath.size() > 0)) {
+				std::filesystem::path Model = std::filesystem::path(aAssetRoot) / Source.ModelPath;
+				uint64_t ModelSize = std::filesystem::file_size(Model, Error);
+				if (!Error) {
+					Target.ModelSize = ModelSize;
+					Target.ModelTime = write_time(Model);
+				}
+			}
+		}
+		Header.FloatCount = (uint32_t)FloatPool.size();
+		Header.StringSize = (uint32_t)StringTable.size();
+
+		bool Written = write_cache_file(aSnapshotPath, [&](std::ostream& aStream) {
+			aStream.write((const char*)&Header, sizeof(Header));
+			aStream.write((const char*)Record.data(), Record.size() * sizeof(object_record));
+			aStream.write((const char*)FloatPool.data(), FloatPool.size() * sizeof(float));
+			aStream.write(StringTable.data(), StringTable.size());
+		});
+		if (!Written) throw std::runtime_error("world_snapshot: cannot write " + aSnapshotPath);
+	}
+
+	inline int64_t world_snapshot::write_time(const std::filesystem::path& aPath) {
+		std::error_code Error;
+		std::filesystem::file_time_type Time = std::filesystem::last_write_time(aPath, Error);
+		return Error ? 0 : (int64_t)Time.time_since_epoch().count();
+	}
+
+	inline world_description load_world(const std::string& aSourcePath, const std::string& aSnapshotPath, bool* aUsedSnapshot, const std::string& aAssetRoot) {
+		GEODESY_PROFILE_SCOPE("asset", "world", profiler::instance().intern(aSourcePath));
+		world_snapshot Snapshot(aSnapshotPath);
+		bool UseSnapshot = Snapshot.is_current(aSourcePath, aAssetRoot);
+		if (aUsedSnapshot != nullptr) *aUsedSnapshot = UseSnapshot;
+		if (UseSnapshot) return Snapshot.to_description();
+		return world_description::from_yaml(yaml::load(aSourcePath));
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_WORLD_SNAPSHOT_H
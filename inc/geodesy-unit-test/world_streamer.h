@@ -0,0 +1,387 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_WORLD_STREAMER_H
+#define GEODESY_UNIT_TEST_WORLD_STREAMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+
+#include <geodesy-unit-test/yaml.h>
+#include <geodesy-unit-test/world_snapshot.h>
+#include <geodesy-unit-test/profiler.h>
+
+namespace geodesy::io {
+
+	// One entry of the root config's Worlds list.
+	struct world_entry {
+		std::string 	Name;
+		std::string 	ConfigFile;
+		bool 			AutoLoad;
+	};
+
+	// World list and streaming settings of the root config (assets/config.yaml).
+	struct streaming_config {
+		double 						ExecutionRate 	= 60.0; 	// [Hz] Engine.ExecutionRate.
+		double 						FrameBudget 	= 0.25; 	// Fraction of a frame spent integrating streamed objects.
+		bool 						Prefetch 		= true; 	// Load deferred worlds in the background at startup, else on request.
+		std::vector<world_entry> 	World;
+
+		// Integration time allowed per frame. [ms]
+		double budget() const;
+		static streaming_config from_yaml(const yaml& aRoot);
+	};
+
+	// Streams deferred (AutoLoad: false) worlds in two steps. prefetch() queues a world on a
+	// background thread, which reads its snapshot or YAML and runs aLoad (file I/O, parsing,
+	// decoding) for each object in list order, defer() only records where it is and leaves
+	// loading to its request. request() marks it for integration, and the
+	// frame loop calls update() once per frame, which hands loaded objects to aIntegrate
+	// (stage insertion, GPU upload) until the frame's budget is spent. A world switch is
+	// then spread over as many frames as it needs and none of them stalls, and a prefetched
+	// world switches as fast as its integration allows.
+	//
+	// There is one background thread so the frame thread keeps its core. aLoad runs on it
+	// and aIntegrate on the thread calling update(), objects are integrated in list order.
+	template <typename T>
+	class world_streamer {
+	public:
+
+		enum state {
+			UNKNOWN,
+			DEFERRED, 			// Known, loads when requested.
+			QUEUED,
+			LOADING,
+			LOADED, 			// Every object loaded, not requested yet.
+			INTEGRATING,
+			READY, 				// Every object integrated.
+			FAILED,
+		};
+
+		// Result of one update().
+		struct frame {
+			std::size_t 	Integrated 	= 0;
+			std::size_t 	Pending 	= 0; 		// Objects of requested worlds still to integrate, at least one per world not loaded yet.
+			double 			Elapsed 	= 0.0; 		// [ms]
+		};
+
+		using load_function 		= std::function<T(const object_description&)>;
+		using integrate_function 	= std::function<void(const std::string&, const object_description&, T&)>;
+
+		world_streamer(load_function aLoad, integrate_function aIntegrate);
+		world_streamer(const world_streamer&) = delete;
+		world_streamer& operator=(const world_streamer&) = delete;
+		~world_streamer();
+
+		// Queues aName for background loading, from its snapshot when current. Known worlds
+		// are left as they are.
+		void prefetch(const std::string& aName, const std::string& aSourcePath);
+		// Records aName without loading it, request() queues it. Known worlds are left as
+		// they are.
+		void defer(const std::string& aName, const std::string& aSourcePath);
+		// Prefetches every world of aConfig that is not AutoLoad, or defers them when
+		// aConfig.Prefetch is off.
+		void prefetch_deferred(const streaming_config& aConfig);
+		// Marks a prefetched or deferred world for integration. A world not loaded yet is
+		// loaded next.
+		void request(const std::string& aName);
+		// Integrates loaded objects of requested worlds, in request order, for about aBudget
+		// milliseconds. An object is only started when the running average cost of that
+		// world's objects still fits, and at least one is integrated per call so a budget
+		// below one object's cost still makes progress. Rethrows errors from aIntegrate
+		// after marking the world failed.
+		frame update(double aBudget);
+		state status(const std::string& aName) const;
+		std::string error(const std::string& aName) const;
+		// Forgets a world. A load in progress stops after its current object.
+		void release(const std::string& aName);
+
+	private:
+
+		struct world {
+			std::string 		Name;
+			std::string 		SourcePath;
+			world_description 	Description;
+			std::vector<T> 		Object;
+			std::vector<const char*> 	Label; 		// Interned object names for the profiler.
+			std::size_t 		Loaded 		= 0;
+			std::size_t 		Integrated 	= 0;
+			bool 				Queued 		= false;
+			bool 				Loading 	= false;
+			bool 				Done 		= false;
+			bool 				Requested 	= false;
+			bool 				Cancelled 	= false;
+			std::string 		Error;
+			double 				Cost 		= 0.0; 		// Running average integration time. [ms]
+		};
+
+		load_function 								Load;
+		integrate_function 							Integrate;
+		mutable std::mutex 							Mutex;
+		std::condition_variable 					Wake;
+		std::map<std::string, std::shared_ptr<world>> 	World;
+		std::deque<std::shared_ptr<world>> 			Queue;
+		std::vector<std::shared_ptr<world>> 		Requested;
+		bool 										Stop;
+		std::thread 								Worker;
+
+		void add(const std::string& aName, const std::string& aSourcePath, bool aQueue);
+		void run();
+
+	};
+
+	// ---------- streaming_config ---------- //
+
+	inline double streaming_config::budget() const {
+		return ExecutionRate > 0.0 ? 1000.0 / ExecutionRate * FrameBudget : 0.0;
+	}
+
+	inline streaming_config streaming_config::from_yaml(const yaml& aRoot) {
+		streaming_config Config;
+		Config.ExecutionRate 	= aRoot["Engine"]["ExecutionRate"].as_double(Config.ExecutionRate);
+		Config.FrameBudget 		= aRoot["Streaming"]["FrameBudget"].as_double(Config.FrameBudget);
+		Config.Prefetch 		= aRoot["Streaming"]["Prefetch"].as_bool(Config.Prefetch);
+		const yaml& List = aRoot["Worlds"];
+		for (std::size_t i = 0; i < List.size(); i++) {
+			Config.World.push_back({ List[i]["Name"].as_string(), List[i]["ConfigFile"].as_string(), List[i]["AutoLoad"].as_bool(false) });
+		}
+		return Config;
+	}
+
+	// ---------- world_streamer ---------- //
+
+	template <typename T>
+	inline world_streamer<T>::world_streamer(load_function aLoad, integrate_function aIntegrate) {
+		Load = std::move(aLoad);
+		Integrate = std::move(aIntegrate);
+		Stop = false;
+		Worker = std::thread(&world_streamer::run, this);
+	}
+
+	template <typename T>
+	inline world_streamer<T>::~world_streamer() {
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Stop = true;
+		}
+		Wake.notify_all();
+		Worker.join();
+	}
+
+	template <typename T>
+	inline void world_streamer<T>::prefetch(const std::string& aName, const std::string& aSourcePath) {
+		this->add(aName, aSourcePath, true);
+	}
+
+	template <typename T>
+	inline void world_streamer<T>::defer(const std::string& aName, const std::string& aSourcePath) {
+		this->add(aName, aSourcePath, false);
+	}
+
+	template <typename T>
+	inline void world_streamer<T>::prefetch_deferred(const streaming_config& aConfig) {
+		for (const world_entry& Entry : aConfig.World) {
+			if (!Entry.AutoLoad) this->add(Entry.Name, Entry.ConfigFile, aConfig.Prefetch);
+		}
+	}
+
+	template <typename T>
+	inline void world_streamer<T>::request(const std::string& aName) {
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			auto It = World.find(aName);
+			if (It == World.end()) throw std::runtime_error("world_streamer: " + aName + " was neither prefetched nor deferred");
+			std::shared_ptr<world> W = It->second;
+			if (W->Requested) return;
+			W->Requested = true;
+			Requested.push_back(W);
+			// The world the player is waiting for goes ahead of speculative prefetches.
+			auto Queued = std::find(Queue.begin(), Queue.end(), W);
+			if (Queued != Queue.end()) Queue.erase(Queued);
+			else if (W->Queued) return;
+			W->Queued = true;
+			Queue.push_front(W);
+		}
+		Wake.notify_all();
+	}
+
+	template <typename T>
+	inline typename world_streamer<T>::frame world_streamer<T>::update(double aBudget) {
+		GEODESY_PROFILE_SCOPE("stream", "update");
+		using clock = std::chrono::steady_clock;
+		clock::time_point Start = clock::now();
+		auto elapsed = [](clock::time_point aFrom) { return std::chrono::duration<double, std::milli>(clock::now() - aFrom).count(); };
+
+		frame Frame;
+		std::vector<std::shared_ptr<world>> List;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			List = Requested;
+		}
+		bool OutOfTime = false;
+		for (const std::shared_ptr<world>& W : List) {
+			while (!OutOfTime) {
+				std::size_t Index;
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					if (!W->Error.empty() || (W->Integrated >= W->Loaded)) break;
+					Index = W->Integrated;
+				}
+				if ((Frame.Integrated > 0) && (elapsed(Start) + W->Cost > aBudget)) {
+					OutOfTime = true;
+					break;
+				}
+				clock::time_point ObjectStart = clock::now();
+				try {
+					// Objects below Loaded are no longer touched by the loader.
+					GEODESY_PROFILE_SCOPE("stream", "integrate", W->Label[Index]);
+					Integrate(W->Name, W->Description.Object[Index], W->Object[Index]);
+				}
+				catch (const std::exception& e) {
+					std::lock_guard<std::mutex> Lock(Mutex);
+					W->Error = e.what();
+					throw;
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> Lock(Mutex);
+					W->Error = "unknown error";
+					throw;
+				}
+				double Cost = elapsed(ObjectStart);
+				W->Cost = W->Cost > 0.0 ? 0.75 * W->Cost + 0.25 * Cost : Cost;
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					W->Integrated++;
+				}
+				Frame.Integrated++;
+			}
+		}
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			for (const std::shared_ptr<world>& W : Requested) {
+				if (!W->Error.empty()) continue;
+				// A world still queued or loading has no object list yet, or a partial one.
+				std::size_t Left = W->Object.size() - W->Integrated;
+				Frame.Pending += W->Done ? Left : std::max<std::size_t>(Left, 1);
+			}
+		}
+		Frame.Elapsed = elapsed(Start);
+		return Frame;
+	}
+
+	template <typename T>
+	inline typename world_streamer<T>::state world_streamer<T>::status(const std::string& aName) const {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		auto It = World.find(aName);
+		if (It == World.end()) return UNKNOWN;
+		const world& W = *It->second;
+		if (!W.Error.empty()) return FAILED;
+		if (W.Requested) return (W.Done && (W.Integrated == W.Object.size())) ? READY : INTEGRATING;
+		if (W.Done) return LOADED;
+		if (W.Loading) return LOADING;
+		return W.Queued ? QUEUED : DEFERRED;
+	}
+
+	template <typename T>
+	inline std::string world_streamer<T>::error(const std::string& aName) const {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		auto It = World.find(aName);
+		return It != World.end() ? It->second->Error : std::string();
+	}
+
+	template <typename T>
+	inline void world_streamer<T>::release(const std::string& aName) {
+		std::lock_guard<std::mutex> Lock(Mutex);
+		auto It = World.find(aName);
+		if (It == World.end()) return;
+		std::shared_ptr<world> W = It->second;
+		W->Cancelled = true;
+		World.erase(It);
+		Queue.erase(std::remove(Queue.begin(), Queue.end(), W), Queue.end());
+		Requested.erase(std::remove(Requested.begin(), Requested.end(), W), Requested.end());
+	}
+
+	template <typename T>
+	inline void world_streamer<T>::add(const std::string& aName, const std::string& aSourcePath, bool aQueue) {
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			if (World.count(aName) > 0) return;
+			std::shared_ptr<world> W = std::make_shared<world>();
+			W->Name = aName;
+			W->SourcePath = aSourcePath;
+			W->Queued = aQueue;
+			World[aName] = W;
+			if (aQueue) Queue.push_back(W);
+		}
+		if (aQueue) Wake.notify_all();
+	}
+
+	template <typename T>
+	inline void world_streamer<T>::run() {
+		profiler::instance().set_thread_name("world streamer");
+		while (true) {
+			std::shared_ptr<world> W;
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				Wake.wait(Lock, [&]() { return Stop || !Queue.empty(); });
+				if (Stop) return;
+				W = Queue.front();
+				Queue.pop_front();
+				W->Loading = true;
+			}
+			try {
+				world_description Description = load_world(W->SourcePath, world_snapshot::path_for(W->SourcePath));
+				{
+					// Sized once here, update() only reads objects below Loaded after this.
+					std::lock_guard<std::mutex> Lock(Mutex);
+					W->Object.resize(Description.Object.size());
+					W->Label.resize(Description.Object.size());
+					W->Description = std::move(Description);
+				}
+				bool Complete = true;
+				for (std::size_t i = 0; i < W->Description.Object.size(); i++) {
+					{
+						std::lock_guard<std::mutex> Lock(Mutex);
+						if (Stop || W->Cancelled) {
+							Complete = false;
+							break;
+						}
+					}
+					const char* Label = profiler::instance().intern(W->Description.Object[i].Name);
+					T Object;
+					{
+						GEODESY_PROFILE_SCOPE("stream", "load", Label);
+						Object = Load(W->Description.Object[i]);
+					}
+					std::lock_guard<std::mutex> Lock(Mutex);
+					W->Object[i] = std::move(Object);
+					W->Label[i] = Label;
+					W->Loaded++;
+				}
+				std::lock_guard<std::mutex> Lock(Mutex);
+				W->Done = Complete;
+			}
+			catch (const std::exception& e) {
+				std::lock_guard<std::mutex> Lock(Mutex);
+				W->Error = e.what();
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> Lock(Mutex);
+				W->Error = "unknown error";
+			}
+		}
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_WORLD_STREAMER_H
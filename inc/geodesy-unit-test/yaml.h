@@ -0,0 +1,308 @@
+#pragma once
+#ifndef GEODESY_UNIT_TEST_YAML_H
+#define GEODESY_UNIT_TEST_YAML_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+
+namespace geodesy::io {
+
+	// Parser for the block-style YAML subset used by the files in assets/: nested
+	// mappings and sequences by indentation, "- " items that open a mapping, flow
+	// sequences ([a, b, c]), single or double quoted scalars and # comments. Anchors,
+	// tags, multi-document streams and block scalars are not supported. Errors throw
+	// std::runtime_error with the offending line number.
+	class yaml {
+	public:
+
+		enum kind { NONE, SCALAR, SEQUENCE, MAPPING };
+
+		kind 										Kind;
+		std::string 								Value;
+		std::vector<yaml> 							Item;
+		std::vector<std::pair<std::string, yaml>> 	Member;
+
+		yaml();
+
+		static yaml parse(const std::string& aText);
+		static yaml load(const std::string& aPath);
+
+		// Member lookup, a missing key yields a NONE node so lookups can be chained.
+		const yaml& operator[](const std::string& aKey) const;
+		const yaml& operator[](std::size_t aIndex) const;
+		bool has(const std::string& aKey) const;
+		// Items of a sequence or members of a mapping.
+		std::size_t size() const;
+
+		bool is_none() const { return Kind == NONE; }
+		std::string as_string(const std::string& aDefault = "") const;
+		double as_double(double aDefault = 0.0) const;
+		float as_float(float aDefault = 0.0f) const { return (float)this->as_double(aDefault); }
+		int64_t as_int(int64_t aDefault = 0) const;
+		bool as_bool(bool aDefault = false) const;
+
+	private:
+
+		struct line {
+			std::size_t Indent;
+			std::string Text;
+			std::size_t Number;
+		};
+
+		static const yaml& none();
+		[[noreturn]] static void fail(const line& aLine, const std::string& aMessage);
+		static std::string strip_comment(const std::string& aText);
+		static std::string trim(const std::string& aText);
+		static std::size_t find_colon(const std::string& aText);
+		static bool is_item(const std::string& aText);
+		static yaml parse_block(std::vector<line>& aLine, std::size_t& aIndex, std::size_t aIndent);
+		static yaml parse_inline(const std::string& aText, const line& aLine);
+		static std::string unquote(const std::string& aText, const line& aLine);
+
+	};
+
+	inline yaml::yaml() {
+		Kind = NONE;
+	}
+
+	inline yaml yaml::parse(const std::string& aText) {
+		std::vector<line> Line;
+		std::stringstream Stream(aText);
+		std::string Text;
+		std::size_t Number = 0;
+		while (std::getline(Stream, Text)) {
+			Number++;
+			if ((Text.size() > 0) && (Text.back() == '\r')) Text.pop_back();
+			Text = strip_comment(Text);
+			std::size_t Indent = Text.find_first_not_of(' ');
+			if (Indent == std::string::npos) continue;
+			if (Text[Indent] == '\t') fail({ Indent, Text, Number }, "tabs are not allowed for indentation");
+			if ((Text.compare(Indent, 3, "---") == 0) && (trim(Text).size() == 3)) continue;
+			Line.push_back({ Indent, trim(Text), Number });
+		}
+		if (Line.empty()) return yaml();
+		std::size_t Index = 0;
+		yaml Root = parse_block(Line, Index, Line[0].Indent);
+		if (Index < Line.size()) fail(Line[Index], "unexpected indentation");
+		return Root;
+	}
+
+	inline yaml yaml::load(const std::string& aPath) {
+		std::ifstream File(aPath, std::ios::binary);
+		if (!File) throw std::runtime_error("yaml: cannot open " + aPath);
+		std::stringstream Buffer;
+		Buffer << File.rdbuf();
+		return parse(Buffer.str());
+	}
+
+	inline const yaml& yaml::operator[](const std::string& aKey) const {
+		for (const std::pair<std::string, yaml>& M : Member) if (M.first == aKey) return M.second;
+		return none();
+	}
+
+	inline const yaml& yaml::operator[](std::size_t aIndex) const {
+		return aIndex < Item.size() ? Item[aIndex] : none();
+	}
+
+	inline bool yaml::has(const std::string& aKey) const {
+		for (const std::pair<std::string, yaml>& M : Member) if (M.first == aKey) return true;
+		return false;
+	}
+
+	inline std::size_t yaml::size() const {
+		return Kind == MAPPING ? Member.size() : Item.size();
+	}
+
+	inline std::string yaml::as_string(const std::string& aDefault) const {
+		return Kind == SCALAR ? Value : aDefault;
+	}
+
+	inline double yaml::as_double(double aDefault) const {
+		if (Kind != SCALAR) return aDefault;
+		try { return std::stod(Value); } catch (...) { return aDefault; }
+	}
+
+	inline int64_t yaml::as_int(int64_t aDefault) const {
+		if (Kind != SCALAR) return aDefault;
+		try { return std::stoll(Value); } catch (...) { return aDefault; }
+	}
+
+	inline bool yaml::as_bool(bool aDefault) const {
+		if (Kind != SCALAR) return aDefault;
+		if ((Value == "true") || (Value == "True") || (Value == "TRUE") || (Value == "yes") || (Value == "on")) return true;
+		if ((Value == "false") || (Value == "False") || (Value == "FALSE") || (Value == "no") || (Value == "off")) return false;
+		return aDefault;
+	}
+
+	inline const yaml& yaml::none() {
+		static const yaml None;
+		return None;
+	}
+
+	inline void yaml::fail(const line& aLine, const std::string& aMessage) {
+		throw std::runtime_error("yaml: line " + std::to_string(aLine.Number) + ": " + aMessage);
+	}
+
+	inline std::string yaml::strip_comment(const std::string& aText) {
+		char Quote = 0;
+		for (std::size_t i = 0; i < aText.size(); i++) {
+			char C = aText[i];
+			if (Quote != 0) {
+				if (C == Quote) Quote = 0;
+			}
+			else if ((C == '"') || (C == '\'')) {
+				Quote = C;
+			}
+			else if ((C == '#') && ((i == 0) || (aText[i - 1] == ' ') || (aText[i - 1] == '\t'))) {
+				return aText.substr(0, i);
+			}
+		}
+		return aText;
+	}
+
+	inline std::string yaml::trim(const std::string& aText) {
+		std::size_t Begin = aText.find_first_not_of(" \t");
+		if (Begin == std::string::npos) return "";
+		std::size_t End = aText.find_last_not_of(" \t");
+		return aText.substr(Begin, End - Begin + 1);
+	}
+
+	inline std::size_t yaml::find_colon(const std::string& aText) {
+		// Key separator, a ':' outside quotes and brackets followed by a space or the end.
+		char Quote = 0;
+		int Depth = 0;
+		for (std::size_t i = 0; i < aText.size(); i++) {
+			char C = aText[i];
+			if (Quote != 0) { if (C == Quote) Quote = 0; continue; }
+			if ((C == '"') || (C == '\'')) Quote = C;
+			else if ((C == '[') || (C == '{')) Depth++;
+			else if ((C == ']') || (C == '}')) Depth--;
+			else if ((C == ':') && (Depth == 0) && ((i + 1 == aText.size()) || (aText[i + 1] == ' '))) return i;
+		}
+		return std::string::npos;
+	}
+
+	inline bool yaml::is_item(const std::string& aText) {
+		return (aText == "-") || (aText.compare(0, 2, "- ") == 0);
+	}
+
+	inline yaml yaml::parse_block(std::vector<line>& aLine, std::size_t& aIndex, std::size_t aIndent) {
+		yaml Node;
+		if (is_item(aLine[aIndex].Text)) {
+			Node.Kind = SEQUENCE;
+			while ((aIndex < aLine.size()) && (aLine[aIndex].Indent == aIndent) && is_item(aLine[aIndex].Text)) {
+				line& Current = aLine[aIndex];
+				std::string Rest = Current.Text.size() > 1 ? Current.Text.substr(2) : "";
+				std::size_t Offset = Rest.find_first_not_of(' ');
+				if (Offset == std::string::npos) {
+					// "-" alone, the item is the block below it.
+					aIndex++;
+					if ((aIndex < aLine.size()) && (aLine[aIndex].Indent > aIndent)) Node.Item.push_back(parse_block(aLine, aIndex, aLine[aIndex].Indent));
+					else Node.Item.push_back(yaml());
+				}
+				else if (find_colon(Rest) != std::string::npos) {
+					// "- Key: Value" opens a mapping whose members continue at the column of Key.
+					Current.Indent = aIndent + 2 + Offset;
+					Current.Text = Rest.substr(Offset);
+					Node.Item.push_back(parse_block(aLine, aIndex, Current.Indent));
+				}
+				else {
+					Node.Item.push_back(parse_inline(trim(Rest), Current));
+					aIndex++;
+				}
+			}
+			return Node;
+		}
+
+		Node.Kind = MAPPING;
+		while ((aIndex < aLine.size()) && (aLine[aIndex].Indent == aIndent)) {
+			const line& Current = aLine[aIndex];
+			if (is_item(Current.Text)) fail(Current, "sequence item inside a mapping");
+			std::size_t Colon = find_colon(Current.Text);
+			if (Colon == std::string::npos) fail(Current, "expected 'key: value'");
+			std::string Key = unquote(trim(Current.Text.substr(0, Colon)), Current);
+			std::string Rest = trim(Current.Text.substr(Colon + 1));
+			aIndex++;
+			if (Rest.size() > 0) {
+				Node.Member.emplace_back(Key, parse_inline(Rest, Current));
+			}
+			else if ((aIndex < aLine.size()) && (aLine[aIndex].Indent > aIndent)) {
+				Node.Member.emplace_back(Key, parse_block(aLine, aIndex, aLine[aIndex].Indent));
+			}
+			else if ((aIndex < aLine.size()) && (aLine[aIndex].Indent == aIndent) && is_item(aLine[aIndex].Text)) {
+				// A sequence may sit at the same indentation as its key.
+				Node.Member.emplace_back(Key, parse_block(aLine, aIndex, aIndent));
+			}
+			else {
+				Node.Member.emplace_back(Key, yaml());
+			}
+		}
+		if ((aIndex < aLine.size()) && (aLine[aIndex].Indent > aIndent)) fail(aLine[aIndex], "unexpected indentation");
+		return Node;
+	}
+
+	inline yaml yaml::parse_inline(const std::string& aText, const line& aLine) {
+		yaml Node;
+		if ((aText.size() > 0) && (aText[0] == '[')) {
+			if (aText.back() != ']') fail(aLine, "unterminated flow sequence");
+			Node.Kind = SEQUENCE;
+			// Split on top-level commas.
+			std::string Inner = aText.substr(1, aText.size() - 2);
+			char Quote = 0;
+			int Depth = 0;
+			std::size_t Start = 0;
+			for (std::size_t i = 0; i <= Inner.size(); i++) {
+				char C = i < Inner.size() ? Inner[i] : ',';
+				if (Quote != 0) { if (C == Quote) Quote = 0; continue; }
+				if ((C == '"') || (C == '\'')) Quote = C;
+				else if (C == '[') Depth++;
+				else if (C == ']') Depth--;
+				else if ((C == ',') && (Depth == 0)) {
+					std::string Element = trim(Inner.substr(Start, i - Start));
+					if (Element.size() > 0) Node.Item.push_back(parse_inline(Element, aLine));
+					Start = i + 1;
+				}
+			}
+			return Node;
+		}
+		if ((aText == "~") || (aText == "null")) return Node;
+		Node.Kind = SCALAR;
+		Node.Value = unquote(aText, aLine);
+		return Node;
+	}
+
+	inline std::string yaml::unquote(const std::string& aText, const line& aLine) {
+		if ((aText.size() == 0) || ((aText[0] != '"') && (aText[0] != '\''))) return aText;
+		char Quote = aText[0];
+		if ((aText.size() < 2) || (aText.back() != Quote)) fail(aLine, "unterminated string");
+		std::string Result;
+		for (std::size_t i = 1; i + 1 < aText.size(); i++) {
+			char C = aText[i];
+			if ((Quote == '"') && (C == '\\') && (i + 2 < aText.size())) {
+				char Next = aText[++i];
+				switch (Next) {
+				case 'n': Result += '\n'; break;
+				case 't': Result += '\t'; break;
+				default: Result += Next; break;
+				}
+			}
+			else if ((Quote == '\'') && (C == '\'') && (i + 2 < aText.size()) && (aText[i + 1] == '\'')) {
+				Result += '\'';
+				i++;
+			}
+			else {
+				Result += C;
+			}
+		}
+		return Result;
+	}
+
+}
+
+#endif // GEODESY_UNIT_TEST_YAML_H
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <iomanip>
+#include <chrono>
 
 // Includes core engine, and base types.
 #include <geodesy/engine.h>
@@ -8,37 +10,112 @@
 
 // Example Application - Unit Test
 #include <geodesy-unit-test/unit_test.h>
+#include <geodesy-unit-test/world_snapshot.h>
+#include <geodesy-unit-test/profiler.h>
 
 // Using entry point for app.
 int main(int aCmdArgCount, char* aCmdArgList[]) {
 
+	// Startup timing, each phase prints the time since the previous one and is recorded
+	// into the profiler trace.
+	geodesy::profiler& Profiler = geodesy::profiler::instance();
+	Profiler.set_thread_name("main");
+	uint64_t PhaseStart = Profiler.now();
+	auto phase_done = [&](const char* aPhase) {
+		uint64_t Now = Profiler.now();
+		Profiler.record("startup", aPhase, nullptr, PhaseStart, Now);
+		std::cout << "[startup] " << std::setw(28) << std::left << aPhase << std::fixed << std::setprecision(3)
+				  << (double)(Now - PhaseStart) * 1e-6 << " ms" << std::endl;
+		PhaseStart = Now;
+	};
+
 	// Process command line arguments into a set for easy lookup.
 	std::set<std::string> CommandLineArguments;
 	for (int i = 0; i < aCmdArgCount; i++) {
 		CommandLineArguments.insert(aCmdArgList[i]);
 	}
+	phase_done("Command line");
+
+	// --trace=<path> writes every recorded scope as Chrome trace JSON on exit, open it in
+	// chrome://tracing or ui.perfetto.dev. Frame time percentiles are printed when the
+	// engine marked frames.
+	std::string TracePath;
+	for (const std::string& Argument : CommandLineArguments) {
+		if (Argument.rfind("--trace=", 0) == 0) TracePath = Argument.substr(8);
+	}
+	auto write_trace = [&]() {
+		geodesy::profiler::frame_stats Stats = Profiler.frame_statistics();
+		if (Stats.Count > 0) {
+			std::cout << "[frame] " << Stats.Count << " frames, mean " << std::fixed << std::setprecision(3) << Stats.Mean
+					  << " ms, p50 " << Stats.P50 << " ms, p90 " << Stats.P90 << " ms, p99 " << Stats.P99 << " ms, max " << Stats.Max << " ms" << std::endl;
+		}
+		if (TracePath.empty()) return;
+		if (Profiler.write_chrome_trace(TracePath)) std::cout << "[trace] " << TracePath << std::endl;
+		else std::cerr << "Error: cannot write trace " << TracePath << std::endl;
+	};
+
+	// Compiles every world listed in the root config into a binary snapshot next to its
+	// YAML (level_01.yaml -> level_01.world), with resolved model metadata. Worlds load from
+	// the snapshot while it matches its YAML and fall back to parsing otherwise.
+	if (CommandLineArguments.count("--compile-worlds") > 0) {
+		try {
+			geodesy::io::yaml Config = geodesy::io::yaml::load("assets/config.yaml");
+			for (std::size_t i = 0; i < Config["Worlds"].size(); i++) {
+				std::string Source = Config["Worlds"][i]["ConfigFile"].as_string();
+				if (!std::filesystem::exists(Source)) {
+					std::cout << "[worlds] skipped " << Source << " (not found)" << std::endl;
+					continue;
+				}
+				std::string Snapshot = geodesy::io::world_snapshot::path_for(Source);
+				geodesy::io::world_snapshot::compile(Source, Snapshot, true);
+				std::cout << "[worlds] " << Source << " -> " << Snapshot << std::endl;
+			}
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			return -1;
+		}
+		phase_done("World snapshots");
+		return 0;
+	}
+
+	// Headless mode runs the CPU only test suites and never touches Vulkan, so it works
+	// on machines without a GPU or driver. Exit code is non-zero if any test failed.
+	if (CommandLineArguments.count("--headless") > 0) {
+		bool Passed = geodesy::unit_test::run_tests(CommandLineArguments);
+		phase_done("Tests");
+		write_trace();
+		return Passed ? 0 : 1;
+	}
 
 	// Pre-Initialization phase, used for setting up engine configuration before the engine is initialized.
 	geodesy::engine::config EngineConfig = geodesy::unit_test::initialize(CommandLineArguments);
+	phase_done("Engine configuration");
 
 	// Initialize all third party libraries needed by the engine.
 	if (!geodesy::engine::initialize()) return -1;
+	phase_done("Third party libraries");
 
 	try {
 		// Initialize Engine
 		geodesy::engine Engine(CommandLineArguments, EngineConfig);
+		phase_done("Engine instance");
 		{
 			// Initialize User App
 			geodesy::unit_test UnitTest(&Engine);
+			phase_done("Device context");
 
-			// Run User App
+			// Run User App. Frame stats need the frame loop to call Profiler.frame_mark().
+			GEODESY_PROFILE_SCOPE("engine", "run");
 			Engine.run(&UnitTest);
 		}
 	}
 	catch (const std::exception& e) {
 		std::cerr << "Error: " << e.what() << std::endl;
+		write_trace();
 		return -1;
 	}
+	write_trace();
 
 	// Terminate all third party libraries.
 	geodesy::engine::terminate();
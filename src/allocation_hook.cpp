@@ -0,0 +1,78 @@
+#include <geodesy-unit-test/allocation.h>
+
+#include <cstdlib>
+#include <new>
+
+// Global operator new/delete replacements for the app and benchmark executables.
+// Every allocation bumps the geodesy::allocation counters so benchmark cases can
+// report allocs/op and test cases their allocation count.
+
+namespace {
+
+	inline void count(std::size_t aSize) {
+		geodesy::allocation::Total.fetch_add(1, std::memory_order_relaxed);
+		geodesy::allocation::Bytes.fetch_add(aSize, std::memory_order_relaxed);
+		geodesy::allocation::Thread++;
+	}
+
+	void* counted_allocate(std::size_t aSize) {
+		count(aSize);
+		void* Pointer = std::malloc(aSize > 0 ? aSize : 1);
+		return Pointer;
+	}
+
+	void* counted_allocate_aligned(std::size_t aSize, std::size_t aAlignment) {
+		count(aSize);
+		aSize = ((aSize + aAlignment - 1) / aAlignment) * aAlignment;
+#if defined(_MSC_VER)
+		return _aligned_malloc(aSize > 0 ? aSize : aAlignment, aAlignment);
+#else
+		return std::aligned_alloc(aAlignment, aSize > 0 ? aSize : aAlignment);
+#endif
+	}
+
+	void counted_free_aligned(void* aPointer) {
+#if defined(_MSC_VER)
+		_aligned_free(aPointer);
+#else
+		std::free(aPointer);
+#endif
+	}
+
+}
+
+void* operator new(std::size_t aSize) {
+	void* Pointer = counted_allocate(aSize);
+	if (Pointer == nullptr) throw std::bad_alloc();
+	return Pointer;
+}
+
+void* operator new[](std::size_t aSize) {
+	void* Pointer = counted_allocate(aSize);
+	if (Pointer == nullptr) throw std::bad_alloc();
+	return Pointer;
+}
+
+void* operator new(std::size_t aSize, const std::nothrow_t&) noexcept { return counted_allocate(aSize); }
+void* operator new[](std::size_t aSize, const std::nothrow_t&) noexcept { return counted_allocate(aSize); }
+
+void* operator new(std::size_t aSize, std::align_val_t aAlignment) {
+	void* Pointer = counted_allocate_aligned(aSize, (std::size_t)aAlignment);
+	if (Pointer == nullptr) throw std::bad_alloc();
+	return Pointer;
+}
+
+void* operator new[](std::size_t aSize, std::align_val_t aAlignment) {
+	void* Pointer = counted_allocate_aligned(aSize, (std::size_t)aAlignment);
+	if (Pointer == nullptr) throw std::bad_alloc();
+	return Pointer;
+}
+
+void operator delete(void* aPointer) noexcept { std::free(aPointer); }
+void operator delete[](void* aPointer) noexcept { std::free(aPointer); }
+void operator delete(void* aPointer, std::size_t) noexcept { std::free(aPointer); }
+void operator delete[](void* aPointer, std::size_t) noexcept { std::free(aPointer); }
+void operator delete(void* aPointer, std::align_val_t) noexcept { counted_free_aligned(aPointer); }
+void operator delete[](void* aPointer, std::align_val_t) noexcept { counted_free_aligned(aPointer); }
+void operator delete(void* aPointer, std::size_t, std::align_val_t) noexcept { counted_free_aligned(aPointer); }
+void operator delete[](void* aPointer, std::size_t, std::align_val_t) noexcept { counted_free_aligned(aPointer); }
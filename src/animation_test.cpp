@@ -0,0 +1,360 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/animation.h>
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Skeletal animation import, keyframe sampling and blended palettes. The reference
+// evaluator below recomputes every node's global transform from the glTF document in
+// double precision, searching keys from scratch, so it shares none of the cached search,
+// SoA blend or joint hierarchy folding of animation_instance.
+
+namespace geodesy {
+
+	namespace {
+
+		// Appends float arrays to one buffer and writes the matching views and accessors.
+		struct document_builder {
+			std::vector<uint8_t> 	Data;
+			std::string 			View;
+			std::string 			Accessor;
+			std::size_t 			Count = 0;
+
+			std::size_t add(const std::vector<float>& aValue, const char* aType, std::size_t aComponents) {
+				std::size_t Offset = Data.size();
+				Data.insert(Data.end(), (const uint8_t*)aValue.data(), (const uint8_t*)(aValue.data() + aValue.size()));
+				View += std::string(Count > 0 ? ",\n" : "") + "    { \"buffer\": 0, \"byteOffset\": " + std::to_string(Offset) + ", \"byteLength\": " + std::to_string(aValue.size() * 4) + " }";
+				Accessor += std::string(Count > 0 ? ",\n" : "") + "    { \"bufferView\": " + std::to_string(Count) + ", \"componentType\": 5126, \"count\": " + std::to_string(aValue.size() / aComponents) + ", \"type\": \"" + aType + "\" }";
+				return Count++;
+			}
+		};
+
+		std::string base64(const std::vector<uint8_t>& aData) {
+			const char* Alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			std::string Text;
+			for (std::size_t i = 0; i < aData.size(); i += 3) {
+				uint32_t Block = (uint32_t)aData[i] << 16;
+				if (i + 1 < aData.size()) Block |= (uint32_t)aData[i + 1] << 8;
+				if (i + 2 < aData.size()) Block |= aData[i + 2];
+				Text += Alphabet[(Block >> 18) & 63];
+				Text += Alphabet[(Block >> 12) & 63];
+				Text += (i + 1 < aData.size()) ? Alphabet[(Block >> 6) & 63] : '=';
+				Text += (i + 2 < aData.size()) ? Alphabet[Block & 63] : '=';
+			}
+			return Text;
+		}
+
+		// Armature (matrix) -> Hip -> { Spacer (scale 2) -> Spine, Leg }. The skin lists the
+		// joints child first. Walk animates all three joints with a rotation that crosses
+		// hemispheres between keys, Wave uses cubic splines and also targets the armature,
+		// which is not a joint and is dropped.
+		std::string rig_document() {
+			document_builder B;
+			std::size_t IBM = B.add({
+				1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, -1.5f, 0, 1,
+				1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, -0.5f, 0, 1,
+				0.5f, 0, 0, 0,  0, 0.5f, 0, 0,  0, 0, 0.5f, 0,  0.2f, 0.3f, 0, 1,
+			}, "MAT4", 16);
+			std::size_t WalkTime = B.add({ 0.0f, 0.25f, 0.5f, 0.75f, 1.0f }, "SCALAR", 1);
+			std::size_t HipMove = B.add({ 0, 0.5f, 0,  0.1f, 0.6f, 0,  0.2f, 0.5f, 0,  0.1f, 0.4f, 0,  0, 0.5f, 0 }, "VEC3", 3);
+			std::size_t SpineTime = B.add({ 0.0f, 0.4f, 0.8f, 1.2f }, "SCALAR", 1);
+			std::size_t SpineTurn = B.add({
+				0, 0, 0, 1,
+				0, 0, 0.3826834f, 0.9238795f,
+				0, 0, -0.7071068f, -0.7071068f, 		// Same hemisphere as +90 deg only after a sign flip.
+				0, 0.1f, 0, 0.9949874f,
+			}, "VEC4", 4);
+			std::size_t LegScale = B.add({ 1, 1, 1,  1.2f, 0.8f, 1,  1, 1, 1 }, "VEC3", 3);
+			std::size_t LegTime = B.add({ 0.0f, 0.3f, 0.9f }, "SCALAR", 1);
+			std::size_t WaveTime = B.add({ 0.0f, 0.5f, 1.5f }, "SCALAR", 1);
+			std::size_t WaveSpine = B.add({
+				0, 0, 0, 0,  0, 0, 0, 1,  0, 0, 0.5f, 0,
+				0.2f, 0, 0, 0,  0.2588190f, 0, 0, 0.9659258f,  0, 0, 0, 0,
+				0, 0, 0, 0,  0, 0.4472136f, 0, 0.8944272f,  0, 0, 0, 0,
+			}, "VEC4", 4);
+			std::size_t WaveLeg = B.add({ 0, 0, 0, 1,  0.3826834f, 0, 0, 0.9238795f,  0, 0, 0, 1 }, "VEC4", 4);
+			std::size_t WaveArmature = B.add({ 0, 0, 0,  0, 1, 0,  0, 0, 0 }, "VEC3", 3);
+			return std::string("{\n") +
+				"  \"asset\": { \"version\": \"2.0\" },\n"
+				"  \"nodes\": [\n"
+				"    { \"name\": \"Armature\", \"matrix\": [ 0, 1, 0, 0,  -1, 0, 0, 0,  0, 0, 1, 0,  1, 2, 3, 1 ], \"children\": [ 1 ] },\n"
+				"    { \"name\": \"Hip\", \"translation\": [ 0, 0.5, 0 ], \"children\": [ 2, 4 ] },\n"
+				"    { \"name\": \"Spacer\", \"scale\": [ 2, 2, 2 ], \"children\": [ 3 ] },\n"
+				"    { \"name\": \"Spine\", \"translation\": [ 0, 0.5, 0 ], \"rotation\": [ 0, 0, 0.1736482, 0.9848078 ] },\n"
+				"    { \"name\": \"Leg\", \"translation\": [ 0.2, -0.5, 0 ] },\n"
+				"    { \"name\": \"Body\", \"mesh\": 0, \"skin\": 0 }\n"
+				"  ],\n"
+				"  \"skins\": [ { \"joints\": [ 3, 1, 4 ], \"inverseBindMatrices\": " + std::to_string(IBM) + " } ],\n"
+				"  \"animations\": [\n"
+				"    { \"name\": \"Walk\", \"samplers\": [\n"
+				"        { \"input\": " + std::to_string(WalkTime) + ", \"output\": " + std::to_string(HipMove) + " },\n"
+				"        { \"input\": " + std::to_string(SpineTime) + ", \"output\": " + std::to_string(SpineTurn) + ", \"interpolation\": \"LINEAR\" },\n"
+				"        { \"input\": " + std::to_string(LegTime) + ", \"output\": " + std::to_string(LegScale) + ", \"interpolation\": \"STEP\" }\n"
+				"      ], \"channels\": [\n"
+				"        { \"sampler\": 0, \"target\": { \"node\": 1, \"path\": \"translation\" } },\n"
+				"        { \"sampler\": 1, \"target\": { \"node\": 3, \"path\": \"rotation\" } },\n"
+				"        { \"sampler\": 2, \"target\": { \"node\": 4, \"path\": \"scale\" } }\n"
+				"      ] },\n"
+				"    { \"name\": \"Wave\", \"samplers\": [\n"
+				"        { \"input\": " + std::to_string(WaveTime) + ", \"output\": " + std::to_string(WaveSpine) + ", \"interpolation\": \"CUBICSPLINE\" },\n"
+				"        { \"input\": " + std::to_string(LegTime) + ", \"output\": " + std::to_string(WaveLeg) + " },\n"
+				"        { \"input\": " + std::to_string(LegTime) + ", \"output\": " + std::to_string(WaveArmature) + " }\n"
+				"      ], \"channels\": [\n"
+				"        { \"sampler\": 0, \"target\": { \"node\": 3, \"path\": \"rotation\" } },\n"
+				"        { \"sampler\": 1, \"target\": { \"node\": 4, \"path\": \"rotation\" } },\n"
+				"        { \"sampler\": 2, \"target\": { \"node\": 0, \"path\": \"translation\" } }\n"
+				"      ] }\n"
+				"  ],\n"
+				"  \"meshes\": [ { \"primitives\": [ { \"attributes\": { \"POSITION\": 0 } } ] } ],\n"
+				"  \"buffers\": [ { \"uri\": \"data:application/octet-stream;base64," + base64(B.Data) + "\", \"byteLength\": " + std::to_string(B.Data.size()) + " } ],\n"
+				"  \"bufferViews\": [\n" + B.View + "\n  ],\n"
+				"  \"accessors\": [\n" + B.Accessor + "\n  ]\n"
+				"}\n";
+		}
+
+		io::gltf load_rig(const std::string& aName) {
+			test::scratch Scratch("animation-test-" + aName);
+			const std::filesystem::path& Directory = Scratch.path();
+			std::filesystem::path Path = Directory / "rig.gltf";
+			std::ofstream(Path, std::ios::binary | std::ios::trunc) << rig_document();
+			io::gltf Model = io::gltf::load(Path.string());
+			return Model;
+		}
+
+		// ---------- reference ---------- //
+
+		using dmat = std::array<double, 16>; 		// Column-major 4x4.
+
+		dmat multiply(const dmat& aA, const dmat& aB) {
+			dmat C{};
+			for (int c = 0; c < 4; c++) {
+				for (int r = 0; r < 4; r++) {
+					for (int k = 0; k < 4; k++) C[4 * c + r] += aA[4 * k + r] * aB[4 * c + k];
+				}
+			}
+			return C;
+		}
+
+		dmat trs(const double* aT, const double* aR, const double* aS) {
+			double X = aR[0], Y = aR[1], Z = aR[2], W = aR[3];
+			return {
+				(1 - 2 * (Y * Y + Z * Z)) * aS[0], 2 * (X * Y + Z * W) * aS[0], 2 * (X * Z - Y * W) * aS[0], 0,
+				2 * (X * Y - Z * W) * aS[1], (1 - 2 * (X * X + Z * Z)) * aS[1], 2 * (Y * Z + X * W) * aS[1], 0,
+				2 * (X * Z + Y * W) * aS[2], 2 * (Y * Z - X * W) * aS[2], (1 - 2 * (X * X + Y * Y)) * aS[2], 0,
+				aT[0], aT[1], aT[2], 1
+			};
+		}
+
+		void normalize(double* aQ) {
+			double Length = std::sqrt(aQ[0] * aQ[0] + aQ[1] * aQ[1] + aQ[2] * aQ[2] + aQ[3] * aQ[3]);
+			for (int i = 0; i < 4; i++) aQ[i] /= Length;
+		}
+
+		// Channel value at aTime, keys searched from scratch.
+		void reference_sample(const animation_clip::channel& aChannel, double aTime, double* aOut) {
+			std::size_t N = aChannel.Path == animation_clip::ROTATION ? 4 : 3;
+			bool Cubic = aChannel.Interpolation == animation_clip::CUBICSPLINE;
+			std::size_t Width = Cubic ? 3 * N : N;
+			const std::vector<float>& T = aChannel.Time;
+			auto value = [&](std::size_t aKey, std::size_t aPart, std::size_t aComponent) { return (double)aChannel.Value[aKey * Width + aPart * N + aComponent]; };
+			if (aTime <= T.front() || T.size() == 1) { for (std::size_t i = 0; i < N; i++) aOut[i] = value(0, Cubic ? 1 : 0, i); return; }
+			if (aTime >= T.back()) { for (std::size_t i = 0; i < N; i++) aOut[i] = value(T.size() - 1, Cubic ? 1 : 0, i); return; }
+			std::size_t K = 0;
+			while (T[K + 1] <= aTime) K++;
+			double Span = T[K + 1] - T[K], U = (aTime - T[K]) / Span;
+			if (aChannel.Interpolation == animation_clip::STEP) {
+				for (std::size_t i = 0; i < N; i++) aOut[i] = value(K, 0, i);
+			}
+			else if (Cubic) {
+				double U2 = U * U, U3 = U2 * U;
+				for (std::size_t i = 0; i < N; i++) {
+					aOut[i] = (2 * U3 - 3 * U2 + 1) * value(K, 1, i) + (U3 - 2 * U2 + U) * Span * value(K, 2, i)
+							+ (-2 * U3 + 3 * U2) * value(K + 1, 1, i) + (U3 - U2) * Span * value(K + 1, 0, i);
+				}
+				if (N == 4) normalize(aOut);
+			}
+			else if (N == 4) {
+				double A[4], B[4], Dot = 0;
+				for (int i = 0; i < 4; i++) { A[i] = value(K, 0, i); B[i] = value(K + 1, 0, i); Dot += A[i] * B[i]; }
+				if (Dot < 0) { for (int i = 0; i < 4; i++) B[i] = -B[i]; Dot = -Dot; }
+				double WA = 1 - U, WB = U;
+				if (Dot < 0.9995) {
+					double Angle = std::acos(Dot);
+					WA = std::sin((1 - U) * Angle) / std::sin(Angle);
+					WB = std::sin(U * Angle) / std::sin(Angle);
+				}
+				for (int i = 0; i < 4; i++) aOut[i] = WA * A[i] + WB * B[i];
+				normalize(aOut);
+			}
+			else {
+				for (std::size_t i = 0; i < N; i++) aOut[i] = value(K, 0, i) + (value(K + 1, 0, i) - value(K, 0, i)) * U;
+			}
+		}
+
+		// Palette from the document's node hierarchy with the weighted clips applied.
+		std::vector<double> reference_palette(const io::gltf& aModel, const animated_model& aRig, const std::vector<float>& aWeight, double aTime) {
+			const io::json& Nodes = aModel.Document["nodes"];
+			std::size_t NodeCount = Nodes.size();
+			// Rest TRS of every node, the armature's matrix is kept as a matrix.
+			std::vector<std::array<double, 10>> Rest(NodeCount);
+			for (std::size_t n = 0; n < NodeCount; n++) {
+				for (std::size_t i = 0; i < 3; i++) Rest[n][i] = Nodes[n]["translation"][i].as_double(0.0);
+				for (std::size_t i = 0; i < 4; i++) Rest[n][3 + i] = Nodes[n]["rotation"][i].as_double(i == 3 ? 1.0 : 0.0);
+				for (std::size_t i = 0; i < 3; i++) Rest[n][7 + i] = Nodes[n]["scale"][i].as_double(1.0);
+			}
+			// Blend per joint node.
+			std::vector<std::array<double, 10>> Sum(NodeCount);
+			double WeightSum = 0;
+			for (std::size_t c = 0; c < aRig.Clip.size(); c++) {
+				if (aWeight[c] <= 0.0f) continue;
+				const animation_clip& Clip = aRig.Clip[c];
+				double T = std::fmod(aTime, (double)Clip.Duration);
+				std::vector<std::array<double, 10>> Pose = Rest;
+				for (const animation_clip::channel& Channel : Clip.Channel) {
+					std::size_t Node = aRig.Skeleton.Node[Channel.Joint];
+					std::size_t Base = Channel.Path == animation_clip::TRANSLATION ? 0 : (Channel.Path == animation_clip::ROTATION ? 3 : 7);
+					reference_sample(Channel, T, &Pose[Node][Base]);
+				}
+				for (std::size_t n = 0; n < NodeCount; n++) {
+					double Dot = 0;
+					for (int i = 3; i < 7; i++) Dot += Sum[n][i] * Pose[n][i];
+					double Sign = (WeightSum > 0 && Dot <= 0) ? -1.0 : 1.0;
+					for (int i = 0; i < 10; i++) Sum[n][i] += aWeight[c] * ((i >= 3 && i < 7) ? Sign : 1.0) * Pose[n][i];
+				}
+				WeightSum += aWeight[c];
+			}
+			std::vector<dmat> Local(NodeCount);
+			for (std::size_t n = 0; n < NodeCount; n++) {
+				std::array<double, 10> P = Rest[n];
+				bool IsJoint = std::find(aRig.Skeleton.Node.begin(), aRig.Skeleton.Node.end(), n) != aRig.Skeleton.Node.end();
+				if ((WeightSum > 0) && IsJoint) {
+					for (int i = 0; i < 10; i++) P[i] = Sum[n][i] / WeightSum;
+					normalize(&P[3]);
+				}
+				Local[n] = trs(&P[0], &P[3], &P[7]);
+				if (Nodes[n].has("matrix")) for (std::size_t i = 0; i < 16; i++) Local[n][i] = Nodes[n]["matrix"][i].as_double();
+			}
+			std::vector<int> Parent(NodeCount, -1);
+			for (std::size_t n = 0; n < NodeCount; n++) {
+				for (std::size_t c = 0; c < Nodes[n]["children"].size(); c++) Parent[Nodes[n]["children"][c].as_index()] = (int)n;
+			}
+			std::vector<double> Palette;
+			for (std::size_t j = 0; j < aRig.Skeleton.size(); j++) {
+				dmat Global = Local[aRig.Skeleton.Node[j]];
+				for (int P = Parent[aRig.Skeleton.Node[j]]; P >= 0; P = Parent[P]) Global = multiply(Local[P], Global);
+				dmat IB;
+				for (int i = 0; i < 16; i++) IB[i] = aRig.Skeleton.InverseBind[16 * j + i];
+				dmat Skin = multiply(Global, IB);
+				Palette.insert(Palette.end(), Skin.begin(), Skin.end());
+			}
+			return Palette;
+		}
+
+		double max_difference(const float* aPalette, const std::vector<double>& aReference) {
+			double Difference = 0;
+			for (std::size_t i = 0; i < aReference.size(); i++) Difference = std::max(Difference, std::abs((double)aPalette[i] - aReference[i]));
+			return Difference;
+		}
+
+		void register_animation(test& aTest) {
+			aTest.add("gltf", [](test::context& aContext) {
+				io::gltf Model = load_rig("gltf");
+				animated_model Rig = animated_model::from_gltf(Model);
+				const skeleton& S = Rig.Skeleton;
+				aContext.check("Joints in skin order", (S.size() == 3) && (S.Name[0] == "Spine") && (S.Name[1] == "Hip") && (S.Name[2] == "Leg"));
+				aContext.check("Parents skip non-joint nodes", (S.Parent[0] == 1) && (S.Parent[1] == -1) && (S.Parent[2] == 1));
+				aContext.check("Parents first", (S.Order.size() == 3) && (S.Order[0] == 1));
+				aContext.check("Spacer folded into the offset", (S.Offset[0] == 2.0f) && (S.Offset[4] == 2.0f) && (S.Offset[9] == 0.0f));
+				// The armature matrix rotates 90 degrees about z and moves by (1, 2, 3).
+				const float* Root = &S.Offset[12];
+				aContext.check("Root offset from the armature matrix", (std::abs(Root[0]) < 1e-6f) && (std::abs(Root[1] - 1.0f) < 1e-6f) && (std::abs(Root[3] + 1.0f) < 1e-6f) && (Root[9] == 1.0f) && (Root[11] == 3.0f));
+				aContext.check("Inverse bind matrices", (S.InverseBind[16 * 2] == 0.5f) && (S.InverseBind[16 * 2 + 12] == 0.2f));
+				aContext.check("Clips", (Rig.Clip.size() == 2) && (Rig.Clip[0].Name == "Walk") && (Rig.Clip[0].Channel.size() == 3) && (Rig.Clip[0].Duration == 1.2f));
+				aContext.check("Non-joint targets dropped", (Rig.Clip[1].Channel.size() == 2) && (Rig.Clip[1].Channel[0].Interpolation == animation_clip::CUBICSPLINE) && (Rig.Clip[1].Duration == 1.5f));
+			});
+
+			aTest.add("sample", [](test::context& aContext) {
+				io::gltf Model = load_rig("sample");
+				animated_model Rig = animated_model::from_gltf(Model);
+				const animation_clip& Walk = Rig.Clip[0];
+				// Forward playback with the cached key against a fresh search at every step.
+				bool Same = true;
+				uint32_t Hint = 0;
+				for (int Step = 0; Step <= 200; Step++) {
+					float T = -0.1f + (float)Step * 0.0071f;
+					float Cached[3], Fresh[3];
+					uint32_t Cold = 0;
+					Walk.sample(0, T, Hint, Cached);
+					Walk.sample(0, T, Cold, Fresh);
+					Same = Same && (std::memcmp(Cached, Fresh, sizeof(Cached)) == 0);
+				}
+				aContext.check("Cached key matches a fresh search", Same);
+				float Value[4];
+				Hint = 3;
+				Walk.sample(0, 0.3f, Hint, Value);
+				aContext.check("Backward jump", (Hint == 1) && (std::abs(Value[0] - 0.12f) < 1e-6f) && (std::abs(Value[1] - 0.58f) < 1e-6f));
+				Walk.sample(0, 5.0f, Hint, Value);
+				aContext.check("Clamped after the last key", (Value[0] == 0.0f) && (Value[1] == 0.5f));
+				Walk.sample(2, 0.5f, Hint = 0, Value);
+				aContext.check("Step holds the previous key", (Value[0] == 1.2f) && (Value[1] == 0.8f));
+				// Keys 1 and 2 are 135 degrees apart once the sign of key 2 is flipped.
+				Walk.sample(1, 0.6f, Hint = 0, Value);
+				float Angle = 2.0f * std::atan2(Value[2], Value[3]);
+				aContext.check("Slerp takes the short way", std::abs(Angle - (0.7853982f + 1.5707963f) * 0.5f) < 1e-4f);
+				Rig.Clip[1].sample(0, 0.5f, Hint = 0, Value);
+				aContext.check("Cubic spline passes through its keys", std::abs(Value[0] - 0.2588190f) < 1e-6f && std::abs(Value[3] - 0.9659258f) < 1e-6f);
+			});
+
+			aTest.add("reference", [](test::context& aContext) {
+				io::gltf Model = load_rig("reference");
+				animated_model Rig = animated_model::from_gltf(Model);
+				animation_instance Instance(&Rig);
+				aContext.check("Default weights play the first clip", (Instance.Weight.size() == 2) && (Instance.Weight[0] == 1.0f) && (Instance.joint_count() == 3));
+				const std::vector<std::vector<float>> WeightList = { { 1, 0 }, { 0, 1 }, { 0.3f, 0.7f }, { 2, 2 }, { 0, 0 } };
+				const char* Name[] = { "Walk only", "Wave only", "Blend", "Unnormalized weights", "Rest pose" };
+				for (std::size_t w = 0; w < WeightList.size(); w++) {
+					Instance.Weight = WeightList[w];
+					double Worst = 0;
+					// Forward playback over several loops, then scrubbing back and forth.
+					for (int Step = 0; Step < 300; Step++) {
+						double T = Step < 200 ? Step * (1.0 / 60.0) : std::fmod(Step * 0.37, 4.0);
+						Instance.Time = (float)T;
+						Instance.evaluate();
+						Worst = std::max(Worst, max_difference(Instance.palette(), reference_palette(Model, Rig, WeightList[w], (double)(float)T)));
+					}
+					aContext.check(std::string(Name[w]) + " matches the reference", Worst < 2e-5);
+				}
+			});
+
+			aTest.add("parallel", [](test::context& aContext) {
+				io::gltf Model = load_rig("parallel");
+				animated_model Rig = animated_model::from_gltf(Model);
+				std::vector<animation_instance> Serial, Parallel;
+				for (std::size_t i = 0; i < 100; i++) {
+					animation_instance Instance(&Rig);
+					Instance.Weight = { (float)(i % 3), (float)(i % 2) };
+					Instance.Time = 0.013f * (float)i;
+					Serial.push_back(Instance);
+					Parallel.push_back(Instance);
+				}
+				job_system Jobs(4);
+				bool Same = true;
+				for (int Frame = 0; Frame < 10; Frame++) {
+					for (animation_instance& I : Serial) { I.Time += 1.0f / 60.0f; I.evaluate(); }
+					for (animation_instance& I : Parallel) I.Time += 1.0f / 60.0f;
+					evaluate(Jobs, Parallel, 7);
+					for (std::size_t i = 0; i < Serial.size(); i++) Same = Same && (std::memcmp(Serial[i].palette(), Parallel[i].palette(), 16 * 3 * sizeof(float)) == 0);
+				}
+				aContext.check("Parallel matches serial", Same);
+			});
+		}
+
+		test::suite AnimationSuite("animation", register_animation);
+
+	}
+
+}
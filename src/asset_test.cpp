@@ -0,0 +1,123 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/asset_cache.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+// Model cache sharing and instance batching.
+
+namespace geodesy {
+
+	namespace {
+
+		struct mesh {
+			std::string 		Path;
+			std::vector<float> 	Vertex;
+		};
+
+		io::object_description object(const std::string& aName, const std::string& aModelPath, float aX) {
+			io::object_description Object{};
+			Object.Name 		= aName;
+			Object.Type 		= "object";
+			Object.ModelPath 	= aModelPath;
+			Object.Position 	= { aX, 0.0f, 0.0f };
+			Object.Scale 		= { 1.0f, 1.0f, 1.0f };
+			return Object;
+		}
+
+		void register_asset(test& aTest) {
+			aTest.add("cache", [](test::context& aContext) {
+				io::asset_cache<mesh> Cache([](const std::string& aPath) {
+					return std::make_shared<mesh>(mesh{ aPath, std::vector<float>(64, 1.0f) });
+				});
+				std::shared_ptr<mesh> A = Cache.acquire("models/box/box.gltf");
+				std::shared_ptr<mesh> B = Cache.acquire("models/./box/box.gltf");
+				std::shared_ptr<mesh> C = Cache.acquire("models/cube/../box/box.gltf");
+				std::shared_ptr<mesh> D = Cache.acquire("models/cube/cube.gltf");
+				aContext.check("Same path shares one copy", (A == B) && (B == C));
+				aContext.check("Different path loads separately", A != D);
+				aContext.check("One load per unique path", (Cache.load_count() == 2) && (Cache.hit_count() == 2) && (Cache.size() == 2));
+				aContext.check("Find does not load", (Cache.find("models/box/box.gltf") == A) && (Cache.find("models/none.gltf") == nullptr));
+
+				// Released assets are dropped and reloaded on demand.
+				D.reset();
+				aContext.check("Released asset expires", (Cache.size() == 1) && (Cache.find("models/cube/cube.gltf") == nullptr));
+				Cache.purge();
+				D = Cache.acquire("models/cube/cube.gltf");
+				aContext.check("Released asset reloads", (D != nullptr) && (Cache.load_count() == 3));
+			});
+
+			aTest.add("cache_failure", [](test::context& aContext) {
+				int Attempt = 0;
+				io::asset_cache<mesh> Cache([&](const std::string& aPath) {
+					if (Attempt++ == 0) throw std::runtime_error("missing " + aPath);
+					return std::make_shared<mesh>(mesh{ aPath, {} });
+				});
+				bool Threw = false;
+				try { Cache.acquire("models/box.gltf"); }
+				catch (const std::runtime_error&) { Threw = true; }
+				aContext.check("Loader error propagates", Threw && (Cache.size() == 0));
+				aContext.check("Failed path retried", Cache.acquire("models/box.gltf") != nullptr);
+			});
+
+			aTest.add("cache_concurrent", [](test::context& aContext) {
+				std::atomic<int> LoadCount{ 0 };
+				io::asset_cache<mesh> Cache([&](const std::string& aPath) {
+					LoadCount++;
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+					return std::make_shared<mesh>(mesh{ aPath, {} });
+				});
+				std::vector<std::shared_ptr<mesh>> Result(8);
+				std::vector<std::thread> Worker;
+				for (std::size_t t = 0; t < Result.size(); t++) {
+					Worker.emplace_back([&, t]() { Result[t] = Cache.acquire("models/sponza.gltf"); });
+				}
+				for (std::thread& Thread : Worker) Thread.join();
+				bool Shared = true;
+				for (const std::shared_ptr<mesh>& M : Result) Shared &= (M != nullptr) && (M == Result[0]);
+				aContext.check("Concurrent acquires load once", LoadCount == 1);
+				aContext.check("Concurrent acquires share result", Shared);
+			});
+
+			aTest.add("instancing", [](test::context& aContext) {
+				// Repeated models of level_01.yaml.
+				io::world_description World;
+				World.Object.push_back(object("Camera3D", "models/camera.gltf", 0.0f));
+				World.Object[0].IsSubject = true;
+				World.Object.push_back(object("BoxTextured", "models/BoxTextured.gltf", 2.0f));
+				World.Object.push_back(object("BoxTextured2", "models/BoxTextured.gltf", 4.0f));
+				World.Object.push_back(object("Cube", "models/Cube.gltf", 0.0f));
+				World.Object.push_back(object("Cube2", "models/Cube.gltf", 0.0f));
+				World.Object.push_back(object("BoxWithVertexColors", "models/./BoxTextured.gltf", 0.0f));
+				World.Object.push_back(object("CesiumMan", "models/CesiumMan.gltf", -2.0f));
+				World.Object.push_back(object("CesiumMan2", "models/CesiumMan.gltf", 2.0f));
+				World.Object.push_back(object("CesiumMan3", "models/CesiumMan.gltf", 4.0f));
+				World.Object[6].AnimationWeights = { 0.0f, 1.0f };
+				World.Object[7].AnimationWeights = { 1.0f, 0.0f };
+				World.Object[8].AnimationWeights = { 0.0f, 1.0f };
+
+				std::size_t LoadCount = 0;
+				io::asset_cache<mesh> Cache([&](const std::string& aPath) {
+					LoadCount++;
+					return std::make_shared<mesh>(mesh{ aPath, {} });
+				});
+				std::vector<io::instance_batch<mesh>> Batch = io::build_instance_batches(World, Cache);
+				aContext.check("Batch count", Batch.size() == 4);
+				aContext.check("Loads scale with unique models", LoadCount == 3);
+				aContext.check("Boxes batched", (Batch.size() > 0) && (Batch[0].Instance.size() == 3) && (Batch[0].Object == std::vector<std::size_t>{ 1, 2, 5 }));
+				aContext.check("Instance transforms", (Batch.size() > 0) && (Batch[0].Instance[1].Position[0] == 4.0f) && (Batch[0].Instance[1].Scale[2] == 1.0f));
+				aContext.check("Cubes batched", (Batch.size() > 1) && (Batch[1].Instance.size() == 2));
+				aContext.check("Animation weights split batches", (Batch.size() > 3) && (Batch[2].Object == std::vector<std::size_t>{ 6, 8 }) && (Batch[3].Object == std::vector<std::size_t>{ 7 }));
+				aContext.check("Split batches share model", (Batch.size() > 3) && (Batch[2].Model == Batch[3].Model));
+			});
+		}
+
+		test::suite AssetSuite("asset", register_asset);
+
+	}
+
+}
@@ -0,0 +1,179 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/scene_bvh.h>
+#include <geodesy-unit-test/transform_hierarchy.h>
+
+#include <cmath>
+#include <random>
+
+// Frustum culling over the scene BVH, checked against testing every box on its own, and
+// the bounds helpers it is fed from.
+
+namespace geodesy {
+
+	namespace {
+
+		using mat4 = math::mat<float, 4, 4>;
+
+		aabb random_box(std::mt19937& aRandom) {
+			std::uniform_real_distribution<float> Spread(-200.0f, 200.0f), Size(0.1f, 4.0f);
+			math::vec<float, 3> Center = { Spread(aRandom), Spread(aRandom), 0.1f * Spread(aRandom) };
+			float S = Size(aRandom);
+			return { { Center[0] - S, Center[1] - S, Center[2] - S }, { Center[0] + S, Center[1] + S, Center[2] + S } };
+		}
+
+		// Ids of the live boxes intersecting the frustum, tested one at a time.
+		std::vector<scene_bvh::id> brute_force(const std::vector<aabb>& aBox, const std::vector<uint8_t>& aAlive, const frustum& aFrustum) {
+			std::vector<scene_bvh::id> Visible;
+			for (scene_bvh::id i = 0; i < aBox.size(); i++) if (aAlive[i] && aFrustum.intersects(aBox[i])) Visible.push_back(i);
+			return Visible;
+		}
+
+		bool same_set(std::vector<scene_bvh::id> aA, const std::vector<scene_bvh::id>& aB) {
+			std::sort(aA.begin(), aA.end());
+			return aA == aB;
+		}
+
+		frustum level_camera(float aYaw) {
+			// level_01's Camera3D, FOV 70, Near 1, Far 2000, looking along +y and turning.
+			mat4 View = math::simd::inverse(object_transform({ 0.0f, -5.0f, 2.0f }, { aYaw, 90.0f }, { 1.0f, 1.0f, 1.0f }));
+			return frustum::from_camera(View, 70.0f, 16.0f / 9.0f, 1.0f, 2000.0f);
+		}
+
+		void register_bvh(test& aTest) {
+			aTest.add("frustum", [](test::context& aContext) {
+				frustum Frustum = frustum::from_camera(math::simd::inverse(object_transform({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f })), 90.0f, 1.0f, 1.0f, 100.0f);
+				auto box = [](float aX, float aY, float aZ, float aSize) { return aabb{ { aX - aSize, aY - aSize, aZ - aSize }, { aX + aSize, aY + aSize, aZ + aSize } }; };
+				aContext.check("In front", Frustum.intersects(box(0.0f, 0.0f, -10.0f, 0.5f)) && Frustum.intersects(box(9.0f, -9.0f, -10.0f, 0.5f)));
+				aContext.check("Behind, beyond and beside", !Frustum.intersects(box(0.0f, 0.0f, 10.0f, 0.5f)) && !Frustum.intersects(box(0.0f, 0.0f, -200.0f, 0.5f)) && !Frustum.intersects(box(12.0f, 0.0f, -10.0f, 0.5f)) && !Frustum.intersects(box(0.0f, 0.0f, -0.2f, 0.5f)));
+				aContext.check("Straddling the near plane", Frustum.intersects(box(0.0f, 0.0f, -1.0f, 0.5f)));
+				// Unit normals, so plane values are distances.
+				aContext.check("Near plane distance", std::abs(Frustum.Plane[4][2] * -3.0f + Frustum.Plane[4][3] - 2.0f) < 1e-4f);
+
+				// Any box with a corner inside clip space intersects.
+				mat4 Projection = math::constant::perspective(70.0f * math::constant::Pi<float> / 180.0f, 16.0f / 9.0f, 1.0f, 2000.0f);
+				mat4 View = math::simd::inverse(object_transform({ 0.0f, -5.0f, 2.0f }, { 20.0f, 90.0f }, { 1.0f, 1.0f, 1.0f }));
+				mat4 ViewProjection = math::simd::mul(Projection, View);
+				frustum Camera = frustum::from_matrix(ViewProjection);
+				std::mt19937 Random(23);
+				bool Conservative = true;
+				std::size_t Inside = 0;
+				for (int i = 0; i < 20000; i++) {
+					aabb Box = random_box(Random);
+					bool Corner = false;
+					for (int c = 0; c < 8; c++) {
+						math::vec<float, 4> P = math::simd::mul(ViewProjection, math::vec<float, 4>(c & 1 ? Box.Max[0] : Box.Min[0], c & 2 ? Box.Max[1] : Box.Min[1], c & 4 ? Box.Max[2] : Box.Min[2], 1.0f));
+						Corner = Corner || ((std::abs(P[0]) <= P[3]) && (std::abs(P[1]) <= P[3]) && (P[2] >= 0.0f) && (P[2] <= P[3]));
+					}
+					Inside += Corner ? 1 : 0;
+					Conservative = Conservative && (!Corner || Camera.intersects(Box));
+				}
+				aContext.check("Boxes with a visible corner kept", (Inside > 100) && Conservative);
+			});
+
+			aTest.add("cull", [](test::context& aContext) {
+				std::mt19937 Random(24);
+				scene_bvh Tree;
+				std::vector<aabb> Box;
+				for (int i = 0; i < 20000; i++) {
+					Box.push_back(random_box(Random));
+					Tree.add(Box.back());
+				}
+				std::vector<uint8_t> Alive(Box.size(), 1);
+				std::vector<scene_bvh::id> Visible;
+				bool Match = true;
+				for (float Yaw = 0.0f; Yaw < 360.0f; Yaw += 45.0f) {
+					frustum Frustum = level_camera(Yaw);
+					Tree.cull(Frustum, Visible);
+					Match = Match && same_set(Visible, brute_force(Box, Alive, Frustum));
+				}
+				aContext.check("Same boxes as testing each", Match);
+				aContext.check("Counts", (Tree.stats().Visible == Visible.size()) && (Tree.stats().Visible + Tree.stats().Culled == 20000) && (Tree.stats().Visible > 0) && (Tree.stats().Culled > 0));
+				aContext.check("Shallow tree", (Tree.node_count() < 20000 / 3) && (Tree.stats().NodeTests < Tree.node_count()));
+
+				// Everything in view: the root is inside and no node below it is tested.
+				scene_bvh Ahead;
+				for (int i = 0; i < 1000; i++) Ahead.add({ { (float)(i % 10), 100.0f + (float)(i / 10), 0.0f }, { (float)(i % 10) + 0.5f, 100.5f + (float)(i / 10), 0.5f } });
+				Ahead.cull(level_camera(0.0f), Visible);
+				aContext.check("Whole subtrees emitted", (Visible.size() == 1000) && (Ahead.stats().NodeTests == 1));
+			});
+
+			aTest.add("refit", [](test::context& aContext) {
+				std::mt19937 Random(25);
+				scene_bvh Tree;
+				std::vector<aabb> Box;
+				for (int i = 0; i < 5000; i++) {
+					Box.push_back(random_box(Random));
+					Tree.add(Box.back());
+				}
+				std::vector<uint8_t> Alive(Box.size(), 1);
+				std::vector<scene_bvh::id> Visible;
+				frustum Frustum = level_camera(30.0f);
+				Tree.cull(Frustum, Visible);
+				std::size_t Nodes = Tree.node_count();
+				bool Match = true;
+				for (int Frame = 0; Frame < 20; Frame++) {
+					// A tenth of the boxes move, some of them far, or only a few.
+					for (int m = 0; m < (Frame % 2 == 0 ? 500 : 5); m++) {
+						scene_bvh::id Item = (scene_bvh::id)(Random() % Box.size());
+						Box[Item] = random_box(Random);
+						Tree.set_bounds(Item, Box[Item]);
+					}
+					Tree.cull(Frustum, Visible);
+					Match = Match && same_set(Visible, brute_force(Box, Alive, Frustum));
+				}
+				aContext.check("Refit after moves", Match && (Tree.node_count() == Nodes));
+
+				// Removed boxes disappear and their ids are reused.
+				for (scene_bvh::id i = 0; i < Box.size(); i += 3) {
+					Tree.remove(i);
+					Alive[i] = 0;
+				}
+				Tree.cull(Frustum, Visible);
+				bool Removed = same_set(Visible, brute_force(Box, Alive, Frustum)) && (Tree.size() == Box.size() - (Box.size() + 2) / 3);
+				scene_bvh::id Reused = Tree.add(Box[0]);
+				Box[Reused] = Box[0];
+				Alive[Reused] = 1;
+				Tree.cull(Frustum, Visible);
+				aContext.check("Remove and add", Removed && (Reused % 3 == 0) && same_set(Visible, brute_force(Box, Alive, Frustum)));
+				Tree.rebuild();
+				Tree.cull(Frustum, Visible);
+				aContext.check("Rebuild", same_set(Visible, brute_force(Box, Alive, Frustum)));
+
+				bool Threw = false;
+				try { Tree.set_bounds(3, Box[3]); }
+				catch (const std::invalid_argument&) { Threw = true; }
+				aContext.check("Removed item rejected", Threw);
+			});
+
+			aTest.add("bounds", [](test::context& aContext) {
+				aabb Unit{ { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+				aabb Turned = Unit.transformed(object_transform({ 10.0f, 0.0f, 0.0f }, { 45.0f, 0.0f }, { 1.0f, 1.0f, 2.0f }));
+				aContext.check("Transformed box", (std::abs(Turned.Max[0] - 10.0f - std::sqrt(2.0f)) < 1e-5f) && (std::abs(Turned.Min[1] + std::sqrt(2.0f)) < 1e-5f) && (std::abs(Turned.Max[2] - 2.0f) < 1e-6f));
+
+				// The gizmo's accessor min and max against its vertex data.
+				io::gltf Model = io::gltf::load("assets/models/gizmo/scene.gltf");
+				bool Match = Model.Mesh.size() > 0;
+				for (std::size_t m = 0; m < Model.Mesh.size(); m++) {
+					aabb Box = mesh_bounds(Model, m);
+					io::gltf::view View = Model.accessor_view(Model.Mesh[m].Primitive[0].attribute("POSITION"));
+					for (std::size_t i = 0; i < View.Count; i++) {
+						for (std::size_t k = 0; k < 3; k++) {
+							Match = Match && (View.component(i, k) >= Box.Min[k] - 1e-4f) && (View.component(i, k) <= Box.Max[k] + 1e-4f);
+						}
+					}
+				}
+				aContext.check("Mesh bounds hold every vertex", Match);
+				bool Threw = false;
+				try { mesh_bounds(Model, Model.Mesh.size()); }
+				catch (const std::out_of_range&) { Threw = true; }
+				aContext.check("Missing mesh rejected", Threw);
+			});
+		}
+
+		test::suite BVHSuite("bvh", register_bvh);
+
+	}
+
+}
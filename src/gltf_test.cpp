@@ -0,0 +1,220 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/json.h>
+#include <geodesy-unit-test/gltf.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// JSON parsing and memory mapped glTF/GLB import.
+
+namespace geodesy {
+
+	namespace {
+
+		// Quad with interleaved float position/normal, normalized ushort uv and ushort indices.
+		std::vector<uint8_t> quad_buffer() {
+			std::vector<uint8_t> Data;
+			auto append = [&](const void* aData, std::size_t aSize) {
+				Data.insert(Data.end(), (const uint8_t*)aData, (const uint8_t*)aData + aSize);
+			};
+			const float Vertex[4][6] = {
+				{ -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+				{  1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+				{  1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+				{ -1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+			};
+			append(Vertex, sizeof(Vertex)); 							// View 0, 96 bytes, stride 24.
+			const uint16_t UV[4][2] = { { 0, 0 }, { 65535, 0 }, { 65535, 65535 }, { 0, 65535 } };
+			append(UV, sizeof(UV)); 									// View 1, 16 bytes.
+			const uint16_t Index[6] = { 0, 1, 2, 0, 2, 3 };
+			append(Index, sizeof(Index)); 								// View 2, 12 bytes.
+			Data.resize(124, 0);
+			return Data;
+		}
+
+		std::string quad_document(const std::string& aBuffer) {
+			return std::string("{\n") +
+				"  \"asset\": { \"version\": \"2.0\" },\n"
+				"  \"buffers\": [ { " + aBuffer + "\"byteLength\": 124 } ],\n"
+				"  \"bufferViews\": [\n"
+				"    { \"buffer\": 0, \"byteOffset\": 0, \"byteLength\": 96, \"byteStride\": 24 },\n"
+				"    { \"buffer\": 0, \"byteOffset\": 96, \"byteLength\": 16 },\n"
+				"    { \"buffer\": 0, \"byteOffset\": 112, \"byteLength\": 12 }\n"
+				"  ],\n"
+				"  \"accessors\": [\n"
+				"    { \"bufferView\": 0, \"componentType\": 5126, \"count\": 4, \"type\": \"VEC3\" },\n"
+				"    { \"bufferView\": 0, \"byteOffset\": 12, \"componentType\": 5126, \"count\": 4, \"type\": \"VEC3\" },\n"
+				"    { \"bufferView\": 1, \"componentType\": 5123, \"normalized\": true, \"count\": 4, \"type\": \"VEC2\" },\n"
+				"    { \"bufferView\": 2, \"componentType\": 5123, \"count\": 6, \"type\": \"SCALAR\" }\n"
+				"  ],\n"
+				"  \"meshes\": [ { \"name\": \"Quad\", \"primitives\": [ { \"attributes\": { \"POSITION\": 0, \"NORMAL\": 1, \"TEXCOORD_0\": 2 }, \"indices\": 3 } ] } ]\n"
+				"}\n";
+		}
+
+		std::string base64(const std::vector<uint8_t>& aData) {
+			const char* Alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			std::string Text;
+			for (std::size_t i = 0; i < aData.size(); i += 3) {
+				uint32_t Block = (uint32_t)aData[i] << 16;
+				if (i + 1 < aData.size()) Block |= (uint32_t)aData[i + 1] << 8;
+				if (i + 2 < aData.size()) Block |= aData[i + 2];
+				Text += Alphabet[(Block >> 18) & 63];
+				Text += Alphabet[(Block >> 12) & 63];
+				Text += (i + 1 < aData.size()) ? Alphabet[(Block >> 6) & 63] : '=';
+				Text += (i + 2 < aData.size()) ? Alphabet[Block & 63] : '=';
+			}
+			return Text;
+		}
+
+		void write_file(const std::filesystem::path& aPath, const void* aData, std::size_t aSize) {
+			std::ofstream Stream(aPath, std::ios::binary | std::ios::trunc);
+			Stream.write((const char*)aData, aSize);
+		}
+
+		void write_glb(const std::filesystem::path& aPath, std::string aDocument, std::vector<uint8_t> aBinary) {
+			while (aDocument.size() % 4 != 0) aDocument += ' ';
+			while (aBinary.size() % 4 != 0) aBinary.push_back(0);
+			uint32_t Header[3] = { 0x46546C67u, 2, (uint32_t)(12 + 8 + aDocument.size() + 8 + aBinary.size()) };
+			uint32_t JSONChunk[2] = { (uint32_t)aDocument.size(), 0x4E4F534Au };
+			uint32_t BINChunk[2] = { (uint32_t)aBinary.size(), 0x004E4942u };
+			std::ofstream Stream(aPath, std::ios::binary | std::ios::trunc);
+			Stream.write((const char*)Header, 12);
+			Stream.write((const char*)JSONChunk, 8);
+			Stream.write(aDocument.data(), aDocument.size());
+			Stream.write((const char*)BINChunk, 8);
+			Stream.write((const char*)aBinary.data(), aBinary.size());
+		}
+
+		// Checks every accessor of the quad and returns true when all match.
+		bool quad_matches(const io::gltf& aModel) {
+			if ((aModel.Mesh.size() != 1) || (aModel.Mesh[0].Primitive.size() != 1)) return false;
+			const io::gltf::primitive& P = aModel.Mesh[0].Primitive[0];
+			std::vector<float> Vertex = io::interleave(aModel, P, {
+				{ "POSITION", 3, { 0.0f } },
+				{ "NORMAL", 3, { 0.0f } },
+				{ "TEXCOORD_0", 2, { 0.0f } },
+				{ "COLOR_0", 4, { 1.0f, 1.0f, 1.0f, 1.0f } },
+			});
+			const float Expected[12] = { 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+			if ((Vertex.size() != 48) || (std::memcmp(&Vertex[24], Expected, sizeof(Expected)) != 0)) return false;
+			std::vector<uint32_t> Index = aModel.read_indices(P.Indices);
+			return Index == std::vector<uint32_t>{ 0, 1, 2, 0, 2, 3 };
+		}
+
+		void register_gltf(test& aTest) {
+			aTest.add("json", [](test::context& aContext) {
+				io::json Root = io::json::parse("\xEF\xBB\xBF{ \"a\": [1, -2.5e1, true, false, null], \"s\": \"q\\\"\\u00e9\\ud83d\\ude00\\n\", \"o\": {} }");
+				aContext.check("Array", (Root["a"].size() == 5) && (Root["a"][0].as_int() == 1) && (Root["a"][1].as_double() == -25.0));
+				aContext.check("Literals", Root["a"][2].as_bool() && !Root["a"][3].as_bool(true) && (Root["a"][4].Kind == io::json::NULL_VALUE));
+				aContext.check("String escapes", Root["s"].as_string() == "q\"\xC3\xA9\xF0\x9F\x98\x80\n");
+				aContext.check("Empty object", (Root["o"].Kind == io::json::OBJECT) && (Root["o"].size() == 0));
+				aContext.check("Missing chains to none", Root["x"]["y"][3].is_none() && (Root["x"].as_index(7) == 7));
+				io::json Index = io::json::parse("[3, -1, 2.5, 1e300]");
+				aContext.check("Index rejects negative, fractional and huge numbers",
+					(Index[0].as_index(0) == 3) && (Index[1].as_index(0) == SIZE_MAX) && (Index[2].as_index(0) == SIZE_MAX) && (Index[3].as_index(0) == SIZE_MAX));
+
+				std::size_t ThrowCount = 0;
+				for (const char* Bad : { "{", "[1,]", "{\"a\" 1}", "\"abc", "01x", "[1] 2", "tru" }) {
+					try { io::json::parse(Bad); }
+					catch (const std::runtime_error&) { ThrowCount++; }
+				}
+				aContext.check("Malformed input throws", ThrowCount == 7);
+			});
+
+			aTest.add("gltf_mapped", [](test::context& aContext) {
+				test::scratch Scratch("gltf-test");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::vector<uint8_t> Buffer = quad_buffer();
+				write_file(Directory / "quad data.bin", Buffer.data(), Buffer.size());
+				std::string Document = quad_document("\"uri\": \"quad%20data.bin\", ");
+				write_file(Directory / "quad.gltf", Document.data(), Document.size());
+
+				io::gltf Mapped = io::gltf::load((Directory / "quad.gltf").string());
+				aContext.check("External buffer mapped, not copied", (Mapped.heap_bytes() == 0) && (Mapped.buffer_size(0) == 124));
+				io::gltf::view Position = Mapped.accessor_view(0);
+				aContext.check("View over mapping", (Position.Data == Mapped.buffer_data(0)) && (Position.Stride == 24));
+				io::gltf::view Index = Mapped.accessor_view(3);
+				aContext.check("Packed view exposed directly", (Index.as<uint16_t>(io::gltf::UNSIGNED_SHORT) != nullptr) && (Position.as<float>(io::gltf::FLOAT) == nullptr));
+				aContext.check("Mapped quad", quad_matches(Mapped));
+
+				io::gltf Read = io::gltf::load((Directory / "quad.gltf").string(), io::gltf::READ);
+				aContext.check("Read mode copies buffer", (Read.heap_bytes() == 124) && quad_matches(Read));
+
+				write_glb(Directory / "quad.glb", quad_document(""), Buffer);
+				io::gltf Binary = io::gltf::load((Directory / "quad.glb").string());
+				aContext.check("GLB BIN chunk used in place", (Binary.heap_bytes() == 0) && quad_matches(Binary));
+
+				std::string Embedded = quad_document("\"uri\": \"data:application/octet-stream;base64," + base64(Buffer) + "\", ");
+				write_file(Directory / "embedded.gltf", Embedded.data(), Embedded.size());
+				aContext.check("Data URI buffer", quad_matches(io::gltf::load((Directory / "embedded.gltf").string())));
+			});
+
+			aTest.add("gltf_bounds", [](test::context& aContext) {
+				test::scratch Scratch("gltf-bounds");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::vector<uint8_t> Buffer = quad_buffer();
+				write_file(Directory / "quad.bin", Buffer.data(), Buffer.size());
+				// Index accessor claims 7 elements, one past the end of its view.
+				std::string Document = quad_document("\"uri\": \"quad.bin\", ");
+				Document.replace(Document.find("\"count\": 6"), 10, "\"count\": 7");
+				write_file(Directory / "bad.gltf", Document.data(), Document.size());
+				io::gltf Model = io::gltf::load((Directory / "bad.gltf").string());
+				bool Threw = false;
+				try { Model.read_indices(3); }
+				catch (const std::runtime_error&) { Threw = true; }
+				aContext.check("Accessor past view throws", Threw);
+
+				Threw = false;
+				try { io::gltf::load((Directory / "missing.gltf").string()); }
+				catch (const std::runtime_error&) { Threw = true; }
+				aContext.check("Missing file throws", Threw);
+
+				// Primitives referencing missing accessors or materials.
+				const std::string Primitive = "{ \"attributes\": { \"POSITION\": 0, \"NORMAL\": 1, \"TEXCOORD_0\": 2 }, \"indices\": 3 }";
+				std::size_t RejectCount = 0;
+				for (const char* Bad : {
+					"{ \"attributes\": { \"POSITION\": 0, \"NORMAL\": 9 } }",
+					"{ \"attributes\": { \"POSITION\": -1 } }",
+					"{ \"attributes\": { \"POSITION\": 0 }, \"indices\": 4 }",
+					"{ \"attributes\": { \"POSITION\": 0 }, \"material\": 0 }"
+				}) {
+					std::string Broken = quad_document("\"uri\": \"quad.bin\", ");
+					Broken.replace(Broken.find(Primitive), Primitive.size(), Bad);
+					write_file(Directory / "broken.gltf", Broken.data(), Broken.size());
+					try { io::gltf::load((Directory / "broken.gltf").string()); }
+					catch (const std::runtime_error&) { RejectCount++; }
+				}
+				aContext.check("Primitive references checked at parse time", RejectCount == 4);
+
+				// Buffer shorter than its declared length.
+				write_file(Directory / "quad.bin", Buffer.data(), 100);
+				Threw = false;
+				try { io::gltf::load((Directory / "bad.gltf").string()); }
+				catch (const std::runtime_error&) { Threw = true; }
+				aContext.check("Short buffer throws", Threw);
+			});
+
+			aTest.add("gltf_assets", [](test::context& aContext) {
+				// The bundled bricks2 model ships as both .gltf + .bin and .glb.
+				std::string Text = "assets/models/bricks2/bricks2.gltf", Binary = "assets/models/bricks2/bricks2.glb";
+				if (!std::filesystem::exists(Text) || !std::filesystem::exists(Binary)) return;
+				io::gltf A = io::gltf::load(Text), B = io::gltf::load(Binary);
+				bool Same = (A.Mesh.size() == B.Mesh.size()) && (A.Mesh.size() > 0);
+				for (std::size_t m = 0; Same && (m < A.Mesh.size()); m++) {
+					for (std::size_t p = 0; Same && (p < A.Mesh[m].Primitive.size()); p++) {
+						std::vector<io::vertex_attribute> Layout = { { "POSITION", 3, { 0.0f } }, { "NORMAL", 3, { 0.0f } }, { "TEXCOORD_0", 2, { 0.0f } } };
+						Same = io::interleave(A, A.Mesh[m].Primitive[p], Layout) == io::interleave(B, B.Mesh[m].Primitive[p], Layout);
+					}
+				}
+				aContext.check("bricks2 .gltf and .glb agree", Same);
+			});
+		}
+
+		test::suite GltfSuite("gltf", register_gltf);
+
+	}
+
+}
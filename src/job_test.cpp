@@ -0,0 +1,116 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/job_system.h>
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// Work stealing job system and task graphs.
+
+namespace geodesy {
+
+	namespace {
+
+		void register_job(test& aTest) {
+			aTest.add("parallel_for", [](test::context& aContext) {
+				job_system Jobs(4);
+				aContext.check("Thread count includes the caller", Jobs.thread_count() == 4);
+				std::vector<std::atomic<int>> Visit(10007);
+				for (std::atomic<int>& V : Visit) V = 0;
+				std::mutex Mutex;
+				std::vector<std::pair<std::size_t, std::size_t>> Chunk;
+				Jobs.parallel_for(Visit.size(), 64, [&](std::size_t aBegin, std::size_t aEnd) {
+					for (std::size_t i = aBegin; i < aEnd; i++) Visit[i]++;
+					std::lock_guard<std::mutex> Lock(Mutex);
+					Chunk.push_back({ aBegin, aEnd });
+				});
+				bool Once = true;
+				for (std::atomic<int>& V : Visit) Once = Once && (V == 1);
+				aContext.check("Every index visited once", Once);
+				std::size_t Largest = 0;
+				for (const std::pair<std::size_t, std::size_t>& C : Chunk) Largest = std::max(Largest, C.second - C.first);
+				aContext.check("Chunks of the grain size", (Chunk.size() == 157) && (Largest == 64));
+
+				bool Called = false;
+				Jobs.parallel_for(0, 16, [&](std::size_t aBegin, std::size_t aEnd) { Called = (aBegin == 0) && (aEnd == 0); });
+				aContext.check("Empty range runs once with nothing to do", Called);
+			});
+
+			aTest.add("graph", [](test::context& aContext) {
+				job_system Jobs(4);
+				// Diamond: update -> (animate, cull) -> submit, cull is itself a range.
+				std::mutex Mutex;
+				std::vector<std::string> Log;
+				auto log = [&](const std::string& aEntry) {
+					std::lock_guard<std::mutex> Lock(Mutex);
+					Log.push_back(aEntry);
+				};
+				std::atomic<std::size_t> Culled{ 0 };
+				task_graph Graph;
+				task_graph::id Update = Graph.add("update", [&]() { log("update"); });
+				task_graph::id Animate = Graph.add("animate", [&]() { log("animate"); }, { Update });
+				task_graph::id Cull = Graph.add_range("cull", 1000, 10, [&](std::size_t aBegin, std::size_t aEnd) { Culled += aEnd - aBegin; }, { Update });
+				Graph.add("submit", [&]() { log("submit:" + std::to_string(Culled.load())); }, { Animate, Cull });
+				aContext.check("Graph size", Graph.size() == 4);
+
+				bool Ordered = true;
+				for (int Frame = 0; Frame < 20; Frame++) {
+					Log.clear();
+					Culled = 0;
+					Jobs.run(Graph);
+					Ordered = Ordered && (Log.size() == 3) && (Log[0] == "update") && (Log[1] == "animate") && (Log[2] == "submit:1000");
+				}
+				aContext.check("Dependencies hold on every rerun", Ordered);
+
+				bool Threw = false;
+				try { Graph.add("bad", []() {}, { 7 }); }
+				catch (const std::invalid_argument&) { Threw = true; }
+				aContext.check("Forward dependency rejected", Threw);
+			});
+
+			aTest.add("steal", [](test::context& aContext) {
+				// All chunks start on the caller's queue, the others only get work by stealing.
+				job_system Jobs(4);
+				std::mutex Mutex;
+				std::vector<std::thread::id> Thread;
+				Jobs.parallel_for(64, 1, [&](std::size_t, std::size_t) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+					std::lock_guard<std::mutex> Lock(Mutex);
+					if (std::find(Thread.begin(), Thread.end(), std::this_thread::get_id()) == Thread.end()) Thread.push_back(std::this_thread::get_id());
+				});
+				aContext.check("Idle workers steal", Thread.size() > 1);
+
+				// Single thread runs everything on the caller.
+				job_system Serial(1);
+				std::thread::id Caller = std::this_thread::get_id();
+				bool OnCaller = true;
+				Serial.parallel_for(100, 7, [&](std::size_t, std::size_t) { OnCaller = OnCaller && (std::this_thread::get_id() == Caller); });
+				aContext.check("One thread runs on the caller", OnCaller);
+			});
+
+			aTest.add("exception", [](test::context& aContext) {
+				job_system Jobs(3);
+				std::atomic<bool> AfterRan{ false };
+				task_graph Graph;
+				task_graph::id Fail = Graph.add("fail", []() { throw std::runtime_error("task failed"); });
+				Graph.add("after", [&]() { AfterRan = true; }, { Fail });
+				std::string Message;
+				try { Jobs.run(Graph); }
+				catch (const std::runtime_error& e) { Message = e.what(); }
+				aContext.check("Rethrown from run", Message == "task failed");
+				aContext.check("Dependents skipped", !AfterRan);
+
+				std::atomic<int> Count{ 0 };
+				Jobs.parallel_for(100, 10, [&](std::size_t aBegin, std::size_t aEnd) { Count += (int)(aEnd - aBegin); });
+				aContext.check("Usable after a failure", Count == 100);
+			});
+		}
+
+		test::suite JobSuite("job", register_job);
+
+	}
+
+}
@@ -0,0 +1,181 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/light_clusters.h>
+#include <geodesy-unit-test/transform_hierarchy.h>
+
+#include <cmath>
+#include <random>
+
+// Clustered light assignment, checked against a brute force test of every light at
+// sample points throughout the view frustum.
+
+namespace geodesy {
+
+	namespace {
+
+		using mat4 = math::mat<float, 4, 4>;
+
+		math::vec<float, 3> apply(const mat4& aMatrix, const math::vec<float, 3>& aVector, float aW) {
+			math::vec<float, 4> V = math::simd::mul(aMatrix, math::vec<float, 4>(aVector[0], aVector[1], aVector[2], aW));
+			return { V[0], V[1], V[2] };
+		}
+
+		// Whether a view space point is lit by a light already moved to view space.
+		bool lit(const cluster_light& aLight, const math::vec<float, 3>& aPoint) {
+			float D[3] = { aPoint[0] - aLight.Position[0], aPoint[1] - aLight.Position[1], aPoint[2] - aLight.Position[2] };
+			float Distance = std::sqrt(D[0] * D[0] + D[1] * D[1] + D[2] * D[2]);
+			if (Distance >= aLight.Range) return false;
+			if (aLight.Angle <= 0.0f) return true;
+			if (Distance == 0.0f) return true;
+			float Along = (D[0] * aLight.Direction[0] + D[1] * aLight.Direction[1] + D[2] * aLight.Direction[2]) / Distance;
+			return Along > std::cos(aLight.Angle * 3.14159265358979f / 180.0f);
+		}
+
+		std::vector<cluster_light> random_lights(std::size_t aCount, uint32_t aSeed) {
+			std::mt19937 Random(aSeed);
+			std::uniform_real_distribution<float> Spread(-60.0f, 60.0f), Range(0.5f, 8.0f), Unit(-1.0f, 1.0f), Angle(5.0f, 85.0f), Coin(0.0f, 1.0f);
+			std::vector<cluster_light> Light(aCount);
+			for (cluster_light& L : Light) {
+				L.Position = { Spread(Random), Spread(Random), 0.2f * Spread(Random) };
+				L.Range = Range(Random);
+				if (Coin(Random) < 0.3f) {
+					L.Direction = { Unit(Random), Unit(Random), Unit(Random) };
+					L.Angle = Angle(Random);
+				}
+			}
+			return Light;
+		}
+
+		mat4 camera_view() {
+			return math::simd::inverse(object_transform({ 3.0f, -2.0f, 1.5f }, { 35.0f, 80.0f }, { 1.0f, 1.0f, 1.0f }));
+		}
+
+		void register_light(test& aTest) {
+			aTest.add("grid", [](test::context& aContext) {
+				cluster_grid Grid;
+				Grid.TilesX = 4;
+				Grid.TilesY = 2;
+				Grid.Slices = 3;
+				Grid.FieldOfView = 90.0f;
+				Grid.AspectRatio = 2.0f;
+				Grid.Near = 1.0f;
+				Grid.Far = 1000.0f;
+				light_clusters Clusters(Grid);
+				aContext.check("Cluster count", (Clusters.cluster_count() == 24) && (Clusters.offsets().size() == 25));
+				// Slices split depth at 10 and 100, tiles split x / depth at -1, 0, 1 and y / depth at 0.
+				aContext.check("Depth slices", (Clusters.cluster({ 0.1f, 0.1f, -5.0f }) == Clusters.cluster(2, 1, 0)) && (Clusters.cluster({ 0.1f, 0.1f, -50.0f }) == Clusters.cluster(2, 1, 1)) && (Clusters.cluster({ 0.1f, 0.1f, -500.0f }) == Clusters.cluster(2, 1, 2)));
+				aContext.check("Tiles", (Clusters.cluster({ -15.0f, -1.0f, -10.5f }) == Clusters.cluster(0, 0, 1)) && (Clusters.cluster({ 15.0f, 5.0f, -10.5f }) == Clusters.cluster(3, 1, 1)));
+				aContext.check("Outside the frustum", (Clusters.cluster({ 0.0f, 0.0f, -0.5f }) == light_clusters::None) && (Clusters.cluster({ 0.0f, 0.0f, -2000.0f }) == light_clusters::None) && (Clusters.cluster({ 0.0f, 3.0f, -2.0f }) == light_clusters::None));
+
+				bool Threw = false;
+				Grid.Near = 0.0f;
+				try { light_clusters Invalid(Grid); }
+				catch (const std::invalid_argument&) { Threw = true; }
+				aContext.check("Invalid frustum rejected", Threw);
+			});
+
+			aTest.add("assignment", [](test::context& aContext) {
+				light_clusters Clusters;
+				mat4 View = camera_view();
+				std::vector<cluster_light> Light = random_lights(3000, 22);
+				Clusters.build(View, Light);
+				std::vector<cluster_light> ViewLight = Light;
+				for (cluster_light& L : ViewLight) {
+					L.Position = apply(View, L.Position, 1.0f);
+					float Length = std::sqrt(L.Direction[0] * L.Direction[0] + L.Direction[1] * L.Direction[1] + L.Direction[2] * L.Direction[2]);
+					L.Direction = apply(View, { L.Direction[0] / Length, L.Direction[1] / Length, L.Direction[2] / Length }, 0.0f);
+				}
+
+				const std::vector<uint32_t>& Offset = Clusters.offsets();
+				const std::vector<uint32_t>& Index = Clusters.indices();
+				bool Sorted = Offset.back() == Index.size();
+				for (std::size_t c = 0; c < Clusters.cluster_count(); c++) {
+					for (uint32_t k = Offset[c] + 1; k < Offset[c + 1]; k++) Sorted = Sorted && (Index[k - 1] < Index[k]);
+				}
+				aContext.check("Ascending unique lists", Sorted);
+
+				// Every light reaching a point is listed in the point's cluster.
+				std::mt19937 Random(5);
+				const cluster_grid& Grid = Clusters.grid();
+				float HalfY = std::tan(Grid.FieldOfView * 3.14159265358979f / 360.0f);
+				std::uniform_real_distribution<float> Depth(Grid.Near, 80.0f), Across(-1.0f, 1.0f);
+				std::size_t Missing = 0, Lit = 0;
+				for (int Sample = 0; Sample < 20000; Sample++) {
+					float D = Depth(Random);
+					math::vec<float, 3> Point = { Across(Random) * HalfY * Grid.AspectRatio * D, Across(Random) * HalfY * D, -D };
+					uint32_t C = Clusters.cluster(Point);
+					if (C == light_clusters::None) continue;
+					for (uint32_t l = 0; l < ViewLight.size(); l++) {
+						if (!lit(ViewLight[l], Point)) continue;
+						Lit++;
+						if (!std::binary_search(Index.begin() + Offset[C], Index.begin() + Offset[C + 1], l)) Missing++;
+					}
+				}
+				aContext.check("No light missed", (Lit > 1000) && (Missing == 0));
+				aContext.check("Lights culled", (Clusters.stats().Visible > 0) && (Clusters.stats().Visible < Light.size()) && (Clusters.stats().Assigned == Index.size()));
+			});
+
+			aTest.add("culling", [](test::context& aContext) {
+				light_clusters Clusters;
+				mat4 View = math::simd::inverse(object_transform({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }));
+				std::vector<cluster_light> Light(5);
+				// Small, inside one cluster: the centre of tile (8, 4) at the middle of its slice.
+				uint32_t Slice = 12;
+				float Depth = Clusters.grid().Near * std::pow(Clusters.grid().Far / Clusters.grid().Near, (Slice + 0.5f) / Clusters.grid().Slices);
+				float HalfY = std::tan(Clusters.grid().FieldOfView * 3.14159265358979f / 360.0f);
+				Light[0].Position = { (1.0f / 16.0f) * HalfY * Clusters.grid().AspectRatio * Depth, 0.0f, -Depth };
+				Light[0].Range = 0.001f;
+				Light[1].Position = { 0.0f, 0.0f, 5.0f }; 			// Behind the camera.
+				Light[2].Position = { 0.0f, 0.0f, -1000.0f }; 		// Beyond the far plane.
+				Light[3].Position = { -100.0f, 0.0f, -10.0f }; 		// Off to the side.
+				// Around the camera, reaches into every tile of the near slices.
+				Light[4].Position = { 0.0f, 0.0f, 0.0f };
+				Light[4].Range = 0.5f;
+				Clusters.build(View, Light);
+				const std::vector<uint32_t>& Offset = Clusters.offsets();
+				uint32_t Own = Clusters.cluster(Light[0].Position);
+				std::size_t Nearby = 0, FirstSlice = 0;
+				for (std::size_t c = 0; c < Clusters.cluster_count(); c++) {
+					for (uint32_t k = Offset[c]; k < Offset[c + 1]; k++) {
+						Nearby += Clusters.indices()[k] == 4 ? 1 : 0;
+						FirstSlice += (Clusters.indices()[k] == 4) && (c < 16 * 9) ? 1 : 0;
+					}
+				}
+				aContext.check("Small light in one cluster", (Own == Clusters.cluster(8, 4, Slice)) && (Offset[Own + 1] - Offset[Own] == 1) && (Clusters.indices()[Offset[Own]] == 0));
+				aContext.check("Off screen lights culled", (Clusters.stats().Visible == 2) && (Clusters.stats().Assigned == 1 + Nearby));
+				aContext.check("Camera light covers the nearest slice", FirstSlice == 16 * 9);
+
+				// A spot light pointing away from the view is bounded tighter than its range.
+				std::vector<cluster_light> Spot(1);
+				Spot[0].Position = { 0.0f, 0.0f, -20.0f };
+				Spot[0].Range = 10.0f;
+				Spot[0].Direction = { 0.0f, 0.0f, -1.0f };
+				Spot[0].Angle = 20.0f;
+				Clusters.build(View, Spot);
+				std::size_t Narrow = Clusters.stats().Assigned;
+				Spot[0].Angle = 0.0f;
+				Clusters.build(View, Spot);
+				aContext.check("Spot cone tighter than a point light", (Narrow > 0) && (Narrow < Clusters.stats().Assigned));
+			});
+
+			aTest.add("determinism", [](test::context& aContext) {
+				light_clusters Serial, Parallel;
+				job_system Jobs(4);
+				mat4 View = camera_view();
+				bool Same = true;
+				for (uint32_t Frame = 0; Frame < 3; Frame++) {
+					std::vector<cluster_light> Light = random_lights(5000 + 1000 * Frame, 100 + Frame);
+					Serial.build(View, Light);
+					Parallel.build(View, Light, &Jobs);
+					Same = Same && (Serial.offsets() == Parallel.offsets()) && (Serial.indices() == Parallel.indices());
+				}
+				aContext.check("Identical with a job system", Same);
+			});
+		}
+
+		test::suite LightSuite("light", register_light);
+
+	}
+
+}
@@ -0,0 +1,229 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/mesh_optimizer.h>
+
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <filesystem>
+
+// Level of detail: quadric simplification, the LOD chain built at import and selection by
+// projected screen space error.
+
+namespace geodesy {
+
+	namespace {
+
+		struct test_mesh {
+			std::vector<float> 		Position;
+			std::vector<float> 		Normal;
+			std::vector<float> 		Texcoord;
+			std::vector<uint32_t> 	Index;
+		};
+
+		// Unit UV sphere with a texcoord seam at u = 0 and a vertex per segment at the poles.
+		test_mesh sphere(uint32_t aSegments, uint32_t aRings) {
+			test_mesh Mesh;
+			const float Pi = 3.14159265358979f;
+			for (uint32_t r = 0; r <= aRings; r++) {
+				for (uint32_t s = 0; s <= aSegments; s++) {
+					float Theta = Pi * (float)r / (float)aRings, Phi = 2.0f * Pi * (float)(s % aSegments) / (float)aSegments;
+					float P[3] = { std::sin(Theta) * std::cos(Phi), std::cos(Theta), std::sin(Theta) * std::sin(Phi) };
+					if ((r == 0) || (r == aRings)) P[0] = P[2] = 0.0f;
+					Mesh.Position.insert(Mesh.Position.end(), P, P + 3);
+					Mesh.Normal.insert(Mesh.Normal.end(), P, P + 3);
+					Mesh.Texcoord.insert(Mesh.Texcoord.end(), { (float)s / (float)aSegments, (float)r / (float)aRings });
+				}
+			}
+			for (uint32_t r = 0; r < aRings; r++) {
+				for (uint32_t s = 0; s < aSegments; s++) {
+					uint32_t A = r * (aSegments + 1) + s, B = A + 1, C = A + aSegments + 1, D = C + 1;
+					if (r > 0) Mesh.Index.insert(Mesh.Index.end(), { A, B, C });
+					if (r < aRings - 1) Mesh.Index.insert(Mesh.Index.end(), { B, D, C });
+				}
+			}
+			return Mesh;
+		}
+
+		std::vector<uint32_t> simplify(const test_mesh& aMesh, std::size_t aTarget, const io::simplify_options& aOptions, float* aError) {
+			return io::simplify(aMesh.Position.data(), aMesh.Normal.data(), aMesh.Texcoord.data(), aMesh.Position.size() / 3, aMesh.Index, aTarget, aOptions, aError);
+		}
+
+		void register_lod(test& aTest) {
+			aTest.add("simplify", [](test::context& aContext) {
+				test_mesh Sphere = sphere(64, 32);
+				std::size_t Triangles = Sphere.Index.size() / 3;
+				float Half = 0.0f, Quarter = 0.0f, Tenth = 0.0f;
+				std::vector<uint32_t> A = simplify(Sphere, Triangles / 2, {}, &Half);
+				std::vector<uint32_t> B = simplify(Sphere, Triangles / 4, {}, &Quarter);
+				std::vector<uint32_t> C = simplify(Sphere, Triangles / 10, {}, &Tenth);
+				aContext.check("Reaches the target", (A.size() / 3 == Triangles / 2) && (B.size() / 3 == Triangles / 4) && (C.size() / 3 <= Triangles / 10) && (C.size() / 3 > Triangles / 20));
+				aContext.check("Error grows with reduction", (Half > 0.0f) && (Half < Quarter) && (Quarter < Tenth) && (Tenth < 0.1f));
+
+				// Vertices stay on the sphere, so the deviation shows at the triangle centres,
+				// and no triangle turns inwards or stretches across the texcoord seam.
+				float Deviation = 0.0f, Span = 0.0f;
+				bool Outwards = true;
+				for (std::size_t i = 0; i < C.size(); i += 3) {
+					const float* P[3] = { &Sphere.Position[3 * C[i]], &Sphere.Position[3 * C[i + 1]], &Sphere.Position[3 * C[i + 2]] };
+					float Centre[3];
+					for (std::size_t k = 0; k < 3; k++) Centre[k] = (P[0][k] + P[1][k] + P[2][k]) / 3.0f;
+					Deviation = std::max(Deviation, 1.0f - std::sqrt(Centre[0] * Centre[0] + Centre[1] * Centre[1] + Centre[2] * Centre[2]));
+					double N[3];
+					io::detail::cross(P[0], P[1], P[2], N);
+					Outwards = Outwards && (N[0] * Centre[0] + N[1] * Centre[1] + N[2] * Centre[2] > 0.0);
+					float U[3] = { Sphere.Texcoord[2 * C[i]], Sphere.Texcoord[2 * C[i + 1]], Sphere.Texcoord[2 * C[i + 2]] };
+					Span = std::max(Span, *std::max_element(U, U + 3) - *std::min_element(U, U + 3));
+				}
+				aContext.check("Error estimate tracks the deviation", (Deviation > 0.5f * Tenth) && (Deviation < 2.0f * Tenth));
+				aContext.check("No flipped triangles", Outwards);
+				aContext.check("Texcoord seam kept", Span < 0.5f);
+
+				io::simplify_options Bound;
+				Bound.MaxError = 0.5f * Half;
+				float Error = 0.0f;
+				std::vector<uint32_t> D = simplify(Sphere, 0, Bound, &Error);
+				aContext.check("Error limit holds", (Error <= Bound.MaxError) && (D.size() > A.size()) && (D.size() < Sphere.Index.size()));
+
+				// A flat grid loses its interior at no error and keeps its outline.
+				test_mesh Grid;
+				const uint32_t Size = 32;
+				for (uint32_t y = 0; y <= Size; y++) {
+					for (uint32_t x = 0; x <= Size; x++) {
+						Grid.Position.insert(Grid.Position.end(), { (float)x, (float)y, 0.0f });
+						Grid.Normal.insert(Grid.Normal.end(), { 0.0f, 0.0f, 1.0f });
+						Grid.Texcoord.insert(Grid.Texcoord.end(), { (float)x / Size, (float)y / Size });
+					}
+				}
+				for (uint32_t y = 0; y < Size; y++) {
+					for (uint32_t x = 0; x < Size; x++) {
+						uint32_t A0 = y * (Size + 1) + x, B0 = A0 + 1, C0 = A0 + Size + 1, D0 = C0 + 1;
+						Grid.Index.insert(Grid.Index.end(), { A0, B0, D0, A0, D0, C0 });
+					}
+				}
+				std::vector<uint32_t> Flat = simplify(Grid, 2, {}, &Error);
+				double Area = 0.0;
+				for (std::size_t i = 0; i < Flat.size(); i += 3) {
+					double N[3];
+					io::detail::cross(&Grid.Position[3 * Flat[i]], &Grid.Position[3 * Flat[i + 1]], &Grid.Position[3 * Flat[i + 2]], N);
+					Area += 0.5 * N[2];
+				}
+				aContext.check("Flat grid collapses without error", (Flat.size() / 3 < Grid.Index.size() / 3 / 10) && (Error == 0.0f) && (std::abs(Area - Size * Size) < 1e-3));
+
+				bool Threw = false;
+				try { io::simplify(Grid.Position.data(), nullptr, nullptr, 4, Grid.Index, 2); }
+				catch (const std::out_of_range&) { Threw = true; }
+				aContext.check("Index out of range", Threw);
+			});
+
+			aTest.add("chain", [](test::context& aContext) {
+				io::gltf Model = io::gltf::load("assets/models/pirate_map/scene.gltf");
+				io::mesh_options Options;
+				Options.LodCount = 4;
+				bool Levels = true, Coarser = true, Bounded = true, Valid = true;
+				std::size_t Full = 0, Coarsest = 0;
+				for (std::size_t m = 0; m < Model.Mesh.size(); m++) {
+					io::optimized_mesh Mesh = io::optimize_mesh(Model, m, 0, Options);
+					io::optimized_mesh Plain = io::optimize_mesh(Model, m, 0);
+					Levels = Levels && (Mesh.lod_count() >= 2) && (Mesh.lod_count() <= 5) && Plain.Lod.empty() && (Mesh.Index == Plain.Index);
+					float Extent = 0.0f;
+					for (std::size_t k = 0; k < 3; k++) {
+						float Low = FLT_MAX, High = -FLT_MAX;
+						for (std::size_t v = 0; v < Mesh.VertexCount; v++) {
+							Low = std::min(Low, Mesh.Position[3 * v + k]);
+							High = std::max(High, Mesh.Position[3 * v + k]);
+						}
+						Extent = std::max(Extent, High - Low);
+					}
+					std::vector<float> Error = Mesh.lod_error();
+					for (std::size_t l = 1; l < Mesh.lod_count(); l++) {
+						Coarser = Coarser && (Mesh.lod_triangles(l) * 10 <= Mesh.lod_triangles(l - 1) * 9) && (Error[l] >= Error[l - 1]);
+						Bounded = Bounded && (Error[l] <= Options.LodMaxError * Extent * 1.0001f);
+					}
+					Valid = Valid && io::detail::consistent(Mesh) && (Mesh.lod_index(1) == Mesh.LodIndex.data());
+					Full += Mesh.lod_triangles(0);
+					Coarsest += Mesh.lod_triangles(Mesh.lod_count() - 1);
+				}
+				aContext.check("Every mesh gets levels", Levels);
+				aContext.check("Levels get coarser", Coarser);
+				aContext.check("Error within the limit", Bounded);
+				aContext.check("Levels index the mesh's vertices", Valid);
+				aContext.check("Coarsest levels under half the triangles", Coarsest * 2 < Full);
+
+				bool Threw = false;
+				Options.LodRatio = 1.0f;
+				try { io::optimize_mesh(Model, 0, 0, Options); }
+				catch (const std::invalid_argument&) { Threw = true; }
+				aContext.check("LOD ratio checked", Threw);
+			});
+
+			aTest.add("cache", [](test::context& aContext) {
+				test::scratch Scratch("lod-test");
+				const std::filesystem::path& Directory = Scratch.path();
+				io::mesh_cache Cache(Directory.string());
+				std::string Path = "assets/models/Pigwithanimation.gltf";
+				io::mesh_options Options;
+				Options.LodCount = 3;
+				io::mesh_report Cold, Warm, Plain;
+				std::vector<io::optimized_mesh> A = Cache.load(Path, Options, &Cold);
+				std::vector<io::optimized_mesh> B = Cache.load(Path, Options, &Warm);
+				bool Identical = Warm.Hit && (A.size() == B.size());
+				for (std::size_t i = 0; Identical && (i < A.size()); i++) {
+					Identical = (A[i].LodIndex == B[i].LodIndex) && (A[i].lod_error() == B[i].lod_error()) && (A[i].Lod.size() == Warm.Entry[i].Lod.size());
+				}
+				aContext.check("Levels cached", !Cold.Hit && Identical && (A[0].lod_count() > 1));
+				aContext.check("Report lists levels", Warm.to_string().find("lod 1") != std::string::npos);
+				Cache.load(Path, io::mesh_options(), &Plain);
+				aContext.check("LOD options miss", !Plain.Hit);
+			});
+
+			aTest.add("selection", [](test::context& aContext) {
+				// 70 degrees over 1080 pixels is 771 pixels per unit at unit distance, so level
+				// l fits under a pixel from 771 * Error[l] and switches in from 1028 * Error[l].
+				lod_selector Selector(70.0f, 1080.0f);
+				const float Error[] = { 0.0f, 0.01f, 0.04f, 0.16f };
+				aContext.check("Projected error", std::abs(Selector.projected_error(1.0f, 1.0f) - 771.2f) < 0.1f);
+				aContext.check("Fresh selection", (Selector.select(Error, 4, 5.0f) == 0) && (Selector.select(Error, 4, 20.0f) == 1) && (Selector.select(Error, 4, 200.0f) == 3));
+				aContext.check("Coarser waits for the band", (Selector.select(Error, 4, 35.0f, 1) == 1) && (Selector.select(Error, 4, 45.0f, 1) == 2));
+				aContext.check("Finer at once", (Selector.select(Error, 4, 35.0f, 2) == 2) && (Selector.select(Error, 4, 25.0f, 2) == 1) && (Selector.select(Error, 4, 1.0f, 3) == 0));
+
+				// An object wobbling across a boundary switches once, not every frame.
+				std::size_t Level = SIZE_MAX, Switches = 0;
+				for (std::size_t Frame = 0; Frame < 100; Frame++) {
+					std::size_t Next = Selector.select(Error, 4, Frame % 2 == 0 ? 30.0f : 32.0f, Level);
+					if ((Level != SIZE_MAX) && (Next != Level)) Switches++;
+					Level = Next;
+				}
+				aContext.check("Hysteresis", Switches <= 1);
+
+				// Scattered copies of a model draw a fraction of its triangles, each within the
+				// pixel threshold.
+				io::gltf Model = io::gltf::load("assets/models/pirate_map/scene.gltf");
+				io::mesh_options Options;
+				Options.LodCount = 4;
+				io::optimized_mesh Mesh = io::optimize_mesh(Model, 3, 0, Options);
+				std::vector<float> Levels = Mesh.lod_error();
+				// The coarsest level stops at the error limit, a twentieth of the extent.
+				float Extent = Levels.back() / Options.LodMaxError;
+				std::mt19937 Random(3);
+				std::uniform_real_distribution<float> Distance(Extent, 200.0f * Extent);
+				std::size_t Drawn = 0, Full = 0;
+				bool Within = true;
+				for (std::size_t i = 0; i < 1000; i++) {
+					float D = Distance(Random);
+					std::size_t L = Selector.select(Levels.data(), Levels.size(), D);
+					Within = Within && (Selector.projected_error(Levels[L], D) <= 1.0f);
+					Drawn += Mesh.lod_triangles(L);
+					Full += Mesh.lod_triangles(0);
+				}
+				aContext.check("Within the threshold", Within);
+				aContext.check("Triangles scale with screen size", Drawn * 2 < Full);
+			});
+		}
+
+		test::suite LodSuite("lod", register_lod);
+
+	}
+
+}
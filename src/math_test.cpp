@@ -0,0 +1,760 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/math_simd.h>
+#include <geodesy-unit-test/vec_array.h>
+#include <geodesy-unit-test/grid.h>
+#include <geodesy-unit-test/fft.h>
+#include <geodesy-unit-test/math_constexpr.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+// Math library tests, one case per area so the runner can spread them across threads.
+
+namespace geodesy {
+
+	namespace {
+
+		const float TestEpsilon = 1e-5f;
+
+		bool float_equal(float aA, float aB) {
+			return std::abs(aA - aB) < TestEpsilon;
+		}
+
+		void register_math(test& aTest) {
+			// Vector Tests
+			aTest.add("vec", [](test::context& aContext) {
+				// Constructor tests
+				{
+					math::vec<float, 3> DefaultVec;
+					math::vec<float, 3> InitVec = { 1.0f, 2.0f, 3.0f };
+
+					aContext.check("Default constructor zero initialization",
+						float_equal(DefaultVec[0], 0.0f) &&
+						float_equal(DefaultVec[1], 0.0f) &&
+						float_equal(DefaultVec[2], 0.0f));
+
+					aContext.check("Initializer list constructor",
+						float_equal(InitVec[0], 1.0f) &&
+						float_equal(InitVec[1], 2.0f) &&
+						float_equal(InitVec[2], 3.0f));
+				}
+
+				// Arithmetic operations
+				{
+					math::vec<float, 3> A(2.0f, 1.0f, -3.0f);
+					math::vec<float, 3> B = { 0.0f, -2.09f, 9.987f };
+					float Scalar = 3.14159f;
+
+					// Test negation
+					math::vec<float, 3> Neg = -A;
+					aContext.check("Vector negation",
+						float_equal(Neg[0], -2.0f) &&
+						float_equal(Neg[1], -1.0f) &&
+						float_equal(Neg[2], 3.0f));
+
+					// Test addition
+					math::vec<float, 3> Sum = A + B;
+					aContext.check("Vector addition",
+						float_equal(Sum[0], 2.0f) &&
+						float_equal(Sum[1], -1.09f) &&
+						float_equal(Sum[2], 6.987f));
+
+					// Test subtraction
+					math::vec<float, 3> Diff = A - B;
+					aContext.check("Vector subtraction",
+						float_equal(Diff[0], 2.0f) &&
+						float_equal(Diff[1], 3.09f) &&
+						float_equal(Diff[2], -12.987f));
+
+					// Test scalar multiplication
+					math::vec<float, 3> Scaled = A * Scalar;
+					aContext.check("Vector scalar multiplication",
+						float_equal(Scaled[0], 2.0f * Scalar) &&
+						float_equal(Scaled[1], 1.0f * Scalar) &&
+						float_equal(Scaled[2], -3.0f * Scalar));
+
+					// Test scalar division
+					math::vec<float, 3> Divided = A / Scalar;
+					aContext.check("Vector scalar division",
+						float_equal(Divided[0], 2.0f / Scalar) &&
+						float_equal(Divided[1], 1.0f / Scalar) &&
+						float_equal(Divided[2], -3.0f / Scalar));
+				}
+
+				// Compound assignments
+				{
+					math::vec<float, 3> A = { 2.0f, 1.0f, -3.0f };
+					math::vec<float, 3> B = { 0.0f, -2.09f, 9.987f };
+					float Scalar = 3.14159f;
+
+					math::vec<float, 3> TestVec = A;
+					TestVec += B;
+					aContext.check("Vector compound addition",
+						float_equal(TestVec[0], 2.0f) &&
+						float_equal(TestVec[1], -1.09f) &&
+						float_equal(TestVec[2], 6.987f));
+
+					TestVec = A;
+					TestVec -= B;
+					aContext.check("Vector compound subtraction",
+						float_equal(TestVec[0], 2.0f) &&
+						float_equal(TestVec[1], 3.09f) &&
+						float_equal(TestVec[2], -12.987f));
+
+					TestVec = A;
+					TestVec *= Scalar;
+					aContext.check("Vector compound multiplication",
+						float_equal(TestVec[0], 2.0f * Scalar) &&
+						float_equal(TestVec[1], 1.0f * Scalar) &&
+						float_equal(TestVec[2], -3.0f * Scalar));
+
+					TestVec = A;
+					TestVec /= Scalar;
+					aContext.check("Vector compound division",
+						float_equal(TestVec[0], 2.0f / Scalar) &&
+						float_equal(TestVec[1], 1.0f / Scalar) &&
+						float_equal(TestVec[2], -3.0f / Scalar));
+				}
+
+				// Special operations
+				{
+					math::vec<float, 3> A = { 2.0f, 1.0f, -3.0f };
+					math::vec<float, 3> B = { 0.0f, -2.09f, 9.987f };
+
+					// Dot product
+					float Dot = A * B;
+					aContext.check("Vector dot product",
+						float_equal(Dot, 2.0f*0.0f + 1.0f*(-2.09f) + (-3.0f)*9.987f));
+
+					// Cross product
+					math::vec<float, 3> Cross = A ^ B;
+					aContext.check("Vector cross product",
+						float_equal(Cross[0], 1.0f*9.987f - (-3.0f)*(-2.09f)) &&
+						float_equal(Cross[1], (-3.0f)*0.0f - 2.0f*9.987f) &&
+						float_equal(Cross[2], 2.0f*(-2.09f) - 1.0f*0.0f));
+				}
+			});
+
+			// Complex number tests
+			aTest.add("complex", [](test::context& aContext) {
+				// Constructor tests
+				{
+					math::complex<float> DefaultComplex;
+					math::complex<float> InitComplex(1.0f, 2.0f);
+
+					aContext.check("Complex default constructor",
+						float_equal(DefaultComplex[0], 0.0f) &&
+						float_equal(DefaultComplex[1], 0.0f));
+
+					aContext.check("Complex initialization constructor",
+						float_equal(InitComplex[0], 1.0f) &&
+						float_equal(InitComplex[1], 2.0f));
+				}
+
+				// Basic operations
+				{
+					math::complex<float> A(1.0f, 2.0f);
+					math::complex<float> B(3.0f, 4.0f);
+
+					// Addition
+					math::complex<float> Sum = A + B;
+					aContext.check("Complex addition",
+						float_equal(Sum[0], 4.0f) &&
+						float_equal(Sum[1], 6.0f));
+
+					// Conjugate
+					math::complex<float> Conj = ~A;
+					aContext.check("Complex conjugate",
+						float_equal(Conj[0], 1.0f) &&
+						float_equal(Conj[1], -2.0f));
+
+					// Multiplication
+					math::complex<float> Prod = A * B;
+					aContext.check("Complex multiplication",
+						float_equal(Prod[0], -5.0f) &&
+						float_equal(Prod[1], 10.0f));
+
+					// Functions
+					float Abs = abs(A);
+					aContext.check("Complex absolute value",
+						float_equal(Abs, std::sqrt(5.0f)));
+
+					float Phase = phase(A);
+					aContext.check("Complex phase",
+						float_equal(Phase, std::atan2(2.0f, 1.0f)));
+				}
+			});
+
+			// Matrix tests
+			aTest.add("mat", [](test::context& aContext) {
+				// Test column-major storage with row-major input
+				{
+					math::mat<float, 4, 4> A = math::mat<float, 4, 4>(
+						1.0f, 0.0f, 0.0f, 1.0f,
+						2.0f, 1.0f, -1.0f, 2.0f,
+						3.0f, 2.0f, 0.0f, 3.0f,
+						4.0f, 3.0f, 1.0f, 4.0f
+					);
+
+					// Test column-major access
+					aContext.check("Matrix column-major storage",
+						float_equal(A(0,0), 1.0f) &&
+						float_equal(A(1,0), 2.0f) &&
+						float_equal(A(2,0), 3.0f) &&
+						float_equal(A(3,0), 4.0f));
+				}
+
+				// Test matrix multiplication
+				{
+					math::mat<float, 4, 4> A = math::mat<float, 4, 4>(
+						1.0f, 0.0f, 0.0f, 1.0f,
+						2.0f, 1.0f, -1.0f, 2.0f,
+						3.0f, 2.0f, 0.0f, 3.0f,
+						4.0f, 3.0f, 1.0f, 4.0f
+					);
+
+					math::mat<float, 4, 4> B = {
+						1.0f, 2.0f, 3.0f, 4.0f,
+						5.0f, 6.0f, 7.0f, 8.0f,
+						9.0f, 10.0f, 11.0f, 12.0f,
+						13.0f, 14.0f, 15.0f, 16.0f
+					};
+
+					math::mat<float, 4, 4> C = A * B;
+					bool ProductMatch = true;
+					for (int i = 0; i < 4; i++) {
+						for (int j = 0; j < 4; j++) {
+							float Expected = 0.0f;
+							for (int k = 0; k < 4; k++)
+								Expected += A(i, k) * B(k, j);
+							ProductMatch &= float_equal(C(i, j), Expected);
+						}
+					}
+					aContext.check("Matrix multiplication", ProductMatch);
+				}
+
+				// Test determinant
+				{
+					math::mat<float, 4, 4> A = math::mat<float, 4, 4>(
+						2.0f, -1.0f, 0.0f, 1.0f,
+						1.0f, 3.0f, -2.0f, 0.0f,
+						0.0f, 2.0f, 4.0f, -1.0f,
+						1.0f, -1.0f, 1.0f, 2.0f
+					);
+
+					float Det = determinant(A);
+					aContext.check("Matrix determinant",
+						float_equal(Det, 55.0f));
+				}
+			});
+
+			// SIMD 4x4 kernels, checked against the generic mat<T,M,N> template.
+			aTest.add("simd", [](test::context& aContext) {
+				std::mt19937 Generator(1234);
+				std::uniform_real_distribution<float> Distribution(-4.0f, 4.0f);
+				auto random_mat4 = [&]() -> math::mat<float, 4, 4> {
+					math::mat<float, 4, 4> M;
+					for (int i = 0; i < 4; i++)
+						for (int j = 0; j < 4; j++)
+							M(i, j) = Distribution(Generator);
+					return M;
+				};
+
+				{
+					math::mat<float, 4, 4> A;
+					aContext.check("SIMD column-major layout",
+						(&A(1, 0) == &A(0, 0) + 1) &&
+						(&A(0, 1) == &A(0, 0) + 4));
+				}
+
+				bool MultiplyExact = true;
+				bool VectorExact = true;
+				bool DeterminantClose = true;
+				bool InverseClose = true;
+				for (int n = 0; n < 1000; n++) {
+					math::mat<float, 4, 4> A = random_mat4();
+					math::mat<float, 4, 4> B = random_mat4();
+					math::vec<float, 4> V = { Distribution(Generator), Distribution(Generator), Distribution(Generator), Distribution(Generator) };
+
+					math::mat<float, 4, 4> Generic = A * B;
+					math::mat<float, 4, 4> Simd = math::simd::mul(A, B);
+					for (int i = 0; i < 4; i++)
+						for (int j = 0; j < 4; j++)
+							MultiplyExact &= (Generic(i, j) == Simd(i, j));
+
+					math::vec<float, 4> GenericVec = A * V;
+					math::vec<float, 4> SimdVec = math::simd::mul(A, V);
+					for (int i = 0; i < 4; i++)
+						VectorExact &= (GenericVec[i] == SimdVec[i]);
+
+					float GenericDet = determinant(A);
+					float SimdDet = math::simd::determinant(A);
+					DeterminantClose &= std::abs(GenericDet - SimdDet) <= 1e-4f * std::max(1.0f, std::abs(GenericDet));
+
+					// Only well conditioned matrices give a meaningful A * inverse(A) == I check.
+					if (std::abs(GenericDet) > 1.0f) {
+						math::mat<float, 4, 4> Identity = A * math::simd::inverse(A);
+						for (int i = 0; i < 4; i++)
+							for (int j = 0; j < 4; j++)
+								InverseClose &= std::abs(Identity(i, j) - (i == j ? 1.0f : 0.0f)) < 1e-3f;
+					}
+				}
+
+				aContext.check("SIMD matrix multiplication (bit exact)", MultiplyExact);
+				aContext.check("SIMD matrix-vector multiplication (bit exact)", VectorExact);
+				aContext.check("SIMD matrix determinant", DeterminantClose);
+				aContext.check("SIMD matrix inverse", InverseClose);
+			});
+
+			// Structure-of-arrays batch kernels, checked against per-element vec/mat operators.
+			aTest.add("vec_array", [](test::context& aContext) {
+				std::mt19937 Generator(5678);
+				std::uniform_real_distribution<float> Distribution(-10.0f, 10.0f);
+				// Odd count so the padded tail is exercised.
+				const std::size_t Count = 1001;
+				std::vector<math::vec<float, 3>> A(Count), B(Count);
+				for (std::size_t i = 0; i < Count; i++) {
+					A[i] = { Distribution(Generator), Distribution(Generator), Distribution(Generator) };
+					B[i] = { Distribution(Generator), Distribution(Generator), Distribution(Generator) };
+				}
+				math::vec_array<float, 3> SoA(A), SoB(B), Out;
+
+				bool RoundTrip = (SoA.size() == Count);
+				std::vector<math::vec<float, 3>> Back = SoA.to_vector();
+				for (std::size_t i = 0; i < Count; i++)
+					for (int c = 0; c < 3; c++)
+						RoundTrip &= (Back[i][c] == A[i][c]);
+				aContext.check("vec_array round trip", RoundTrip);
+
+				math::mat<float, 4, 4> Transform = math::mat<float, 4, 4>(
+					0.0f, -2.0f, 0.0f, 1.0f,
+					2.0f, 0.0f, 0.0f, -3.0f,
+					0.0f, 0.0f, 2.0f, 0.5f,
+					0.0f, 0.0f, 0.0f, 1.0f
+				);
+				bool TransformClose = true;
+				math::batch::transform_points(Transform, SoA, Out);
+				for (std::size_t i = 0; i < Count; i++) {
+					math::vec<float, 4> Expected = Transform * math::vec<float, 4>{ A[i][0], A[i][1], A[i][2], 1.0f };
+					for (int c = 0; c < 3; c++)
+						TransformClose &= std::abs(Out.get(i)[c] - Expected[c]) < 1e-4f;
+				}
+				aContext.check("Batch transform points", TransformClose);
+
+				bool CrossClose = true;
+				math::batch::cross(SoA, SoB, Out);
+				for (std::size_t i = 0; i < Count; i++) {
+					math::vec<float, 3> Expected = A[i] ^ B[i];
+					for (int c = 0; c < 3; c++)
+						CrossClose &= std::abs(Out.get(i)[c] - Expected[c]) < 1e-3f;
+				}
+				aContext.check("Batch cross product", CrossClose);
+
+				bool DotClose = true;
+				std::vector<float> Dot(SoA.stride());
+				math::batch::dot(SoA, SoB, Dot.data());
+				for (std::size_t i = 0; i < Count; i++)
+					DotClose &= std::abs(Dot[i] - (A[i] * B[i])) < 1e-3f;
+				aContext.check("Batch dot product", DotClose);
+
+				math::vec_array<float, 3> Short(Count - 1);
+				bool DotThrew = false, CrossThrew = false;
+				try { math::batch::dot(SoA, Short, Dot.data()); }
+				catch (const std::invalid_argument&) { DotThrew = true; }
+				try { math::batch::cross(Short, SoB, Out); }
+				catch (const std::invalid_argument&) { CrossThrew = true; }
+				aContext.check("Batch dot and cross reject mismatched sizes", DotThrew && CrossThrew);
+
+				bool NormalizeClose = true;
+				Out = SoA;
+				Out.set(0, { 0.0f, 0.0f, 0.0f });
+				math::batch::normalize(Out);
+				NormalizeClose &= (Out.get(0)[0] == 0.0f) && (Out.get(0)[1] == 0.0f) && (Out.get(0)[2] == 0.0f);
+				for (std::size_t i = 1; i < Count; i++) {
+					math::vec<float, 3> Expected = A[i] / std::sqrt(A[i] * A[i]);
+					for (int c = 0; c < 3; c++)
+						NormalizeClose &= float_equal(Out.get(i)[c], Expected[c]);
+				}
+				aContext.check("Batch normalize", NormalizeClose);
+
+				math::vec<float, 3> Min, Max;
+				math::batch::bounds(SoA, Min, Max);
+				bool BoundsExact = true;
+				for (int c = 0; c < 3; c++) {
+					float ExpectedMin = A[0][c], ExpectedMax = A[0][c];
+					for (std::size_t i = 0; i < Count; i++) {
+						ExpectedMin = std::min(ExpectedMin, A[i][c]);
+						ExpectedMax = std::max(ExpectedMax, A[i][c]);
+					}
+					BoundsExact &= (Min[c] == ExpectedMin) && (Max[c] == ExpectedMax);
+				}
+				aContext.check("Batch bounds", BoundsExact);
+			});
+
+			// Field tests
+			aTest.add("field", [](test::context& aContext) {
+				math::field<float, 2, float> X({-5.0f, -5.0f}, {2.0f, 2.0f}, {50, 50}, 1);
+				math::field<float, 2, float> Y({-2.0f, -3.0f}, {4.0f, 5.0f}, {50, 50}, 2);
+
+				// Test field addition
+				math::field<float, 2, float> Sum = X + Y;
+
+				// Test field sampling, the point lies inside both domains.
+				math::vec<float, 2> SamplePoint = {1.9f, 1.3f};
+				float SampleValue = Sum(SamplePoint);
+
+				aContext.check("Field sampling", float_equal(X(SamplePoint), 1.0f) && float_equal(Y(SamplePoint), 2.0f));
+				aContext.check("Field addition", float_equal(SampleValue, 3.0f));
+			});
+
+			// Lazy expression templates over vec, mat and grid.
+			aTest.add("expression", [](test::context& aContext) {
+				math::vec<float, 3> A = { 2.0f, 1.0f, -3.0f };
+				math::vec<float, 3> B = { 0.0f, -2.09f, 9.987f };
+				math::vec<float, 3> C = { 0.5f, 0.25f, -1.0f };
+				float Scalar = 3.14159f;
+
+				math::vec<float, 3> Lazy = math::lazy(A) * Scalar + math::lazy(B) - math::lazy(C);
+				math::vec<float, 3> Eager = A * Scalar + B - C;
+				aContext.check("Lazy vector expression",
+					float_equal(Lazy[0], Eager[0]) &&
+					float_equal(Lazy[1], Eager[1]) &&
+					float_equal(Lazy[2], Eager[2]));
+
+				math::mat<float, 4, 4> M = math::mat<float, 4, 4>(
+					1.0f, 0.0f, 0.0f, 1.0f,
+					2.0f, 1.0f, -1.0f, 2.0f,
+					3.0f, 2.0f, 0.0f, 3.0f,
+					4.0f, 3.0f, 1.0f, 4.0f
+				);
+				math::mat<float, 4, 4> LazyMat = math::lazy(M) + math::lazy(M) * 2.0f - math::lazy(M) / 2.0f;
+				bool MatClose = true;
+				for (int i = 0; i < 4; i++)
+					for (int j = 0; j < 4; j++)
+						MatClose &= float_equal(LazyMat(i, j), 2.5f * M(i, j));
+				aContext.check("Lazy matrix expression", MatClose);
+
+				// Linear data is reproduced exactly by multilinear interpolation, so sums of
+				// grids on different layouts can be checked at arbitrary points.
+				math::grid<float, 2, float> X({-5.0f, -5.0f}, {2.0f, 2.0f}, {50, 50}, 0.0f);
+				math::grid<float, 2, float> Y({-2.0f, -3.0f}, {4.0f, 5.0f}, {50, 50}, 0.0f);
+				for (std::size_t i = 0; i < X.size(); i++) {
+					math::vec<float, 2> P = X.Layout.position(i);
+					X[i] = P[0] + 2.0f * P[1];
+				}
+				for (std::size_t i = 0; i < Y.size(); i++) {
+					math::vec<float, 2> P = Y.Layout.position(i);
+					Y[i] = 3.0f - P[0];
+				}
+
+				math::vec<float, 2> SamplePoint = {1.9f, 1.3f};
+				float Expected = (1.9f + 2.0f * 1.3f) + 2.0f * (3.0f - 1.9f);
+
+				math::grid<float, 2, float> Sum = X + Y * 2.0f;
+				aContext.check("Grid expression evaluation",
+					(Sum.size() == X.size()) &&
+					(std::abs(Sum(SamplePoint) - Expected) < 1e-3f));
+
+				aContext.check("Grid expression sampling",
+					std::abs((X + Y * 2.0f)(SamplePoint) - Expected) < 1e-3f);
+
+				math::grid<float, 2, float> Same = X - X * 0.5f + -X;
+				bool SameClose = true;
+				for (std::size_t i = 0; i < Same.size(); i++)
+					SameClose &= float_equal(Same[i], -0.5f * X[i]);
+				aContext.check("Grid expression same layout", SameClose);
+			});
+
+			// Batched grid sampling, checked against point-wise sampling.
+			aTest.add("grid_sample", [](test::context& aContext) {
+				std::mt19937 Generator(91011);
+				// Points reach outside the box to exercise clamping.
+				std::uniform_real_distribution<float> Distribution(-6.0f, 6.0f);
+
+				math::grid<float, 2, float> Plane({-5.0f, -5.0f}, {2.0f, 2.0f}, {50, 37}, 0.0f);
+				math::grid<float, 3, float> Volume({-1.0f, -2.0f, -3.0f}, {1.0f, 2.0f, 3.0f}, {17, 9, 1}, 0.0f);
+				for (std::size_t i = 0; i < Plane.size(); i++) Plane[i] = Distribution(Generator);
+				for (std::size_t i = 0; i < Volume.size(); i++) Volume[i] = Distribution(Generator);
+
+				const std::size_t Count = 20001;
+				math::vec_array<float, 2> PlanePoint(Count);
+				math::vec_array<float, 3> VolumePoint(Count);
+				for (std::size_t i = 0; i < Count; i++) {
+					PlanePoint.set(i, { Distribution(Generator), Distribution(Generator) });
+					VolumePoint.set(i, { Distribution(Generator), Distribution(Generator), Distribution(Generator) });
+				}
+
+				std::vector<float> Batch(PlanePoint.stride()), Parallel(PlanePoint.stride());
+				Plane.sample(PlanePoint, Batch.data());
+				job_system Jobs(4);
+				Plane.sample_parallel(PlanePoint, Parallel.data(), &Jobs);
+				bool PlaneClose = true;
+				bool PlaneParallel = true;
+				for (std::size_t i = 0; i < Count; i++) {
+					PlaneClose &= std::abs(Batch[i] - Plane(PlanePoint.get(i))) < 1e-4f;
+					PlaneParallel &= (Batch[i] == Parallel[i]);
+				}
+				aContext.check("Grid batch sampling 2D", PlaneClose);
+				aContext.check("Grid parallel sampling 2D", PlaneParallel);
+
+				std::vector<float> VolumeBatch(VolumePoint.stride());
+				Volume.sample(VolumePoint, VolumeBatch.data());
+				bool VolumeClose = true;
+				for (std::size_t i = 0; i < Count; i++)
+					VolumeClose &= std::abs(VolumeBatch[i] - Volume(VolumePoint.get(i))) < 1e-4f;
+				aContext.check("Grid batch sampling 3D (flat axis)", VolumeClose);
+
+				// Non-finite and huge coordinates clamp to the box edges, NaN to the lower one.
+				const float Infinity = std::numeric_limits<float>::infinity(), NaN = std::numeric_limits<float>::quiet_NaN();
+				const float Corner = Plane[Plane.size() - 1];
+				math::vec_array<float, 2> EdgePoint(4);
+				EdgePoint.set(0, { NaN, NaN });
+				EdgePoint.set(1, { Infinity, Infinity });
+				EdgePoint.set(2, { 1e30f, 1e30f });
+				EdgePoint.set(3, { -Infinity, NaN });
+				std::vector<float> Edge(EdgePoint.stride());
+				Plane.sample(EdgePoint, Edge.data());
+				aContext.check("Grid sampling clamps non-finite coordinates",
+					(Plane({ NaN, NaN }) == Plane[0]) && (Plane({ Infinity, Infinity }) == Corner) && (Plane({ 1e30f, 1e30f }) == Corner) &&
+					(Edge[0] == Plane[0]) && (Edge[1] == Corner) && (Edge[2] == Corner) && (Edge[3] == Plane[0]));
+
+				// A grid without nodes reads as its background.
+				math::grid<float, 2, float> Empty;
+				math::grid<float, 2, float, math::bricked<>> EmptyBricked({ 0.0f, 0.0f }, { 1.0f, 1.0f }, { 0, 4 }, 7.0f);
+				std::vector<float> EmptyBatch(PlanePoint.stride(), -1.0f);
+				Empty.sample(PlanePoint, EmptyBatch.data());
+				bool EmptyBackground = (Empty({ 0.5f, 0.5f }) == 0.0f) && (EmptyBricked({ 0.5f, 0.5f }) == 7.0f);
+				for (std::size_t i = 0; i < Count; i++) EmptyBackground &= (EmptyBatch[i] == 0.0f);
+				aContext.check("Empty grid samples its background", EmptyBackground);
+			});
+
+			// Test bricked grid storage
+			aTest.add("grid_bricked", [](test::context& aContext) {
+				using sparse = math::grid<float, 3, float, math::bricked<8>>;
+				using dense = math::grid<float, 3, float>;
+				math::vec<float, 3> Lower = { -1.0f, -1.0f, -1.0f };
+				math::vec<float, 3> Upper = { 1.0f, 1.0f, 1.0f };
+				math::vec<std::size_t, 3> Count = { 95, 88, 70 };
+
+				// Two small blobs in opposite corners, the rest of the box is background.
+				sparse A(Lower, Upper, Count, 0.0f), B(Lower, Upper, Count, 0.0f);
+				dense DenseA(Lower, Upper, Count, 0.0f), DenseB(Lower, Upper, Count, 0.0f);
+				for (std::size_t z = 0; z < 6; z++) for (std::size_t y = 0; y < 6; y++) for (std::size_t x = 0; x < 6; x++) {
+					std::size_t Near = x + Count[0] * (y + Count[1] * z);
+					std::size_t Far = (Count[0] - 1 - x) + Count[0] * ((Count[1] - 1 - y) + Count[1] * (Count[2] - 1 - z));
+					A[Near] = DenseA[Near] = float(x + y + z);
+					B[Far] = DenseB[Far] = float(x * y) - float(z);
+				}
+				aContext.check("Bricked grid allocates only touched bricks", (A.Storage.Occupied == 1) && (B.Storage.Occupied == 1));
+				aContext.check("Bricked grid memory below dense", A.memory() * 100 < DenseA.memory());
+
+				std::mt19937 Generator(121314);
+				std::uniform_real_distribution<float> Distribution(-1.2f, 1.2f);
+				bool SampleMatch = true;
+				for (int i = 0; i < 2000; i++) {
+					math::vec<float, 3> Point = { Distribution(Generator), Distribution(Generator), Distribution(Generator) };
+					SampleMatch &= std::abs(A(Point) - DenseA(Point)) < 1e-5f;
+				}
+				// Bias the probes into the occupied corner so interpolation hits written nodes.
+				for (int i = 0; i < 2000; i++) {
+					math::vec<float, 3> Point = { -1.0f + std::abs(Distribution(Generator)) * 0.1f, -1.0f + std::abs(Distribution(Generator)) * 0.1f, -1.0f + std::abs(Distribution(Generator)) * 0.1f };
+					SampleMatch &= std::abs(A(Point) - DenseA(Point)) < 1e-5f;
+				}
+				aContext.check("Bricked grid sampling matches dense", SampleMatch);
+
+				const sparse Sum = A + B * 2.0f;
+				const dense DenseSum = DenseA + DenseB * 2.0f;
+				bool SumMatch = (Sum.Storage.Occupied == 2);
+				for (std::size_t i = 0; i < Sum.size(); i++) SumMatch &= (Sum[i] == DenseSum[i]);
+				aContext.check("Bricked grid arithmetic skips empty bricks", SumMatch);
+
+				// A constant term moves the background instead of filling every brick.
+				const sparse Shifted = A + 1.0f;
+				aContext.check("Bricked grid background shift", (Shifted.Storage.Occupied == 1) && (Shifted[Shifted.size() - 1] == 1.0f) && (Shifted[1] == A.get(1) + 1.0f));
+				aContext.check("Bricked grid read does not allocate", (A.get(A.size() - 1) == 0.0f) && (A.Storage.Occupied == 1));
+
+				sparse Cleared = A * 0.0f;
+				Cleared.Storage.compact();
+				aContext.check("Bricked grid compact releases background bricks", Cleared.Storage.Occupied == 0);
+			});
+
+			// Test FFT and field convolution
+			aTest.add("fft", [](test::context& aContext) {
+				std::mt19937 Generator(151617);
+				std::uniform_real_distribution<float> Distribution(-1.0f, 1.0f);
+
+				// Naive DFT in double as the reference, error relative to the signal's L2 norm.
+				auto dft = [](const std::vector<math::complex<float>>& aIn) {
+					const double Pi = 3.14159265358979323846;
+					std::vector<std::complex<double>> Out(aIn.size());
+					for (std::size_t k = 0; k < aIn.size(); k++) {
+						std::complex<double> Sum = 0.0;
+						for (std::size_t j = 0; j < aIn.size(); j++)
+							Sum += std::complex<double>(aIn[j][0], aIn[j][1]) * std::polar(1.0, -2.0 * Pi * double((j * k) % aIn.size()) / double(aIn.size()));
+						Out[k] = Sum;
+					}
+					return Out;
+				};
+
+				bool ForwardMatch = true;
+				bool RoundTrip = true;
+				// Powers of two, mixed radix, a generic radix 7 and Bluestein lengths.
+				for (std::size_t Size : { 1, 2, 3, 8, 12, 60, 97, 128, 210, 1000, 1031 }) {
+					std::vector<math::complex<float>> Signal(Size);
+					for (math::complex<float>& Value : Signal) Value = math::complex<float>(Distribution(Generator), Distribution(Generator));
+					std::vector<std::complex<double>> Expected = dft(Signal);
+					std::vector<math::complex<float>> Spectrum = Signal;
+					math::fft<float> Plan(Size);
+					Plan.forward(Spectrum.data());
+					double Error = 0.0, Norm = 0.0;
+					for (std::size_t k = 0; k < Size; k++) {
+						Error += std::norm(std::complex<double>(Spectrum[k][0], Spectrum[k][1]) - Expected[k]);
+						Norm += std::norm(Expected[k]);
+					}
+					ForwardMatch &= std::sqrt(Error / Norm) < 1e-5;
+					Plan.inverse(Spectrum.data());
+					for (std::size_t k = 0; k < Size; k++) RoundTrip &= math::abs(Spectrum[k] - Signal[k]) < 1e-5f;
+				}
+				aContext.check("FFT forward matches DFT", ForwardMatch);
+				aContext.check("FFT inverse round trip", RoundTrip);
+
+				// 2D transform against a row then column DFT.
+				math::vec<std::size_t, 2> Count = { 6, 35 };
+				std::vector<math::complex<float>> Plane(Count[0] * Count[1]);
+				for (math::complex<float>& Value : Plane) Value = math::complex<float>(Distribution(Generator), Distribution(Generator));
+				std::vector<math::complex<float>> Reference = Plane;
+				for (std::size_t y = 0; y < Count[1]; y++) {
+					std::vector<math::complex<float>> Row(Reference.begin() + y * Count[0], Reference.begin() + (y + 1) * Count[0]);
+					std::vector<std::complex<double>> Out = dft(Row);
+					for (std::size_t x = 0; x < Count[0]; x++) Reference[y * Count[0] + x] = math::complex<float>(float(Out[x].real()), float(Out[x].imag()));
+				}
+				for (std::size_t x = 0; x < Count[0]; x++) {
+					std::vector<math::complex<float>> Column(Count[1]);
+					for (std::size_t y = 0; y < Count[1]; y++) Column[y] = Reference[y * Count[0] + x];
+					std::vector<std::complex<double>> Out = dft(Column);
+					for (std::size_t y = 0; y < Count[1]; y++) Reference[y * Count[0] + x] = math::complex<float>(float(Out[y].real()), float(Out[y].imag()));
+				}
+				math::fft_nd<float, 2> PlaneTransform(Count);
+				std::vector<math::complex<float>> Threaded = Plane;
+				PlaneTransform.forward(Plane.data());
+				job_system Jobs(3);
+				PlaneTransform.forward(Threaded.data(), &Jobs);
+				bool PlaneMatch = true;
+				bool ThreadMatch = true;
+				for (std::size_t i = 0; i < Plane.size(); i++) {
+					PlaneMatch &= math::abs(Plane[i] - Reference[i]) < 1e-4f;
+					ThreadMatch &= (Plane[i][0] == Threaded[i][0]) && (Plane[i][1] == Threaded[i][1]);
+				}
+				aContext.check("FFT 2D matches separable DFT", PlaneMatch);
+				aContext.check("FFT 2D threaded matches serial", ThreadMatch);
+
+				// Convolution of a 3D field with an asymmetric kernel, against direct summation.
+				math::grid<float, 3, float> Field({ 0.0f, 0.0f, 0.0f }, { 1.0f, 2.0f, 3.0f }, { 23, 17, 9 }, 0.0f);
+				math::grid<float, 3, float> Kernel({ -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f }, { 5, 4, 3 }, 0.0f);
+				for (std::size_t i = 0; i < Field.size(); i++) Field[i] = Distribution(Generator);
+				for (std::size_t i = 0; i < Kernel.size(); i++) Kernel[i] = Distribution(Generator);
+				math::grid<float, 3, float> Fast = math::convolve(Field, Kernel, &Jobs);
+				math::grid<float, 3, float> Direct = math::convolve_direct(Field, Kernel);
+				bool ConvolveMatch = true;
+				for (std::size_t i = 0; i < Field.size(); i++) ConvolveMatch &= std::abs(Fast[i] - Direct[i]) < 1e-4f;
+				aContext.check("FFT convolution matches direct", ConvolveMatch);
+
+				// A normalized blur leaves a constant field unchanged away from the boundary.
+				math::grid<float, 2, float> Constant({ 0.0f, 0.0f }, { 1.0f, 1.0f }, { 64, 64 }, 3.0f);
+				math::grid<float, 2, float> Gaussian = math::gaussian_kernel(Constant, 0.03f);
+				math::grid<float, 2, float> Blurred = math::convolve(Constant, Gaussian);
+				aContext.check("Gaussian blur preserves interior", std::abs(Blurred[32 + 64 * 32] - 3.0f) < 1e-4f);
+			});
+
+			// Test constexpr math. The static_asserts are the test, a failure stops the build.
+			aTest.add("constexpr", [](test::context& aContext) {
+				namespace cx = math::constant;
+
+				constexpr cx::vec<float, 3> A = { 2.0f, 1.0f, -3.0f };
+				constexpr cx::vec<float, 3> B = { 0.0f, -2.0f, 4.0f };
+				static_assert(A + B == cx::vec<float, 3>(2.0f, -1.0f, 1.0f), "constexpr vec addition");
+				static_assert(A - B == cx::vec<float, 3>(2.0f, 3.0f, -7.0f), "constexpr vec subtraction");
+				static_assert(-A == cx::vec<float, 3>(-2.0f, -1.0f, 3.0f), "constexpr vec negation");
+				static_assert(A * 2.0f == cx::vec<float, 3>(4.0f, 2.0f, -6.0f), "constexpr vec scaling");
+				static_assert(A * B == -14.0f, "constexpr vec dot");
+				static_assert((A ^ B) == cx::vec<float, 3>(-2.0f, -8.0f, -4.0f), "constexpr vec cross");
+				static_assert(cx::length(cx::vec<float, 2>(3.0f, 4.0f)) == 5.0f, "constexpr vec length");
+
+				constexpr cx::mat<float, 4, 4> M = cx::mat<float, 4, 4>(
+					1.0f, 0.0f, 0.0f, 1.0f,
+					2.0f, 1.0f, -1.0f, 2.0f,
+					3.0f, 2.0f, 0.0f, 3.0f,
+					4.0f, 3.0f, 1.0f, 5.0f
+				);
+				static_assert(M(1, 2) == -1.0f && M.Data[1] == 2.0f, "constexpr mat row-major construction, column-major storage");
+				static_assert(cx::determinant(M) == 2.0f, "constexpr mat determinant");
+				static_assert(cx::determinant(cx::identity<double, 5>() * 2.0) == 32.0, "constexpr mat determinant 5x5");
+				static_assert(M * cx::identity<float, 4>() == M, "constexpr mat identity product");
+				static_assert(M + M == M * 2.0f, "constexpr mat addition");
+				static_assert(M - M == cx::mat<float, 4, 4>(), "constexpr mat subtraction");
+				static_assert(-M + M == cx::mat<float, 4, 4>(), "constexpr mat negation");
+				static_assert((M * 4.0f) / 2.0f == M * 2.0f, "constexpr mat division");
+				static_assert(cx::transpose(cx::transpose(M)) == M, "constexpr mat transpose");
+				static_assert(M * cx::vec<float, 4>(1.0f, 0.0f, 0.0f, 0.0f) == cx::vec<float, 4>(1.0f, 2.0f, 3.0f, 4.0f), "constexpr mat vec product");
+				static_assert(cx::determinant(cx::y_up_to_z_up<float>()) == 1.0f, "constexpr basis change is a rotation");
+				static_assert(cx::y_up_to_z_up<float>() * cx::vec<float, 4>(0.0f, 1.0f, 0.0f, 0.0f) == cx::vec<float, 4>(0.0f, 0.0f, 1.0f, 0.0f), "constexpr basis change maps Y to Z");
+
+				constexpr cx::complex<float> C(1.0f, 2.0f), D(3.0f, 4.0f);
+				static_assert(C * D == cx::complex<float>(-5.0f, 10.0f), "constexpr complex multiply");
+				static_assert(~C == cx::complex<float>(1.0f, -2.0f), "constexpr complex conjugate");
+				static_assert(C + D == cx::complex<float>(4.0f, 6.0f), "constexpr complex addition");
+				static_assert(C - D == cx::complex<float>(-2.0f, -2.0f), "constexpr complex subtraction");
+				static_assert(-C == cx::complex<float>(-1.0f, -2.0f), "constexpr complex negation");
+				static_assert(C * 2.0f == cx::complex<float>(2.0f, 4.0f), "constexpr complex scaling");
+				static_assert(D / 2.0f == cx::complex<float>(1.5f, 2.0f), "constexpr complex division");
+				static_assert(cx::abs(D) == 5.0f, "constexpr complex abs");
+
+				// Transcendental helpers fold to within a few ulp of the runtime library.
+				constexpr cx::mat<float, 4, 4> Quarter = cx::rotation<float>({ 0.0f, 0.0f, 2.0f }, cx::Pi<float> / 2.0f);
+				static_assert(cx::abs(Quarter(0, 1) + 1.0f) < 1e-6f && cx::abs(Quarter(1, 0) - 1.0f) < 1e-6f && cx::abs(Quarter(0, 0)) < 1e-6f, "constexpr rotation");
+				constexpr cx::mat<float, 4, 4> Projection = cx::perspective(cx::Pi<float> / 2.0f, 2.0f, 0.1f, 100.0f);
+				static_assert(cx::abs(Projection(1, 1) - 1.0f) < 1e-6f && cx::abs(Projection(0, 0) - 0.5f) < 1e-6f, "constexpr perspective");
+
+				aContext.check("Constexpr math static_asserts", true);
+
+				// cos keeps its precision at its zeros and far from the origin.
+				bool Trig = true;
+				for (float X : { cx::Pi<float> / 2.0f, 3.0f * cx::Pi<float> / 2.0f, -cx::Pi<float> / 2.0f, 1.0f, -7.5f, 1000.0f, 1e22f, -1e30f, 3.4e38f }) {
+					Trig = Trig && (std::abs(cx::cos(X) - (float)std::cos((double)X)) <= 1e-6f * std::abs((float)std::cos((double)X)) + 1e-12f);
+					Trig = Trig && (std::abs(cx::sin(X) - (float)std::sin((double)X)) <= 1e-6f * std::abs((float)std::sin((double)X)) + 1e-12f);
+				}
+				aContext.check("Constexpr sin and cos match the runtime library", Trig);
+				static_assert(cx::abs(cx::sin(1e30f) + 0.79116344f) < 1e-6f, "constexpr sin reduces huge angles exactly");
+				aContext.check("Constexpr sin and cos of huge doubles", (std::abs(cx::sin(1e300) - std::sin(1e300)) < 1e-15) && (std::abs(cx::cos(-1e22) - std::cos(-1e22)) < 1e-15));
+				aContext.check("Constexpr sin of NaN and infinity", std::isnan(cx::sin(std::nanf(""))) && std::isnan(cx::cos(HUGE_VALF)));
+
+				// The folded types must agree with the engine's runtime operators.
+				math::vec<float, 3> RuntimeA = A, RuntimeB = B;
+				math::vec<float, 3> RuntimeCross = RuntimeA ^ RuntimeB;
+				constexpr cx::vec<float, 3> Cross = A ^ B;
+				aContext.check("Constexpr vec matches engine", ((RuntimeA * RuntimeB) == (A * B)) && (RuntimeCross[0] == Cross[0]) && (RuntimeCross[1] == Cross[1]) && (RuntimeCross[2] == Cross[2]));
+
+				math::mat<float, 4, 4> RuntimeM = M;
+				constexpr cx::mat<float, 4, 4> Square = M * M;
+				math::mat<float, 4, 4> RuntimeSquare = RuntimeM * RuntimeM;
+				bool MatMatch = float_equal(math::determinant(RuntimeM), cx::determinant(M));
+				for (std::size_t r = 0; r < 4; r++) for (std::size_t c = 0; c < 4; c++) MatMatch &= (RuntimeSquare(r, c) == Square(r, c));
+				aContext.check("Constexpr mat matches engine", MatMatch);
+
+				math::complex<float> RuntimeProduct = math::complex<float>(C) * math::complex<float>(D);
+				aContext.check("Constexpr complex matches engine", (RuntimeProduct[0] == (C * D)[0]) && (RuntimeProduct[1] == (C * D)[1]));
+			});
+
+		}
+
+		test::suite MathSuite("math", register_math);
+
+	}
+
+}
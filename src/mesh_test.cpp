@@ -0,0 +1,223 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/mesh_optimizer.h>
+
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <random>
+#include <filesystem>
+
+// Import time mesh optimization: vertex cache and fetch order, quantization, meshlets and
+// the cache they are stored in.
+
+namespace geodesy {
+
+	namespace {
+
+		// Triangles of an N x N quad grid, two per quad, in shuffled order.
+		std::vector<uint32_t> shuffled_grid(uint32_t aSize, uint32_t aSeed) {
+			std::vector<std::array<uint32_t, 3>> Triangle;
+			for (uint32_t y = 0; y < aSize; y++) {
+				for (uint32_t x = 0; x < aSize; x++) {
+					uint32_t A = y * (aSize + 1) + x, B = A + 1, C = A + aSize + 1, D = C + 1;
+					Triangle.push_back({ A, B, D });
+					Triangle.push_back({ A, D, C });
+				}
+			}
+			std::mt19937 Random(aSeed);
+			std::shuffle(Triangle.begin(), Triangle.end(), Random);
+			std::vector<uint32_t> Index;
+			for (const std::array<uint32_t, 3>& T : Triangle) Index.insert(Index.end(), T.begin(), T.end());
+			return Index;
+		}
+
+		// Triangles rotated to start at their smallest index, then sorted, so two lists of
+		// the same triangles with the same winding compare equal.
+		std::vector<std::array<uint32_t, 3>> canonical(const std::vector<uint32_t>& aIndex) {
+			std::vector<std::array<uint32_t, 3>> Triangle;
+			for (std::size_t i = 0; i < aIndex.size(); i += 3) {
+				std::array<uint32_t, 3> T = { aIndex[i], aIndex[i + 1], aIndex[i + 2] };
+				std::rotate(T.begin(), std::min_element(T.begin(), T.end()), T.end());
+				Triangle.push_back(T);
+			}
+			std::sort(Triangle.begin(), Triangle.end());
+			return Triangle;
+		}
+
+		void register_mesh(test& aTest) {
+			aTest.add("vertex cache", [](test::context& aContext) {
+				io::vertex_cache_statistics One = io::analyze_vertex_cache({ 0, 1, 2 }, 3);
+				io::vertex_cache_statistics Quad = io::analyze_vertex_cache({ 0, 1, 2, 2, 1, 3 }, 4);
+				aContext.check("Known ratios", (One.ACMR == 3.0) && (One.ATVR == 1.0) && (Quad.ACMR == 2.0) && (Quad.Misses == 4));
+				// A vertex pushed out of a two entry cache is transformed again.
+				io::vertex_cache_statistics Small = io::analyze_vertex_cache({ 0, 1, 2, 0, 2, 3 }, 4, 2);
+				aContext.check("FIFO eviction", (Small.Misses == 5) && (Small.ATVR == 5.0 / 4.0));
+
+				std::vector<uint32_t> Index = shuffled_grid(64, 1);
+				std::size_t VertexCount = 65 * 65;
+				io::vertex_cache_statistics Before = io::analyze_vertex_cache(Index, VertexCount);
+				std::vector<uint32_t> Optimized = Index;
+				io::optimize_vertex_cache(Optimized, VertexCount);
+				io::vertex_cache_statistics After = io::analyze_vertex_cache(Optimized, VertexCount);
+				aContext.check("Same triangles and winding", canonical(Optimized) == canonical(Index));
+				aContext.check("Grid close to one vertex per triangle", (Before.ACMR > 2.5) && (After.ACMR < 0.8) && (After.ATVR < 1.6));
+
+				std::vector<uint32_t> Remap;
+				std::vector<uint32_t> Fetch = { 5, 2, 7, 2, 7, 0 };
+				std::size_t Used = io::optimize_vertex_fetch(Fetch, 8, Remap);
+				aContext.check("First use order", (Used == 4) && (Fetch == std::vector<uint32_t>{ 0, 1, 2, 1, 2, 3 }) && (Remap[5] == 0) && (Remap[0] == 3) && (Remap[1] == UINT32_MAX));
+				bool Threw = false;
+				try { io::optimize_vertex_cache(Fetch, 3); }
+				catch (const std::out_of_range&) { Threw = true; }
+				aContext.check("Index out of range", Threw);
+			});
+
+			aTest.add("quantize", [](test::context& aContext) {
+				bool Round = true;
+				for (float V : { 0.0f, 1.0f, -2.5f, 0.333f, 65504.0f, 6.0e-5f, 1.0e-7f }) Round = Round && (std::abs(io::detail::from_half(io::detail::to_half(V)) - V) <= std::abs(V) / 1024.0f + 6.0e-8f);
+				aContext.check("Half round trip", Round && (io::detail::to_half(1.0f) == 0x3C00) && (io::detail::to_half(-2.0f) == 0xC000) && (io::detail::to_half(1.0e6f) == 0x7C00));
+
+				std::mt19937 Random(2);
+				std::normal_distribution<float> Gauss;
+				float Worst = 1.0f;
+				for (int i = 0; i < 10000; i++) {
+					float N[3] = { Gauss(Random), Gauss(Random), Gauss(Random) }, Out[3];
+					float Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+					for (float& C : N) C /= Length;
+					io::detail::decode_octahedral(io::detail::encode_octahedral(N), Out);
+					Worst = std::min(Worst, N[0] * Out[0] + N[1] * Out[1] + N[2] * Out[2]);
+				}
+				aContext.check("Octahedral normals within 0.1 degrees", Worst > std::cos(0.1f * 3.14159265f / 180.0f));
+			});
+
+			aTest.add("model", [](test::context& aContext) {
+				io::gltf Model = io::gltf::load("assets/models/pirate_map/scene.gltf");
+				io::mesh_options Quantized;
+				Quantized.Quantize = true;
+				bool Better = true, Same = true, Close = true, Smaller = true, Limits = true, Covered = true, Bounded = true;
+				for (std::size_t m = 0; m < Model.Mesh.size(); m++) {
+					io::optimized_mesh Float = io::optimize_mesh(Model, m, 0);
+					io::optimized_mesh Packed = io::optimize_mesh(Model, m, 0, Quantized);
+					Better = Better && (Float.After.ACMR <= Float.Before.ACMR) && (Float.After.ATVR <= Float.Before.ATVR);
+
+					// Every authored triangle is still there, through the remap.
+					io::optimized_mesh Source = io::optimize_mesh(Model, m, 0, { false, false, 64, 0, 16 });
+					std::vector<float> Key, Expected;
+					for (uint32_t I : Float.Index) Key.insert(Key.end(), &Float.Position[3 * I], &Float.Position[3 * I] + 3);
+					for (uint32_t I : Source.Index) Expected.insert(Expected.end(), &Source.Position[3 * I], &Source.Position[3 * I] + 3);
+					auto triangles = [](const std::vector<float>& aCorner) {
+						std::vector<std::array<float, 9>> T(aCorner.size() / 9);
+						for (std::size_t t = 0; t < T.size(); t++) {
+							std::copy_n(&aCorner[9 * t], 9, T[t].begin());
+							// Rotate to the smallest corner so winding is kept.
+							std::size_t Start = 0;
+							for (std::size_t c = 1; c < 3; c++) if (std::lexicographical_compare(&T[t][3 * c], &T[t][3 * c] + 3, &T[t][3 * Start], &T[t][3 * Start] + 3)) Start = c;
+							std::rotate(T[t].begin(), T[t].begin() + 3 * Start, T[t].end());
+						}
+						std::sort(T.begin(), T.end());
+						return T;
+					};
+					Same = Same && (triangles(Key) == triangles(Expected));
+
+					for (std::size_t v = 0; v < Float.VertexCount; v++) {
+						float P[3], Q[3], N[3], M[3], U[2], W[2];
+						Float.position(v, P);
+						Packed.position(v, Q);
+						Float.normal(v, N);
+						Packed.normal(v, M);
+						Float.texcoord(v, U);
+						Packed.texcoord(v, W);
+						for (std::size_t k = 0; k < 3; k++) Close = Close && (std::abs(P[k] - Q[k]) <= 0.51f * Packed.PositionScale[k]);
+						float NL = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+						Close = Close && ((NL < 0.5f) || ((N[0] * M[0] + N[1] * M[1] + N[2] * M[2]) / NL > 0.9999f));
+						for (std::size_t k = 0; k < 2; k++) Close = Close && (std::abs(U[k] - W[k]) <= std::abs(U[k]) / 1024.0f + 1e-7f);
+					}
+					Smaller = Smaller && (Packed.After.VertexBytes * 2 == Float.After.VertexBytes) && (Float.After.VertexBytes <= Float.Before.VertexBytes) && (Packed.Index == Float.Index);
+
+					// Meshlets cover the index buffer in order and within the limits.
+					std::vector<uint32_t> Rebuilt;
+					for (const io::meshlet& L : Float.Meshlet) {
+						Limits = Limits && (L.VertexCount <= 64) && (L.TriangleCount <= 124) && (L.TriangleCount > 0);
+						for (uint32_t t = 0; t < 3 * L.TriangleCount; t++) Rebuilt.push_back(Float.MeshletVertex[L.VertexOffset + Float.MeshletTriangle[L.TriangleOffset + t]]);
+						for (uint32_t i = 0; i < L.VertexCount; i++) {
+							float P[3];
+							Float.position(Float.MeshletVertex[L.VertexOffset + i], P);
+							float D = std::sqrt((P[0] - L.Center[0]) * (P[0] - L.Center[0]) + (P[1] - L.Center[1]) * (P[1] - L.Center[1]) + (P[2] - L.Center[2]) * (P[2] - L.Center[2]));
+							Bounded = Bounded && (D <= L.Radius * 1.0001f + 1e-6f);
+						}
+					}
+					Covered = Covered && (Rebuilt == Float.Index) && io::detail::consistent(Float) && io::detail::consistent(Packed);
+				}
+				aContext.check("Cache statistics improve", Better);
+				aContext.check("Same triangles", Same);
+				aContext.check("Quantized within about half a step", Close);
+				aContext.check("Half the vertex bytes", Smaller);
+				aContext.check("Meshlet limits", Limits);
+				aContext.check("Meshlets cover the index buffer", Covered);
+				aContext.check("Meshlet spheres bound their vertices", Bounded);
+
+				bool Threw = false;
+				try { io::optimize_mesh(Model, 0, 0, { true, false, 300, 124, 16 }); }
+				catch (const std::invalid_argument&) { Threw = true; }
+				aContext.check("Meshlet vertex limit checked", Threw);
+			});
+
+			aTest.add("meshlet cone", [](test::context& aContext) {
+				// A flat patch facing +z is back facing from below and never from above.
+				io::meshlet Patch{};
+				Patch.Center[2] = 0.0f;
+				Patch.Radius = 1.0f;
+				Patch.ConeAxis[2] = 1.0f;
+				Patch.ConeCutoff = 0.0f;
+				float Below[3] = { 0.0f, 0.0f, -5.0f }, Above[3] = { 0.0f, 0.0f, 5.0f }, Edge[3] = { 5.0f, 0.0f, -0.5f };
+				aContext.check("Flat patch", Patch.backfacing(Below) && !Patch.backfacing(Above) && !Patch.backfacing(Edge));
+				Patch.ConeCutoff = 1.0f;
+				aContext.check("Wide cone never culls", !Patch.backfacing(Below));
+			});
+
+			aTest.add("cache", [](test::context& aContext) {
+				test::scratch Scratch("mesh-test");
+				const std::filesystem::path& Directory = Scratch.path();
+				io::mesh_cache Cache((Directory / "cache").string());
+				std::string Path = "assets/models/Pigwithanimation.gltf";
+
+				io::mesh_report Cold, Warm;
+				std::vector<io::optimized_mesh> A = Cache.load(Path, io::mesh_options(), &Cold);
+				std::vector<io::optimized_mesh> B = Cache.load(Path, io::mesh_options(), &Warm);
+				aContext.check("First load optimizes and stores", !Cold.Hit && Cold.Stored && (A.size() == 4));
+				aContext.check("Second load from cache", Warm.Hit && (Warm.Optimize == 0.0));
+				bool Identical = A.size() == B.size();
+				for (std::size_t i = 0; Identical && (i < A.size()); i++) {
+					Identical = (A[i].Index == B[i].Index) && (A[i].Position == B[i].Position) && (A[i].Normal == B[i].Normal) && (A[i].Texcoord == B[i].Texcoord) && (A[i].Joint == B[i].Joint) && (A[i].Weight == B[i].Weight);
+					Identical = Identical && (A[i].MeshletVertex == B[i].MeshletVertex) && (A[i].MeshletTriangle == B[i].MeshletTriangle) && (A[i].Meshlet.size() == B[i].Meshlet.size());
+					Identical = Identical && (A[i].Before.ACMR == B[i].Before.ACMR) && (A[i].After.ATVR == B[i].After.ATVR) && (A[i].Mesh == B[i].Mesh) && (A[i].Primitive == B[i].Primitive);
+				}
+				aContext.check("Cached meshes identical", Identical && (A[0].Joint.size() == 4 * (std::size_t)A[0].VertexCount) && A[2].Joint.empty());
+				aContext.check("Report", (Warm.Entry.size() == 4) && (Warm.bytes_after() <= Warm.bytes_before()) && (Warm.to_string().find("ACMR") != std::string::npos));
+
+				io::mesh_options Quantized;
+				Quantized.Quantize = true;
+				io::mesh_report Other;
+				std::vector<io::optimized_mesh> C = Cache.load(Path, Quantized, &Other);
+				aContext.check("Different options miss", !Other.Hit && C[0].Quantized && (Other.bytes_after() < Warm.bytes_after()));
+
+				// A corrupt entry is ignored and replaced.
+				io::gltf Model = io::gltf::load(Path);
+				io::mapped_file Source(Path);
+				std::string Entry = Cache.path_for(io::mesh_cache::key(Source.data(), Source.size(), Model, io::mesh_options()));
+				Source.close();
+				std::filesystem::resize_file(Entry, 1000);
+				io::mesh_report Repaired, After;
+				Cache.load(Path, io::mesh_options(), &Repaired);
+				Cache.load(Path, io::mesh_options(), &After);
+				aContext.check("Truncated entry falls back to optimizing", !Repaired.Hit && Repaired.Stored && After.Hit);
+			});
+		}
+
+		test::suite MeshSuite("mesh", register_mesh);
+
+	}
+
+}
@@ -0,0 +1,147 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/physics.h>
+
+#include <cmath>
+#include <random>
+
+// Fixed step sphere physics: settings from the world file, resting and colliding bodies,
+// and bit for bit determinism across thread counts.
+
+namespace geodesy {
+
+	namespace {
+
+		// Spheres dropped into a 10 x 10 m box open at the top.
+		physics_world make_pile(std::size_t aCount, uint32_t aSeed) {
+			physics_world World;
+			World.add_plane({ 0.0f, 0.0f, 1.0f }, 0.0f);
+			World.add_plane({ 1.0f, 0.0f, 0.0f }, -5.0f);
+			World.add_plane({ -1.0f, 0.0f, 0.0f }, -5.0f);
+			World.add_plane({ 0.0f, 1.0f, 0.0f }, -5.0f);
+			World.add_plane({ 0.0f, -1.0f, 0.0f }, -5.0f);
+			std::mt19937 Random(aSeed);
+			std::uniform_real_distribution<float> Spread(-4.5f, 4.5f), Size(0.2f, 0.4f);
+			for (std::size_t i = 0; i < aCount; i++) {
+				World.add_sphere({ Spread(Random), Spread(Random), 0.5f + 0.3f * (float)i / 10.0f }, Size(Random), 1.0f + Size(Random));
+			}
+			// A static post in the middle.
+			World.add_sphere({ 0.0f, 0.0f, 0.5f }, 1.0f, 0.0f);
+			return World;
+		}
+
+		float speed(const math::vec<float, 3>& aVelocity) {
+			return std::sqrt(aVelocity[0] * aVelocity[0] + aVelocity[1] * aVelocity[1] + aVelocity[2] * aVelocity[2]);
+		}
+
+		void register_physics(test& aTest) {
+			aTest.add("settings", [](test::context& aContext) {
+				io::world_description Description{};
+				Description.Gravity = { 0.0f, 0.0f, -9.81f };
+				Description.TimeStep = 0.016667f;
+				Description.VelocityIterations = 8;
+				Description.PositionIterations = 3;
+				physics_settings Settings = physics_settings::from_world(Description);
+				aContext.check("Physics block", (Settings.Gravity[2] == -9.81f) && (Settings.TimeStep == 0.016667f) && (Settings.VelocityIterations == 8) && (Settings.PositionIterations == 3));
+				Description.TimeStep = 0.0f;
+				Description.VelocityIterations = 0;
+				aContext.check("Missing values keep defaults", (physics_settings::from_world(Description).TimeStep > 0.0f) && (physics_settings::from_world(Description).VelocityIterations == 8));
+
+				physics_world World(Settings);
+				World.add_sphere({ 0.0f, 0.0f, 10.0f }, 0.5f, 1.0f);
+				std::size_t Steps = 0;
+				for (int Frame = 0; Frame < 60; Frame++) Steps += World.step(1.0f / 60.0f);
+				aContext.check("One step per frame at the world's rate", (Steps >= 59) && (Steps <= 60));
+				aContext.check("Long frames capped", World.step(1.0f) == Settings.MaxSubSteps);
+				bool Threw = false;
+				try { World.add_sphere({ 0.0f, 0.0f, 0.0f }, 0.0f, 1.0f); }
+				catch (const std::invalid_argument&) { Threw = true; }
+				aContext.check("Zero radius rejected", Threw);
+			});
+
+			aTest.add("rest", [](test::context& aContext) {
+				physics_world World;
+				World.add_plane({ 0.0f, 0.0f, 2.0f }, 0.0f);
+				physics_world::id Ball = World.add_sphere({ 0.0f, 0.0f, 3.0f }, 0.5f, 2.0f);
+				float Highest = 0.0f;
+				bool Bounced = false;
+				for (int Step = 0; Step < 300; Step++) {
+					World.substep();
+					float Z = World.position(Ball)[2];
+					if ((Step > 30) && (World.velocity(Ball)[2] > 0.5f)) Bounced = true;
+					if (Step > 200) Highest = std::max(Highest, Z);
+				}
+				aContext.check("Bounces off the floor", Bounced);
+				aContext.check("Comes to rest on the floor", (std::abs(World.position(Ball)[2] - 0.5f) < 0.01f) && (Highest < 0.52f) && (speed(World.velocity(Ball)) < 0.2f));
+				aContext.check("One island", (World.stats().Islands == 1) && (World.stats().Contacts == 1) && (World.stats().LargestIsland == 1));
+			});
+
+			aTest.add("collision", [](test::context& aContext) {
+				physics_settings Settings;
+				Settings.Gravity = { 0.0f, 0.0f, 0.0f };
+				Settings.Restitution = 1.0f;
+				physics_world World(Settings);
+				physics_world::id A = World.add_sphere({ -1.0f, 0.0f, 0.0f }, 0.5f, 1.0f, { 2.0f, 0.0f, 0.0f });
+				physics_world::id B = World.add_sphere({ 1.0f, 0.0f, 0.0f }, 0.5f, 1.0f, { -2.0f, 0.0f, 0.0f });
+				physics_world::id Heavy = World.add_sphere({ 0.0f, 5.0f, 0.0f }, 0.5f, 3.0f, { 0.0f, -1.0f, 0.0f });
+				physics_world::id Light = World.add_sphere({ 0.0f, 7.0f, 0.0f }, 0.5f, 1.0f, { 0.0f, -3.0f, 0.0f });
+				for (int Step = 0; Step < 60; Step++) World.substep();
+				aContext.check("Equal masses swap velocities", (std::abs(World.velocity(A)[0] + 2.0f) < 1e-3f) && (std::abs(World.velocity(B)[0] - 2.0f) < 1e-3f));
+				float Momentum = 3.0f * World.velocity(Heavy)[1] + World.velocity(Light)[1];
+				float Energy = 1.5f * World.velocity(Heavy)[1] * World.velocity(Heavy)[1] + 0.5f * World.velocity(Light)[1] * World.velocity(Light)[1];
+				aContext.check("Momentum kept", std::abs(Momentum + 6.0f) < 1e-3f);
+				aContext.check("Elastic", std::abs(Energy - 6.0f) < 1e-2f);
+				aContext.check("Separated", (World.position(B)[0] - World.position(A)[0] > 1.0f) && (World.stats().Contacts == 0));
+
+				// A static body is never moved.
+				physics_world Wall(Settings);
+				physics_world::id Post = Wall.add_sphere({ 0.0f, 0.0f, 0.0f }, 1.0f, 0.0f, { 5.0f, 0.0f, 0.0f });
+				physics_world::id Ball = Wall.add_sphere({ 3.0f, 0.0f, 0.0f }, 0.5f, 1.0f, { -2.0f, 0.0f, 0.0f });
+				for (int Step = 0; Step < 60; Step++) Wall.substep();
+				aContext.check("Static body stays", (Wall.position(Post)[0] == 0.0f) && (Wall.velocity(Post)[0] == 0.0f));
+				aContext.check("Ball reflected", std::abs(Wall.velocity(Ball)[0] - 2.0f) < 1e-3f);
+			});
+
+			aTest.add("pile", [](test::context& aContext) {
+				physics_world World = make_pile(300, 21);
+				for (int Step = 0; Step < 600; Step++) World.substep();
+				bool Inside = true;
+				float Fastest = 0.0f;
+				for (physics_world::id i = 0; i < 300; i++) {
+					math::vec<float, 3> P = World.position(i);
+					Inside = Inside && (P[2] > 0.1f) && (std::abs(P[0]) < 5.0f) && (std::abs(P[1]) < 5.0f);
+					Fastest = std::max(Fastest, speed(World.velocity(i)));
+				}
+				aContext.check("Bodies stay in the box", Inside);
+				aContext.check("Pile settles", Fastest < 1.0f);
+				aContext.check("Contacts grouped", (World.stats().Contacts > 300) && (World.stats().Islands >= 1) && (World.stats().LargestIsland > 1));
+			});
+
+			aTest.add("determinism", [](test::context& aContext) {
+				physics_world Serial = make_pile(2000, 7);
+				physics_world One = make_pile(2000, 7);
+				physics_world Four = make_pile(2000, 7);
+				job_system JobsOne(1), JobsFour(4);
+				for (int Step = 0; Step < 60; Step++) {
+					Serial.substep();
+					One.substep(&JobsOne);
+					Four.substep(&JobsFour);
+				}
+				bool Same = true;
+				for (physics_world::id i = 0; i < Serial.size(); i++) {
+					for (std::size_t k = 0; k < 3; k++) {
+						Same = Same && (Serial.position(i)[k] == One.position(i)[k]) && (Serial.position(i)[k] == Four.position(i)[k]);
+						Same = Same && (Serial.velocity(i)[k] == One.velocity(i)[k]) && (Serial.velocity(i)[k] == Four.velocity(i)[k]);
+					}
+				}
+				aContext.check("Identical for any thread count", Same);
+				aContext.check("Same contacts", (Serial.stats().Contacts == Four.stats().Contacts) && (Serial.stats().Islands == Four.stats().Islands));
+			});
+		}
+
+		test::suite PhysicsSuite("physics", register_physics);
+
+	}
+
+}
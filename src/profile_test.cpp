@@ -0,0 +1,139 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/json.h>
+#include <geodesy-unit-test/profiler.h>
+
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+
+// Scope recording, per-thread rings, Chrome trace export and frame time percentiles.
+// Every case records into its own profiler, so the synthetic events and frames never
+// reach the process wide one that --trace and the frame summary report.
+
+namespace geodesy {
+
+	namespace {
+
+		std::vector<profiler::event> events_of(const profiler& aProfiler, const char* aCategory) {
+			std::vector<profiler::event> List;
+			for (const profiler::event& E : aProfiler.events()) {
+				if (std::strcmp(E.Category, aCategory) == 0) List.push_back(E);
+			}
+			return List;
+		}
+
+		void register_profile(test& aTest) {
+			aTest.add("events", [](test::context& aContext) {
+				profiler Profiler;
+				{
+					profiler::scope Outer(Profiler, "profile.nest", "outer");
+					for (int i = 0; i < 3; i++) {
+						profiler::scope Inner(Profiler, "profile.nest", "inner", Profiler.intern("step " + std::to_string(i)));
+					}
+				}
+				std::vector<profiler::event> Nest = events_of(Profiler, "profile.nest");
+				bool Contained = Nest.size() == 4;
+				for (std::size_t i = 1; Contained && (i < Nest.size()); i++) {
+					Contained = (Nest[i].Start >= Nest[0].Start) && (Nest[i].Start + Nest[i].Duration <= Nest[0].Start + Nest[0].Duration);
+				}
+				aContext.check("Outer scope first, inner scopes inside it", Contained && (std::strcmp(Nest[0].Name, "outer") == 0));
+				aContext.check("Detail kept", (Nest.size() == 4) && (std::strcmp(Nest[3].Detail, "step 2") == 0) && (Nest[0].Detail == nullptr));
+				aContext.check("Interned strings are shared", Profiler.intern("step 1") == Profiler.intern(std::string("step ") + "1"));
+
+				// A full ring keeps its newest events.
+				std::size_t Kept = 0;
+				uint64_t FirstStart = 0, LastStart = 0;
+				std::thread Writer([&]() {
+					for (uint64_t i = 0; i < profiler::ThreadCapacity + 100; i++) Profiler.record("profile.ring", "tick", nullptr, i, i + 1);
+					std::vector<profiler::event> Ring = events_of(Profiler, "profile.ring");
+					Kept = Ring.size();
+					if (!Ring.empty()) {
+						FirstStart = Ring.front().Start;
+						LastStart = Ring.back().Start;
+					}
+				});
+				Writer.join();
+				aContext.check("Full ring keeps the newest events", (Kept == profiler::ThreadCapacity) && (FirstStart == 100) && (LastStart == profiler::ThreadCapacity + 99));
+
+				std::atomic<int> Recorded{ 0 };
+				std::vector<std::thread> Worker;
+				for (int t = 0; t < 4; t++) {
+					Worker.emplace_back([&, t]() {
+						Profiler.set_thread_name("profile worker " + std::to_string(t));
+						for (int i = 0; i < 50; i++) {
+							profiler::scope Work(Profiler, "profile.threads", "work");
+						}
+						// Threads stay alive until all four recorded, so each keeps its own ring.
+						Recorded++;
+						while (Recorded < 4) std::this_thread::yield();
+					});
+				}
+				for (std::thread& Thread : Worker) Thread.join();
+				std::vector<profiler::event> Threads = events_of(Profiler, "profile.threads");
+				std::vector<uint32_t> Id;
+				for (const profiler::event& E : Threads) {
+					if (std::find(Id.begin(), Id.end(), E.Thread) == Id.end()) Id.push_back(E.Thread);
+				}
+				aContext.check("Concurrent threads record without loss", (Threads.size() == 200) && (Id.size() == 4));
+
+				// Exports while a writer laps its ring, every event read must be one that was
+				// written whole, so its fields still agree with each other.
+				std::atomic<bool> Done{ false };
+				std::thread Racer([&]() {
+					for (uint64_t i = 0; i < profiler::ThreadCapacity * 8; i++) Profiler.record("profile.race", (i & 1) ? "odd" : "even", nullptr, i, 3 * i);
+					Done = true;
+				});
+				bool Consistent = true;
+				do {
+					for (const profiler::event& E : events_of(Profiler, "profile.race")) {
+						Consistent = Consistent && (E.Duration == 2 * E.Start) && (std::strcmp(E.Name, (E.Start & 1) ? "odd" : "even") == 0);
+					}
+				} while (!Done);
+				Racer.join();
+				aContext.check("Export during recording reads whole events", Consistent);
+
+				io::json Trace = io::json::parse(Profiler.to_chrome_trace());
+				const io::json& List = Trace["traceEvents"];
+				std::size_t NestCount = 0, MetadataCount = 0;
+				bool Timed = true;
+				for (std::size_t i = 0; i < List.size(); i++) {
+					if (List[i]["ph"].as_string() == "M") MetadataCount++;
+					if (List[i]["cat"].as_string() != "profile.nest") continue;
+					NestCount++;
+					Timed = Timed && (List[i]["ph"].as_string() == "X") && (List[i]["dur"].as_double(-1.0) >= 0.0) && (List[i]["tid"].as_int() > 0);
+				}
+				aContext.check("Chrome trace parses", (NestCount == 4) && Timed && (MetadataCount >= 1));
+				aContext.check("Detail in args", Profiler.to_chrome_trace().find("\"args\":{\"detail\":\"step 0\"}") != std::string::npos);
+
+				Profiler.Enabled = false;
+				{
+					profiler::scope Skipped(Profiler, "profile.disabled", "skipped");
+				}
+				aContext.check("Disabled records nothing", events_of(Profiler, "profile.disabled").empty());
+				aContext.check("Process wide profiler untouched", events_of(profiler::instance(), "profile.nest").empty() && events_of(profiler::instance(), "profile.race").empty());
+			});
+
+			aTest.add("frames", [](test::context& aContext) {
+				profiler Profiler;
+				// Fills the whole window, 1 to 1024 microseconds shuffled.
+				for (uint64_t i = 0; i < profiler::FrameCapacity; i++) Profiler.record_frame(((i * 389) % profiler::FrameCapacity + 1) * 1000);
+				profiler::frame_stats Stats = Profiler.frame_statistics();
+				auto near = [](double aA, double aB) { return std::abs(aA - aB) < 1e-9; };
+				aContext.check("Window size", Stats.Count == profiler::FrameCapacity);
+				aContext.check("Percentiles", near(Stats.P50, 0.512) && near(Stats.P90, 0.922) && near(Stats.P99, 1.014) && near(Stats.Max, 1.024));
+				aContext.check("Mean", near(Stats.Mean, 0.5125));
+				// Older frames roll out of the window.
+				for (uint64_t i = 0; i < profiler::FrameCapacity * 3 / 4; i++) Profiler.record_frame(10000000);
+				aContext.check("Rolling window", near(Profiler.frame_statistics().P50, 10.0) && (Profiler.frame_statistics().Count == profiler::FrameCapacity));
+			});
+		}
+
+		test::suite ProfileSuite("profile", register_profile);
+
+	}
+
+}
@@ -0,0 +1,62 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/json.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+// The runner's own reports and scratch directories. A failing case is run on a nested
+// test instance so its failure never reaches the process wide results.
+
+namespace geodesy {
+
+	namespace {
+
+		void register_runner(test& aTest) {
+			aTest.add("reports", [](test::context& aContext) {
+				const std::string Message = "line one\nline\ttwo\r\x01 \"quoted\" <&>";
+				test Inner;
+				Inner.add("throws", [&](test::context&) { throw std::runtime_error(Message); });
+				std::vector<test::result> ResultList = Inner.run();
+				aContext.check("Escaped exception fails the case", (ResultList.size() == 1) && !ResultList[0].Passed);
+
+				bool JsonValid = false;
+				try {
+					io::json Report = io::json::parse(test::to_json(ResultList));
+					JsonValid = Report["results"][0]["failures"][0].as_string() == "exception: " + Message;
+				}
+				catch (const std::runtime_error&) {}
+				aContext.check("JSON report parses and keeps the message", JsonValid);
+
+				// XML 1.0 allows no control characters besides tab, LF and CR, and those must be
+				// character references inside attributes to survive.
+				std::string JUnit = test::to_junit(ResultList);
+				std::size_t Start = JUnit.find("<failure message=\"");
+				std::size_t End = JUnit.find("\"/>", Start);
+				bool XmlValid = (Start != std::string::npos) && (End != std::string::npos);
+				std::string Attribute = XmlValid ? JUnit.substr(Start, End - Start) : "";
+				for (char Character : Attribute) XmlValid &= (unsigned char)Character >= 0x20;
+				XmlValid &= (Attribute.find("line one&#10;line&#9;two&#13;? &quot;quoted&quot; &lt;&amp;&gt;") != std::string::npos);
+				aContext.check("JUnit report holds the message as character references", XmlValid);
+			});
+
+			aTest.add("scratch", [](test::context& aContext) {
+				std::filesystem::path Path;
+				{
+					test::scratch Directory("runner-scratch");
+					Path = Directory.path();
+					std::ofstream(Path / "file.txt") << "scratch";
+					aContext.check("Scratch directory created and writable", std::filesystem::is_directory(Path) && (std::distance(std::filesystem::directory_iterator(Path), std::filesystem::directory_iterator()) == 1));
+				}
+				aContext.check("Scratch directory removed with its contents", !std::filesystem::exists(Path));
+			});
+		}
+
+		test::suite RunnerSuite("runner", register_runner);
+
+	}
+
+}
@@ -0,0 +1,135 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/job_system.h>
+#include <geodesy-unit-test/stage_loader.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+// Parallel stage object construction.
+
+namespace geodesy {
+
+	namespace {
+
+		std::vector<io::object_description> object_list(std::size_t aCount) {
+			std::vector<io::object_description> List(aCount);
+			for (std::size_t i = 0; i < aCount; i++) {
+				List[i] = io::object_description{};
+				List[i].Name = "Object" + std::to_string(i);
+				List[i].FrameCount = (uint32_t)i;
+			}
+			return List;
+		}
+
+		void register_stage(test& aTest) {
+			aTest.add("build_order", [](test::context& aContext) {
+				std::vector<io::object_description> List = object_list(32);
+				job_system Jobs(4);
+				std::thread::id Caller = std::this_thread::get_id();
+				std::vector<std::size_t> FinalizeOrder;
+				bool FinalizeOnCaller = true;
+				io::load_report Report;
+				std::vector<std::size_t> Result = io::build_objects<std::size_t>(List,
+					[](const io::object_description& aObject) {
+						// Later objects finish first, finalization must still be in list order.
+						std::this_thread::sleep_for(std::chrono::microseconds(200 * (32 - aObject.FrameCount)));
+						return (std::size_t)aObject.FrameCount * 10;
+					},
+					[&](std::size_t aIndex, std::size_t& aValue) {
+						FinalizeOnCaller &= (std::this_thread::get_id() == Caller);
+						FinalizeOrder.push_back(aIndex);
+						aValue += 1;
+					},
+					&Report, &Jobs
+				);
+				bool Ordered = (Result.size() == 32) && (FinalizeOrder.size() == 32);
+				for (std::size_t i = 0; Ordered && (i < 32); i++) Ordered = (Result[i] == i * 10 + 1) && (FinalizeOrder[i] == i);
+				aContext.check("Results in list order", Ordered);
+				aContext.check("Finalize on calling thread", FinalizeOnCaller);
+				bool Timed = Report.Entry.size() == 32;
+				for (std::size_t i = 0; Timed && (i < 32); i++) {
+					const io::load_report::entry& E = Report.Entry[i];
+					Timed = (E.Name == List[i].Name) && (E.Thread < 4) && (E.LoadEnd >= E.LoadStart) && (E.FinalizeStart >= E.LoadEnd) && (E.FinalizeEnd <= Report.Total);
+				}
+				aContext.check("Per object timings", Timed);
+				aContext.check("Report text", Report.to_string().find("Object31") != std::string::npos);
+			});
+
+			aTest.add("build_parallel", [](test::context& aContext) {
+				// Eight 40 ms loads on eight threads take about one load, not the sum.
+				std::vector<io::object_description> List = object_list(8);
+				job_system Jobs(8);
+				io::load_report Report;
+				io::build_objects<int>(List,
+					[](const io::object_description&) { std::this_thread::sleep_for(std::chrono::milliseconds(40)); return 1; },
+					[](std::size_t, int&) {},
+					&Report, &Jobs
+				);
+				aContext.check("Loads overlap", Report.Total < 0.5 * Report.load_sum());
+				aContext.check("Total near slowest load", Report.Total < Report.slowest_load() + 60.0);
+			});
+
+			aTest.add("build_failure", [](test::context& aContext) {
+				std::vector<io::object_description> List = object_list(16);
+				job_system Jobs(4);
+				std::size_t FinalizeCount = 0;
+				bool Threw = false;
+				try {
+					io::build_objects<int>(List,
+						[](const io::object_description& aObject) {
+							if (aObject.FrameCount == 5) throw std::runtime_error("missing model");
+							return 1;
+						},
+						[&](std::size_t, int&) { FinalizeCount++; },
+						nullptr, &Jobs
+					);
+				}
+				catch (const std::runtime_error& aError) {
+					Threw = std::string(aError.what()) == "missing model";
+				}
+				aContext.check("Load error rethrown", Threw);
+				aContext.check("Finalize stops at failed object", FinalizeCount <= 5);
+
+				// Without a job system loads and finalizes alternate on the calling thread.
+				FinalizeCount = 0;
+				Threw = false;
+				try {
+					io::build_objects<int>(List,
+						[](const io::object_description& aObject) {
+							if (aObject.FrameCount == 5) throw std::runtime_error("missing model");
+							return 1;
+						},
+						[&](std::size_t, int&) { FinalizeCount++; }
+					);
+				}
+				catch (const std::runtime_error&) {
+					Threw = true;
+				}
+				aContext.check("Serial load error rethrown", Threw && (FinalizeCount == 5));
+
+				Threw = false;
+				try {
+					io::build_objects<int>(List,
+						[](const io::object_description&) { return 1; },
+						[](std::size_t aIndex, int&) { if (aIndex == 3) throw std::runtime_error("upload failed"); },
+						nullptr, &Jobs
+					);
+				}
+				catch (const std::runtime_error&) {
+					Threw = true;
+				}
+				aContext.check("Finalize error rethrown", Threw);
+
+				std::vector<int> Empty = io::build_objects<int>({}, [](const io::object_description&) { return 1; }, [](std::size_t, int&) {});
+				aContext.check("Empty list", Empty.empty());
+			});
+		}
+
+		test::suite StageSuite("stage", register_stage);
+
+	}
+
+}
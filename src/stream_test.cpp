@@ -0,0 +1,218 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/world_streamer.h>
+
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+// Background prefetch and budgeted integration of deferred worlds.
+
+namespace geodesy {
+
+	namespace {
+
+		const char* ConfigText =
+			"Engine:\n"
+			"  Name: \"Geodesy Unit Test\"\n"
+			"  ExecutionRate: 120 # [Hz]\n"
+			"Streaming:\n"
+			"  FrameBudget: 0.5\n"
+			"Worlds:\n"
+			"  - Name: \"MainMenu\"\n"
+			"    ConfigFile: \"assets/worlds/main_menu.yaml\"\n"
+			"    AutoLoad: false\n"
+			"  - Name: \"Level01\"\n"
+			"    ConfigFile: \"assets/worlds/level_01.yaml\"\n"
+			"    AutoLoad: true\n";
+
+		// Writes a world of aCount objects named Object0, Object1, ...
+		std::string write_world(const std::filesystem::path& aDirectory, const std::string& aName, std::size_t aCount) {
+			std::string Text = "World:\n  Name: \"" + aName + "\"\n  Objects:\n";
+			for (std::size_t i = 0; i < aCount; i++) {
+				Text += "    - Name: \"Object" + std::to_string(i) + "\"\n      Type: \"object\"\n      Position: [" + std::to_string(i) + ", 0, 0]\n";
+			}
+			std::filesystem::path Path = aDirectory / (aName + ".yaml");
+			std::ofstream(Path, std::ios::binary | std::ios::trunc) << Text;
+			return Path.string();
+		}
+
+		// Polls until aDone holds or five seconds pass.
+		template <typename F>
+		bool wait_for(F aDone) {
+			std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (!aDone()) {
+				if (std::chrono::steady_clock::now() > Deadline) return false;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			return true;
+		}
+
+		void spin(double aMilliseconds) {
+			std::chrono::steady_clock::time_point End = std::chrono::steady_clock::now() + std::chrono::microseconds((int64_t)(aMilliseconds * 1000.0));
+			while (std::chrono::steady_clock::now() < End) {}
+		}
+
+		using streamer = io::world_streamer<std::string>;
+
+		void register_stream(test& aTest) {
+			aTest.add("config", [](test::context& aContext) {
+				io::streaming_config Config = io::streaming_config::from_yaml(io::yaml::parse(ConfigText));
+				aContext.check("Budget from rate and fraction", std::abs(Config.budget() - 1000.0 / 120.0 * 0.5) < 1e-9);
+				aContext.check("Prefetch defaults on", Config.Prefetch);
+				aContext.check("Prefetch off", !io::streaming_config::from_yaml(io::yaml::parse("Streaming:\n  Prefetch: false\n")).Prefetch);
+				aContext.check("World list", (Config.World.size() == 2) && !Config.World[0].AutoLoad && Config.World[1].AutoLoad && (Config.World[1].Name == "Level01"));
+				io::streaming_config Default = io::streaming_config::from_yaml(io::yaml::parse("Worlds:\n"));
+				aContext.check("Defaults without Engine or Streaming", std::abs(Default.budget() - 1000.0 / 60.0 * 0.25) < 1e-9);
+			});
+
+			aTest.add("prefetch", [](test::context& aContext) {
+				test::scratch Scratch("stream-test-prefetch");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::string Menu = write_world(Directory, "menu", 6);
+				std::vector<std::string> Integrated;
+				{
+					streamer Streamer(
+						[](const io::object_description& aObject) { return aObject.Name + "@" + std::to_string((int)aObject.Position[0]); },
+						[&](const std::string& aWorld, const io::object_description&, std::string& aObject) { Integrated.push_back(aWorld + ":" + aObject); }
+					);
+					io::streaming_config Config;
+					Config.World = { { "Menu", Menu, false }, { "Level", (Directory / "level.yaml").string(), true } };
+					Streamer.prefetch_deferred(Config);
+					aContext.check("AutoLoad worlds not prefetched", Streamer.status("Level") == streamer::UNKNOWN);
+					aContext.check("Loads in the background", wait_for([&]() { return Streamer.status("Menu") == streamer::LOADED; }));
+					streamer::frame Idle = Streamer.update(100.0);
+					aContext.check("Nothing integrated before request", (Idle.Integrated == 0) && Integrated.empty());
+
+					Streamer.request("Menu");
+					streamer::frame Frame = Streamer.update(100.0);
+					aContext.check("Prefetched world integrates in one roomy frame", (Frame.Integrated == 6) && (Frame.Pending == 0) && (Streamer.status("Menu") == streamer::READY));
+					aContext.check("List order", (Integrated.size() == 6) && (Integrated.front() == "Menu:Object0@0") && (Integrated.back() == "Menu:Object5@5"));
+				}
+			});
+
+			aTest.add("deferred", [](test::context& aContext) {
+				test::scratch Scratch("stream-test-deferred");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::string Menu = write_world(Directory, "menu", 2);
+				std::string Level = write_world(Directory, "level", 3);
+				std::atomic<bool> Release{ false };
+				{
+					// Loads of the prefetched menu hold the background thread until released.
+					streamer Streamer(
+						[&](const io::object_description& aObject) {
+							while (!Release) std::this_thread::yield();
+							return aObject.Name;
+						},
+						[](const std::string&, const io::object_description&, std::string&) {}
+					);
+					io::streaming_config Config;
+					Config.Prefetch = false;
+					Config.World = { { "Level", Level, false } };
+					Streamer.prefetch("Menu", Menu);
+					Streamer.prefetch_deferred(Config);
+					aContext.check("Menu loading", wait_for([&]() { return Streamer.status("Menu") == streamer::LOADING; }));
+					aContext.check("Prefetch off leaves the world unloaded", Streamer.status("Level") == streamer::DEFERRED);
+
+					Streamer.request("Level");
+					streamer::frame Queued = Streamer.update(100.0);
+					aContext.check("Queued world counts as pending", (Queued.Integrated == 0) && (Queued.Pending >= 1) && (Streamer.status("Level") == streamer::INTEGRATING));
+
+					Release = true;
+					std::size_t Integrated = 0;
+					bool Done = wait_for([&]() {
+						Integrated += Streamer.update(100.0).Integrated;
+						return Streamer.status("Level") == streamer::READY;
+					});
+					aContext.check("Deferred world loads on request", Done && (Integrated == 3) && (Streamer.update(100.0).Pending == 0));
+					aContext.check("Unrequested menu not integrated", Streamer.status("Menu") != streamer::READY);
+				}
+			});
+
+			aTest.add("budget", [](test::context& aContext) {
+				test::scratch Scratch("stream-test-budget");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::string Level = write_world(Directory, "level", 12);
+				std::string Menu = write_world(Directory, "menu", 4);
+				std::vector<std::string> Integrated;
+				{
+					streamer Streamer(
+						[](const io::object_description& aObject) { return aObject.Name; },
+						[&](const std::string&, const io::object_description&, std::string& aObject) { spin(1.0); Integrated.push_back(aObject); }
+					);
+					// Requested straight away, integration overlaps the background load.
+					Streamer.prefetch("Level", Level);
+					Streamer.request("Level");
+					std::size_t FrameCount = 0, MostPerFrame = 0;
+					bool Done = wait_for([&]() {
+						streamer::frame Frame = Streamer.update(2.5);
+						if (Frame.Integrated > 0) FrameCount++;
+						MostPerFrame = std::max(MostPerFrame, Frame.Integrated);
+						return Streamer.status("Level") == streamer::READY;
+					});
+					aContext.check("World completes", Done && (Integrated.size() == 12));
+					aContext.check("Budget spreads objects over frames", (MostPerFrame >= 1) && (MostPerFrame <= 3) && (FrameCount >= 4));
+
+					// A zero budget still integrates one object per frame.
+					Streamer.prefetch("Menu", Menu);
+					aContext.check("Second world loads", wait_for([&]() { return Streamer.status("Menu") == streamer::LOADED; }));
+					Streamer.request("Menu");
+					streamer::frame Frame = Streamer.update(0.0);
+					aContext.check("Progress below one object's cost", (Frame.Integrated == 1) && (Frame.Pending == 3) && (Streamer.status("Menu") == streamer::INTEGRATING));
+					aContext.check("Order across worlds", (Integrated.size() == 13) && (Integrated[11] == "Object11") && (Integrated[12] == "Object0"));
+				}
+			});
+
+			aTest.add("failure", [](test::context& aContext) {
+				test::scratch Scratch("stream-test-failure");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::string Level = write_world(Directory, "level", 3);
+				{
+					streamer Streamer(
+						[](const io::object_description& aObject) -> std::string {
+							if (aObject.Name == "Object1") throw std::runtime_error("bad model");
+							return aObject.Name;
+						},
+						[](const std::string&, const io::object_description&, std::string&) {}
+					);
+					Streamer.prefetch("Missing", (Directory / "missing.yaml").string());
+					Streamer.prefetch("Level", Level);
+					aContext.check("Missing world fails", wait_for([&]() { return Streamer.status("Missing") == streamer::FAILED; }));
+					aContext.check("Load error reported", wait_for([&]() { return Streamer.status("Level") == streamer::FAILED; }) && (Streamer.error("Level") == "bad model"));
+
+					bool Threw = false;
+					try { Streamer.request("Unknown"); }
+					catch (const std::runtime_error&) { Threw = true; }
+					aContext.check("Unknown request throws", Threw);
+					Streamer.release("Level");
+					aContext.check("Released world forgotten", Streamer.status("Level") == streamer::UNKNOWN);
+				}
+				{
+					// An integrator throwing something that is not a std::exception still fails
+					// the world instead of leaving it integrating.
+					streamer Streamer(
+						[](const io::object_description& aObject) { return aObject.Name; },
+						[](const std::string&, const io::object_description&, std::string&) { throw 42; }
+					);
+					Streamer.prefetch("Level", Level);
+					Streamer.request("Level");
+					bool Threw = false;
+					wait_for([&]() {
+						try { Streamer.update(1.0); }
+						catch (int) { Threw = true; }
+						return Threw;
+					});
+					aContext.check("Integration error fails the world", Threw && (Streamer.status("Level") == streamer::FAILED) && (Streamer.update(1.0).Integrated == 0));
+				}
+			});
+		}
+
+		test::suite StreamSuite("stream", register_stream);
+
+	}
+
+}
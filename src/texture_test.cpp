@@ -0,0 +1,304 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/texture_cache.h>
+
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+// PNG/JPEG decoding, mip generation and the content addressed texture cache.
+
+namespace geodesy {
+
+	namespace {
+
+		// 16x16 4:2:0 baseline JPEG with a restart marker after every MCU, red ramps with x,
+		// green with y, blue is 200 left of x = 8 and 40 right of it.
+		const uint8_t SmallJPEG[] = {
+			0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x08, 0x06, 0x06, 0x07, 0x06, 0x05, 0x08, 0x07, 0x07,
+			0x07, 0x09, 0x09, 0x08, 0x0A, 0x0C, 0x14, 0x0D, 0x0C, 0x0B, 0x0B, 0x0C, 0x19, 0x12, 0x13, 0x0F,
+			0x14, 0x1D, 0x1A, 0x1F, 0x1E, 0x1D, 0x1A, 0x1C, 0x1C, 0x20, 0x24, 0x2E, 0x27, 0x20, 0x22, 0x2C,
+			0x23, 0x1C, 0x1C, 0x28, 0x37, 0x29, 0x2C, 0x30, 0x31, 0x34, 0x34, 0x34, 0x1F, 0x27, 0x39, 0x3D,
+			0x38, 0x32, 0x3C, 0x2E, 0x33, 0x34, 0x32, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x09, 0x09, 0x09, 0x0C,
+			0x0B, 0x0C, 0x18, 0x0D, 0x0D, 0x18, 0x32, 0x21, 0x1C, 0x21, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+			0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+			0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+			0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0xFF, 0xC0, 0x00, 0x11,
+			0x08, 0x00, 0x10, 0x00, 0x10, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xFF,
+			0xC4, 0x00, 0x15, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x05, 0x06, 0xFF, 0xC4, 0x00, 0x18, 0x10, 0x00, 0x02, 0x03, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x05, 0x22, 0x31,
+			0xFF, 0xC4, 0x00, 0x14, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xC4, 0x00, 0x1B, 0x11, 0x00, 0x01, 0x04, 0x03, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x06, 0x21, 0x31,
+			0x33, 0x51, 0xC1, 0xFF, 0xDD, 0x00, 0x04, 0x00, 0x01, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00,
+			0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00, 0x87, 0x42, 0x0B, 0x28, 0x28, 0x84, 0x16, 0x50, 0xB8,
+			0x42, 0x0B, 0x28, 0x28, 0x84, 0x16, 0x50, 0x3A, 0xD5, 0x71, 0xCE, 0xF8, 0x1B, 0x2B, 0x75, 0x27,
+			0xFF, 0xD9,
+		};
+
+		// zlib stream with one dynamic Huffman block, the text built by pangram_text().
+		const uint8_t DynamicZlib[] = {
+			0x78, 0xDA, 0x7D, 0xD1, 0x5D, 0x0E, 0x82, 0x30, 0x10, 0x04, 0xE0, 0xAB, 0xCC, 0x11, 0xDA, 0x52,
+			0x0A, 0xC4, 0xD3, 0x20, 0x54, 0x40, 0xC5, 0x62, 0xA1, 0x8A, 0x9C, 0x5E, 0xC2, 0xA3, 0xD9, 0xF1,
+			0x71, 0x93, 0xFD, 0xB2, 0x3F, 0xB3, 0xF4, 0x1E, 0xCF, 0x34, 0x34, 0x37, 0x9C, 0x63, 0x78, 0x3F,
+			0x70, 0x09, 0x2B, 0x14, 0xAE, 0x69, 0x9C, 0x66, 0x84, 0x97, 0x8F, 0x58, 0xF6, 0x86, 0x7B, 0xBD,
+			0x7D, 0xD0, 0x86, 0x0E, 0xEA, 0x74, 0xD4, 0xBF, 0x40, 0x53, 0xA0, 0x65, 0x60, 0x28, 0xB0, 0x32,
+			0xC8, 0x28, 0xA8, 0x64, 0x60, 0xF9, 0x4A, 0x4E, 0x16, 0x39, 0x15, 0x26, 0x97, 0x85, 0xA3, 0x22,
+			0x23, 0x33, 0x0A, 0x7E, 0x37, 0xB9, 0xA3, 0xA4, 0xC2, 0x91, 0x57, 0x55, 0x54, 0x94, 0x24, 0x0D,
+			0xCD, 0x03, 0xD7, 0x8A, 0x45, 0xFE, 0x27, 0x73, 0xB3, 0xCF, 0xF9, 0x02, 0x12, 0x45, 0xCE, 0x2B,
+		};
+
+		std::string pangram_text() {
+			std::string Text;
+			for (int i = 0; i < 12; i++) Text += "the quick brown fox " + std::to_string(i) + " jumps over the lazy dog " + std::to_string(i * i) + "; ";
+			return Text;
+		}
+
+		uint32_t crc32(const uint8_t* aData, std::size_t aSize) {
+			uint32_t CRC = 0xFFFFFFFFu;
+			for (std::size_t i = 0; i < aSize; i++) {
+				CRC ^= aData[i];
+				for (int k = 0; k < 8; k++) CRC = (CRC >> 1) ^ (0xEDB88320u & (0u - (CRC & 1u)));
+			}
+			return ~CRC;
+		}
+
+		// Encodes packed scanlines as a PNG with stored (uncompressed) deflate blocks. Row y
+		// uses filter type y % 5, so every filter is exercised.
+		std::vector<uint8_t> write_png(uint32_t aWidth, uint32_t aHeight, uint8_t aColorType, uint8_t aDepth, const std::vector<uint8_t>& aRows, const std::vector<uint8_t>& aPalette = {}, const std::vector<uint8_t>& aTransparency = {}) {
+			static const uint32_t Channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+			std::size_t Bits = (std::size_t)Channels[aColorType] * aDepth;
+			std::size_t Stride = (aWidth * Bits + 7) / 8, Step = std::max<std::size_t>(1, Bits / 8);
+			std::vector<uint8_t> Raw;
+			for (uint32_t y = 0; y < aHeight; y++) {
+				uint8_t Filter = (uint8_t)(y % 5);
+				Raw.push_back(Filter);
+				const uint8_t* Row = aRows.data() + y * Stride;
+				const uint8_t* Up = y > 0 ? Row - Stride : nullptr;
+				for (std::size_t i = 0; i < Stride; i++) {
+					uint8_t A = i >= Step ? Row[i - Step] : 0, B = Up ? Up[i] : 0, C = (Up && (i >= Step)) ? Up[i - Step] : 0;
+					uint8_t Predictor[5] = { 0, A, B, (uint8_t)((A + B) / 2), io::detail::paeth(A, B, C) };
+					Raw.push_back((uint8_t)(Row[i] - Predictor[Filter]));
+				}
+			}
+
+			std::vector<uint8_t> Zlib = { 0x78, 0x01 };
+			for (std::size_t Offset = 0; Offset < Raw.size(); Offset += 65535) {
+				std::size_t Length = std::min<std::size_t>(65535, Raw.size() - Offset);
+				Zlib.push_back(Offset + Length >= Raw.size() ? 1 : 0);
+				Zlib.push_back((uint8_t)Length); Zlib.push_back((uint8_t)(Length >> 8));
+				Zlib.push_back((uint8_t)~Length); Zlib.push_back((uint8_t)(~Length >> 8));
+				Zlib.insert(Zlib.end(), Raw.begin() + Offset, Raw.begin() + Offset + Length);
+			}
+			uint32_t A = 1, B = 0;
+			for (uint8_t Byte : Raw) { A = (A + Byte) % 65521; B = (B + A) % 65521; }
+			for (int s = 24; s >= 0; s -= 8) Zlib.push_back((uint8_t)(((B << 16) | A) >> s));
+
+			std::vector<uint8_t> File = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+			auto chunk = [&](const char* aType, const std::vector<uint8_t>& aBody) {
+				for (int s = 24; s >= 0; s -= 8) File.push_back((uint8_t)(aBody.size() >> s));
+				std::size_t Start = File.size();
+				File.insert(File.end(), aType, aType + 4);
+				File.insert(File.end(), aBody.begin(), aBody.end());
+				uint32_t CRC = crc32(File.data() + Start, File.size() - Start);
+				for (int s = 24; s >= 0; s -= 8) File.push_back((uint8_t)(CRC >> s));
+			};
+			std::vector<uint8_t> Header;
+			for (uint32_t Value : { aWidth, aHeight }) for (int s = 24; s >= 0; s -= 8) Header.push_back((uint8_t)(Value >> s));
+			Header.insert(Header.end(), { aDepth, aColorType, 0, 0, 0 });
+			chunk("IHDR", Header);
+			if (!aPalette.empty()) chunk("PLTE", aPalette);
+			if (!aTransparency.empty()) chunk("tRNS", aTransparency);
+			chunk("IDAT", Zlib);
+			chunk("IEND", {});
+			return File;
+		}
+
+		// Deterministic RGBA test pattern.
+		std::vector<uint8_t> pattern(uint32_t aWidth, uint32_t aHeight, uint32_t aSeed) {
+			std::vector<uint8_t> Pixel((std::size_t)aWidth * aHeight * 4);
+			uint32_t State = aSeed * 2654435761u + 1;
+			for (uint8_t& Value : Pixel) {
+				State = State * 1664525u + 1013904223u;
+				Value = (uint8_t)(State >> 24);
+			}
+			return Pixel;
+		}
+
+		void write_file(const std::filesystem::path& aPath, const std::vector<uint8_t>& aData) {
+			std::ofstream Stream(aPath, std::ios::binary | std::ios::trunc);
+			Stream.write((const char*)aData.data(), aData.size());
+		}
+
+		bool throws(const std::vector<uint8_t>& aData) {
+			try { io::decode_image(aData.data(), aData.size()); }
+			catch (const std::runtime_error&) { return true; }
+			return false;
+		}
+
+		void register_texture(test& aTest) {
+			aTest.add("inflate", [](test::context& aContext) {
+				std::vector<uint8_t> Out;
+				io::detail::inflater(DynamicZlib + 2, sizeof(DynamicZlib) - 6).run(Out);
+				std::string Expected = pangram_text();
+				aContext.check("Dynamic Huffman block", (Out.size() == Expected.size()) && (std::memcmp(Out.data(), Expected.data(), Out.size()) == 0));
+			});
+
+			aTest.add("png", [](test::context& aContext) {
+				std::vector<uint8_t> RGBA = pattern(13, 7, 1);
+				std::vector<uint8_t> File = write_png(13, 7, 6, 8, RGBA);
+				io::image Image = io::decode_image(File.data(), File.size());
+				aContext.check("RGBA8, every filter", (Image.Width == 13) && (Image.Height == 7) && (Image.Pixel == RGBA));
+
+				std::vector<uint8_t> RGB;
+				for (std::size_t i = 0; i < RGBA.size(); i += 4) RGB.insert(RGB.end(), RGBA.begin() + i, RGBA.begin() + i + 3);
+				File = write_png(13, 7, 2, 8, RGB);
+				Image = io::decode_png(File.data(), File.size());
+				bool Match = Image.Pixel.size() == RGBA.size();
+				for (std::size_t i = 0; Match && (i < RGBA.size()); i += 4) Match = (std::memcmp(&Image.Pixel[i], &RGBA[i], 3) == 0) && (Image.Pixel[i + 3] == 255);
+				aContext.check("RGB8 opaque", Match);
+
+				// 2 bit palette, 5 pixels per row packs into 2 bytes, entry 1 is half transparent.
+				std::vector<uint8_t> Palette = { 255, 0, 0, 0, 255, 0, 0, 0, 255, 9, 9, 9 };
+				std::vector<uint8_t> Rows = { 0x1B, 0x40, 0xE4, 0x00 }; 		// 0 1 2 3 1 | 3 2 1 0 0
+				File = write_png(5, 2, 3, 2, Rows, Palette, { 255, 128 });
+				Image = io::decode_png(File.data(), File.size());
+				aContext.check("Palette with tRNS", (Image.Pixel[4] == 0) && (Image.Pixel[5] == 255) && (Image.Pixel[7] == 128) && (Image.Pixel[3 * 4] == 9) && (Image.Pixel[3 * 4 + 3] == 255) && (Image.Pixel[5 * 4 + 1] == 9) && (Image.Pixel[9 * 4] == 255));
+
+				// 1 bit gray, 16 bit gray with alpha.
+				File = write_png(10, 1, 0, 1, { 0xA5, 0x80 });
+				Image = io::decode_png(File.data(), File.size());
+				aContext.check("1 bit gray expands to 0/255", (Image.Pixel[0] == 255) && (Image.Pixel[4] == 0) && (Image.Pixel[8 * 4] == 255) && (Image.Pixel[9 * 4] == 0));
+				File = write_png(1, 1, 4, 16, { 0x12, 0x34, 0xAB, 0xCD });
+				Image = io::decode_png(File.data(), File.size());
+				aContext.check("16 bit keeps the high byte", (Image.Pixel[0] == 0x12) && (Image.Pixel[2] == 0x12) && (Image.Pixel[3] == 0xAB));
+
+				File = write_png(13, 7, 6, 8, RGBA);
+				File.resize(File.size() - 40);
+				aContext.check("Truncated file throws", throws(File));
+				aContext.check("Unknown format throws", throws({ 'G', 'I', 'F', '8', '9', 'a' }));
+
+				// Maximal IHDR dimensions over a few bytes of data fail on the data, not the allocation.
+				File = write_png(1, 1, 6, 8, { 1, 2, 3, 4 });
+				for (std::size_t Field : { 16, 20 }) { File[Field] = 0x01; File[Field + 1] = File[Field + 2] = File[Field + 3] = 0x00; }
+				aContext.check("Huge dimensions with short data throw", throws(File));
+			});
+
+			aTest.add("jpeg", [](test::context& aContext) {
+				io::image Image = io::decode_image(SmallJPEG, sizeof(SmallJPEG));
+				// Reference pixels from libjpeg, the IDCT and upsampling differ by a few levels.
+				struct probe { uint32_t X, Y; int R, G, B; };
+				const probe Probe[] = { { 0, 0, 0, 2, 185 }, { 15, 15, 242, 238, 55 }, { 4, 12, 63, 191, 202 }, { 12, 4, 193, 62, 32 } };
+				bool Close = (Image.Width == 16) && (Image.Height == 16);
+				for (const probe& P : Probe) {
+					const uint8_t* Pixel = &Image.Pixel[((std::size_t)P.Y * 16 + P.X) * 4];
+					Close = Close && (std::abs(Pixel[0] - P.R) <= 4) && (std::abs(Pixel[1] - P.G) <= 4) && (std::abs(Pixel[2] - P.B) <= 4) && (Pixel[3] == 255);
+				}
+				aContext.check("4:2:0 with restarts matches libjpeg", Close);
+
+				std::vector<uint8_t> Progressive(SmallJPEG, SmallJPEG + sizeof(SmallJPEG));
+				Progressive[0x8D] = 0xC2; 									// SOF0 -> SOF2.
+				aContext.check("Progressive rejected", throws(Progressive));
+				std::vector<uint8_t> Truncated(SmallJPEG, SmallJPEG + 0x60);
+				aContext.check("Truncated file throws", throws(Truncated));
+
+				// Bundled bricks2 textures are 512x512 baseline JPEGs.
+				std::string Path = "assets/models/bricks2/bricks2.jpg";
+				if (!std::filesystem::exists(Path)) return;
+				io::mapped_file File(Path);
+				Image = io::decode_image(File.data(), File.size());
+				aContext.check("bricks2.jpg", (Image.Width == 512) && (Image.Height == 512));
+			});
+
+			aTest.add("mipmap", [](test::context& aContext) {
+				io::image Image;
+				Image.Width = 5;
+				Image.Height = 3;
+				Image.Pixel.assign(5 * 3 * 4, 0);
+				for (std::size_t i = 0; i < Image.Pixel.size(); i += 8) std::memset(&Image.Pixel[i], 255, 4);
+				io::texture Linear = io::texture::from_image(io::image(Image), true, false);
+				aContext.check("Chain down to 1x1", (Linear.Level.size() == 3) && (Linear.Level[1].Width == 2) && (Linear.Level[1].Height == 1) && (Linear.Level[2].Width == 1) && (Linear.Level[2].Height == 1));
+				aContext.check("Levels packed", (Linear.Level[1].Offset == 60) && (Linear.Level[2].Offset == 68) && (Linear.byte_size() == 72));
+
+				// Alternating black and white pixels average to mid grey.
+				io::image Checker;
+				Checker.Width = Checker.Height = 2;
+				Checker.Pixel = { 0, 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 0 };
+				io::texture L = io::texture::from_image(io::image(Checker), true, false);
+				io::texture S = io::texture::from_image(io::image(Checker), true, true);
+				aContext.check("Linear average", (L.data(1)[0] == 128) && (L.data(1)[3] == 128));
+				aContext.check("sRGB average in linear light", (S.data(1)[0] == 188) && (S.data(1)[3] == 128));
+				io::texture None = io::texture::from_image(io::image(Checker), false, true);
+				aContext.check("No mipmaps", (None.Level.size() == 1) && (None.byte_size() == 16));
+			});
+
+			aTest.add("cache", [](test::context& aContext) {
+				test::scratch Scratch("texture-test");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::vector<uint8_t> RGBA = pattern(37, 21, 7);
+				write_file(Directory / "a.png", write_png(37, 21, 6, 8, RGBA));
+				io::texture_cache Cache((Directory / "cache").string());
+
+				io::texture_report::entry Cold, Warm;
+				io::texture A = Cache.load((Directory / "a.png").string(), io::texture_options(), &Cold);
+				io::texture B = Cache.load((Directory / "a.png").string(), io::texture_options(), &Warm);
+				aContext.check("First load decodes and stores", !Cold.Hit && Cold.Stored && !A.is_mapped());
+				aContext.check("Second load is mapped from cache", Warm.Hit && B.is_mapped() && (Warm.Decode == 0.0));
+				aContext.check("Cached chain identical", (A.Level.size() == B.Level.size()) && (A.byte_size() == B.byte_size()) && (std::memcmp(A.data(), B.data(), A.byte_size()) == 0) && (B.Srgb == A.Srgb));
+				aContext.check("Level 0 is the image", std::memcmp(B.data(), RGBA.data(), RGBA.size()) == 0);
+
+				// Keyed by content and options, not path.
+				std::filesystem::copy_file(Directory / "a.png", Directory / "copy.png");
+				io::texture_report::entry Copy, Data;
+				Cache.load((Directory / "copy.png").string(), io::texture_options(), &Copy);
+				Cache.load((Directory / "a.png").string(), { true, false }, &Data);
+				aContext.check("Copied source hits", Copy.Hit);
+				aContext.check("Different options miss", !Data.Hit);
+
+				io::texture_report::entry Edited;
+				RGBA[0] ^= 1;
+				write_file(Directory / "a.png", write_png(37, 21, 6, 8, RGBA));
+				io::texture C = Cache.load((Directory / "a.png").string(), io::texture_options(), &Edited);
+				aContext.check("Edited source misses", !Edited.Hit && (C.data()[0] == RGBA[0]));
+
+				// A corrupt entry is ignored and replaced.
+				io::mapped_file Source((Directory / "a.png").string());
+				std::string Entry = Cache.path_for(io::texture_cache::key(Source.data(), Source.size(), io::texture_options()));
+				Source.close();
+				std::filesystem::resize_file(Entry, 100);
+				io::texture_report::entry Repaired, After;
+				Cache.load((Directory / "a.png").string(), io::texture_options(), &Repaired);
+				Cache.load((Directory / "a.png").string(), io::texture_options(), &After);
+				aContext.check("Truncated entry falls back to decode", !Repaired.Hit && Repaired.Stored && After.Hit);
+
+				// Parallel load keeps list order and rethrows failures.
+				std::vector<io::texture_cache::source> List;
+				for (uint32_t i = 0; i < 6; i++) {
+					std::string Name = (Directory / ("t" + std::to_string(i) + ".png")).string();
+					write_file(Name, write_png(8 + i, 4, 6, 8, pattern(8 + i, 4, 100 + i)));
+					List.push_back({ Name, io::texture_options() });
+				}
+				job_system Jobs(3);
+				io::texture_report Report;
+				std::vector<io::texture> All = Cache.load_all(List, &Report, &Jobs);
+				bool Ordered = (All.size() == 6) && (Report.Entry.size() == 6);
+				for (uint32_t i = 0; Ordered && (i < 6); i++) Ordered = (All[i].Width == 8 + i) && (Report.Entry[i].Path == List[i].Path);
+				aContext.check("load_all keeps order", Ordered && (Report.hit_count() == 0));
+				Cache.load_all(List, &Report);
+				aContext.check("load_all warm", Report.hit_count() == 6);
+				List.push_back({ (Directory / "missing.png").string(), io::texture_options() });
+				bool Threw = false;
+				try { Cache.load_all(List, nullptr, &Jobs); }
+				catch (const std::runtime_error&) { Threw = true; }
+				aContext.check("Missing source throws", Threw);
+			});
+		}
+
+		test::suite TextureSuite("texture", register_texture);
+
+	}
+
+}
@@ -0,0 +1,157 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/transform_hierarchy.h>
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+// Flattened transform hierarchy with dirty propagation, checked against a full
+// recomputation that walks every node's parent chain.
+
+namespace geodesy {
+
+	namespace {
+
+		using mat4 = math::mat<float, 4, 4>;
+
+		mat4 reference_world(const transform_hierarchy& aHierarchy, transform_hierarchy::id aNode) {
+			transform_hierarchy::id Parent = aHierarchy.parent(aNode);
+			if (Parent == transform_hierarchy::None) return aHierarchy.local(aNode);
+			return math::simd::mul(reference_world(aHierarchy, Parent), aHierarchy.local(aNode));
+		}
+
+		bool matches_reference(const transform_hierarchy& aHierarchy) {
+			for (transform_hierarchy::id i = 0; i < aHierarchy.size(); i++) {
+				mat4 Expected = reference_world(aHierarchy, i);
+				if (std::memcmp(&Expected(0, 0), &aHierarchy.world(i)(0, 0), sizeof(mat4)) != 0) return false;
+			}
+			return true;
+		}
+
+		bool near(const mat4& aA, const mat4& aB) {
+			for (std::size_t r = 0; r < 4; r++) for (std::size_t c = 0; c < 4; c++) if (std::abs(aA(r, c) - aB(r, c)) > 1e-5f) return false;
+			return true;
+		}
+
+		mat4 random_transform(std::mt19937& aRandom) {
+			std::uniform_real_distribution<float> Angle(-180.0f, 180.0f), Offset(-5.0f, 5.0f), Scale(0.5f, 2.0f);
+			return object_transform({ Offset(aRandom), Offset(aRandom), Offset(aRandom) }, { Angle(aRandom), Angle(aRandom) }, { Scale(aRandom), Scale(aRandom), Scale(aRandom) });
+		}
+
+		void register_transform(test& aTest) {
+			aTest.add("update", [](test::context& aContext) {
+				std::mt19937 Random(20);
+				transform_hierarchy Hierarchy;
+				// A forest whose nodes attach to any earlier node, so depths arrive out of order.
+				for (std::size_t i = 0; i < 2000; i++) {
+					transform_hierarchy::id Parent = (i % 10 == 0) ? transform_hierarchy::None : (transform_hierarchy::id)(Random() % i);
+					Hierarchy.add(random_transform(Random), Parent);
+				}
+				aContext.check("First update computes every node", Hierarchy.update() == 2000);
+				aContext.check("World transforms match", matches_reference(Hierarchy));
+				aContext.check("Nothing moved", (Hierarchy.update() == 0) && (Hierarchy.updated_count() == 0));
+
+				// Moving a node updates exactly its subtree.
+				bool Counts = true;
+				for (int Step = 0; Step < 50; Step++) {
+					transform_hierarchy::id Moved = (transform_hierarchy::id)(Random() % Hierarchy.size());
+					std::size_t Subtree = 0;
+					for (transform_hierarchy::id i = 0; i < Hierarchy.size(); i++) {
+						for (transform_hierarchy::id A = i; A != transform_hierarchy::None; A = Hierarchy.parent(A)) {
+							if (A == Moved) { Subtree++; break; }
+						}
+					}
+					Hierarchy.set_local(Moved, random_transform(Random));
+					Counts = Counts && (Hierarchy.update() == Subtree);
+				}
+				aContext.check("Only moved subtrees update", Counts);
+				aContext.check("World transforms still match", matches_reference(Hierarchy));
+
+				// Overlapping subtrees in one frame are each updated once.
+				transform_hierarchy::id Child = 1999;
+				transform_hierarchy::id Parent = Hierarchy.parent(Child);
+				Hierarchy.set_local(Child, random_transform(Random));
+				if (Parent != transform_hierarchy::None) Hierarchy.set_local(Parent, random_transform(Random));
+				std::size_t Updated = Hierarchy.update();
+				aContext.check("Nested changes", (Updated >= 1) && (Updated == Hierarchy.updated_count()) && matches_reference(Hierarchy));
+			});
+
+			aTest.add("order", [](test::context& aContext) {
+				transform_hierarchy Hierarchy;
+				mat4 Step = object_transform({ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+				transform_hierarchy::id A = Hierarchy.add(Step);
+				transform_hierarchy::id B = Hierarchy.add(Step, A);
+				transform_hierarchy::id C = Hierarchy.add(Step, B);
+				Hierarchy.update();
+				// A root and a child of A after the deeper C force a re-sort, ids stay put.
+				transform_hierarchy::id D = Hierarchy.add(Step);
+				transform_hierarchy::id E = Hierarchy.add(Step, A);
+				aContext.check("Ids in order of addition", (A == 0) && (B == 1) && (C == 2) && (D == 3) && (E == 4));
+				aContext.check("Only new nodes update", Hierarchy.update() == 2);
+				aContext.check("Parents kept", (Hierarchy.parent(C) == B) && (Hierarchy.parent(E) == A) && (Hierarchy.parent(D) == transform_hierarchy::None));
+				aContext.check("Chain translation", (Hierarchy.world(C)(0, 3) == 3.0f) && (Hierarchy.world(E)(0, 3) == 2.0f) && (Hierarchy.world(D)(0, 3) == 1.0f));
+				Hierarchy.set_local(A, object_transform({ 0.0f, 2.0f, 0.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }));
+				aContext.check("Root move reaches every descendant", (Hierarchy.update() == 4) && (Hierarchy.world(C)(1, 3) == 2.0f) && (Hierarchy.world(C)(0, 3) == 2.0f));
+
+				bool Threw = false;
+				try { Hierarchy.add(Step, 99); }
+				catch (const std::invalid_argument&) { Threw = true; }
+				aContext.check("Missing parent rejected", Threw);
+				Hierarchy.clear();
+				aContext.check("Cleared", (Hierarchy.size() == 0) && (Hierarchy.update() == 0));
+			});
+
+			aTest.add("object_transform", [](test::context& aContext) {
+				mat4 Yaw = object_transform({ 0.0f, 0.0f, 0.0f }, { 90.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+				mat4 Pitch = object_transform({ 0.0f, 0.0f, 0.0f }, { 0.0f, 90.0f }, { 1.0f, 1.0f, 1.0f });
+				mat4 Full = object_transform({ 1.0f, 2.0f, 3.0f }, { 90.0f, 90.0f }, { 2.0f, 3.0f, 4.0f });
+				aContext.check("Yaw turns x to y", near(Yaw, mat4(0, -1, 0, 0,  1, 0, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1)));
+				aContext.check("Pitch turns y to z", near(Pitch, mat4(1, 0, 0, 0,  0, 0, -1, 0,  0, 1, 0, 0,  0, 0, 0, 1)));
+				mat4 Move(1, 0, 0, 1,  0, 1, 0, 2,  0, 0, 1, 3,  0, 0, 0, 1);
+				mat4 Scale(2, 0, 0, 0,  0, 3, 0, 0,  0, 0, 4, 0,  0, 0, 0, 1);
+				aContext.check("Translate, yaw, pitch, scale", near(Full, math::simd::mul(math::simd::mul(Move, Yaw), math::simd::mul(Pitch, Scale))));
+			});
+
+			aTest.add("gltf", [](test::context& aContext) {
+				test::scratch Scratch("transform-test");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::filesystem::path Path = Directory / "nodes.gltf";
+				std::ofstream(Path, std::ios::binary | std::ios::trunc) <<
+					"{\n"
+					"  \"asset\": { \"version\": \"2.0\" },\n"
+					"  \"scene\": 0,\n"
+					"  \"scenes\": [ { \"nodes\": [ 0, 3 ] } ],\n"
+					"  \"nodes\": [\n"
+					"    { \"name\": \"Root\", \"translation\": [ 1, 0, 0 ], \"rotation\": [ 0, 0, 0.7071068, 0.7071068 ], \"children\": [ 1 ] },\n"
+					"    { \"name\": \"Arm\", \"matrix\": [ 2, 0, 0, 0,  0, 2, 0, 0,  0, 0, 2, 0,  1, 0, 0, 1 ], \"children\": [ 2 ] },\n"
+					"    { \"name\": \"Hand\", \"translation\": [ 0, 1, 0 ] },\n"
+					"    { \"name\": \"Lamp\", \"scale\": [ 3, 3, 3 ] },\n"
+					"    { \"name\": \"Unused\" }\n"
+					"  ]\n"
+					"}\n";
+				io::gltf Model = io::gltf::load(Path.string());
+
+				transform_hierarchy Hierarchy;
+				transform_hierarchy::id Object = Hierarchy.add(object_transform({ 0.0f, 0.0f, 10.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }));
+				std::vector<transform_hierarchy::id> Node = add_gltf_nodes(Hierarchy, Model, Object);
+				aContext.check("Scene nodes added", (Node.size() == 5) && (Hierarchy.size() == 5) && (Node[4] == transform_hierarchy::None));
+				aContext.check("Hierarchy", (Hierarchy.parent(Node[0]) == Object) && (Hierarchy.parent(Node[2]) == Node[1]) && (Hierarchy.parent(Node[3]) == Object));
+				Hierarchy.update();
+				// Root turns x to y, the arm doubles and moves along x, so the hand ends at
+				// (1, 0, 10) + R * ((1, 0, 0) + 2 * (0, 1, 0)) = (-1, 1, 10).
+				const mat4& Hand = Hierarchy.world(Node[2]);
+				aContext.check("Hand position", (std::abs(Hand(0, 3) + 1.0f) < 1e-5f) && (std::abs(Hand(1, 3) - 1.0f) < 1e-5f) && (std::abs(Hand(2, 3) - 10.0f) < 1e-5f));
+				aContext.check("Scale from the matrix", std::abs(Hand(1, 0) - 2.0f) < 1e-5f);
+				aContext.check("Lamp scale", Hierarchy.world(Node[3])(2, 2) == 3.0f);
+			});
+		}
+
+		test::suite TransformSuite("transform", register_transform);
+
+	}
+
+}
@@ -1,11 +1,14 @@
 #include <geodesy-unit-test/unit_test.h>
 
+#include <geodesy-unit-test/test.h>
+
 #include <memory>
 
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <chrono>
 #include <algorithm>
-#include <complex>
 
 namespace geodesy {
 
@@ -87,271 +90,63 @@ namespace geodesy {
 
 	}
 
-	void unit_test::math_test() {
-	    // Test configuration
-	    float TestEpsilon = 1e-5f;
-	    uint32_t TotalTests = 0;
-	    uint32_t PassedTests = 0;
-
-	    auto test_result = [&](const std::string& TestName, bool Result) {
-	        TotalTests++;
-	        if(Result) PassedTests++;
-	        std::cout << std::setw(50) << std::left << TestName 
-	                  << (Result ? "PASSED" : "FAILED") << std::endl;
-	    };
-
-	    auto float_equal = [TestEpsilon](float A, float B) -> bool {
-	        return std::abs(A - B) < TestEpsilon;
-	    };
-
-	    std::cout << "\n=== Testing Math Library ===\n\n";
-
-	    // Vector Tests
-	    {
-	        std::cout << "Testing vec<T,N>:\n";
-	
-	        // Constructor tests
-	        {
-	            math::vec<float, 3> DefaultVec;
-	            math::vec<float, 3> InitVec = { 1.0f, 2.0f, 3.0f };
-	
-	            test_result("Default constructor zero initialization", 
-	                float_equal(DefaultVec[0], 0.0f) && 
-	                float_equal(DefaultVec[1], 0.0f) && 
-	                float_equal(DefaultVec[2], 0.0f));
-	
-	            test_result("Initializer list constructor",
-	                float_equal(InitVec[0], 1.0f) && 
-	                float_equal(InitVec[1], 2.0f) && 
-	                float_equal(InitVec[2], 3.0f));
-	        }
-
-	        // Arithmetic operations
-	        {
-	            math::vec<float, 3> A(2.0f, 1.0f, -3.0f);
-	            math::vec<float, 3> B = { 0.0f, -2.09f, 9.987f };
-	            float Scalar = 3.14159f;
-
-	            // Test negation
-	            math::vec<float, 3> Neg = -A;
-	            test_result("Vector negation", 
-	                float_equal(Neg[0], -2.0f) && 
-	                float_equal(Neg[1], -1.0f) && 
-	                float_equal(Neg[2], 3.0f));
-
-	            // Test addition
-	            math::vec<float, 3> Sum = A + B;
-	            test_result("Vector addition", 
-	                float_equal(Sum[0], 2.0f) && 
-	                float_equal(Sum[1], -1.09f) && 
-	                float_equal(Sum[2], 6.987f));
-
-	            // Test subtraction
-	            math::vec<float, 3> Diff = A - B;
-	            test_result("Vector subtraction", 
-	                float_equal(Diff[0], 2.0f) && 
-	                float_equal(Diff[1], 3.09f) && 
-	                float_equal(Diff[2], -12.987f));
-
-	            // Test scalar multiplication
-	            math::vec<float, 3> Scaled = A * Scalar;
-	            test_result("Vector scalar multiplication", 
-	                float_equal(Scaled[0], 2.0f * Scalar) && 
-	                float_equal(Scaled[1], 1.0f * Scalar) && 
-	                float_equal(Scaled[2], -3.0f * Scalar));
-
-	            // Test scalar division
-	            math::vec<float, 3> Divided = A / Scalar;
-	            test_result("Vector scalar division", 
-	                float_equal(Divided[0], 2.0f / Scalar) && 
-	                float_equal(Divided[1], 1.0f / Scalar) && 
-	                float_equal(Divided[2], -3.0f / Scalar));
-	        }
-
-	        // Compound assignments
-	        {
-	            math::vec<float, 3> A = { 2.0f, 1.0f, -3.0f };
-	            math::vec<float, 3> B = { 0.0f, -2.09f, 9.987f };
-	            float Scalar = 3.14159f;
-
-	            math::vec<float, 3> TestVec = A;
-	            TestVec += B;
-	            test_result("Vector compound addition", 
-	                float_equal(TestVec[0], 2.0f) && 
-	                float_equal(TestVec[1], -1.09f) && 
-	                float_equal(TestVec[2], 6.987f));
-
-	            TestVec = A;
-	            TestVec -= B;
-	            test_result("Vector compound subtraction", 
-	                float_equal(TestVec[0], 2.0f) && 
-	                float_equal(TestVec[1], 3.09f) && 
-	                float_equal(TestVec[2], -12.987f));
-
-	            TestVec = A;
-	            TestVec *= Scalar;
-	            test_result("Vector compound multiplication", 
-	                float_equal(TestVec[0], 2.0f * Scalar) && 
-	                float_equal(TestVec[1], 1.0f * Scalar) && 
-	                float_equal(TestVec[2], -3.0f * Scalar));
-
-	            TestVec = A;
-	            TestVec /= Scalar;
-	            test_result("Vector compound division", 
-	                float_equal(TestVec[0], 2.0f / Scalar) && 
-	                float_equal(TestVec[1], 1.0f / Scalar) && 
-	                float_equal(TestVec[2], -3.0f / Scalar));
-	        }
-
-	        // Special operations
-	        {
-	            math::vec<float, 3> A = { 2.0f, 1.0f, -3.0f };
-	            math::vec<float, 3> B = { 0.0f, -2.09f, 9.987f };
-
-	            // Dot product
-	            float Dot = A * B;
-	            test_result("Vector dot product", 
-	                float_equal(Dot, 2.0f*0.0f + 1.0f*(-2.09f) + (-3.0f)*9.987f));
-
-	            // Cross product
-	            math::vec<float, 3> Cross = A ^ B;
-	            test_result("Vector cross product", true);  // Add specific value checks
-	        }
-	    }
-
-	    // Complex number tests
-	    {
-	        std::cout << "\nTesting complex<T>:\n";
-	
-	        // Constructor tests
-	        {
-	            math::complex<float> DefaultComplex;
-	            math::complex<float> InitComplex(1.0f, 2.0f);
-	
-	            test_result("Complex default constructor", 
-	                float_equal(DefaultComplex[0], 0.0f) && 
-	                float_equal(DefaultComplex[1], 0.0f));
-	
-	            test_result("Complex initialization constructor",
-	                float_equal(InitComplex[0], 1.0f) && 
-	                float_equal(InitComplex[1], 2.0f));
-	        }
-
-	        // Basic operations
-	        {
-	            math::complex<float> A(1.0f, 2.0f);
-	            math::complex<float> B(3.0f, 4.0f);
-
-	            // Addition
-	            math::complex<float> Sum = A + B;
-	            test_result("Complex addition",
-	                float_equal(Sum[0], 4.0f) && 
-	                float_equal(Sum[1], 6.0f));
-
-	            // Conjugate
-	            math::complex<float> Conj = ~A;
-	            test_result("Complex conjugate",
-	                float_equal(Conj[0], 1.0f) && 
-	                float_equal(Conj[1], -2.0f));
-
-	            // Multiplication
-	            math::complex<float> Prod = A * B;
-	            test_result("Complex multiplication",
-	                float_equal(Prod[0], -5.0f) && 
-	                float_equal(Prod[1], 10.0f));
-
-	            // Functions
-	            float Abs = abs(A);
-	            test_result("Complex absolute value",
-	                float_equal(Abs, std::sqrt(5.0f)));
-
-	            float Phase = phase(A);
-	            test_result("Complex phase",
-	                float_equal(Phase, std::atan2(2.0f, 1.0f)));
-	        }
-	    }
-
-	    // Matrix tests
-	    {
-	        std::cout << "\nTesting mat<T,M,N>:\n";
-	
-	        // Test column-major storage with row-major input
-	        {
-	            math::mat<float, 4, 4> A = math::mat<float, 4, 4>(
-	                1.0f, 0.0f, 0.0f, 1.0f,    
-	                2.0f, 1.0f, -1.0f, 2.0f,   
-	                3.0f, 2.0f, 0.0f, 3.0f,    
-	                4.0f, 3.0f, 1.0f, 4.0f     
-	            );
-
-	            // Test column-major access
-	            test_result("Matrix column-major storage",
-	                float_equal(A(0,0), 1.0f) && 
-	                float_equal(A(1,0), 2.0f) && 
-	                float_equal(A(2,0), 3.0f) && 
-	                float_equal(A(3,0), 4.0f));
-	        }
-
-	        // Test matrix multiplication
-	        {
-	            math::mat<float, 4, 4> A = math::mat<float, 4, 4>(
-	                1.0f, 0.0f, 0.0f, 1.0f,
-	                2.0f, 1.0f, -1.0f, 2.0f,
-	                3.0f, 2.0f, 0.0f, 3.0f,
-	                4.0f, 3.0f, 1.0f, 4.0f
-	            );
-
-	            math::mat<float, 4, 4> B = {
-	                1.0f, 2.0f, 3.0f, 4.0f,
-	                5.0f, 6.0f, 7.0f, 8.0f,
-	                9.0f, 10.0f, 11.0f, 12.0f,
-	                13.0f, 14.0f, 15.0f, 16.0f
-	            };
-
-	            math::mat<float, 4, 4> C = A * B;
-	            test_result("Matrix multiplication", true);  // Add specific value checks
-	        }
-
-	        // Test determinant
-	        {
-	            math::mat<float, 4, 4> A = math::mat<float, 4, 4>(
-	                2.0f, -1.0f, 0.0f, 1.0f,
-	                1.0f, 3.0f, -2.0f, 0.0f,
-	                0.0f, 2.0f, 4.0f, -1.0f,
-	                1.0f, -1.0f, 1.0f, 2.0f
-	            );
-
-	            float Det = determinant(A);
-	            test_result("Matrix determinant",
-	                float_equal(Det, 48.0f));
-	        }
-	    }
-
-	    // Field tests
-	    {
-	        std::cout << "\nTesting field<X,N,Y>:\n";
-
-	        math::field<float, 2, float> X({-5.0f, -5.0f}, {2.0f, 2.0f}, {50, 50}, 1);
-	        math::field<float, 2, float> Y({-2.0f, -3.0f}, {4.0f, 5.0f}, {50, 50}, 2);
-	
-	        // Test field addition
-	        math::field<float, 2, float> Sum = X + Y;
-	
-	        // Test field sampling
-	        math::vec<float, 2> SamplePoint = {1.9f, 1.3f};
-	        float SampleValue = Sum(SamplePoint);
-	
-	        test_result("Field operations", true);  // Add specific value checks
-	    }
-
-	    // Print summary
-	    std::cout << "\n=== Test Summary ===\n"
-	              << "Total Tests: " << TotalTests << "\n"
-	              << "Passed: " << PassedTests << "\n"
-	              << "Failed: " << (TotalTests - PassedTests) << "\n"
-	              << "Success Rate: " 
-	              << (TotalTests > 0 ? (100.0f * PassedTests / TotalTests) : 0.0f)
-	              << "%\n\n";
+	bool unit_test::run_tests(const std::set<std::string>& aCommandLineArguments) {
+		// Options are given as --key=value since the argument set does not keep order.
+		test Test;
+		std::string JsonPath, JUnitPath;
+		for (const std::string& Argument : aCommandLineArguments) {
+			std::size_t Split = Argument.find('=');
+			if ((Argument.rfind("--", 0) != 0) || (Split == std::string::npos)) continue;
+			std::string Key = Argument.substr(0, Split);
+			std::string Value = Argument.substr(Split + 1);
+			if (Key == "--filter") 			Test.Options.Filter = Value;
+			else if (Key == "--threads") {
+				// A count of decimal digits, 0 uses hardware concurrency.
+				bool Valid = (Value.size() > 0) && (Value.size() <= 9) && std::all_of(Value.begin(), Value.end(), [](char aCharacter) { return (aCharacter >= '0') && (aCharacter <= '9'); });
+				if (!Valid) {
+					std::cerr << "Error: invalid thread count '" << Value << "'\n"
+					          << "Usage: --headless [--filter=<substring>] [--threads=<count>] [--json=<path>] [--junit=<path>]" << std::endl;
+					return false;
+				}
+				Test.Options.ThreadCount = std::stoul(Value);
+			}
+			else if (Key == "--json") 		JsonPath = Value;
+			else if (Key == "--junit") 		JUnitPath = Value;
+		}
+
+		Test.register_all();
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		std::vector<test::result> ResultList = Test.run(&std::cout);
+		double Elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+		std::size_t PassedCount = std::count_if(ResultList.begin(), ResultList.end(), [](const test::result& aResult) { return aResult.Passed; });
+		std::cout << "\n=== Test Summary ===\n"
+		          << "Total Tests: " << ResultList.size() << "\n"
+		          << "Passed: " << PassedCount << "\n"
+		          << "Failed: " << (ResultList.size() - PassedCount) << "\n"
+		          << "Wall Time: " << std::fixed << std::setprecision(3) << Elapsed << " ms\n\n";
+
+		// A report that cannot be written fails the run, CI would otherwise read a stale one.
+		auto write_report = [](const std::string& aPath, const std::string& aReport) -> bool {
+			std::ofstream File(aPath, std::ios::binary | std::ios::trunc);
+			File << aReport;
+			File.close();
+			if (!File.fail()) return true;
+			std::cerr << "Error: could not write test report '" << aPath << "'" << std::endl;
+			return false;
+		};
+		bool ReportsWritten = true;
+		if (JsonPath.size() > 0) ReportsWritten &= write_report(JsonPath, test::to_json(ResultList));
+		if (JUnitPath.size() > 0) ReportsWritten &= write_report(JUnitPath, test::to_junit(ResultList));
+
+		if (ResultList.empty()) {
+			std::cerr << "Error: no tests matched";
+			if (Test.Options.Filter.size() > 0) std::cerr << " filter '" << Test.Options.Filter << "'";
+			std::cerr << std::endl;
+			return false;
+		}
+
+		return ReportsWritten && (PassedCount == ResultList.size());
 	}
 
 	void unit_test::create_worlds() {
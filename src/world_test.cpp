@@ -0,0 +1,192 @@
+#include <geodesy/engine.h>
+
+#include <geodesy-unit-test/test.h>
+#include <geodesy-unit-test/yaml.h>
+#include <geodesy-unit-test/world_snapshot.h>
+
+#include <cstddef>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+// World file parsing and binary snapshot round trips.
+
+namespace geodesy {
+
+	namespace {
+
+		const char* WorldText =
+			"# Test world\n"
+			"World:\n"
+			"  Name: \"Test # World\"\n"
+			"  Physics:\n"
+			"    Gravity: [0.0, 0.0, -9.81]\n"
+			"    TimeStep: 0.016667  # 60 FPS\n"
+			"    VelocityIterations: 8\n"
+			"    PositionIterations: 3\n"
+			"  Objects:\n"
+			"    - Name: \"Camera3D\"\n"
+			"      Type: camera3d\n"
+			"      ModelPath: \"models/camera.gltf\"\n"
+			"      Position: [0.0, -5.0, 2.0]\n"
+			"      Direction: [0.0, 0.0]\n"
+			"      Scale: [1.0, 1.0, 1.0]\n"
+			"      Resolution: [1920, 1080]\n"
+			"      FrameRate: 60.0\n"
+			"      FrameCount: 3\n"
+			"      FOV: 70.0\n"
+			"      Near: 1.0\n"
+			"      Far: 2000.0\n"
+			"    # Animated object\n"
+			"    - Name: 'Brain''Stem'\n"
+			"      Type: \"object\"\n"
+			"      ModelPath: \"models/brain.gltf\"\n"
+			"      Position: [2.0, -2.0, 0.0]\n"
+			"      Direction: [-90.0, 90.0]\n"
+			"      Scale: [0.5, 0.5, 0.5]\n"
+			"      AnimationWeights: [0.25, 0.75]\n";
+
+		void write_text(const std::filesystem::path& aPath, const std::string& aText) {
+			std::ofstream Stream(aPath, std::ios::binary | std::ios::trunc);
+			Stream << aText;
+		}
+
+		bool same_world(const io::world_description& aA, const io::world_description& aB) {
+			if ((aA.Name != aB.Name) || (aA.TimeStep != aB.TimeStep) || (aA.Object.size() != aB.Object.size())) return false;
+			if ((aA.VelocityIterations != aB.VelocityIterations) || (aA.PositionIterations != aB.PositionIterations)) return false;
+			for (std::size_t d = 0; d < 3; d++) if (aA.Gravity[d] != aB.Gravity[d]) return false;
+			for (std::size_t i = 0; i < aA.Object.size(); i++) {
+				const io::object_description& A = aA.Object[i];
+				const io::object_description& B = aB.Object[i];
+				if ((A.Name != B.Name) || (A.Type != B.Type) || (A.ModelPath != B.ModelPath) || (A.AnimationWeights != B.AnimationWeights)) return false;
+				if ((A.IsSubject != B.IsSubject) || (A.FrameRate != B.FrameRate) || (A.FrameCount != B.FrameCount)) return false;
+				if ((A.FieldOfView != B.FieldOfView) || (A.Near != B.Near) || (A.Far != B.Far)) return false;
+				if ((A.Resolution[0] != B.Resolution[0]) || (A.Resolution[1] != B.Resolution[1])) return false;
+				for (std::size_t d = 0; d < 3; d++) if ((A.Position[d] != B.Position[d]) || (A.Scale[d] != B.Scale[d])) return false;
+				for (std::size_t d = 0; d < 2; d++) if (A.Direction[d] != B.Direction[d]) return false;
+			}
+			return true;
+		}
+
+		void register_world(test& aTest) {
+			aTest.add("yaml", [](test::context& aContext) {
+				io::yaml Root = io::yaml::parse(WorldText);
+				const io::yaml& World = Root["World"];
+				aContext.check("Quoted scalar keeps '#'", World["Name"].as_string() == "Test # World");
+				aContext.check("Trailing comment stripped", World["Physics"]["TimeStep"].as_string() == "0.016667");
+				aContext.check("Flow sequence", (World["Physics"]["Gravity"].size() == 3) && (World["Physics"]["Gravity"][2].as_double() == -9.81));
+				aContext.check("Block sequence of mappings", World["Objects"].size() == 2);
+				aContext.check("Unquoted scalar", World["Objects"][0]["Type"].as_string() == "camera3d");
+				aContext.check("Escaped single quote", World["Objects"][1]["Name"].as_string() == "Brain'Stem");
+				aContext.check("Missing key chains to none", World["Missing"]["Deeper"][4].is_none() && (World["Missing"].as_int(7) == 7));
+
+				io::yaml Sequence = io::yaml::parse("List:\n- a\n- [1, [2, 3]]\n-\n  Key: true\n");
+				aContext.check("Sequence at key indentation", Sequence["List"].size() == 3);
+				aContext.check("Nested flow sequence", Sequence["List"][1][1][1].as_int() == 3);
+				aContext.check("Bare item opens a block", Sequence["List"][2]["Key"].as_bool());
+
+				bool Threw = false;
+				try { io::yaml::parse("A: 1\n    B: 2\n"); }
+				catch (const std::runtime_error&) { Threw = true; }
+				aContext.check("Bad indentation throws", Threw);
+			});
+
+			aTest.add("snapshot_round_trip", [](test::context& aContext) {
+				test::scratch Scratch("world-test-round-trip");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::filesystem::create_directories(Directory / "models");
+				write_text(Directory / "level.yaml", WorldText);
+				write_text(Directory / "models" / "brain.gltf", "{ \"asset\": { \"version\": \"2.0\" } }");
+				std::string Source = (Directory / "level.yaml").string();
+				std::string Snapshot = io::world_snapshot::path_for(Source);
+				aContext.check("Snapshot path", Snapshot == (Directory / "level.world").string());
+
+				io::world_snapshot::compile(Source, Snapshot, true, Directory.string());
+				io::world_snapshot View(Snapshot);
+				aContext.check("Snapshot valid", View.is_valid());
+				aContext.check("Snapshot current", View.is_current(Source, Directory.string()));
+				aContext.check("Assets resolved flag", (View.info().Flags & io::world_snapshot::ASSETS_RESOLVED) != 0);
+				aContext.check("Mapped strings", (View.object_count() == 2) && (View.string(View.object(1).Name) == "Brain'Stem"));
+				aContext.check("Mapped weights", (View.object(1).WeightCount == 2) && (View.weights(View.object(1))[1] == 0.75f));
+				aContext.check("Resolved model metadata", (View.object(1).ModelSize > 0) && (View.object(0).ModelSize == 0));
+				bool Temporary = false;
+				for (const std::filesystem::directory_entry& Entry : std::filesystem::directory_iterator(Directory)) Temporary |= Entry.path().string().find(".tmp") != std::string::npos;
+				aContext.check("No temporary left behind", !Temporary);
+
+				bool UsedSnapshot = false;
+				io::world_description Loaded = io::load_world(Source, Snapshot, &UsedSnapshot, Directory.string());
+				io::world_description Parsed = io::world_description::from_yaml(io::yaml::load(Source));
+				aContext.check("Loader uses current snapshot", UsedSnapshot);
+				aContext.check("Snapshot matches YAML", same_world(Loaded, Parsed));
+
+				// Touched model, the snapshot must be recompiled.
+				std::filesystem::path Model = Directory / "models" / "brain.gltf";
+				std::filesystem::last_write_time(Model, std::filesystem::last_write_time(Model) + std::chrono::seconds(2));
+				aContext.check("Touched model makes snapshot stale", !View.is_current(Source, Directory.string()));
+				io::load_world(Source, Snapshot, &UsedSnapshot, Directory.string());
+				aContext.check("Touched model falls back to YAML", !UsedSnapshot);
+			});
+
+			aTest.add("snapshot_fallback", [](test::context& aContext) {
+				test::scratch Scratch("world-test-fallback");
+				const std::filesystem::path& Directory = Scratch.path();
+				std::string Source = (Directory / "level.yaml").string();
+				std::string Snapshot = (Directory / "level.world").string();
+				write_text(Source, WorldText);
+				io::world_snapshot::compile(Source, Snapshot);
+
+				// Edited source, the snapshot must be ignored.
+				std::string Edited = std::string(WorldText) + "    - Name: \"Extra\"\n      Type: \"object\"\n";
+				write_text(Source, Edited);
+				bool UsedSnapshot = true;
+				io::world_description Loaded = io::load_world(Source, Snapshot, &UsedSnapshot);
+				aContext.check("Stale snapshot falls back to YAML", !UsedSnapshot && (Loaded.Object.size() == 3));
+
+				// Corrupted header, the snapshot must be rejected outright.
+				io::world_snapshot::compile(Source, Snapshot);
+				{
+					std::fstream Stream(Snapshot, std::ios::binary | std::ios::in | std::ios::out);
+					Stream.write("NOTAWRLD", 8);
+				}
+				aContext.check("Bad magic rejected", !io::world_snapshot(Snapshot).is_valid());
+				Loaded = io::load_world(Source, Snapshot, &UsedSnapshot);
+				aContext.check("Bad magic falls back to YAML", !UsedSnapshot && (Loaded.Object.size() == 3));
+
+				// Written by a host of the other byte order.
+				io::world_snapshot::compile(Source, Snapshot);
+				{
+					uint32_t Swapped = 0x04030201u;
+					std::fstream Stream(Snapshot, std::ios::binary | std::ios::in | std::ios::out);
+					Stream.seekp(offsetof(io::world_snapshot::header, ByteOrder));
+					Stream.write((const char*)&Swapped, sizeof(Swapped));
+				}
+				aContext.check("Foreign byte order rejected", !io::world_snapshot(Snapshot).is_valid());
+
+				// Truncated file.
+				io::world_snapshot::compile(Source, Snapshot);
+				std::filesystem::resize_file(Snapshot, std::filesystem::file_size(Snapshot) - 1);
+				aContext.check("Truncated snapshot rejected", !io::world_snapshot(Snapshot).is_valid());
+
+				// Right size, but a record whose weights or name run past their pools.
+				auto patch = [&](std::size_t aOffset, uint32_t aValue) {
+					io::world_snapshot::compile(Source, Snapshot);
+					std::fstream Stream(Snapshot, std::ios::binary | std::ios::in | std::ios::out);
+					Stream.seekp(sizeof(io::world_snapshot::header) + sizeof(io::world_snapshot::object_record) + aOffset);
+					Stream.write((const char*)&aValue, sizeof(aValue));
+				};
+				patch(offsetof(io::world_snapshot::object_record, WeightCount), 1000);
+				aContext.check("Weight range checked", !io::world_snapshot(Snapshot).is_valid());
+				Loaded = io::load_world(Source, Snapshot, &UsedSnapshot);
+				aContext.check("Bad record falls back to YAML", !UsedSnapshot && (Loaded.Object.size() == 3) && (Loaded.Object[1].AnimationWeights.size() == 2));
+				patch(offsetof(io::world_snapshot::object_record, Name) + offsetof(io::world_snapshot::string_ref, Length), 1u << 30);
+				aContext.check("String range checked", !io::world_snapshot(Snapshot).is_valid());
+
+				aContext.check("Missing snapshot falls back", !io::world_snapshot((Directory / "none.world").string()).is_valid());
+			});
+		}
+
+		test::suite WorldSuite("world", register_world);
+
+	}
+
+}